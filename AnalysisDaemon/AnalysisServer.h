@@ -0,0 +1,804 @@
+#pragma once
+#include "pch.h"
+#include "AnalysisHistory.h"
+#include "AnalysisJson.h"
+#include "AnalysisPipeline.h"
+#include "AsyncTask.h"
+#include "BatchQueue.h"
+#include "FleetQuery.h"
+#include "FleetResultStore.h"
+#include "FleetSketch.h"
+#include "HttpMessage.h"
+#include "ServerMetrics.h"
+#include "Utf8.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace HardwareAnalyzer
+{
+	// Long-running local analysis service for tools that have OCR text but no UI.
+	//
+	//   POST /v1/windows   body: OCR text of the Windows "About" page (UTF-8)
+	//   POST /v1/macos     body: OCR text of "About This Mac"
+	//   GET  /metrics      Prometheus text: throughput, latency histograms, batch sizes
+	//   GET  /v1/stats     JSON: running fleet statistics (FleetSketch) of everything analyzed
+	//   GET  /v1/fleet     JSON: exact totals (FleetTotals) over the rows kept in FleetResultStore
+	//   POST /v1/query     body: a FleetQuery selection ("ram < 8 and gpu = IntelUHD");
+	//                      JSON: how many of those rows it matches
+	//   GET  /health
+	//
+	// One thread owns every socket and runs a poll() loop; complete requests go into a
+	// bounded BatchQueue that the workers drain in micro-batches. A worker analyzes its whole
+	// batch, then hands the responses back with one lock and one wake-up for the batch.
+	// Statistics, totals and queries go to a report thread instead, which answers them from
+	// its own copy of the workers' sketches and rows.
+	// With a history directory, each batch's analyses are also appended to the per-device
+	// AnalysisHistory in one write.
+	// A full queue is answered with 503 straight away rather than queued without bound.
+	class AnalysisServer
+	{
+	public:
+		struct Options
+		{
+			std::string SocketPath;                     // Unix domain socket; used when Port is 0
+			uint16_t Port = 0;                          // HTTP on 127.0.0.1 instead
+			unsigned Workers = ThreadPoolExecutor::DefaultThreadCount();
+			size_t MaxBatch = 32;
+			std::chrono::microseconds BatchWindow{ 200 };
+			size_t QueueCapacity = 8192;
+			size_t MaxBodyBytes = 1024 * 1024;
+			size_t MaxConnections = 4096;
+			size_t ArenaBytes = 256 * 1024;             // Per-worker arena for analysis strings; 0 = heap
+			std::string HistoryDirectory;               // AnalysisHistory of every analysis; empty = none
+			size_t FleetRows = 1 << 20;                 // Rows kept for /v1/fleet, over all workers; 0 = none
+		};
+
+		explicit AnalysisServer(Options options)
+			: m_options(std::move(options)), m_queue(m_options.QueueCapacity), m_reports(ReportCapacity)
+		{
+		}
+
+		~AnalysisServer()
+		{
+			Shutdown();
+		}
+
+		AnalysisServer(const AnalysisServer&) = delete;
+		AnalysisServer& operator=(const AnalysisServer&) = delete;
+
+		// Binds the socket and starts the workers; false with 'error' set on failure
+		bool Start(std::string& error)
+		{
+			int pipeFds[2];
+			if (pipe(pipeFds) != 0)
+			{
+				error = std::string("pipe: ") + std::strerror(errno);
+				return false;
+			}
+			m_wakeRead = pipeFds[0];
+			m_wakeWrite = pipeFds[1];
+			SetNonBlocking(m_wakeRead);
+			SetNonBlocking(m_wakeWrite);
+
+			if (!m_options.HistoryDirectory.empty())
+			{
+				m_history = std::make_unique<AnalysisHistory>();
+				if (!m_history->Open(m_options.HistoryDirectory, error))
+					return false;
+			}
+
+			m_listener = m_options.Port != 0 ? ListenLoopback(error) : ListenUnix(error);
+			if (m_listener < 0)
+				return false;
+			SetNonBlocking(m_listener);
+
+			for (unsigned i = 0; i < (std::max)(m_options.Workers, 1u); i++)
+			{
+				WorkerStats* stats = m_stats.emplace_back(std::make_unique<WorkerStats>()).get();
+				stats->FleetRows = m_options.FleetRows / (std::max)(m_options.Workers, 1u);
+				m_workers.emplace_back([this, stats] { WorkerLoop(*stats); });
+				m_snapshots.emplace_back(std::make_unique<WorkerSnapshot>())->Fleet.Reserve(stats->FleetRows);
+			}
+			m_reporter = std::thread([this] { ReportLoop(); });
+			return true;
+		}
+
+		// Serves until Stop() is called, on the calling thread
+		void Run()
+		{
+			std::vector<pollfd> fds;
+			std::vector<uint64_t> ids;
+			while (!m_stopping.load(std::memory_order_acquire))
+			{
+				fds.clear();
+				ids.clear();
+				fds.push_back({ m_wakeRead, POLLIN, 0 });
+				bool accepting = m_connections.size() < m_options.MaxConnections;
+				fds.push_back({ accepting ? m_listener : -1, POLLIN, 0 });
+				for (auto& [id, connection] : m_connections)
+				{
+					short events = 0;
+					if (!connection.Busy && !connection.Closing)
+						events |= POLLIN;
+					if (connection.Sent < connection.Out.size())
+						events |= POLLOUT;
+					fds.push_back({ connection.Fd, events, 0 });
+					ids.push_back(id);
+				}
+
+				if (poll(fds.data(), static_cast<nfds_t>(fds.size()), -1) < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					break;
+				}
+
+				if (fds[0].revents & POLLIN)
+				{
+					char drain[256];
+					while (read(m_wakeRead, drain, sizeof(drain)) > 0)
+					{
+					}
+					DeliverCompletions();
+				}
+				if (fds[1].revents & POLLIN)
+					AcceptAll();
+
+				for (size_t i = 0; i < ids.size(); i++)
+				{
+					short revents = fds[i + 2].revents;
+					if (revents == 0)
+						continue;
+					auto found = m_connections.find(ids[i]);
+					if (found == m_connections.end())
+						continue;
+
+					Connection& connection = found->second;
+					bool open = true;
+					if (revents & (POLLERR | POLLNVAL))
+						open = false;
+					if (open && (revents & (POLLIN | POLLHUP)) && !connection.Busy)
+						open = Receive(connection, ids[i]);
+					if (open && (revents & POLLOUT))
+						open = Flush(connection);
+					if (!open)
+						Close(found);
+				}
+			}
+			Shutdown();
+		}
+
+		// Safe to call from a signal handler or any thread
+		void Stop()
+		{
+			m_stopping.store(true, std::memory_order_release);
+			Wake();
+		}
+
+		ServerMetrics& Metrics() { return m_metrics; }
+
+	private:
+		struct Connection
+		{
+			int Fd = -1;
+			std::string In;
+			std::string Out;
+			size_t Sent = 0;
+			bool Busy = false;      // A request is with the workers or the report thread; later pipelined ones wait
+			bool Closing = false;   // Close once Out is sent
+		};
+
+		struct Job
+		{
+			uint64_t ConnectionId;
+			ServerMetrics::Endpoint Endpoint;
+			bool KeepAlive;
+			std::wstring Text;
+			std::chrono::steady_clock::time_point Received;
+		};
+
+		// A worker's own sketch and rows, behind a lock it shares only with the report thread
+		// catching its copy up
+		struct WorkerStats
+		{
+			std::mutex Lock;
+			FleetSketch Sketch;
+			FleetResultStore Fleet;
+			size_t FleetRows = 0;
+			uint64_t FleetDropped = 0;
+		};
+
+		// The report thread's copy of a worker's sketch and rows. Catching up copies the
+		// sketch and only the rows the worker added since, under its lock; merging, the column
+		// kernels and queries then run on the copy with no lock held, at the cost of holding
+		// the rows twice.
+		struct WorkerSnapshot
+		{
+			FleetSketch Sketch;
+			FleetResultStore Fleet;
+			FleetQuery Query{ Fleet };
+			uint64_t FleetDropped = 0;
+		};
+
+		enum class ReportKind : uint8_t
+		{
+			Statistics,
+			Fleet,
+			Query
+		};
+
+		// A request that reads every worker's rows, answered on the report thread
+		struct Report
+		{
+			uint64_t ConnectionId;
+			ReportKind Kind;
+			bool KeepAlive;
+			std::string Body;
+		};
+
+		static constexpr size_t ReportCapacity = 256;
+		static constexpr size_t MaxReportBatch = 16;
+
+		struct Completion
+		{
+			uint64_t ConnectionId;
+			bool KeepAlive;
+			std::string Response;
+		};
+
+		int ListenUnix(std::string& error)
+		{
+			sockaddr_un address{};
+			address.sun_family = AF_UNIX;
+			if (m_options.SocketPath.empty() || m_options.SocketPath.size() >= sizeof(address.sun_path))
+			{
+				error = "socket path is empty or too long";
+				return -1;
+			}
+			std::memcpy(address.sun_path, m_options.SocketPath.c_str(), m_options.SocketPath.size() + 1);
+
+			int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (fd < 0)
+			{
+				error = std::string("socket: ") + std::strerror(errno);
+				return -1;
+			}
+
+			// A socket file nobody answers on is left over from a crash; a live one is another daemon
+			if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0)
+			{
+				close(fd);
+				error = m_options.SocketPath + " is already served by another process";
+				return -1;
+			}
+			close(fd);
+			unlink(m_options.SocketPath.c_str());
+
+			fd = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0)
+			{
+				error = "bind " + m_options.SocketPath + ": " + std::strerror(errno);
+				if (fd >= 0)
+					close(fd);
+				return -1;
+			}
+			m_ownsSocketPath = true;
+			return fd;
+		}
+
+		int ListenLoopback(std::string& error)
+		{
+			int fd = socket(AF_INET, SOCK_STREAM, 0);
+			if (fd < 0)
+			{
+				error = std::string("socket: ") + std::strerror(errno);
+				return -1;
+			}
+			int reuse = 1;
+			setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+			sockaddr_in address{};
+			address.sin_family = AF_INET;
+			address.sin_port = htons(m_options.Port);
+			address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0)
+			{
+				error = "bind 127.0.0.1:" + std::to_string(m_options.Port) + ": " + std::strerror(errno);
+				close(fd);
+				return -1;
+			}
+			return fd;
+		}
+
+		void AcceptAll()
+		{
+			while (m_connections.size() < m_options.MaxConnections)
+			{
+				int fd = accept(m_listener, nullptr, nullptr);
+				if (fd < 0)
+					return;
+				SetNonBlocking(fd);
+				if (m_options.Port != 0)
+				{
+					// Responses are written whole; don't let Nagle hold them back
+					int noDelay = 1;
+					setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+				}
+#ifdef SO_NOSIGPIPE
+				int noSigPipe = 1;
+				setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+				Connection connection;
+				connection.Fd = fd;
+				m_connections.emplace(m_nextConnectionId++, std::move(connection));
+				m_metrics.OpenConnections.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		// Reads what the socket has and handles the complete requests in it; false to close
+		bool Receive(Connection& connection, uint64_t id)
+		{
+			char buffer[16 * 1024];
+			for (;;)
+			{
+				ssize_t count = recv(connection.Fd, buffer, sizeof(buffer), 0);
+				if (count > 0)
+				{
+					connection.In.append(buffer, static_cast<size_t>(count));
+					if (static_cast<size_t>(count) < sizeof(buffer))
+						break;
+					continue;
+				}
+				if (count == 0)
+					return false;   // Peer closed; anything it was owed can't be delivered
+				if (errno == EAGAIN || errno == EWOULDBLOCK)
+					break;
+				if (errno != EINTR)
+					return false;
+			}
+			HandleRequests(connection, id);
+			return Flush(connection);
+		}
+
+		// Handles buffered requests until one goes to the workers or the buffer runs dry
+		void HandleRequests(Connection& connection, uint64_t id)
+		{
+			while (!connection.Busy && !connection.Closing && !connection.In.empty())
+			{
+				HttpRequest request;
+				size_t consumed = 0;
+				switch (HttpMessage::Parse(connection.In, m_options.MaxBodyBytes, request, consumed))
+				{
+				case HttpMessage::ParseResult::Incomplete:
+					return;
+				case HttpMessage::ParseResult::Malformed:
+					Reject(connection, 400, "malformed request");
+					return;
+				case HttpMessage::ParseResult::Unsupported:
+					Reject(connection, 411, "send a Content-Length body");
+					return;
+				case HttpMessage::ParseResult::TooLarge:
+					Reject(connection, 413, "request too large");
+					return;
+				default:
+					break;
+				}
+
+				Dispatch(connection, id, request);
+				connection.In.erase(0, consumed);
+			}
+		}
+
+		void Dispatch(Connection& connection, uint64_t id, const HttpRequest& request)
+		{
+			bool isWindows = request.Target == "/v1/windows";
+			bool isMacOS = request.Target == "/v1/macos";
+			if (isWindows || isMacOS)
+			{
+				if (request.Method != "POST")
+				{
+					Respond(connection, 405, "text/plain", "use POST", request.KeepAlive);
+					m_metrics.BadRequests.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+				// Screenshots need Windows.Media.Ocr, which only the app has
+				if (HttpMessage::StartsWithIgnoreCase(request.ContentType, "image/"))
+				{
+					Respond(connection, 415, "text/plain", "send the OCR text of the screenshot", request.KeepAlive);
+					m_metrics.BadRequests.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+
+				auto endpoint = isWindows ? ServerMetrics::Endpoint::Windows : ServerMetrics::Endpoint::MacOS;
+				m_metrics.Requests[static_cast<size_t>(endpoint)].fetch_add(1, std::memory_order_relaxed);
+				Job job{ id, endpoint, request.KeepAlive, Utf8::Decode(request.Body), std::chrono::steady_clock::now() };
+				if (!m_queue.Push(std::move(job)))
+				{
+					m_metrics.Rejected.fetch_add(1, std::memory_order_relaxed);
+					Respond(connection, 503, "text/plain", "analysis queue is full", request.KeepAlive);
+					return;
+				}
+				m_metrics.QueueDepth.fetch_add(1, std::memory_order_relaxed);
+				connection.Busy = true;
+			}
+			else if (request.Target == "/metrics" && request.Method == "GET")
+			{
+				Respond(connection, 200, "text/plain; version=0.0.4", m_metrics.ToPrometheusText(), request.KeepAlive);
+			}
+			else if (request.Target == "/v1/stats" && request.Method == "GET")
+			{
+				QueueReport(connection, id, ReportKind::Statistics, request);
+			}
+			else if (request.Target == "/v1/fleet" && request.Method == "GET")
+			{
+				QueueReport(connection, id, ReportKind::Fleet, request);
+			}
+			else if (request.Target == "/v1/query" && request.Method == "POST")
+			{
+				QueueReport(connection, id, ReportKind::Query, request);
+			}
+			else if (request.Target == "/health" && request.Method == "GET")
+			{
+				Respond(connection, 200, "text/plain", "ok", request.KeepAlive);
+			}
+			else
+			{
+				Respond(connection, 404, "text/plain", "unknown endpoint", request.KeepAlive);
+				m_metrics.BadRequests.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		// Reports merge sketches and scan every worker's rows, which would stall every connection here
+		void QueueReport(Connection& connection, uint64_t id, ReportKind kind, const HttpRequest& request)
+		{
+			if (!m_reports.Push({ id, kind, request.KeepAlive, std::string(request.Body) }))
+			{
+				m_metrics.Rejected.fetch_add(1, std::memory_order_relaxed);
+				Respond(connection, 503, "text/plain", "report queue is full", request.KeepAlive);
+				return;
+			}
+			connection.Busy = true;
+		}
+
+		void Respond(Connection& connection, int status, std::string_view contentType, std::string_view body, bool keepAlive)
+		{
+			connection.Out += HttpMessage::Response(status, contentType, body, keepAlive);
+			if (!keepAlive)
+				connection.Closing = true;
+		}
+
+		// Protocol errors leave the stream in an unknown state, so the connection ends
+		void Reject(Connection& connection, int status, std::string_view message)
+		{
+			m_metrics.BadRequests.fetch_add(1, std::memory_order_relaxed);
+			Respond(connection, status, "text/plain", message, false);
+			connection.In.clear();
+		}
+
+		// Writes as much of Out as the socket takes; false to close
+		bool Flush(Connection& connection)
+		{
+			while (connection.Sent < connection.Out.size())
+			{
+				int flags = 0;
+#ifdef MSG_NOSIGNAL
+				flags = MSG_NOSIGNAL;
+#endif
+				ssize_t count = send(connection.Fd, connection.Out.data() + connection.Sent, connection.Out.size() - connection.Sent, flags);
+				if (count > 0)
+				{
+					connection.Sent += static_cast<size_t>(count);
+					continue;
+				}
+				if (count < 0 && errno == EINTR)
+					continue;
+				if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+					return true;
+				return false;
+			}
+			connection.Out.clear();
+			connection.Sent = 0;
+			return !connection.Closing;
+		}
+
+		void DeliverCompletions()
+		{
+			std::vector<Completion> completions;
+			{
+				std::lock_guard<std::mutex> lock(m_completionLock);
+				completions.swap(m_completions);
+				m_wakePending = false;
+			}
+
+			for (auto& completion : completions)
+			{
+				auto found = m_connections.find(completion.ConnectionId);
+				if (found == m_connections.end())
+					continue;   // The client left while its request was being analyzed
+
+				Connection& connection = found->second;
+				connection.Out += completion.Response;
+				connection.Busy = false;
+				if (!completion.KeepAlive)
+					connection.Closing = true;
+
+				// Requests pipelined behind this one can go now
+				HandleRequests(connection, completion.ConnectionId);
+				if (!Flush(connection))
+					Close(found);
+			}
+		}
+
+		void WorkerLoop(WorkerStats& stats)
+		{
+			std::vector<Job> batch;
+			std::vector<Completion> completions;
+			AnalysisHistory::Batch records;
+			AnalysisHistory::Batch* history = m_history ? &records : nullptr;
+
+			// Everything a batch's analyses allocate comes from here and is dropped in one
+			// release once the batch's JSON is written. Requests too big for the buffer spill
+			// into the upstream heap until that release.
+			std::vector<std::byte> arenaBuffer(m_options.ArenaBytes);
+			std::pmr::monotonic_buffer_resource arena(arenaBuffer.data(), arenaBuffer.size());
+			std::pmr::memory_resource* resource = arenaBuffer.empty() ? nullptr : &arena;
+
+			while (m_queue.PopBatch(batch, m_options.MaxBatch, m_options.BatchWindow))
+			{
+				m_metrics.RecordBatch(batch.size());
+				m_metrics.QueueDepth.fetch_sub(batch.size(), std::memory_order_relaxed);
+				completions.clear();
+				for (auto& job : batch)
+				{
+					auto started = std::chrono::steady_clock::now();
+					m_metrics.QueueWait.Record(started - job.Received);
+
+					std::string response;
+					try
+					{
+						std::string json = AnalyzeToJson(job, resource, stats, history);
+						response = HttpMessage::Response(200, "application/json", json, job.KeepAlive);
+					}
+					catch (const std::exception& e)
+					{
+						response = HttpMessage::Response(500, "text/plain", e.what(), job.KeepAlive);
+					}
+
+					auto finished = std::chrono::steady_clock::now();
+					m_metrics.AnalysisTime.Record(finished - started);
+					m_metrics.RequestLatency.Record(finished - job.Received);
+					completions.push_back({ job.ConnectionId, job.KeepAlive, std::move(response) });
+				}
+				arena.release();
+				if (history)
+					m_metrics.HistoryDropped.fetch_add(m_history->AppendOrDrop(records), std::memory_order_relaxed);
+
+				Post(completions);
+			}
+		}
+
+		void ReportLoop()
+		{
+			std::vector<Report> batch;
+			std::vector<Completion> completions;
+			while (m_reports.PopBatch(batch, MaxReportBatch, std::chrono::microseconds(0)))
+			{
+				// One catch-up serves every report of the batch
+				for (size_t i = 0; i < m_stats.size(); i++)
+				{
+					WorkerStats& stats = *m_stats[i];
+					WorkerSnapshot& snapshot = *m_snapshots[i];
+					std::lock_guard<std::mutex> lock(stats.Lock);
+					snapshot.Sketch = stats.Sketch;
+					snapshot.Fleet.CatchUp(stats.Fleet);
+					snapshot.FleetDropped = stats.FleetDropped;
+				}
+
+				completions.clear();
+				for (auto& report : batch)
+				{
+					completions.push_back({ report.ConnectionId, report.KeepAlive, Answer(report) });
+				}
+				Post(completions);
+			}
+		}
+
+		std::string Answer(const Report& report)
+		{
+			if (report.Kind == ReportKind::Statistics)
+			{
+				FleetSketch merged;
+				for (auto& snapshot : m_snapshots)
+				{
+					merged.Merge(snapshot->Sketch);
+				}
+				return HttpMessage::Response(200, "application/json", merged.ToJson(), report.KeepAlive);
+			}
+
+			if (report.Kind == ReportKind::Fleet)
+			{
+				// Totals over every worker's rows, and how many analyses didn't fit under FleetRows
+				FleetTotals totals;
+				uint64_t dropped = 0;
+				for (auto& snapshot : m_snapshots)
+				{
+					totals.Add(snapshot->Fleet);
+					dropped += snapshot->FleetDropped;
+				}
+				std::string json = totals.ToJson();
+				json.pop_back();
+				json += ",\"dropped\":";
+				AnalysisJson::AppendNumber(json, dropped);
+				json += '}';
+				return HttpMessage::Response(200, "application/json", json, report.KeepAlive);
+			}
+
+			uint64_t matched = 0;
+			uint64_t rows = 0;
+			std::string error;
+			for (auto& snapshot : m_snapshots)
+			{
+				snapshot->Query.Refresh();
+				RoaringBitmap selected;
+				if (!snapshot->Query.Evaluate(report.Body, selected, error))
+				{
+					m_metrics.BadRequests.fetch_add(1, std::memory_order_relaxed);
+					return HttpMessage::Response(400, "text/plain", error, report.KeepAlive);
+				}
+				matched += selected.Cardinality();
+				rows += snapshot->Query.Rows();
+			}
+			std::string json = "{\"matched\":";
+			AnalysisJson::AppendNumber(json, matched);
+			json += ",\"rows\":";
+			AnalysisJson::AppendNumber(json, rows);
+			json += '}';
+			return HttpMessage::Response(200, "application/json", json, report.KeepAlive);
+		}
+
+		// Hands responses to the I/O thread
+		void Post(std::vector<Completion>& completions)
+		{
+			bool wake;
+			{
+				std::lock_guard<std::mutex> lock(m_completionLock);
+				for (auto& completion : completions)
+				{
+					m_completions.push_back(std::move(completion));
+				}
+				wake = !m_wakePending;
+				m_wakePending = true;
+			}
+			// One byte per round trip of the I/O thread, however many batches land meanwhile
+			if (wake)
+				Wake();
+		}
+
+		static std::string AnalyzeToJson(const Job& job, std::pmr::memory_resource* arena, WorkerStats& stats, AnalysisHistory::Batch* history)
+		{
+			bool windows = job.Endpoint == ServerMetrics::Endpoint::Windows;
+			if (!arena)
+			{
+				return windows
+					? Record(AnalysisPipeline::AnalyzeWindowsText(job.Text), stats, history)
+					: Record(AnalysisPipeline::AnalyzeMacOSText(job.Text), stats, history);
+			}
+			return windows
+				? Record(AnalysisPipeline::AnalyzeWindowsText(job.Text, arena), stats, history)
+				: Record(AnalysisPipeline::AnalyzeMacOSText(job.Text, arena), stats, history);
+		}
+
+		template <typename Analysis>
+		static std::string Record(const Analysis& analysis, WorkerStats& stats, AnalysisHistory::Batch* history)
+		{
+			{
+				std::lock_guard<std::mutex> lock(stats.Lock);
+				stats.Sketch.Add(analysis);
+				if (stats.Fleet.Size() < stats.FleetRows)
+					stats.Fleet.Append(analysis);
+				else
+					stats.FleetDropped++;
+			}
+			if (history)
+				history->Add(analysis, AnalysisHistory::Now());
+			return AnalysisJson::ToJson(analysis);
+		}
+
+		void Wake()
+		{
+			char byte = 1;
+			ssize_t ignored = write(m_wakeWrite, &byte, 1);
+			(void)ignored;
+		}
+
+		void Close(std::unordered_map<uint64_t, Connection>::iterator found)
+		{
+			close(found->second.Fd);
+			m_connections.erase(found);
+			m_metrics.OpenConnections.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		void Shutdown()
+		{
+			m_queue.Close();
+			for (auto& worker : m_workers)
+			{
+				worker.join();
+			}
+			m_workers.clear();
+			m_reports.Close();
+			if (m_reporter.joinable())
+				m_reporter.join();
+			if (m_history)
+				m_history->Close();
+
+			for (auto& [id, connection] : m_connections)
+			{
+				close(connection.Fd);
+			}
+			m_connections.clear();
+
+			for (int* fd : { &m_listener, &m_wakeRead, &m_wakeWrite })
+			{
+				if (*fd >= 0)
+					close(*fd);
+				*fd = -1;
+			}
+			if (m_ownsSocketPath)
+			{
+				unlink(m_options.SocketPath.c_str());
+				m_ownsSocketPath = false;
+			}
+		}
+
+		static void SetNonBlocking(int fd)
+		{
+			fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+			fcntl(fd, F_SETFD, FD_CLOEXEC);
+		}
+
+		Options m_options;
+		ServerMetrics m_metrics;
+		BatchQueue<Job> m_queue;
+		std::vector<std::thread> m_workers;
+		std::vector<std::unique_ptr<WorkerStats>> m_stats;
+		BatchQueue<Report> m_reports;
+		std::thread m_reporter;
+		std::vector<std::unique_ptr<WorkerSnapshot>> m_snapshots;   // Report thread only
+		std::unique_ptr<AnalysisHistory> m_history;     // Set before the workers start
+
+		// I/O thread only
+		int m_listener = -1;
+		bool m_ownsSocketPath = false;
+		std::unordered_map<uint64_t, Connection> m_connections;
+		uint64_t m_nextConnectionId = 1;
+
+		int m_wakeRead = -1;
+		int m_wakeWrite = -1;
+		std::atomic<bool> m_stopping{ false };
+
+		std::mutex m_completionLock;   // Guards the two below
+		std::vector<Completion> m_completions;
+		bool m_wakePending = false;
+	};
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include "pch.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace HardwareAnalyzer
+{
+	// Bounded multi-producer queue whose consumers take work in batches. A consumer wakes
+	// for the first item, then lingers up to the batch window for more before it starts,
+	// so under load one lock round trip and one wake-up cover a whole batch. A lingering
+	// consumer waits on a condition of its own, so a push wakes an idle consumer rather
+	// than it, and wakes it only once its batch is full.
+	template <typename T>
+	class BatchQueue
+	{
+	public:
+		explicit BatchQueue(size_t capacity) : m_capacity(capacity) {}
+
+		BatchQueue(const BatchQueue&) = delete;
+		BatchQueue& operator=(const BatchQueue&) = delete;
+
+		// false when the queue is full or closed; the caller sheds the item
+		bool Push(T item)
+		{
+			bool full;
+			{
+				std::lock_guard<std::mutex> lock(m_lock);
+				if (m_closed || m_items.size() >= m_capacity)
+					return false;
+				m_items.push_back(std::move(item));
+				full = m_lingerers > 0 && m_items.size() >= m_lingerBatch;
+			}
+			m_wake.notify_one();
+			if (full)
+				m_full.notify_all();
+			return true;
+		}
+
+		// Waits for room instead, for producers that should slow down rather than shed;
+		// false once the queue is closed
+		bool PushWait(T item)
+		{
+			bool full;
+			{
+				std::unique_lock<std::mutex> lock(m_lock);
+				m_spaceWaiters++;
+				m_space.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+				m_spaceWaiters--;
+				if (m_closed)
+					return false;
+				m_items.push_back(std::move(item));
+				full = m_lingerers > 0 && m_items.size() >= m_lingerBatch;
+			}
+			m_wake.notify_one();
+			if (full)
+				m_full.notify_all();
+			return true;
+		}
+
+		// Moves up to maxBatch items into 'batch' (cleared first). Blocks until there is at
+		// least one; false once the queue is closed and drained.
+		bool PopBatch(std::vector<T>& batch, size_t maxBatch, std::chrono::microseconds window)
+		{
+			batch.clear();
+			std::unique_lock<std::mutex> lock(m_lock);
+			do
+			{
+				m_wake.wait(lock, [this] { return m_closed || !m_items.empty(); });
+				if (m_items.empty())
+					return false;
+
+				if (m_items.size() < maxBatch && window.count() > 0 && !m_closed)
+				{
+					auto deadline = std::chrono::steady_clock::now() + window;
+					m_lingerBatch = m_lingerers == 0 ? maxBatch : (std::min)(m_lingerBatch, maxBatch);
+					m_lingerers++;
+					m_full.wait_until(lock, deadline, [&] { return m_closed || m_items.size() >= maxBatch; });
+					m_lingerers--;
+				}
+				// An idle consumer may have taken what this one lingered for
+			} while (m_items.empty());
+
+			while (!m_items.empty() && batch.size() < maxBatch)
+			{
+				batch.push_back(std::move(m_items.front()));
+				m_items.pop_front();
+			}
+			// Leftovers are someone else's batch
+			if (!m_items.empty())
+				m_wake.notify_one();
+			if (m_spaceWaiters > 0)
+				m_space.notify_all();
+			return true;
+		}
+
+		// Wakes every consumer; items already queued are still handed out
+		void Close()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_lock);
+				m_closed = true;
+			}
+			m_wake.notify_all();
+			m_full.notify_all();
+			m_space.notify_all();
+		}
+
+		size_t Size()
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			return m_items.size();
+		}
+
+	private:
+		const size_t m_capacity;
+		std::mutex m_lock;
+		std::condition_variable m_wake;     // Idle consumers waiting for a first item
+		std::condition_variable m_full;     // Lingering consumers waiting for a full batch
+		size_t m_lingerers = 0;
+		size_t m_lingerBatch = 0;           // Smallest batch a lingering consumer waits for
+		std::condition_variable m_space;    // PushWait callers waiting for room
+		size_t m_spaceWaiters = 0;
+		std::deque<T> m_items;
+		bool m_closed = false;
+	};
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include "pch.h"
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace HardwareAnalyzer
+{
+	// The little HTTP/1.1 the daemon speaks: one request at a time per connection, bodies
+	// sized by Content-Length only, keep-alive unless the client asks otherwise.
+	struct HttpRequest
+	{
+		std::string_view Method;
+		std::string_view Target;      // Path, query string stripped
+		std::string_view ContentType;
+		std::string_view Body;
+		bool KeepAlive = true;
+	};
+
+	class HttpMessage
+	{
+	public:
+		enum class ParseResult
+		{
+			Complete,
+			Incomplete,      // Wait for more bytes
+			Malformed,       // 400
+			Unsupported,     // Chunked bodies: 411
+			TooLarge         // Headers or body over the limit: 413
+		};
+
+		static constexpr size_t MaxHeaderBytes = 16 * 1024;
+
+		// Parses the request at the start of 'buffer'. On Complete, 'consumed' is its total
+		// size and the views in 'request' point into 'buffer'.
+		static ParseResult Parse(std::string_view buffer, size_t maxBodyBytes, HttpRequest& request, size_t& consumed)
+		{
+			size_t headerEnd = buffer.find("\r\n\r\n");
+			if (headerEnd == std::string_view::npos)
+				return buffer.size() > MaxHeaderBytes ? ParseResult::TooLarge : ParseResult::Incomplete;
+
+			std::string_view head = buffer.substr(0, headerEnd);
+			size_t lineEnd = head.find("\r\n");
+			std::string_view requestLine = head.substr(0, lineEnd);
+			head = lineEnd == std::string_view::npos ? std::string_view{} : head.substr(lineEnd + 2);
+
+			// "POST /v1/windows HTTP/1.1"
+			size_t firstSpace = requestLine.find(' ');
+			size_t secondSpace = requestLine.find(' ', firstSpace + 1);
+			if (firstSpace == std::string_view::npos || secondSpace == std::string_view::npos)
+				return ParseResult::Malformed;
+			request = {};
+			request.Method = requestLine.substr(0, firstSpace);
+			request.Target = requestLine.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+			request.Target = request.Target.substr(0, request.Target.find('?'));
+			std::string_view version = requestLine.substr(secondSpace + 1);
+			if (version != "HTTP/1.1" && version != "HTTP/1.0")
+				return ParseResult::Malformed;
+			request.KeepAlive = version == "HTTP/1.1";
+
+			size_t contentLength = 0;
+			while (!head.empty())
+			{
+				lineEnd = head.find("\r\n");
+				std::string_view line = head.substr(0, lineEnd);
+				head = lineEnd == std::string_view::npos ? std::string_view{} : head.substr(lineEnd + 2);
+
+				size_t colon = line.find(':');
+				if (colon == std::string_view::npos)
+					return ParseResult::Malformed;
+				std::string_view name = line.substr(0, colon);
+				std::string_view value = Trim(line.substr(colon + 1));
+
+				if (EqualsIgnoreCase(name, "content-length"))
+				{
+					auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), contentLength);
+					if (error != std::errc{} || end != value.data() + value.size())
+						return ParseResult::Malformed;
+				}
+				else if (EqualsIgnoreCase(name, "transfer-encoding"))
+				{
+					return ParseResult::Unsupported;
+				}
+				else if (EqualsIgnoreCase(name, "connection"))
+				{
+					if (EqualsIgnoreCase(value, "close"))
+						request.KeepAlive = false;
+					else if (EqualsIgnoreCase(value, "keep-alive"))
+						request.KeepAlive = true;
+				}
+				else if (EqualsIgnoreCase(name, "content-type"))
+				{
+					request.ContentType = value;
+				}
+			}
+
+			if (contentLength > maxBodyBytes)
+				return ParseResult::TooLarge;
+			size_t bodyStart = headerEnd + 4;
+			if (buffer.size() - bodyStart < contentLength)
+				return ParseResult::Incomplete;
+
+			request.Body = buffer.substr(bodyStart, contentLength);
+			consumed = bodyStart + contentLength;
+			return ParseResult::Complete;
+		}
+
+		static std::string Response(int status, std::string_view contentType, std::string_view body, bool keepAlive)
+		{
+			std::string response = "HTTP/1.1 ";
+			response += std::to_string(status);
+			response += ' ';
+			response += Reason(status);
+			response += "\r\nContent-Type: ";
+			response += contentType;
+			response += "\r\nContent-Length: ";
+			response += std::to_string(body.size());
+			response += keepAlive ? "\r\n\r\n" : "\r\nConnection: close\r\n\r\n";
+			response += body;
+			return response;
+		}
+
+		static bool EqualsIgnoreCase(std::string_view a, std::string_view b)
+		{
+			return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+				return ToLower(x) == ToLower(y);
+			});
+		}
+
+		static bool StartsWithIgnoreCase(std::string_view text, std::string_view prefix)
+		{
+			return text.size() >= prefix.size() && EqualsIgnoreCase(text.substr(0, prefix.size()), prefix);
+		}
+
+	private:
+		static char ToLower(char c)
+		{
+			return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+		}
+
+		static std::string_view Trim(std::string_view text)
+		{
+			while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+				text.remove_prefix(1);
+			while (!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+				text.remove_suffix(1);
+			return text;
+		}
+
+		static const char* Reason(int status)
+		{
+			switch (status)
+			{
+			case 200:
+				return "OK";
+			case 400:
+				return "Bad Request";
+			case 404:
+				return "Not Found";
+			case 405:
+				return "Method Not Allowed";
+			case 411:
+				return "Length Required";
+			case 413:
+				return "Payload Too Large";
+			case 415:
+				return "Unsupported Media Type";
+			case 500:
+				return "Internal Server Error";
+			case 503:
+				return "Service Unavailable";
+			default:
+				return "Unknown";
+			}
+		}
+	};
+}
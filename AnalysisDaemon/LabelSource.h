@@ -0,0 +1,218 @@
+#pragma once
+#include "pch.h"
+#include "BuiltInLabels.h"
+#include "LabelCatalog.h"
+#include "LabelPack.h"
+#include "LanguageIdentifier.h"
+#include "OcrTextScanner.h"
+#include "Utf8.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace HardwareAnalyzer
+{
+	// Source of a label pack, as "hardware-analyzerd labels" compiles it (see Labels/ for a
+	// sample). UTF-8, one "key: value" per line, '#' starting a comment line:
+	//   language: id            starts a language; the lines after it describe it
+	//   script: latin           latin, cyrillic, greek, kana, hangul or han (latin if left out)
+	//   markers: ...            letters no other language of the same script uses
+	//   graphics-card: Kartu grafis|Adaptor tampilan
+	//                           a field of LabelFieldNames, '|' between alternatives, the
+	//                           first that matches winning
+	//   seed: ...               text of the "About" page, which LanguageIdentifier recognizes
+	//                           a Latin-script language by; several lines are joined
+	// Labels are written as the page shows them and folded here. Without ram-units a language
+	// takes the built-in English units, since a RAM label is only looked for with its own.
+	class LabelSource
+	{
+	public:
+		// Adds the languages of one source. On a malformed line nothing is added and error
+		// names the line.
+		bool Parse(std::string_view text, std::string& error)
+		{
+			std::vector<Language> languages;
+			size_t lineNumber = 0;
+			for (size_t start = 0; start < text.size();)
+			{
+				size_t end = text.find('\n', start);
+				if (end == std::string_view::npos)
+					end = text.size();
+				std::string_view line = Trim(text.substr(start, end - start));
+				start = end + 1;
+				lineNumber++;
+				if (line.empty() || line.front() == '#')
+					continue;
+
+				auto fail = [&](const std::string& problem) {
+					error = "line " + std::to_string(lineNumber) + ": " + problem;
+					return false;
+				};
+				size_t colon = line.find(':');
+				if (colon == std::string_view::npos)
+					return fail("expected \"key: value\"");
+				std::string_view key = Trim(line.substr(0, colon));
+				std::wstring value = Utf8::Decode(Trim(line.substr(colon + 1)));
+
+				if (key == "language")
+				{
+					if (value.empty())
+						return fail("the language has no tag");
+					languages.emplace_back().Tag = value;
+					continue;
+				}
+				if (languages.empty())
+					return fail("\"" + std::string(key) + "\" before any \"language:\" line");
+
+				Language& language = languages.back();
+				if (key == "script")
+				{
+					size_t script = 0;
+					while (script < std::size(ScriptNames) && Utf8::Decode(ScriptNames[script]) != value)
+						script++;
+					if (script == std::size(ScriptNames))
+						return fail("unknown script \"" + Utf8::Encode(value) + "\"");
+					language.Script = static_cast<WritingScript>(script);
+				}
+				else if (key == "markers")
+				{
+					language.Markers = Folded(value);
+				}
+				else if (key == "seed")
+				{
+					language.Seed += (language.Seed.empty() ? L"" : L" ") + Folded(value);
+				}
+				else
+				{
+					size_t field = 0;
+					while (field < LanguageLabels::FieldCount && LabelFieldNames[field] != key)
+						field++;
+					if (field == LanguageLabels::FieldCount)
+						return fail("unknown key \"" + std::string(key) + "\"");
+					if (language.Defined[field])
+						return fail(std::string(key) + " is given twice");
+					language.Defined[field] = true;
+					for (std::wstring_view label : LabelCatalog::Split(value))
+					{
+						std::wstring folded = Folded(label);
+						if (folded.empty())
+							return fail(std::string(key) + " has an empty alternative");
+						language.Fields[field] += (language.Fields[field].empty() ? L"" : L"|") + folded;
+					}
+				}
+			}
+
+			for (Language& language : languages)
+			{
+				if (!language.Seed.empty() && language.Script != WritingScript::Latin)
+				{
+					error = Utf8::Encode(language.Tag) + ": only Latin-script languages have a seed";
+					return false;
+				}
+				m_languages.push_back(std::move(language));
+			}
+			return true;
+		}
+
+		size_t LanguageCount() const { return m_languages.size(); }
+
+		// The catalog the parsed languages make, checked with LabelPack::Validate; nullptr
+		// and an error when it doesn't pass
+		std::shared_ptr<const LabelCatalog> Build(uint32_t dataVersion, std::string& error) const
+		{
+			if (m_languages.empty())
+			{
+				error = "no languages";
+				return nullptr;
+			}
+
+			// The views point into this copy, which the catalog keeps
+			auto storage = std::make_shared<const std::vector<Language>>(m_languages);
+			LabelSpan englishUnits = BuiltInLabels::Catalog()->Find(L"en")->Fields[static_cast<size_t>(LabelField::RamUnits)];
+
+			LabelCatalog::Contents contents;
+			contents.DataVersion = dataVersion;
+			std::vector<std::wstring_view> seeds;
+			for (const Language& source : *storage)
+			{
+				LanguageLabels language;
+				language.Tag = source.Tag;
+				language.Script = source.Script;
+				language.Markers = source.Markers;
+				for (size_t field = 0; field < LanguageLabels::FieldCount; field++)
+				{
+					language.Fields[field] = LabelCatalog::Split(source.Fields[field]);
+				}
+				auto& units = language.Fields[static_cast<size_t>(LabelField::RamUnits)];
+				if (units.empty())
+					units = englishUnits;
+
+				if (!source.Seed.empty() && seeds.size() < LabelCatalog::MaxTrigramLanguages)
+				{
+					contents.TrigramLanguages.push_back(contents.Languages.size());
+					seeds.push_back(source.Seed);
+				}
+				contents.Languages.push_back(std::move(language));
+			}
+			if (!seeds.empty())
+				contents.OwnedTrigramMasks = LanguageIdentifier::BuildProfiles(seeds);
+			contents.Storage = storage;
+
+			auto catalog = std::make_shared<const LabelCatalog>(std::move(contents));
+			if (!LabelPack::Validate(*catalog, error))
+				return nullptr;
+			return catalog;
+		}
+
+	private:
+		using LabelSpan = std::vector<std::wstring_view>;
+
+		static constexpr std::string_view ScriptNames[] = { "latin", "cyrillic", "greek", "kana", "hangul", "han" };
+		static_assert(std::size(ScriptNames) == static_cast<size_t>(WritingScript::Count));
+
+		struct Language
+		{
+			std::wstring Tag;
+			WritingScript Script = WritingScript::Latin;
+			std::wstring Markers;
+			std::array<std::wstring, LanguageLabels::FieldCount> Fields;   // Folded, '|' between alternatives
+			std::array<bool, LanguageLabels::FieldCount> Defined{};
+			std::wstring Seed;
+		};
+
+		static std::string_view Trim(std::string_view text)
+		{
+			while (!text.empty() && (text.front() == ' ' || text.front() == '\t' || text.front() == '\r'))
+				text.remove_prefix(1);
+			while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r'))
+				text.remove_suffix(1);
+			return text;
+		}
+
+		// As the scanners compare: OcrTextScanner::Fold, whitespace runs as one space
+		static std::wstring Folded(std::wstring_view text)
+		{
+			std::wstring folded;
+			for (wchar_t c : text)
+			{
+				if (OcrTextScanner::IsSpace(c))
+				{
+					if (!folded.empty() && folded.back() != L' ')
+						folded += L' ';
+				}
+				else
+				{
+					folded += OcrTextScanner::Fold(c);
+				}
+			}
+			if (!folded.empty() && folded.back() == L' ')
+				folded.pop_back();
+			return folded;
+		}
+
+		std::vector<Language> m_languages;
+	};
+}
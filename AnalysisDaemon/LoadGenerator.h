@@ -0,0 +1,186 @@
+#pragma once
+#include "pch.h"
+#include "ServerMetrics.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace HardwareAnalyzer
+{
+	// Closed-loop load against a running AnalysisServer: each connection sends a request,
+	// waits for the response, and sends the next one, for a fixed duration.
+	class LoadGenerator
+	{
+	public:
+		struct Options
+		{
+			std::string SocketPath;
+			uint16_t Port = 0;
+			std::string Target = "/v1/windows";
+			std::string Body;
+			std::vector<std::string> Bodies;   // Sent in turn instead of Body when not empty
+			unsigned Connections = 32;
+			std::chrono::seconds Duration{ 10 };
+		};
+
+		struct Report
+		{
+			uint64_t Succeeded = 0;
+			uint64_t Failed = 0;           // Non-200 responses
+			uint64_t ConnectionErrors = 0;
+			double Seconds = 0;
+			LatencyHistogram Latency;
+
+			double RequestsPerSecond() const { return Seconds > 0 ? static_cast<double>(Succeeded) / Seconds : 0; }
+		};
+
+		static void Run(const Options& options, Report& report)
+		{
+			std::vector<std::string> requests;
+			for (const std::string& body : options.Bodies.empty() ? std::vector<std::string>{ options.Body } : options.Bodies)
+			{
+				requests.push_back("POST " + options.Target + " HTTP/1.1\r\nHost: localhost\r\nContent-Type: text/plain; charset=utf-8\r\nContent-Length: "
+					+ std::to_string(body.size()) + "\r\n\r\n" + body);
+			}
+
+			std::atomic<uint64_t> succeeded{ 0 };
+			std::atomic<uint64_t> failed{ 0 };
+			std::atomic<uint64_t> connectionErrors{ 0 };
+			auto started = std::chrono::steady_clock::now();
+			auto deadline = started + options.Duration;
+
+			std::vector<std::thread> clients;
+			for (unsigned i = 0; i < (std::max)(options.Connections, 1u); i++)
+			{
+				clients.emplace_back([&, i] {
+					int fd = Connect(options);
+					if (fd < 0)
+					{
+						connectionErrors.fetch_add(1, std::memory_order_relaxed);
+						return;
+					}
+
+					// Each connection starts at its own request so they don't send the same one at once
+					std::string buffer;
+					size_t next = i % requests.size();
+					while (std::chrono::steady_clock::now() < deadline)
+					{
+						auto sent = std::chrono::steady_clock::now();
+						int status = 0;
+						const std::string& request = requests[next];
+						next = next + 1 == requests.size() ? 0 : next + 1;
+						if (!SendAll(fd, request) || !ReceiveResponse(fd, buffer, status))
+						{
+							connectionErrors.fetch_add(1, std::memory_order_relaxed);
+							break;
+						}
+						report.Latency.Record(std::chrono::steady_clock::now() - sent);
+						(status == 200 ? succeeded : failed).fetch_add(1, std::memory_order_relaxed);
+					}
+					close(fd);
+				});
+			}
+			for (auto& client : clients)
+			{
+				client.join();
+			}
+
+			report.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+			report.Succeeded = succeeded.load();
+			report.Failed = failed.load();
+			report.ConnectionErrors = connectionErrors.load();
+		}
+
+	private:
+		static int Connect(const Options& options)
+		{
+			int fd;
+			int result;
+			if (options.Port != 0)
+			{
+				fd = socket(AF_INET, SOCK_STREAM, 0);
+				sockaddr_in address{};
+				address.sin_family = AF_INET;
+				address.sin_port = htons(options.Port);
+				address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+				result = fd < 0 ? -1 : connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+				int noDelay = 1;
+				if (result == 0)
+					setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+			}
+			else
+			{
+				fd = socket(AF_UNIX, SOCK_STREAM, 0);
+				sockaddr_un address{};
+				address.sun_family = AF_UNIX;
+				std::strncpy(address.sun_path, options.SocketPath.c_str(), sizeof(address.sun_path) - 1);
+				result = fd < 0 ? -1 : connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+			}
+			if (result != 0)
+			{
+				if (fd >= 0)
+					close(fd);
+				return -1;
+			}
+			return fd;
+		}
+
+		static bool SendAll(int fd, const std::string& data)
+		{
+			size_t sent = 0;
+			while (sent < data.size())
+			{
+				int flags = 0;
+#ifdef MSG_NOSIGNAL
+				flags = MSG_NOSIGNAL;
+#endif
+				ssize_t count = send(fd, data.data() + sent, data.size() - sent, flags);
+				if (count <= 0)
+					return false;
+				sent += static_cast<size_t>(count);
+			}
+			return true;
+		}
+
+		// Reads one Content-Length response; bytes past it stay in 'buffer'
+		static bool ReceiveResponse(int fd, std::string& buffer, int& status)
+		{
+			char chunk[16 * 1024];
+			for (;;)
+			{
+				size_t headerEnd = buffer.find("\r\n\r\n");
+				if (headerEnd != std::string::npos)
+				{
+					size_t length = 0;
+					size_t field = buffer.find("Content-Length: ");
+					if (field != std::string::npos && field < headerEnd)
+						length = std::strtoul(buffer.c_str() + field + 16, nullptr, 10);
+					if (buffer.size() >= headerEnd + 4 + length)
+					{
+						status = buffer.size() > 12 ? std::atoi(buffer.c_str() + 9) : 0;
+						buffer.erase(0, headerEnd + 4 + length);
+						return true;
+					}
+				}
+
+				ssize_t count = recv(fd, chunk, sizeof(chunk), 0);
+				if (count <= 0)
+					return false;
+				buffer.append(chunk, static_cast<size_t>(count));
+			}
+		}
+	};
+}
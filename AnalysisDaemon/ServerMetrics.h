@@ -0,0 +1,175 @@
+#pragma once
+#include "pch.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace HardwareAnalyzer
+{
+	// Latency histogram with power-of-two microsecond buckets (<1us, <2us, <4us, ... <~67s).
+	// Recording is one relaxed atomic increment, so every request can be measured.
+	class LatencyHistogram
+	{
+	public:
+		static constexpr size_t BucketCount = 27;
+
+		void Record(std::chrono::nanoseconds elapsed)
+		{
+			uint64_t us = static_cast<uint64_t>(elapsed.count() > 0 ? elapsed.count() / 1000 : 0);
+			size_t bucket = (std::min)(static_cast<size_t>(std::bit_width(us)), BucketCount - 1);
+			m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+			m_count.fetch_add(1, std::memory_order_relaxed);
+			m_sumUs.fetch_add(us, std::memory_order_relaxed);
+		}
+
+		// Upper bound in microseconds of bucket i
+		static uint64_t BucketLimitUs(size_t bucket)
+		{
+			return uint64_t{ 1 } << bucket;
+		}
+
+		uint64_t Count() const { return m_count.load(std::memory_order_relaxed); }
+		uint64_t SumUs() const { return m_sumUs.load(std::memory_order_relaxed); }
+		uint64_t Bucket(size_t bucket) const { return m_buckets[bucket].load(std::memory_order_relaxed); }
+
+		// Upper bound of the bucket holding the q-quantile (0 when empty)
+		uint64_t QuantileUs(double q) const
+		{
+			uint64_t total = 0;
+			std::array<uint64_t, BucketCount> counts;
+			for (size_t i = 0; i < BucketCount; i++)
+			{
+				counts[i] = Bucket(i);
+				total += counts[i];
+			}
+			if (total == 0)
+				return 0;
+
+			uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+			uint64_t seen = 0;
+			for (size_t i = 0; i < BucketCount; i++)
+			{
+				seen += counts[i];
+				if (seen >= rank)
+					return BucketLimitUs(i);
+			}
+			return BucketLimitUs(BucketCount - 1);
+		}
+
+	private:
+		std::array<std::atomic<uint64_t>, BucketCount> m_buckets{};
+		std::atomic<uint64_t> m_count{ 0 };
+		std::atomic<uint64_t> m_sumUs{ 0 };
+	};
+
+	// Counters for the analysis daemon, rendered in the Prometheus text format by /metrics
+	class ServerMetrics
+	{
+	public:
+		enum class Endpoint : uint8_t
+		{
+			Windows,
+			MacOS,
+			Count
+		};
+
+		std::array<std::atomic<uint64_t>, static_cast<size_t>(Endpoint::Count)> Requests{};
+		std::atomic<uint64_t> Rejected{ 0 };      // Queue full: answered 503 without analysis
+		std::atomic<uint64_t> BadRequests{ 0 };   // 4xx
+		std::atomic<uint64_t> Batches{ 0 };
+		std::atomic<uint64_t> BatchedRequests{ 0 };
+		std::atomic<uint64_t> OpenConnections{ 0 };
+		std::atomic<uint64_t> QueueDepth{ 0 };
+		std::atomic<uint64_t> HistoryDropped{ 0 };   // Analyses the history failed to record
+
+		LatencyHistogram RequestLatency;   // Request parsed -> response ready to send
+		LatencyHistogram QueueWait;        // Request parsed -> picked up by a worker
+		LatencyHistogram AnalysisTime;     // Parse + analyze + score + JSON on the worker
+
+		void RecordBatch(size_t size)
+		{
+			Batches.fetch_add(1, std::memory_order_relaxed);
+			BatchedRequests.fetch_add(size, std::memory_order_relaxed);
+		}
+
+		std::string ToPrometheusText()
+		{
+			auto now = std::chrono::steady_clock::now();
+			uint64_t completed = RequestLatency.Count();
+
+			// Throughput over the whole uptime and since the previous scrape
+			double uptime = std::chrono::duration<double>(now - m_started).count();
+			double recentRate = 0;
+			{
+				std::lock_guard<std::mutex> lock(m_scrapeLock);
+				double interval = std::chrono::duration<double>(now - m_lastScrape).count();
+				if (interval > 0)
+					recentRate = static_cast<double>(completed - m_lastCompleted) / interval;
+				m_lastScrape = now;
+				m_lastCompleted = completed;
+			}
+
+			std::string text;
+			auto line = [&](const char* name, const std::string& labels, auto value) {
+				text += "hardware_analyzer_";
+				text += name;
+				if (!labels.empty())
+					text += '{' + labels + '}';
+				text += ' ';
+				text += std::to_string(value);
+				text += '\n';
+			};
+
+			line("uptime_seconds", "", uptime);
+			line("requests_total", "endpoint=\"windows\"", Requests[static_cast<size_t>(Endpoint::Windows)].load());
+			line("requests_total", "endpoint=\"macos\"", Requests[static_cast<size_t>(Endpoint::MacOS)].load());
+			line("completed_total", "", completed);
+			line("rejected_total", "", Rejected.load());
+			line("bad_requests_total", "", BadRequests.load());
+			line("throughput_per_second", "window=\"uptime\"", uptime > 0 ? static_cast<double>(completed) / uptime : 0.0);
+			line("throughput_per_second", "window=\"since_last_scrape\"", recentRate);
+			line("batches_total", "", Batches.load());
+			line("batched_requests_total", "", BatchedRequests.load());
+			line("queue_depth", "", QueueDepth.load());
+			line("open_connections", "", OpenConnections.load());
+			line("history_dropped_total", "", HistoryDropped.load());
+
+			AppendHistogram(text, "request_latency_us", RequestLatency);
+			AppendHistogram(text, "queue_wait_us", QueueWait);
+			AppendHistogram(text, "analysis_time_us", AnalysisTime);
+			return text;
+		}
+
+	private:
+		static void AppendHistogram(std::string& text, const char* name, const LatencyHistogram& histogram)
+		{
+			std::string prefix = std::string("hardware_analyzer_") + name;
+			uint64_t cumulative = 0;
+			for (size_t i = 0; i < LatencyHistogram::BucketCount; i++)
+			{
+				cumulative += histogram.Bucket(i);
+				if (i + 1 == LatencyHistogram::BucketCount)
+					break;   // The last bucket also holds everything slower: only +Inf covers it
+				text += prefix + "_bucket{le=\"" + std::to_string(LatencyHistogram::BucketLimitUs(i)) + "\"} " + std::to_string(cumulative) + '\n';
+			}
+			text += prefix + "_bucket{le=\"+Inf\"} " + std::to_string(cumulative) + '\n';
+			text += prefix + "_sum " + std::to_string(histogram.SumUs()) + '\n';
+			text += prefix + "_count " + std::to_string(histogram.Count()) + '\n';
+
+			for (double q : { 0.5, 0.9, 0.99, 0.999 })
+			{
+				text += prefix + "_quantile{q=\"" + std::to_string(q).substr(0, 5) + "\"} " + std::to_string(histogram.QuantileUs(q)) + '\n';
+			}
+		}
+
+		std::chrono::steady_clock::time_point m_started = std::chrono::steady_clock::now();
+		std::mutex m_scrapeLock;
+		std::chrono::steady_clock::time_point m_lastScrape = m_started;
+		uint64_t m_lastCompleted = 0;
+	};
+}
@@ -0,0 +1,435 @@
+#pragma once
+#include "pch.h"
+#include "AnalysisPipeline.h"
+#include "MappedFile.h"
+#include "ResultSerializer.h"
+#include "SystemProfilerParser.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory_resource>
+#include <optional>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace HardwareAnalyzer
+{
+	// Analyzes a file of JSON lines, one OCR page each as "corpus" writes them, over several
+	// worker processes: the page is the "text" string, of a Mac when "platform" is "macos".
+	//
+	// The input is cut into chunks of about ChunkBytes, on line boundaries. The cut depends
+	// only on the file and ChunkBytes, so the coordinator and every worker make the same one
+	// and no ranges are passed around. Worker w of n analyzes chunks w, w + n, w + 2n... and
+	// writes each result to its own shard file as a frame: the byte offset of the page's line
+	// in the input, then the serialized result. Each shard is in offset order, so a k-way merge
+	// on the offsets puts the results back in input order: the output is the same bytes for
+	// any number of workers and any chunk size. A worker needs nothing but the input and its
+	// arguments, so shards could as well come from other hosts holding a copy of the input;
+	// here everything runs locally, through the file system.
+	class ShardedBatch
+	{
+	public:
+		struct Options
+		{
+			std::string Program;              // This daemon, run as "Program batch-worker ..."
+			std::string InputPath;
+			std::string OutputPath;
+			std::string ShardDirectory;       // Empty: OutputPath + ".shards", removed afterwards
+			unsigned Workers = (std::max)(std::thread::hardware_concurrency(), 1u);
+			size_t ChunkBytes = 4 << 20;
+			ResultSerializer::Format Format = ResultSerializer::Format::Json;
+			TargetPlatform CsvPlatform = TargetPlatform::Windows;  // CSV has one platform's columns
+		};
+
+		struct Statistics
+		{
+			uint64_t Records = 0;
+			uint64_t Skipped = 0;             // Lines without a "text" string, or of the other platform in CSV
+			uint64_t InputBytes = 0;
+			uint64_t OutputBytes = 0;
+			double AnalyzeSeconds = 0;        // Until the last worker is done
+			double MergeSeconds = 0;
+		};
+
+		// Bytes [Begin, End) of the input
+		struct Range
+		{
+			size_t Begin = 0;
+			size_t End = 0;
+		};
+
+		// Chunks of about 'chunkBytes' each covering 'data', each ending after a newline (or at
+		// the end of the data). Only the bytes around the nominal cuts are read.
+		static std::vector<Range> Split(std::string_view data, size_t chunkBytes)
+		{
+			chunkBytes = (std::max)(chunkBytes, size_t(1));
+			std::vector<Range> ranges;
+			size_t begin = 0;
+			while (begin < data.size())
+			{
+				size_t end = data.size();
+				if (data.size() - begin > chunkBytes)
+				{
+					const void* newline = std::memchr(data.data() + begin + chunkBytes - 1, '\n', data.size() - begin - chunkBytes + 1);
+					if (newline)
+						end = static_cast<size_t>(static_cast<const char*>(newline) - data.data()) + 1;
+				}
+				ranges.push_back({ begin, end });
+				begin = end;
+			}
+			return ranges;
+		}
+
+		// Runs the workers, waits for them and merges their shards into OutputPath
+		static bool Run(const Options& options, Statistics& stats, std::string& error)
+		{
+			stats = Statistics{};
+			auto start = std::chrono::steady_clock::now();
+			std::error_code code;
+			stats.InputBytes = std::filesystem::file_size(options.InputPath, code);
+			if (code)
+			{
+				error = "can't read " + options.InputPath + ": " + code.message();
+				return false;
+			}
+
+			std::filesystem::path shards = options.ShardDirectory.empty() ? options.OutputPath + ".shards" : options.ShardDirectory;
+			std::filesystem::create_directories(shards, code);
+			if (code)
+			{
+				error = "can't create " + shards.string() + ": " + code.message();
+				return false;
+			}
+
+			// An empty input has no chunks, and nothing for workers to do
+			unsigned workers = stats.InputBytes == 0 ? 0 : (std::max)(options.Workers, 1u);
+			std::vector<std::string> shardPaths;
+			std::vector<pid_t> pids;
+			for (unsigned worker = 0; worker < workers && error.empty(); worker++)
+			{
+				shardPaths.push_back((shards / ("shard-" + std::to_string(worker))).string());
+				pid_t pid = 0;
+				if (Spawn(options, worker, workers, shardPaths.back(), pid, error))
+					pids.push_back(pid);
+			}
+			// A worker that couldn't start leaves a gap: stop the others rather than wait for them
+			for (size_t worker = 0; worker < pids.size(); worker++)
+			{
+				if (!error.empty())
+					kill(pids[worker], SIGTERM);
+				int status = 0;
+				while (waitpid(pids[worker], &status, 0) < 0 && errno == EINTR)
+				{
+				}
+				if (error.empty() && (!WIFEXITED(status) || WEXITSTATUS(status) != 0))
+					error = "worker " + std::to_string(worker) + " failed";
+			}
+			stats.AnalyzeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			start = std::chrono::steady_clock::now();
+			bool merged = error.empty() && Merge(options, shardPaths, stats, error);
+			stats.MergeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			for (const std::string& path : shardPaths)
+				std::filesystem::remove(path, code);
+			if (options.ShardDirectory.empty())
+				std::filesystem::remove(shards, code);
+			if (!merged)
+				std::filesystem::remove(options.OutputPath, code);
+			return merged;
+		}
+
+		// What a worker process runs: chunks worker, worker + workers, ... of the input into
+		// the shard at shardPath
+		static bool RunWorker(const Options& options, unsigned worker, unsigned workers, const std::string& shardPath, std::string& error)
+		{
+			std::optional<MappedFile> input = MappedFile::Open(options.InputPath);
+			if (!input)
+			{
+				error = "can't map " + options.InputPath;
+				return false;
+			}
+			std::FILE* shard = std::fopen(shardPath.c_str(), "wb");
+			if (!shard)
+			{
+				error = "can't create " + shardPath + ": " + std::strerror(errno);
+				return false;
+			}
+
+			std::string_view data(reinterpret_cast<const char*>(input->Data()), input->Size());
+			std::vector<Range> ranges = Split(data, options.ChunkBytes);
+			PageReader reader;
+			OutputBuffer out;
+			std::vector<std::byte> arenaBuffer(64 * 1024);
+			bool written = true;
+			for (size_t chunk = worker; chunk < ranges.size() && written; chunk += workers)
+			{
+				for (size_t begin = ranges[chunk].Begin; begin < ranges[chunk].End;)
+				{
+					const void* newline = std::memchr(data.data() + begin, '\n', ranges[chunk].End - begin);
+					size_t end = newline ? static_cast<size_t>(static_cast<const char*>(newline) - data.data()) : ranges[chunk].End;
+					std::string_view line = data.substr(begin, end - begin);
+					uint64_t offset = begin;
+					begin = end + 1;
+					if (line.find_first_not_of(" \t\r") == std::string_view::npos)
+						continue;
+
+					// A frame of the line's offset and the result's length, then the result; a
+					// page that can't be read gets an empty frame, which the merge counts
+					char* header = out.Reserve(FrameHeaderBytes);
+					std::memcpy(header, &offset, sizeof(offset));
+					out.Commit(header + FrameHeaderBytes);
+					size_t payload = out.Size();
+					if (reader.Read(line) && (options.Format != ResultSerializer::Format::Csv || reader.Platform == options.CsvPlatform))
+					{
+						std::pmr::monotonic_buffer_resource arena(arenaBuffer.data(), arenaBuffer.size());
+						if (reader.Platform == TargetPlatform::macOS)
+							ResultSerializer::Write(options.Format, out, AnalysisPipeline::AnalyzeMacOSText(reader.Text, &arena));
+						else
+							ResultSerializer::Write(options.Format, out, AnalysisPipeline::AnalyzeWindowsText(reader.Text, &arena));
+					}
+					uint32_t length = static_cast<uint32_t>(out.Size() - payload);
+					std::memcpy(out.Data() + payload - sizeof(length), &length, sizeof(length));
+				}
+				if (out.Size() >= FlushBytes)
+				{
+					written = std::fwrite(out.Data(), 1, out.Size(), shard) == out.Size();
+					out.Clear();
+				}
+			}
+			written = written && std::fwrite(out.Data(), 1, out.Size(), shard) == out.Size();
+			if (std::fclose(shard) != 0 || !written)
+			{
+				error = "can't write " + shardPath;
+				return false;
+			}
+			return true;
+		}
+
+		// k-way merge of the shards on the frames' offsets into OutputPath, as Run does once its
+		// workers are done. Every offset is in one shard only, so the order is total and doesn't
+		// depend on how the chunks were dealt out.
+		static bool Merge(const Options& options, const std::vector<std::string>& shardPaths, Statistics& stats, std::string& error)
+		{
+			std::FILE* output = std::fopen(options.OutputPath.c_str(), "wb");
+			if (!output)
+			{
+				error = "can't create " + options.OutputPath + ": " + std::strerror(errno);
+				return false;
+			}
+			std::vector<char> outputBuffer(FlushBytes);
+			std::setvbuf(output, outputBuffer.data(), _IOFBF, outputBuffer.size());
+
+			bool written = true;
+			if (options.Format == ResultSerializer::Format::Csv)
+			{
+				OutputBuffer header;
+				if (options.CsvPlatform == TargetPlatform::macOS)
+					ResultSerializer::CsvHeader<MacOSAnalysis>(header);
+				else
+					ResultSerializer::CsvHeader<WindowsAnalysis>(header);
+				written = std::fwrite(header.Data(), 1, header.Size(), output) == header.Size();
+				stats.OutputBytes += header.Size();
+			}
+
+			std::vector<std::unique_ptr<ShardReader>> readers;
+			using Head = std::pair<uint64_t, size_t>;  // Offset of the shard's next frame, shard
+			std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+			for (const std::string& path : shardPaths)
+			{
+				readers.push_back(std::make_unique<ShardReader>(path));
+				if (!readers.back()->Opened())
+				{
+					error = "can't read " + path;
+					std::fclose(output);
+					return false;
+				}
+				if (readers.back()->Next())
+					heads.emplace(readers.back()->Offset, readers.size() - 1);
+			}
+
+			while (!heads.empty() && written)
+			{
+				size_t shard = heads.top().second;
+				ShardReader& reader = *readers[shard];
+				heads.pop();
+				if (reader.Payload.empty())
+					stats.Skipped++;
+				else
+					stats.Records++;
+				written = std::fwrite(reader.Payload.data(), 1, reader.Payload.size(), output) == reader.Payload.size();
+				stats.OutputBytes += reader.Payload.size();
+				if (reader.Next())
+					heads.emplace(reader.Offset, shard);
+			}
+			written = std::fclose(output) == 0 && written;
+			if (!written)
+			{
+				error = "can't write " + options.OutputPath;
+				return false;
+			}
+			for (size_t shard = 0; shard < readers.size(); shard++)
+			{
+				if (!readers[shard]->Finished())
+				{
+					error = shardPaths[shard] + " ends in a torn frame";
+					return false;
+				}
+			}
+			return true;
+		}
+
+	private:
+		// u64 input offset and u32 result length, in native byte order: shards are merged on
+		// the machine that wrote them
+		static constexpr size_t FrameHeaderBytes = sizeof(uint64_t) + sizeof(uint32_t);
+		static constexpr size_t FlushBytes = 1 << 20;
+
+		// The page of one input line, its buffers reused from line to line
+		struct PageReader
+		{
+			std::wstring Text;
+			TargetPlatform Platform = TargetPlatform::Windows;
+
+			bool Read(std::string_view line)
+			{
+				std::optional<std::string_view> text = StringValue(line, "text");
+				if (!text)
+					return false;
+				std::optional<std::string_view> platform = StringValue(line, "platform");
+				Platform = platform && *platform == "macos" ? TargetPlatform::macOS : TargetPlatform::Windows;
+				if (text->find('\\') == std::string_view::npos)
+				{
+					Utf8::Decode(*text, Text);
+				}
+				else
+				{
+					m_unescaped = SystemProfilerParser::Unescape(*text);
+					Utf8::Decode(m_unescaped, Text);
+				}
+				return true;
+			}
+
+		private:
+			// The string value of "key", escapes left in. Quotes inside strings are escaped, so
+			// the first "key" followed by a colon is a key, if not necessarily a top-level one.
+			static std::optional<std::string_view> StringValue(std::string_view line, std::string_view key)
+			{
+				for (size_t at = line.find(key); at != std::string_view::npos; at = line.find(key, at + 1))
+				{
+					if (at == 0 || line[at - 1] != '"' || line.substr(at + key.size(), 1) != "\"")
+						continue;
+					size_t value = line.find_first_not_of(" \t", at + key.size() + 1);
+					if (value == std::string_view::npos || line[value] != ':')
+						continue;
+					value = line.find_first_not_of(" \t", value + 1);
+					if (value == std::string_view::npos || line[value] != '"')
+						return std::nullopt;
+
+					size_t end = ++value;
+					for (;;)
+					{
+						end = line.find('"', end);
+						if (end == std::string_view::npos)
+							return std::nullopt;
+						size_t backslashes = 0;
+						while (line[end - backslashes - 1] == '\\')
+							backslashes++;
+						if (backslashes % 2 == 0)
+							return line.substr(value, end - value);
+						end++;
+					}
+				}
+				return std::nullopt;
+			}
+
+			std::string m_unescaped;
+		};
+
+		// The frames of one shard, read in order
+		class ShardReader
+		{
+		public:
+			explicit ShardReader(const std::string& path)
+				: m_file(std::fopen(path.c_str(), "rb")), m_buffer(FlushBytes)
+			{
+				if (m_file)
+					std::setvbuf(m_file, m_buffer.data(), _IOFBF, m_buffer.size());
+			}
+
+			ShardReader(const ShardReader&) = delete;
+			ShardReader& operator=(const ShardReader&) = delete;
+
+			~ShardReader()
+			{
+				if (m_file)
+					std::fclose(m_file);
+			}
+
+			bool Opened() const { return m_file != nullptr; }
+
+			// The next frame into Offset and Payload; false at the end or on a torn frame
+			bool Next()
+			{
+				char header[FrameHeaderBytes];
+				uint32_t length = 0;
+				if (std::fread(header, 1, sizeof(header), m_file) != sizeof(header))
+					return false;
+				std::memcpy(&Offset, header, sizeof(Offset));
+				std::memcpy(&length, header + sizeof(Offset), sizeof(length));
+				Payload.resize(length);
+				return std::fread(Payload.data(), 1, length, m_file) == length;
+			}
+
+			// After Next returned false: whether that was the clean end of the shard
+			bool Finished() const { return std::feof(m_file) && !std::ferror(m_file); }
+
+			uint64_t Offset = 0;
+			std::string Payload;
+
+		private:
+			std::FILE* m_file;
+			std::vector<char> m_buffer;
+		};
+
+		static bool Spawn(const Options& options, unsigned worker, unsigned workers, const std::string& shardPath, pid_t& pid, std::string& error)
+		{
+			const char* format = options.Format == ResultSerializer::Format::Csv ? "csv" : options.Format == ResultSerializer::Format::Binary ? "binary" : "json";
+			std::vector<std::string> arguments = { options.Program, "batch-worker", "--worker", std::to_string(worker), "--workers", std::to_string(workers),
+				"--chunk-kb", std::to_string((std::max)(options.ChunkBytes / 1024, size_t(1))), "--format", format, "--output", shardPath };
+			if (options.CsvPlatform == TargetPlatform::macOS)
+				arguments.push_back("--macos");
+			arguments.push_back(options.InputPath);
+
+			std::vector<char*> argv;
+			for (std::string& argument : arguments)
+				argv.push_back(argument.data());
+			argv.push_back(nullptr);
+			int spawned = posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(), environ);
+			if (spawned != 0)
+			{
+				error = "can't run " + options.Program + ": " + std::strerror(spawned);
+				return false;
+			}
+			return true;
+		}
+	};
+}
@@ -0,0 +1,797 @@
+#pragma once
+#include "pch.h"
+#include "AnalysisHistory.h"
+#include "AnalysisJson.h"
+#include "AnalysisPipeline.h"
+#include "AsyncTask.h"
+#include "BatchQueue.h"
+#include "DiagnosticsReportParser.h"
+#include "SystemProfilerParser.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace HardwareAnalyzer
+{
+	// Turns a screenshot into text for the watch folder. Recognize is called from several
+	// OCR workers at once, so implementations must be thread-safe (or pool their engines,
+	// see OcrEnginePool).
+	class IImageOcrBackend
+	{
+	public:
+		virtual ~IImageOcrBackend() = default;
+
+		// The text of the image file at 'path', whose bytes are 'image'; false with 'error' set
+		virtual bool Recognize(const std::filesystem::path& path, std::string_view image, std::wstring& text, std::string& error) = 0;
+	};
+
+	// Runs an OCR program per image, e.g. "tesseract {} stdout". The command is split on
+	// spaces, "{}" becomes the image path as one argument (no shell is involved, so any file
+	// name is safe) and the program's standard output, UTF-8, is the text.
+	class CommandOcrBackend : public IImageOcrBackend
+	{
+	public:
+		explicit CommandOcrBackend(std::string_view command)
+		{
+			for (size_t start = 0; start < command.size();)
+			{
+				size_t end = (std::min)(command.find(' ', start), command.size());
+				if (end > start)
+					m_arguments.emplace_back(command.substr(start, end - start));
+				start = end + 1;
+			}
+		}
+
+		bool Recognize(const std::filesystem::path& path, std::string_view, std::wstring& text, std::string& error) override
+		{
+			if (m_arguments.empty())
+			{
+				error = "no OCR command";
+				return false;
+			}
+
+			std::vector<std::string> arguments = m_arguments;
+			std::vector<char*> argv;
+			for (std::string& argument : arguments)
+			{
+				if (argument == "{}")
+					argument = path.string();
+				argv.push_back(argument.data());
+			}
+			argv.push_back(nullptr);
+
+			int output[2];
+			if (pipe2(output, O_CLOEXEC) != 0)
+			{
+				error = std::string("pipe: ") + std::strerror(errno);
+				return false;
+			}
+			posix_spawn_file_actions_t actions;
+			posix_spawn_file_actions_init(&actions);
+			posix_spawn_file_actions_adddup2(&actions, output[1], STDOUT_FILENO);
+			posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+			pid_t pid = 0;
+			int spawned = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+			posix_spawn_file_actions_destroy(&actions);
+			close(output[1]);
+			if (spawned != 0)
+			{
+				close(output[0]);
+				error = "can't run " + m_arguments[0] + ": " + std::strerror(spawned);
+				return false;
+			}
+
+			std::string bytes;
+			char buffer[16 * 1024];
+			for (;;)
+			{
+				ssize_t length = read(output[0], buffer, sizeof(buffer));
+				if (length > 0)
+					bytes.append(buffer, static_cast<size_t>(length));
+				else if (length == 0 || errno != EINTR)
+					break;
+			}
+			close(output[0]);
+
+			int status = 0;
+			while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+			{
+			}
+			if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			{
+				error = m_arguments[0] + " failed";
+				return false;
+			}
+			text = Utf8::Decode(bytes);
+			return true;
+		}
+
+	private:
+		std::vector<std::string> m_arguments;
+	};
+
+	// Analyzes the screenshots and text exports dropped into directories, as they land:
+	//
+	//   inotify -> debounce -> [queue] decode -> [queue] OCR -> [queue] parse, analyze,
+	//   score, write the result
+	//
+	// One thread reads the inotify events. A file is ready once it has been closed after
+	// writing (or moved in) and then left alone for the settle time; one that is written
+	// but never closed, as some sync clients do, once it has been quiet for longer. Each
+	// stage has its own workers and a bounded BatchQueue. Workers wait for room downstream,
+	// and the event thread holds ready files back while the first queue is full, so a
+	// burst backs up into the directory instead of memory.
+	//
+	// Text files are dxdiag or msinfo32 exports (system_profiler or sw_vers output with
+	// Platform macOS) when DiagnosticsReportParser recognizes them, OCR text otherwise;
+	// images go through the OCR backend. Without a backend, images are left for a later
+	// run that has one.
+	//
+	// Each result is "<input>.result.json", next to the input or in ResultsDirectory: the
+	// analysis JSON plus "file", or just "file" and "error". It is written to a temporary
+	// file, synced and renamed into place, so readers never see half of one. Its mtime is
+	// set to the input's: a file counts as done when a result with its mtime exists. At
+	// startup, and after an inotify queue overflow, the directories are scanned and every
+	// file that isn't done goes through, so files that arrived while the daemon was down
+	// are caught up and finished ones aren't redone. A file rewritten later is redone.
+	class WatchFolder
+	{
+	public:
+		struct Options
+		{
+			std::vector<std::string> Directories;
+			std::string ResultsDirectory;               // Empty = next to each input
+			std::string HistoryDirectory;               // Also append to this AnalysisHistory; empty = don't
+			TargetPlatform Platform = TargetPlatform::Windows;
+			std::chrono::milliseconds Settle{ 200 };    // After the last close or move
+			std::chrono::milliseconds Quiet{ 5000 };    // After the last write, when there's no close
+			unsigned DecodeWorkers = 1;
+			unsigned OcrWorkers = ThreadPoolExecutor::DefaultThreadCount();
+			unsigned AnalyzeWorkers = 2;
+			size_t QueueCapacity = 256;                 // Per stage
+			size_t MaxFileBytes = 64 * 1024 * 1024;
+			bool Once = false;                          // Return from Run once the backlog is done
+		};
+
+		struct Statistics
+		{
+			std::atomic<uint64_t> Analyzed{ 0 };
+			std::atomic<uint64_t> Failed{ 0 };          // Written with an "error"
+			std::atomic<uint64_t> Deferred{ 0 };        // Images with no OCR backend
+			std::atomic<uint64_t> AlreadyDone{ 0 };
+			std::atomic<uint64_t> Overflows{ 0 };
+			std::atomic<uint64_t> HistoryDropped{ 0 };  // Analyses the history failed to record
+		};
+
+		WatchFolder(Options options, std::unique_ptr<IImageOcrBackend> ocr)
+			: m_options(std::move(options)), m_ocr(std::move(ocr)),
+			m_decodeQueue(m_options.QueueCapacity), m_ocrQueue(m_options.QueueCapacity), m_analyzeQueue(m_options.QueueCapacity)
+		{
+		}
+
+		~WatchFolder()
+		{
+			Shutdown();
+		}
+
+		WatchFolder(const WatchFolder&) = delete;
+		WatchFolder& operator=(const WatchFolder&) = delete;
+
+		// Watches the directories, queues what they already hold and starts the workers;
+		// false with 'error' set on failure
+		bool Start(std::string& error)
+		{
+			int pipeFds[2];
+			if (pipe2(pipeFds, O_NONBLOCK | O_CLOEXEC) != 0)
+			{
+				error = std::string("pipe: ") + std::strerror(errno);
+				return false;
+			}
+			m_wakeRead = pipeFds[0];
+			m_wakeWrite = pipeFds[1];
+
+			m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			if (m_inotify < 0)
+			{
+				error = std::string("inotify: ") + std::strerror(errno);
+				return false;
+			}
+			for (const std::string& directory : m_options.Directories)
+			{
+				int wd = inotify_add_watch(m_inotify, directory.c_str(),
+					IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY | IN_DELETE | IN_MOVED_FROM | IN_ONLYDIR);
+				if (wd < 0)
+				{
+					error = directory + ": " + std::strerror(errno);
+					return false;
+				}
+				m_watches[wd] = directory;
+			}
+
+			if (!m_options.ResultsDirectory.empty())
+			{
+				std::error_code ignored;
+				std::filesystem::create_directories(m_options.ResultsDirectory, ignored);
+			}
+			if (!m_options.HistoryDirectory.empty())
+			{
+				m_history = std::make_unique<AnalysisHistory>();
+				if (!m_history->Open(m_options.HistoryDirectory, error))
+					return false;
+			}
+
+			// Watching first, then scanning: a file that lands in between is seen twice,
+			// which the in-flight set and the result check absorb, rather than not at all
+			CatchUp();
+
+			auto start = [](std::vector<std::thread>& threads, unsigned count, auto loop) {
+				for (unsigned i = 0; i < (std::max)(count, 1u); i++)
+					threads.emplace_back(loop);
+			};
+			start(m_decodeWorkers, m_options.DecodeWorkers, [this] { DecodeLoop(); });
+			start(m_ocrWorkers, m_options.OcrWorkers, [this] { OcrLoop(); });
+			start(m_analyzeWorkers, m_options.AnalyzeWorkers, [this] { AnalyzeLoop(); });
+			return true;
+		}
+
+		// Reads events until Stop() is called (or, with Once, until the backlog is done)
+		void Run()
+		{
+			alignas(inotify_event) char events[64 * 1024];
+			while (!m_stopping.load(std::memory_order_acquire))
+			{
+				auto now = std::chrono::steady_clock::now();
+				Dispatch(now);
+				if (m_options.Once && m_pending.empty() && m_ready.empty() && InFlight() == 0)
+					break;
+
+				// A full first queue is retried shortly; otherwise sleep until the next file settles
+				int timeout = -1;
+				if (!m_ready.empty())
+					timeout = 10;
+				else if (!m_pending.empty())
+					timeout = static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(m_nextDeadline - now).count());
+				else if (m_options.Once)
+					timeout = 10;
+
+				pollfd fds[] = { { m_wakeRead, POLLIN, 0 }, { m_inotify, POLLIN, 0 } };
+				if (poll(fds, 2, (std::max)(timeout, -1)) < 0)
+				{
+					if (errno == EINTR)
+						continue;
+					break;
+				}
+				if (fds[0].revents & POLLIN)
+				{
+					char drain[64];
+					while (read(m_wakeRead, drain, sizeof(drain)) > 0)
+					{
+					}
+				}
+				if (fds[1].revents & POLLIN)
+					ReadEvents(events, sizeof(events));
+			}
+		}
+
+		// Safe from a signal handler
+		void Stop()
+		{
+			m_stopping.store(true, std::memory_order_release);
+			char byte = 1;
+			ssize_t ignored = write(m_wakeWrite, &byte, 1);
+			(void)ignored;
+		}
+
+		// Finishes what's queued (or, after Stop, drops it for the next run) and joins the workers
+		void Shutdown()
+		{
+			m_decodeQueue.Close();
+			Join(m_decodeWorkers);
+			m_ocrQueue.Close();
+			Join(m_ocrWorkers);
+			m_analyzeQueue.Close();
+			Join(m_analyzeWorkers);
+			if (m_history)
+				m_history->Close();
+
+			for (int* fd : { &m_inotify, &m_wakeRead, &m_wakeWrite })
+			{
+				if (*fd >= 0)
+					close(*fd);
+				*fd = -1;
+			}
+		}
+
+		const Statistics& Stats() const { return m_statistics; }
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct Pending
+		{
+			Clock::time_point Deadline;
+		};
+
+		struct Item
+		{
+			std::filesystem::path Path;
+			timespec Modified{};    // Of the input as it was read; the result gets it
+			std::string Bytes;
+			std::wstring Text;      // Set by OCR
+			std::string Error;      // Set by any stage; the result is just the error
+		};
+
+		// Editors' and downloaders' temporary files, hidden files and our own results
+		static bool IsCandidate(std::string_view name)
+		{
+			if (name.empty() || name[0] == '.' || name.back() == '~')
+				return false;
+			for (std::string_view suffix : { ".result.json", ".tmp", ".part", ".partial", ".crdownload", ".swp" })
+			{
+				if (name.ends_with(suffix))
+					return false;
+			}
+			return true;
+		}
+
+		std::filesystem::path ResultPath(const std::filesystem::path& input) const
+		{
+			std::filesystem::path result = m_options.ResultsDirectory.empty()
+				? input.parent_path() : std::filesystem::path(m_options.ResultsDirectory);
+			return result / (input.filename().string() + ".result.json");
+		}
+
+		// Whether there's a result with the input's mtime; missing, empty and non-regular
+		// inputs count as done, there's nothing to do for them
+		bool Done(const std::filesystem::path& input) const
+		{
+			struct stat inputStat, resultStat;
+			if (stat(input.c_str(), &inputStat) != 0 || !S_ISREG(inputStat.st_mode) || inputStat.st_size == 0)
+				return true;
+			return stat(ResultPath(input).c_str(), &resultStat) == 0 &&
+				resultStat.st_mtim.tv_sec == inputStat.st_mtim.tv_sec && resultStat.st_mtim.tv_nsec == inputStat.st_mtim.tv_nsec;
+		}
+
+		void CatchUp()
+		{
+			for (const std::string& directory : m_options.Directories)
+			{
+				std::error_code error;
+				for (std::filesystem::directory_iterator entry(directory, error), end; !error && entry != end; entry.increment(error))
+				{
+					if (IsCandidate(entry->path().filename().string()))
+						m_ready.push_back(entry->path());
+				}
+			}
+		}
+
+		void ReadEvents(char* buffer, size_t size)
+		{
+			auto now = Clock::now();
+			for (;;)
+			{
+				ssize_t length = read(m_inotify, buffer, size);
+				if (length <= 0)
+					return;
+
+				for (char* at = buffer; at < buffer + length;)
+				{
+					const auto* event = reinterpret_cast<const inotify_event*>(at);
+					at += sizeof(inotify_event) + event->len;
+
+					// Events were lost: the directories tell what's left to do
+					if (event->mask & IN_Q_OVERFLOW)
+					{
+						m_statistics.Overflows.fetch_add(1, std::memory_order_relaxed);
+						CatchUp();
+						continue;
+					}
+					auto watch = m_watches.find(event->wd);
+					if (event->len == 0 || (event->mask & IN_ISDIR) || watch == m_watches.end() || !IsCandidate(event->name))
+						continue;
+
+					std::filesystem::path path = std::filesystem::path(watch->second) / event->name;
+					if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+					{
+						m_pending.erase(path.native());
+						continue;
+					}
+					bool written = event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO);
+					Clock::time_point deadline = now + (written ? m_options.Settle : m_options.Quiet);
+					m_pending[path.native()].Deadline = deadline;
+					m_nextDeadline = (std::min)(m_nextDeadline, deadline);
+				}
+			}
+		}
+
+		// Settled files join the ready list; ready files go into the first queue while it has room
+		void Dispatch(Clock::time_point now)
+		{
+			if (now >= m_nextDeadline)
+			{
+				m_nextDeadline = Clock::time_point::max();
+				for (auto it = m_pending.begin(); it != m_pending.end();)
+				{
+					if (it->second.Deadline <= now)
+					{
+						m_ready.push_back(it->first);
+						it = m_pending.erase(it);
+						continue;
+					}
+					m_nextDeadline = (std::min)(m_nextDeadline, it->second.Deadline);
+					++it;
+				}
+			}
+
+			while (!m_ready.empty())
+			{
+				std::filesystem::path& path = m_ready.front();
+				if (IsInFlight(path))
+				{
+					// Rewritten while its previous version is still going through: look again later
+					Clock::time_point deadline = now + m_options.Settle;
+					m_pending[path.native()].Deadline = deadline;
+					m_nextDeadline = (std::min)(m_nextDeadline, deadline);
+				}
+				else if (Done(path))
+				{
+					m_statistics.AlreadyDone.fetch_add(1, std::memory_order_relaxed);
+				}
+				else
+				{
+					SetInFlight(path, true);
+					Item item;
+					item.Path = path;
+					if (!m_decodeQueue.Push(std::move(item)))
+					{
+						SetInFlight(path, false);
+						return;
+					}
+				}
+				m_ready.pop_front();
+			}
+		}
+
+		void DecodeLoop()
+		{
+			std::vector<Item> batch;
+			while (m_decodeQueue.PopBatch(batch, 16, std::chrono::microseconds(0)))
+			{
+				for (Item& item : batch)
+				{
+					if (m_stopping.load(std::memory_order_relaxed))
+					{
+						SetInFlight(item.Path, false);
+						continue;
+					}
+					bool image = false;
+					if (!Read(item) || (image = IsImage(item.Bytes)) == false)
+					{
+						m_analyzeQueue.PushWait(std::move(item));
+					}
+					else if (!m_ocr)
+					{
+						m_statistics.Deferred.fetch_add(1, std::memory_order_relaxed);
+						SetInFlight(item.Path, false);
+					}
+					else
+					{
+						m_ocrQueue.PushWait(std::move(item));
+					}
+				}
+			}
+		}
+
+		void OcrLoop()
+		{
+			std::vector<Item> batch;
+			while (m_ocrQueue.PopBatch(batch, 1, std::chrono::microseconds(0)))
+			{
+				Item& item = batch.front();
+				if (m_stopping.load(std::memory_order_relaxed))
+				{
+					SetInFlight(item.Path, false);
+					continue;
+				}
+				if (!m_ocr->Recognize(item.Path, item.Bytes, item.Text, item.Error) && item.Error.empty())
+					item.Error = "OCR failed";
+				m_analyzeQueue.PushWait(std::move(item));
+			}
+		}
+
+		void AnalyzeLoop()
+		{
+			std::vector<Item> batch;
+			AnalysisHistory::Batch records;
+			while (m_analyzeQueue.PopBatch(batch, 32, std::chrono::microseconds(0)))
+			{
+				for (Item& item : batch)
+				{
+					std::string json;
+					try
+					{
+						if (item.Error.empty())
+							json = Analyze(item, m_history ? &records : nullptr);
+					}
+					catch (const std::exception& e)
+					{
+						item.Error = e.what();
+					}
+					if (!item.Error.empty())
+					{
+						json = "{\"file\":";
+						AnalysisJson::AppendString(json, Utf8::Decode(item.Path.string()));
+						json += ",\"error\":";
+						AnalysisJson::AppendString(json, Utf8::Decode(item.Error));
+						json += '}';
+					}
+
+					if (WriteResult(item, json))
+						(item.Error.empty() ? m_statistics.Analyzed : m_statistics.Failed).fetch_add(1, std::memory_order_relaxed);
+					SetInFlight(item.Path, false);
+				}
+				if (m_history)
+					m_statistics.HistoryDropped.fetch_add(m_history->AppendOrDrop(records), std::memory_order_relaxed);
+			}
+		}
+
+		// The file's bytes and mtime; false with the error set when it can't be used
+		bool Read(Item& item) const
+		{
+			int fd = open(item.Path.c_str(), O_RDONLY | O_CLOEXEC);
+			struct stat status;
+			if (fd < 0 || fstat(fd, &status) != 0)
+			{
+				item.Error = std::strerror(errno);
+				if (fd >= 0)
+					close(fd);
+				return false;
+			}
+			item.Modified = status.st_mtim;
+			if (static_cast<uint64_t>(status.st_size) > m_options.MaxFileBytes)
+			{
+				close(fd);
+				item.Error = "file too large";
+				return false;
+			}
+
+			item.Bytes.resize(static_cast<size_t>(status.st_size));
+			size_t done = 0;
+			while (done < item.Bytes.size())
+			{
+				ssize_t length = read(fd, item.Bytes.data() + done, item.Bytes.size() - done);
+				if (length < 0 && errno == EINTR)
+					continue;
+				if (length <= 0)
+					break;
+				done += static_cast<size_t>(length);
+			}
+			close(fd);
+			item.Bytes.resize(done);
+
+			if (!IsImage(item.Bytes) && item.Bytes.find('\0') != std::string::npos && !IsUtf16(item.Bytes))
+			{
+				item.Error = "neither an image nor text";
+				return false;
+			}
+			return true;
+		}
+
+		static bool IsImage(std::string_view bytes)
+		{
+			using namespace std::string_view_literals;
+			for (std::string_view magic : { "\x89PNG"sv, "\xFF\xD8\xFF"sv, "GIF8"sv, "II*\0"sv, "MM\0*"sv })
+			{
+				if (bytes.starts_with(magic))
+					return true;
+			}
+			return (bytes.size() > 10 && bytes.starts_with("BM") && bytes.substr(6, 4) == "\0\0\0\0"sv) ||
+				(bytes.size() > 12 && bytes.starts_with("RIFF") && bytes.substr(8, 4) == "WEBP");
+		}
+
+		static bool IsUtf16(std::string_view bytes)
+		{
+			return bytes.starts_with("\xFF\xFE") || bytes.starts_with("\xFE\xFF");
+		}
+
+		// UTF-8, with or without a BOM, or UTF-16 with its BOM, as Notepad and PowerShell write
+		static std::wstring DecodeText(std::string_view bytes)
+		{
+			if (!IsUtf16(bytes))
+				return Utf8::Decode(bytes.starts_with("\xEF\xBB\xBF") ? bytes.substr(3) : bytes);
+
+			bool bigEndian = bytes[0] == '\xFE';
+			std::wstring text;
+			text.reserve(bytes.size() / 2);
+			for (size_t i = 2; i + 1 < bytes.size(); i += 2)
+			{
+				auto high = static_cast<uint8_t>(bytes[i + (bigEndian ? 0 : 1)]);
+				auto low = static_cast<uint8_t>(bytes[i + (bigEndian ? 1 : 0)]);
+				uint32_t unit = (static_cast<uint32_t>(high) << 8) | low;
+				// Surrogate pairs become one character where wchar_t has room for it
+				if constexpr (sizeof(wchar_t) == 4)
+				{
+					if (unit >= 0xDC00 && unit < 0xE000 && !text.empty() && text.back() >= 0xD800 && text.back() < 0xDC00)
+					{
+						text.back() = static_cast<wchar_t>(0x10000 + ((static_cast<uint32_t>(text.back()) - 0xD800) << 10) + (unit - 0xDC00));
+						continue;
+					}
+				}
+				text += static_cast<wchar_t>(unit);
+			}
+			return text;
+		}
+
+		// A system_profiler or sw_vers export rather than an OCR page
+		static bool IsMacReport(std::string_view bytes, SystemProfilerParser::Format format)
+		{
+			return format == SystemProfilerParser::Format::Json || format == SystemProfilerParser::Format::Plist ||
+				(format == SystemProfilerParser::Format::Text &&
+					(bytes.find("Hardware Overview:") != std::string_view::npos || bytes.find("ProductVersion:") != std::string_view::npos));
+		}
+
+		std::string Analyze(Item& item, AnalysisHistory::Batch* history) const
+		{
+			std::string json;
+			if (m_options.Platform == TargetPlatform::macOS)
+			{
+				MacOSAnalysis analysis;
+				if (!item.Text.empty())
+				{
+					analysis = AnalysisPipeline::AnalyzeMacOSText(item.Text);
+				}
+				else if (!IsUtf16(item.Bytes) && IsMacReport(item.Bytes, SystemProfilerParser::Parse(item.Bytes, analysis.Info)))
+				{
+					analysis.Results = MacOSHardwareAnalyzerService::AnalyzeMacOSHardware(analysis.Info);
+					analysis.Score = MacOSHardwareAnalyzerService::CalculateGlobalScore(analysis.Results);
+				}
+				else
+				{
+					analysis = AnalysisPipeline::AnalyzeMacOSText(DecodeText(item.Bytes));
+				}
+				json = AnalysisJson::ToJson(analysis);
+				if (history)
+					history->Add(analysis, AnalysisHistory::Now());
+			}
+			else
+			{
+				WindowsAnalysis analysis;
+				DiagnosticsReportParser report;
+				if (item.Text.empty())
+				{
+					report.Feed(item.Bytes);
+					analysis.Info = report.Finish();
+				}
+				if (item.Text.empty() && report.DetectedFormat() != DiagnosticsReportParser::Format::Unknown)
+				{
+					analysis.Results = HardwareAnalyzerService::AnalyzeHardware(analysis.Info);
+					analysis.Score = HardwareAnalyzerService::CalculateGlobalScore(analysis.Results);
+				}
+				else
+				{
+					analysis = AnalysisPipeline::AnalyzeWindowsText(item.Text.empty() ? DecodeText(item.Bytes) : item.Text);
+				}
+				json = AnalysisJson::ToJson(analysis);
+				if (history)
+					history->Add(analysis, AnalysisHistory::Now());
+			}
+
+			json.pop_back();
+			json += ",\"file\":";
+			AnalysisJson::AppendString(json, Utf8::Decode(item.Path.string()));
+			json += '}';
+			return json;
+		}
+
+		// Temporary file, synced, mtime set to the input's, renamed over the result
+		bool WriteResult(const Item& item, const std::string& json) const
+		{
+			std::filesystem::path result = ResultPath(item.Path);
+			std::filesystem::path temporary = result.parent_path() / ("." + result.filename().string() + ".tmp");
+			int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+			if (fd < 0)
+				return false;
+
+			bool written = true;
+			for (size_t done = 0; written && done < json.size();)
+			{
+				ssize_t length = write(fd, json.data() + done, json.size() - done);
+				if (length < 0 && errno == EINTR)
+					continue;
+				written = length > 0;
+				done += written ? static_cast<size_t>(length) : 0;
+			}
+			// An input that couldn't even be opened has no mtime to carry: its result is
+			// never "done" and it's tried again at the next start
+			timespec times[2] = { { 0, UTIME_NOW }, item.Modified };
+			written = written && futimens(fd, times) == 0 && fdatasync(fd) == 0;
+			written = close(fd) == 0 && written;
+			if (written && std::rename(temporary.c_str(), result.c_str()) == 0)
+				return true;
+			unlink(temporary.c_str());
+			return false;
+		}
+
+		bool IsInFlight(const std::filesystem::path& path)
+		{
+			std::lock_guard<std::mutex> lock(m_inFlightLock);
+			return m_inFlight.count(path.native()) > 0;
+		}
+
+		void SetInFlight(const std::filesystem::path& path, bool inFlight)
+		{
+			std::lock_guard<std::mutex> lock(m_inFlightLock);
+			if (inFlight)
+				m_inFlight.insert(path.native());
+			else
+				m_inFlight.erase(path.native());
+		}
+
+		size_t InFlight()
+		{
+			std::lock_guard<std::mutex> lock(m_inFlightLock);
+			return m_inFlight.size();
+		}
+
+		static void Join(std::vector<std::thread>& threads)
+		{
+			for (auto& thread : threads)
+			{
+				thread.join();
+			}
+			threads.clear();
+		}
+
+		Options m_options;
+		std::unique_ptr<IImageOcrBackend> m_ocr;
+		std::unique_ptr<AnalysisHistory> m_history;
+		Statistics m_statistics;
+		std::atomic<bool> m_stopping{ false };
+		int m_inotify = -1;
+		int m_wakeRead = -1;
+		int m_wakeWrite = -1;
+
+		// Event thread only
+		std::unordered_map<int, std::string> m_watches;
+		std::unordered_map<std::string, Pending> m_pending;
+		Clock::time_point m_nextDeadline = Clock::time_point::max();
+		std::deque<std::filesystem::path> m_ready;
+
+		std::mutex m_inFlightLock;
+		std::unordered_set<std::string> m_inFlight;    // Queued or being processed
+
+		BatchQueue<Item> m_decodeQueue;
+		BatchQueue<Item> m_ocrQueue;
+		BatchQueue<Item> m_analyzeQueue;
+		std::vector<std::thread> m_decodeWorkers;
+		std::vector<std::thread> m_ocrWorkers;
+		std::vector<std::thread> m_analyzeWorkers;
+	};
+}
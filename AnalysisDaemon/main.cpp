@@ -0,0 +1,965 @@
+// hardware-analyzerd: the portable analysis engine as a local service, plus a load generator.
+// Builds on Linux and macOS without the WinUI project:
+//   c++ -std=c++20 -O2 -pthread -I../HardwareAnalyzer -I. main.cpp -o hardware-analyzerd
+//
+//   hardware-analyzerd serve [--socket PATH | --port N] [--workers N] [--batch N]
+//                            [--batch-window-us N] [--queue N] [--arena-kb N] [--labels DIR]
+//                            [--history DIR] [--fleet-rows N]
+//   hardware-analyzerd load  [--socket PATH | --port N] [--connections N] [--seconds N]
+//                            [--macos] FILE | --corpus N [--seed N]
+//   hardware-analyzerd probe [--root DIR --machine NAME]
+//   hardware-analyzerd report [--macos] [--profiles FILE] [--repeat N] FILE...
+//   hardware-analyzerd corpus [--count N] [--first N] [--seed N] [--macos-share P] [--languages en,fr,...]
+//                             [--noise P | --confusions P --merged-lines P --dropped-labels P]
+//                             [--check [--threads N]]
+//   hardware-analyzerd gate [--min-score N] FILE... | --corpus N [--seed N] [--noise P] [--full]
+//   hardware-analyzerd watch [--macos] [--results DIR] [--history DIR] [--ocr-command "tesseract {} stdout"]
+//                            [--settle-ms N] [--ocr-workers N] [--workers N] [--queue N] [--once] DIR...
+//   hardware-analyzerd serialize [--format json|csv|binary] [--count N] [--repeat N] [--macos] [--output FILE]
+//   hardware-analyzerd batch [--workers N] [--chunk-kb N] [--format json|csv|binary] [--macos] [--shards DIR]
+//                            [--summary] --output FILE INPUT
+//   (batch runs "hardware-analyzerd batch-worker ..." in each worker process)
+//   hardware-analyzerd labels [--data-version N] --output FILE.halp SOURCE...
+//
+//   curl --unix-socket /tmp/hardware-analyzer.sock --data-binary @about.txt http://localhost/v1/windows
+//   curl --unix-socket /tmp/hardware-analyzer.sock http://localhost/metrics
+//   curl --unix-socket /tmp/hardware-analyzer.sock http://localhost/v1/stats
+//   curl --unix-socket /tmp/hardware-analyzer.sock http://localhost/v1/fleet
+//   curl --unix-socket /tmp/hardware-analyzer.sock --data 'ram < 8 and score < 55' http://localhost/v1/query
+
+#include "pch.h"
+#include "AnalysisJson.h"
+#include "AnalysisServer.h"
+#include "DiagnosticsReportParser.h"
+#include "FleetResultStore.h"
+#include "LabelPack.h"
+#include "LabelSource.h"
+#include "LazyHardwareInfo.h"
+#include "LinuxHardwareProbe.h"
+#include "LoadGenerator.h"
+#include "RequirementProfiles.h"
+#include "ResultSerializer.h"
+#include "ShardedBatch.h"
+#include "SyntheticCorpus.h"
+#include "SystemProfilerParser.h"
+#include "WatchFolder.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace HardwareAnalyzer;
+
+namespace
+{
+	constexpr const char* DefaultSocketPath = "/tmp/hardware-analyzer.sock";
+
+	AnalysisServer* g_server = nullptr;
+	WatchFolder* g_watchFolder = nullptr;
+
+	void OnTerminate(int)
+	{
+		if (g_server)
+			g_server->Stop();
+		if (g_watchFolder)
+			g_watchFolder->Stop();
+	}
+
+	// "--name value" pairs after the command; bare arguments are collected in order
+	class Arguments
+	{
+	public:
+		Arguments(int argc, char** argv)
+		{
+			for (int i = 2; i < argc; i++)
+			{
+				std::string_view argument = argv[i];
+				if (argument.substr(0, 2) != "--")
+					m_positional.emplace_back(argument);
+				else if (argument == "--macos" || argument == "--check" || argument == "--full" || argument == "--once" || argument == "--summary")
+					m_flags.emplace_back(argument);
+				else if (i + 1 < argc)
+					m_named.emplace_back(argument, argv[++i]);
+				else
+					m_valid = false;
+			}
+		}
+
+		bool Valid() const { return m_valid; }
+		bool Flag(std::string_view name) const { return std::find(m_flags.begin(), m_flags.end(), name) != m_flags.end(); }
+		const std::vector<std::string>& Positional() const { return m_positional; }
+
+		std::string Text(std::string_view name, std::string fallback) const
+		{
+			for (const auto& [key, value] : m_named)
+			{
+				if (key == name)
+					return value;
+			}
+			return fallback;
+		}
+
+		unsigned long Number(std::string_view name, unsigned long fallback) const
+		{
+			std::string text = Text(name, {});
+			return text.empty() ? fallback : std::strtoul(text.c_str(), nullptr, 10);
+		}
+
+		double Fraction(std::string_view name, double fallback) const
+		{
+			std::string text = Text(name, {});
+			return text.empty() ? fallback : std::strtod(text.c_str(), nullptr);
+		}
+
+	private:
+		std::vector<std::pair<std::string, std::string>> m_named;
+		std::vector<std::string> m_flags;
+		std::vector<std::string> m_positional;
+		bool m_valid = true;
+	};
+
+	int Serve(const Arguments& arguments)
+	{
+		AnalysisServer::Options options;
+		options.Port = static_cast<uint16_t>(arguments.Number("--port", 0));
+		options.SocketPath = arguments.Text("--socket", DefaultSocketPath);
+		options.Workers = static_cast<unsigned>(arguments.Number("--workers", options.Workers));
+		options.MaxBatch = arguments.Number("--batch", options.MaxBatch);
+		options.BatchWindow = std::chrono::microseconds(arguments.Number("--batch-window-us", static_cast<unsigned long>(options.BatchWindow.count())));
+		options.QueueCapacity = arguments.Number("--queue", options.QueueCapacity);
+		options.ArenaBytes = arguments.Number("--arena-kb", static_cast<unsigned long>(options.ArenaBytes / 1024)) * 1024;
+		options.HistoryDirectory = arguments.Text("--history", {});
+		options.FleetRows = arguments.Number("--fleet-rows", static_cast<unsigned long>(options.FleetRows));
+
+		std::string labels = arguments.Text("--labels", {});
+		if (!labels.empty())
+			LabelPack::SetActive(LabelPack::LoadDirectory(labels));
+
+		AnalysisServer server(options);
+		std::string error;
+		if (!server.Start(error))
+		{
+			std::fprintf(stderr, "hardware-analyzerd: %s\n", error.c_str());
+			return 1;
+		}
+
+		g_server = &server;
+		std::signal(SIGINT, OnTerminate);
+		std::signal(SIGTERM, OnTerminate);
+		std::signal(SIGPIPE, SIG_IGN);
+
+		std::fprintf(stderr, "hardware-analyzerd: listening on %s, %u workers\n",
+			options.Port != 0 ? ("127.0.0.1:" + std::to_string(options.Port)).c_str() : options.SocketPath.c_str(), options.Workers);
+		server.Run();
+		g_server = nullptr;
+		return 0;
+	}
+
+	// Options of the synthetic corpus from --seed, --macos-share, --languages and the noise rates
+	SyntheticCorpus::Options CorpusOptions(const Arguments& arguments)
+	{
+		SyntheticCorpus::Options options;
+		options.Seed = arguments.Number("--seed", 1);
+		options.MacOSShare = arguments.Fraction("--macos-share", options.MacOSShare);
+		double noise = arguments.Fraction("--noise", 0);
+		options.ConfusionRate = arguments.Fraction("--confusions", noise / 20);
+		options.MergedLineRate = arguments.Fraction("--merged-lines", noise);
+		options.DroppedLabelRate = arguments.Fraction("--dropped-labels", noise);
+
+		std::string languages = arguments.Text("--languages", {});
+		for (size_t start = 0; start < languages.size();)
+		{
+			size_t comma = (std::min)(languages.find(',', start), languages.size());
+			options.Languages.emplace_back(languages.begin() + start, languages.begin() + comma);
+			start = comma + 1;
+		}
+		return options;
+	}
+
+	int Load(const Arguments& arguments)
+	{
+		LoadGenerator::Options options;
+		unsigned long corpus = arguments.Number("--corpus", 0);
+		if (corpus > 0)
+		{
+			// Distinct pages of the target platform, sent in turn
+			SyntheticCorpus::Options corpusOptions = CorpusOptions(arguments);
+			corpusOptions.MacOSShare = arguments.Flag("--macos") ? 1 : 0;
+			SyntheticCorpus generator(corpusOptions);
+			SyntheticCorpus::Document document;
+			for (unsigned long index = 0; index < corpus; index++)
+			{
+				generator.Generate(index, document);
+				options.Bodies.push_back(Utf8::Encode(document.Text));
+			}
+		}
+		else
+		{
+			if (arguments.Positional().size() != 1)
+			{
+				std::fprintf(stderr, "hardware-analyzerd load: expected one OCR text file or --corpus N\n");
+				return 2;
+			}
+			std::ifstream file(arguments.Positional()[0], std::ios::binary);
+			if (!file)
+			{
+				std::fprintf(stderr, "hardware-analyzerd load: can't read %s\n", arguments.Positional()[0].c_str());
+				return 1;
+			}
+			options.Body.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		}
+
+		options.Port = static_cast<uint16_t>(arguments.Number("--port", 0));
+		options.SocketPath = arguments.Text("--socket", DefaultSocketPath);
+		options.Connections = static_cast<unsigned>(arguments.Number("--connections", options.Connections));
+		options.Duration = std::chrono::seconds(arguments.Number("--seconds", static_cast<unsigned long>(options.Duration.count())));
+		options.Target = arguments.Flag("--macos") ? "/v1/macos" : "/v1/windows";
+		std::signal(SIGPIPE, SIG_IGN);
+
+		LoadGenerator::Report report;
+		LoadGenerator::Run(options, report);
+		std::printf("%llu ok, %llu failed, %llu connection errors in %.1f s: %.0f req/s\n",
+			static_cast<unsigned long long>(report.Succeeded), static_cast<unsigned long long>(report.Failed),
+			static_cast<unsigned long long>(report.ConnectionErrors), report.Seconds, report.RequestsPerSecond());
+		std::printf("latency (bucket upper bounds): p50 %llu us, p90 %llu us, p99 %llu us, p99.9 %llu us\n",
+			static_cast<unsigned long long>(report.Latency.QuantileUs(0.5)), static_cast<unsigned long long>(report.Latency.QuantileUs(0.9)),
+			static_cast<unsigned long long>(report.Latency.QuantileUs(0.99)), static_cast<unsigned long long>(report.Latency.QuantileUs(0.999)));
+		return report.Failed == 0 && report.ConnectionErrors == 0 ? 0 : 1;
+	}
+
+	// Analyzes this machine from procfs and sysfs, no screenshot, and prints the JSON. --root
+	// and --machine read a captured tree (or a container's view of its host) instead.
+	int Probe(const Arguments& arguments)
+	{
+		std::string root = arguments.Text("--root", {});
+		WindowsAnalysis analysis;
+		if (!root.empty())
+		{
+			analysis.Info = LinuxHardwareProbe::Probe(root, arguments.Text("--machine", "x86_64"));
+		}
+		else
+		{
+#if defined(__linux__)
+			analysis.Info = LinuxHardwareProbe::Probe();
+#else
+			std::fprintf(stderr, "hardware-analyzerd probe: only Linux can be probed, use --root\n");
+			return 2;
+#endif
+		}
+		analysis.Results = HardwareAnalyzerService::AnalyzeHardware(analysis.Info);
+		analysis.Score = HardwareAnalyzerService::CalculateGlobalScore(analysis.Results);
+		std::printf("%s\n", AnalysisJson::ToJson(analysis).c_str());
+		return 0;
+	}
+
+	// The analysis as one JSON line, plus "profiles":[{"name":...,"score":...,"status":{...}}]
+	// with its score and check statuses under each requirement profile when there are any
+	template <typename Analysis>
+	void PrintAnalysis(const Analysis& analysis, const RequirementProfileTable& profiles)
+	{
+		std::string json = AnalysisJson::ToJson(analysis);
+		if (profiles.Size() > 0)
+		{
+			ProfileEvaluation evaluation = profiles.Evaluate(analysis);
+			json.pop_back();
+			json += ",\"profiles\":[";
+			for (size_t profile = 0; profile < profiles.Size(); profile++)
+			{
+				json += profile > 0 ? ",{\"name\":" : "{\"name\":";
+				AnalysisJson::AppendString(json, profiles.Name(profile));
+				json += ",\"score\":";
+				AnalysisJson::AppendNumber(json, static_cast<int>(evaluation.Scores[profile]));
+				json += ",\"status\":{";
+				bool first = true;
+				for (size_t kind = 0; kind < RequirementInputs::KindCount; kind++)
+				{
+					uint8_t status = evaluation.Status[kind][profile];
+					if (status == RequirementInputs::NotApplicable)
+						continue;
+					json += first ? "\"" : ",\"";
+					json += ResultCodes::CheckNames[kind];
+					json += "\":\"";
+					json += AnalysisJson::StatusName(static_cast<StatusLevel>(status));
+					json += '"';
+					first = false;
+				}
+				json += "}}";
+			}
+			json += "]}";
+		}
+		std::printf("%s\n", json.c_str());
+	}
+
+	// system_profiler and sw_vers output, one JSON line per Mac: an MDM export holds many
+	int MacReport(const Arguments& arguments, const RequirementProfileTable& profiles, unsigned long repeat)
+	{
+		int status = 0;
+		for (const std::string& path : arguments.Positional())
+		{
+			size_t macs = SystemProfilerParser::ForEachMacInFile(path, [&](const MacOSHardwareInfo& info) {
+				MacOSAnalysis analysis;
+				analysis.Info = info;
+				analysis.Results = MacOSHardwareAnalyzerService::AnalyzeMacOSHardware(analysis.Info);
+				analysis.Score = MacOSHardwareAnalyzerService::CalculateGlobalScore(analysis.Results);
+				PrintAnalysis(analysis, profiles);
+			});
+			if (macs == 0)
+			{
+				std::fprintf(stderr, "hardware-analyzerd report: %s holds no system_profiler or sw_vers output\n", path.c_str());
+				status = 1;
+				continue;
+			}
+
+			if (repeat == 0)
+				continue;
+			std::error_code error;
+			uintmax_t bytes = std::filesystem::file_size(path, error);
+			auto start = std::chrono::steady_clock::now();
+			for (unsigned long i = 0; i < repeat; i++)
+			{
+				SystemProfilerParser::ForEachMacInFile(path, [](const MacOSHardwareInfo&) {});
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::fprintf(stderr, "%s: %lu parses of %zu Macs in %.3f s, %.0f MB/s, %.0f Macs/s\n", path.c_str(), repeat, macs, seconds,
+				error ? 0.0 : static_cast<double>(bytes) * repeat / seconds / (1024 * 1024), static_cast<double>(macs) * repeat / seconds);
+		}
+		return status;
+	}
+
+	// Analyzes dxdiag and msinfo32 exports and prints one JSON line per file; --macos reads
+	// system_profiler output instead. --profiles adds the results under each requirement
+	// profile of the file (see RequirementProfileTable::Parse). --repeat parses each file
+	// that many more times and reports the parse throughput on stderr.
+	int Report(const Arguments& arguments)
+	{
+		if (arguments.Positional().empty())
+		{
+			std::fprintf(stderr, "hardware-analyzerd report: expected dxdiag, msinfo32 or system_profiler files\n");
+			return 2;
+		}
+
+		RequirementProfileTable profiles;
+		std::string profilesPath = arguments.Text("--profiles", {});
+		if (!profilesPath.empty())
+		{
+			std::ifstream file(profilesPath, std::ios::binary);
+			std::string text(std::istreambuf_iterator<char>(file), {});
+			std::string error = "can't read the file";
+			if (!file || !profiles.Parse(text, error))
+			{
+				std::fprintf(stderr, "hardware-analyzerd report: %s: %s\n", profilesPath.c_str(), error.c_str());
+				return 2;
+			}
+		}
+
+		unsigned long repeat = arguments.Number("--repeat", 0);
+		if (arguments.Flag("--macos"))
+			return MacReport(arguments, profiles, repeat);
+
+		int status = 0;
+		for (const std::string& path : arguments.Positional())
+		{
+			WindowsAnalysis analysis;
+			if (!DiagnosticsReportParser::ParseFile(path, analysis.Info))
+			{
+				std::fprintf(stderr, "hardware-analyzerd report: %s isn't a readable dxdiag or msinfo32 report\n", path.c_str());
+				status = 1;
+				continue;
+			}
+			analysis.Results = HardwareAnalyzerService::AnalyzeHardware(analysis.Info);
+			analysis.Score = HardwareAnalyzerService::CalculateGlobalScore(analysis.Results);
+			PrintAnalysis(analysis, profiles);
+
+			if (repeat == 0)
+				continue;
+			std::error_code error;
+			uintmax_t bytes = std::filesystem::file_size(path, error);
+			auto start = std::chrono::steady_clock::now();
+			for (unsigned long i = 0; i < repeat; i++)
+			{
+				HardwareInfo info;
+				DiagnosticsReportParser::ParseFile(path, info);
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::fprintf(stderr, "%s: %lu parses in %.3f s, %.0f MB/s\n", path.c_str(), repeat, seconds,
+				error ? 0.0 : static_cast<double>(bytes) * repeat / seconds / (1024 * 1024));
+		}
+		return status;
+	}
+
+	// Per-field mismatch counts of one platform in a --check run
+	struct CorpusTally
+	{
+		uint64_t Documents = 0;
+		uint64_t Exact = 0;
+		std::array<uint64_t, SyntheticCorpus::FieldCount> Mismatches{};
+
+		void Add(uint32_t fields)
+		{
+			Documents++;
+			Exact += fields == 0;
+			for (size_t field = 0; field < SyntheticCorpus::FieldCount; field++)
+				Mismatches[field] += (fields >> field) & 1;
+		}
+
+		void Merge(const CorpusTally& other)
+		{
+			Documents += other.Documents;
+			Exact += other.Exact;
+			for (size_t field = 0; field < SyntheticCorpus::FieldCount; field++)
+				Mismatches[field] += other.Mismatches[field];
+		}
+
+		void Print(const char* platform, uint32_t fields) const
+		{
+			std::printf("%s: %llu documents, %.2f%% read exactly;", platform, static_cast<unsigned long long>(Documents),
+				Documents ? 100.0 * Exact / Documents : 0.0);
+			for (size_t field = 0; field < SyntheticCorpus::FieldCount; field++)
+			{
+				if ((fields >> field) & 1)
+				{
+					std::printf(" %s %.2f%%", SyntheticCorpus::FieldNames[field],
+						Documents ? 100.0 * (Documents - Mismatches[field]) / Documents : 0.0);
+				}
+			}
+			std::printf("\n");
+		}
+	};
+
+	// Writes synthetic OCR pages as JSON lines, {"index":...,"platform":...,"language":...,
+	// "text":...,"truth":{...}}, with the truth in the "info" form of the analysis JSON.
+	// --noise P sets the merged-line and dropped-label rates to P and the character
+	// confusion rate to P/20. --check parses the pages on --threads threads instead, the
+	// way the server's workers do, and prints the throughput and how often each field was
+	// read right.
+	int Corpus(const Arguments& arguments)
+	{
+		SyntheticCorpus generator(CorpusOptions(arguments));
+		uint64_t first = arguments.Number("--first", 0);
+		uint64_t count = arguments.Number("--count", 1000);
+		auto start = std::chrono::steady_clock::now();
+
+		if (!arguments.Flag("--check"))
+		{
+			static char outputBuffer[1 << 20];
+			std::setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+			SyntheticCorpus::Document document;
+			std::string json;
+			uint64_t bytes = 0;
+			for (uint64_t index = first; index < first + count; index++)
+			{
+				generator.Generate(index, document);
+				bool macOS = document.Platform == TargetPlatform::macOS;
+				json = "{\"index\":";
+				AnalysisJson::AppendNumber(json, index);
+				json += macOS ? ",\"platform\":\"macos\",\"language\":" : ",\"platform\":\"windows\",\"language\":";
+				AnalysisJson::AppendString(json, document.Language);
+				json += ",\"text\":";
+				AnalysisJson::AppendString(json, document.Text);
+				json += ",\"truth\":";
+				if (macOS)
+					AnalysisJson::AppendInfo(json, document.Mac);
+				else
+					AnalysisJson::AppendInfo(json, document.Windows);
+				json += "}\n";
+				std::fwrite(json.data(), 1, json.size(), stdout);
+				bytes += json.size();
+			}
+			std::fflush(stdout);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::fprintf(stderr, "%llu documents, %.1f MB in %.3f s: %.0f documents/s\n", static_cast<unsigned long long>(count),
+				bytes / (1024.0 * 1024), seconds, count / seconds);
+			return 0;
+		}
+
+		unsigned threads = static_cast<unsigned>(arguments.Number("--threads", (std::max)(std::thread::hardware_concurrency(), 1u)));
+		threads = (std::max)(threads, 1u);
+		std::vector<CorpusTally> windows(threads), macOS(threads);
+		std::vector<uint64_t> characters(threads);
+		std::vector<std::thread> workers;
+		for (unsigned worker = 0; worker < threads; worker++)
+		{
+			workers.emplace_back([&, worker] {
+				std::vector<std::byte> arenaBuffer(64 * 1024);
+				SyntheticCorpus::Document document;
+				for (uint64_t index = first + worker; index < first + count; index += threads)
+				{
+					generator.Generate(index, document);
+					characters[worker] += document.Text.size();
+					std::pmr::monotonic_buffer_resource arena(arenaBuffer.data(), arenaBuffer.size());
+					if (document.Platform == TargetPlatform::macOS)
+					{
+						pmr::MacOSAnalysis analysis = AnalysisPipeline::AnalyzeMacOSText(document.Text, &arena);
+						macOS[worker].Add(SyntheticCorpus::Mismatches(document.Mac, analysis.Info));
+					}
+					else
+					{
+						pmr::WindowsAnalysis analysis = AnalysisPipeline::AnalyzeWindowsText(document.Text, &arena);
+						windows[worker].Add(SyntheticCorpus::Mismatches(document.Windows, analysis.Info));
+					}
+				}
+			});
+		}
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		uint64_t totalCharacters = 0;
+		for (unsigned worker = 1; worker < threads; worker++)
+		{
+			windows[0].Merge(windows[worker]);
+			macOS[0].Merge(macOS[worker]);
+		}
+		for (uint64_t worker : characters)
+			totalCharacters += worker;
+
+		std::printf("%llu documents (%.1f M characters) generated and analyzed on %u threads in %.3f s: %.0f documents/s\n",
+			static_cast<unsigned long long>(count), totalCharacters / 1e6, threads, seconds, count / seconds);
+		windows[0].Print("windows", SyntheticCorpus::DeviceNameField | SyntheticCorpus::ProcessorField |
+			SyntheticCorpus::RamField | SyntheticCorpus::GpuField | SyntheticCorpus::VramField | SyntheticCorpus::SystemTypeField);
+		macOS[0].Print("macos", SyntheticCorpus::DeviceNameField | SyntheticCorpus::DeviceYearField |
+			SyntheticCorpus::ChipField | SyntheticCorpus::MemoryField | SyntheticCorpus::MacOSVersionField);
+		return 0;
+	}
+
+	// Screens Windows OCR text files with the quick gate (neither the architecture nor RAM is
+	// Bad) or, with --min-score, whether the score reaches N, extracting only the fields that
+	// decide it: one "PATH pass" or "PATH fail" line each. --corpus N screens N synthetic pages
+	// instead and prints the throughput; --full also analyzes them in full, checks that both
+	// give the same answer and prints that throughput to compare.
+	int Gate(const Arguments& arguments)
+	{
+		bool scored = !arguments.Text("--min-score", {}).empty();
+		int minimum = static_cast<int>(arguments.Number("--min-score", 0));
+		auto gate = [&](std::wstring_view text, std::pmr::memory_resource* arena) {
+			pmr::LazyHardwareInfo info(text, ParseLimits{}, arena);
+			pmr::ShortCircuitScore score(info);
+			return scored ? score.Reaches(minimum) : score.PassesGate();
+		};
+
+		unsigned long corpus = arguments.Number("--corpus", 0);
+		if (corpus == 0)
+		{
+			if (arguments.Positional().empty())
+			{
+				std::fprintf(stderr, "hardware-analyzerd gate: expected OCR text files or --corpus N\n");
+				return 2;
+			}
+			int status = 0;
+			for (const std::string& path : arguments.Positional())
+			{
+				std::ifstream file(path, std::ios::binary);
+				std::string text(std::istreambuf_iterator<char>(file), {});
+				if (!file)
+				{
+					std::fprintf(stderr, "hardware-analyzerd gate: can't read %s\n", path.c_str());
+					status = 1;
+					continue;
+				}
+				std::pmr::monotonic_buffer_resource arena;
+				std::printf("%s %s\n", path.c_str(), gate(Utf8::Decode(text), &arena) ? "pass" : "fail");
+			}
+			return status;
+		}
+
+		SyntheticCorpus::Options options = CorpusOptions(arguments);
+		options.MacOSShare = 0;
+		SyntheticCorpus generator(options);
+		SyntheticCorpus::Document document;
+		std::vector<std::wstring> pages;
+		for (unsigned long index = 0; index < corpus; index++)
+		{
+			generator.Generate(index, document);
+			pages.push_back(document.Text);
+		}
+
+		std::vector<std::byte> arenaBuffer(64 * 1024);
+		std::vector<bool> passed;
+		auto start = std::chrono::steady_clock::now();
+		for (const std::wstring& page : pages)
+		{
+			std::pmr::monotonic_buffer_resource arena(arenaBuffer.data(), arenaBuffer.size());
+			passed.push_back(gate(page, &arena));
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::printf("gate: %llu of %lu pages pass, %.3f s: %.0f pages/s\n",
+			static_cast<unsigned long long>(std::count(passed.begin(), passed.end(), true)), corpus, seconds, corpus / seconds);
+		if (!arguments.Flag("--full"))
+			return 0;
+
+		uint64_t disagreements = 0;
+		start = std::chrono::steady_clock::now();
+		for (size_t page = 0; page < pages.size(); page++)
+		{
+			std::pmr::monotonic_buffer_resource arena(arenaBuffer.data(), arenaBuffer.size());
+			pmr::WindowsAnalysis analysis = AnalysisPipeline::AnalyzeWindowsText(pages[page], &arena);
+			bool pass = analysis.Score >= minimum;
+			if (!scored)
+			{
+				pass = true;
+				for (const auto& result : analysis.Results)
+				{
+					if ((result.Name == L"Architecture" || result.Name == L"RAM") && result.Status == StatusLevel::Bad)
+						pass = false;
+				}
+			}
+			disagreements += pass != passed[page];
+		}
+		double fullSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::printf("full analysis: %.3f s: %.0f pages/s, %.1fx the gate's time, %llu disagreements\n",
+			fullSeconds, corpus / fullSeconds, fullSeconds / seconds, static_cast<unsigned long long>(disagreements));
+		return disagreements == 0 ? 0 : 1;
+	}
+
+	// Analyzes what lands in the directories (see WatchFolder) until SIGINT or SIGTERM, or
+	// with --once until what they already hold is done
+	int Watch(const Arguments& arguments)
+	{
+		WatchFolder::Options options;
+		options.Directories = arguments.Positional();
+		if (options.Directories.empty())
+		{
+			std::fprintf(stderr, "hardware-analyzerd watch: expected directories to watch\n");
+			return 2;
+		}
+		options.ResultsDirectory = arguments.Text("--results", {});
+		options.HistoryDirectory = arguments.Text("--history", {});
+		options.Platform = arguments.Flag("--macos") ? TargetPlatform::macOS : TargetPlatform::Windows;
+		options.Settle = std::chrono::milliseconds(arguments.Number("--settle-ms", static_cast<unsigned long>(options.Settle.count())));
+		options.OcrWorkers = static_cast<unsigned>(arguments.Number("--ocr-workers", options.OcrWorkers));
+		options.AnalyzeWorkers = static_cast<unsigned>(arguments.Number("--workers", options.AnalyzeWorkers));
+		options.QueueCapacity = arguments.Number("--queue", options.QueueCapacity);
+		options.Once = arguments.Flag("--once");
+
+		std::string command = arguments.Text("--ocr-command", {});
+		std::unique_ptr<IImageOcrBackend> ocr;
+		if (!command.empty())
+			ocr = std::make_unique<CommandOcrBackend>(command);
+
+		WatchFolder watchFolder(options, std::move(ocr));
+		std::string error;
+		if (!watchFolder.Start(error))
+		{
+			std::fprintf(stderr, "hardware-analyzerd watch: %s\n", error.c_str());
+			return 1;
+		}
+
+		g_watchFolder = &watchFolder;
+		std::signal(SIGINT, OnTerminate);
+		std::signal(SIGTERM, OnTerminate);
+		auto start = std::chrono::steady_clock::now();
+		watchFolder.Run();
+		watchFolder.Shutdown();
+		g_watchFolder = nullptr;
+
+		const WatchFolder::Statistics& stats = watchFolder.Stats();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		uint64_t analyzed = stats.Analyzed.load();
+		std::fprintf(stderr, "hardware-analyzerd watch: %llu analyzed (%.0f files/s), %llu failed, %llu already done, %llu images without OCR\n",
+			static_cast<unsigned long long>(analyzed), analyzed / seconds, static_cast<unsigned long long>(stats.Failed.load()),
+			static_cast<unsigned long long>(stats.AlreadyDone.load()), static_cast<unsigned long long>(stats.Deferred.load()));
+		if (uint64_t dropped = stats.HistoryDropped.load())
+			std::fprintf(stderr, "hardware-analyzerd watch: %llu analyses not recorded in the history\n", static_cast<unsigned long long>(dropped));
+		return 0;
+	}
+
+	// The serializer format --format names, json when there's none; false for an unknown name
+	bool FormatOf(const std::string& name, ResultSerializer::Format& format)
+	{
+		if (name == "json")
+			format = ResultSerializer::Format::Json;
+		else if (name == "csv")
+			format = ResultSerializer::Format::Csv;
+		else if (name == "binary")
+			format = ResultSerializer::Format::Binary;
+		else
+			return false;
+		return true;
+	}
+
+	// Writes the analyses --repeat times into one reused buffer and prints the output rate
+	template <typename Analysis>
+	int SerializeAnalyses(const Arguments& arguments, const std::vector<Analysis>& analyses)
+	{
+		std::string name = arguments.Text("--format", "json");
+		ResultSerializer::Format format = ResultSerializer::Format::Json;
+		if (!FormatOf(name, format))
+		{
+			std::fprintf(stderr, "hardware-analyzerd serialize: unknown format %s\n", name.c_str());
+			return 2;
+		}
+
+		OutputBuffer out;
+		std::string path = arguments.Text("--output", {});
+		if (!path.empty())
+		{
+			if (format == ResultSerializer::Format::Csv)
+				ResultSerializer::CsvHeader<Analysis>(out);
+			for (const Analysis& analysis : analyses)
+				ResultSerializer::Write(format, out, analysis);
+			std::FILE* file = std::fopen(path.c_str(), "wb");
+			bool written = file && std::fwrite(out.Data(), 1, out.Size(), file) == out.Size();
+			if (!file || std::fclose(file) != 0 || !written)
+			{
+				std::fprintf(stderr, "hardware-analyzerd serialize: can't write %s\n", path.c_str());
+				return 1;
+			}
+		}
+
+		unsigned long repeat = (std::max)(arguments.Number("--repeat", 200), 1ul);
+		uint64_t bytes = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned long pass = 0; pass < repeat; pass++)
+		{
+			out.Clear();
+			for (const Analysis& analysis : analyses)
+				ResultSerializer::Write(format, out, analysis);
+			bytes += out.Size();
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		uint64_t records = static_cast<uint64_t>(analyses.size()) * repeat;
+		std::printf("%s: %llu records, %.1f bytes each, %.3f s: %.2f GB/s, %.1f M records/s\n", name.c_str(),
+			static_cast<unsigned long long>(records), static_cast<double>(bytes) / records, seconds, bytes / seconds / 1e9, records / seconds / 1e6);
+
+		if (format == ResultSerializer::Format::Json)
+		{
+			// The same JSON one std::string per record, as the server and report write it
+			bytes = 0;
+			start = std::chrono::steady_clock::now();
+			for (unsigned long pass = 0; pass < repeat; pass++)
+			{
+				for (const Analysis& analysis : analyses)
+					bytes += AnalysisJson::ToJson(analysis).size() + 1;
+			}
+			seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			std::printf("AnalysisJson::ToJson: %.3f s: %.2f GB/s\n", seconds, bytes / seconds / 1e9);
+		}
+		return 0;
+	}
+
+	// Analyzes --count synthetic pages (--macos: of Macs), then times the serializers on the
+	// results. --output FILE also writes them once to FILE.
+	int Serialize(const Arguments& arguments)
+	{
+		SyntheticCorpus::Options options = CorpusOptions(arguments);
+		options.MacOSShare = arguments.Flag("--macos") ? 1 : 0;
+		SyntheticCorpus generator(options);
+		SyntheticCorpus::Document document;
+		unsigned long count = arguments.Number("--count", 10000);
+
+		if (options.MacOSShare > 0)
+		{
+			std::vector<MacOSAnalysis> analyses;
+			for (unsigned long index = 0; index < count; index++)
+			{
+				generator.Generate(index, document);
+				analyses.push_back(AnalysisPipeline::AnalyzeMacOSText(document.Text));
+			}
+			return SerializeAnalyses(arguments, analyses);
+		}
+
+		std::vector<WindowsAnalysis> analyses;
+		for (unsigned long index = 0; index < count; index++)
+		{
+			generator.Generate(index, document);
+			analyses.push_back(AnalysisPipeline::AnalyzeWindowsText(document.Text));
+		}
+		return SerializeAnalyses(arguments, analyses);
+	}
+
+	// The options batch and batch-worker share; false after printing why they're wrong
+	bool BatchOptions(const Arguments& arguments, const char* command, ShardedBatch::Options& options)
+	{
+		std::string format = arguments.Text("--format", "json");
+		if (!FormatOf(format, options.Format))
+		{
+			std::fprintf(stderr, "hardware-analyzerd %s: unknown format %s\n", command, format.c_str());
+			return false;
+		}
+		options.OutputPath = arguments.Text("--output", {});
+		if (arguments.Positional().size() != 1 || options.OutputPath.empty())
+		{
+			std::fprintf(stderr, "hardware-analyzerd %s: expected --output FILE and one input file\n", command);
+			return false;
+		}
+		options.InputPath = arguments.Positional()[0];
+		options.ChunkBytes = arguments.Number("--chunk-kb", static_cast<unsigned long>(options.ChunkBytes / 1024)) * 1024;
+		options.CsvPlatform = arguments.Flag("--macos") ? TargetPlatform::macOS : TargetPlatform::Windows;
+		return true;
+	}
+
+	// Analyzes a file of JSON lines as "corpus" writes them over --workers processes (see
+	// ShardedBatch) into --output, one result per page in input order. --macos picks the
+	// pages and columns of a CSV output. --summary loads a binary output into a FleetResultStore
+	// afterwards and prints its totals as JSON.
+	int Batch(const Arguments& arguments, const char* program)
+	{
+		ShardedBatch::Options options;
+		if (!BatchOptions(arguments, "batch", options))
+			return 2;
+		bool summary = arguments.Flag("--summary");
+		if (summary && options.Format != ResultSerializer::Format::Binary)
+		{
+			std::fprintf(stderr, "hardware-analyzerd batch: --summary reads the results back, so it needs --format binary\n");
+			return 2;
+		}
+		options.Program = program;
+		options.Workers = static_cast<unsigned>(arguments.Number("--workers", options.Workers));
+		options.ShardDirectory = arguments.Text("--shards", {});
+
+		ShardedBatch::Statistics stats;
+		std::string error;
+		if (!ShardedBatch::Run(options, stats, error))
+		{
+			std::fprintf(stderr, "hardware-analyzerd batch: %s\n", error.c_str());
+			return 1;
+		}
+		double seconds = stats.AnalyzeSeconds + stats.MergeSeconds;
+		std::fprintf(stderr, "hardware-analyzerd batch: %llu pages (%llu skipped), %.1f MB in, %.1f MB out on %u workers: "
+			"analysis %.3f s, merge %.3f s, %.0f pages/s\n",
+			static_cast<unsigned long long>(stats.Records), static_cast<unsigned long long>(stats.Skipped),
+			stats.InputBytes / (1024.0 * 1024), stats.OutputBytes / (1024.0 * 1024), (std::max)(options.Workers, 1u),
+			stats.AnalyzeSeconds, stats.MergeSeconds, seconds > 0 ? stats.Records / seconds : 0.0);
+
+		if (summary)
+		{
+			std::ifstream file(options.OutputPath, std::ios::binary);
+			std::string bytes(std::istreambuf_iterator<char>(file), {});
+			FleetResultStore store;
+			if (!store.AppendBinary(bytes))
+			{
+				std::fprintf(stderr, "hardware-analyzerd batch: %s has a malformed record after %zu\n", options.OutputPath.c_str(), store.Size());
+				return 1;
+			}
+			FleetTotals totals;
+			totals.Add(store);
+			std::printf("%s\n", totals.ToJson().c_str());
+		}
+		return 0;
+	}
+
+	int BatchWorker(const Arguments& arguments)
+	{
+		ShardedBatch::Options options;
+		if (!BatchOptions(arguments, "batch-worker", options))
+			return 2;
+		unsigned workers = static_cast<unsigned>(arguments.Number("--workers", 0));
+		unsigned worker = static_cast<unsigned>(arguments.Number("--worker", 0));
+		if (worker >= workers)
+		{
+			std::fprintf(stderr, "hardware-analyzerd batch-worker: expected --worker I --workers N with I < N\n");
+			return 2;
+		}
+
+		std::string error;
+		if (!ShardedBatch::RunWorker(options, worker, workers, options.OutputPath, error))
+		{
+			std::fprintf(stderr, "hardware-analyzerd batch-worker: %s\n", error.c_str());
+			return 1;
+		}
+		return 0;
+	}
+
+	// Compiles label sources (LabelSource.h) into one pack, then loads it back as the app would
+	int Labels(const Arguments& arguments)
+	{
+		std::string output = arguments.Text("--output", {});
+		if (output.empty() || arguments.Positional().empty())
+		{
+			std::fprintf(stderr, "hardware-analyzerd labels: expected --output FILE and label sources\n");
+			return 2;
+		}
+
+		LabelSource source;
+		for (const std::string& path : arguments.Positional())
+		{
+			std::ifstream file(path, std::ios::binary);
+			std::string text(std::istreambuf_iterator<char>(file), {});
+			std::string error = "can't read the file";
+			if (!file || !source.Parse(text, error))
+			{
+				std::fprintf(stderr, "hardware-analyzerd labels: %s: %s\n", path.c_str(), error.c_str());
+				return 1;
+			}
+		}
+
+		std::string error;
+		auto catalog = source.Build(static_cast<uint32_t>(arguments.Number("--data-version", 1)), error);
+		if (!catalog)
+		{
+			std::fprintf(stderr, "hardware-analyzerd labels: %s\n", error.c_str());
+			return 1;
+		}
+		if (!LabelPack::Write(*catalog, output))
+		{
+			std::fprintf(stderr, "hardware-analyzerd labels: can't write %s\n", output.c_str());
+			return 1;
+		}
+		auto pack = LabelPack::Load(output, error);
+		if (!pack)
+		{
+			std::fprintf(stderr, "hardware-analyzerd labels: %s doesn't load back: %s\n", output.c_str(), error.c_str());
+			return 1;
+		}
+		std::printf("%s: %zu languages, %zu with a trigram profile, data version %u\n",
+			output.c_str(), pack->Languages().size(), pack->TrigramLanguageCount(), pack->DataVersion());
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string_view command = argc > 1 ? argv[1] : "";
+	Arguments arguments(argc, argv);
+	if (arguments.Valid() && command == "serve")
+		return Serve(arguments);
+	if (arguments.Valid() && command == "load")
+		return Load(arguments);
+	if (arguments.Valid() && command == "probe")
+		return Probe(arguments);
+	if (arguments.Valid() && command == "report")
+		return Report(arguments);
+	if (arguments.Valid() && command == "corpus")
+		return Corpus(arguments);
+	if (arguments.Valid() && command == "gate")
+		return Gate(arguments);
+	if (arguments.Valid() && command == "watch")
+		return Watch(arguments);
+	if (arguments.Valid() && command == "serialize")
+		return Serialize(arguments);
+	if (arguments.Valid() && command == "batch")
+		return Batch(arguments, argv[0]);
+	if (arguments.Valid() && command == "batch-worker")
+		return BatchWorker(arguments);
+	if (arguments.Valid() && command == "labels")
+		return Labels(arguments);
+
+	std::fprintf(stderr,
+		"usage: hardware-analyzerd serve [--socket PATH | --port N] [--workers N] [--batch N] [--batch-window-us N] [--queue N] [--arena-kb N] [--labels DIR] [--history DIR]\n"
+		"                                [--fleet-rows N]\n"
+		"       hardware-analyzerd load [--socket PATH | --port N] [--connections N] [--seconds N] [--macos] FILE | --corpus N [--seed N]\n"
+		"       hardware-analyzerd probe [--root DIR --machine NAME]\n"
+		"       hardware-analyzerd report [--macos] [--profiles FILE] [--repeat N] FILE...\n"
+		"       hardware-analyzerd corpus [--count N] [--first N] [--seed N] [--macos-share P] [--languages en,fr,...]\n"
+		"                                 [--noise P | --confusions P --merged-lines P --dropped-labels P] [--check [--threads N]]\n"
+		"       hardware-analyzerd gate [--min-score N] FILE... | --corpus N [--seed N] [--noise P] [--full]\n"
+		"       hardware-analyzerd watch [--macos] [--results DIR] [--history DIR] [--ocr-command \"tesseract {} stdout\"]\n"
+		"                                [--settle-ms N] [--ocr-workers N] [--workers N] [--queue N] [--once] DIR...\n"
+		"       hardware-analyzerd serialize [--format json|csv|binary] [--count N] [--repeat N] [--macos] [--output FILE]\n"
+		"       hardware-analyzerd batch [--workers N] [--chunk-kb N] [--format json|csv|binary] [--macos] [--shards DIR]\n"
+		"                                [--summary] --output FILE INPUT\n"
+		"       hardware-analyzerd labels [--data-version N] --output FILE.halp SOURCE...\n");
+	return 2;
+}
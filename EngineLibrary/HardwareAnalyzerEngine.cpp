@@ -0,0 +1,270 @@
+// HardwareAnalyzerEngine.cpp: the C ABI (HardwareAnalyzerEngine.h) over the header-only engine.
+// The engine is compiled in; callers need nothing but the C header and the library.
+//   Linux/macOS: c++ -std=c++20 -O2 -shared -fPIC -fvisibility=hidden -I../HardwareAnalyzer
+//                HardwareAnalyzerEngine.cpp -o libhardware_analyzer_engine.so
+//   Windows:     cl /std:c++20 /O2 /EHsc /LD /I..\HardwareAnalyzer HardwareAnalyzerEngine.cpp
+
+#define HA_BUILDING_LIBRARY
+#define HARDWARE_ANALYZER_PORTABLE
+#include "HardwareAnalyzerEngine.h"
+
+#include "pch.h"
+#include "AnalysisPipeline.h"
+#include "LabelPack.h"
+#include "ResultCodes.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+namespace
+{
+	using namespace HardwareAnalyzer;
+
+	static_assert(sizeof(ha_span) == 16 && sizeof(ha_check) == 32, "ABI structs changed size");
+	static_assert(HA_RESULT_V1_SIZE == 480 && sizeof(ha_result) >= HA_RESULT_V1_SIZE, "the v1 ha_result layout changed");
+	static_assert(ResultCodes::ReasonCount == HA_REASON_X86 + 1, "ha_reason and ResultCodes::ReasonKeys differ");
+	static_assert(static_cast<int>(CheckKind::MacOSVersion) == HA_CHECK_MACOS_VERSION, "ha_check_kind and CheckKind differ");
+
+	// Turns engine strings into spans: into the caller's input when the value appears there
+	// verbatim, else copied into the caller's scratch buffer. A value found more than once
+	// ("Intel" in a header card and on the processor line) is taken after its field's label,
+	// and as a whole word rather than inside a longer one ("16 GB" in "116 GB").
+	class SpanWriter
+	{
+	public:
+		SpanWriter(std::string_view input, std::wstring_view wide, ha_result& result, std::string& utf8)
+			: m_input(input), m_wide(wide), m_result(result), m_utf8(utf8) {}
+
+		ha_span Locate(std::wstring_view value, LabelField label = LabelField::Count)
+		{
+			ha_span span{};
+			if (value.empty() || value == L"?")
+				return span;
+
+			m_utf8.clear();
+			Utf8::Append(m_utf8, value);
+			size_t found = Find(0);
+			if (found != std::string_view::npos && label != LabelField::Count && m_input.find(m_utf8, found + 1) != std::string_view::npos)
+			{
+				size_t afterLabel = Find(LabelOffset(label));
+				if (afterLabel != std::string_view::npos)
+					found = afterLabel;
+			}
+			if (found != std::string_view::npos)
+			{
+				span.offset = static_cast<uint32_t>(found);
+				span.length = static_cast<uint32_t>(m_utf8.size());
+				span.source = HA_SPAN_INPUT;
+				return span;
+			}
+
+			uint32_t free = m_result.scratch_capacity - m_result.scratch_used;
+			if (!m_result.scratch || m_utf8.size() > free)
+			{
+				m_result.flags |= HA_RESULT_SCRATCH_OVERFLOW;
+				return span;
+			}
+			std::memcpy(m_result.scratch + m_result.scratch_used, m_utf8.data(), m_utf8.size());
+			span.offset = m_result.scratch_used;
+			span.length = static_cast<uint32_t>(m_utf8.size());
+			span.source = HA_SPAN_SCRATCH;
+			m_result.scratch_used += span.length;
+			return span;
+		}
+
+	private:
+		// First occurrence of the value from 'from' on that isn't part of a longer word or
+		// number, else the first occurrence at all
+		size_t Find(size_t from) const
+		{
+			size_t first = m_input.find(m_utf8, from);
+			bool wordStart = IsWordByte(m_utf8.front());
+			bool wordEnd = IsWordByte(m_utf8.back());
+			for (size_t found = first; found != std::string_view::npos; found = m_input.find(m_utf8, found + 1))
+			{
+				size_t end = found + m_utf8.size();
+				if ((!wordStart || found == 0 || !IsWordByte(m_input[found - 1]))
+					&& (!wordEnd || end == m_input.size() || !IsWordByte(m_input[end])))
+					return found;
+			}
+			return first;
+		}
+
+		static bool IsWordByte(char c)
+		{
+			return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+		}
+
+		// Byte offset of the first label of the field in the input, in any language; 0 without one
+		size_t LabelOffset(LabelField field)
+		{
+			if (!m_catalog)
+				m_catalog = LabelPack::Active();
+			size_t length = 0;
+			size_t pos = OcrTextScanner::FindAny(m_wide, m_catalog->All().Labels(field), 0, length);
+			return pos == OcrTextScanner::npos ? 0 : Utf8::ByteOffset(m_input, pos);
+		}
+
+		std::string_view m_input;
+		std::wstring_view m_wide;
+		ha_result& m_result;
+		std::string& m_utf8;
+		std::shared_ptr<const LabelCatalog> m_catalog;
+	};
+
+	// Label a check's value follows on a Windows page, when it's a field's value. VRAM has
+	// no catalog label of its own; it's read from the graphics card's header or name, so it
+	// is looked for after that label.
+	LabelField LabelOf(CheckKind kind)
+	{
+		switch (kind)
+		{
+		case CheckKind::Processor: return LabelField::Processor;
+		case CheckKind::GraphicsCard: return LabelField::GraphicsCard;
+		case CheckKind::RAM: return LabelField::InstalledRam;
+		case CheckKind::VideoMemory: return LabelField::GraphicsCard;
+		default: return LabelField::Count;
+		}
+	}
+
+	template <typename Results>
+	void WriteChecks(SpanWriter& spans, const Results& checks, ha_result& result)
+	{
+		for (const auto& check : checks)
+		{
+			if (result.check_count == HA_MAX_CHECKS)
+				break;
+			ha_check& out = result.checks[result.check_count++];
+			CheckKind kind = ResultCodes::KindOf(check.Name);
+			out.kind = kind == CheckKind::Count ? static_cast<uint32_t>(HA_CHECK_PROCESSOR) : static_cast<uint32_t>(kind);
+			out.status = static_cast<uint32_t>(check.Status);
+			out.reason = ResultCodes::ReasonOf(check.ReasonKey);
+			out.value = spans.Locate(check.Value, result.platform == HA_PLATFORM_WINDOWS ? LabelOf(kind) : LabelField::Count);
+		}
+	}
+
+	int32_t Analyze(uint32_t platform, const char* text, size_t length, ha_result* result)
+	{
+		if (!result || (!text && length > 0) || length > UINT32_MAX
+			|| (platform != HA_PLATFORM_WINDOWS && platform != HA_PLATFORM_MACOS))
+			return HA_ERROR_INVALID_ARGUMENT;
+		if (result->struct_size < HA_RESULT_V1_SIZE)
+			return HA_ERROR_STRUCT_SIZE;
+
+		// The result is built whole here and copied out as far as the caller's struct goes;
+		// the part of a newer caller's struct this library doesn't know is zeroed
+		constexpr size_t outputs = offsetof(ha_result, platform);
+		const size_t known = (std::min)(size_t{ result->struct_size }, sizeof(ha_result));
+		std::memset(reinterpret_cast<char*>(result) + outputs, 0, result->struct_size - outputs);
+		ha_result out{};
+		std::memcpy(&out, result, outputs);
+		out.platform = platform;
+		if (!out.scratch)
+			out.scratch_capacity = 0;
+
+		// Per-thread buffers keep repeated calls from reallocating them. The analysis lives in
+		// an arena over a per-thread block, going to the heap only for a page that outgrows
+		// it, and is released once its spans are written.
+		thread_local std::wstring wide;
+		thread_local std::string utf8;
+		alignas(std::max_align_t) thread_local std::byte arenaBlock[64 * 1024];
+		thread_local std::pmr::monotonic_buffer_resource arena(arenaBlock, sizeof(arenaBlock), std::pmr::new_delete_resource());
+		std::string_view input{ text ? text : "", length };
+		try
+		{
+			Utf8::Decode(input, wide);
+			SpanWriter spans{ input, wide, out, utf8 };
+			if (platform == HA_PLATFORM_WINDOWS)
+			{
+				pmr::WindowsAnalysis analysis = AnalysisPipeline::AnalyzeWindowsText(wide, &arena);
+				out.score = analysis.Score;
+				out.ram_gb = analysis.Info.RamGB;
+				out.vram_gb = analysis.Info.VramGB;
+				out.fields[HA_FIELD_DEVICE_NAME] = spans.Locate(analysis.Info.DeviceName, LabelField::DeviceName);
+				out.fields[HA_FIELD_PROCESSOR] = spans.Locate(analysis.Info.Processor, LabelField::Processor);
+				out.fields[HA_FIELD_RAM] = spans.Locate(analysis.Info.RAM, LabelField::InstalledRam);
+				out.fields[HA_FIELD_GPU] = spans.Locate(analysis.Info.GPU, LabelField::GraphicsCard);
+				out.fields[HA_FIELD_VRAM] = spans.Locate(analysis.Info.VRAM, LabelOf(CheckKind::VideoMemory));
+				out.fields[HA_FIELD_SYSTEM_TYPE] = spans.Locate(analysis.Info.SystemType, LabelField::SystemType);
+				WriteChecks(spans, analysis.Results, out);
+			}
+			else
+			{
+				pmr::MacOSAnalysis analysis = AnalysisPipeline::AnalyzeMacOSText(wide, &arena);
+				out.score = analysis.Score;
+				out.ram_gb = analysis.Info.MemoryGB;
+				out.chip_generation = analysis.Info.ChipGeneration;
+				out.macos_major_version = analysis.Info.MacOSMajorVersion;
+				out.is_apple_silicon = analysis.Info.IsAppleSilicon;
+				out.is_intel_mac = analysis.Info.IsIntelMac;
+				out.fields[HA_FIELD_DEVICE_NAME] = spans.Locate(analysis.Info.DeviceName);
+				out.fields[HA_FIELD_DEVICE_YEAR] = spans.Locate(analysis.Info.DeviceYear);
+				out.fields[HA_FIELD_CHIP] = spans.Locate(analysis.Info.Chip);
+				out.fields[HA_FIELD_MEMORY] = spans.Locate(analysis.Info.Memory);
+				out.fields[HA_FIELD_MACOS_VERSION] = spans.Locate(analysis.Info.MacOSVersion);
+				WriteChecks(spans, analysis.Results, out);
+			}
+		}
+		catch (...)
+		{
+			// Nothing may unwind into C; the result stays zeroed
+			arena.release();
+			return HA_ERROR_INTERNAL;
+		}
+		arena.release();
+		std::memcpy(reinterpret_cast<char*>(result) + outputs, reinterpret_cast<const char*>(&out) + outputs, known - outputs);
+		return HA_OK;
+	}
+}
+
+extern "C" HA_API uint32_t ha_abi_version(void)
+{
+	return HA_ABI_VERSION;
+}
+
+extern "C" HA_API int32_t ha_analyze(uint32_t platform, const char* text, size_t length, ha_result* result)
+{
+	return Analyze(platform, text, length, result);
+}
+
+extern "C" HA_API size_t ha_analyze_batch(ha_record* records, size_t count)
+{
+	if (!records)
+		return 0;
+
+	size_t succeeded = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		records[i].status = Analyze(records[i].platform, records[i].text, records[i].length, records[i].result);
+		if (records[i].status == HA_OK)
+			succeeded++;
+	}
+	return succeeded;
+}
+
+extern "C" HA_API const char* ha_reason_key(uint32_t reason)
+{
+	return reason < ResultCodes::ReasonCount ? ResultCodes::ReasonKeys[reason] : "";
+}
+
+extern "C" HA_API size_t ha_load_label_packs(const char* directory)
+{
+	try
+	{
+		if (directory)
+		{
+			std::u8string path(reinterpret_cast<const char8_t*>(directory));
+			LabelPack::SetActive(LabelPack::LoadDirectory(std::filesystem::path(path)));
+		}
+		return LabelPack::Active()->Languages().size();
+	}
+	catch (...)
+	{
+		return 0;
+	}
+}
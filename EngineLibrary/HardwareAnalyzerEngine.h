@@ -0,0 +1,227 @@
+/* HardwareAnalyzerEngine.h: C ABI of the OCR hardware analysis engine.
+ *
+ * Plain C, no Windows or WinRT headers. Results go into caller-owned structs: strings come
+ * back as spans into the caller's input (or into a scratch buffer the caller supplies for
+ * the rare value the engine rewrites), so nothing the library returns needs freeing.
+ *
+ * Compatibility: the major version changes only when an existing declaration does.
+ * Enumerators and fields are only ever appended; callers set ha_result.struct_size so a
+ * newer library never writes past an older caller's struct.
+ */
+#ifndef HARDWARE_ANALYZER_ENGINE_H
+#define HARDWARE_ANALYZER_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#if defined(HA_BUILDING_LIBRARY)
+#define HA_API __declspec(dllexport)
+#else
+#define HA_API __declspec(dllimport)
+#endif
+#else
+#define HA_API __attribute__((visibility("default")))
+#endif
+
+#define HA_ABI_VERSION_MAJOR 1
+#define HA_ABI_VERSION_MINOR 0
+#define HA_ABI_VERSION ((HA_ABI_VERSION_MAJOR << 16) | HA_ABI_VERSION_MINOR)
+
+/* Return codes */
+#define HA_OK 0
+#define HA_ERROR_INVALID_ARGUMENT 1   /* Null pointer, unknown platform, input over 4 GiB */
+#define HA_ERROR_STRUCT_SIZE 2        /* result->struct_size smaller than any known layout */
+#define HA_ERROR_INTERNAL 3           /* The engine failed; the result is zeroed */
+
+typedef enum ha_platform
+{
+	HA_PLATFORM_WINDOWS = 0,   /* Windows "About" / System Information page */
+	HA_PLATFORM_MACOS = 1      /* macOS "About This Mac" */
+} ha_platform;
+
+typedef enum ha_status_level
+{
+	HA_STATUS_GOOD = 0,
+	HA_STATUS_WARNING = 1,
+	HA_STATUS_BAD = 2
+} ha_status_level;
+
+/* Extracted text fields; each platform fills its own, the others stay empty */
+typedef enum ha_field
+{
+	HA_FIELD_DEVICE_NAME = 0,
+	HA_FIELD_PROCESSOR = 1,      /* Windows */
+	HA_FIELD_RAM = 2,            /* Windows */
+	HA_FIELD_GPU = 3,            /* Windows */
+	HA_FIELD_VRAM = 4,           /* Windows */
+	HA_FIELD_SYSTEM_TYPE = 5,    /* Windows */
+	HA_FIELD_DEVICE_YEAR = 6,    /* macOS */
+	HA_FIELD_CHIP = 7,           /* macOS */
+	HA_FIELD_MEMORY = 8,         /* macOS */
+	HA_FIELD_MACOS_VERSION = 9,  /* macOS */
+	HA_FIELD_COUNT = 10
+} ha_field;
+
+/* What a check judged, in the order the engine reports them */
+typedef enum ha_check_kind
+{
+	HA_CHECK_PROCESSOR = 0,
+	HA_CHECK_GRAPHICS_CARD = 1,
+	HA_CHECK_RAM = 2,
+	HA_CHECK_VIDEO_MEMORY = 3,
+	HA_CHECK_ARCHITECTURE = 4,
+	HA_CHECK_CHIP = 5,
+	HA_CHECK_MEMORY = 6,
+	HA_CHECK_MACOS_VERSION = 7
+} ha_check_kind;
+
+/* Why a check got its status; ha_reason_key() gives the app's localization key */
+typedef enum ha_reason
+{
+	HA_REASON_UNKNOWN = 0,
+	HA_REASON_AMD_RADEON = 1,
+	HA_REASON_AMD_VEGA = 2,
+	HA_REASON_ARM64 = 3,
+	HA_REASON_ACCEPTABLE_RAM = 4,
+	HA_REASON_APPLE_SILICON_SUPPORTED = 5,
+	HA_REASON_ARCH_UNKNOWN = 6,
+	HA_REASON_CPU_DETECTED = 7,
+	HA_REASON_CPU_NOT_FOUND = 8,
+	HA_REASON_CHIP_NOT_FOUND = 9,
+	HA_REASON_CHIP_UNKNOWN = 10,
+	HA_REASON_GPU_DETECTED = 11,
+	HA_REASON_GPU_NOT_FOUND = 12,
+	HA_REASON_GOOD_RAM = 13,
+	HA_REASON_GOOD_VRAM = 14,
+	HA_REASON_INTEL_ARC = 15,
+	HA_REASON_INTEL_INTEGRATED = 16,
+	HA_REASON_INTEL_IRIS = 17,
+	HA_REASON_INTEL_MAC_NOT_SUPPORTED = 18,
+	HA_REASON_INTEL_UHD = 19,
+	HA_REASON_LOW_PERF_CPU = 20,
+	HA_REASON_LOW_RAM = 21,
+	HA_REASON_LOW_VRAM = 22,
+	HA_REASON_MAC_ACCEPTABLE_MEMORY = 23,
+	HA_REASON_MAC_GOOD_MEMORY = 24,
+	HA_REASON_MAC_LOW_MEMORY = 25,
+	HA_REASON_MAC_OS_SUPPORTED = 26,
+	HA_REASON_MAC_OS_TOO_OLD = 27,
+	HA_REASON_MAC_OS_VERSION_NOT_FOUND = 28,
+	HA_REASON_MAC_VERY_LOW_MEMORY = 29,
+	HA_REASON_MEMORY_NOT_FOUND = 30,
+	HA_REASON_MODERN_INTEL = 31,
+	HA_REASON_MODERN_RYZEN = 32,
+	HA_REASON_MULTIPLE_GPU = 33,
+	HA_REASON_NVIDIA_DEDICATED = 34,
+	HA_REASON_OLDER_INTEL = 35,
+	HA_REASON_OLDER_RYZEN = 36,
+	HA_REASON_QUALCOMM_ARM = 37,
+	HA_REASON_QUALCOMM_ADRENO = 38,
+	HA_REASON_RAM_NOT_FOUND = 39,
+	HA_REASON_SHARED_MEMORY = 40,
+	HA_REASON_VRAM_NOT_FOUND = 41,
+	HA_REASON_VERY_LOW_RAM = 42,
+	HA_REASON_VERY_LOW_VRAM = 43,
+	HA_REASON_VERY_OLD_CPU = 44,
+	HA_REASON_X64 = 45,
+	HA_REASON_X86 = 46,
+} ha_reason;
+
+/* Where a span's bytes are */
+typedef enum ha_span_source
+{
+	HA_SPAN_NONE = 0,      /* Not found: the field is empty, or the check value is "?" */
+	HA_SPAN_INPUT = 1,     /* input + offset, verbatim from the caller's text */
+	HA_SPAN_SCRATCH = 2    /* result->scratch + offset: text the engine normalized or derived */
+} ha_span_source;
+
+/* An HA_SPAN_INPUT value that appears more than once in the input is the occurrence after its
+ * field's label on a Windows page (VRAM's is the graphics card's). macOS fields have no labels:
+ * theirs is the first occurrence that is a whole word, which is where the engine, taking the
+ * first match of each field, read it. */
+
+typedef struct ha_span
+{
+	uint32_t offset;
+	uint32_t length;       /* UTF-8 bytes */
+	uint32_t source;       /* ha_span_source */
+	uint32_t reserved;
+} ha_span;
+
+typedef struct ha_check
+{
+	uint32_t kind;         /* ha_check_kind */
+	uint32_t status;       /* ha_status_level */
+	uint32_t reason;       /* ha_reason */
+	uint32_t reserved;
+	ha_span value;
+} ha_check;
+
+#define HA_MAX_CHECKS 8
+
+/* Result flags */
+#define HA_RESULT_SCRATCH_OVERFLOW 0x1u   /* Some HA_SPAN_SCRATCH values didn't fit; their spans are HA_SPAN_NONE */
+
+typedef struct ha_result
+{
+	/* Set by the caller before the call */
+	uint32_t struct_size;      /* sizeof(ha_result); at least HA_RESULT_V1_SIZE */
+	uint32_t scratch_capacity;
+	char* scratch;             /* Optional; 256 bytes is plenty */
+
+	/* Filled by the library */
+	uint32_t platform;         /* ha_platform */
+	int32_t score;             /* 0..100, -1 when nothing could be extracted */
+	uint32_t flags;            /* HA_RESULT_* */
+	uint32_t scratch_used;
+	uint32_t check_count;
+	int32_t chip_generation;   /* macOS: 1 for M1, ... */
+	int32_t macos_major_version;
+	uint8_t is_apple_silicon;
+	uint8_t is_intel_mac;
+	uint16_t reserved;
+	double ram_gb;             /* Windows RAM, macOS memory */
+	double vram_gb;
+	ha_span fields[HA_FIELD_COUNT];
+	ha_check checks[HA_MAX_CHECKS];
+} ha_result;
+
+/* Size of the first ha_result layout. A library writes only the fields that fit in the
+ * caller's struct_size, and zeroes what it doesn't know of a newer caller's struct. */
+#define HA_RESULT_V1_SIZE (offsetof(ha_result, checks) + sizeof(ha_check) * HA_MAX_CHECKS)
+
+typedef struct ha_record
+{
+	const char* text;          /* UTF-8 OCR text, not necessarily NUL-terminated */
+	size_t length;
+	uint32_t platform;         /* ha_platform */
+	int32_t status;            /* Out: HA_OK or an HA_ERROR_* code for this record */
+	ha_result* result;
+} ha_record;
+
+/* HA_ABI_VERSION of the loaded library; check the major part against the header's */
+HA_API uint32_t ha_abi_version(void);
+
+/* Parses, analyzes and scores one OCR text. Thread-safe. */
+HA_API int32_t ha_analyze(uint32_t platform, const char* text, size_t length, ha_result* result);
+
+/* ha_analyze over many records in one call; returns how many got HA_OK */
+HA_API size_t ha_analyze_batch(ha_record* records, size_t count);
+
+/* "Reason_GoodRAM" for HA_REASON_GOOD_RAM; "" for an unknown id. Static storage. */
+HA_API const char* ha_reason_key(uint32_t reason);
+
+/* Uses the label packs (*.halp) in the directory from now on, on top of the built-in labels.
+ * Returns the number of languages the engine knows afterwards. */
+HA_API size_t ha_load_label_packs(const char* directory);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1195 @@
+#pragma once
+#include "pch.h"
+#include "AnalysisPipeline.h"
+#include "MappedFile.h"
+#include "ResultCodes.h"
+#include "Tracing.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace HardwareAnalyzer
+{
+	// One analysis read back from the history
+	struct HistoryRecord
+	{
+		uint64_t Offset = 0;
+		int64_t TimeMs = 0;     // Unix time in milliseconds
+		std::variant<WindowsAnalysis, MacOSAnalysis> Analysis;
+	};
+
+	// What the index knows about a device, without reading the log
+	struct HistoryDevice
+	{
+		uint64_t Offset = 0;    // Its latest record
+		int64_t TimeMs = 0;
+		uint32_t Records = 0;
+		TargetPlatform Platform = TargetPlatform::Windows;
+		int Score = -1;
+	};
+
+	// Per-device history of analyses in a directory of two files:
+	//
+	//   history.log   append-only records: RecordHeader, then the payload (UTF-8 strings,
+	//                 numbers, results by ResultCodes id), padded to 8 bytes. Each record
+	//                 links to the previous record of the same device.
+	//   history.idx   IndexHeader and an open-addressing table of IndexSlot, memory-mapped:
+	//                 the latest record, record count and score of each device
+	//
+	// Devices are keyed by a 64-bit hash of the UTF-8 of DeviceName (below); analyses without
+	// a name share the empty one. The log is the truth and the index a cache of it: the index is
+	// marked clean only when closed properly, and any other index is rebuilt by scanning the
+	// log, which is cut back to its last record whose CRCs match.
+	//
+	// Appends go into a Batch first, are written with one write call and indexed under one
+	// lock. Compaction runs in the background once the log has doubled: per device it keeps
+	// the newest record and every record that differs from the one before it (the upgrades
+	// and regressions), at most KeepPerDevice of them, and swaps the files in.
+	class AnalysisHistory
+	{
+	public:
+		static constexpr uint64_t NoRecord = UINT64_MAX;
+
+		struct Options
+		{
+			uint32_t KeepPerDevice = 32;
+			bool AutoCompact = true;
+		};
+
+		// Encoded records waiting to be appended. Encoding needs no lock, so batch workers
+		// fill their own and hand them over once per batch.
+		class Batch
+		{
+		public:
+			template <typename String>
+			void Add(const BasicWindowsAnalysis<String>& analysis, int64_t timeMs)
+			{
+				size_t start = Begin();
+				const auto& info = analysis.Info;
+				for (const String* text : { &info.DeviceName, &info.Processor, &info.RAM, &info.GPU, &info.VRAM, &info.SystemType })
+				{
+					AppendText(*text);
+				}
+				AppendValue(info.RamGB);
+				AppendValue(info.VramGB);
+				AppendResults(analysis.Results);
+				End(start, TargetPlatform::Windows, analysis.Score, DeviceName(info), timeMs);
+			}
+
+			template <typename String>
+			void Add(const BasicMacOSAnalysis<String>& analysis, int64_t timeMs)
+			{
+				size_t start = Begin();
+				const auto& info = analysis.Info;
+				for (const String* text : { &info.DeviceName, &info.DeviceYear, &info.Chip, &info.Memory, &info.MacOSVersion })
+				{
+					AppendText(*text);
+				}
+				AppendValue(info.MemoryGB);
+				AppendValue(static_cast<int32_t>(info.ChipGeneration));
+				AppendValue(static_cast<int32_t>(info.MacOSMajorVersion));
+				AppendValue(static_cast<uint8_t>((info.IsAppleSilicon ? 1 : 0) | (info.IsIntelMac ? 2 : 0)));
+				AppendResults(analysis.Results);
+				End(start, TargetPlatform::macOS, analysis.Score, DeviceName(info), timeMs);
+			}
+
+			size_t Size() const { return m_records.size(); }
+			bool Empty() const { return m_records.empty(); }
+
+			void Clear()
+			{
+				m_bytes.clear();
+				m_records.clear();
+			}
+
+		private:
+			friend class AnalysisHistory;
+
+			std::string m_bytes;
+			std::vector<size_t> m_records;     // Start of each record in m_bytes
+
+			size_t Begin()
+			{
+				size_t start = m_bytes.size();
+				m_bytes.append(sizeof(RecordHeader), '\0');
+				return start;
+			}
+
+			void End(size_t start, TargetPlatform platform, int score, std::wstring_view deviceName, int64_t timeMs)
+			{
+				size_t payload = m_bytes.size() - start - sizeof(RecordHeader);
+				m_bytes.append((8 - m_bytes.size() % 8) % 8, '\0');
+
+				RecordHeader header{};
+				header.Magic = RecordMagic;
+				header.Length = static_cast<uint32_t>(m_bytes.size() - start);
+				header.Key = DeviceKey(deviceName);
+				header.Previous = NoRecord;
+				header.TimeMs = timeMs;
+				header.Platform = static_cast<uint8_t>(platform);
+				header.Score = static_cast<int8_t>(std::clamp(score, -1, 100));
+				header.PayloadLength = static_cast<uint32_t>(payload);
+				header.ContentCrc = Crc32(reinterpret_cast<const std::byte*>(m_bytes.data() + start + sizeof(RecordHeader)), payload);
+				std::memcpy(m_bytes.data() + start, &header, sizeof(header));
+				m_records.push_back(start);
+			}
+
+			// UTF-8 behind a 16-bit length; longer text is cut (OCR lines never get close), at
+			// the start of a character so what is kept still decodes
+			void AppendText(std::wstring_view text)
+			{
+				size_t at = m_bytes.size();
+				m_bytes.append(sizeof(uint16_t), '\0');
+				Utf8::Append(m_bytes, text);
+				size_t length = m_bytes.size() - at - sizeof(uint16_t);
+				if (length > UINT16_MAX)
+				{
+					length = UINT16_MAX;
+					while (length > 0 && (static_cast<uint8_t>(m_bytes[at + sizeof(uint16_t) + length]) & 0xC0) == 0x80)
+						length--;
+					m_bytes.resize(at + sizeof(uint16_t) + length);
+				}
+				uint16_t stored = static_cast<uint16_t>(length);
+				std::memcpy(m_bytes.data() + at, &stored, sizeof(stored));
+			}
+
+			template <typename Value>
+			void AppendValue(Value value)
+			{
+				m_bytes.append(reinterpret_cast<const char*>(&value), sizeof(value));
+			}
+
+			template <typename Results>
+			void AppendResults(const Results& results)
+			{
+				AppendValue(static_cast<uint8_t>((std::min)(results.size(), size_t{ UINT8_MAX })));
+				for (size_t i = 0; i < results.size() && i < UINT8_MAX; i++)
+				{
+					AppendValue(static_cast<uint8_t>(ResultCodes::KindOf(results[i].Name)));
+					AppendValue(static_cast<uint8_t>(results[i].Status));
+					AppendValue(ResultCodes::ReasonOf(results[i].ReasonKey));
+					AppendText(results[i].Value);
+				}
+			}
+		};
+
+		AnalysisHistory() = default;
+
+		explicit AnalysisHistory(Options options)
+			: m_options(options)
+		{
+		}
+
+		~AnalysisHistory()
+		{
+			Close();
+		}
+
+		AnalysisHistory(const AnalysisHistory&) = delete;
+		AnalysisHistory& operator=(const AnalysisHistory&) = delete;
+
+		static int64_t Now()
+		{
+			return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		}
+
+		// The name a device's records are kept under, which Latest and History take. A Windows
+		// page shows the computer's own name. "About This Mac" shows only the model ("MacBook
+		// Pro"), so a Mac goes under its model, year, chip and memory: that keeps apart Macs
+		// of one model, but Macs of the same configuration still share a history, as nothing
+		// on the page tells them apart.
+		template <typename String>
+		static std::wstring DeviceName(const BasicHardwareInfo<String>& info)
+		{
+			return std::wstring(std::wstring_view(info.DeviceName));
+		}
+
+		template <typename String>
+		static std::wstring DeviceName(const BasicMacOSHardwareInfo<String>& info)
+		{
+			if (info.DeviceName.empty())
+				return {};
+			std::wstring name(std::wstring_view(info.DeviceName));
+			for (const String* part : { &info.DeviceYear, &info.Chip, &info.Memory })
+			{
+				if (!part->empty())
+					name.append(L" / ").append(std::wstring_view(*part));
+			}
+			return name;
+		}
+
+		// Creates the directory and files as needed; false with 'error' set on failure
+		bool Open(const std::filesystem::path& directory, std::string& error)
+		{
+			TraceSpan span{ "AnalysisHistory::Open" };
+			Close();
+			std::error_code ignored;
+			std::filesystem::create_directories(directory, ignored);
+
+			std::unique_lock<std::shared_mutex> lock(m_lock);
+			m_directory = directory;
+			return OpenFiles(error);
+		}
+
+		// Makes the history durable and marks the index clean; also done by the destructor.
+		// Waits for a running compaction, and none starts until the next Open.
+		void Close()
+		{
+			std::lock_guard<std::mutex> compactor(m_compactorLock);
+			if (m_compactor.joinable())
+				m_compactor.join();
+
+			std::unique_lock<std::shared_mutex> lock(m_lock);
+			if (!m_index.Data())
+				return;
+			m_log.Sync();
+			Header().LogBytes = m_logBytes;
+			Header().Clean = 1;
+			m_index.Flush();
+			CloseFiles();
+		}
+
+		bool IsOpen() const
+		{
+			std::shared_lock<std::shared_mutex> lock(m_lock);
+			return m_index.Data() != nullptr;
+		}
+
+		template <typename Analysis>
+		bool Append(const Analysis& analysis, int64_t timeMs = Now())
+		{
+			Batch batch;
+			batch.Add(analysis, timeMs);
+			return Append(batch);
+		}
+
+		// Writes and indexes the batch's records and clears it; false, with nothing written,
+		// when the history isn't open or the write fails, and false with the records written
+		// but not indexed when the index is lost
+		bool Append(Batch& batch)
+		{
+			if (batch.Empty())
+				return true;
+
+			bool compact = false;
+			{
+				std::unique_lock<std::shared_mutex> lock(m_lock);
+				if (!m_index.Data())
+					return false;
+
+				// Link each record to its device's previous one, which may be in the batch
+				uint64_t base = m_logBytes;
+				std::unordered_map<uint64_t, uint64_t> latest;
+				for (size_t start : batch.m_records)
+				{
+					RecordHeader header;
+					std::memcpy(&header, batch.m_bytes.data() + start, sizeof(header));
+					auto found = latest.find(header.Key);
+					const IndexSlot* slot = found == latest.end() ? Find(header.Key) : nullptr;
+					header.Previous = found != latest.end() ? found->second : (slot ? slot->Offset : NoRecord);
+					header.HeaderCrc = HeaderCrc(header);
+					std::memcpy(batch.m_bytes.data() + start, &header, sizeof(header));
+					latest[header.Key] = base + start;
+				}
+
+				if (!m_log.Write(batch.m_bytes.data(), batch.m_bytes.size()))
+				{
+					m_log.Truncate(base);
+					return false;
+				}
+				m_logBytes += batch.m_bytes.size();
+
+				// The log is ahead of the index from here until Apply finishes, which a crash
+				// in between can't leave behind: the index isn't clean until Close. Neither is
+				// it when the index is lost growing, which leaves the history closed until the
+				// next Open rebuilds it from the log.
+				for (size_t start : batch.m_records)
+				{
+					RecordHeader header;
+					std::memcpy(&header, batch.m_bytes.data() + start, sizeof(header));
+					if (!Apply(header, base + start))
+					{
+						CloseFiles();
+						return false;
+					}
+				}
+				Header().LogBytes = m_logBytes;
+				compact = m_options.AutoCompact && NeedsCompaction();
+			}
+			batch.Clear();
+
+			if (compact)
+				StartCompaction();
+			return true;
+		}
+
+		// Append for batch workers, which can't hold records back: the batch is cleared
+		// whether or not it was taken, so a failing or closed history can't make it grow.
+		// The number of records not appended, 0 on success.
+		size_t AppendOrDrop(Batch& batch)
+		{
+			if (Append(batch))
+				return 0;
+			size_t dropped = batch.Size();
+			batch.Clear();
+			return dropped;
+		}
+
+		// Forces the log and the index to the disk
+		bool Sync()
+		{
+			std::unique_lock<std::shared_mutex> lock(m_lock);
+			return m_index.Data() && m_log.Sync() && m_index.Flush();
+		}
+
+		// The index entry of the device, named as DeviceName names it: one hash and a probe or
+		// two, no log access
+		std::optional<HistoryDevice> Latest(std::wstring_view deviceName) const
+		{
+			uint64_t key = DeviceKey(deviceName);
+			std::shared_lock<std::shared_mutex> lock(m_lock);
+			const IndexSlot* slot = m_index.Data() ? Find(key) : nullptr;
+			if (!slot)
+				return std::nullopt;
+			return HistoryDevice{ slot->Offset, slot->TimeMs, slot->Records, static_cast<TargetPlatform>(slot->Platform), slot->Score };
+		}
+
+		std::optional<HistoryRecord> ReadLatest(std::wstring_view deviceName) const
+		{
+			auto device = Latest(deviceName);
+			return device ? Read(device->Offset) : std::nullopt;
+		}
+
+		// std::nullopt for an offset that isn't the start of a valid record
+		std::optional<HistoryRecord> Read(uint64_t offset) const
+		{
+			return WithView([&]() -> std::optional<HistoryRecord> {
+				RecordHeader header;
+				if (!ReadHeader(offset, header))
+					return std::nullopt;
+				return Decode(header, offset);
+			});
+		}
+
+		// The device's records, newest first
+		std::vector<HistoryRecord> History(std::wstring_view deviceName, size_t maxRecords = SIZE_MAX) const
+		{
+			uint64_t key = DeviceKey(deviceName);
+			return WithView([&] {
+				std::vector<HistoryRecord> records;
+				const IndexSlot* slot = m_index.Data() ? Find(key) : nullptr;
+				RecordHeader header;
+				for (uint64_t offset = slot ? slot->Offset : NoRecord; offset != NoRecord && records.size() < maxRecords; offset = header.Previous)
+				{
+					// Links only point back, so a damaged one can't make a loop
+					if (!ReadHeader(offset, header) || header.Key != key || (header.Previous != NoRecord && header.Previous >= offset))
+						break;
+					if (auto record = Decode(header, offset))
+						records.push_back(std::move(*record));
+				}
+				return records;
+			});
+		}
+
+		size_t DeviceCount() const
+		{
+			std::shared_lock<std::shared_mutex> lock(m_lock);
+			return m_index.Data() ? Header().Count : 0;
+		}
+
+		uint64_t RecordCount() const
+		{
+			std::shared_lock<std::shared_mutex> lock(m_lock);
+			return m_index.Data() ? Header().Records : 0;
+		}
+
+		// Compacts on a background thread unless a compaction is already running or the
+		// history is closed
+		bool StartCompaction()
+		{
+			std::lock_guard<std::mutex> compactor(m_compactorLock);
+			if (!IsOpen() || m_compacting.exchange(true))
+				return false;
+			if (m_compactor.joinable())
+				m_compactor.join();
+			m_compactor = std::thread([this] {
+				Compact();
+				m_compacting.store(false);
+			});
+			return true;
+		}
+
+		// Rewrites the log without the records compaction drops. Appends and lookups go on
+		// meanwhile; only the final copy of the records appended since and the swap of the
+		// files hold them up.
+		bool Compact()
+		{
+			TraceSpan span{ "AnalysisHistory::Compact" };
+			std::lock_guard<std::mutex> compacting(m_compactLock);
+
+			uint64_t snapshotEnd;
+			std::vector<IndexSlot> slots;
+			std::optional<MappedFile> source;
+			{
+				std::unique_lock<std::shared_mutex> lock(m_lock);
+				if (!m_index.Data())
+					return false;
+				snapshotEnd = m_logBytes;
+				const IndexSlot* table = Slots();
+				for (uint32_t i = 0; i < Header().Capacity; i++)
+				{
+					if (table[i].Key != 0)
+						slots.push_back(table[i]);
+				}
+				source = MappedFile::Open(LogPath());
+			}
+			if (!source || source->Size() < snapshotEnd)
+				return false;
+
+			AppendFile out;
+			if (!out.Open(CompactLogPath(), true))
+				return false;
+
+			std::unordered_map<uint64_t, IndexSlot> table;
+			table.reserve(slots.size());
+			std::string buffer;
+			uint64_t written = 0;
+			std::vector<uint64_t> kept;
+			for (const IndexSlot& slot : slots)
+			{
+				kept.clear();
+				bool newest = true;
+				RecordHeader header;
+				for (uint64_t offset = slot.Offset; offset != NoRecord && kept.size() < m_options.KeepPerDevice; offset = header.Previous)
+				{
+					if (!ReadHeader(*source, offset, header) || (header.Previous != NoRecord && header.Previous >= offset))
+						break;
+					RecordHeader previous;
+					bool changed = header.Previous == NoRecord || !ReadHeader(*source, header.Previous, previous)
+						|| previous.ContentCrc != header.ContentCrc;
+					if (newest || changed)
+						kept.push_back(offset);
+					newest = false;
+				}
+
+				IndexSlot& moved = table[slot.Key];
+				moved = NewSlot(slot.Key);
+				for (auto it = kept.rbegin(); it != kept.rend(); ++it)
+				{
+					CopyRecord(*source, *it, moved, written, buffer);
+				}
+				if (buffer.size() >= FlushBytes)
+				{
+					if (!out.Write(buffer.data(), buffer.size()))
+						return false;
+					buffer.clear();
+				}
+			}
+
+			std::unique_lock<std::shared_mutex> lock(m_lock);
+			if (!m_index.Data())
+				return false;
+
+			// Records appended while the rest was copied
+			if (m_logBytes > snapshotEnd)
+			{
+				source = MappedFile::Open(LogPath());
+				if (!source || source->Size() < m_logBytes)
+					return false;
+				RecordHeader header;
+				for (uint64_t offset = snapshotEnd; offset < m_logBytes && ReadHeader(*source, offset, header); offset += header.Length)
+				{
+					IndexSlot& moved = table.try_emplace(header.Key, NewSlot(header.Key)).first->second;
+					CopyRecord(*source, offset, moved, written, buffer);
+				}
+			}
+			bool complete = out.Write(buffer.data(), buffer.size()) && out.Sync();
+			out.Close();
+			source.reset();
+			if (!complete || !WriteIndex(CompactIndexPath(), table, written))
+				return false;
+
+			// The log goes first: with the new log and the old index, which isn't clean,
+			// a crash in between ends in a rebuild rather than the old offsets
+			CloseFiles();
+			std::error_code renamed;
+			std::filesystem::rename(CompactLogPath(), LogPath(), renamed);
+			if (!renamed)
+				std::filesystem::rename(CompactIndexPath(), IndexPath(), renamed);
+			std::string error;
+			return OpenFiles(error) && !renamed;
+		}
+
+	private:
+		static constexpr uint32_t RecordMagic = 0x52484148;    // "HAHR"
+		static constexpr uint32_t IndexMagic = 0x49484148;     // "HAHI"
+		static constexpr uint16_t IndexVersion = 1;
+		static constexpr uint32_t InitialCapacity = 1024;
+		static constexpr uint64_t MinCompactionRecords = 4096;
+		static constexpr size_t FlushBytes = 1024 * 1024;
+
+		struct RecordHeader
+		{
+			uint32_t Magic;
+			uint32_t Length;          // Whole record, a multiple of 8
+			uint64_t Key;             // DeviceKey of the device name
+			uint64_t Previous;        // The device's previous record, NoRecord for its first
+			int64_t TimeMs;
+			uint8_t Platform;
+			int8_t Score;
+			uint16_t Reserved;
+			uint32_t ContentCrc;      // CRC-32 of the payload; equal for repeated analyses
+			uint32_t PayloadLength;
+			uint32_t HeaderCrc;       // CRC-32 of the fields above
+		};
+
+		struct IndexHeader
+		{
+			uint32_t Magic;
+			uint16_t Version;
+			uint16_t Clean;           // 1 only between Close and the next Open
+			uint32_t Capacity;        // Slots, a power of two
+			uint32_t Count;           // Devices
+			uint64_t LogBytes;        // Log length the index reflects
+			uint64_t Records;
+			uint64_t CompactedRecords;
+			uint64_t Reserved[3];
+		};
+
+		struct IndexSlot
+		{
+			uint64_t Key;             // 0 = empty
+			uint64_t Offset;
+			int64_t TimeMs;
+			uint32_t Records;
+			uint8_t Platform;
+			int8_t Score;
+			uint16_t Reserved;
+		};
+
+		static_assert(std::endian::native == std::endian::little, "History files are read in place as little-endian");
+		static_assert(sizeof(RecordHeader) == 48 && sizeof(IndexHeader) == 64 && sizeof(IndexSlot) == 32);
+
+		// The log file, written at its end only
+		class AppendFile
+		{
+		public:
+			AppendFile() = default;
+			AppendFile(const AppendFile&) = delete;
+			AppendFile& operator=(const AppendFile&) = delete;
+
+			~AppendFile()
+			{
+				Close();
+			}
+
+			bool Open(const std::filesystem::path& path, bool truncate)
+			{
+				Close();
+#ifdef _WIN32
+				m_handle = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+					truncate ? CREATE_ALWAYS : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+				return m_handle != INVALID_HANDLE_VALUE;
+#else
+				m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : 0), 0644);
+				return m_fd >= 0;
+#endif
+			}
+
+			uint64_t Size() const
+			{
+#ifdef _WIN32
+				LARGE_INTEGER size{};
+				return GetFileSizeEx(m_handle, &size) ? static_cast<uint64_t>(size.QuadPart) : 0;
+#else
+				struct stat status{};
+				return fstat(m_fd, &status) == 0 ? static_cast<uint64_t>(status.st_size) : 0;
+#endif
+			}
+
+			bool Write(const char* data, size_t size)
+			{
+#ifdef _WIN32
+				LARGE_INTEGER zero{};
+				if (!SetFilePointerEx(m_handle, zero, nullptr, FILE_END))
+					return false;
+				while (size > 0)
+				{
+					DWORD written = 0;
+					DWORD chunk = static_cast<DWORD>((std::min)(size, size_t{ 1 } << 30));
+					if (!WriteFile(m_handle, data, chunk, &written, nullptr) || written == 0)
+						return false;
+					data += written;
+					size -= written;
+				}
+#else
+				if (lseek(m_fd, 0, SEEK_END) < 0)
+					return false;
+				while (size > 0)
+				{
+					ssize_t written = write(m_fd, data, size);
+					if (written < 0 && errno == EINTR)
+						continue;
+					if (written <= 0)
+						return false;
+					data += written;
+					size -= static_cast<size_t>(written);
+				}
+#endif
+				return true;
+			}
+
+			bool Truncate(uint64_t size)
+			{
+#ifdef _WIN32
+				LARGE_INTEGER end{};
+				end.QuadPart = static_cast<LONGLONG>(size);
+				return SetFilePointerEx(m_handle, end, nullptr, FILE_BEGIN) && SetEndOfFile(m_handle);
+#else
+				return ftruncate(m_fd, static_cast<off_t>(size)) == 0;
+#endif
+			}
+
+			bool Sync()
+			{
+#ifdef _WIN32
+				return FlushFileBuffers(m_handle) != 0;
+#elif defined(__APPLE__)
+				return fsync(m_fd) == 0;
+#else
+				return fdatasync(m_fd) == 0;
+#endif
+			}
+
+			void Close()
+			{
+#ifdef _WIN32
+				if (m_handle != INVALID_HANDLE_VALUE)
+					CloseHandle(m_handle);
+				m_handle = INVALID_HANDLE_VALUE;
+#else
+				if (m_fd >= 0)
+					close(m_fd);
+				m_fd = -1;
+#endif
+			}
+
+		private:
+#ifdef _WIN32
+			HANDLE m_handle = INVALID_HANDLE_VALUE;
+#else
+			int m_fd = -1;
+#endif
+		};
+
+		Options m_options;
+		std::filesystem::path m_directory;
+		mutable std::shared_mutex m_lock;     // Guards everything below
+		AppendFile m_log;
+		uint64_t m_logBytes = 0;
+		WritableMappedFile m_index;
+		mutable std::optional<MappedFile> m_view;      // Read-only map of the log for readers
+
+		std::mutex m_compactLock;
+		std::atomic<bool> m_compacting{ false };
+		std::mutex m_compactorLock;     // Guards m_compactor between StartCompaction and Close
+		std::thread m_compactor;
+
+		std::filesystem::path LogPath() const { return m_directory / L"history.log"; }
+		std::filesystem::path IndexPath() const { return m_directory / L"history.idx"; }
+		std::filesystem::path CompactLogPath() const { return m_directory / L"history.log.compact"; }
+		std::filesystem::path CompactIndexPath() const { return m_directory / L"history.idx.compact"; }
+
+		IndexHeader& Header() const { return *reinterpret_cast<IndexHeader*>(m_index.Data()); }
+		IndexSlot* Slots() const { return reinterpret_cast<IndexSlot*>(m_index.Data() + sizeof(IndexHeader)); }
+
+		static IndexSlot NewSlot(uint64_t key)
+		{
+			return IndexSlot{ key, NoRecord, 0, 0, 0, -1, 0 };
+		}
+
+		static size_t IndexBytes(uint32_t capacity)
+		{
+			return sizeof(IndexHeader) + size_t{ capacity } * sizeof(IndexSlot);
+		}
+
+		// FNV-1a over the UTF-8 of the name, so the keys in the files are the same where
+		// wchar_t is UTF-16 and where it is UTF-32, then mixed for the probe position
+		static uint64_t DeviceKey(std::wstring_view name)
+		{
+			uint64_t hash = 14695981039346656037ull;
+			auto feed = [&](uint32_t byte) { hash = (hash ^ byte) * 1099511628211ull; };
+			for (size_t i = 0; i < name.size(); i++)
+			{
+				uint32_t c = static_cast<uint32_t>(name[i]);
+				if (c >= 0xD800 && c <= 0xDBFF && i + 1 < name.size())
+				{
+					uint32_t low = static_cast<uint32_t>(name[i + 1]);
+					if (low >= 0xDC00 && low <= 0xDFFF)
+					{
+						c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+						i++;
+					}
+				}
+
+				if (c < 0x80)
+				{
+					feed(c);
+				}
+				else if (c < 0x800)
+				{
+					feed(0xC0 | (c >> 6));
+					feed(0x80 | (c & 0x3F));
+				}
+				else if (c < 0x10000)
+				{
+					feed(0xE0 | (c >> 12));
+					feed(0x80 | ((c >> 6) & 0x3F));
+					feed(0x80 | (c & 0x3F));
+				}
+				else
+				{
+					feed(0xF0 | (c >> 18));
+					feed(0x80 | ((c >> 12) & 0x3F));
+					feed(0x80 | ((c >> 6) & 0x3F));
+					feed(0x80 | (c & 0x3F));
+				}
+			}
+			hash ^= hash >> 33;
+			hash *= 0xff51afd7ed558ccdull;
+			hash ^= hash >> 33;
+			return hash == 0 ? 1 : hash;
+		}
+
+		static uint32_t Crc32(const std::byte* data, size_t size)
+		{
+			static constexpr auto Table = [] {
+				std::array<uint32_t, 256> table{};
+				for (uint32_t i = 0; i < 256; i++)
+				{
+					uint32_t c = i;
+					for (int bit = 0; bit < 8; bit++)
+					{
+						c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+					}
+					table[i] = c;
+				}
+				return table;
+			}();
+
+			uint32_t crc = 0xFFFFFFFFu;
+			for (size_t i = 0; i < size; i++)
+			{
+				crc = Table[(crc ^ static_cast<uint32_t>(data[i])) & 0xFF] ^ (crc >> 8);
+			}
+			return ~crc;
+		}
+
+		static uint32_t HeaderCrc(const RecordHeader& header)
+		{
+			return Crc32(reinterpret_cast<const std::byte*>(&header), offsetof(RecordHeader, HeaderCrc));
+		}
+
+		// Called with m_lock held exclusively
+		bool OpenFiles(std::string& error)
+		{
+			if (!m_log.Open(LogPath(), false))
+			{
+				error = "can't open " + LogPath().string();
+				return false;
+			}
+			uint64_t logSize = m_log.Size();
+
+			// Trusted only after a Close that covered no more than the log now holds
+			uint64_t replayFrom = 0;
+			auto index = WritableMappedFile::Open(IndexPath());
+			if (index && index->Size() >= sizeof(IndexHeader))
+			{
+				IndexHeader header;
+				std::memcpy(&header, index->Data(), sizeof(header));
+				if (header.Magic == IndexMagic && header.Version == IndexVersion && header.Clean == 1
+					&& std::has_single_bit(header.Capacity) && index->Size() == IndexBytes(header.Capacity) && header.LogBytes <= logSize)
+				{
+					m_index = std::move(*index);
+					replayFrom = header.LogBytes;
+				}
+			}
+			index.reset();
+			if (!m_index.Data() && !CreateIndex(IndexPath(), InitialCapacity))
+			{
+				error = "can't create " + IndexPath().string();
+				m_log.Close();
+				return false;
+			}
+
+			Header().Clean = 0;
+			m_index.Flush();
+			m_logBytes = Replay(replayFrom, logSize);
+			if (!m_index.Data())
+			{
+				error = "can't reopen " + IndexPath().string() + " after growing it";
+				m_log.Close();
+				return false;
+			}
+			if (m_logBytes < logSize)
+				m_log.Truncate(m_logBytes);
+			Header().LogBytes = m_logBytes;
+			// A rebuilt index starts the compaction count from the log as it is
+			if (replayFrom == 0)
+				Header().CompactedRecords = Header().Records;
+			return true;
+		}
+
+		void CloseFiles()
+		{
+			m_view.reset();
+			m_index = WritableMappedFile{};
+			m_log.Close();
+		}
+
+		bool CreateIndex(const std::filesystem::path& path, uint32_t capacity)
+		{
+			std::error_code ignored;
+			std::filesystem::remove(path, ignored);
+			auto index = WritableMappedFile::Open(path, IndexBytes(capacity));
+			if (!index)
+				return false;
+			std::memset(index->Data(), 0, index->Size());
+			m_index = std::move(*index);
+			Header().Magic = IndexMagic;
+			Header().Version = IndexVersion;
+			Header().Capacity = capacity;
+			return true;
+		}
+
+		// Indexes the valid records in [from, end); returns where the valid ones stop
+		uint64_t Replay(uint64_t from, uint64_t end)
+		{
+			if (from >= end)
+				return from;
+			auto log = MappedFile::Open(LogPath());
+			if (!log)
+				return from;
+
+			uint64_t offset = from;
+			RecordHeader header;
+			while (offset < end && ReadHeader(*log, offset, header)
+				&& Crc32(log->Data() + offset + sizeof(RecordHeader), header.PayloadLength) == header.ContentCrc)
+			{
+				if (!Apply(header, offset))
+					break;
+				offset += header.Length;
+			}
+			return offset;
+		}
+
+		bool ReadHeader(uint64_t offset, RecordHeader& header) const
+		{
+			return m_view && ReadHeader(*m_view, offset, header);
+		}
+
+		static bool ReadHeader(const MappedFile& log, uint64_t offset, RecordHeader& header)
+		{
+			if (offset % 8 != 0 || offset > log.Size() || log.Size() - offset < sizeof(RecordHeader))
+				return false;
+			std::memcpy(&header, log.Data() + offset, sizeof(header));
+			return header.Magic == RecordMagic && header.HeaderCrc == HeaderCrc(header)
+				&& header.Length % 8 == 0 && header.Length >= sizeof(RecordHeader) + uint64_t{ header.PayloadLength }
+				&& header.Length <= log.Size() - offset;
+		}
+
+		const IndexSlot* Find(uint64_t key) const
+		{
+			const IndexSlot* slots = Slots();
+			uint32_t mask = Header().Capacity - 1;
+			for (uint32_t i = static_cast<uint32_t>(key) & mask;; i = (i + 1) & mask)
+			{
+				if (slots[i].Key == key)
+					return &slots[i];
+				if (slots[i].Key == 0)
+					return nullptr;
+			}
+		}
+
+		// Makes the record at 'offset' its device's latest; false when growing the table lost
+		// the index, which leaves m_index unmapped
+		bool Apply(const RecordHeader& header, uint64_t offset)
+		{
+			// At most 70% full, so probes stay short and always reach an empty slot
+			if ((uint64_t{ Header().Count } + 1) * 10 > uint64_t{ Header().Capacity } * 7 && !Grow())
+				return false;
+
+			IndexSlot* slots = Slots();
+			uint32_t mask = Header().Capacity - 1;
+			uint32_t i = static_cast<uint32_t>(header.Key) & mask;
+			while (slots[i].Key != 0 && slots[i].Key != header.Key)
+			{
+				i = (i + 1) & mask;
+			}
+			IndexSlot& slot = slots[i];
+			if (slot.Key == 0)
+			{
+				if ((uint64_t{ Header().Count } + 2) > Header().Capacity)
+					return true;     // Growing failed and the table is full: the next Open rebuilds
+				slot = NewSlot(header.Key);
+				Header().Count++;
+			}
+			slot.Offset = offset;
+			slot.TimeMs = header.TimeMs;
+			slot.Records++;
+			slot.Platform = header.Platform;
+			slot.Score = header.Score;
+			Header().Records++;
+			return true;
+		}
+
+		// Doubles the table into a new file and swaps it in. Keeps the old one when the new
+		// one can't be made; false when neither can be mapped again once the old is unmapped.
+		bool Grow()
+		{
+			IndexHeader header = Header();
+			std::vector<IndexSlot> slots(Slots(), Slots() + header.Capacity);
+			WritableMappedFile old = std::move(m_index);
+
+			std::filesystem::path grown = m_directory / L"history.idx.grow";
+			if (!CreateIndex(grown, header.Capacity * 2))
+			{
+				m_index = std::move(old);
+				return true;
+			}
+			header.Capacity *= 2;
+			Header() = header;
+			IndexSlot* table = Slots();
+			uint32_t mask = header.Capacity - 1;
+			for (const IndexSlot& slot : slots)
+			{
+				if (slot.Key == 0)
+					continue;
+				uint32_t i = static_cast<uint32_t>(slot.Key) & mask;
+				while (table[i].Key != 0)
+				{
+					i = (i + 1) & mask;
+				}
+				table[i] = slot;
+			}
+
+			// Windows can't replace a file that is still mapped
+			old = WritableMappedFile{};
+			m_index = WritableMappedFile{};
+			std::error_code error;
+			std::filesystem::rename(grown, IndexPath(), error);
+			auto index = WritableMappedFile::Open(error ? grown : IndexPath());
+			if (index)
+				m_index = std::move(*index);
+			return m_index.Data() != nullptr;
+		}
+
+		bool NeedsCompaction() const
+		{
+			const IndexHeader& header = Header();
+			return header.Records >= 2 * (std::max)(header.CompactedRecords, uint64_t{ header.Count }) + MinCompactionRecords;
+		}
+
+		// Appends the record at 'offset' of 'source' to 'buffer' as the next record of 'slot',
+		// at 'written' in the new log
+		static void CopyRecord(const MappedFile& source, uint64_t offset, IndexSlot& slot, uint64_t& written, std::string& buffer)
+		{
+			RecordHeader header;
+			std::memcpy(&header, source.Data() + offset, sizeof(header));
+			header.Previous = slot.Offset;
+			header.HeaderCrc = HeaderCrc(header);
+			size_t at = buffer.size();
+			buffer.append(reinterpret_cast<const char*>(source.Data() + offset), header.Length);
+			std::memcpy(buffer.data() + at, &header, sizeof(header));
+
+			slot.Offset = written;
+			slot.TimeMs = header.TimeMs;
+			slot.Records++;
+			slot.Platform = header.Platform;
+			slot.Score = header.Score;
+			written += header.Length;
+		}
+
+		// Writes a clean index of 'table' for a log of 'logBytes'
+		static bool WriteIndex(const std::filesystem::path& path, const std::unordered_map<uint64_t, IndexSlot>& table, uint64_t logBytes)
+		{
+			uint32_t capacity = InitialCapacity;
+			while (uint64_t{ capacity } * 7 < (uint64_t{ table.size() } + 1) * 10)
+			{
+				capacity *= 2;
+			}
+
+			std::error_code ignored;
+			std::filesystem::remove(path, ignored);
+			auto index = WritableMappedFile::Open(path, IndexBytes(capacity));
+			if (!index)
+				return false;
+			std::memset(index->Data(), 0, index->Size());
+
+			IndexHeader header{};
+			header.Magic = IndexMagic;
+			header.Version = IndexVersion;
+			header.Clean = 1;
+			header.Capacity = capacity;
+			header.Count = static_cast<uint32_t>(table.size());
+			header.LogBytes = logBytes;
+			IndexSlot* slots = reinterpret_cast<IndexSlot*>(index->Data() + sizeof(IndexHeader));
+			for (const auto& [key, slot] : table)
+			{
+				uint32_t i = static_cast<uint32_t>(key) & (capacity - 1);
+				while (slots[i].Key != 0)
+				{
+					i = (i + 1) & (capacity - 1);
+				}
+				slots[i] = slot;
+				header.Records += slot.Records;
+			}
+			header.CompactedRecords = header.Records;
+			std::memcpy(index->Data(), &header, sizeof(header));
+			return index->Flush();
+		}
+
+		// Runs 'function' with the read-only map covering the whole log, remapping it first
+		// (under the exclusive lock) if appends have outgrown it
+		template <typename Function>
+		auto WithView(Function&& function) const -> decltype(function())
+		{
+			{
+				std::shared_lock<std::shared_mutex> lock(m_lock);
+				if (!m_index.Data() || (m_view && m_view->Size() >= m_logBytes))
+					return function();
+			}
+			std::unique_lock<std::shared_mutex> lock(m_lock);
+			if (m_index.Data() && (!m_view || m_view->Size() < m_logBytes))
+				m_view = MappedFile::Open(LogPath());
+			return function();
+		}
+
+		// Reads a record's payload; std::nullopt if it doesn't parse
+		std::optional<HistoryRecord> Decode(const RecordHeader& header, uint64_t offset) const
+		{
+			PayloadReader reader{ m_view->Data() + offset + sizeof(RecordHeader), header.PayloadLength };
+			HistoryRecord record;
+			record.Offset = offset;
+			record.TimeMs = header.TimeMs;
+			if (header.Platform == static_cast<uint8_t>(TargetPlatform::macOS))
+			{
+				MacOSAnalysis analysis;
+				auto& info = analysis.Info;
+				for (std::wstring* text : { &info.DeviceName, &info.DeviceYear, &info.Chip, &info.Memory, &info.MacOSVersion })
+				{
+					reader.Text(*text);
+				}
+				info.MemoryGB = reader.Read<double>();
+				info.ChipGeneration = reader.Read<int32_t>();
+				info.MacOSMajorVersion = reader.Read<int32_t>();
+				uint8_t flags = reader.Read<uint8_t>();
+				info.IsAppleSilicon = (flags & 1) != 0;
+				info.IsIntelMac = (flags & 2) != 0;
+				reader.Results(analysis.Results);
+				analysis.Score = header.Score;
+				record.Analysis = std::move(analysis);
+			}
+			else
+			{
+				WindowsAnalysis analysis;
+				auto& info = analysis.Info;
+				for (std::wstring* text : { &info.DeviceName, &info.Processor, &info.RAM, &info.GPU, &info.VRAM, &info.SystemType })
+				{
+					reader.Text(*text);
+				}
+				info.RamGB = reader.Read<double>();
+				info.VramGB = reader.Read<double>();
+				reader.Results(analysis.Results);
+				analysis.Score = header.Score;
+				record.Analysis = std::move(analysis);
+			}
+			if (!reader.Valid)
+				return std::nullopt;
+			return record;
+		}
+
+		// Bounds-checked reads; past the end everything reads as empty and Valid turns false
+		struct PayloadReader
+		{
+			const std::byte* Data;
+			size_t Size;
+			size_t Position = 0;
+			bool Valid = true;
+
+			template <typename Value>
+			Value Read()
+			{
+				Value value{};
+				if (Size - Position < sizeof(value))
+				{
+					Valid = false;
+					return value;
+				}
+				std::memcpy(&value, Data + Position, sizeof(value));
+				Position += sizeof(value);
+				return value;
+			}
+
+			void Text(std::wstring& text)
+			{
+				uint16_t length = Read<uint16_t>();
+				if (Size - Position < length)
+				{
+					Valid = false;
+					return;
+				}
+				Utf8::Decode({ reinterpret_cast<const char*>(Data + Position), length }, text);
+				Position += length;
+			}
+
+			void Results(std::vector<HardwareCheckResult>& results)
+			{
+				uint8_t count = Read<uint8_t>();
+				for (uint8_t i = 0; i < count && Valid; i++)
+				{
+					uint8_t kind = Read<uint8_t>();
+					uint8_t status = Read<uint8_t>();
+					uint8_t reason = Read<uint8_t>();
+					HardwareCheckResult result;
+					Text(result.Value);
+					if (kind >= static_cast<uint8_t>(CheckKind::Count))
+						continue;
+					result.Name = Widen(ResultCodes::CheckNames[kind]);
+					result.Status = static_cast<StatusLevel>((std::min)(status, static_cast<uint8_t>(StatusLevel::Bad)));
+					result.ReasonKey = Widen(ResultCodes::ReasonKey(reason));
+					results.push_back(std::move(result));
+				}
+			}
+
+			static std::wstring Widen(std::string_view ascii)
+			{
+				return std::wstring(ascii.begin(), ascii.end());
+			}
+		};
+	};
+}
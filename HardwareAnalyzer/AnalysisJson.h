@@ -0,0 +1,160 @@
+#pragma once
+#include "pch.h"
+#include "AnalysisPipeline.h"
+#include "Utf8.h"
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace HardwareAnalyzer
+{
+	// Analysis results as compact UTF-8 JSON for callers outside the app:
+	//   {"platform":"windows","score":85,"info":{...},"results":[{"name":...,"value":...,"status":"good","reasonKey":...}]}
+	// Numbers are written with to_chars, so the output doesn't depend on the C locale.
+	class AnalysisJson
+	{
+	public:
+		template <typename String>
+		static std::string ToJson(const BasicWindowsAnalysis<String>& analysis)
+		{
+			std::string json = "{\"platform\":\"windows\",\"score\":";
+			AppendNumber(json, analysis.Score);
+			json += ",\"info\":";
+			AppendInfo(json, analysis.Info);
+			AppendResults(json, analysis.Results);
+			json += '}';
+			return json;
+		}
+
+		template <typename String>
+		static std::string ToJson(const BasicMacOSAnalysis<String>& analysis)
+		{
+			std::string json = "{\"platform\":\"macos\",\"score\":";
+			AppendNumber(json, analysis.Score);
+			json += ",\"info\":";
+			AppendInfo(json, analysis.Info);
+			AppendResults(json, analysis.Results);
+			json += '}';
+			return json;
+		}
+
+		// The "info" object of ToJson on its own
+		template <typename String>
+		static void AppendInfo(std::string& json, const BasicHardwareInfo<String>& info)
+		{
+			json += "{\"deviceName\":";
+			AppendString(json, info.DeviceName);
+			json += ",\"processor\":";
+			AppendString(json, info.Processor);
+			json += ",\"ram\":";
+			AppendString(json, info.RAM);
+			json += ",\"ramGB\":";
+			AppendNumber(json, info.RamGB);
+			json += ",\"gpu\":";
+			AppendString(json, info.GPU);
+			json += ",\"vram\":";
+			AppendString(json, info.VRAM);
+			json += ",\"vramGB\":";
+			AppendNumber(json, info.VramGB);
+			json += ",\"systemType\":";
+			AppendString(json, info.SystemType);
+			json += '}';
+		}
+
+		template <typename String>
+		static void AppendInfo(std::string& json, const BasicMacOSHardwareInfo<String>& info)
+		{
+			json += "{\"deviceName\":";
+			AppendString(json, info.DeviceName);
+			json += ",\"deviceYear\":";
+			AppendString(json, info.DeviceYear);
+			json += ",\"chip\":";
+			AppendString(json, info.Chip);
+			json += ",\"memory\":";
+			AppendString(json, info.Memory);
+			json += ",\"memoryGB\":";
+			AppendNumber(json, info.MemoryGB);
+			json += ",\"macOSVersion\":";
+			AppendString(json, info.MacOSVersion);
+			json += ",\"chipGeneration\":";
+			AppendNumber(json, info.ChipGeneration);
+			json += ",\"macOSMajorVersion\":";
+			AppendNumber(json, info.MacOSMajorVersion);
+			json += ",\"isAppleSilicon\":";
+			json += info.IsAppleSilicon ? "true" : "false";
+			json += ",\"isIntelMac\":";
+			json += info.IsIntelMac ? "true" : "false";
+			json += '}';
+		}
+
+		static void AppendString(std::string& json, std::wstring_view text)
+		{
+			json += '"';
+			size_t start = json.size();
+			Utf8::Append(json, text);
+
+			// Escape in place; only quotes, backslashes and control characters need it
+			for (size_t i = start; i < json.size(); i++)
+			{
+				unsigned char c = static_cast<unsigned char>(json[i]);
+				if (c == '"' || c == '\\')
+				{
+					json.insert(i, 1, '\\');
+					i++;
+				}
+				else if (c < 0x20)
+				{
+					static constexpr char Hex[] = "0123456789abcdef";
+					const char escape[] = { '\\', 'u', '0', '0', Hex[c >> 4], Hex[c & 0xF] };
+					json.replace(i, 1, escape, sizeof(escape));
+					i += sizeof(escape) - 1;
+				}
+			}
+			json += '"';
+		}
+
+		template <typename Number>
+		static void AppendNumber(std::string& json, Number value)
+		{
+			char buffer[32];
+			auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+			json.append(buffer, error == std::errc{} ? end : buffer);
+		}
+
+		static const char* StatusName(StatusLevel status)
+		{
+			switch (status)
+			{
+			case StatusLevel::Good:
+				return "good";
+			case StatusLevel::Warning:
+				return "warning";
+			default:
+				return "bad";
+			}
+		}
+
+	private:
+		template <typename Results>
+		static void AppendResults(std::string& json, const Results& results)
+		{
+			json += ",\"results\":[";
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				if (i > 0)
+					json += ',';
+				json += "{\"name\":";
+				AppendString(json, results[i].Name);
+				json += ",\"value\":";
+				AppendString(json, results[i].Value);
+				json += ",\"status\":\"";
+				json += StatusName(results[i].Status);
+				json += "\",\"reasonKey\":";
+				AppendString(json, results[i].ReasonKey);
+				json += '}';
+			}
+			json += ']';
+		}
+	};
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include "pch.h"
+#include "AsyncTask.h"
+#include "HardwareInfo.h"
+#include "MacOSHardwareInfo.h"
+#include "Tracing.h"
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace HardwareAnalyzer
+{
+	template <typename String>
+	struct BasicWindowsAnalysis
+	{
+		BasicHardwareInfo<String> Info;
+		BasicCheckResults<String> Results;
+		int Score = -1;
+	};
+
+	template <typename String>
+	struct BasicMacOSAnalysis
+	{
+		BasicMacOSHardwareInfo<String> Info;
+		BasicCheckResults<String> Results;
+		int Score = -1;
+	};
+
+	using WindowsAnalysis = BasicWindowsAnalysis<std::wstring>;
+	using MacOSAnalysis = BasicMacOSAnalysis<std::wstring>;
+
+	namespace pmr
+	{
+		using WindowsAnalysis = BasicWindowsAnalysis<std::pmr::wstring>;
+		using MacOSAnalysis = BasicMacOSAnalysis<std::pmr::wstring>;
+	}
+
+	// Parse -> analyze -> score for the OCR text of one screenshot, run on the executor's
+	// threads. The token is checked between stages, so a superseded job stops at the next
+	// boundary with TaskCanceled instead of finishing work nobody will look at.
+	class AnalysisPipeline
+	{
+	public:
+		// The same stages run inline on the calling thread, for callers with their own threads
+		static WindowsAnalysis AnalyzeWindowsText(const std::wstring& text)
+		{
+			WindowsAnalysis analysis;
+			analysis.Info = HardwareAnalyzerService::ParseOcrText(text);
+			analysis.Results = HardwareAnalyzerService::AnalyzeHardware(analysis.Info);
+			analysis.Score = HardwareAnalyzerService::CalculateGlobalScore(analysis.Results);
+			return analysis;
+		}
+
+		static MacOSAnalysis AnalyzeMacOSText(const std::wstring& text)
+		{
+			MacOSAnalysis analysis;
+			analysis.Info = MacOSHardwareAnalyzerService::ParseMacOSOcrText(text);
+			analysis.Results = MacOSHardwareAnalyzerService::AnalyzeMacOSHardware(analysis.Info);
+			analysis.Score = MacOSHardwareAnalyzerService::CalculateGlobalScore(analysis.Results);
+			return analysis;
+		}
+
+		// Same stages with every string and vector in 'arena', for workers that analyze a batch
+		// and then release the arena in one go. The parts are built in place and moved, never
+		// assigned, so nothing is copied out of the arena.
+		static pmr::WindowsAnalysis AnalyzeWindowsText(std::wstring_view text, std::pmr::memory_resource* arena)
+		{
+			pmr::HardwareInfo info = HardwareAnalyzerService::ParseOcrText(text, ParseLimits{}, arena);
+			pmr::CheckResults results = HardwareAnalyzerService::AnalyzeHardware(info);
+			int score = HardwareAnalyzerService::CalculateGlobalScore(results);
+			return { std::move(info), std::move(results), score };
+		}
+
+		static pmr::MacOSAnalysis AnalyzeMacOSText(std::wstring_view text, std::pmr::memory_resource* arena)
+		{
+			pmr::MacOSHardwareInfo info = MacOSHardwareAnalyzerService::ParseMacOSOcrText(text, ParseLimits{}, arena);
+			pmr::CheckResults results = MacOSHardwareAnalyzerService::AnalyzeMacOSHardware(info);
+			int score = MacOSHardwareAnalyzerService::CalculateGlobalScore(results);
+			return { std::move(info), std::move(results), score };
+		}
+
+		static Task<WindowsAnalysis> AnalyzeWindowsTextAsync(std::wstring text, CancellationToken token,
+			ThreadPoolExecutor& executor = ThreadPoolExecutor::Shared())
+		{
+			co_await executor.Schedule(token);
+
+			WindowsAnalysis analysis;
+			analysis.Info = HardwareAnalyzerService::ParseOcrText(text);
+			token.ThrowIfCancellationRequested();
+
+			analysis.Results = HardwareAnalyzerService::AnalyzeHardware(analysis.Info);
+			token.ThrowIfCancellationRequested();
+
+			analysis.Score = HardwareAnalyzerService::CalculateGlobalScore(analysis.Results);
+			co_return analysis;
+		}
+
+		static Task<MacOSAnalysis> AnalyzeMacOSTextAsync(std::wstring text, CancellationToken token,
+			ThreadPoolExecutor& executor = ThreadPoolExecutor::Shared())
+		{
+			co_await executor.Schedule(token);
+
+			MacOSAnalysis analysis;
+			analysis.Info = MacOSHardwareAnalyzerService::ParseMacOSOcrText(text);
+			token.ThrowIfCancellationRequested();
+
+			analysis.Results = MacOSHardwareAnalyzerService::AnalyzeMacOSHardware(analysis.Info);
+			token.ThrowIfCancellationRequested();
+
+			analysis.Score = MacOSHardwareAnalyzerService::CalculateGlobalScore(analysis.Results);
+			co_return analysis;
+		}
+	};
+}
@@ -4,6 +4,8 @@
 
 #include "App.xaml.h"
 #include "MainWindow.xaml.h"
+#include "OcrService.h"
+#include "LabelPack.h"
 
 using namespace winrt;
 using namespace winrt::Windows::Foundation;
@@ -42,8 +44,19 @@ namespace winrt::HardwareAnalyzer::implementation
 	/// <param name="e">Details about the launch request and process.</param>
 	void App::OnLaunched(const LaunchActivatedEventArgs&)
 	{
+		// Label packs in the Labels folder next to the executable add or update OCR label languages.
+		// They are only mapped here, so this costs next to nothing.
+		wchar_t modulePath[MAX_PATH]{};
+		if (GetModuleFileNameW(nullptr, modulePath, MAX_PATH))
+		{
+			auto labelDirectory = std::filesystem::path{ modulePath }.parent_path() / L"Labels";
+			::HardwareAnalyzer::LabelPack::SetActive(::HardwareAnalyzer::LabelPack::LoadDirectory(labelDirectory));
+		}
+
 		window = make<MainWindow>();
 		// window.Content().Measure(Size{100, 100});
 		window.Activate();
+
+		OcrService::WarmUpAsync();
 	}
 }
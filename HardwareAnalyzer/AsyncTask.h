@@ -0,0 +1,358 @@
+#pragma once
+#include "pch.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace HardwareAnalyzer
+{
+	// Thrown at a stage boundary when the job's token has been cancelled
+	struct TaskCanceled : std::exception
+	{
+		const char* what() const noexcept override { return "task canceled"; }
+	};
+
+	class CancellationToken
+	{
+	public:
+		CancellationToken() = default;   // Never cancelled
+
+		bool IsCancellationRequested() const
+		{
+			return m_state && m_state->load(std::memory_order_acquire);
+		}
+
+		void ThrowIfCancellationRequested() const
+		{
+			if (IsCancellationRequested())
+				throw TaskCanceled{};
+		}
+
+	private:
+		friend class CancellationSource;
+		explicit CancellationToken(std::shared_ptr<const std::atomic<bool>> state) : m_state(std::move(state)) {}
+
+		std::shared_ptr<const std::atomic<bool>> m_state;
+	};
+
+	class CancellationSource
+	{
+	public:
+		CancellationToken Token() const { return CancellationToken{ m_state }; }
+		void Cancel() { m_state->store(true, std::memory_order_release); }
+
+	private:
+		std::shared_ptr<std::atomic<bool>> m_state = std::make_shared<std::atomic<bool>>(false);
+	};
+
+	// "Latest wins" job slot: starting a job cancels the one before it, so a new image or a
+	// second click supersedes an analysis that is still in flight
+	class LatestJob
+	{
+	public:
+		CancellationToken Begin()
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_current.Cancel();
+			m_current = CancellationSource{};
+			return m_current.Token();
+		}
+
+		void Cancel()
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_current.Cancel();
+		}
+
+	private:
+		std::mutex m_lock;
+		CancellationSource m_current;
+	};
+
+	template <typename T = void>
+	class Task;
+
+	namespace Detail
+	{
+		struct TaskPromiseBase
+		{
+			std::coroutine_handle<> Continuation = std::noop_coroutine();
+			std::exception_ptr Error;
+
+			std::suspend_always initial_suspend() noexcept { return {}; }
+
+			// Resume whoever awaited the task, on the thread that finished it
+			struct FinalAwaiter
+			{
+				bool await_ready() noexcept { return false; }
+
+				template <typename Promise>
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+				{
+					return handle.promise().Continuation;
+				}
+
+				void await_resume() noexcept {}
+			};
+
+			FinalAwaiter final_suspend() noexcept { return {}; }
+			void unhandled_exception() noexcept { Error = std::current_exception(); }
+		};
+
+		template <typename T>
+		struct TaskPromise : TaskPromiseBase
+		{
+			std::optional<T> Value;
+
+			Task<T> get_return_object() noexcept;
+			void return_value(T value) { Value.emplace(std::move(value)); }
+
+			T TakeResult()
+			{
+				if (Error)
+					std::rethrow_exception(Error);
+				return std::move(*Value);
+			}
+		};
+
+		template <>
+		struct TaskPromise<void> : TaskPromiseBase
+		{
+			Task<void> get_return_object() noexcept;
+			void return_void() noexcept {}
+
+			void TakeResult()
+			{
+				if (Error)
+					std::rethrow_exception(Error);
+			}
+		};
+	}
+
+	// Lazy, move-only coroutine result. Nothing runs until the task is awaited; the awaiting
+	// coroutine then continues on whatever thread the task finishes on.
+	template <typename T>
+	class Task
+	{
+	public:
+		using promise_type = Detail::TaskPromise<T>;
+
+		Task() = default;
+		explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+		Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+
+		Task& operator=(Task&& other) noexcept
+		{
+			if (this != &other)
+			{
+				if (m_handle)
+					m_handle.destroy();
+				m_handle = std::exchange(other.m_handle, {});
+			}
+			return *this;
+		}
+
+		Task(const Task&) = delete;
+		Task& operator=(const Task&) = delete;
+
+		~Task()
+		{
+			if (m_handle)
+				m_handle.destroy();
+		}
+
+		auto operator co_await() && noexcept
+		{
+			struct Awaiter
+			{
+				std::coroutine_handle<promise_type> Handle;
+
+				bool await_ready() const noexcept { return !Handle || Handle.done(); }
+
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+				{
+					Handle.promise().Continuation = continuation;
+					return Handle;
+				}
+
+				T await_resume() { return Handle.promise().TakeResult(); }
+			};
+			return Awaiter{ m_handle };
+		}
+
+	private:
+		std::coroutine_handle<promise_type> m_handle;
+	};
+
+	namespace Detail
+	{
+		template <typename T>
+		Task<T> TaskPromise<T>::get_return_object() noexcept
+		{
+			return Task<T>{ std::coroutine_handle<TaskPromise<T>>::from_promise(*this) };
+		}
+
+		inline Task<void> TaskPromise<void>::get_return_object() noexcept
+		{
+			return Task<void>{ std::coroutine_handle<TaskPromise<void>>::from_promise(*this) };
+		}
+
+		// Eager coroutine that frees itself when it finishes; only used by SyncWait
+		struct DetachedTask
+		{
+			struct promise_type
+			{
+				DetachedTask get_return_object() noexcept { return {}; }
+				std::suspend_never initial_suspend() noexcept { return {}; }
+				std::suspend_never final_suspend() noexcept { return {}; }
+				void return_void() noexcept {}
+				void unhandled_exception() noexcept { std::terminate(); }
+			};
+		};
+	}
+
+	// Fixed set of worker threads running coroutine continuations in FIFO order.
+	// CPU-bound stages co_await Schedule() to leave the UI (or OCR completion) thread.
+	class ThreadPoolExecutor
+	{
+	public:
+		explicit ThreadPoolExecutor(unsigned threadCount = DefaultThreadCount())
+		{
+			for (unsigned i = 0; i < (std::max)(threadCount, 1u); i++)
+			{
+				m_threads.emplace_back([this] { WorkerLoop(); });
+			}
+		}
+
+		~ThreadPoolExecutor()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_lock);
+				m_stopping = true;
+			}
+			m_wake.notify_all();
+			for (auto& thread : m_threads)
+			{
+				thread.join();
+			}
+		}
+
+		ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+		ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+
+		// Process-wide pool for the analysis pipeline
+		static ThreadPoolExecutor& Shared()
+		{
+			static ThreadPoolExecutor executor;
+			return executor;
+		}
+
+		static unsigned DefaultThreadCount()
+		{
+			unsigned hardware = std::thread::hardware_concurrency();
+			return hardware > 1 ? hardware - 1 : 1;
+		}
+
+		// Resumes the awaiting coroutine on a pool thread, then throws TaskCanceled if the
+		// token was cancelled while it waited in the queue
+		auto Schedule(CancellationToken token = {})
+		{
+			struct ScheduleAwaiter
+			{
+				ThreadPoolExecutor& Executor;
+				CancellationToken Token;
+
+				bool await_ready() const noexcept { return false; }
+				void await_suspend(std::coroutine_handle<> handle) { Executor.Post(handle); }
+				void await_resume() const { Token.ThrowIfCancellationRequested(); }
+			};
+			return ScheduleAwaiter{ *this, std::move(token) };
+		}
+
+		void Post(std::coroutine_handle<> handle)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_lock);
+				m_queue.push_back(handle);
+			}
+			m_wake.notify_one();
+		}
+
+	private:
+		void WorkerLoop()
+		{
+			for (;;)
+			{
+				std::coroutine_handle<> handle;
+				{
+					std::unique_lock<std::mutex> lock(m_lock);
+					m_wake.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+					if (m_queue.empty())
+						return;   // Stopping and drained
+					handle = m_queue.front();
+					m_queue.pop_front();
+				}
+				handle.resume();
+			}
+		}
+
+		std::mutex m_lock;
+		std::condition_variable m_wake;
+		std::deque<std::coroutine_handle<>> m_queue;
+		bool m_stopping = false;
+		std::vector<std::thread> m_threads;
+	};
+
+	// Blocks the calling thread until the task completes and returns its result (or rethrows).
+	// For command-line tools and tests; never call it on the UI thread.
+	template <typename T>
+	T SyncWait(Task<T> task)
+	{
+		std::mutex lock;
+		std::condition_variable finished;
+		bool done = false;
+		std::exception_ptr error;
+		std::optional<std::conditional_t<std::is_void_v<T>, bool, T>> result;
+
+		auto run = [&]() -> Detail::DetachedTask {
+			try
+			{
+				if constexpr (std::is_void_v<T>)
+				{
+					co_await std::move(task);
+					result.emplace(true);
+				}
+				else
+				{
+					result.emplace(co_await std::move(task));
+				}
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+
+			std::lock_guard<std::mutex> guard(lock);
+			done = true;
+			finished.notify_one();
+		};
+		run();
+
+		std::unique_lock<std::mutex> guard(lock);
+		finished.wait(guard, [&] { return done; });
+		if (error)
+			std::rethrow_exception(error);
+		if constexpr (!std::is_void_v<T>)
+			return std::move(*result);
+	}
+}
@@ -0,0 +1,285 @@
+#pragma once
+#include "pch.h"
+#include "LabelCatalog.h"
+#include "LanguageIdentifier.h"
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace HardwareAnalyzer
+{
+	// Labels compiled into the app: what the parsers use when no label pack is installed,
+	// and the source LabelPack::Write exports to start a pack from.
+	class BuiltInLabels
+	{
+	public:
+		static constexpr uint32_t DataVersion = 1;
+
+		static std::shared_ptr<const LabelCatalog> Catalog()
+		{
+			static const std::shared_ptr<const LabelCatalog> catalog = Create();
+			return catalog;
+		}
+
+	private:
+		// Folded labels, '|' between alternatives. An empty unit list means DefaultRamUnits.
+		struct LanguageRow
+		{
+			std::wstring_view Tag;
+			WritingScript Script;
+			std::wstring_view Markers;
+			std::wstring_view Processor, InstalledRam, RamUnits;
+			std::wstring_view GraphicsCard, DeviceName, SystemType;
+			std::wstring_view GpuStopLabels;
+		};
+
+		static constexpr std::wstring_view DefaultRamUnits = L"gb|go|gib|tb|to";
+
+		static constexpr LanguageRow Languages[] = {
+			{ L"en", WritingScript::Latin, L"",
+				L"processor", L"installed ram", L"",
+				L"graphics card", L"device name", L"system type",
+				L"multiple|memory|processor|device name" },
+			{ L"fr", WritingScript::Latin, L"",
+				L"processeur", L"ram installee|ram installe|memoire ram installee|memoire ram installe", L"",
+				L"carte graphique", L"nom de l'appareil", L"type du systeme",
+				L"plusieurs|memoire|processeur|nom de" },
+			{ L"de", WritingScript::Latin, L"",
+				L"prozessor", L"installierter ram|installierter arbeitsspeicher", L"",
+				L"grafikkarte", L"geratename", L"systemtyp", L"" },
+			{ L"es", WritingScript::Latin, L"",
+				L"procesador", L"ram instalada|memoria ram", L"",
+				L"tarjeta grafica", L"nombre del dispositivo", L"tipo de sistema", L"" },
+			{ L"it", WritingScript::Latin, L"",
+				L"processore", L"ram installata", L"",
+				L"scheda grafica|scheda video", L"nome dispositivo", L"tipo sistema", L"" },
+			{ L"pt", WritingScript::Latin, L"",
+				L"processador", L"ram instalada", L"",
+				L"placa de video|placa grafica", L"nome do dispositivo", L"tipo de sistema", L"" },
+			{ L"nl", WritingScript::Latin, L"",
+				L"processor", L"geinstalleerd ram-geheugen|geinstalleerd ram|geinstalleerde ram", L"",
+				L"grafische kaart|videokaart", L"apparaatnaam", L"systeemtype", L"" },
+			{ L"pl", WritingScript::Latin, L"",
+				L"procesor", L"zainstalowana pamiec ram|zainstalowana pamiec", L"",
+				L"karta graficzna", L"nazwa urzadzenia", L"typ systemu", L"" },
+			{ L"sv", WritingScript::Latin, L"",
+				L"processor", L"installerat ram-minne|installerat ram", L"",
+				L"grafikkort", L"enhetsnamn", L"systemtyp", L"" },
+			{ L"da", WritingScript::Latin, L"",
+				L"processor", L"installeret ram", L"",
+				L"grafikkort", L"enhedsnavn", L"systemtype", L"" },
+			{ L"nb", WritingScript::Latin, L"",
+				L"prosessor", L"installert ram", L"",
+				L"skjermkort|grafikkort", L"enhetsnavn", L"systemtype", L"" },
+			{ L"fi", WritingScript::Latin, L"",
+				L"suoritin", L"asennettu ram-muisti|asennettu ram", L"gt|tt|gb|tb",
+				L"naytonohjain", L"laitteen nimi", L"jarjestelman tyyppi", L"" },
+			{ L"cs", WritingScript::Latin, L"",
+				L"procesor", L"nainstalovana pamet ram|nainstalovana pamet", L"",
+				L"graficka karta", L"nazev zarizeni", L"typ systemu", L"" },
+			{ L"sk", WritingScript::Latin, L"",
+				L"procesor", L"nainstalovana pamat ram|nainstalovana pamat", L"",
+				L"graficka karta", L"nazov zariadenia", L"typ systemu", L"" },
+			{ L"hu", WritingScript::Latin, L"",
+				L"processzor", L"telepitett ram", L"",
+				L"videokartya", L"eszkoz neve", L"rendszer tipusa", L"" },
+			{ L"ro", WritingScript::Latin, L"",
+				L"procesor", L"memorie ram instalata|ram instalata", L"",
+				L"placa grafica", L"nume dispozitiv", L"tip sistem", L"" },
+			{ L"tr", WritingScript::Latin, L"",
+				L"islemci", L"yuklu ram|yuklu bellek", L"",
+				L"ekran karti", L"cihaz adi", L"sistem turu", L"" },
+			{ L"ru", WritingScript::Cyrillic, L"\u044B\u044D\u044A\u0451",
+				L"\u043F\u0440\u043E\u0446\u0435\u0441\u0441\u043E\u0440", L"\u043E\u043F\u0435\u0440\u0430\u0442\u0438\u0432\u043D\u0430\u044F \u043F\u0430\u043C\u044F\u0442\u044C|\u0443\u0441\u0442\u0430\u043D\u043E\u0432\u043B\u0435\u043D\u043D\u0430\u044F \u043F\u0430\u043C\u044F\u0442\u044C (\u043E\u0437\u0443)|\u0443\u0441\u0442\u0430\u043D\u043E\u0432\u043B\u0435\u043D\u043D\u0430\u044F \u043F\u0430\u043C\u044F\u0442\u044C", L"\u0433\u0431|\u0442\u0431",
+				L"\u0432\u0438\u0434\u0435\u043E\u043A\u0430\u0440\u0442\u0430", L"\u0438\u043C\u044F \u0443\u0441\u0442\u0440\u043E\u0439\u0441\u0442\u0432\u0430", L"\u0442\u0438\u043F \u0441\u0438\u0441\u0442\u0435\u043C\u044B", L"" },
+			{ L"uk", WritingScript::Cyrillic, L"\u0456\u0457\u0454\u0491",
+				L"\u043F\u0440\u043E\u0446\u0435\u0441\u043E\u0440", L"\u0432\u0441\u0442\u0430\u043D\u043E\u0432\u043B\u0435\u043D\u0430 \u043E\u043F\u0435\u0440\u0430\u0442\u0438\u0432\u043D\u0430 \u043F\u0430\u043C'\u044F\u0442\u044C|\u043E\u043F\u0435\u0440\u0430\u0442\u0438\u0432\u043D\u0430 \u043F\u0430\u043C'\u044F\u0442\u044C|\u0432\u0441\u0442\u0430\u043D\u043E\u0432\u043B\u0435\u043D\u0430 \u043F\u0430\u043C'\u044F\u0442\u044C", L"\u0433\u0431|\u0442\u0431",
+				L"\u0432\u0456\u0434\u0435\u043E\u043A\u0430\u0440\u0442\u0430", L"\u0456\u043C'\u044F \u043F\u0440\u0438\u0441\u0442\u0440\u043E\u044E", L"\u0442\u0438\u043F \u0441\u0438\u0441\u0442\u0435\u043C\u0438", L"" },
+			{ L"el", WritingScript::Greek, L"",
+				L"\u03B5\u03C0\u03B5\u03BE\u03B5\u03C1\u03B3\u03B1\u03C3\u03C4\u03B7\u03C3", L"\u03B5\u03B3\u03BA\u03B1\u03C4\u03B5\u03C3\u03C4\u03B7\u03BC\u03B5\u03BD\u03B7 \u03BC\u03BD\u03B7\u03BC\u03B7 ram|\u03B5\u03B3\u03BA\u03B1\u03C4\u03B5\u03C3\u03C4\u03B7\u03BC\u03B5\u03BD\u03B7 \u03BC\u03BD\u03B7\u03BC\u03B7", L"",
+				L"\u03BA\u03B1\u03C1\u03C4\u03B1 \u03B3\u03C1\u03B1\u03C6\u03B9\u03BA\u03C9\u03BD", L"\u03BF\u03BD\u03BF\u03BC\u03B1 \u03C3\u03C5\u03C3\u03BA\u03B5\u03C5\u03B7\u03C3", L"\u03C4\u03C5\u03C0\u03BF\u03C3 \u03C3\u03C5\u03C3\u03C4\u03B7\u03BC\u03B1\u03C4\u03BF\u03C3", L"" },
+			{ L"ja", WritingScript::Kana, L"",
+				L"\u30D7\u30ED\u30BB\u30C3\u30B5", L"\u5B9F\u88C5 ram", L"",
+				L"\u30B0\u30E9\u30D5\u30A3\u30C3\u30AF\u30B9 \u30AB\u30FC\u30C9", L"\u30C7\u30D0\u30A4\u30B9\u540D", L"\u30B7\u30B9\u30C6\u30E0\u306E\u7A2E\u985E", L"" },
+			{ L"zh", WritingScript::Han, L"",
+				L"\u5904\u7406\u5668", L"\u673A\u5E26 ram", L"",
+				L"\u663E\u5361", L"\u8BBE\u5907\u540D\u79F0", L"\u7CFB\u7EDF\u7C7B\u578B", L"" },
+			{ L"ko", WritingScript::Hangul, L"",
+				L"\uD504\uB85C\uC138\uC11C", L"\uC124\uCE58\uB41C ram", L"",
+				L"\uADF8\uB798\uD53D \uCE74\uB4DC", L"\uB514\uBC14\uC774\uC2A4 \uC774\uB984|\uC7A5\uCE58 \uC774\uB984", L"\uC2DC\uC2A4\uD15C \uC885\uB958", L"" },
+		};
+
+		// macOS shows model and release names untranslated; only the memory unit is localized
+		struct MacRow
+		{
+			std::wstring_view Tag;
+			std::wstring_view DeviceModels, MemoryUnits, VersionNames;
+		};
+
+		static constexpr MacRow MacLanguages[] = {
+			{ L"en", L"macbook pro|macbook air|imac|mac mini|mac studio|mac pro", L"gb",
+				L"sonoma|sequoia|ventura|monterey|big sur|catalina|mojave|high sierra|sierra|tahoe" },
+			{ L"fr", L"", L"go", L"" },
+		};
+
+		// Folded text of the Windows "About" and System Information pages in each Latin-script
+		// language. The trigram profiles LanguageIdentifier scores against are built from it.
+		struct SeedRow
+		{
+			std::wstring_view Tag;
+			std::wstring_view Text;
+		};
+
+		static constexpr SeedRow Seeds[] = {
+			{ L"en",
+				L"device specifications device name processor installed ram device id product id system type "
+				L"pen and touch no pen or touch input is available for this display windows specifications edition "
+				L"version installed on os build experience bit operating system based processor graphics card "
+				L"storage related links domain or workgroup system protection advanced system settings" },
+			{ L"fr",
+				L"specifications de l'appareil nom de l'appareil processeur memoire ram installee id de peripherique "
+				L"id de produit type du systeme stylet et fonction tactile la fonctionnalite d'entree tactile ou avec "
+				L"un stylet n'est pas disponible sur cet ecran specifications de windows edition version installe le "
+				L"version du systeme d'exploitation experience systeme d'exploitation bits processeur carte graphique "
+				L"stockage liens associes domaine ou groupe de travail protection du systeme parametres avances du systeme" },
+			{ L"de",
+				L"geratespezifikationen geratename prozessor installierter ram gerate-id produkt-id systemtyp stift- "
+				L"und toucheingabe fur diese anzeige ist keine stift- oder toucheingabe verfugbar windows-spezifikationen "
+				L"edition version installiert am betriebssystembuild leistung bit-betriebssystem basierter prozessor "
+				L"grafikkarte speicher verwandte links domane oder arbeitsgruppe computerschutz erweiterte systemeinstellungen" },
+			{ L"es",
+				L"especificaciones del dispositivo nombre del dispositivo procesador memoria ram instalada id del "
+				L"dispositivo id del producto tipo de sistema lapiz y entrada tactil la entrada tactil o manuscrita no "
+				L"esta disponible para esta pantalla especificaciones de windows edicion version instalado el compilacion "
+				L"del sistema operativo experiencia sistema operativo de bits procesador basado en tarjeta grafica "
+				L"almacenamiento vinculos relacionados dominio o grupo de trabajo proteccion del sistema configuracion avanzada" },
+			{ L"it",
+				L"specifiche dispositivo nome dispositivo processore ram installata id dispositivo id prodotto tipo "
+				L"sistema penna e tocco nessun input penna o tocco disponibile per questo schermo specifiche di windows "
+				L"edizione versione data installazione build sistema operativo esperienza sistema operativo a bit "
+				L"processore basato su scheda grafica archiviazione collegamenti correlati dominio o gruppo di lavoro "
+				L"protezione sistema impostazioni di sistema avanzate" },
+			{ L"pt",
+				L"especificacoes do dispositivo nome do dispositivo processador ram instalada id do dispositivo id do "
+				L"produto tipo de sistema caneta e toque nenhuma entrada de caneta ou toque esta disponivel para este "
+				L"video especificacoes do windows edicao versao instalado em compilacao do sistema operacional "
+				L"experiencia sistema operacional de bits processador baseado em placa de video armazenamento links "
+				L"relacionados dominio ou grupo de trabalho protecao do sistema configuracoes avancadas do sistema" },
+			{ L"nl",
+				L"apparaatspecificaties apparaatnaam processor geinstalleerd ram-geheugen apparaat-id product-id "
+				L"systeemtype pen en aanraken voor dit beeldscherm is geen pen- of aanraakinvoer beschikbaar "
+				L"windows-specificaties editie versie geinstalleerd op build van besturingssysteem ervaring bits "
+				L"besturingssysteem processor grafische kaart opslag gerelateerde koppelingen domein of werkgroep "
+				L"systeembeveiliging geavanceerde systeeminstellingen" },
+			{ L"pl",
+				L"specyfikacje urzadzenia nazwa urzadzenia procesor zainstalowana pamiec ram identyfikator urzadzenia "
+				L"identyfikator produktu typ systemu piorko i dotyk dla tego ekranu nie jest dostepne wprowadzanie za "
+				L"pomoca piora ani dotyku specyfikacje systemu windows wersja zainstalowano kompilacja systemu "
+				L"operacyjnego srodowisko bitowy system operacyjny procesor oparty na architekturze karta graficzna "
+				L"magazyn powiazane linki domena lub grupa robocza ochrona systemu zaawansowane ustawienia systemu" },
+			{ L"sv",
+				L"enhetsspecifikationer enhetsnamn processor installerat ram-minne enhets-id produkt-id systemtyp "
+				L"penna och pekfunktioner ingen penn- eller pekinmatning ar tillganglig for den har skarmen "
+				L"windows-specifikationer utgava version installerades operativsystemversion upplevelse bitars "
+				L"operativsystem baserad processor grafikkort lagring relaterade lankar doman eller arbetsgrupp "
+				L"systemskydd avancerade systeminstallningar" },
+			{ L"da",
+				L"enhedsspecifikationer enhedsnavn processor installeret ram enheds-id produkt-id systemtype pen og "
+				L"touch der er ingen pen- eller touchinput tilgangelig for denne skarm windows-specifikationer udgave "
+				L"version installeret den operativsystembuild oplevelse bit-operativsystem baseret processor grafikkort "
+				L"lager relaterede links domane eller arbejdsgruppe systembeskyttelse avancerede systemindstillinger" },
+			{ L"nb",
+				L"enhetsspesifikasjoner enhetsnavn prosessor installert ram enhets-id produkt-id systemtype penn og "
+				L"beroring ingen penn- eller beroringsinndata er tilgjengelig for denne skjermen windows-spesifikasjoner "
+				L"utgave versjon installert operativsystembygg opplevelse biters operativsystem basert prosessor "
+				L"skjermkort lagring relaterte koblinger domene eller arbeidsgruppe systembeskyttelse avanserte "
+				L"systeminnstillinger" },
+			{ L"fi",
+				L"laitteen tiedot laitteen nimi suoritin asennettu ram-muisti laitetunnus tuotetunnus jarjestelman "
+				L"tyyppi kyna ja kosketus tassa naytossa ei ole kyna- tai kosketussyotetta windowsin tiedot versio "
+				L"asennettu kayttojarjestelman koontiversio kokemus bittinen kayttojarjestelma pohjainen suoritin "
+				L"naytonohjain tallennustila aiheeseen liittyvat linkit toimialue tai tyoryhma jarjestelman suojaus "
+				L"jarjestelman lisaasetukset" },
+			{ L"cs",
+				L"specifikace zarizeni nazev zarizeni procesor nainstalovana pamet ram id zarizeni id produktu typ "
+				L"systemu pero a dotykove ovladani pro tento displej neni k dispozici zadne pero ani dotykovy vstup "
+				L"specifikace windows edice verze datum instalace build operacniho systemu prostredi bitovy operacni "
+				L"system procesor graficka karta uloziste souvisejici odkazy domena nebo pracovni skupina ochrana "
+				L"systemu upresnit nastaveni systemu" },
+			{ L"sk",
+				L"specifikacie zariadenia nazov zariadenia procesor nainstalovana pamat ram identifikacia zariadenia "
+				L"identifikacia produktu typ systemu pero a dotykove ovladanie pre tuto obrazovku nie je k dispozicii "
+				L"pero ani dotykovy vstup specifikacie systemu windows vydanie verzia nainstalovane zostava operacneho "
+				L"systemu prostredie bitovy operacny system procesor graficka karta ukladaci priestor suvisiace "
+				L"prepojenia domena alebo pracovna skupina ochrana systemu rozsirene nastavenia systemu" },
+			{ L"hu",
+				L"eszkoz muszaki adatai eszkoz neve processzor telepitett ram eszkozazonosito termekazonosito "
+				L"rendszer tipusa toll es erintes ehhez a kijelzohoz nem erheto el tollal vagy erintessel torteno "
+				L"bevitel windows muszaki adatai kiadas verzio telepitve operacios rendszer buildje felhasznaloi "
+				L"elmeny bites operacios rendszer alapu processzor videokartya tarhely kapcsolodo hivatkozasok "
+				L"tartomany vagy munkacsoport rendszervedelem specialis rendszerbeallitasok" },
+			{ L"ro",
+				L"specificatii dispozitiv nume dispozitiv procesor memorie ram instalata id dispozitiv id produs tip "
+				L"sistem stilou si atingere nu este disponibila nicio intrare prin stilou sau atingere pentru acest "
+				L"afisaj specificatii windows editie versiune instalat pe versiune sistem de operare experienta sistem "
+				L"de operare pe de biti procesor bazat pe placa grafica stocare linkuri asociate domeniu sau grup de "
+				L"lucru protectia sistemului setari complexe de sistem" },
+			{ L"tr",
+				L"cihaz belirtimleri cihaz adi islemci yuklu ram cihaz kimligi urun kimligi sistem turu kalem ve "
+				L"dokunma bu ekran icin kalem veya dokunma girdisi yok windows belirtimleri surum yuklenme tarihi "
+				L"isletim sistemi derlemesi deneyim bit isletim sistemi tabanli islemci ekran karti depolama ilgili "
+				L"baglantilar etki alani veya calisma grubu sistem korumasi gelismis sistem ayarlari" },
+		};
+
+		static std::shared_ptr<const LabelCatalog> Create()
+		{
+			LabelCatalog::Contents contents;
+			contents.DataVersion = DataVersion;
+
+			for (const auto& row : Languages)
+			{
+				LanguageLabels language;
+				language.Tag = row.Tag;
+				language.Script = row.Script;
+				language.Markers = row.Markers;
+				auto set = [&](LabelField field, std::wstring_view labels) {
+					language.Fields[static_cast<size_t>(field)] = LabelCatalog::Split(labels);
+				};
+				set(LabelField::Processor, row.Processor);
+				set(LabelField::InstalledRam, row.InstalledRam);
+				set(LabelField::RamUnits, row.RamUnits.empty() ? DefaultRamUnits : row.RamUnits);
+				set(LabelField::GraphicsCard, row.GraphicsCard);
+				set(LabelField::DeviceName, row.DeviceName);
+				set(LabelField::SystemType, row.SystemType);
+				set(LabelField::GpuStopLabels, row.GpuStopLabels);
+
+				for (const auto& mac : MacLanguages)
+				{
+					if (mac.Tag == row.Tag)
+					{
+						set(LabelField::MacDeviceModels, mac.DeviceModels);
+						set(LabelField::MacMemoryUnits, mac.MemoryUnits);
+						set(LabelField::MacVersionNames, mac.VersionNames);
+					}
+				}
+				contents.Languages.push_back(std::move(language));
+			}
+
+			std::vector<std::wstring_view> seedTexts;
+			for (const auto& seed : Seeds)
+			{
+				for (size_t index = 0; index < contents.Languages.size(); index++)
+				{
+					if (contents.Languages[index].Tag == seed.Tag)
+					{
+						contents.TrigramLanguages.push_back(index);
+						seedTexts.push_back(seed.Text);
+					}
+				}
+			}
+			contents.OwnedTrigramMasks = LanguageIdentifier::BuildProfiles(seedTexts);
+
+			return std::make_shared<const LabelCatalog>(std::move(contents));
+		}
+	};
+}
@@ -0,0 +1,783 @@
+#pragma once
+#include "pch.h"
+#include "HardwareInfo.h"
+#include "QuantityParser.h"
+#include "Tracing.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace HardwareAnalyzer
+{
+	// HardwareInfo from the exports users can attach instead of a screenshot:
+	//   - dxdiag /t      "      Processor: ..." lines under "------\nSystem Information\n------"
+	//   - msinfo32 /report   "Processor<TAB>..." lines under "[System Summary]", UTF-16
+	//   - dxdiag /x      <DxDiag><SystemInformation><Processor>...
+	//   - msinfo32 .nfo  <Category name="System Summary"><Data><Item>Processor</Item><Value>...
+	// Those are exact, so neither OCR normalization nor the regex rules are involved.
+	//
+	// Bytes are pushed through Feed() in any chunking and read in one forward pass: UTF-16
+	// is transcoded a piece at a time, text is split at newlines found with memchr, and XML
+	// goes through a small tag state machine. Memory stays bounded whatever the report's
+	// size: one partial line or element (MaxLine) and at most MaxAdapters adapters.
+	//
+	// Field names are the English ones: dxdiag and the XML formats always use them, a
+	// msinfo32 report uses the UI language.
+	class DiagnosticsReportParser
+	{
+	public:
+		enum class Format : uint8_t
+		{
+			Unknown,
+			DxDiagText,
+			MsInfoText,
+			DxDiagXml,
+			MsInfoXml
+		};
+
+		struct DisplayAdapter
+		{
+			std::wstring Name;
+			std::wstring Dedicated;     // As written ("8018 MB")
+			double DedicatedGB = 0;
+		};
+
+		static constexpr size_t MaxLine = 4096;     // Longer lines (driver file lists) are skipped
+		static constexpr size_t MaxAdapters = 16;
+
+		void Feed(std::string_view bytes)
+		{
+			if (m_encoding == Encoding::Unknown)
+			{
+				// Three bytes tell UTF-16 and a UTF-8 BOM from the rest
+				size_t take = (std::min)(bytes.size(), 3 - m_head.size());
+				m_head.append(bytes.substr(0, take));
+				bytes.remove_prefix(take);
+				if (m_head.size() < 3)
+					return;
+				StartAfterHead();
+			}
+			Convert(bytes);
+		}
+
+		// The info of everything fed so far; the parser is done after this
+		HardwareInfo Finish()
+		{
+			if (m_encoding == Encoding::Unknown && !m_head.empty())
+				StartAfterHead();
+			if (m_mode == Mode::Text && !m_line.empty() && !m_lineTooLong)
+				HandleLine(m_line);
+			m_line.clear();
+
+			if (m_info.SystemType.empty())
+				m_info.SystemType = std::move(m_operatingSystem);
+
+			// The adapter with the most dedicated memory, like the Linux probe; Microsoft's
+			// basic and remote display drivers only if nothing else is there
+			const DisplayAdapter* best = nullptr;
+			for (const DisplayAdapter& adapter : m_adapters)
+			{
+				bool generic = adapter.Name.starts_with(L"Microsoft ");
+				bool bestGeneric = best && best->Name.starts_with(L"Microsoft ");
+				if (!best || (bestGeneric && !generic) || (bestGeneric == generic && adapter.DedicatedGB > best->DedicatedGB))
+					best = &adapter;
+			}
+			if (best)
+			{
+				m_info.GPU = best->Name;
+				m_info.VRAM = best->Dedicated;
+				m_info.VramGB = best->DedicatedGB;
+			}
+			return std::move(m_info);
+		}
+
+		Format DetectedFormat() const { return m_format; }
+		const std::vector<DisplayAdapter>& Adapters() const { return m_adapters; }
+
+		// Reads the file in 64 KB chunks; false when it can't be read or isn't a report
+		static bool ParseFile(const std::filesystem::path& path, HardwareInfo& info, Format* format = nullptr)
+		{
+			TraceSpan span{ "ParseDiagnosticsReport" };
+			std::ifstream file(path, std::ios::binary);
+			if (!file)
+				return false;
+
+			DiagnosticsReportParser parser;
+			std::vector<char> chunk(64 * 1024);
+			while (file.read(chunk.data(), static_cast<std::streamsize>(chunk.size())) || file.gcount() > 0)
+			{
+				parser.Feed({ chunk.data(), static_cast<size_t>(file.gcount()) });
+			}
+			info = parser.Finish();
+			if (format)
+				*format = parser.DetectedFormat();
+			return parser.DetectedFormat() != Format::Unknown;
+		}
+
+	private:
+		enum class Encoding : uint8_t { Unknown, Narrow, Utf16LE, Utf16BE };
+		enum class Mode : uint8_t { Undecided, Text, Xml };
+		enum class XmlState : uint8_t { Text, Tag, CData, Comment };
+		enum class Section : uint8_t { None, System, Display, Other };
+
+		static constexpr size_t MaxDepth = 32;
+
+		Encoding m_encoding = Encoding::Unknown;
+		std::string m_head;             // First three bytes, until the encoding is known
+		std::string m_utf8;             // Transcoded UTF-16 piece
+		uint8_t m_oddByte = 0;          // First half of a UTF-16 unit split across chunks
+		bool m_hasOddByte = false;
+		uint16_t m_highSurrogate = 0;
+
+		Mode m_mode = Mode::Undecided;
+		Format m_format = Format::Unknown;
+		Section m_section = Section::None;
+
+		// Text
+		std::string m_line;             // Partial line carried to the next chunk
+		bool m_lineTooLong = false;
+		bool m_afterRule = false;       // The previous line was dxdiag's "-----" above a title
+
+		// XML
+		XmlState m_xmlState = XmlState::Text;
+		std::string m_tag;
+		std::string m_text;
+		std::string m_itemKey;          // msinfo's <Item> waiting for its <Value>
+		size_t m_closeMatched = 0;      // Characters of "]]>" or "-->" seen
+		size_t m_depth = 0;
+		std::array<Section, MaxDepth> m_sections{};
+
+		HardwareInfo m_info;
+		std::wstring m_operatingSystem;
+		std::vector<DisplayAdapter> m_adapters;
+
+		void StartAfterHead()
+		{
+			auto byte = [&](size_t i) { return i < m_head.size() ? static_cast<uint8_t>(m_head[i]) : 0; };
+			size_t bom = 0;
+			if (byte(0) == 0xFF && byte(1) == 0xFE)
+			{
+				m_encoding = Encoding::Utf16LE;
+				bom = 2;
+			}
+			else if (byte(0) == 0xFE && byte(1) == 0xFF)
+			{
+				m_encoding = Encoding::Utf16BE;
+				bom = 2;
+			}
+			else if (byte(0) == 0xEF && byte(1) == 0xBB && byte(2) == 0xBF)
+			{
+				m_encoding = Encoding::Narrow;
+				bom = 3;
+			}
+			else
+			{
+				// msinfo32 reports without a BOM still start with an ASCII character
+				m_encoding = m_head.size() >= 2 && byte(0) != 0 && byte(1) == 0 ? Encoding::Utf16LE : Encoding::Narrow;
+			}
+
+			std::string head = std::move(m_head);
+			m_head.clear();
+			Convert(std::string_view(head).substr((std::min)(bom, head.size())));
+		}
+
+		void Convert(std::string_view bytes)
+		{
+			if (m_encoding == Encoding::Narrow)
+			{
+				Scan(bytes);
+				return;
+			}
+
+			// UTF-16 to UTF-8 in pieces, so the scratch buffer doesn't grow with the chunk
+			constexpr size_t Piece = 16 * 1024;
+			while (!bytes.empty())
+			{
+				std::string_view piece = bytes.substr(0, Piece);
+				bytes.remove_prefix(piece.size());
+				Transcode(piece);
+				Scan(m_utf8);
+			}
+		}
+
+		void Transcode(std::string_view bytes)
+		{
+			// At most 4 bytes of UTF-8 per unit: 3 for a BMP character, 4 for the low half of
+			// a pair whose high half came in the previous piece
+			m_utf8.resize(bytes.size() / 2 * 4 + 4);
+			char* out = m_utf8.data();
+			size_t i = 0;
+			if (m_hasOddByte && !bytes.empty())
+			{
+				m_hasOddByte = false;
+				out = Unit(m_oddByte, static_cast<uint8_t>(bytes[0]), out);
+				i = 1;
+			}
+			bool little = m_encoding == Encoding::Utf16LE;
+			for (; i + 1 < bytes.size(); i += 2)
+			{
+				uint8_t first = static_cast<uint8_t>(bytes[i]);
+				uint8_t second = static_cast<uint8_t>(bytes[i + 1]);
+				// ASCII, nearly all of a report
+				if ((little ? second : first) == 0 && (little ? first : second) < 0x80 && m_highSurrogate == 0)
+					*out++ = static_cast<char>(little ? first : second);
+				else
+					out = Unit(first, second, out);
+			}
+			if (i < bytes.size())
+			{
+				m_oddByte = static_cast<uint8_t>(bytes[i]);
+				m_hasOddByte = true;
+			}
+			m_utf8.resize(static_cast<size_t>(out - m_utf8.data()));
+		}
+
+		char* Unit(uint8_t first, uint8_t second, char* out)
+		{
+			uint32_t c = m_encoding == Encoding::Utf16LE ? (first | (uint32_t{ second } << 8)) : ((uint32_t{ first } << 8) | second);
+			if (c >= 0xD800 && c < 0xDC00)
+			{
+				m_highSurrogate = static_cast<uint16_t>(c);
+				return out;
+			}
+			if (c >= 0xDC00 && c < 0xE000)
+			{
+				if (m_highSurrogate == 0)
+					return out;
+				c = 0x10000 + ((uint32_t{ m_highSurrogate } - 0xD800) << 10) + (c - 0xDC00);
+			}
+			m_highSurrogate = 0;
+
+			if (c < 0x80)
+			{
+				*out++ = static_cast<char>(c);
+			}
+			else if (c < 0x800)
+			{
+				*out++ = static_cast<char>(0xC0 | (c >> 6));
+				*out++ = static_cast<char>(0x80 | (c & 0x3F));
+			}
+			else if (c < 0x10000)
+			{
+				*out++ = static_cast<char>(0xE0 | (c >> 12));
+				*out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+				*out++ = static_cast<char>(0x80 | (c & 0x3F));
+			}
+			else
+			{
+				*out++ = static_cast<char>(0xF0 | (c >> 18));
+				*out++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+				*out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+				*out++ = static_cast<char>(0x80 | (c & 0x3F));
+			}
+			return out;
+		}
+
+		void Scan(std::string_view data)
+		{
+			if (m_mode == Mode::Undecided)
+			{
+				// The first character that isn't blank: '<' is XML, anything else text
+				size_t first = data.find_first_not_of(" \t\r\n");
+				if (first == std::string_view::npos)
+					return;
+				data.remove_prefix(first);
+				m_mode = data[0] == '<' ? Mode::Xml : Mode::Text;
+			}
+			if (m_mode == Mode::Text)
+				ScanText(data);
+			else
+				ScanXml(data);
+		}
+
+		void ScanText(std::string_view data)
+		{
+			while (!data.empty())
+			{
+				const char* newline = static_cast<const char*>(std::memchr(data.data(), '\n', data.size()));
+				size_t length = newline ? static_cast<size_t>(newline - data.data()) : data.size();
+				if (!newline)
+				{
+					CarryLine(data.substr(0, length));
+					return;
+				}
+
+				if (m_line.empty() && !m_lineTooLong)
+				{
+					// The usual case: the whole line is in this chunk, no copy
+					if (length <= MaxLine)
+						HandleLine(data.substr(0, length));
+				}
+				else
+				{
+					CarryLine(data.substr(0, length));
+					if (!m_lineTooLong)
+						HandleLine(m_line);
+					m_line.clear();
+					m_lineTooLong = false;
+				}
+				data.remove_prefix(length + 1);
+			}
+		}
+
+		void CarryLine(std::string_view part)
+		{
+			if (m_lineTooLong || m_line.size() + part.size() > MaxLine)
+			{
+				m_line.clear();
+				m_lineTooLong = true;
+				return;
+			}
+			m_line.append(part);
+		}
+
+		void HandleLine(std::string_view line)
+		{
+			std::string_view trimmed = Trim(line);
+			if (trimmed.empty())
+				return;
+
+			if (trimmed.find_first_not_of('-') == std::string_view::npos)
+			{
+				m_afterRule = true;
+				return;
+			}
+			bool afterRule = m_afterRule;
+			m_afterRule = false;
+
+			if (trimmed.front() == '[' && trimmed.back() == ']')
+			{
+				SetFormat(Format::MsInfoText);
+				m_section = SectionOf(trimmed.substr(1, trimmed.size() - 2));
+				return;
+			}
+
+			size_t tab = line.find('\t');
+			if (tab != std::string_view::npos)
+			{
+				Field(Trim(line.substr(0, tab)), Trim(line.substr(tab + 1)), false);
+				return;
+			}
+
+			size_t colon = line.find(':');
+			if (colon == std::string_view::npos)
+			{
+				// dxdiag's section titles sit between two rules
+				if (afterRule)
+				{
+					SetFormat(Format::DxDiagText);
+					m_section = SectionOf(trimmed);
+				}
+				return;
+			}
+			Field(Trim(line.substr(0, colon)), Trim(line.substr(colon + 1)), false);
+		}
+
+		void ScanXml(std::string_view data)
+		{
+			size_t i = 0;
+			while (i < data.size())
+			{
+				switch (m_xmlState)
+				{
+				case XmlState::Text:
+				{
+					const char* open = static_cast<const char*>(std::memchr(data.data() + i, '<', data.size() - i));
+					size_t end = open ? static_cast<size_t>(open - data.data()) : data.size();
+					AppendBounded(m_text, data.substr(i, end - i));
+					if (!open)
+						return;
+					m_xmlState = XmlState::Tag;
+					m_tag.clear();
+					i = end + 1;
+					break;
+				}
+				case XmlState::Tag:
+				{
+					// Character by character while the tag could still turn out to be
+					// "<![CDATA[" or "<!--", whose content may hold '>'
+					if (m_tag.empty() || (m_tag[0] == '!' && m_tag.size() < 8))
+					{
+						char c = data[i++];
+						if (c == '>')
+						{
+							HandleTag();
+							continue;
+						}
+						m_tag += c;
+						if (m_tag == "![CDATA[")
+						{
+							m_xmlState = XmlState::CData;
+							m_closeMatched = 0;
+						}
+						else if (m_tag == "!--")
+						{
+							m_xmlState = XmlState::Comment;
+							m_closeMatched = 0;
+						}
+						continue;
+					}
+					const char* close = static_cast<const char*>(std::memchr(data.data() + i, '>', data.size() - i));
+					size_t end = close ? static_cast<size_t>(close - data.data()) : data.size();
+					AppendBounded(m_tag, data.substr(i, end - i));
+					if (!close)
+						return;
+					i = end + 1;
+					HandleTag();
+					break;
+				}
+				case XmlState::CData:
+				case XmlState::Comment:
+				{
+					// Up to "]]>" or "-->"; CDATA is text, a comment is dropped
+					bool cdata = m_xmlState == XmlState::CData;
+					char mark = cdata ? ']' : '-';
+					if (m_closeMatched == 0)
+					{
+						// Straight to the next mark; what's before it is content
+						const char* found = static_cast<const char*>(std::memchr(data.data() + i, mark, data.size() - i));
+						size_t end = found ? static_cast<size_t>(found - data.data()) : data.size();
+						if (cdata)
+							AppendBounded(m_text, data.substr(i, end - i));
+						i = end;
+						if (!found)
+							return;
+					}
+					char c = data[i++];
+					if (c == mark && m_closeMatched < 2)
+					{
+						m_closeMatched++;
+						continue;
+					}
+					if (c == '>' && m_closeMatched == 2)
+					{
+						m_xmlState = XmlState::Text;
+						continue;
+					}
+					if (cdata)
+					{
+						// Marks that didn't end it were content; a third one shifts the window
+						size_t held = c == mark ? 1 : m_closeMatched;
+						AppendBounded(m_text, std::string_view("]]", held));
+						if (c != mark)
+							AppendBounded(m_text, std::string_view(&c, 1));
+					}
+					m_closeMatched = c == mark ? 2 : 0;
+					break;
+				}
+				}
+			}
+		}
+
+		void HandleTag()
+		{
+			m_xmlState = XmlState::Text;
+			std::string_view tag = m_tag;
+			if (tag.empty() || tag[0] == '?' || tag[0] == '!')
+				return;
+
+			if (tag[0] == '/')
+			{
+				EndElement(Trim(tag.substr(1)));
+				return;
+			}
+
+			bool selfClosing = tag.back() == '/';
+			size_t nameEnd = tag.find_first_of(" \t\r\n/");
+			std::string_view name = tag.substr(0, nameEnd);
+			StartElement(name, tag);
+			if (selfClosing)
+				EndElement(name);
+		}
+
+		void StartElement(std::string_view name, std::string_view tag)
+		{
+			m_text.clear();
+			Section section = m_depth == 0 ? Section::None : m_sections[(std::min)(m_depth, MaxDepth) - 1];
+			if (m_depth == 0)
+			{
+				SetFormat(name == "DxDiag" ? Format::DxDiagXml : name == "MsInfo" ? Format::MsInfoXml : Format::Unknown);
+			}
+			else if (name == "Category")
+			{
+				// msinfo: <Category name="Display">
+				section = SectionOf(Attribute(tag, "name"));
+			}
+			else if (m_depth == 1)
+			{
+				// dxdiag: <SystemInformation>, <DisplayDevices>, ... under <DxDiag>
+				section = SectionOf(name);
+			}
+			if (m_depth < MaxDepth)
+				m_sections[m_depth] = section;
+			m_depth++;
+			m_section = section;
+		}
+
+		void EndElement(std::string_view name)
+		{
+			std::string_view text = Trim(m_text);
+			if (name == "Item")
+			{
+				m_itemKey.assign(text);
+			}
+			else if (name == "Value")
+			{
+				if (!m_itemKey.empty())
+					Field(m_itemKey, text, true);
+				m_itemKey.clear();
+			}
+			else if (!text.empty())
+			{
+				Field(name, text, true);
+			}
+			m_text.clear();
+
+			if (m_depth > 0)
+				m_depth--;
+			m_section = m_depth == 0 ? Section::None : m_sections[(std::min)(m_depth, MaxDepth) - 1];
+		}
+
+		void Field(std::string_view key, std::string_view value, bool xml)
+		{
+			if (value.empty() || m_section == Section::Other)
+				return;
+
+			// "Card name", "CardName" and "cardname" are one key
+			char buffer[48];
+			size_t length = 0;
+			for (char c : key)
+			{
+				if (length == sizeof(buffer))
+					return;
+				if (c >= 'A' && c <= 'Z')
+					buffer[length++] = static_cast<char>(c - 'A' + 'a');
+				else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))
+					buffer[length++] = c;
+			}
+			std::string_view normalized(buffer, length);
+
+			auto decode = [&]() { return xml ? DecodeText(DecodeEntities(value)) : DecodeText(value); };
+			switch (m_section)
+			{
+			case Section::None:
+			case Section::System:
+				if ((normalized == "machinename" || normalized == "systemname") && m_info.DeviceName.empty())
+				{
+					m_info.DeviceName = decode();
+				}
+				else if (normalized == "processor" && m_info.Processor.empty())
+				{
+					m_info.Processor = decode();
+				}
+				else if ((normalized == "memory" || normalized == "installedphysicalmemoryram") && m_info.RAM.empty())
+				{
+					// dxdiag "16384MB RAM", msinfo32 "16.0 GB"
+					m_info.RAM = decode();
+					uint64_t bytes = 0;
+					if (QuantityParser::Parse(m_info.RAM, bytes))
+						m_info.RamGB = QuantityParser::ToGB(bytes);
+				}
+				else if (normalized == "systemtype")
+				{
+					// msinfo32 "x64-based PC"
+					m_info.SystemType = decode();
+				}
+				else if (normalized == "operatingsystem" && m_operatingSystem.empty())
+				{
+					// dxdiag "Windows 11 Pro 64-bit (10.0, Build 22631)", used without a System Type
+					m_operatingSystem = decode();
+				}
+				break;
+
+			case Section::Display:
+				if (normalized == "cardname" || normalized == "name")
+				{
+					if (m_adapters.size() < MaxAdapters)
+						m_adapters.push_back({ decode(), {}, 0 });
+				}
+				else if ((normalized == "dedicatedmemory" || normalized == "adapterram") && !m_adapters.empty() && m_adapters.back().Dedicated.empty())
+				{
+					// msinfo32's Adapter RAM is a 32-bit field, so it stops at 4 GB; dxdiag's is exact
+					DisplayAdapter& adapter = m_adapters.back();
+					adapter.Dedicated = decode();
+					uint64_t bytes = 0;
+					if (QuantityParser::Parse(adapter.Dedicated, bytes) || ParseBytes(value, bytes))
+						adapter.DedicatedGB = QuantityParser::ToGB(bytes);
+				}
+				break;
+
+			default:
+				break;
+			}
+		}
+
+		void SetFormat(Format format)
+		{
+			if (m_format == Format::Unknown)
+				m_format = format;
+		}
+
+		static Section SectionOf(std::string_view title)
+		{
+			std::string_view trimmed = Trim(title);
+			if (trimmed == "System Information" || trimmed == "SystemInformation" || trimmed == "System Summary")
+				return Section::System;
+			if (trimmed == "Display Devices" || trimmed == "DisplayDevices" || trimmed == "Display")
+				return Section::Display;
+			return Section::Other;
+		}
+
+		// msinfo32 "(1,073,741,824) bytes" or "1.00 GB (1,073,741,824 bytes)": the digits of
+		// the last parenthesized number
+		static bool ParseBytes(std::string_view text, uint64_t& bytes)
+		{
+			if (text.find("bytes") == std::string_view::npos)
+				return false;
+			size_t open = text.rfind('(');
+			if (open == std::string_view::npos)
+				return false;
+			uint64_t value = 0;
+			bool any = false;
+			for (size_t i = open + 1; i < text.size() && text[i] != ')' && text[i] != ' '; i++)
+			{
+				if (text[i] == ',' || text[i] == '.')
+					continue;
+				if (text[i] < '0' || text[i] > '9' || value > UINT64_MAX / 10)
+					return false;
+				value = value * 10 + static_cast<uint64_t>(text[i] - '0');
+				any = true;
+			}
+			bytes = value;
+			return any;
+		}
+
+		// The value of name="..." in a start tag
+		static std::string_view Attribute(std::string_view tag, std::string_view name)
+		{
+			for (size_t at = tag.find(name); at != std::string_view::npos; at = tag.find(name, at + 1))
+			{
+				size_t quote = at + name.size();
+				if (at == 0 || (tag[at - 1] != ' ' && tag[at - 1] != '\t') || quote + 1 >= tag.size() || tag[quote] != '=')
+					continue;
+				char mark = tag[quote + 1];
+				size_t end = tag.find(mark, quote + 2);
+				if ((mark == '"' || mark == '\'') && end != std::string_view::npos)
+					return tag.substr(quote + 2, end - quote - 2);
+			}
+			return {};
+		}
+
+		// &amp; &lt; &gt; &quot; &apos; and numeric references
+		static std::string DecodeEntities(std::string_view text)
+		{
+			std::string decoded;
+			decoded.reserve(text.size());
+			for (size_t i = 0; i < text.size(); i++)
+			{
+				size_t semicolon = text[i] == '&' ? text.find(';', i) : std::string_view::npos;
+				if (semicolon == std::string_view::npos || semicolon - i > 10)
+				{
+					decoded += text[i];
+					continue;
+				}
+
+				std::string_view entity = text.substr(i + 1, semicolon - i - 1);
+				static constexpr std::pair<std::string_view, char> Named[] = {
+					{ "amp", '&' }, { "lt", '<' }, { "gt", '>' }, { "quot", '"' }, { "apos", '\'' },
+				};
+				bool known = false;
+				for (const auto& [entityName, c] : Named)
+				{
+					if (entity == entityName)
+					{
+						decoded += c;
+						known = true;
+					}
+				}
+				if (!known && entity.size() > 1 && entity[0] == '#')
+				{
+					bool hex = entity[1] == 'x' || entity[1] == 'X';
+					std::string_view digits = entity.substr(hex ? 2 : 1);
+					uint32_t code = 0;
+					auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), code, hex ? 16 : 10);
+					if (error == std::errc{} && end == digits.data() + digits.size() && code > 0 && code < 0x110000)
+					{
+						Utf8::Append(decoded, std::wstring(1, static_cast<wchar_t>(code)));
+						known = true;
+					}
+				}
+				if (!known)
+				{
+					decoded += text[i];
+					continue;
+				}
+				i = semicolon;
+			}
+			return decoded;
+		}
+
+		// UTF-8, or Windows-1252 for the ANSI files older dxdiag writes ("Intel\xAE")
+		static std::wstring DecodeText(std::string_view text)
+		{
+			if (IsUtf8(text))
+				return Utf8::Decode(text);
+
+			// 0x80-0x9F differ from Latin-1; 0 marks the five unassigned bytes
+			static constexpr wchar_t Windows1252[32] = {
+				0x20AC, 0, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0, 0x017D, 0,
+				0, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0, 0x017E, 0x0178,
+			};
+			std::wstring decoded;
+			decoded.reserve(text.size());
+			for (char c : text)
+			{
+				uint8_t byte = static_cast<uint8_t>(c);
+				wchar_t wide = byte >= 0x80 && byte < 0xA0 ? Windows1252[byte - 0x80] : static_cast<wchar_t>(byte);
+				decoded += wide != 0 ? wide : L'\uFFFD';
+			}
+			return decoded;
+		}
+
+		static bool IsUtf8(std::string_view text)
+		{
+			for (size_t i = 0; i < text.size();)
+			{
+				uint8_t lead = static_cast<uint8_t>(text[i]);
+				size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3 : (lead >> 3) == 0x1E ? 4 : 0;
+				if (length == 0 || i + length > text.size())
+					return false;
+				for (size_t k = 1; k < length; k++)
+				{
+					if ((static_cast<uint8_t>(text[i + k]) & 0xC0) != 0x80)
+						return false;
+				}
+				i += length;
+			}
+			return true;
+		}
+
+		static void AppendBounded(std::string& into, std::string_view part)
+		{
+			into.append(part.substr(0, MaxLine - (std::min)(into.size(), MaxLine)));
+		}
+
+		static std::string_view Trim(std::string_view text)
+		{
+			size_t first = text.find_first_not_of(" \t\r\n");
+			if (first == std::string_view::npos)
+				return {};
+			return text.substr(first, text.find_last_not_of(" \t\r\n") - first + 1);
+		}
+	};
+}
@@ -0,0 +1,629 @@
+#pragma once
+#include "pch.h"
+#include "FleetResultStore.h"
+#include "RoaringBitmap.h"
+#include "ResultCodes.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace HardwareAnalyzer
+{
+	// Bitmap indexes over a FleetResultStore's rows, for selections such as "every machine
+	// with under 8 GB of RAM, an Intel UHD GPU and a score under 55" without scanning the
+	// columns. Kept:
+	//   - one bitmap per platform, per (check, status) and per (check, reason id); a reason
+	//     is also the check's family (cpu = ModernIntel, gpu = IntelUHD, chip = IntelMacNotSupported)
+	//   - score, RAM, VRAM and macOS version as buckets of value ranges: a comparison ORs the
+	//     buckets wholly inside it and checks the column only for the rows of the bucket its
+	//     bound falls in, so results are exact
+	// Evaluate() takes a small predicate language (see below) and runs it as bitmap AND/OR.
+	//
+	// Refresh() indexes the rows appended since the last call; it must not run alongside
+	// the const members, which may run concurrently with each other.
+	class FleetQuery
+	{
+	public:
+		enum class Measure : uint8_t
+		{
+			Score,
+			RamGB,
+			VramGB,
+			MacOSMajor,
+
+			Count
+		};
+
+		enum class Comparison : uint8_t
+		{
+			Less,
+			LessEqual,
+			Greater,
+			GreaterEqual,
+			Equal,
+			NotEqual
+		};
+
+		explicit FleetQuery(const FleetResultStore& store)
+			: m_store(store)
+		{
+			// Bucket edges sit on the thresholds queries tend to use
+			m_measures[static_cast<size_t>(Measure::Score)].Edges = { 10, 20, 30, 40, 50, 60, 70, 80, 90, 100 };
+			m_measures[static_cast<size_t>(Measure::RamGB)].Edges = { 2, 4, 6, 8, 12, 16, 24, 32, 64, 128 };
+			m_measures[static_cast<size_t>(Measure::VramGB)].Edges = { 1, 2, 3, 4, 6, 8, 12, 16, 24 };
+			for (double version = 11; version <= 30; version++)
+			{
+				m_measures[static_cast<size_t>(Measure::MacOSMajor)].Edges.push_back(version);
+			}
+			for (MeasureIndex& measure : m_measures)
+			{
+				measure.Buckets.resize(measure.Edges.size() + 1);
+			}
+			Refresh();
+		}
+
+		void Refresh()
+		{
+			size_t rows = m_store.Size();
+			std::span<const uint8_t> platform = m_store.Platform();
+			for (size_t row = m_rows; row < rows; row++)
+			{
+				uint32_t id = static_cast<uint32_t>(row);
+				if (platform[row] < m_platforms.size())
+					m_platforms[platform[row]].Add(id);
+
+				for (size_t kind = 0; kind < FleetResultStore::KindCount; kind++)
+				{
+					uint8_t status = m_store.Status(static_cast<CheckKind>(kind))[row];
+					if (status == FleetResultStore::NotApplicable)
+						continue;
+					if (status < StatusCount)
+						m_status[kind][status].Add(id);
+					uint8_t reason = m_store.Reason(static_cast<CheckKind>(kind))[row];
+					if (reason < ResultCodes::ReasonCount)
+						m_reasons[kind][reason].Add(id);
+				}
+
+				for (size_t measure = 0; measure < MeasureCount; measure++)
+				{
+					double value = ValueOf(static_cast<Measure>(measure), row);
+					if (!Found(static_cast<Measure>(measure), value))
+						continue;
+					const std::vector<double>& edges = m_measures[measure].Edges;
+					size_t bucket = static_cast<size_t>(std::upper_bound(edges.begin(), edges.end(), value) - edges.begin());
+					Bucket& into = m_measures[measure].Buckets[bucket];
+					into.Rows.Add(id);
+					into.Min = (std::min)(into.Min, value);
+					into.Max = (std::max)(into.Max, value);
+				}
+			}
+			if (rows != m_rows)
+			{
+				m_rows = rows;
+				m_all = RoaringBitmap::Range(static_cast<uint32_t>(rows));
+			}
+		}
+
+		size_t Rows() const { return m_rows; }
+		const RoaringBitmap& All() const { return m_all; }
+		const RoaringBitmap& OnPlatform(TargetPlatform platform) const { return m_platforms[static_cast<size_t>(platform)]; }
+		const RoaringBitmap& WithStatus(CheckKind kind, StatusLevel status) const { return m_status[static_cast<size_t>(kind)][static_cast<size_t>(status)]; }
+
+		const RoaringBitmap& WithReason(CheckKind kind, uint8_t reason) const
+		{
+			return reason < ResultCodes::ReasonCount ? m_reasons[static_cast<size_t>(kind)][reason] : m_empty;
+		}
+
+		// Rows that have the check, whatever its status
+		RoaringBitmap WithCheck(CheckKind kind) const
+		{
+			const auto& status = m_status[static_cast<size_t>(kind)];
+			return RoaringBitmap::Or(RoaringBitmap::Or(status[0], status[1]), status[2]);
+		}
+
+		// Rows whose value compares true against 'value'; rows where it wasn't found never match
+		RoaringBitmap Select(Measure measure, Comparison comparison, double value) const
+		{
+			const MeasureIndex& index = m_measures[static_cast<size_t>(measure)];
+			if (comparison == Comparison::NotEqual)
+			{
+				RoaringBitmap found;
+				for (const Bucket& bucket : index.Buckets)
+				{
+					found = RoaringBitmap::Or(found, bucket.Rows);
+				}
+				return RoaringBitmap::AndNot(found, Select(measure, Comparison::Equal, value));
+			}
+
+			RoaringBitmap rows;
+			for (const Bucket& bucket : index.Buckets)
+			{
+				// Every comparison is monotonic in the value (or, for =, needs Min = Max), so
+				// the bucket's extremes tell whether it matches whole or not at all
+				if (bucket.Rows.Empty())
+					continue;
+				bool low = Compare(bucket.Min, comparison, value);
+				bool high = Compare(bucket.Max, comparison, value);
+				if (!low && !high && (comparison != Comparison::Equal || bucket.Min > value || bucket.Max < value))
+					continue;
+				if (low && high)
+				{
+					rows = RoaringBitmap::Or(rows, bucket.Rows);
+					continue;
+				}
+
+				RoaringBitmap matches;
+				bucket.Rows.ForEach([&](uint32_t row) {
+					if (Compare(ValueOf(measure, row), comparison, value))
+						matches.Add(row);
+				});
+				rows = RoaringBitmap::Or(rows, matches);
+			}
+			return rows;
+		}
+
+		// Query language, keywords and names case-insensitive:
+		//   query      := term { ("or" | "||") term }
+		//   term       := factor { ("and" | "&&") factor }
+		//   factor     := ("not" | "!") factor | "(" query ")" | comparison
+		//   comparison := field op value, op one of < <= > >= = == !=
+		// Fields:
+		//   score, ram, vram, macos          against a number (GB for ram and vram; macos is the major version)
+		//   cpu, gpu, ram, vram, arch, chip, memory, macos
+		//                                    against a reason, with or without "Reason_": the check's family
+		//   <check>.reason, <check>.status   the same reason, or good / warning / bad (ordered in that way)
+		//   reason, status                   any check with that reason or status
+		//   platform                         windows or macos
+		// e.g.  ram < 8 and gpu = IntelUHD and score < 55
+		//       chip = IntelMacNotSupported and macos = 13
+		//       not (cpu.status = good or platform = macos)
+		bool Evaluate(std::string_view query, RoaringBitmap& rows, std::string& error) const
+		{
+			Parser parser{ *this, query };
+			rows = parser.Query();
+			if (parser.Failed())
+			{
+				error = parser.Error();
+				return false;
+			}
+			if (!parser.AtEnd())
+			{
+				error = parser.Describe("unexpected text");
+				return false;
+			}
+			return true;
+		}
+
+		size_t MemoryBytes() const
+		{
+			size_t bytes = m_all.MemoryBytes();
+			for (const RoaringBitmap& rows : m_platforms)
+			{
+				bytes += rows.MemoryBytes();
+			}
+			for (size_t kind = 0; kind < FleetResultStore::KindCount; kind++)
+			{
+				for (const RoaringBitmap& rows : m_status[kind])
+				{
+					bytes += rows.MemoryBytes();
+				}
+				for (const RoaringBitmap& rows : m_reasons[kind])
+				{
+					bytes += rows.MemoryBytes();
+				}
+			}
+			for (const MeasureIndex& measure : m_measures)
+			{
+				for (const Bucket& bucket : measure.Buckets)
+				{
+					bytes += bucket.Rows.MemoryBytes();
+				}
+			}
+			return bytes;
+		}
+
+	private:
+		static constexpr size_t StatusCount = 3;
+		static constexpr size_t MeasureCount = static_cast<size_t>(Measure::Count);
+
+		struct Bucket
+		{
+			RoaringBitmap Rows;
+			double Min = HUGE_VAL;     // Of the values actually in it, which decide whether a
+			double Max = -HUGE_VAL;    // comparison takes all, none or some of the rows
+		};
+
+		struct MeasureIndex
+		{
+			std::vector<double> Edges;     // Ascending; bucket i holds Edges[i - 1] <= v < Edges[i]
+			std::vector<Bucket> Buckets;
+		};
+
+		const FleetResultStore& m_store;
+		size_t m_rows = 0;
+		RoaringBitmap m_all;
+		RoaringBitmap m_empty;
+		std::array<RoaringBitmap, 2> m_platforms;
+		std::array<std::array<RoaringBitmap, StatusCount>, FleetResultStore::KindCount> m_status;
+		std::array<std::array<RoaringBitmap, ResultCodes::ReasonCount>, FleetResultStore::KindCount> m_reasons;
+		std::array<MeasureIndex, MeasureCount> m_measures;
+
+		double ValueOf(Measure measure, size_t row) const
+		{
+			switch (measure)
+			{
+			case Measure::Score: return m_store.Score()[row];
+			case Measure::RamGB: return m_store.RamGB()[row];
+			case Measure::VramGB: return m_store.VramGB()[row];
+			default: return m_store.MacOSMajor()[row];
+			}
+		}
+
+		// Not found is a score of -1 and 0 for the rest
+		static bool Found(Measure measure, double value)
+		{
+			return measure == Measure::Score ? value >= 0 : value > 0;
+		}
+
+		static bool Compare(double left, Comparison comparison, double right)
+		{
+			switch (comparison)
+			{
+			case Comparison::Less: return left < right;
+			case Comparison::LessEqual: return left <= right;
+			case Comparison::Greater: return left > right;
+			case Comparison::GreaterEqual: return left >= right;
+			case Comparison::Equal: return left == right;
+			default: return left != right;
+			}
+		}
+
+		// Recursive descent straight to bitmaps; after the first error the rest is skipped
+		class Parser
+		{
+		public:
+			Parser(const FleetQuery& query, std::string_view text)
+				: m_query(query), m_text(text) {}
+
+			bool Failed() const { return !m_error.empty(); }
+			const std::string& Error() const { return m_error; }
+
+			bool AtEnd()
+			{
+				SkipSpace();
+				return m_position == m_text.size();
+			}
+
+			std::string Describe(std::string_view message) const
+			{
+				return std::string(message) + " at offset " + std::to_string(m_position);
+			}
+
+			RoaringBitmap Query()
+			{
+				RoaringBitmap rows = Term();
+				while (!Failed() && (Keyword("or") || Symbol("||")))
+				{
+					rows = RoaringBitmap::Or(rows, Term());
+				}
+				return rows;
+			}
+
+		private:
+			const FleetQuery& m_query;
+			std::string_view m_text;
+			size_t m_position = 0;
+			size_t m_depth = 0;
+			std::string m_error;
+
+			static constexpr size_t MaxDepth = 64;
+
+			RoaringBitmap Fail(std::string_view message)
+			{
+				if (m_error.empty())
+					m_error = Describe(message);
+				return {};
+			}
+
+			RoaringBitmap Term()
+			{
+				RoaringBitmap rows = Factor();
+				while (!Failed() && (Keyword("and") || Symbol("&&")))
+				{
+					RoaringBitmap right = Factor();
+					rows = RoaringBitmap::And(rows, right);
+				}
+				return rows;
+			}
+
+			RoaringBitmap Factor()
+			{
+				if (++m_depth > MaxDepth)
+					return Fail("query nested too deeply");
+
+				RoaringBitmap rows;
+				if (Keyword("not") || (!Peek("!=") && Symbol("!")))
+				{
+					rows = RoaringBitmap::AndNot(m_query.All(), Factor());
+				}
+				else if (Symbol("("))
+				{
+					rows = Query();
+					if (!Failed() && !Symbol(")"))
+						rows = Fail("expected ')'");
+				}
+				else
+				{
+					rows = Predicate();
+				}
+				m_depth--;
+				return rows;
+			}
+
+			RoaringBitmap Predicate()
+			{
+				size_t start = (SkipSpace(), m_position);
+				std::string field = Lower(Word());
+				if (field.empty())
+					return Fail("expected a field");
+
+				Comparison comparison;
+				if (Symbol("<="))
+					comparison = Comparison::LessEqual;
+				else if (Symbol(">="))
+					comparison = Comparison::GreaterEqual;
+				else if (Symbol("!="))
+					comparison = Comparison::NotEqual;
+				else if (Symbol("=="))
+					comparison = Comparison::Equal;
+				else if (Symbol("<"))
+					comparison = Comparison::Less;
+				else if (Symbol(">"))
+					comparison = Comparison::Greater;
+				else if (Symbol("="))
+					comparison = Comparison::Equal;
+				else
+					return Fail("expected a comparison after '" + field + "'");
+
+				SkipSpace();
+				if (m_position < m_text.size() && (IsDigit(m_text[m_position]) || m_text[m_position] == '.' || m_text[m_position] == '-'))
+					return Numeric(field, comparison);
+
+				std::string value = Lower(Word());
+				if (value.empty())
+					return Fail("expected a value");
+
+				RoaringBitmap rows;
+				if (!Named(field, comparison, value, rows))
+				{
+					m_position = start;
+					return Fail("can't compare '" + field + "' with '" + value + "'");
+				}
+				return rows;
+			}
+
+			// An optional '-', then digits with at most one '.'; "-", "." or "1.2.3" is malformed
+			RoaringBitmap Numeric(const std::string& field, Comparison comparison)
+			{
+				size_t end = m_position;
+				if (m_text[end] == '-')
+					end++;
+				size_t digits = 0;
+				while (end < m_text.size() && (IsDigit(m_text[end]) || m_text[end] == '.'))
+				{
+					digits += IsDigit(m_text[end]);
+					end++;
+				}
+				std::string number(m_text.substr(m_position, end - m_position));
+				char* parsed = nullptr;
+				double value = digits == 0 ? 0 : std::strtod(number.c_str(), &parsed);
+				if (digits == 0 || parsed != number.c_str() + number.size())
+					return Fail("malformed number");
+				m_position = end;
+
+				static constexpr std::pair<std::string_view, Measure> Measures[] = {
+					{ "score", Measure::Score },
+					{ "ram", Measure::RamGB },
+					{ "vram", Measure::VramGB },
+					{ "macos", Measure::MacOSMajor },
+				};
+				for (const auto& [name, measure] : Measures)
+				{
+					if (field == name)
+						return m_query.Select(measure, comparison, value);
+				}
+				return Fail("'" + field + "' isn't a number");
+			}
+
+			bool Named(const std::string& field, Comparison comparison, const std::string& value, RoaringBitmap& rows) const
+			{
+				if (field == "platform")
+				{
+					if (comparison != Comparison::Equal && comparison != Comparison::NotEqual)
+						return false;
+					const RoaringBitmap* platform = value == "windows" ? &m_query.OnPlatform(TargetPlatform::Windows)
+						: value == "macos" ? &m_query.OnPlatform(TargetPlatform::macOS) : nullptr;
+					if (platform == nullptr)
+						return false;
+					rows = comparison == Comparison::Equal ? *platform : RoaringBitmap::AndNot(m_query.All(), *platform);
+					return true;
+				}
+
+				// "status" and "reason" alone are any check; otherwise a check name and an
+				// optional ".status" or ".reason", the reason being the default
+				std::string_view check = field;
+				bool status = false;
+				bool anyCheck = field == "status" || field == "reason";
+				if (anyCheck)
+				{
+					status = field == "status";
+				}
+				else if (size_t dot = check.find('.'); dot != std::string_view::npos)
+				{
+					std::string_view part = check.substr(dot + 1);
+					if (part != "status" && part != "reason")
+						return false;
+					status = part == "status";
+					check = check.substr(0, dot);
+				}
+
+				size_t first = 0;
+				size_t last = FleetResultStore::KindCount;
+				if (!anyCheck)
+				{
+					CheckKind kind = KindOf(check);
+					if (kind == CheckKind::Count)
+						return false;
+					first = static_cast<size_t>(kind);
+					last = first + 1;
+				}
+
+				RoaringBitmap equal;
+				RoaringBitmap present;
+				for (size_t kind = first; kind < last; kind++)
+				{
+					CheckKind checkKind = static_cast<CheckKind>(kind);
+					if (status)
+					{
+						int level = StatusOf(value);
+						if (level < 0)
+							return false;
+						for (int candidate = 0; candidate < static_cast<int>(StatusCount); candidate++)
+						{
+							if (FleetQuery::Compare(candidate, comparison, level))
+								equal = RoaringBitmap::Or(equal, m_query.WithStatus(checkKind, static_cast<StatusLevel>(candidate)));
+						}
+						continue;
+					}
+
+					if (comparison != Comparison::Equal && comparison != Comparison::NotEqual)
+						return false;
+					uint8_t reason = ReasonOf(value);
+					if (reason == ResultCodes::UnknownReason)
+						return false;
+					equal = RoaringBitmap::Or(equal, m_query.WithReason(checkKind, reason));
+					if (!anyCheck)
+						present = m_query.WithCheck(checkKind);
+				}
+
+				// A check's != keeps to the rows that have it; "reason != X" is every row
+				// where no check gave X
+				if (!status && comparison == Comparison::NotEqual)
+					rows = RoaringBitmap::AndNot(anyCheck ? m_query.All() : present, equal);
+				else
+					rows = std::move(equal);
+				return true;
+			}
+
+			static CheckKind KindOf(std::string_view name)
+			{
+				static constexpr std::pair<std::string_view, CheckKind> Checks[] = {
+					{ "cpu", CheckKind::Processor },
+					{ "gpu", CheckKind::GraphicsCard },
+					{ "ram", CheckKind::RAM },
+					{ "vram", CheckKind::VideoMemory },
+					{ "arch", CheckKind::Architecture },
+					{ "chip", CheckKind::Chip },
+					{ "memory", CheckKind::Memory },
+					{ "macos", CheckKind::MacOSVersion },
+				};
+				for (const auto& [check, kind] : Checks)
+				{
+					if (name == check)
+						return kind;
+				}
+				return CheckKind::Count;
+			}
+
+			static int StatusOf(std::string_view value)
+			{
+				return value == "good" ? 0 : value == "warning" ? 1 : value == "bad" ? 2 : -1;
+			}
+
+			// Case-insensitive, with or without the "Reason_" prefix
+			static uint8_t ReasonOf(std::string_view value)
+			{
+				if (value.starts_with("reason_"))
+					value.remove_prefix(7);
+				for (size_t reason = 1; reason < ResultCodes::ReasonCount; reason++)
+				{
+					std::string_view key = ResultCodes::ReasonKeys[reason];
+					key.remove_prefix(7);
+					if (Lower(key) == value)
+						return static_cast<uint8_t>(reason);
+				}
+				return ResultCodes::UnknownReason;
+			}
+
+			void SkipSpace()
+			{
+				while (m_position < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_position])))
+				{
+					m_position++;
+				}
+			}
+
+			bool Peek(std::string_view symbol)
+			{
+				SkipSpace();
+				return m_text.substr(m_position).starts_with(symbol);
+			}
+
+			bool Symbol(std::string_view symbol)
+			{
+				if (!Peek(symbol))
+					return false;
+				m_position += symbol.size();
+				return true;
+			}
+
+			// A whole word only: "order" isn't "or" followed by "der"
+			bool Keyword(std::string_view keyword)
+			{
+				SkipSpace();
+				size_t end = m_position;
+				while (end < m_text.size() && IsWordChar(m_text[end]))
+				{
+					end++;
+				}
+				if (Lower(m_text.substr(m_position, end - m_position)) != keyword)
+					return false;
+				m_position = end;
+				return true;
+			}
+
+			std::string_view Word()
+			{
+				SkipSpace();
+				size_t start = m_position;
+				while (m_position < m_text.size() && (IsWordChar(m_text[m_position]) || m_text[m_position] == '.'))
+				{
+					m_position++;
+				}
+				return m_text.substr(start, m_position - start);
+			}
+
+			static bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+			static bool IsWordChar(char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; }
+
+			static std::string Lower(std::string_view text)
+			{
+				std::string lower(text);
+				for (char& c : lower)
+				{
+					c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+				}
+				return lower;
+			}
+		};
+	};
+}
@@ -0,0 +1,527 @@
+#pragma once
+#include "pch.h"
+#include "AnalysisJson.h"
+#include "AnalysisPipeline.h"
+#include "ResultCodes.h"
+#include "ResultSerializer.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// HARDWARE_ANALYZER_FLEET_SCALAR leaves the kernels on their scalar loops, to check one against the other
+#if (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)) && !defined(HARDWARE_ANALYZER_FLEET_SCALAR)
+#include <emmintrin.h>
+#define HARDWARE_ANALYZER_FLEET_SSE2 1
+#endif
+
+namespace HardwareAnalyzer
+{
+	// Distinct strings of a column, each stored once and referred to by a dense code.
+	// Code 0 is the empty string, i.e. nothing was extracted.
+	class StringDictionary
+	{
+	public:
+		StringDictionary()
+		{
+			m_values.emplace_back();
+			m_codes.emplace(m_values.front(), 0);
+		}
+
+		// The map's keys point into m_values: moving keeps them valid, copying wouldn't
+		StringDictionary(const StringDictionary&) = delete;
+		StringDictionary& operator=(const StringDictionary&) = delete;
+		StringDictionary(StringDictionary&&) = default;
+		StringDictionary& operator=(StringDictionary&&) = default;
+
+		uint32_t Encode(std::wstring_view value)
+		{
+			auto found = m_codes.find(value);
+			if (found != m_codes.end())
+				return found->second;
+
+			uint32_t code = static_cast<uint32_t>(m_values.size());
+			const std::wstring& stored = m_values.emplace_back(value);
+			m_codes.emplace(stored, code);
+			return code;
+		}
+
+		std::wstring_view Decode(uint32_t code) const { return m_values[code]; }
+		size_t Size() const { return m_values.size(); }
+
+	private:
+		std::deque<std::wstring> m_values;     // Never reallocates, so the views stay valid
+		std::unordered_map<std::wstring_view, uint32_t> m_codes;
+	};
+
+	// Analysis results of a whole fleet as columns, one row per machine, for aggregate
+	// questions ("share of the fleet with Bad RAM", "score histogram by GPU family") that
+	// would otherwise walk hundreds of thousands of vectors of strings. A row takes 35 bytes:
+	//   - status and reason id bytes for each CheckKind (NotApplicable for the other platform)
+	//   - RAM and VRAM in GB as floats (0 = not found; macOS memory goes in RAM)
+	//   - the score (-1 = nothing extracted)
+	//   - the macOS major version (0 = not found or Windows)
+	//   - dictionary codes of the CPU (or Mac chip) and GPU names
+	// The kernels are static and take column spans, so they apply to any column or slice.
+	class FleetResultStore
+	{
+	public:
+		static constexpr uint8_t NotApplicable = 0xFF;
+		static constexpr size_t KindCount = static_cast<size_t>(CheckKind::Count);
+		static constexpr size_t ScoreBins = 102;     // Scores -1 to 100; bin = score + 1
+
+		using ScoreHistogramBins = std::array<uint64_t, ScoreBins>;
+
+		void Reserve(size_t rows)
+		{
+			m_platform.reserve(rows);
+			for (size_t kind = 0; kind < KindCount; kind++)
+			{
+				m_status[kind].reserve(rows);
+				m_reason[kind].reserve(rows);
+			}
+			m_ramGB.reserve(rows);
+			m_vramGB.reserve(rows);
+			m_score.reserve(rows);
+			m_macOSMajor.reserve(rows);
+			m_cpu.reserve(rows);
+			m_gpu.reserve(rows);
+		}
+
+		size_t Size() const { return m_score.size(); }
+
+		template <typename String>
+		void Append(const BasicWindowsAnalysis<String>& analysis)
+		{
+			AppendRow(TargetPlatform::Windows, analysis.Results, analysis.Score,
+				analysis.Info.RamGB, analysis.Info.VramGB, 0, analysis.Info.Processor, analysis.Info.GPU);
+		}
+
+		template <typename String>
+		void Append(const BasicMacOSAnalysis<String>& analysis)
+		{
+			AppendRow(TargetPlatform::macOS, analysis.Results, analysis.Score,
+				analysis.Info.MemoryGB, 0, analysis.Info.MacOSMajorVersion, analysis.Info.Chip, std::wstring_view{});
+		}
+
+		// Rows of a stream of ResultSerializer binary records, as "batch --format binary" writes
+		// them; false at a malformed record, with the rows before it kept
+		bool AppendBinary(std::string_view stream)
+		{
+			std::string_view record;
+			TargetPlatform platform;
+			WindowsAnalysis windows;
+			MacOSAnalysis macOS;
+			while (ResultSerializer::NextBinaryRecord(stream, record, platform))
+			{
+				if (platform == TargetPlatform::Windows && ResultSerializer::ReadBinary(record, windows))
+					Append(windows);
+				else if (platform == TargetPlatform::macOS && ResultSerializer::ReadBinary(record, macOS))
+					Append(macOS);
+				else
+					return false;
+			}
+			return stream.empty();
+		}
+
+		// Appends the rows and names 'source' has past this store's, for a copy that is read
+		// while the source keeps growing. This store must hold a prefix of 'source', as one
+		// built only by CatchUp does, so the dictionary codes carry over as they are.
+		void CatchUp(const FleetResultStore& source)
+		{
+			size_t from = Size();
+			auto tail = [from](auto& into, const auto& column)
+			{
+				into.insert(into.end(), column.begin() + static_cast<std::ptrdiff_t>(from), column.end());
+			};
+			tail(m_platform, source.m_platform);
+			for (size_t kind = 0; kind < KindCount; kind++)
+			{
+				tail(m_status[kind], source.m_status[kind]);
+				tail(m_reason[kind], source.m_reason[kind]);
+			}
+			tail(m_ramGB, source.m_ramGB);
+			tail(m_vramGB, source.m_vramGB);
+			tail(m_macOSMajor, source.m_macOSMajor);
+			tail(m_cpu, source.m_cpu);
+			tail(m_gpu, source.m_gpu);
+			// Size() is the score column's, so it goes last
+			tail(m_score, source.m_score);
+
+			for (uint32_t code = static_cast<uint32_t>(m_cpuNames.Size()); code < source.m_cpuNames.Size(); code++)
+				m_cpuNames.Encode(source.m_cpuNames.Decode(code));
+			for (uint32_t code = static_cast<uint32_t>(m_gpuNames.Size()); code < source.m_gpuNames.Size(); code++)
+				m_gpuNames.Encode(source.m_gpuNames.Decode(code));
+		}
+
+		std::span<const uint8_t> Platform() const { return m_platform; }     // TargetPlatform values
+		std::span<const uint8_t> Status(CheckKind kind) const { return m_status[static_cast<size_t>(kind)]; }
+		std::span<const uint8_t> Reason(CheckKind kind) const { return m_reason[static_cast<size_t>(kind)]; }
+		std::span<const float> RamGB() const { return m_ramGB; }
+		std::span<const float> VramGB() const { return m_vramGB; }
+		std::span<const int8_t> Score() const { return m_score; }
+		std::span<const uint8_t> MacOSMajor() const { return m_macOSMajor; }
+		std::span<const uint32_t> Cpu() const { return m_cpu; }
+		std::span<const uint32_t> Gpu() const { return m_gpu; }
+		const StringDictionary& CpuNames() const { return m_cpuNames; }
+		const StringDictionary& GpuNames() const { return m_gpuNames; }
+
+		// Share of the rows that have the check (of either platform) with the given status
+		double Share(CheckKind kind, StatusLevel status) const
+		{
+			std::span<const uint8_t> column = Status(kind);
+			size_t present = column.size() - CountEqual(column, NotApplicable);
+			return present == 0 ? 0 : static_cast<double>(CountEqual(column, static_cast<uint8_t>(status))) / static_cast<double>(present);
+		}
+
+		static size_t CountEqual(std::span<const uint8_t> column, uint8_t value)
+		{
+			size_t count = 0;
+			size_t i = 0;
+#if HARDWARE_ANALYZER_FLEET_SSE2
+			const __m128i needle = _mm_set1_epi8(static_cast<char>(value));
+			while (column.size() - i >= 16)
+			{
+				// Each byte lane counts its matches (cmpeq gives -1); fold the lanes into
+				// the total every 255 blocks, before one can wrap
+				size_t blocks = (std::min)((column.size() - i) / 16, size_t{ 255 });
+				__m128i lanes = _mm_setzero_si128();
+				for (size_t block = 0; block < blocks; block++, i += 16)
+				{
+					__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(column.data() + i));
+					lanes = _mm_sub_epi8(lanes, _mm_cmpeq_epi8(bytes, needle));
+				}
+				__m128i sums = _mm_sad_epu8(lanes, _mm_setzero_si128());
+				count += static_cast<size_t>(_mm_cvtsi128_si32(sums)) + static_cast<size_t>(_mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+			}
+#endif
+			for (; i < column.size(); i++)
+			{
+				count += column[i] == value;
+			}
+			return count;
+		}
+
+		// Rows with low <= value < high (e.g. RAM from 0.1 to 8 GB: found but under 8)
+		static size_t CountInRange(std::span<const float> column, float low, float high)
+		{
+			size_t count = 0;
+			size_t i = 0;
+#if HARDWARE_ANALYZER_FLEET_SSE2
+			const __m128 lowest = _mm_set1_ps(low);
+			const __m128 highest = _mm_set1_ps(high);
+			for (; column.size() - i >= 4; i += 4)
+			{
+				__m128 values = _mm_loadu_ps(column.data() + i);
+				__m128 inside = _mm_and_ps(_mm_cmpge_ps(values, lowest), _mm_cmplt_ps(values, highest));
+				count += static_cast<size_t>(std::popcount(static_cast<unsigned>(_mm_movemask_ps(inside))));
+			}
+#endif
+			for (; i < column.size(); i++)
+			{
+				count += column[i] >= low && column[i] < high;
+			}
+			return count;
+		}
+
+		// Mean of the values that were found (above 0); 0 when none were
+		static double AverageFound(std::span<const float> column)
+		{
+			double sum = 0;
+			size_t count = 0;
+			size_t i = 0;
+#if HARDWARE_ANALYZER_FLEET_SSE2
+			const __m128 zero = _mm_setzero_ps();
+			while (column.size() - i >= 4)
+			{
+				// Float lanes for a few thousand values at a time, then into the double total
+				size_t end = i + (std::min)((column.size() - i) / 4 * 4, size_t{ 4096 });
+				__m128 lanes = zero;
+				for (; i < end; i += 4)
+				{
+					__m128 values = _mm_loadu_ps(column.data() + i);
+					__m128 found = _mm_cmpgt_ps(values, zero);
+					lanes = _mm_add_ps(lanes, _mm_and_ps(values, found));
+					count += static_cast<size_t>(std::popcount(static_cast<unsigned>(_mm_movemask_ps(found))));
+				}
+				alignas(16) float partial[4];
+				_mm_store_ps(partial, lanes);
+				sum += static_cast<double>(partial[0]) + partial[1] + partial[2] + partial[3];
+			}
+#endif
+			for (; i < column.size(); i++)
+			{
+				if (column[i] > 0)
+				{
+					sum += column[i];
+					count++;
+				}
+			}
+			return count == 0 ? 0 : sum / static_cast<double>(count);
+		}
+
+		// Count of every byte value, e.g. of a reason column
+		static std::array<uint64_t, 256> Histogram(std::span<const uint8_t> column)
+		{
+			// Four partial histograms, so runs of equal values don't serialize on one counter
+			std::array<std::array<uint64_t, 256>, 4> partial{};
+			size_t i = 0;
+			for (; column.size() - i >= 4; i += 4)
+			{
+				partial[0][column[i]]++;
+				partial[1][column[i + 1]]++;
+				partial[2][column[i + 2]]++;
+				partial[3][column[i + 3]]++;
+			}
+			for (; i < column.size(); i++)
+			{
+				partial[0][column[i]]++;
+			}
+
+			std::array<uint64_t, 256> histogram{};
+			for (size_t value = 0; value < 256; value++)
+			{
+				histogram[value] = partial[0][value] + partial[1][value] + partial[2][value] + partial[3][value];
+			}
+			return histogram;
+		}
+
+		static ScoreHistogramBins ScoreHistogram(std::span<const int8_t> scores)
+		{
+			// As bytes, -1 is 255 and 0..100 are themselves
+			std::array<uint64_t, 256> bytes = Histogram({ reinterpret_cast<const uint8_t*>(scores.data()), scores.size() });
+			ScoreHistogramBins histogram{};
+			histogram[0] = bytes[255];
+			for (size_t score = 0; score + 1 < ScoreBins; score++)
+			{
+				histogram[score + 1] = bytes[score];
+			}
+			return histogram;
+		}
+
+		// One score histogram per group, where groups[i] is row i's group: a reason column
+		// (ScoreHistogramBy(Score(), Reason(CheckKind::GraphicsCard), ResultCodes::ReasonCount)
+		// is the histogram by GPU family) or dictionary codes (by CPU or GPU name)
+		template <typename Group>
+		static std::vector<ScoreHistogramBins> ScoreHistogramBy(std::span<const int8_t> scores, std::span<const Group> groups, size_t groupCount)
+		{
+			std::vector<ScoreHistogramBins> histograms(groupCount);
+			size_t rows = (std::min)(scores.size(), groups.size());
+			for (size_t i = 0; i < rows; i++)
+			{
+				size_t bin = static_cast<size_t>(scores[i] + 1);
+				if (static_cast<size_t>(groups[i]) < groupCount && bin < ScoreBins)
+					histograms[groups[i]][bin]++;
+			}
+			return histograms;
+		}
+
+		// Nearest-rank percentiles (quantiles in [0, 1]) of the values that were found
+		static std::vector<float> Percentiles(std::span<const float> column, const std::vector<double>& quantiles)
+		{
+			std::vector<float> found;
+			found.reserve(column.size());
+			for (float value : column)
+			{
+				if (value > 0)
+					found.push_back(value);
+			}
+
+			std::vector<size_t> order(quantiles.size());
+			for (size_t i = 0; i < order.size(); i++)
+			{
+				order[i] = i;
+			}
+			std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return quantiles[a] < quantiles[b]; });
+
+			// Ascending ranks, each selection only looking past the previous one
+			std::vector<float> results(quantiles.size(), 0.0f);
+			auto from = found.begin();
+			for (size_t index : order)
+			{
+				if (found.empty())
+					break;
+				auto nth = found.begin() + static_cast<std::ptrdiff_t>(NearestRank(quantiles[index], found.size()));
+				std::nth_element(from, nth, found.end());
+				results[index] = *nth;
+				from = nth;
+			}
+			return results;
+		}
+
+		// Nearest-rank percentile of the scored rows (bin 0, "no data", is left out); -1 if none
+		static int ScorePercentile(const ScoreHistogramBins& histogram, double quantile)
+		{
+			uint64_t total = 0;
+			for (size_t bin = 1; bin < ScoreBins; bin++)
+			{
+				total += histogram[bin];
+			}
+			if (total == 0)
+				return -1;
+
+			uint64_t rank = NearestRank(quantile, total);
+			uint64_t seen = 0;
+			for (size_t bin = 1; bin < ScoreBins; bin++)
+			{
+				seen += histogram[bin];
+				if (seen > rank)
+					return static_cast<int>(bin) - 1;
+			}
+			return 100;
+		}
+
+	private:
+		std::vector<uint8_t> m_platform;
+		std::array<std::vector<uint8_t>, KindCount> m_status;
+		std::array<std::vector<uint8_t>, KindCount> m_reason;
+		std::vector<float> m_ramGB;
+		std::vector<float> m_vramGB;
+		std::vector<int8_t> m_score;
+		std::vector<uint8_t> m_macOSMajor;
+		std::vector<uint32_t> m_cpu;
+		std::vector<uint32_t> m_gpu;
+		StringDictionary m_cpuNames;
+		StringDictionary m_gpuNames;
+
+		// Zero-based index of the nearest-rank percentile among 'count' sorted values
+		static uint64_t NearestRank(double quantile, uint64_t count)
+		{
+			double rank = std::ceil(std::clamp(quantile, 0.0, 1.0) * static_cast<double>(count));
+			return rank < 1 ? 0 : (std::min)(static_cast<uint64_t>(rank) - 1, count - 1);
+		}
+
+		template <typename Results>
+		void AppendRow(TargetPlatform platform, const Results& results, int score,
+			double ramGB, double vramGB, int macOSMajor, std::wstring_view cpu, std::wstring_view gpu)
+		{
+			size_t row = Size();
+			m_platform.push_back(static_cast<uint8_t>(platform));
+			for (size_t kind = 0; kind < KindCount; kind++)
+			{
+				m_status[kind].push_back(NotApplicable);
+				m_reason[kind].push_back(ResultCodes::UnknownReason);
+			}
+			for (const auto& result : results)
+			{
+				size_t kind = static_cast<size_t>(ResultCodes::KindOf(result.Name));
+				if (kind == KindCount)
+					continue;
+				m_status[kind][row] = static_cast<uint8_t>(result.Status);
+				m_reason[kind][row] = ResultCodes::ReasonOf(result.ReasonKey);
+			}
+
+			m_ramGB.push_back(static_cast<float>(ramGB));
+			m_vramGB.push_back(static_cast<float>(vramGB));
+			m_score.push_back(static_cast<int8_t>(std::clamp(score, -1, 100)));
+			m_macOSMajor.push_back(static_cast<uint8_t>(std::clamp(macOSMajor, 0, 255)));
+			m_cpu.push_back(m_cpuNames.Encode(cpu));
+			m_gpu.push_back(m_gpuNames.Encode(gpu));
+		}
+	};
+
+	// Aggregates of one or more stores, through the column kernels: the stores of the
+	// server's workers behind /v1/fleet, or the one "batch --summary" loads
+	struct FleetTotals
+	{
+		static constexpr size_t StatusCount = 3;
+
+		uint64_t Rows = 0;
+		uint64_t Windows = 0;
+		uint64_t MacOS = 0;
+		std::array<std::array<uint64_t, StatusCount>, FleetResultStore::KindCount> Status{};
+		FleetResultStore::ScoreHistogramBins Scores{};
+		double RamSum = 0;           // Over the rows where it was found
+		uint64_t RamFound = 0;
+		double VramSum = 0;
+		uint64_t VramFound = 0;
+
+		void Add(const FleetResultStore& store)
+		{
+			constexpr float found = std::numeric_limits<float>::denorm_min();
+			constexpr float unbounded = std::numeric_limits<float>::infinity();
+
+			Rows += store.Size();
+			Windows += FleetResultStore::CountEqual(store.Platform(), static_cast<uint8_t>(TargetPlatform::Windows));
+			MacOS += FleetResultStore::CountEqual(store.Platform(), static_cast<uint8_t>(TargetPlatform::macOS));
+			for (size_t kind = 0; kind < FleetResultStore::KindCount; kind++)
+			{
+				for (size_t status = 0; status < StatusCount; status++)
+				{
+					Status[kind][status] += FleetResultStore::CountEqual(store.Status(static_cast<CheckKind>(kind)), static_cast<uint8_t>(status));
+				}
+			}
+			FleetResultStore::ScoreHistogramBins scores = FleetResultStore::ScoreHistogram(store.Score());
+			for (size_t bin = 0; bin < FleetResultStore::ScoreBins; bin++)
+			{
+				Scores[bin] += scores[bin];
+			}
+
+			size_t ram = FleetResultStore::CountInRange(store.RamGB(), found, unbounded);
+			size_t vram = FleetResultStore::CountInRange(store.VramGB(), found, unbounded);
+			RamSum += FleetResultStore::AverageFound(store.RamGB()) * static_cast<double>(ram);
+			VramSum += FleetResultStore::AverageFound(store.VramGB()) * static_cast<double>(vram);
+			RamFound += ram;
+			VramFound += vram;
+		}
+
+		std::string ToJson() const
+		{
+			static constexpr double Quantiles[] = { 0.1, 0.5, 0.9 };
+			static constexpr const char* QuantileNames[] = { "p10", "p50", "p90" };
+
+			std::string json = "{\"rows\":";
+			AnalysisJson::AppendNumber(json, Rows);
+			json += ",\"windows\":";
+			AnalysisJson::AppendNumber(json, Windows);
+			json += ",\"macos\":";
+			AnalysisJson::AppendNumber(json, MacOS);
+			json += ",\"score\":{";
+			for (size_t i = 0; i < std::size(Quantiles); i++)
+			{
+				json += i > 0 ? ",\"" : "\"";
+				json += QuantileNames[i];
+				json += "\":";
+				AnalysisJson::AppendNumber(json, FleetResultStore::ScorePercentile(Scores, Quantiles[i]));
+			}
+			json += "},\"noData\":";
+			AnalysisJson::AppendNumber(json, Scores[0]);
+			json += ",\"meanRamGB\":";
+			AnalysisJson::AppendNumber(json, RamFound == 0 ? 0.0 : std::round(RamSum / static_cast<double>(RamFound) * 100) / 100);
+			json += ",\"meanVramGB\":";
+			AnalysisJson::AppendNumber(json, VramFound == 0 ? 0.0 : std::round(VramSum / static_cast<double>(VramFound) * 100) / 100);
+
+			json += ",\"checks\":[";
+			bool first = true;
+			for (size_t kind = 0; kind < FleetResultStore::KindCount; kind++)
+			{
+				if (Status[kind][0] + Status[kind][1] + Status[kind][2] == 0)
+					continue;
+				json += first ? "{\"check\":\"" : ",{\"check\":\"";
+				first = false;
+				json += ResultCodes::CheckNames[kind];
+				json += '"';
+				for (size_t status = 0; status < StatusCount; status++)
+				{
+					json += ",\"";
+					json += AnalysisJson::StatusName(static_cast<StatusLevel>(status));
+					json += "\":";
+					AnalysisJson::AppendNumber(json, Status[kind][status]);
+				}
+				json += '}';
+			}
+			json += "]}";
+			return json;
+		}
+	};
+}
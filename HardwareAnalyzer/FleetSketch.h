@@ -0,0 +1,496 @@
+#pragma once
+#include "pch.h"
+#include "AnalysisJson.h"
+#include "AnalysisPipeline.h"
+#include "FleetResultStore.h"
+#include "ResultCodes.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace HardwareAnalyzer
+{
+	// 64-bit hash of a name for the sketches below: FNV-1a over the code units, then the
+	// MurmurHash3 finalizer so every bit depends on every character
+	inline uint64_t SketchHash(std::wstring_view text)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (wchar_t c : text)
+		{
+			hash = (hash ^ static_cast<uint64_t>(c)) * 1099511628211ull;
+		}
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccdull;
+		hash ^= hash >> 33;
+		hash *= 0xc4ceb9fe1a85ec53ull;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+	// Distinct count estimate in 4 KB, with a standard error of about 1.6%.
+	// Merging takes the larger register, so a merged sketch is the sketch of both streams.
+	class HyperLogLog
+	{
+	public:
+		static constexpr unsigned Precision = 12;
+		static constexpr size_t RegisterCount = size_t{ 1 } << Precision;
+
+		void Add(uint64_t hash)
+		{
+			size_t index = static_cast<size_t>(hash >> (64 - Precision));
+			// The guard bit caps the rank when the remaining bits are all zero
+			uint64_t rest = (hash << Precision) | (uint64_t{ 1 } << (Precision - 1));
+			uint8_t rank = static_cast<uint8_t>(std::countl_zero(rest) + 1);
+			m_registers[index] = (std::max)(m_registers[index], rank);
+		}
+
+		void Merge(const HyperLogLog& other)
+		{
+			for (size_t i = 0; i < RegisterCount; i++)
+			{
+				m_registers[i] = (std::max)(m_registers[i], other.m_registers[i]);
+			}
+		}
+
+		uint64_t Estimate() const
+		{
+			double sum = 0;
+			size_t zeros = 0;
+			for (uint8_t rank : m_registers)
+			{
+				sum += std::ldexp(1.0, -static_cast<int>(rank));
+				zeros += rank == 0;
+			}
+
+			const double m = static_cast<double>(RegisterCount);
+			double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+			// Linear counting is the better estimate while many registers are still empty
+			if (estimate <= 2.5 * m && zeros > 0)
+				estimate = m * std::log(m / static_cast<double>(zeros));
+			return static_cast<uint64_t>(std::llround(estimate));
+		}
+
+	private:
+		std::array<uint8_t, RegisterCount> m_registers{};
+	};
+
+	// Frequency upper bounds for any key in 32 KB: each of the Depth rows counts the key in
+	// one of Width cells, and the smallest of its cells overestimates by at most ~0.3% of the
+	// stream (e / Width) with probability 1 - e^-Depth. Merging adds the cells.
+	class CountMinSketch
+	{
+	public:
+		static constexpr size_t Depth = 4;
+		static constexpr size_t Width = 1024;
+
+		// Counts the key and returns its new estimate
+		uint64_t Add(uint64_t hash)
+		{
+			uint64_t estimate = UINT64_MAX;
+			for (size_t row = 0; row < Depth; row++)
+			{
+				uint64_t& cell = m_cells[row][Cell(hash, row)];
+				cell++;
+				estimate = (std::min)(estimate, cell);
+			}
+			return estimate;
+		}
+
+		uint64_t Estimate(uint64_t hash) const
+		{
+			uint64_t estimate = UINT64_MAX;
+			for (size_t row = 0; row < Depth; row++)
+			{
+				estimate = (std::min)(estimate, m_cells[row][Cell(hash, row)]);
+			}
+			return estimate;
+		}
+
+		void Merge(const CountMinSketch& other)
+		{
+			for (size_t row = 0; row < Depth; row++)
+			{
+				for (size_t i = 0; i < Width; i++)
+				{
+					m_cells[row][i] += other.m_cells[row][i];
+				}
+			}
+		}
+
+	private:
+		std::array<std::array<uint64_t, Width>, Depth> m_cells{};
+
+		// Multiply-shift with a different odd multiplier per row, so that keys sharing a cell
+		// in one row rarely share one in the others
+		static size_t Cell(uint64_t hash, size_t row)
+		{
+			static constexpr uint64_t Multipliers[Depth] = {
+				0x9e3779b97f4a7c15ull, 0xbf58476d1ce4e5b9ull, 0x94d049bb133111ebull, 0xd6e8feb86659fd93ull
+			};
+			return static_cast<size_t>((hash * Multipliers[row]) >> (64 - std::countr_zero(Width)));
+		}
+	};
+
+	// The most frequent names of a stream: a count-min sketch counts every name, and the
+	// Capacity names with the highest estimates so far are kept as candidates. Names are cut
+	// to MaxNameChars, so the memory is fixed however many distinct names go by.
+	class HeavyHitters
+	{
+	public:
+		static constexpr size_t Capacity = 32;
+		static constexpr size_t MaxNameChars = 128;
+
+		struct Entry
+		{
+			std::wstring Name;
+			uint64_t Count = 0;     // Upper bound on the name's frequency
+			uint64_t Hash = 0;
+		};
+
+		void Add(std::wstring_view name)
+		{
+			if (name.empty())
+				return;
+			name = name.substr(0, (std::min)(name.size(), MaxNameChars));
+			uint64_t hash = SketchHash(name);
+			Offer(name, hash, m_counts.Add(hash));
+		}
+
+		// Adds the other stream's counts, then keeps the best of both candidate lists by the
+		// merged estimates
+		void Merge(const HeavyHitters& other)
+		{
+			m_counts.Merge(other.m_counts);
+			std::vector<Entry> candidates(m_entries.begin(), m_entries.end());
+			candidates.insert(candidates.end(), other.m_entries.begin(), other.m_entries.end());
+			m_entries.clear();
+			for (const Entry& candidate : candidates)
+			{
+				Offer(candidate.Name, candidate.Hash, m_counts.Estimate(candidate.Hash));
+			}
+		}
+
+		// Up to 'count' names, most frequent first
+		std::vector<Entry> Top(size_t count) const
+		{
+			std::vector<Entry> top = m_entries;
+			std::sort(top.begin(), top.end(), [](const Entry& a, const Entry& b) {
+				return a.Count != b.Count ? a.Count > b.Count : a.Name < b.Name;
+			});
+			top.resize((std::min)(top.size(), count));
+			return top;
+		}
+
+	private:
+		CountMinSketch m_counts;
+		std::vector<Entry> m_entries;     // At most Capacity, unordered
+
+		void Offer(std::wstring_view name, uint64_t hash, uint64_t estimate)
+		{
+			auto lowest = m_entries.end();
+			for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+			{
+				if (it->Hash == hash)
+				{
+					it->Count = (std::max)(it->Count, estimate);
+					return;
+				}
+				if (lowest == m_entries.end() || it->Count < lowest->Count)
+					lowest = it;
+			}
+
+			if (m_entries.size() < Capacity)
+			{
+				m_entries.push_back({ std::wstring(name), estimate, hash });
+			}
+			else if (estimate > lowest->Count)
+			{
+				lowest->Name.assign(name);
+				lowest->Count = estimate;
+				lowest->Hash = hash;
+			}
+		}
+	};
+
+	// Quantiles of positive values to within 1% of the value, from a fixed array of
+	// logarithmic buckets: bucket i holds (MinValue * Gamma^(i-1), MinValue * Gamma^i].
+	// Covers 1/64 to ~17000 (GB); values outside are counted in the end buckets.
+	class LogHistogram
+	{
+	public:
+		static constexpr double Gamma = 1.02;
+		static constexpr double MinValue = 1.0 / 64;
+		static constexpr size_t BucketCount = 704;
+
+		// Values of 0 or below are "not found" and not counted
+		void Add(double value)
+		{
+			if (!(value > 0))
+				return;
+			double index = std::ceil(std::log(value / MinValue) / std::log(Gamma));
+			m_buckets[static_cast<size_t>(std::clamp(index, 0.0, static_cast<double>(BucketCount - 1)))]++;
+			m_count++;
+		}
+
+		void Merge(const LogHistogram& other)
+		{
+			for (size_t i = 0; i < BucketCount; i++)
+			{
+				m_buckets[i] += other.m_buckets[i];
+			}
+			m_count += other.m_count;
+		}
+
+		uint64_t Count() const { return m_count; }
+
+		// Nearest-rank quantile in [0, 1]; 0 when empty
+		double Quantile(double quantile) const
+		{
+			if (m_count == 0)
+				return 0;
+			double rank = std::ceil(std::clamp(quantile, 0.0, 1.0) * static_cast<double>(m_count));
+			uint64_t index = rank < 1 ? 0 : (std::min)(static_cast<uint64_t>(rank) - 1, m_count - 1);
+
+			uint64_t seen = 0;
+			size_t bucket = 0;
+			for (; bucket + 1 < BucketCount; bucket++)
+			{
+				seen += m_buckets[bucket];
+				if (seen > index)
+					break;
+			}
+			// The point of the bucket with the same relative distance to both ends
+			return MinValue * std::pow(Gamma, static_cast<double>(bucket)) * 2 / (1 + Gamma);
+		}
+
+	private:
+		std::array<uint64_t, BucketCount> m_buckets{};
+		uint64_t m_count = 0;
+	};
+
+	// Running statistics of an unbounded stream of analyses in about 100 KB, whatever the
+	// stream's length. Each producer (e.g. a daemon worker) keeps its own sketch and readers
+	// merge copies, so adding takes no shared lock:
+	//   - scores: exact histogram, the 102 possible values need no approximation
+	//   - RAM/memory and VRAM in GB: LogHistogram quantiles
+	//   - CPU (or Mac chip) and GPU names: HeavyHitters
+	//   - reason frequencies per check and status: exact counters by ResultCodes reason id
+	//   - distinct device, CPU and GPU names: HyperLogLog
+	class FleetSketch
+	{
+	public:
+		static constexpr size_t KindCount = static_cast<size_t>(CheckKind::Count);
+		static constexpr size_t StatusCount = 3;
+
+		template <typename String>
+		void Add(const BasicWindowsAnalysis<String>& analysis)
+		{
+			m_windows++;
+			AddCommon(analysis.Results, analysis.Score, analysis.Info.DeviceName, analysis.Info.Processor);
+			m_ramGB.Add(analysis.Info.RamGB);
+			m_vramGB.Add(analysis.Info.VramGB);
+			m_gpus.Add(analysis.Info.GPU);
+			if (!analysis.Info.GPU.empty())
+				m_distinctGpus.Add(SketchHash(analysis.Info.GPU));
+		}
+
+		template <typename String>
+		void Add(const BasicMacOSAnalysis<String>& analysis)
+		{
+			m_macOS++;
+			AddCommon(analysis.Results, analysis.Score, analysis.Info.DeviceName, analysis.Info.Chip);
+			m_ramGB.Add(analysis.Info.MemoryGB);
+		}
+
+		void Merge(const FleetSketch& other)
+		{
+			m_windows += other.m_windows;
+			m_macOS += other.m_macOS;
+			for (size_t bin = 0; bin < m_scores.size(); bin++)
+			{
+				m_scores[bin] += other.m_scores[bin];
+			}
+			for (size_t kind = 0; kind < KindCount; kind++)
+			{
+				for (size_t status = 0; status < StatusCount; status++)
+				{
+					for (size_t reason = 0; reason < ResultCodes::ReasonCount; reason++)
+					{
+						m_reasons[kind][status][reason] += other.m_reasons[kind][status][reason];
+					}
+				}
+			}
+			m_ramGB.Merge(other.m_ramGB);
+			m_vramGB.Merge(other.m_vramGB);
+			m_processors.Merge(other.m_processors);
+			m_gpus.Merge(other.m_gpus);
+			m_distinctDevices.Merge(other.m_distinctDevices);
+			m_distinctProcessors.Merge(other.m_distinctProcessors);
+			m_distinctGpus.Merge(other.m_distinctGpus);
+		}
+
+		uint64_t Count() const { return m_windows + m_macOS; }
+		const FleetResultStore::ScoreHistogramBins& Scores() const { return m_scores; }
+		const LogHistogram& RamGB() const { return m_ramGB; }
+		const LogHistogram& VramGB() const { return m_vramGB; }
+		const HeavyHitters& Processors() const { return m_processors; }
+		const HeavyHitters& Gpus() const { return m_gpus; }
+		uint64_t DistinctDevices() const { return m_distinctDevices.Estimate(); }
+		uint64_t DistinctProcessors() const { return m_distinctProcessors.Estimate(); }
+		uint64_t DistinctGpus() const { return m_distinctGpus.Estimate(); }
+
+		uint64_t ReasonCount(CheckKind kind, StatusLevel status, uint8_t reason) const
+		{
+			return m_reasons[static_cast<size_t>(kind)][static_cast<size_t>(status)][reason];
+		}
+
+		// {"analyses":..,"windows":..,"macos":..,"score":{"p10":..},"ramGB":{..},"vramGB":{..},
+		//  "topProcessors":[{"name":..,"count":..}],"topGpus":[..],
+		//  "failureReasons":[{"check":..,"status":..,"reasonKey":..,"count":..}],
+		//  "distinctDeviceNames":..,"distinctProcessors":..,"distinctGpus":..}
+		std::string ToJson(size_t topCount = 10) const
+		{
+			static constexpr double Quantiles[] = { 0.1, 0.5, 0.9, 0.99 };
+			static constexpr const char* QuantileNames[] = { "p10", "p50", "p90", "p99" };
+
+			std::string json = "{\"analyses\":";
+			AnalysisJson::AppendNumber(json, Count());
+			json += ",\"windows\":";
+			AnalysisJson::AppendNumber(json, m_windows);
+			json += ",\"macos\":";
+			AnalysisJson::AppendNumber(json, m_macOS);
+
+			json += ",\"score\":{";
+			for (size_t i = 0; i < std::size(Quantiles); i++)
+			{
+				json += i > 0 ? ",\"" : "\"";
+				json += QuantileNames[i];
+				json += "\":";
+				AnalysisJson::AppendNumber(json, FleetResultStore::ScorePercentile(m_scores, Quantiles[i]));
+			}
+			for (auto [name, histogram] : { std::pair{ "ramGB", &m_ramGB }, std::pair{ "vramGB", &m_vramGB } })
+			{
+				json += "},\"";
+				json += name;
+				json += "\":{";
+				for (size_t i = 0; i < std::size(Quantiles); i++)
+				{
+					json += i > 0 ? ",\"" : "\"";
+					json += QuantileNames[i];
+					json += "\":";
+					// Two decimals are well within the histogram's 1%
+					AnalysisJson::AppendNumber(json, std::round(histogram->Quantile(Quantiles[i]) * 100) / 100);
+				}
+			}
+			json += '}';
+
+			AppendTop(json, "topProcessors", m_processors.Top(topCount));
+			AppendTop(json, "topGpus", m_gpus.Top(topCount));
+			AppendFailureReasons(json);
+
+			json += ",\"distinctDeviceNames\":";
+			AnalysisJson::AppendNumber(json, DistinctDevices());
+			json += ",\"distinctProcessors\":";
+			AnalysisJson::AppendNumber(json, DistinctProcessors());
+			json += ",\"distinctGpus\":";
+			AnalysisJson::AppendNumber(json, DistinctGpus());
+			json += '}';
+			return json;
+		}
+
+	private:
+		uint64_t m_windows = 0;
+		uint64_t m_macOS = 0;
+		FleetResultStore::ScoreHistogramBins m_scores{};
+		std::array<std::array<std::array<uint64_t, ResultCodes::ReasonCount>, StatusCount>, KindCount> m_reasons{};
+		LogHistogram m_ramGB;
+		LogHistogram m_vramGB;
+		HeavyHitters m_processors;
+		HeavyHitters m_gpus;
+		HyperLogLog m_distinctDevices;
+		HyperLogLog m_distinctProcessors;
+		HyperLogLog m_distinctGpus;
+
+		template <typename Results>
+		void AddCommon(const Results& results, int score, std::wstring_view deviceName, std::wstring_view processor)
+		{
+			m_scores[static_cast<size_t>(std::clamp(score, -1, 100) + 1)]++;
+			for (const auto& result : results)
+			{
+				size_t kind = static_cast<size_t>(ResultCodes::KindOf(result.Name));
+				size_t status = static_cast<size_t>(result.Status);
+				if (kind < KindCount && status < StatusCount)
+					m_reasons[kind][status][ResultCodes::ReasonOf(result.ReasonKey)]++;
+			}
+
+			m_processors.Add(processor);
+			if (!processor.empty())
+				m_distinctProcessors.Add(SketchHash(processor));
+			if (!deviceName.empty())
+				m_distinctDevices.Add(SketchHash(deviceName));
+		}
+
+		static void AppendTop(std::string& json, const char* name, const std::vector<HeavyHitters::Entry>& top)
+		{
+			json += ",\"";
+			json += name;
+			json += "\":[";
+			for (size_t i = 0; i < top.size(); i++)
+			{
+				json += i > 0 ? ",{\"name\":" : "{\"name\":";
+				AnalysisJson::AppendString(json, top[i].Name);
+				json += ",\"count\":";
+				AnalysisJson::AppendNumber(json, top[i].Count);
+				json += '}';
+			}
+			json += ']';
+		}
+
+		// Every Warning and Bad outcome seen, most frequent first
+		void AppendFailureReasons(std::string& json) const
+		{
+			struct Failure
+			{
+				size_t Kind;
+				StatusLevel Status;
+				uint8_t Reason;
+				uint64_t Count;
+			};
+			std::vector<Failure> failures;
+			for (size_t kind = 0; kind < KindCount; kind++)
+			{
+				for (StatusLevel status : { StatusLevel::Warning, StatusLevel::Bad })
+				{
+					for (size_t reason = 0; reason < ResultCodes::ReasonCount; reason++)
+					{
+						uint64_t count = m_reasons[kind][static_cast<size_t>(status)][reason];
+						if (count > 0)
+							failures.push_back({ kind, status, static_cast<uint8_t>(reason), count });
+					}
+				}
+			}
+			std::stable_sort(failures.begin(), failures.end(), [](const Failure& a, const Failure& b) { return a.Count > b.Count; });
+
+			json += ",\"failureReasons\":[";
+			for (size_t i = 0; i < failures.size(); i++)
+			{
+				json += i > 0 ? ",{\"check\":\"" : "{\"check\":\"";
+				json += ResultCodes::CheckNames[failures[i].Kind];
+				json += "\",\"status\":\"";
+				json += AnalysisJson::StatusName(failures[i].Status);
+				json += "\",\"reasonKey\":\"";
+				json += ResultCodes::ReasonKey(failures[i].Reason);
+				json += "\",\"count\":";
+				AnalysisJson::AppendNumber(json, failures[i].Count);
+				json += '}';
+			}
+			json += ']';
+		}
+	};
+}
@@ -1,8 +1,17 @@
 #pragma once
 #include "pch.h"
+#include "HardwareThresholds.h"
+#include "OcrNormalizer.h"
+#include "OcrTextScanner.h"
+#include "QuantityParser.h"
+#include "RuleStats.h"
+#include "Tracing.h"
+#include "LabelPack.h"
 #include <string>
+#include <string_view>
 #include <vector>
-#include <regex>
+#include <memory>
+#include <memory_resource>
 #include <algorithm>
 
 namespace HardwareAnalyzer
@@ -14,376 +23,568 @@ namespace HardwareAnalyzer
 		Bad
 	};
 
-	struct HardwareCheckResult
+	// The result types are templates over their string type: std::wstring for the app, and
+	// std::pmr::wstring (the pmr:: aliases below) for callers that keep each request's strings
+	// in an arena and drop them all at once.
+	template <typename String>
+	struct BasicHardwareCheckResult
 	{
-		std::wstring Name;
-		std::wstring Value;
+		using Allocator = typename String::allocator_type;
+
+		BasicHardwareCheckResult() = default;
+		explicit BasicHardwareCheckResult(const Allocator& allocator) : Name(allocator), Value(allocator), ReasonKey(allocator) {}
+
+		String Name;
+		String Value;
 		StatusLevel Status;
-		std::wstring ReasonKey;  // Resource key for localization
+		String ReasonKey;  // Resource key for localization
 	};
 
-	struct HardwareInfo
+	// Check results in a vector that allocates from the same place as their strings
+	template <typename String>
+	using BasicCheckResults = std::vector<BasicHardwareCheckResult<String>,
+		typename std::allocator_traits<typename String::allocator_type>::template rebind_alloc<BasicHardwareCheckResult<String>>>;
+
+	template <typename String>
+	struct BasicHardwareInfo
 	{
-		std::wstring DeviceName;
-		std::wstring Processor;
-		std::wstring RAM;
-		std::wstring GPU;
-		std::wstring VRAM;
-		std::wstring SystemType;
+		using Allocator = typename String::allocator_type;
+
+		BasicHardwareInfo() = default;
+		explicit BasicHardwareInfo(const Allocator& allocator)
+			: DeviceName(allocator), Processor(allocator), RAM(allocator), GPU(allocator), VRAM(allocator), SystemType(allocator) {}
+
+		String DeviceName;
+		String Processor;
+		String RAM;
+		String GPU;
+		String VRAM;
+		String SystemType;
 
 		double RamGB = 0;
 		double VramGB = 0;
 	};
 
+	using HardwareCheckResult = BasicHardwareCheckResult<std::wstring>;
+	using HardwareInfo = BasicHardwareInfo<std::wstring>;
+
+	namespace pmr
+	{
+		using HardwareCheckResult = BasicHardwareCheckResult<std::pmr::wstring>;
+		using CheckResults = BasicCheckResults<std::pmr::wstring>;
+		using HardwareInfo = BasicHardwareInfo<std::pmr::wstring>;
+	}
+
+	template <typename String>
+	class BasicLazyHardwareInfo;
+	template <typename String>
+	class BasicShortCircuitScore;
+
 	class HardwareAnalyzerService
 	{
+		// Extract and classify one field at a time (LazyHardwareInfo.h)
+		template <typename String>
+		friend class BasicLazyHardwareInfo;
+		template <typename String>
+		friend class BasicShortCircuitScore;
+
 	public:
 		static HardwareInfo ParseOcrText(const std::wstring& text)
+		{
+			return ParseOcrText(text, ParseLimits{});
+		}
+
+		static HardwareInfo ParseOcrText(const std::wstring& text, const ParseLimits& limits)
 		{
 			HardwareInfo info;
+			Parse(text, limits, info);
+			return info;
+		}
+
+		// Every string of the parse, the normalized copy of the text included, comes from
+		// 'arena' and is never freed on its own: the caller releases the arena instead
+		static pmr::HardwareInfo ParseOcrText(std::wstring_view text, const ParseLimits& limits, std::pmr::memory_resource* arena)
+		{
+			pmr::HardwareInfo info{ pmr::HardwareInfo::Allocator(arena) };
+			Parse(text, limits, info);
+			return info;
+		}
+
+		static std::vector<HardwareCheckResult> AnalyzeHardware(const HardwareInfo& info)
+		{
+			std::vector<HardwareCheckResult> results;
+			Analyze(info, results);
+			return results;
+		}
 
-			// Normalize textn replace common OCR mistakes
-			std::wstring normalizedText = text;
+		// The results and their strings come from the arena 'info' was parsed into
+		static pmr::CheckResults AnalyzeHardware(const pmr::HardwareInfo& info)
+		{
+			pmr::CheckResults results{ info.Processor.get_allocator() };
+			Analyze(info, results);
+			return results;
+		}
+
+		template <typename Results>
+		static int CalculateGlobalScore(const Results& results)
+		{
+			// Count how many results have actual values (not "?")
+			int validResults = 0;
+			for (const auto& result : results)
+			{
+				if (result.Value != L"?")
+					validResults++;
+			}
+
+			// If no data could be extracted, return -1 to indicate no result possible
+			if (validResults == 0)
+			{
+				return -1;
+			}
+
+			// Check for unsupported architecture first - return 0 immediately
+			for (const auto& result : results)
+			{
+				if (result.Value == L"?")
+					continue;
+
+				// If Architecture is Bad (ARM or x86), the system is not supported
+				if (result.Name == L"Architecture" && result.Status == StatusLevel::Bad)
+				{
+					return 0;
+				}
+			}
+
+			int score = 100;
+			for (const auto& result : results)
+			{
+				if (result.Value == L"?")
+					continue; // Don't penalize unknown values
+
+				switch (result.Status)
+				{
+				case StatusLevel::Warning:
+					score -= 15;
+					break;
+				case StatusLevel::Bad:
+					score -= 30;
+					break;
+				default:
+					break;
+				}
+			}
+			return (std::max)(0, score);
+		}
+
+	private:
+		template <typename String>
+		static void Parse(std::wstring_view text, const ParseLimits& limits, BasicHardwareInfo<String>& info)
+		{
+			TraceSpan span{ "ParseOcrText" };
+
+			// Cap the text before scanning it (huge lines, log dumps, blank padding),
+			// then fix common OCR confusions ("1O GB", "Mernory", NBSP, curly quotes)
+			std::shared_ptr<const LabelCatalog> catalog = LabelPack::Active();
+			String normalizedText{ info.DeviceName.get_allocator() };
+			OcrTextScanner::ApplyLimits(text, limits, normalizedText);
+			OcrNormalizer::Normalize(normalizedText, *catalog);
+			std::wstring_view textView = normalizedText;
+
+			// Labels of the page's language (then English, then every language's) when it
+			// can be identified, every language's labels otherwise
+			const LanguageLabels* language = LanguageIdentifier::Identify(textView, *catalog);
+			const LanguageLabels& labels = language ? *language : catalog->All();
+
+			ExtractProcessor(textView, labels, info.Processor);
+			ExtractRAM(textView, labels, info);
+			ExtractGPU(textView, labels, info.GPU);
+			ExtractVRAM(textView, labels, info);
+			ExtractDeviceName(textView, labels, info.DeviceName);
+			ExtractSystemType(textView, labels, info.SystemType);
+		}
+
+		template <typename String>
+		static void Analyze(const BasicHardwareInfo<String>& info, BasicCheckResults<String>& results)
+		{
+			TraceSpan span{ "AnalyzeHardware" };
+			auto allocator = info.Processor.get_allocator();
+			results.reserve(5);
+
+			// Analyze CPU
+			auto& cpuResult = results.emplace_back(allocator);
+			cpuResult.Name = L"Processor";
+			cpuResult.Value = info.Processor.empty() ? std::wstring_view(L"?") : std::wstring_view(info.Processor);
+			cpuResult.Status = AnalyzeCPU(info.Processor, cpuResult.ReasonKey);
+
+			// Analyze GPU
+			auto& gpuResult = results.emplace_back(allocator);
+			gpuResult.Name = L"Graphics Card";
+			gpuResult.Value = info.GPU.empty() ? std::wstring_view(L"?") : std::wstring_view(info.GPU);
+			gpuResult.Status = AnalyzeGPU(info.GPU, info.VramGB, gpuResult.ReasonKey);
+
+			// Analyze RAM
+			auto& ramResult = results.emplace_back(allocator);
+			ramResult.Name = L"RAM";
+			ramResult.Value = info.RAM.empty() ? std::wstring_view(L"?") : std::wstring_view(info.RAM);
+			ramResult.Status = AnalyzeRAM(info.RamGB, ramResult.ReasonKey);
+
+			// Analyze VRAM (shared memory check)
+			auto& vramResult = results.emplace_back(allocator);
+			vramResult.Name = L"Video Memory";
+			vramResult.Value = info.VRAM.empty() ? std::wstring_view(L"?") : std::wstring_view(info.VRAM);
+			vramResult.Status = AnalyzeVRAM(info.VramGB, info.GPU, vramResult.ReasonKey);
+
+			// Analyze System Architecture
+			auto& archResult = results.emplace_back(allocator);
+			archResult.Name = L"Architecture";
+			archResult.Status = AnalyzeArchitecture(info.SystemType, info.Processor, archResult.ReasonKey, archResult.Value);
+		}
+
+		template <typename String>
+		static void ExtractDeviceName(std::wstring_view text, const LanguageLabels& labels, String& deviceName)
+		{
+			RuleProbe probe{ Rule::DeviceNameLabel };
+			for (const LanguageLabels* set = &labels; set; set = set->Fallback)
+			{
+				if (OcrTextScanner::FindLabeledLine(text, set->Labels(LabelField::DeviceName), deviceName))
+				{
+					probe.Match();
+					return;
+				}
+			}
+		}
+
+		template <typename String>
+		static void ExtractProcessor(std::wstring_view text, const LanguageLabels& labels, String& processor)
+		{
+			TraceSpan span{ "ExtractProcessor" };
 
 			// Extract processor/CPU - multi-language support
-			// English: Processor, French: Processeur, German: Prozessor, Spanish: Procesador
-			std::wregex cpuRegex(LR"((?:Processor|Processeur|Prozessor|Procesador)\s*[:\-]?\s*(.+?)(?:\n|$))", std::regex::icase);
-			std::wsmatch cpuMatch;
-			if (std::regex_search(normalizedText, cpuMatch, cpuRegex))
+			// English: Processor, French: Processeur, German: Prozessor, ... (see BuiltInLabels.h)
+			RuleProbe probe{ Rule::ProcessorLabel };
+			for (const LanguageLabels* set = &labels; set; set = set->Fallback)
 			{
-				info.Processor = cpuMatch[1].str();
-				// Clean up trailing whitespace
-				info.Processor.erase(info.Processor.find_last_not_of(L" \t\r\n") + 1);
+				if (OcrTextScanner::FindLabeledLine(text, set->Labels(LabelField::Processor), processor))
+				{
+					probe.Match();
+					return;
+				}
 			}
 
 			// Also check for CPU in header cards format (like "AMD Ryzen 9 7900...")
-			if (info.Processor.empty())
+			// Same as "(AMD|Intel|Qualcomm|Apple)[^\n]+(?:Core|Ryzen|Xeon|Snapdragon|M\d)[^\n]+":
+			// the first vendor of a line that comes before its last model keyword.
+			probe.Attempt(Rule::ProcessorHeaderCard);
+			for (size_t lineStart = 0; lineStart < text.size();)
 			{
-				std::wregex cpuHeaderRegex(LR"((AMD|Intel|Qualcomm|Apple)[^\n]+(?:Core|Ryzen|Xeon|Snapdragon|M\d)[^\n]+)", std::regex::icase);
-				if (std::regex_search(normalizedText, cpuMatch, cpuHeaderRegex))
+				size_t lineEnd = OcrTextScanner::LineEnd(text, lineStart);
+				std::wstring_view line = text.substr(0, lineEnd);
+
+				// The keyword must be followed by at least one character
+				size_t keywordEnd = 0;
+				size_t keyword = lineEnd > lineStart
+					? OcrTextScanner::FindLastAny(text, lineStart, lineEnd - 1, { L"core", L"ryzen", L"xeon", L"snapdragon", L"m#" }, keywordEnd)
+					: OcrTextScanner::npos;
+
+				for (size_t pos = lineStart; keyword != OcrTextScanner::npos && pos < keyword; pos++)
 				{
-					info.Processor = cpuMatch[0].str();
+					size_t vendorLength = OcrTextScanner::MatchAnyAt(line, pos, { L"amd", L"intel", L"qualcomm", L"apple" });
+					if (vendorLength > 0 && pos + vendorLength < keyword)
+					{
+						probe.Match();
+						processor.assign(text.substr(pos, lineEnd - pos));
+						return;
+					}
 				}
+				lineStart = lineEnd + 1;
 			}
+		}
 
+		template <typename String>
+		static void ExtractRAM(std::wstring_view text, const LanguageLabels& labels, BasicHardwareInfo<String>& info)
+		{
+			TraceSpan span{ "ExtractRAM" };
 			// Extract RAM - multi-language
-			// English: Installed RAM, French: Mmoire RAM installe, German: Installierter RAM
-			std::wregex ramRegex(LR"((?:Installed RAM|RAM install[e]e?|M[e]moire RAM install[e]e?|Installierter RAM|Memoria RAM)\s*[:\-]?\s*(\d+[\.,]?\d*)\s*(GB|Go|GiB|TB|To))", std::regex::icase);
-			std::wsmatch ramMatch;
-			if (std::regex_search(normalizedText, ramMatch, ramRegex))
-			{
-				info.RAM = ramMatch[1].str() + L" " + ramMatch[2].str();
-				std::wstring ramValue = ramMatch[1].str();
-				// Replace comma with dot for parsing
-				std::replace(ramValue.begin(), ramValue.end(), L',', L'.');
-				try {
-					info.RamGB = std::stod(ramValue);
-					std::wstring unit = ramMatch[2].str();
-					std::transform(unit.begin(), unit.end(), unit.begin(), ::towlower);
-					if (unit == L"tb" || unit == L"to") {
-						info.RamGB *= 1024;
+			// English: Installed RAM, French: Mémoire RAM installée, German: Installierter RAM
+			OcrTextScanner::QuantityMatch ramMatch;
+			RuleProbe probe{ Rule::RamLabel };
+			for (const LanguageLabels* set = &labels; set; set = set->Fallback)
+			{
+				if (OcrTextScanner::FindLabeledQuantity(text, set->Labels(LabelField::InstalledRam), true, set->Labels(LabelField::RamUnits), ramMatch))
+				{
+					probe.Match();
+					ramMatch.AssignNumberAndUnit(text, info.RAM);
+					uint64_t bytes = 0;
+					if (QuantityParser::Parse(text, ramMatch, bytes))
+					{
+						info.RamGB = QuantityParser::ToGB(bytes);
 					}
+					break;
 				}
-				catch (...) {}
 			}
 
 			// Also try simpler RAM pattern from header cards
 			if (info.RamGB == 0)
 			{
-				std::wregex ramSimpleRegex(LR"((\d+[\.,]?\d*)\s*(GB|Go|GiB))", std::regex::icase);
-				std::wstring::const_iterator searchStart(normalizedText.cbegin());
-				while (std::regex_search(searchStart, normalizedText.cend(), ramMatch, ramSimpleRegex))
+				probe.Attempt(Rule::RamHeaderCard);
+				size_t searchStart = 0;
+				while (OcrTextScanner::FindQuantity(text, searchStart, true, { L"gb", L"go", L"gib" }, ramMatch))
 				{
-					std::wstring ramValue = ramMatch[1].str();
-					std::replace(ramValue.begin(), ramValue.end(), L',', L'.');
-					try {
-						double val = std::stod(ramValue);
+					uint64_t bytes = 0;
+					if (QuantityParser::Parse(text, ramMatch, bytes))
+					{
+						double val = QuantityParser::ToGB(bytes);
 						// RAM is usually 8, 12, 16, 32, 64, 128 GB
-						if (val >= 4 && val <= 256 && info.RamGB == 0) {
+						bool accepted = val >= 4 && val <= 256 && info.RamGB == 0;
+						RuleProbe::Count(Rule::RamHeaderCardCandidate, accepted);
+						if (accepted) {
 							info.RamGB = val;
-							info.RAM = ramMatch[0].str();
+							info.RAM.assign(ramMatch.Text(text));
+							probe.Match();
 						}
 					}
-					catch (...) {}
-					searchStart = ramMatch.suffix().first;
+					searchStart = ramMatch.End;
 				}
 			}
+		}
+
+		template <typename String>
+		static void ExtractGPU(std::wstring_view text, const LanguageLabels& labels, String& gpu)
+		{
+			TraceSpan span{ "ExtractGPU" };
 
 			// Extract GPU - multi-language
 			// English: Graphics card, French: Carte graphique, German: Grafikkarte
 			// First, check for "Multiple GPUs" pattern in the header cards (Windows 11 style)
-			std::wregex multiGpuRegex(LR"((?:Plusieurs\s+GPU|Multiple\s+GPU|Mehrere\s+GPU)[^\n]*)", std::regex::icase);
-			std::wsmatch gpuMatch;
-			
-			// Before parsing GPU, try to extract VRAM from the GPU card header (Windows 11 style: "Carte graphique 16 GB" or "128 MB")
-			if (info.VramGB == 0)
-			{
-				std::wregex gpuCardVramRegex(LR"((?:Graphics card|Carte graphique|Grafikkarte)\s*[:\-]?\s*(\d+)\s*(GB|Go|MB|Mo))", std::regex::icase);
-				std::wsmatch gpuCardVramMatch;
-				if (std::regex_search(normalizedText, gpuCardVramMatch, gpuCardVramRegex))
+			size_t length = 0;
+			RuleProbe probe{ Rule::GpuMultipleHeader };
+			if (OcrTextScanner::FindAny(text, { L"plusieurs gpu", L"multiple gpu", L"mehrere gpu" }, 0, length) != OcrTextScanner::npos)
+			{
+				probe.Match();
+				gpu = L"[MULTIPLE_GPU]";
+				return;
+			}
+
+			// Try standard GPU extraction
+			probe.Attempt(Rule::GpuLabel);
+			const LanguageLabels* set = &labels;
+			while (set && !OcrTextScanner::FindLabeledLine(text, set->Labels(LabelField::GraphicsCard), gpu))
+				set = set->Fallback;
+			if (set)
+			{
+				probe.Match();
+				// Clean up GPU value - stop at the first label of another field
+				// This handles OCR that concatenates multiple fields
+				size_t cutPos = String::npos;
+				for (const LanguageLabels* stops = &labels; stops; stops = stops->Fallback)
 				{
-					try {
-						info.VramGB = std::stod(gpuCardVramMatch[1].str());
-						std::wstring unit = gpuCardVramMatch[2].str();
-						std::transform(unit.begin(), unit.end(), unit.begin(), ::towlower);
-						if (unit == L"mb" || unit == L"mo") {
-							info.VramGB /= 1024.0;
-						}
-						info.VRAM = gpuCardVramMatch[1].str() + L" " + gpuCardVramMatch[2].str();
+					size_t length = 0;
+					size_t pos = OcrTextScanner::FindAny(gpu, stops->Labels(LabelField::GpuStopLabels), 0, length);
+					if (pos != OcrTextScanner::npos && (cutPos == String::npos || pos < cutPos))
+					{
+						cutPos = pos;
 					}
-					catch (...) {}
 				}
+				if (cutPos != String::npos && cutPos > 0)
+				{
+					gpu.resize(cutPos);
+					OcrTextScanner::TrimRight(gpu);
+				}
+				return;
 			}
-			
-			if (std::regex_search(normalizedText, gpuMatch, multiGpuRegex))
-			{
-				info.GPU = L"[MULTIPLE_GPU]";
-			}
-			else
+
+			// Check for GPU in text (NVIDIA, AMD, Intel patterns) if still empty
+			// Same as "(NVIDIA|GeForce|Radeon|Intel.*(?:UHD|Iris|Arc)|AMD.*Radeon|Qualcomm.*Adreno)[^\n]*"
+			probe.Attempt(Rule::GpuVendorLine);
+			for (size_t lineStart = 0; lineStart < text.size();)
 			{
-				// Try standard GPU extraction
-				std::wregex gpuRegex(LR"((?:Graphics card|Carte graphique|Grafikkarte|Tarjeta gr[a]fica)\s*[:\-]?\s*(.+?)(?:\n|$))", std::regex::icase);
-				if (std::regex_search(normalizedText, gpuMatch, gpuRegex))
-				{
-					info.GPU = gpuMatch[1].str();
-					info.GPU.erase(info.GPU.find_last_not_of(L" \t\r\n") + 1);
-
-					// Clean up GPU value - stop at known non-GPU patterns
-					// This handles OCR that concatenates multiple fields
-					size_t cutPos = std::wstring::npos;
-					std::vector<std::wstring> stopPatterns = {
-						L"Plusieurs", L"Multiple", L"Mmoire", L"Memory",
-						L"Processeur", L"Processor", L"Nom de", L"Device name"
-					};
-					for (const auto& pattern : stopPatterns)
-					{
-						size_t pos = info.GPU.find(pattern);
-						if (pos != std::wstring::npos && (cutPos == std::wstring::npos || pos < cutPos))
-						{
-							cutPos = pos;
-						}
-					}
-					if (cutPos != std::wstring::npos && cutPos > 0)
-					{
-						info.GPU = info.GPU.substr(0, cutPos);
-						info.GPU.erase(info.GPU.find_last_not_of(L" \t\r\n") + 1);
-					}
+				size_t lineEnd = OcrTextScanner::LineEnd(text, lineStart);
+				std::wstring_view line = text.substr(0, lineEnd);
+
+				size_t keywordEnd = 0;
+				size_t lastIntelModel = OcrTextScanner::FindLastAny(text, lineStart, lineEnd, { L"uhd", L"iris", L"arc" }, keywordEnd);
+				size_t lastRadeon = OcrTextScanner::FindLastAny(text, lineStart, lineEnd, { L"radeon" }, keywordEnd);
+				size_t lastAdreno = OcrTextScanner::FindLastAny(text, lineStart, lineEnd, { L"adreno" }, keywordEnd);
 
-					// If after cleanup, GPU only contains size info (like "16 GB"), check for multiple GPUs
-					std::wregex sizeOnlyRegex(LR"(^\d+\s*(GB|Go)\s*$)", std::regex::icase);
-					if (std::regex_match(info.GPU, sizeOnlyRegex))
+				auto precedes = [](size_t end, size_t keyword) { return keyword != OcrTextScanner::npos && end <= keyword; };
+
+				for (size_t pos = lineStart; pos < lineEnd; pos++)
+				{
+					size_t length = 0;
+					if (OcrTextScanner::MatchAnyAt(line, pos, { L"nvidia", L"geforce", L"radeon" }) > 0 ||
+						((length = OcrTextScanner::MatchAt(line, pos, L"intel")) > 0 && precedes(pos + length, lastIntelModel)) ||
+						((length = OcrTextScanner::MatchAt(line, pos, L"amd")) > 0 && precedes(pos + length, lastRadeon)) ||
+						((length = OcrTextScanner::MatchAt(line, pos, L"qualcomm")) > 0 && precedes(pos + length, lastAdreno)))
 					{
-						// Check if "Plusieurs GPU" is elsewhere in text
-						if (std::regex_search(normalizedText, multiGpuRegex))
-						{
-							info.GPU = L"[MULTIPLE_GPU]";
-						}
+						probe.Match();
+						gpu.assign(text.substr(pos, lineEnd - pos));
+						return;
 					}
 				}
+				lineStart = lineEnd + 1;
 			}
+		}
 
-			// Check for GPU in text (NVIDIA, AMD, Intel patterns) if still empty
-			if (info.GPU.empty())
+		template <typename String>
+		static void ExtractVRAM(std::wstring_view text, const LanguageLabels& labels, BasicHardwareInfo<String>& info)
+		{
+			TraceSpan span{ "ExtractVRAM" };
+			OcrTextScanner::QuantityMatch vramMatch;
+
+			// Try to extract VRAM from the GPU card header (Windows 11 style: "Carte graphique 16 GB" or "128 MB")
+			RuleProbe probe{ Rule::VramCardHeader };
+			for (const LanguageLabels* set = &labels; set; set = set->Fallback)
 			{
-				std::wregex gpuPatternRegex(LR"((NVIDIA|GeForce|Radeon|Intel.*(?:UHD|Iris|Arc)|AMD.*Radeon|Qualcomm.*Adreno)[^\n]*)", std::regex::icase);
-				if (std::regex_search(normalizedText, gpuMatch, gpuPatternRegex))
+				if (OcrTextScanner::FindLabeledQuantity(text, set->Labels(LabelField::GraphicsCard), false, { L"gb", L"go", L"mb", L"mo" }, vramMatch))
 				{
-					info.GPU = gpuMatch[0].str();
+					probe.Match();
+					uint64_t bytes = 0;
+					if (QuantityParser::Parse(text, vramMatch, bytes))
+					{
+						info.VramGB = QuantityParser::ToGB(bytes);
+						vramMatch.AssignNumberAndUnit(text, info.VRAM);
+					}
+					break;
 				}
 			}
 
 			// Extract VRAM if present
-			std::wregex vramRegex(LR"((?:VRAM|Video RAM|GPU Memory|M[e]moire vid[e]o)\s*[:\-]?\s*(\d+[\.,]?\d*)\s*(GB|Go|GiB|MB|Mo))", std::regex::icase);
-			std::wsmatch vramMatch;
-			if (std::regex_search(normalizedText, vramMatch, vramRegex))
-			{
-				info.VRAM = vramMatch[1].str() + L" " + vramMatch[2].str();
-				std::wstring vramValue = vramMatch[1].str();
-				std::replace(vramValue.begin(), vramValue.end(), L',', L'.');
-				try {
-					info.VramGB = std::stod(vramValue);
-					std::wstring unit = vramMatch[2].str();
-					std::transform(unit.begin(), unit.end(), unit.begin(), ::towlower);
-					if (unit == L"mb" || unit == L"mo") {
-						info.VramGB /= 1024;
-					}
+			probe.Attempt(Rule::VramLabel);
+			if (OcrTextScanner::FindLabeledQuantity(text, { L"vram", L"video ram", L"gpu memory", L"memoire video" },
+				true, { L"gb", L"go", L"gib", L"mb", L"mo" }, vramMatch))
+			{
+				probe.Match();
+				vramMatch.AssignNumberAndUnit(text, info.VRAM);
+				uint64_t bytes = 0;
+				if (QuantityParser::Parse(text, vramMatch, bytes))
+				{
+					info.VramGB = QuantityParser::ToGB(bytes);
 				}
-				catch (...) {}
 			}
 
 			// Look for VRAM in GPU section (e.g., "16 GB" near GPU info)
 			if (info.VramGB == 0 && !info.GPU.empty())
 			{
 				// Check if GPU line contains memory info
-				std::wregex gpuVramRegex(LR"((\d+)\s*(GB|Go))", std::regex::icase);
-				if (std::regex_search(info.GPU, vramMatch, gpuVramRegex))
+				probe.Attempt(Rule::VramFromGpuName);
+				if (OcrTextScanner::FindQuantity(info.GPU, 0, false, { L"gb", L"go" }, vramMatch))
 				{
-					try {
-						info.VramGB = std::stod(vramMatch[1].str());
-						info.VRAM = vramMatch[0].str();
+					probe.Match();
+					uint64_t bytes = 0;
+					if (QuantityParser::Parse(info.GPU, vramMatch, bytes))
+					{
+						info.VramGB = QuantityParser::ToGB(bytes);
+						info.VRAM.assign(vramMatch.Text(info.GPU));
 					}
-					catch (...) {}
 				}
 			}
+		}
 
-			// Extract device name
-			std::wregex deviceRegex(LR"((?:Device name|Nom de l'appareil|Ger[a]tename|Nombre del dispositivo)\s*[:\-]?\s*(.+?)(?:\n|$))", std::regex::icase);
-			std::wsmatch deviceMatch;
-			if (std::regex_search(normalizedText, deviceMatch, deviceRegex))
-			{
-				info.DeviceName = deviceMatch[1].str();
-				info.DeviceName.erase(info.DeviceName.find_last_not_of(L" \t\r\n") + 1);
-			}
+		template <typename String>
+		static void ExtractSystemType(std::wstring_view text, const LanguageLabels& labels, String& systemType)
+		{
+			TraceSpan span{ "ExtractSystemType" };
 
 			// Extract system type - look for architecture-specific patterns
-			// French: "Systme d'exploitation 64 bits, processeur x64"
+			// French: "Système d'exploitation 64 bits, processeur x64"
 			// English: "64-bit operating system, x64-based processor"
-			std::wregex systemRegex(LR"((?:System type|Type du syst[e]me|Systemtyp|Tipo de sistema)\s*[:\-]?\s*(.+?)(?:\n|$))", std::regex::icase);
-			std::wsmatch systemMatch;
-			if (std::regex_search(normalizedText, systemMatch, systemRegex))
+			RuleProbe probe{ Rule::SystemTypeLabel };
+			for (const LanguageLabels* set = &labels; set; set = set->Fallback)
 			{
-				info.SystemType = systemMatch[1].str();
-				info.SystemType.erase(info.SystemType.find_last_not_of(L" \t\r\n") + 1);
+				if (OcrTextScanner::FindLabeledLine(text, set->Labels(LabelField::SystemType), systemType))
+					break;
 			}
 
 			// If SystemType doesn't contain architecture info, try to find it directly
-			if (info.SystemType.empty() ||
-				(info.SystemType.find(L"64") == std::wstring::npos &&
-					info.SystemType.find(L"32") == std::wstring::npos &&
-					info.SystemType.find(L"ARM") == std::wstring::npos &&
-					info.SystemType.find(L"arm") == std::wstring::npos &&
-					info.SystemType.find(L"x64") == std::wstring::npos &&
-					info.SystemType.find(L"x86") == std::wstring::npos))
-			{
-				// Look for architecture patterns directly in text
-				std::wregex archRegex(LR"((64[- ]?bit|32[- ]?bit|x64|x86|ARM64|ARM|aarch64)[^\n]*(?:processor|processeur|based|bas[e]))", std::regex::icase);
-				if (std::regex_search(normalizedText, systemMatch, archRegex))
-				{
-					info.SystemType = systemMatch[0].str();
-				}
-				// Also check for standalone architecture mentions
-				else
-				{
-					std::wregex simpleArchRegex(LR"((?:processeur|processor)\s+(x64|x86|ARM64|ARM))", std::regex::icase);
-					if (std::regex_search(normalizedText, systemMatch, simpleArchRegex))
-					{
-						info.SystemType = systemMatch[0].str();
-					}
-				}
-			}
-
-			return info;
-		}
-
-		static std::vector<HardwareCheckResult> AnalyzeHardware(const HardwareInfo& info)
-		{
-			std::vector<HardwareCheckResult> results;
-
-			// Analyze CPU
-			HardwareCheckResult cpuResult;
-			cpuResult.Name = L"Processor";
-			cpuResult.Value = info.Processor.empty() ? L"?" : info.Processor;
-			cpuResult.Status = AnalyzeCPU(info.Processor, cpuResult.ReasonKey);
-			results.push_back(cpuResult);
-
-			// Analyze GPU
-			HardwareCheckResult gpuResult;
-			gpuResult.Name = L"Graphics Card";
-			gpuResult.Value = info.GPU.empty() ? L"?" : info.GPU;
-			gpuResult.Status = AnalyzeGPU(info.GPU, info.VramGB, gpuResult.ReasonKey);
-			results.push_back(gpuResult);
-
-			// Analyze RAM
-			HardwareCheckResult ramResult;
-			ramResult.Name = L"RAM";
-			ramResult.Value = info.RAM.empty() ? L"?" : info.RAM;
-			ramResult.Status = AnalyzeRAM(info.RamGB, ramResult.ReasonKey);
-			results.push_back(ramResult);
-
-			// Analyze VRAM (shared memory check)
-			HardwareCheckResult vramResult;
-			vramResult.Name = L"Video Memory";
-			vramResult.Value = info.VRAM.empty() ? L"?" : info.VRAM;
-			vramResult.Status = AnalyzeVRAM(info.VramGB, info.GPU, vramResult.ReasonKey);
-			results.push_back(vramResult);
-
-			// Analyze System Architecture
-			HardwareCheckResult archResult;
-			archResult.Name = L"Architecture";
-			std::wstring detectedArch;
-			archResult.Status = AnalyzeArchitecture(info.SystemType, info.Processor, archResult.ReasonKey, detectedArch);
-			archResult.Value = detectedArch;
-			results.push_back(archResult);
-
-			return results;
-		}
-
-		static int CalculateGlobalScore(const std::vector<HardwareCheckResult>& results)
-		{
-			// Count how many results have actual values (not "?")
-			int validResults = 0;
-			for (const auto& result : results)
+			if (!systemType.empty() &&
+				(systemType.find(L"64") != String::npos ||
+					systemType.find(L"32") != String::npos ||
+					systemType.find(L"ARM") != String::npos ||
+					systemType.find(L"arm") != String::npos ||
+					systemType.find(L"x64") != String::npos ||
+					systemType.find(L"x86") != String::npos))
 			{
-				if (result.Value != L"?")
-					validResults++;
+				probe.Match();
+				return;
 			}
 
-			// If no data could be extracted, return -1 to indicate no result possible
-			if (validResults == 0)
+			// Look for architecture patterns directly in text
+			// Same as "(64[- ]?bit|32[- ]?bit|x64|x86|ARM64|ARM|aarch64)[^\n]*(?:processor|processeur|based|basé)"
+			probe.Attempt(Rule::SystemTypeArchLine);
+			for (size_t lineStart = 0; lineStart < text.size();)
 			{
-				return -1;
-			}
+				size_t lineEnd = OcrTextScanner::LineEnd(text, lineStart);
+				std::wstring_view line = text.substr(0, lineEnd);
 
-			// Check for unsupported architecture first - return 0 immediately
-			for (const auto& result : results)
-			{
-				if (result.Value == L"?")
-					continue;
+				size_t suffixEnd = 0;
+				size_t suffix = OcrTextScanner::FindLastAny(text, lineStart, lineEnd,
+					{ L"processor", L"processeur", L"based", L"base" }, suffixEnd);
 
-				// If Architecture is Bad (ARM or x86), the system is not supported
-				if (result.Name == L"Architecture" && result.Status == StatusLevel::Bad)
+				for (size_t pos = lineStart; suffix != OcrTextScanner::npos && pos < suffix; pos++)
 				{
-					return 0;
+					for (auto arch : { L"64-bit", L"64 bit", L"32-bit", L"32 bit", L"x64", L"x86", L"arm64", L"arm", L"aarch64" })
+					{
+						size_t length = OcrTextScanner::MatchAt(line, pos, arch);
+						if (length > 0 && pos + length <= suffix)
+						{
+							probe.Match();
+							systemType.assign(text.substr(pos, suffixEnd - pos));
+							return;
+						}
+					}
 				}
+				lineStart = lineEnd + 1;
 			}
 
-			int score = 100;
-			for (const auto& result : results)
+			// Also check for standalone architecture mentions
+			// Same as "(?:processeur|processor)\s+(x64|x86|ARM64|ARM)"
+			probe.Attempt(Rule::SystemTypeProcessorArch);
+			for (size_t pos = 0; pos < text.size(); pos++)
 			{
-				if (result.Value == L"?")
-					continue; // Don't penalize unknown values
+				size_t length = OcrTextScanner::MatchAnyAt(text, pos, { L"processeur", L"processor" });
+				if (length == 0)
+					continue;
 
-				switch (result.Status)
+				size_t archStart = OcrTextScanner::SkipWhitespace(text, pos + length);
+				size_t archLength = OcrTextScanner::MatchAnyAt(text, archStart, { L"x64", L"x86", L"arm64", L"arm" });
+				if (archStart > pos + length && archLength > 0)
 				{
-				case StatusLevel::Warning:
-					score -= 15;
-					break;
-				case StatusLevel::Bad:
-					score -= 30;
-					break;
-				default:
-					break;
+					probe.Match();
+					systemType.assign(text.substr(pos, archStart + archLength - pos));
+					return;
 				}
 			}
-			return (std::max)(0, score);
 		}
 
-	private:
-		static StatusLevel AnalyzeCPU(const std::wstring& cpu, std::wstring& reasonKey)
+		// Lowercase copy that allocates from the same place as the original
+		template <typename String>
+		static String ToLower(const String& text)
 		{
+			String lower{ text, text.get_allocator() };
+			std::transform(lower.begin(), lower.end(), lower.begin(), ::towlower);
+			return lower;
+		}
+
+		template <typename String>
+		static StatusLevel AnalyzeCPU(const String& cpu, String& reasonKey)
+		{
+			TraceSpan span{ "AnalyzeCPU" };
+			RuleProbe probe{ Rule::CpuNotFound };
 			if (cpu.empty())
 			{
+				probe.Match();
 				reasonKey = L"Reason_CPUNotFound";
 				return StatusLevel::Warning;
 			}
 
-			std::wstring cpuLower = cpu;
-			std::transform(cpuLower.begin(), cpuLower.end(), cpuLower.begin(), ::towlower);
+			String cpuLower = ToLower(cpu);
 
 			// Check for Qualcomm ARM (bad)
+			probe.Attempt(Rule::CpuQualcomm);
 			if (cpuLower.find(L"qualcomm") != std::wstring::npos ||
 				cpuLower.find(L"snapdragon") != std::wstring::npos)
 			{
+				probe.Match();
 				reasonKey = L"Reason_QualcommARM";
 				return StatusLevel::Bad;
 			}
@@ -392,11 +593,21 @@ namespace HardwareAnalyzer
 			// Modern CPUs (2020+): Intel 10th gen+, AMD Ryzen 3000+
 
 			// Intel Core patterns
-			std::wregex intelGenRegex(LR"(i[3579]-(\d{2})(\d{2,3}))", std::regex::icase);
-			std::wsmatch intelMatch;
-			if (std::regex_search(cpuLower, intelMatch, intelGenRegex))
+			// Same as "i[3579]-(\d{2})(\d{2,3})", scanned so that nothing but cpuLower allocates
+			probe.Attempt(Rule::CpuIntelGeneration);
+			std::wstring_view cpuView = cpuLower;
+			size_t intelDigits = OcrTextScanner::npos;
+			for (size_t pos = 0; pos + 3 < cpuView.size() && intelDigits == OcrTextScanner::npos; pos++)
+			{
+				if (cpuView[pos] == L'i' && std::wstring_view(L"3579").find(cpuView[pos + 1]) != std::wstring_view::npos &&
+					cpuView[pos + 2] == L'-' && OcrTextScanner::SkipDigits(cpuView, pos + 3) >= pos + 3 + 4)
+					intelDigits = pos + 3;
+			}
+			if (intelDigits != OcrTextScanner::npos)
 			{
-				int gen = std::stoi(intelMatch[1].str());
+				probe.Match();
+				int gen = 0;
+				QuantityParser::ParseInteger(cpuView.substr(intelDigits, 2), gen);
 				if (gen >= 10)
 				{
 					reasonKey = L"Reason_ModernIntel";
@@ -410,11 +621,24 @@ namespace HardwareAnalyzer
 			}
 
 			// AMD Ryzen patterns
-			std::wregex ryzenRegex(LR"(ryzen\s*[3579]\s*(\d)(\d{3}))", std::regex::icase);
-			std::wsmatch ryzenMatch;
-			if (std::regex_search(cpuLower, ryzenMatch, ryzenRegex))
+			// Same as "ryzen\s*[3579]\s*(\d)(\d{3})"
+			probe.Attempt(Rule::CpuRyzenSeries);
+			size_t ryzenDigits = OcrTextScanner::npos;
+			for (size_t pos = 0; pos < cpuView.size() && ryzenDigits == OcrTextScanner::npos; pos++)
+			{
+				if (cpuView.compare(pos, 5, L"ryzen") != 0)
+					continue;
+				size_t tier = OcrTextScanner::SkipWhitespace(cpuView, pos + 5);
+				if (tier == cpuView.size() || std::wstring_view(L"3579").find(cpuView[tier]) == std::wstring_view::npos)
+					continue;
+				size_t digits = OcrTextScanner::SkipWhitespace(cpuView, tier + 1);
+				if (OcrTextScanner::SkipDigits(cpuView, digits) >= digits + 4)
+					ryzenDigits = digits;
+			}
+			if (ryzenDigits != OcrTextScanner::npos)
 			{
-				int series = std::stoi(ryzenMatch[1].str());
+				probe.Match();
+				int series = cpuView[ryzenDigits] - L'0';
 				if (series >= 3)
 				{
 					reasonKey = L"Reason_ModernRyzen";
@@ -428,59 +652,74 @@ namespace HardwareAnalyzer
 			}
 
 			// Check for known old CPU families
+			probe.Attempt(Rule::CpuLowPerfFamily);
 			if (cpuLower.find(L"pentium") != std::wstring::npos ||
 				cpuLower.find(L"celeron") != std::wstring::npos ||
 				cpuLower.find(L"atom") != std::wstring::npos)
 			{
+				probe.Match();
 				reasonKey = L"Reason_LowPerfCPU";
 				return StatusLevel::Warning;
 			}
 
 			// Check for Intel Core without generation (older naming)
+			probe.Attempt(Rule::CpuCore2);
 			if (cpuLower.find(L"core 2") != std::wstring::npos ||
 				cpuLower.find(L"core2") != std::wstring::npos)
 			{
+				probe.Match();
 				reasonKey = L"Reason_VeryOldCPU";
 				return StatusLevel::Bad;
 			}
 
 			// Default for unrecognized but present CPU
+			probe.Attempt(Rule::CpuDefault);
+			probe.Match();
 			reasonKey = L"Reason_CPUDetected";
 			return StatusLevel::Good;
 		}
 
-		static StatusLevel AnalyzeGPU(const std::wstring& gpu, double vramGB, std::wstring& reasonKey)
+		template <typename String>
+		static StatusLevel AnalyzeGPU(const String& gpu, double vramGB, String& reasonKey)
 		{
+			TraceSpan span{ "AnalyzeGPU" };
+			RuleProbe probe{ Rule::GpuNotFound };
 			if (gpu.empty())
 			{
+				probe.Match();
 				reasonKey = L"Reason_GPUNotFound";
 				return StatusLevel::Warning;
 			}
 
-			std::wstring gpuLower = gpu;
-			std::transform(gpuLower.begin(), gpuLower.end(), gpuLower.begin(), ::towlower);
+			String gpuLower = ToLower(gpu);
 
 			// Check for multiple GPUs (usually means integrated + dedicated = good)
+			probe.Attempt(Rule::GpuMultiple);
 			if (gpu == L"[MULTIPLE_GPU]" ||
 				gpuLower.find(L"plusieurs") != std::wstring::npos ||
 				gpuLower.find(L"multiple") != std::wstring::npos ||
 				gpuLower.find(L"mehrere") != std::wstring::npos)
 			{
+				probe.Match();
 				reasonKey = L"Reason_MultipleGPU";
 				return StatusLevel::Good;
 			}
 
 			// Check for Qualcomm Adreno (bad - ARM)
+			probe.Attempt(Rule::GpuQualcomm);
 			if (gpuLower.find(L"adreno") != std::wstring::npos ||
 				gpuLower.find(L"qualcomm") != std::wstring::npos)
 			{
+				probe.Match();
 				reasonKey = L"Reason_QualcommAdreno";
 				return StatusLevel::Bad;
 			}
 
 			// Check for Intel integrated graphics
+			probe.Attempt(Rule::GpuIntel);
 			if (gpuLower.find(L"intel") != std::wstring::npos)
 			{
+				probe.Match();
 				// Intel Arc is dedicated - good
 				if (gpuLower.find(L"arc") != std::wstring::npos)
 				{
@@ -505,19 +744,23 @@ namespace HardwareAnalyzer
 			}
 
 			// NVIDIA dedicated GPU - good
+			probe.Attempt(Rule::GpuNvidia);
 			if (gpuLower.find(L"nvidia") != std::wstring::npos ||
 				gpuLower.find(L"geforce") != std::wstring::npos ||
 				gpuLower.find(L"rtx") != std::wstring::npos ||
 				gpuLower.find(L"gtx") != std::wstring::npos ||
 				gpuLower.find(L"quadro") != std::wstring::npos)
 			{
+				probe.Match();
 				reasonKey = L"Reason_NVIDIADedicated";
 				return StatusLevel::Good;
 			}
 
 			// AMD dedicated GPU - good
+			probe.Attempt(Rule::GpuAmdRadeon);
 			if (gpuLower.find(L"radeon") != std::wstring::npos)
 			{
+				probe.Match();
 				// Check if it's integrated (Vega in APUs)
 				if (gpuLower.find(L"vega") != std::wstring::npos &&
 					(gpuLower.find(L"ryzen") != std::wstring::npos || vramGB < 2))
@@ -530,11 +773,14 @@ namespace HardwareAnalyzer
 			}
 
 			// Default
+			probe.Attempt(Rule::GpuDefault);
+			probe.Match();
 			reasonKey = L"Reason_GPUDetected";
 			return StatusLevel::Good;
 		}
 
-		static StatusLevel AnalyzeRAM(double ramGB, std::wstring& reasonKey)
+		template <typename String>
+		static StatusLevel AnalyzeRAM(double ramGB, String& reasonKey)
 		{
 			if (ramGB <= 0)
 			{
@@ -542,17 +788,17 @@ namespace HardwareAnalyzer
 				return StatusLevel::Warning;
 			}
 
-			if (ramGB < 8)
+			if (ramGB < HardwareThresholds::RamBadGB)
 			{
 				reasonKey = L"Reason_VeryLowRAM";
 				return StatusLevel::Bad;
 			}
-			else if (ramGB < 12)
+			else if (ramGB < HardwareThresholds::RamWarningGB)
 			{
 				reasonKey = L"Reason_LowRAM";
 				return StatusLevel::Warning;
 			}
-			else if (ramGB < 16)
+			else if (ramGB < HardwareThresholds::RamGoodGB)
 			{
 				reasonKey = L"Reason_AcceptableRAM";
 				return StatusLevel::Good;
@@ -564,13 +810,13 @@ namespace HardwareAnalyzer
 			}
 		}
 
-		static StatusLevel AnalyzeVRAM(double vramGB, const std::wstring& gpu, std::wstring& reasonKey)
+		template <typename String>
+		static StatusLevel AnalyzeVRAM(double vramGB, const String& gpu, String& reasonKey)
 		{
 			if (vramGB <= 0)
 			{
 				// Check if GPU is integrated (shared memory)
-				std::wstring gpuLower = gpu;
-				std::transform(gpuLower.begin(), gpuLower.end(), gpuLower.begin(), ::towlower);
+				String gpuLower = ToLower(gpu);
 
 				if (gpuLower.find(L"intel") != std::wstring::npos &&
 					gpuLower.find(L"arc") == std::wstring::npos)
@@ -583,12 +829,12 @@ namespace HardwareAnalyzer
 				return StatusLevel::Warning;
 			}
 
-			if (vramGB < 2)
+			if (vramGB < HardwareThresholds::VramBadGB)
 			{
 				reasonKey = L"Reason_VeryLowVRAM";
 				return StatusLevel::Bad;
 			}
-			else if (vramGB < 4)
+			else if (vramGB < HardwareThresholds::VramWarningGB)
 			{
 				reasonKey = L"Reason_LowVRAM";
 				return StatusLevel::Warning;
@@ -600,9 +846,12 @@ namespace HardwareAnalyzer
 			}
 		}
 
-		static StatusLevel AnalyzeArchitecture(const std::wstring& systemType, const std::wstring& cpu, std::wstring& reasonKey, std::wstring& detectedArch)
+		template <typename String>
+		static StatusLevel AnalyzeArchitecture(const String& systemType, const String& cpu, String& reasonKey, String& detectedArch)
 		{
-			std::wstring combined = systemType + L" " + cpu;
+			String combined{ systemType.get_allocator() };
+			combined.reserve(systemType.size() + 1 + cpu.size());
+			combined.append(systemType).append(L" ").append(cpu);
 			std::transform(combined.begin(), combined.end(), combined.begin(), ::towlower);
 
 			// Check for ARM architecture (Qualcomm/Snapdragon - not supported)
@@ -0,0 +1,25 @@
+#pragma once
+#include "pch.h"
+
+namespace HardwareAnalyzer
+{
+	// The limits the analyzers grade against, in one place: AnalyzeRAM, AnalyzeVRAM,
+	// AnalyzeMacMemory and AnalyzeMacOSVersion apply them, and a RequirementProfile starts
+	// from them. Under ...BadGB is Bad and under ...WarningGB a Warning; ...GoodGB only
+	// splits Good into its "acceptable" and "good" reasons.
+	struct HardwareThresholds
+	{
+		// Windows
+		static constexpr double RamBadGB = 8;
+		static constexpr double RamWarningGB = 12;
+		static constexpr double RamGoodGB = 16;
+		static constexpr double VramBadGB = 2;
+		static constexpr double VramWarningGB = 4;
+
+		// macOS
+		static constexpr double MacMemoryBadGB = 6;
+		static constexpr double MacMemoryWarningGB = 8;
+		static constexpr double MacMemoryGoodGB = 16;
+		static constexpr int MinMacOSMajor = 15;     // Older versions are Bad
+	};
+}
@@ -0,0 +1,238 @@
+#pragma once
+#include "pch.h"
+#include "OcrTextScanner.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace HardwareAnalyzer
+{
+	// Fields the parsers look up labels for. The order is part of the label pack format;
+	// new fields go last, so packs written before them still load.
+	enum class LabelField : uint8_t
+	{
+		// Windows "About" page
+		Processor,
+		InstalledRam,
+		RamUnits,
+		GraphicsCard,
+		DeviceName,
+		SystemType,
+
+		// macOS "About This Mac"
+		MacDeviceModels,
+		MacMemoryUnits,
+		MacVersionNames,
+
+		// Windows labels that end a graphics card value OCR ran into the next field
+		GpuStopLabels,
+
+		Count
+	};
+
+	// Names of the fields in label sources and in pack validation errors
+	inline constexpr std::string_view LabelFieldNames[] = {
+		"processor", "installed-ram", "ram-units", "graphics-card", "device-name", "system-type",
+		"mac-device-models", "mac-memory-units", "mac-version-names", "gpu-stop-labels",
+	};
+	static_assert(std::size(LabelFieldNames) == static_cast<size_t>(LabelField::Count));
+
+	// How LanguageIdentifier recognizes a language: Latin-script languages by trigrams,
+	// the others by their script, then by their marker letters when several share one
+	enum class WritingScript : uint8_t
+	{
+		Latin,
+		Cyrillic,
+		Greek,
+		Kana,
+		Hangul,
+		Han,
+
+		Count
+	};
+
+	// Folded labels of one UI language (or of all of them, for the multilingual set)
+	struct LanguageLabels
+	{
+		static constexpr size_t FieldCount = static_cast<size_t>(LabelField::Count);
+
+		std::wstring_view Tag;                      // BCP 47 ("fr", "pt"), "*" for the multilingual set
+		WritingScript Script = WritingScript::Latin;
+		std::wstring_view Markers;                  // Letters no other language of the same script uses
+		std::array<std::vector<std::wstring_view>, FieldCount> Fields;
+
+		// Tried for any field this set doesn't find: English for the other languages, then
+		// the multilingual set, which has nullptr (a misidentified page still finds its labels)
+		const LanguageLabels* Fallback = nullptr;
+
+		LabelList Labels(LabelField field) const
+		{
+			return Fields[static_cast<size_t>(field)];
+		}
+	};
+
+	// Every label the parsers know, plus the trigram profiles LanguageIdentifier scores
+	// Latin-script text against. Built once, either from the tables compiled into the app
+	// (BuiltInLabels.h) or from a memory-mapped label pack (LabelPack.h), then shared
+	// read-only between threads. The label views point into whatever Storage holds.
+	class LabelCatalog
+	{
+	public:
+		static constexpr uint32_t TrigramCount = 27 * 27 * 27;
+		static constexpr size_t MaxTrigramLanguages = 32;   // Bits in a trigram mask
+
+		struct Contents
+		{
+			uint32_t DataVersion = 0;
+			std::vector<LanguageLabels> Languages;
+			std::optional<LanguageLabels> All;         // Precomputed multilingual set; merged from Languages when absent
+			const uint32_t* TrigramMasks = nullptr;    // TrigramCount masks, or null without profiles
+			std::vector<uint32_t> OwnedTrigramMasks;   // Used instead when TrigramMasks is null
+			std::vector<size_t> TrigramLanguages;      // Mask bit -> index in Languages
+			std::shared_ptr<const void> Storage;       // Keeps the memory behind every view alive
+		};
+
+		explicit LabelCatalog(Contents contents)
+			: m_dataVersion(contents.DataVersion),
+			m_languages(std::move(contents.Languages)),
+			m_ownedTrigramMasks(std::move(contents.OwnedTrigramMasks)),
+			m_trigramMasks(contents.TrigramMasks),
+			m_storage(std::move(contents.Storage))
+		{
+			if (!m_trigramMasks && m_ownedTrigramMasks.size() == TrigramCount)
+				m_trigramMasks = m_ownedTrigramMasks.data();
+
+			for (size_t index : contents.TrigramLanguages)
+			{
+				if (index < m_languages.size() && m_trigramLanguages.size() < MaxTrigramLanguages)
+					m_trigramLanguages.push_back(&m_languages[index]);
+			}
+
+			// The vector is final now, and the catalog can't move, so pointers into both stay valid
+			m_all = contents.All ? std::move(*contents.All) : Merge(m_languages);
+			m_all.Fallback = nullptr;
+			const LanguageLabels* english = Find(L"en");
+			for (auto& language : m_languages)
+			{
+				language.Fallback = &language == english || !english ? &m_all : english;
+			}
+			m_vocabulary = Vocabulary(m_all);
+		}
+
+		LabelCatalog(const LabelCatalog&) = delete;
+		LabelCatalog& operator=(const LabelCatalog&) = delete;
+
+		// Version of the label data, independent of the app version
+		uint32_t DataVersion() const { return m_dataVersion; }
+
+		const std::vector<LanguageLabels>& Languages() const { return m_languages; }
+
+		// Every language's labels, longest first so "processore" wins over "processor"
+		const LanguageLabels& All() const { return m_all; }
+
+		const LanguageLabels* Find(std::wstring_view tag) const
+		{
+			for (const auto& language : m_languages)
+			{
+				if (language.Tag == tag)
+					return &language;
+			}
+			return nullptr;
+		}
+
+		// Whether 'word' (folded) is a word of some label and has an 'm': what OcrNormalizer's
+		// "rn" -> "m" fix may turn a misread word into
+		bool IsVocabularyWord(std::wstring_view word) const
+		{
+			return std::binary_search(m_vocabulary.begin(), m_vocabulary.end(), word);
+		}
+
+		// Trigram -> bitmask of TrigramLanguage(bit); null when the catalog has no profiles
+		const uint32_t* TrigramMasks() const { return m_trigramMasks; }
+
+		size_t TrigramLanguageCount() const { return m_trigramLanguages.size(); }
+
+		const LanguageLabels* TrigramLanguage(size_t bit) const
+		{
+			return bit < m_trigramLanguages.size() ? m_trigramLanguages[bit] : nullptr;
+		}
+
+		// "a|b|c" -> { "a", "b", "c" }; the views point into the argument
+		static std::vector<std::wstring_view> Split(std::wstring_view labels)
+		{
+			std::vector<std::wstring_view> result;
+			while (!labels.empty())
+			{
+				size_t bar = labels.find(L'|');
+				result.push_back(labels.substr(0, bar));
+				labels = bar == std::wstring_view::npos ? std::wstring_view{} : labels.substr(bar + 1);
+			}
+			return result;
+		}
+
+	private:
+		// Union of every language's labels. At a given position the longer of two matching
+		// labels must be tried first, so each field is sorted by length (stable, so equally
+		// long labels keep the order of the languages).
+		static LanguageLabels Merge(const std::vector<LanguageLabels>& languages)
+		{
+			LanguageLabels all;
+			all.Tag = L"*";
+			for (size_t field = 0; field < LanguageLabels::FieldCount; field++)
+			{
+				auto& merged = all.Fields[field];
+				for (const auto& language : languages)
+				{
+					for (const auto& label : language.Fields[field])
+					{
+						if (std::find(merged.begin(), merged.end(), label) == merged.end())
+							merged.push_back(label);
+					}
+				}
+				std::stable_sort(merged.begin(), merged.end(),
+					[](std::wstring_view a, std::wstring_view b) { return a.size() > b.size(); });
+			}
+			return all;
+		}
+
+		// The Latin words with an 'm' of every label, sorted and unique
+		static std::vector<std::wstring_view> Vocabulary(const LanguageLabels& all)
+		{
+			std::vector<std::wstring_view> words;
+			for (const auto& field : all.Fields)
+			{
+				for (std::wstring_view label : field)
+				{
+					size_t start = 0;
+					for (size_t i = 0; i <= label.size(); i++)
+					{
+						wchar_t c = i < label.size() ? label[i] : L' ';
+						if ((c >= L'a' && c <= L'z') || (c >= 0xDF && c <= 0xFF && c != 0xF7))
+							continue;
+						std::wstring_view word = label.substr(start, i - start);
+						if (word.find(L'm') != std::wstring_view::npos)
+							words.push_back(word);
+						start = i + 1;
+					}
+				}
+			}
+			std::sort(words.begin(), words.end());
+			words.erase(std::unique(words.begin(), words.end()), words.end());
+			return words;
+		}
+
+		uint32_t m_dataVersion;
+		std::vector<LanguageLabels> m_languages;
+		LanguageLabels m_all;
+		std::vector<std::wstring_view> m_vocabulary;
+		std::vector<uint32_t> m_ownedTrigramMasks;
+		const uint32_t* m_trigramMasks;
+		std::vector<const LanguageLabels*> m_trigramLanguages;
+		std::shared_ptr<const void> m_storage;
+	};
+}
@@ -0,0 +1,538 @@
+#pragma once
+#include "pch.h"
+#include "BuiltInLabels.h"
+#include "LabelCatalog.h"
+#include "MappedFile.h"
+#include "Tracing.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace HardwareAnalyzer
+{
+	// Label packs: LabelCatalog contents in a binary file that is memory-mapped and used in
+	// place, so adding or updating a language means dropping a .halp file into the Labels
+	// folder next to the executable, with no recompile and nothing to parse at startup.
+	//
+	// Layout (little-endian, every section 4-byte aligned):
+	//   PackHeader
+	//   PackLanguage[LanguageCount + 1]   the last record is the multilingual set, pre-sorted;
+	//                                     FieldCount ranges each, fewer in packs older than a field
+	//   PackString[LabelCount]            labels; each field of a record is a PackRange of them
+	//   uint32_t[TrigramCount]            trigram masks, bit = PackLanguage::TrigramBit (optional)
+	//   char16_t[StringLength]            UTF-16 text every PackString points into
+	//
+	// Where wchar_t is UTF-16 (Windows) the label views point straight into the mapping.
+	// A pack's DataVersion is the version of its label data, not of the app. Packs are
+	// written by "hardware-analyzerd labels" from a text source (AnalysisDaemon/LabelSource.h).
+	class LabelPack
+	{
+	public:
+		static constexpr uint32_t Magic = 0x504C4148;   // "HALP"
+		static constexpr uint16_t FormatVersion = 1;
+		static constexpr std::wstring_view Extension = L".halp";
+
+		// The catalog the parsers use: the built-in labels until SetActive is called
+		static std::shared_ptr<const LabelCatalog> Active()
+		{
+			std::lock_guard<std::mutex> lock(ActiveLock());
+			auto& active = ActiveCatalog();
+			if (!active)
+				active = BuiltInLabels::Catalog();
+			return active;
+		}
+
+		static void SetActive(std::shared_ptr<const LabelCatalog> catalog)
+		{
+			std::lock_guard<std::mutex> lock(ActiveLock());
+			ActiveCatalog() = std::move(catalog);
+		}
+
+		// The built-in labels combined with every pack in the directory (in file name order).
+		// Unreadable or malformed packs are skipped.
+		static std::shared_ptr<const LabelCatalog> LoadDirectory(const std::filesystem::path& directory)
+		{
+			TraceSpan span{ "LabelPack::LoadDirectory" };
+			std::vector<std::filesystem::path> paths;
+			std::error_code error;
+			for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error))
+			{
+				if (it->path().extension() == Extension)
+					paths.push_back(it->path());
+			}
+			std::sort(paths.begin(), paths.end());
+
+			std::vector<std::shared_ptr<const LabelCatalog>> catalogs{ BuiltInLabels::Catalog() };
+			for (const auto& path : paths)
+			{
+				if (auto pack = Load(path))
+					catalogs.push_back(std::move(pack));
+			}
+			return catalogs.size() == 1 ? catalogs.front() : Combine(catalogs);
+		}
+
+		// nullptr when the file is missing, truncated, of another format version, points
+		// outside itself anywhere, or has labels the parsers can't match (see Validate)
+		static std::shared_ptr<const LabelCatalog> Load(const std::filesystem::path& path)
+		{
+			std::string error;
+			return Load(path, error);
+		}
+
+		static std::shared_ptr<const LabelCatalog> Load(const std::filesystem::path& path, std::string& error)
+		{
+			TraceSpan span{ "LabelPack::Load" };
+			auto file = MappedFile::Open(path);
+			if (!file)
+			{
+				error = "can't map the file";
+				return nullptr;
+			}
+
+			auto storage = std::make_shared<PackStorage>();
+			storage->File = std::move(*file);
+			const std::byte* data = storage->File.Data();
+			const size_t size = storage->File.Size();
+
+			error = "not a label pack, or a damaged one";
+			PackHeader header;
+			if (size < sizeof(header))
+				return nullptr;
+			std::memcpy(&header, data, sizeof(header));
+			if (header.Magic != Magic || header.FormatVersion != FormatVersion || header.FieldCount == 0
+				|| header.FieldCount > LanguageLabels::FieldCount || header.FileSize != size || header.LanguageCount == 0)
+				return nullptr;
+
+			// Records of a pack with fewer fields are shorter; the fields it lacks stay empty
+			const size_t recordSize = sizeof(PackLanguage) - (LanguageLabels::FieldCount - header.FieldCount) * sizeof(PackRange);
+
+			auto inside = [&](uint64_t offset, uint64_t count, uint64_t itemSize, uint64_t alignment) {
+				return offset % alignment == 0 && offset + count * itemSize <= size;
+			};
+			if (!inside(header.LanguageOffset, uint64_t{ header.LanguageCount } + 1, recordSize, 4)
+				|| !inside(header.LabelOffset, header.LabelCount, sizeof(PackString), 4)
+				|| !inside(header.StringOffset, header.StringLength, sizeof(char16_t), 2)
+				|| (header.TrigramOffset != 0 && !inside(header.TrigramOffset, LabelCatalog::TrigramCount, sizeof(uint32_t), 4)))
+				return nullptr;
+
+			// Strings are used in place when wchar_t is UTF-16, widened once otherwise
+			const wchar_t* text;
+			if constexpr (sizeof(wchar_t) == sizeof(char16_t))
+			{
+				text = reinterpret_cast<const wchar_t*>(data + header.StringOffset);
+			}
+			else
+			{
+				storage->Widened.resize(header.StringLength);
+				for (uint32_t i = 0; i < header.StringLength; i++)
+				{
+					char16_t unit;
+					std::memcpy(&unit, data + header.StringOffset + i * sizeof(char16_t), sizeof(unit));
+					storage->Widened[i] = static_cast<wchar_t>(unit);
+				}
+				text = storage->Widened.data();
+			}
+
+			bool valid = true;
+			auto string = [&](PackString s) {
+				if (uint64_t{ s.Offset } + s.Length > header.StringLength)
+				{
+					valid = false;
+					return std::wstring_view{};
+				}
+				return std::wstring_view{ text + s.Offset, s.Length };
+			};
+
+			std::vector<std::wstring_view> labels(header.LabelCount);
+			for (uint32_t i = 0; i < header.LabelCount; i++)
+			{
+				PackString label;
+				std::memcpy(&label, data + header.LabelOffset + uint64_t{ i } * sizeof(PackString), sizeof(label));
+				labels[i] = string(label);
+			}
+
+			LabelCatalog::Contents contents;
+			contents.DataVersion = header.DataVersion;
+			std::vector<size_t> trigramLanguages(LabelCatalog::MaxTrigramLanguages, NoLanguage);
+			for (uint32_t i = 0; i <= header.LanguageCount && valid; i++)
+			{
+				PackLanguage record{};
+				std::memcpy(&record, data + header.LanguageOffset + uint64_t{ i } * recordSize, recordSize);
+
+				LanguageLabels language;
+				language.Tag = string(record.Tag);
+				language.Markers = string(record.Markers);
+				language.Script = static_cast<WritingScript>(record.Script);
+				if (language.Tag.empty() || record.Script >= static_cast<uint8_t>(WritingScript::Count))
+					return nullptr;
+
+				for (size_t field = 0; field < LanguageLabels::FieldCount; field++)
+				{
+					PackRange range = record.Fields[field];
+					if (uint64_t{ range.First } + range.Count > header.LabelCount)
+						return nullptr;
+					language.Fields[field].assign(labels.begin() + range.First, labels.begin() + range.First + range.Count);
+				}
+
+				if (i == header.LanguageCount)
+				{
+					contents.All = std::move(language);
+					break;
+				}
+
+				if (record.TrigramBit != NoTrigramBit)
+				{
+					if (record.TrigramBit >= trigramLanguages.size() || trigramLanguages[record.TrigramBit] != NoLanguage || header.TrigramOffset == 0)
+						return nullptr;
+					trigramLanguages[record.TrigramBit] = i;
+				}
+				contents.Languages.push_back(std::move(language));
+			}
+			if (!valid)
+				return nullptr;
+
+			// Mask bits must name languages 0..n-1 with no gap
+			auto used = std::find(trigramLanguages.begin(), trigramLanguages.end(), NoLanguage);
+			if (std::any_of(used, trigramLanguages.end(), [](size_t index) { return index != NoLanguage; }))
+				return nullptr;
+			contents.TrigramLanguages.assign(trigramLanguages.begin(), used);
+			if (header.TrigramOffset != 0)
+				contents.TrigramMasks = reinterpret_cast<const uint32_t*>(data + header.TrigramOffset);
+
+			contents.Storage = std::move(storage);
+			auto catalog = std::make_shared<const LabelCatalog>(std::move(contents));
+			if (!Validate(*catalog, error))
+				return nullptr;
+			error.clear();
+			return catalog;
+		}
+
+		// Checks what the scanners rely on but the pack format can't express: every label is
+		// folded (OcrTextScanner::Fold, single spaces, none at either end), no label comes after
+		// a shorter one it starts with (which would always match first), the multilingual set
+		// is longest first, and no language is there twice
+		static bool Validate(const LabelCatalog& catalog, std::string& error)
+		{
+			auto check = [&](const LanguageLabels& language, bool longestFirst) {
+				auto fail = [&](size_t field, std::wstring_view label, const char* problem) {
+					error = Utf8::Encode(language.Tag) + " " + std::string(LabelFieldNames[field]) + ": \"" + Utf8::Encode(label) + "\" " + problem;
+					return false;
+				};
+				for (size_t field = 0; field < LanguageLabels::FieldCount; field++)
+				{
+					const auto& labels = language.Fields[field];
+					for (size_t i = 0; i < labels.size(); i++)
+					{
+						std::wstring_view label = labels[i];
+						if (label.empty() || label.front() == L' ' || label.back() == L' ' || label.find(L"  ") != std::wstring_view::npos)
+							return fail(field, label, "is empty or has stray spaces");
+						if (std::any_of(label.begin(), label.end(), [](wchar_t c) { return OcrTextScanner::Fold(c) != c; }))
+							return fail(field, label, "isn't folded");
+						for (size_t j = 0; j < i; j++)
+						{
+							if (longestFirst ? labels[j].size() < label.size() : label.starts_with(labels[j]))
+								return fail(field, label, longestFirst ? "is longer than a label before it" : "comes after a label it starts with");
+						}
+					}
+				}
+				return true;
+			};
+
+			for (const auto& language : catalog.Languages())
+			{
+				if (catalog.Find(language.Tag) != &language)
+				{
+					error = "language " + Utf8::Encode(language.Tag) + " is there twice";
+					return false;
+				}
+				if (!check(language, false))
+					return false;
+			}
+			return check(catalog.All(), true);
+		}
+
+		// Writes the catalog as a pack (through a temporary file, so a reader never maps half
+		// of one). Pair with Select to write one language per file.
+		static bool Write(const LabelCatalog& catalog, const std::filesystem::path& path)
+		{
+			std::vector<char16_t> strings;
+			std::map<std::wstring_view, PackString> written;
+			bool valid = true;
+			auto addString = [&](std::wstring_view s) {
+				auto found = written.find(s);
+				if (found != written.end())
+					return found->second;
+				PackString result{ static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(s.size()) };
+				for (wchar_t c : s)
+				{
+					// Labels are BMP text; a pack has no way to hold anything else
+					if (static_cast<uint32_t>(c) > 0xFFFF)
+						valid = false;
+					strings.push_back(static_cast<char16_t>(c));
+				}
+				written.emplace(s, result);
+				return result;
+			};
+
+			std::vector<PackString> labels;
+			std::vector<PackLanguage> records;
+			auto addRecord = [&](const LanguageLabels& language, uint8_t trigramBit) {
+				PackLanguage record{};
+				record.Tag = addString(language.Tag);
+				record.Markers = addString(language.Markers);
+				record.Script = static_cast<uint8_t>(language.Script);
+				record.TrigramBit = trigramBit;
+				for (size_t field = 0; field < LanguageLabels::FieldCount; field++)
+				{
+					record.Fields[field] = { static_cast<uint32_t>(labels.size()), static_cast<uint32_t>(language.Fields[field].size()) };
+					for (const auto& label : language.Fields[field])
+					{
+						labels.push_back(addString(label));
+					}
+				}
+				records.push_back(record);
+			};
+
+			for (const auto& language : catalog.Languages())
+			{
+				uint8_t bit = NoTrigramBit;
+				for (size_t i = 0; i < catalog.TrigramLanguageCount(); i++)
+				{
+					if (catalog.TrigramLanguage(i) == &language)
+						bit = static_cast<uint8_t>(i);
+				}
+				addRecord(language, bit);
+			}
+			addRecord(catalog.All(), NoTrigramBit);
+			if (!valid)
+				return false;
+
+			PackHeader header{};
+			header.Magic = Magic;
+			header.FormatVersion = FormatVersion;
+			header.FieldCount = static_cast<uint16_t>(LanguageLabels::FieldCount);
+			header.DataVersion = catalog.DataVersion();
+			header.LanguageCount = static_cast<uint32_t>(catalog.Languages().size());
+			header.LanguageOffset = sizeof(PackHeader);
+			header.LabelOffset = header.LanguageOffset + static_cast<uint32_t>(records.size() * sizeof(PackLanguage));
+			header.LabelCount = static_cast<uint32_t>(labels.size());
+			uint32_t end = header.LabelOffset + static_cast<uint32_t>(labels.size() * sizeof(PackString));
+			if (catalog.TrigramMasks())
+			{
+				header.TrigramOffset = end;
+				end += LabelCatalog::TrigramCount * sizeof(uint32_t);
+			}
+			header.StringOffset = end;
+			header.StringLength = static_cast<uint32_t>(strings.size());
+			header.FileSize = end + static_cast<uint32_t>(strings.size() * sizeof(char16_t));
+
+			std::filesystem::path temporary = path;
+			temporary += L".tmp";
+			{
+				std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+				auto write = [&](const void* bytes, size_t count) {
+					out.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(count));
+				};
+				write(&header, sizeof(header));
+				write(records.data(), records.size() * sizeof(PackLanguage));
+				write(labels.data(), labels.size() * sizeof(PackString));
+				if (catalog.TrigramMasks())
+					write(catalog.TrigramMasks(), LabelCatalog::TrigramCount * sizeof(uint32_t));
+				write(strings.data(), strings.size() * sizeof(char16_t));
+				if (!out.flush())
+					return false;
+			}
+
+			std::error_code error;
+			std::filesystem::rename(temporary, path, error);
+			return !error;
+		}
+
+		// A catalog of the listed languages only, in catalog order
+		static std::shared_ptr<const LabelCatalog> Select(const std::shared_ptr<const LabelCatalog>& catalog, const std::vector<std::wstring_view>& tags)
+		{
+			std::vector<const LanguageLabels*> picked;
+			for (const auto& language : catalog->Languages())
+			{
+				if (std::find(tags.begin(), tags.end(), language.Tag) != tags.end())
+					picked.push_back(&language);
+			}
+			return Compose({ catalog }, picked);
+		}
+
+		// Every language of every catalog. A language found in several comes from the one with
+		// the highest DataVersion, the later one on a tie, so a pack overrides the built-in
+		// labels of its languages unless the app ships newer ones.
+		static std::shared_ptr<const LabelCatalog> Combine(const std::vector<std::shared_ptr<const LabelCatalog>>& catalogs)
+		{
+			std::vector<const LanguageLabels*> picked;
+			std::vector<uint32_t> pickedVersions;
+			for (const auto& catalog : catalogs)
+			{
+				for (const auto& language : catalog->Languages())
+				{
+					size_t i = 0;
+					while (i < picked.size() && picked[i]->Tag != language.Tag)
+						i++;
+					if (i == picked.size())
+					{
+						picked.push_back(&language);
+						pickedVersions.push_back(catalog->DataVersion());
+					}
+					else if (catalog->DataVersion() >= pickedVersions[i])
+					{
+						picked[i] = &language;
+						pickedVersions[i] = catalog->DataVersion();
+					}
+				}
+			}
+			return Compose(catalogs, picked);
+		}
+
+	private:
+		struct PackString
+		{
+			uint32_t Offset;   // In char16_t units from the start of the string table
+			uint32_t Length;
+		};
+
+		struct PackRange
+		{
+			uint32_t First;    // Index into the label table
+			uint32_t Count;
+		};
+
+		struct PackHeader
+		{
+			uint32_t Magic;
+			uint16_t FormatVersion;
+			uint16_t FieldCount;
+			uint32_t DataVersion;
+			uint32_t FileSize;
+			uint32_t LanguageCount;
+			uint32_t LanguageOffset;
+			uint32_t LabelOffset;
+			uint32_t LabelCount;
+			uint32_t TrigramOffset;   // 0 when the pack has no trigram profiles
+			uint32_t StringOffset;
+			uint32_t StringLength;
+		};
+
+		struct PackLanguage
+		{
+			PackString Tag;
+			PackString Markers;
+			uint8_t Script;
+			uint8_t TrigramBit;
+			uint16_t Reserved;
+			PackRange Fields[LanguageLabels::FieldCount];
+		};
+
+		static_assert(std::endian::native == std::endian::little, "Label packs are read in place as little-endian");
+		static_assert(sizeof(PackHeader) % 4 == 0 && sizeof(PackLanguage) % 4 == 0 && sizeof(PackString) == 8);
+
+		static constexpr uint8_t NoTrigramBit = 0xFF;
+		static constexpr size_t NoLanguage = static_cast<size_t>(-1);
+
+		struct PackStorage
+		{
+			MappedFile File;
+			std::wstring Widened;   // String table where wchar_t isn't UTF-16
+		};
+
+		// A catalog of the picked languages, whose views stay in (and keep alive) the catalogs
+		// they come from. Trigram masks are remapped to the new bit order, unless one catalog
+		// supplies every profiled language with the same bits and its table can be shared.
+		static std::shared_ptr<const LabelCatalog> Compose(const std::vector<std::shared_ptr<const LabelCatalog>>& catalogs, const std::vector<const LanguageLabels*>& picked)
+		{
+			LabelCatalog::Contents contents;
+			for (const auto* language : picked)
+			{
+				contents.Languages.push_back(*language);
+			}
+
+			// New bit of each catalog's old bits, in the order of the picked languages
+			std::vector<std::vector<size_t>> bits(catalogs.size());
+			size_t bitCount = 0;
+			for (size_t index = 0; index < picked.size() && bitCount < LabelCatalog::MaxTrigramLanguages; index++)
+			{
+				for (size_t source = 0; source < catalogs.size(); source++)
+				{
+					const auto& catalog = *catalogs[source];
+					for (size_t bit = 0; bit < catalog.TrigramLanguageCount(); bit++)
+					{
+						if (catalog.TrigramLanguage(bit) != picked[index])
+							continue;
+						bits[source].resize(catalog.TrigramLanguageCount(), NoLanguage);
+						bits[source][bit] = bitCount++;
+						contents.TrigramLanguages.push_back(index);
+					}
+				}
+			}
+
+			for (size_t source = 0; source < catalogs.size(); source++)
+			{
+				const auto& catalog = *catalogs[source];
+				if (bits[source].empty())
+					continue;
+
+				bool identity = bits[source].size() == bitCount;
+				for (size_t bit = 0; bit < bits[source].size(); bit++)
+				{
+					identity = identity && bits[source][bit] == bit;
+				}
+				if (identity)
+				{
+					contents.TrigramMasks = catalog.TrigramMasks();
+					break;
+				}
+
+				contents.OwnedTrigramMasks.resize(LabelCatalog::TrigramCount);
+				for (uint32_t trigram = 0; trigram < LabelCatalog::TrigramCount; trigram++)
+				{
+					for (uint32_t mask = catalog.TrigramMasks()[trigram]; mask != 0; mask &= mask - 1)
+					{
+						size_t old = static_cast<size_t>(std::countr_zero(mask));
+						size_t bit = old < bits[source].size() ? bits[source][old] : NoLanguage;
+						if (bit != NoLanguage)
+							contents.OwnedTrigramMasks[trigram] |= uint32_t{ 1 } << bit;
+					}
+				}
+			}
+
+			for (const auto& catalog : catalogs)
+			{
+				for (const auto& language : catalog->Languages())
+				{
+					if (std::find(picked.begin(), picked.end(), &language) != picked.end())
+						contents.DataVersion = (std::max)(contents.DataVersion, catalog->DataVersion());
+				}
+			}
+			contents.Storage = std::make_shared<const std::vector<std::shared_ptr<const LabelCatalog>>>(catalogs);
+			return std::make_shared<const LabelCatalog>(std::move(contents));
+		}
+
+		static std::mutex& ActiveLock()
+		{
+			static std::mutex lock;
+			return lock;
+		}
+
+		static std::shared_ptr<const LabelCatalog>& ActiveCatalog()
+		{
+			static std::shared_ptr<const LabelCatalog> catalog;
+			return catalog;
+		}
+	};
+}
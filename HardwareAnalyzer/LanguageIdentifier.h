@@ -0,0 +1,210 @@
+#pragma once
+#include "pch.h"
+#include "LabelCatalog.h"
+#include "OcrTextScanner.h"
+#include "Tracing.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace HardwareAnalyzer
+{
+	// Guesses the UI language of an OCR'd system page from its first few hundred characters,
+	// so the parsers can try that language's labels before the full multilingual lists.
+	//
+	// Latin-script text is scored against the catalog's character trigram profiles: each of
+	// the 27^3 folded trigrams maps to a bitmask of the languages whose profile contains it,
+	// so a document costs one table lookup per trigram whatever the number of languages.
+	// Greek, Cyrillic and CJK text is told apart by its script, and languages sharing a
+	// script (Russian and Ukrainian) by the marker letters only one of them uses.
+	//
+	// The answer is only a hint. nullptr is returned whenever the evidence is thin or two
+	// languages score close together, and callers fall back to matching every language.
+	class LanguageIdentifier
+	{
+	public:
+		static constexpr size_t SampleChars = 400;
+
+		static const LanguageLabels* Identify(std::wstring_view text, const LabelCatalog& catalog)
+		{
+			TraceSpan span{ "LanguageIdentifier::Identify" };
+			text = text.substr(0, (std::min)(text.size(), SampleChars));
+
+			const uint32_t* profiles = catalog.TrigramMasks();
+			std::array<uint32_t, LabelCatalog::MaxTrigramLanguages> scores{};
+			ScriptCounts scripts;
+
+			uint32_t window = 0;      // Last three trigram symbols, base 27
+			uint32_t previous = 0;    // Symbol of the previous character, 0 = word boundary
+			for (wchar_t c : text)
+			{
+				uint32_t symbol = Symbol(c);
+				if (symbol == 0)
+					scripts.Count(c);
+				else
+					scripts.Latin++;
+
+				// Runs of boundaries collapse into one, so " ab" and "ab " are both seen
+				if (symbol == 0 && previous == 0)
+					continue;
+				previous = symbol;
+
+				window = (window * 27 + symbol) % LabelCatalog::TrigramCount;
+				uint32_t mask = profiles ? profiles[window] : 0;
+				if (mask == 0)
+					continue;
+
+				// Trigrams shared by many languages say little about any of them
+				uint32_t weight = WeightScale / static_cast<uint32_t>(std::popcount(mask));
+				for (; mask != 0; mask &= mask - 1)
+				{
+					scores[std::countr_zero(mask)] += weight;
+				}
+			}
+
+			WritingScript script = scripts.Dominant();
+			if (script != WritingScript::Latin)
+				return ByScript(text, catalog, script);
+
+			size_t best = 0;
+			uint32_t runnerUp = 0;
+			for (size_t i = 1; i < scores.size(); i++)
+			{
+				if (scores[i] > scores[best])
+				{
+					runnerUp = scores[best];
+					best = i;
+				}
+				else if (scores[i] > runnerUp)
+				{
+					runnerUp = scores[i];
+				}
+			}
+
+			// At least a few distinctive trigrams, and a clear lead over the next language
+			if (scores[best] < MinScore || scores[best] * 4 < runnerUp * 5)
+				return nullptr;
+			return catalog.TrigramLanguage(best);
+		}
+
+		// Trigram masks for up to 32 languages: bit i is set for every trigram of seeds[i].
+		// Seeds are folded text typical of the language's system pages.
+		static std::vector<uint32_t> BuildProfiles(const std::vector<std::wstring_view>& seeds)
+		{
+			std::vector<uint32_t> masks(LabelCatalog::TrigramCount);
+			for (size_t bit = 0; bit < seeds.size() && bit < LabelCatalog::MaxTrigramLanguages; bit++)
+			{
+				uint32_t window = 0;
+				uint32_t previous = 0;
+				// The extra step closes the last word like the boundary after it in real text
+				for (size_t i = 0; i <= seeds[bit].size(); i++)
+				{
+					uint32_t symbol = i < seeds[bit].size() ? Symbol(seeds[bit][i]) : 0;
+					if (symbol == 0 && previous == 0)
+						continue;
+					previous = symbol;
+
+					window = (window * 27 + symbol) % LabelCatalog::TrigramCount;
+					// Skip the trigrams around one-letter words (" a ") that every language has
+					if (window / 27 % 27 != 0)
+						masks[window] |= uint32_t{ 1 } << bit;
+				}
+			}
+			return masks;
+		}
+
+	private:
+		static constexpr uint32_t WeightScale = 840;          // Divisible by 1..8
+		static constexpr uint32_t MinScore = 6 * WeightScale;
+
+		// 1..26 for a letter that folds to a-z, 0 for anything else
+		static uint32_t Symbol(wchar_t c)
+		{
+			wchar_t folded = OcrTextScanner::Fold(c);
+			return folded >= L'a' && folded <= L'z' ? static_cast<uint32_t>(folded - L'a' + 1) : 0;
+		}
+
+		// The only language of the script, or the one whose marker letters occur most
+		static const LanguageLabels* ByScript(std::wstring_view text, const LabelCatalog& catalog, WritingScript script)
+		{
+			const LanguageLabels* best = nullptr;
+			size_t bestMarkers = 0;
+			size_t candidates = 0;
+			bool tied = false;
+			for (const auto& language : catalog.Languages())
+			{
+				if (language.Script != script)
+					continue;
+				candidates++;
+
+				size_t markers = 0;
+				for (wchar_t c : text)
+				{
+					if (language.Markers.find(OcrTextScanner::Fold(c)) != std::wstring_view::npos)
+						markers++;
+				}
+
+				if (!best || markers > bestMarkers)
+				{
+					tied = false;
+					best = &language;
+					bestMarkers = markers;
+				}
+				else if (markers == bestMarkers)
+				{
+					tied = true;
+				}
+			}
+			return candidates == 1 || (best && !tied && bestMarkers > 0) ? best : nullptr;
+		}
+
+		struct ScriptCounts
+		{
+			uint32_t Latin = 0;
+			uint32_t Cyrillic = 0;
+			uint32_t Greek = 0;
+			uint32_t Kana = 0;
+			uint32_t Hangul = 0;
+			uint32_t Han = 0;
+
+			void Count(wchar_t c)
+			{
+				if (c >= 0x400 && c <= 0x4FF)
+					Cyrillic++;
+				else if (c >= 0x370 && c <= 0x3FF)
+					Greek++;
+				else if (c >= 0x3040 && c <= 0x30FF)
+					Kana++;
+				else if ((c >= 0xAC00 && c <= 0xD7A3) || (c >= 0x1100 && c <= 0x11FF) || (c >= 0x3130 && c <= 0x318F))
+					Hangul++;
+				else if (c >= 0x4E00 && c <= 0x9FFF)
+					Han++;
+			}
+
+			// Greek and Cyrillic only win when they outweigh the Latin letters of brand and
+			// model names ("Intel Core i7", "NVIDIA GeForce") that every language shares. A
+			// CJK character stands for a word, and a Chinese page's few label characters sit
+			// among hundreds of Latin ones, so a handful of them decides alone.
+			// Latin means "score the trigrams".
+			WritingScript Dominant() const
+			{
+				uint32_t cjk = Kana + Hangul + Han;
+				if (cjk >= 6)
+				{
+					if (Hangul > Kana && Hangul >= Han)
+						return WritingScript::Hangul;
+					// Japanese pages mix kanji in, Chinese ones have no kana at all
+					return Kana > 0 ? WritingScript::Kana : WritingScript::Han;
+				}
+				if (Greek >= 8 && Greek >= Latin / 2)
+					return WritingScript::Greek;
+				if (Cyrillic >= 8 && Cyrillic >= Latin / 2)
+					return WritingScript::Cyrillic;
+				return WritingScript::Latin;
+			}
+		};
+	};
+}
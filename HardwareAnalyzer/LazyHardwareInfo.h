@@ -0,0 +1,257 @@
+#pragma once
+#include "pch.h"
+#include "HardwareInfo.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace HardwareAnalyzer
+{
+	// The fields of ParseOcrText, each extracted the first time it's asked for. The text is
+	// capped, normalized and its language identified up front, as every field needs them;
+	// the scans of a field only run if something reads it. Not thread-safe: reading a field
+	// may write it.
+	template <typename String>
+	class BasicLazyHardwareInfo
+	{
+	public:
+		using Allocator = typename String::allocator_type;
+
+		explicit BasicLazyHardwareInfo(std::wstring_view text, const ParseLimits& limits = {}, const Allocator& allocator = {})
+			: m_text(allocator), m_catalog(LabelPack::Active()), m_info(allocator)
+		{
+			TraceSpan span{ "ParseOcrText" };
+			OcrTextScanner::ApplyLimits(text, limits, m_text);
+			OcrNormalizer::Normalize(m_text, *m_catalog);
+			const LanguageLabels* language = LanguageIdentifier::Identify(m_text, *m_catalog);
+			m_labels = language ? language : &m_catalog->All();
+		}
+
+		const String& DeviceName()
+		{
+			if (Extract(DeviceNameField))
+				HardwareAnalyzerService::ExtractDeviceName(m_text, *m_labels, m_info.DeviceName);
+			return m_info.DeviceName;
+		}
+
+		const String& Processor()
+		{
+			if (Extract(ProcessorField))
+				HardwareAnalyzerService::ExtractProcessor(m_text, *m_labels, m_info.Processor);
+			return m_info.Processor;
+		}
+
+		const String& RAM()
+		{
+			if (Extract(RamField))
+				HardwareAnalyzerService::ExtractRAM(m_text, *m_labels, m_info);
+			return m_info.RAM;
+		}
+
+		double RamGB()
+		{
+			RAM();
+			return m_info.RamGB;
+		}
+
+		const String& GPU()
+		{
+			if (Extract(GpuField))
+				HardwareAnalyzerService::ExtractGPU(m_text, *m_labels, m_info.GPU);
+			return m_info.GPU;
+		}
+
+		// The GPU name is read first: it's the last place VRAM is looked for
+		const String& VRAM()
+		{
+			if (Extract(VramField))
+			{
+				GPU();
+				HardwareAnalyzerService::ExtractVRAM(m_text, *m_labels, m_info);
+			}
+			return m_info.VRAM;
+		}
+
+		double VramGB()
+		{
+			VRAM();
+			return m_info.VramGB;
+		}
+
+		const String& SystemType()
+		{
+			if (Extract(SystemTypeField))
+				HardwareAnalyzerService::ExtractSystemType(m_text, *m_labels, m_info.SystemType);
+			return m_info.SystemType;
+		}
+
+		// Every field, the same as ParseOcrText returns for the text
+		const BasicHardwareInfo<String>& Info()
+		{
+			DeviceName();
+			Processor();
+			VRAM();
+			RAM();
+			SystemType();
+			return m_info;
+		}
+
+		Allocator get_allocator() const { return m_text.get_allocator(); }
+
+	private:
+		static constexpr uint8_t DeviceNameField = 1 << 0;
+		static constexpr uint8_t ProcessorField = 1 << 1;
+		static constexpr uint8_t RamField = 1 << 2;
+		static constexpr uint8_t GpuField = 1 << 3;
+		static constexpr uint8_t VramField = 1 << 4;
+		static constexpr uint8_t SystemTypeField = 1 << 5;
+
+		// True the first time 'field' is asked for
+		bool Extract(uint8_t field)
+		{
+			if (m_extracted & field)
+				return false;
+			m_extracted |= field;
+			return true;
+		}
+
+		String m_text;
+		std::shared_ptr<const LabelCatalog> m_catalog;  // Owns *m_labels
+		const LanguageLabels* m_labels = nullptr;
+		BasicHardwareInfo<String> m_info;
+		uint8_t m_extracted = 0;
+	};
+
+	// CalculateGlobalScore(AnalyzeHardware(info)) one check at a time, cheapest decisive check
+	// first: the architecture (a Bad one makes the score 0 whatever else is found), then RAM,
+	// then the processor, graphics card and video memory. After each check the score is known
+	// to lie in [Lowest(), Highest()]; callers stop as soon as that settles their question,
+	// and the fields of the checks never run are never extracted.
+	template <typename String>
+	class BasicShortCircuitScore
+	{
+	public:
+		static constexpr int CheckCount = 5;
+
+		explicit BasicShortCircuitScore(BasicLazyHardwareInfo<String>& info)
+			: m_info(info), m_results(info.get_allocator())
+		{
+			m_results.reserve(CheckCount);
+		}
+
+		// Classifies the next check; false once all five are done
+		bool Next()
+		{
+			if (m_results.size() == CheckCount)
+				return false;
+
+			auto& result = m_results.emplace_back(m_info.get_allocator());
+			switch (m_results.size())
+			{
+			case 1:
+				result.Name = L"Architecture";
+				result.Status = HardwareAnalyzerService::AnalyzeArchitecture(m_info.SystemType(), m_info.Processor(), result.ReasonKey, result.Value);
+				m_unsupported = result.Status == StatusLevel::Bad;
+				break;
+			case 2:
+				result.Name = L"RAM";
+				SetValue(result, m_info.RAM());
+				result.Status = HardwareAnalyzerService::AnalyzeRAM(m_info.RamGB(), result.ReasonKey);
+				break;
+			case 3:
+				result.Name = L"Processor";
+				SetValue(result, m_info.Processor());
+				result.Status = HardwareAnalyzerService::AnalyzeCPU(m_info.Processor(), result.ReasonKey);
+				break;
+			case 4:
+				result.Name = L"Graphics Card";
+				SetValue(result, m_info.GPU());
+				result.Status = HardwareAnalyzerService::AnalyzeGPU(m_info.GPU(), m_info.VramGB(), result.ReasonKey);
+				break;
+			default:
+				result.Name = L"Video Memory";
+				SetValue(result, m_info.VRAM());
+				result.Status = HardwareAnalyzerService::AnalyzeVRAM(m_info.VramGB(), m_info.GPU(), result.ReasonKey);
+				break;
+			}
+
+			// As CalculateGlobalScore: values that weren't found don't count
+			if (result.Value != L"?")
+			{
+				m_found++;
+				m_score -= result.Status == StatusLevel::Bad ? 30 : result.Status == StatusLevel::Warning ? 15 : 0;
+			}
+			return true;
+		}
+
+		// Bounds of the final score given the checks done so far: every check left could
+		// still be Bad (30 off), or Good, or not found at all (-1 when nothing is)
+		int Lowest() const
+		{
+			if (m_unsupported)
+				return 0;
+			int left = CheckCount - static_cast<int>(m_results.size());
+			return m_found == 0 ? -1 : (std::max)(0, m_score - 30 * left);
+		}
+
+		int Highest() const
+		{
+			if (m_unsupported)
+				return 0;
+			return m_found == 0 && m_results.size() == CheckCount ? -1 : (std::max)(0, m_score);
+		}
+
+		bool Settled() const { return Lowest() == Highest(); }
+
+		// The score CalculateGlobalScore gives, without the checks that can't change it
+		int Score()
+		{
+			while (!Settled())
+				Next();
+			return Lowest();
+		}
+
+		// Whether the score is at least 'minimum', running only the checks that decide it
+		bool Reaches(int minimum)
+		{
+			while (Lowest() < minimum && Highest() >= minimum)
+				Next();
+			return Lowest() >= minimum;
+		}
+
+		// The quick gate: neither the architecture nor RAM is Bad. RAM isn't read when the
+		// architecture already rules the machine out.
+		bool PassesGate()
+		{
+			while (m_results.size() < 2 && !m_unsupported)
+				Next();
+			return !m_unsupported && m_results[1].Status != StatusLevel::Bad;
+		}
+
+		// The checks done so far, in the order above rather than AnalyzeHardware's
+		const BasicCheckResults<String>& Results() const { return m_results; }
+
+	private:
+		static void SetValue(BasicHardwareCheckResult<String>& result, const String& value)
+		{
+			result.Value = value.empty() ? std::wstring_view(L"?") : std::wstring_view(value);
+		}
+
+		BasicLazyHardwareInfo<String>& m_info;
+		BasicCheckResults<String> m_results;
+		int m_score = 100;
+		int m_found = 0;
+		bool m_unsupported = false;
+	};
+
+	using LazyHardwareInfo = BasicLazyHardwareInfo<std::wstring>;
+	using ShortCircuitScore = BasicShortCircuitScore<std::wstring>;
+
+	namespace pmr
+	{
+		using LazyHardwareInfo = BasicLazyHardwareInfo<std::pmr::wstring>;
+		using ShortCircuitScore = BasicShortCircuitScore<std::pmr::wstring>;
+	}
+}
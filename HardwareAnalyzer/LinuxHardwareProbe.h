@@ -0,0 +1,404 @@
+#pragma once
+#include "pch.h"
+#include "HardwareInfo.h"
+#include "Tracing.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/utsname.h>
+#endif
+
+namespace HardwareAnalyzer
+{
+	// HardwareInfo for a Linux machine read straight from procfs and sysfs instead of a
+	// screenshot: the result goes through AnalyzeHardware like a parsed one.
+	//   - Processor: /proc/cpuinfo "model name" (the CPU implementer on ARM) and the top
+	//     speed from /sys/devices/system/cpu/cpu0/cpufreq
+	//   - RamGB: the memory blocks of /sys/devices/system/memory (installed RAM), else
+	//     /proc/meminfo MemTotal rounded up (what's left after the kernel's reservations)
+	//   - GPU, VramGB: the PCI display devices of /sys/class/drm, see ProbeGraphics
+	//   - SystemType: worded like Windows' from the uname machine
+	// Every path is under a root directory, so a fixture tree of the same files stands in
+	// for a machine. A probe reads about ten small files: tens of microseconds.
+	class LinuxHardwareProbe
+	{
+	public:
+#if defined(__linux__)
+		// The machine this runs on
+		static HardwareInfo Probe()
+		{
+			utsname names{};
+			uname(&names);
+			HardwareInfo info = Probe("/", names.machine);
+			info.DeviceName = Utf8::Decode(names.nodename);
+			return info;
+		}
+#endif
+
+		// The tree under 'root', on a machine that uname(2) would call 'machine' ("x86_64")
+		static HardwareInfo Probe(const std::filesystem::path& root, std::string_view machine)
+		{
+			TraceSpan span{ "ProbeLinux" };
+			HardwareInfo info;
+			info.DeviceName = Utf8::Decode(Trim(ReadText(root / "proc/sys/kernel/hostname")));
+			ProbeProcessor(root, info);
+			ProbeMemory(root, info);
+			ProbeGraphics(root, info);
+			info.SystemType = SystemTypeOf(machine);
+			return info;
+		}
+
+	private:
+		static constexpr double BytesPerGB = 1024.0 * 1024.0 * 1024.0;
+
+		struct Gpu
+		{
+			std::wstring Name;
+			double VramGB = 0;
+			bool Discrete = false;
+		};
+
+		static void ProbeProcessor(const std::filesystem::path& root, HardwareInfo& info)
+		{
+			// Only the first processor's block is needed, and the kernel formats the file as
+			// it's read: on a big machine the whole of it is hundreds of KB
+			std::string cpuinfo = ReadText(root / "proc/cpuinfo", 16 * 1024);
+			std::string name = CollapseSpaces(Field(cpuinfo, "model name"));
+			if (name.empty())
+				name = CollapseSpaces(Field(cpuinfo, "Hardware"));
+			if (name.empty())
+			{
+				// arm64 has no model name, only the implementer's JEDEC code
+				static constexpr std::pair<unsigned, const char*> Implementers[] = {
+					{ 0x41, "ARM" },
+					{ 0x46, "Fujitsu" },
+					{ 0x48, "HiSilicon" },
+					{ 0x4E, "NVIDIA" },
+					{ 0x51, "Qualcomm" },
+					{ 0x61, "Apple" },
+					{ 0xC0, "Ampere" },
+				};
+				unsigned implementer = 0;
+				if (ParseNumber(Field(cpuinfo, "CPU implementer"), implementer))
+				{
+					name = "ARM processor";
+					for (const auto& [code, vendor] : Implementers)
+					{
+						if (code == implementer)
+							name = std::string(vendor) + " ARM processor";
+					}
+				}
+			}
+			if (name.empty())
+				return;
+
+			// Windows shows the speed after the name ("... @ 2.30GHz   2.30 GHz"); so do we
+			uint64_t maxKHz = 0;
+			if (ParseNumber(Trim(ReadText(root / "sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq")), maxKHz) && maxKHz > 0)
+			{
+				char speed[32];
+				std::snprintf(speed, sizeof(speed), "   %.2f GHz", static_cast<double>(maxKHz) / 1e6);
+				name += speed;
+			}
+			info.Processor = Utf8::Decode(name);
+		}
+
+		static void ProbeMemory(const std::filesystem::path& root, HardwareInfo& info)
+		{
+			uint64_t totalKB = 0;
+			ParseNumber(Field(ReadText(root / "proc/meminfo", 4096), "MemTotal"), totalKB);
+			double usableGB = static_cast<double>(totalKB) * 1024.0 / BytesPerGB;
+
+			// Installed RAM: the memory blocks, online or not, each block_size_bytes (hex).
+			// They cover whole sections, so round to the half GB.
+			double installedGB = 0;
+			uint64_t blockBytes = 0;
+			if (ParseNumber(Trim(ReadText(root / "sys/devices/system/memory/block_size_bytes")), blockBytes, 16) && blockBytes > 0)
+			{
+				uint64_t blocks = 0;
+				std::error_code error;
+				for (std::filesystem::directory_iterator entry(root / "sys/devices/system/memory", error), end; !error && entry != end; entry.increment(error))
+				{
+					std::string name = entry->path().filename().string();
+					blocks += name.size() > 6 && name.starts_with("memory") && IsDigits(std::string_view(name).substr(6));
+				}
+				installedGB = std::round(static_cast<double>(blocks * blockBytes) / BytesPerGB * 2) / 2;
+			}
+			if (installedGB < usableGB)
+				installedGB = std::ceil(usableGB);
+			if (installedGB <= 0)
+				return;
+
+			// Like Windows' "16.0 GB (15.7 GB usable)"
+			info.RamGB = installedGB;
+			info.RAM = FormatSize(installedGB);
+			std::wstring usable = FormatSize(usableGB);
+			if (usableGB > 0 && usable != info.RAM)
+				info.RAM += L" (" + usable + L" usable)";
+		}
+
+		// One Gpu per PCI display device under /sys/class/drm (cardN, not its connectors or
+		// render nodes). sysfs has no marketing names, so they come from:
+		//   - NVIDIA: the driver's /proc/driver/nvidia/gpus/<slot>/information "Model"
+		//   - AMD: amdgpu's product_name where the board has one
+		//   - Intel: the device id's family, close enough for AnalyzeGPU (Arc, Iris Xe, the rest)
+		// and VRAM from amdgpu's mem_info_vram_total, else from the largest prefetchable BAR when
+		// resizable BAR maps all of it (1 GB or more). The dedicated card with the most VRAM
+		// is the one reported.
+		static void ProbeGraphics(const std::filesystem::path& root, HardwareInfo& info)
+		{
+			std::vector<Gpu> gpus;
+			std::set<std::filesystem::path> seen;
+			std::error_code error;
+			for (std::filesystem::directory_iterator entry(root / "sys/class/drm", error), end; !error && entry != end; entry.increment(error))
+			{
+				std::string name = entry->path().filename().string();
+				if (name.size() <= 4 || !name.starts_with("card") || !IsDigits(std::string_view(name).substr(4)))
+					continue;
+				std::filesystem::path device = entry->path() / "device";
+				std::error_code canonicalError;
+				if (!seen.insert(std::filesystem::weakly_canonical(device, canonicalError)).second)
+					continue;
+				Gpu gpu;
+				if (ProbeGpu(root, device, gpu))
+					gpus.push_back(std::move(gpu));
+			}
+			if (gpus.empty())
+				return;
+
+			const Gpu* best = &gpus.front();
+			for (const Gpu& gpu : gpus)
+			{
+				if (gpu.Discrete > best->Discrete || (gpu.Discrete == best->Discrete && gpu.VramGB > best->VramGB))
+					best = &gpu;
+			}
+			info.GPU = best->Name;
+			info.VramGB = best->VramGB;
+			if (best->VramGB > 0)
+				info.VRAM = FormatSize(best->VramGB);
+		}
+
+		static bool ProbeGpu(const std::filesystem::path& root, const std::filesystem::path& device, Gpu& gpu)
+		{
+			unsigned vendor = 0;
+			unsigned id = 0;
+			ParseNumber(Trim(ReadText(device / "vendor")), vendor);
+			ParseNumber(Trim(ReadText(device / "device")), id);
+			std::string uevent = ReadText(device / "uevent", 4096);
+			std::string_view driver = Value(uevent, "DRIVER");
+
+			uint64_t vramBytes = 0;
+			ParseNumber(Trim(ReadText(device / "mem_info_vram_total")), vramBytes);
+			if (vramBytes == 0)
+				vramBytes = LargestPrefetchableBar(device);
+			gpu.VramGB = static_cast<double>(vramBytes) / BytesPerGB;
+
+			switch (vendor)
+			{
+			case 0x10DE:
+			{
+				std::string information = ReadText(root / "proc/driver/nvidia/gpus" / std::string(Value(uevent, "PCI_SLOT_NAME")) / "information", 4096);
+				std::string model = CollapseSpaces(Field(information, "Model"));
+				gpu.Name = Utf8::Decode(model.empty() ? "NVIDIA GPU" : model);
+				gpu.Discrete = true;
+				return true;
+			}
+			case 0x1002:
+			{
+				std::string product = CollapseSpaces(ReadText(device / "product_name"));
+				gpu.Name = Utf8::Decode(product.empty() ? "AMD Radeon Graphics" : product);
+				// APUs carve out a few hundred MB to a couple of GB
+				gpu.Discrete = gpu.VramGB > 2;
+				return true;
+			}
+			case 0x8086:
+				gpu.Name = IntelGraphicsName(id, gpu.Discrete);
+				if (!gpu.Discrete)
+					gpu.VramGB = 0;     // A BAR into shared memory, not VRAM
+				return true;
+			case 0x5143:
+				gpu.Name = L"Qualcomm(R) Adreno(TM) GPU";
+				return true;
+			default:
+				// Qualcomm's is a platform device without PCI ids
+				if (driver == "msm" || driver == "msm_drm")
+				{
+					gpu.Name = L"Qualcomm(R) Adreno(TM) GPU";
+					return true;
+				}
+				if (vendor == 0 && driver.empty())
+					return false;
+				gpu.Name = Utf8::Decode(driver.empty() ? std::string("Display adapter") : std::string(driver) + " display adapter");
+				return true;
+			}
+		}
+
+		static std::wstring IntelGraphicsName(unsigned id, bool& discrete)
+		{
+			// DG2 (Alchemist) and BMG (Battlemage) cards
+			if ((id >= 0x5690 && id <= 0x56BF) || (id >= 0xE202 && id <= 0xE21F))
+			{
+				discrete = true;
+				return L"Intel(R) Arc(TM) Graphics";
+			}
+			// Meteor Lake and Lunar Lake integrated Arc
+			if ((id >= 0x7D40 && id <= 0x7DFF) || (id >= 0x6420 && id <= 0x64BF))
+				return L"Intel(R) Arc(TM) Graphics";
+			// Iris Xe: Tiger Lake, Alder Lake-P, Raptor Lake-P GT2 parts
+			static constexpr unsigned IrisXe[] = { 0x9A40, 0x9A49, 0x46A6, 0x46A8, 0x46AA, 0x46C0, 0x46C1, 0xA7A0, 0xA7A8, 0xA720 };
+			if (std::find(std::begin(IrisXe), std::end(IrisXe), id) != std::end(IrisXe))
+				return L"Intel(R) Iris(R) Xe Graphics";
+			return L"Intel(R) Graphics";
+		}
+
+		// /sys/.../resource: one "start end flags" line of hex per BAR
+		static uint64_t LargestPrefetchableBar(const std::filesystem::path& device)
+		{
+			constexpr uint64_t Prefetchable = 0x2000;     // IORESOURCE_PREFETCH
+			std::string resources = ReadText(device / "resource", 4096);
+			uint64_t largest = 0;
+			for (size_t start = 0; start < resources.size();)
+			{
+				size_t end = resources.find('\n', start);
+				std::string_view line = std::string_view(resources).substr(start, end == std::string::npos ? std::string::npos : end - start);
+				start = end == std::string::npos ? resources.size() : end + 1;
+
+				uint64_t values[3] = {};
+				size_t count = 0;
+				for (size_t at = 0; count < 3 && at < line.size(); count++)
+				{
+					size_t next = line.find(' ', at);
+					if (!ParseNumber(line.substr(at, next == std::string_view::npos ? std::string_view::npos : next - at), values[count]))
+						break;
+					at = next == std::string_view::npos ? line.size() : next + 1;
+				}
+				if (count == 3 && (values[2] & Prefetchable) != 0 && values[1] > values[0])
+					largest = (std::max)(largest, values[1] - values[0] + 1);
+			}
+			return static_cast<double>(largest) >= BytesPerGB ? largest : 0;
+		}
+
+		static std::wstring SystemTypeOf(std::string_view machine)
+		{
+			if (machine == "x86_64" || machine == "amd64")
+				return L"64-bit operating system, x64-based processor";
+			if (machine == "aarch64" || machine == "arm64")
+				return L"64-bit operating system, ARM-based processor";
+			if (machine.starts_with("arm"))
+				return L"32-bit operating system, ARM-based processor";
+			if (machine.size() == 4 && machine[0] == 'i' && machine.substr(2) == "86")
+				return L"32-bit operating system, x86-based processor";
+			// Anything else (riscv64, ppc64le, ...) is left for AnalyzeArchitecture to call unknown
+			return Utf8::Decode(machine);
+		}
+
+		// "16 GB", "15.5 GB", "512 MB"
+		static std::wstring FormatSize(double gb)
+		{
+			char text[32];
+			if (gb < 1)
+				std::snprintf(text, sizeof(text), "%.0f MB", gb * 1024);
+			else if (std::abs(gb - std::round(gb)) < 0.05)
+				std::snprintf(text, sizeof(text), "%.0f GB", gb);
+			else
+				std::snprintf(text, sizeof(text), "%.1f GB", gb);
+			return Utf8::Decode(text);
+		}
+
+		// Up to 'limit' bytes of a file; empty when it can't be read
+		static std::string ReadText(const std::filesystem::path& path, size_t limit = 256)
+		{
+			std::ifstream file(path, std::ios::binary);
+			if (!file)
+				return {};
+			std::string text(limit, '\0');
+			file.read(text.data(), static_cast<std::streamsize>(limit));
+			text.resize(static_cast<size_t>(file.gcount()));
+			return text;
+		}
+
+		// The value of a "key<tabs/spaces>: value" line (cpuinfo, meminfo)
+		static std::string_view Field(std::string_view text, std::string_view key)
+		{
+			for (size_t start = 0; start < text.size();)
+			{
+				size_t end = text.find('\n', start);
+				std::string_view line = text.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+				start = end == std::string_view::npos ? text.size() : end + 1;
+
+				size_t colon = line.find(':');
+				if (colon != std::string_view::npos && Trim(line.substr(0, colon)) == key)
+					return Trim(line.substr(colon + 1));
+			}
+			return {};
+		}
+
+		// The value of a "KEY=value" line (uevent)
+		static std::string_view Value(std::string_view text, std::string_view key)
+		{
+			for (size_t start = 0; start < text.size();)
+			{
+				size_t end = text.find('\n', start);
+				std::string_view line = text.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+				start = end == std::string_view::npos ? text.size() : end + 1;
+
+				if (line.size() > key.size() && line.starts_with(key) && line[key.size()] == '=')
+					return Trim(line.substr(key.size() + 1));
+			}
+			return {};
+		}
+
+		// Decimal, or hex with a 0x prefix or base 16; a trailing unit ("16318436 kB") is ignored
+		template <typename Number>
+		static bool ParseNumber(std::string_view text, Number& value, int base = 10)
+		{
+			text = Trim(text);
+			if (text.starts_with("0x") || text.starts_with("0X"))
+			{
+				text.remove_prefix(2);
+				base = 16;
+			}
+			auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value, base);
+			return error == std::errc{} && end != text.data();
+		}
+
+		static std::string_view Trim(std::string_view text)
+		{
+			size_t first = text.find_first_not_of(" \t\r\n");
+			if (first == std::string_view::npos)
+				return {};
+			return text.substr(first, text.find_last_not_of(" \t\r\n") - first + 1);
+		}
+
+		static std::string CollapseSpaces(std::string_view text)
+		{
+			std::string collapsed;
+			for (char c : Trim(text))
+			{
+				bool space = c == ' ' || c == '\t' || c == '\n' || c == '\r';
+				if (!space)
+					collapsed += c;
+				else if (!collapsed.empty() && collapsed.back() != ' ')
+					collapsed += ' ';
+			}
+			return collapsed;
+		}
+
+		static bool IsDigits(std::string_view text)
+		{
+			return !text.empty() && std::all_of(text.begin(), text.end(), [](char c) { return c >= '0' && c <= '9'; });
+		}
+	};
+}
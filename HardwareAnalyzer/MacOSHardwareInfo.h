@@ -1,9 +1,17 @@
 #pragma once
 #include "pch.h"
 #include "HardwareInfo.h"
+#include "HardwareThresholds.h"
+#include "LabelPack.h"
+#include "OcrNormalizer.h"
+#include "OcrTextScanner.h"
+#include "QuantityParser.h"
+#include "RuleStats.h"
+#include "Tracing.h"
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <regex>
 #include <algorithm>
 
 namespace HardwareAnalyzer
@@ -14,13 +22,21 @@ namespace HardwareAnalyzer
 		macOS
 	};
 
-	struct MacOSHardwareInfo
+	// Template over its string type like BasicHardwareInfo
+	template <typename String>
+	struct BasicMacOSHardwareInfo
 	{
-		std::wstring DeviceName;      // e.g., "MacBook Pro"
-		std::wstring DeviceYear;      // e.g., "2020", "2023"
-		std::wstring Chip;            // e.g., "Apple M1", "Apple M2 Max"
-		std::wstring Memory;          // e.g., "16 GB"
-		std::wstring MacOSVersion;    // e.g., "Ventura 13.0", "Sonoma 15.0"
+		using Allocator = typename String::allocator_type;
+
+		BasicMacOSHardwareInfo() = default;
+		explicit BasicMacOSHardwareInfo(const Allocator& allocator)
+			: DeviceName(allocator), DeviceYear(allocator), Chip(allocator), Memory(allocator), MacOSVersion(allocator) {}
+
+		String DeviceName;      // e.g., "MacBook Pro"
+		String DeviceYear;      // e.g., "2020", "2023"
+		String Chip;            // e.g., "Apple M1", "Apple M2 Max"
+		String Memory;          // e.g., "16 GB"
+		String MacOSVersion;    // e.g., "Ventura 13.0", "Sonoma 15.0"
 
 		double MemoryGB = 0;
 		int ChipGeneration = 0;       // 1 for M1, 2 for M2, etc.
@@ -29,138 +45,53 @@ namespace HardwareAnalyzer
 		bool IsIntelMac = false;
 	};
 
+	using MacOSHardwareInfo = BasicMacOSHardwareInfo<std::wstring>;
+
+	namespace pmr
+	{
+		using MacOSHardwareInfo = BasicMacOSHardwareInfo<std::pmr::wstring>;
+	}
+
 	class MacOSHardwareAnalyzerService
 	{
 	public:
 		static MacOSHardwareInfo ParseMacOSOcrText(const std::wstring& text)
 		{
-			MacOSHardwareInfo info;
-			std::wstring normalizedText = text;
-
-			// Normalize OCR errors: replace common misreads
-			// OCR often reads "M1" as "Ml" (lowercase L) or "MI" (uppercase I)
-			// Replace "Ml" and "MI" patterns that look like Apple chip names
-			std::wregex ocrFixRegex(LR"(Apple\s*M[lI](\d*))", std::regex::icase);
-			normalizedText = std::regex_replace(normalizedText, ocrFixRegex, L"Apple M1$1");
-
-			// Also fix standalone Ml/MI followed by comma or space (like "13-inch, Ml, 2020")
-			std::wregex ocrFixRegex2(LR"(\bM[lI]\b)", std::regex::icase);
-			normalizedText = std::regex_replace(normalizedText, ocrFixRegex2, L"M1");
-
-			// Extract device name (MacBook Pro, MacBook Air, iMac, Mac Mini, Mac Studio, Mac Pro)
-			std::wregex deviceRegex(LR"((MacBook\s*Pro|MacBook\s*Air|iMac|Mac\s*Mini|Mac\s*Studio|Mac\s*Pro))", std::regex::icase);
-			std::wsmatch deviceMatch;
-			if (std::regex_search(normalizedText, deviceMatch, deviceRegex))
-			{
-				info.DeviceName = deviceMatch[1].str();
-			}
-
-			// Extract year from subtitle line like "13-inch, M1, 2020"
-			std::wregex yearRegex(LR"((\d{4}))", std::regex::icase);
-			std::wsmatch yearMatch;
-			if (std::regex_search(normalizedText, yearMatch, yearRegex))
-			{
-				int year = 0;
-				try { year = std::stoi(yearMatch[1].str()); } catch (...) {}
-				if (year >= 2010 && year <= 2035)
-				{
-					info.DeviceYear = yearMatch[1].str();
-				}
-			}
-
-			// Extract Chip - look for "Apple M" followed by digit(s) and optional Pro/Max/Ultra
-			std::wregex appleChipRegex(LR"((Apple\s*M(\d+)(?:\s*(?:Pro|Max|Ultra))?))", std::regex::icase);
-			std::wsmatch chipMatch;
-			if (std::regex_search(normalizedText, chipMatch, appleChipRegex))
-			{
-				info.Chip = chipMatch[1].str();
-				info.IsAppleSilicon = true;
-
-				// Extract generation number from capture group 2
-				try {
-					info.ChipGeneration = std::stoi(chipMatch[2].str());
-				}
-				catch (...) {}
-			}
-
-			// Check for Intel processor if no Apple Silicon found
-			if (!info.IsAppleSilicon)
-			{
-				std::wregex intelRegex(LR"((Intel[^\n]{0,50}))", std::regex::icase);
-				if (std::regex_search(normalizedText, chipMatch, intelRegex))
-				{
-					info.Chip = chipMatch[1].str();
-					info.IsIntelMac = true;
-				}
-			}
-
-			// Extract Memory - look for common RAM sizes followed by GB/Go
-			std::wregex memoryRegex(LR"(\b(8|16|24|32|48|64|96|128)\s*(GB|Go)\b)", std::regex::icase);
-			std::wsmatch memMatch;
-			if (std::regex_search(normalizedText, memMatch, memoryRegex))
-			{
-				info.Memory = memMatch[1].str() + L" " + memMatch[2].str();
-				try {
-					info.MemoryGB = std::stod(memMatch[1].str());
-				}
-				catch (...) {}
-			}
-
-			// Extract macOS version - FIRST look for known version names
-			// This avoids matching "macOS Apple" incorrectly
-			std::wregex osNameRegex(LR"((Sonoma|Sequoia|Ventura|Monterey|Big\s*Sur|Catalina|Mojave|High\s*Sierra|Sierra|Tahoe)\s*(\d+)(?:\.(\d+))?(?:\.(\d+))?)", std::regex::icase);
-			std::wsmatch osMatch;
-			if (std::regex_search(normalizedText, osMatch, osNameRegex))
-			{
-				std::wstring versionName = osMatch[1].str();
-				std::wstring majorStr = osMatch[2].str();
-				std::wstring minorStr = osMatch[3].matched ? osMatch[3].str() : L"0";
-				std::wstring patchStr = osMatch[4].matched ? osMatch[4].str() : L"";
-
-				info.MacOSVersion = versionName + L" " + majorStr + L"." + minorStr;
-				if (!patchStr.empty())
-				{
-					info.MacOSVersion += L"." + patchStr;
-				}
+			return ParseMacOSOcrText(text, ParseLimits{});
+		}
 
-				try {
-					info.MacOSMajorVersion = std::stoi(majorStr);
-				}
-				catch (...) {}
-			}
+		static MacOSHardwareInfo ParseMacOSOcrText(const std::wstring& text, const ParseLimits& limits)
+		{
+			MacOSHardwareInfo info;
+			Parse(text, limits, info);
+			return info;
+		}
 
+		// Every string of the parse comes from 'arena', as in HardwareAnalyzerService::ParseOcrText
+		static pmr::MacOSHardwareInfo ParseMacOSOcrText(std::wstring_view text, const ParseLimits& limits, std::pmr::memory_resource* arena)
+		{
+			pmr::MacOSHardwareInfo info{ pmr::MacOSHardwareInfo::Allocator(arena) };
+			Parse(text, limits, info);
 			return info;
 		}
 
 		static std::vector<HardwareCheckResult> AnalyzeMacOSHardware(const MacOSHardwareInfo& info)
 		{
 			std::vector<HardwareCheckResult> results;
+			Analyze(info, results);
+			return results;
+		}
 
-			// Analyze Chip (Apple Silicon vs Intel)
-			HardwareCheckResult chipResult;
-			chipResult.Name = L"Chip";
-			chipResult.Value = info.Chip.empty() ? L"?" : info.Chip;
-			chipResult.Status = AnalyzeChip(info, chipResult.ReasonKey);
-			results.push_back(chipResult);
-
-			// Analyze Memory (6 GB is warning threshold per user requirement)
-			HardwareCheckResult memResult;
-			memResult.Name = L"Memory";
-			memResult.Value = info.Memory.empty() ? L"?" : info.Memory;
-			memResult.Status = AnalyzeMacMemory(info.MemoryGB, memResult.ReasonKey);
-			results.push_back(memResult);
-
-			// Analyze macOS Version (minimum macOS 15 Sonoma)
-			HardwareCheckResult osResult;
-			osResult.Name = L"macOS Version";
-			osResult.Value = info.MacOSVersion.empty() ? L"?" : info.MacOSVersion;
-			osResult.Status = AnalyzeMacOSVersion(info.MacOSMajorVersion, osResult.ReasonKey);
-			results.push_back(osResult);
-
+		// The results and their strings come from the arena 'info' was parsed into
+		static pmr::CheckResults AnalyzeMacOSHardware(const pmr::MacOSHardwareInfo& info)
+		{
+			pmr::CheckResults results{ info.Chip.get_allocator() };
+			Analyze(info, results);
 			return results;
 		}
 
-		static int CalculateGlobalScore(const std::vector<HardwareCheckResult>& results)
+		template <typename Results>
+		static int CalculateGlobalScore(const Results& results)
 		{
 			// Count how many results have actual values (not "?")
 			int validResults = 0;
@@ -211,33 +142,233 @@ namespace HardwareAnalyzer
 		}
 
 	private:
-		static StatusLevel AnalyzeChip(const MacOSHardwareInfo& info, std::wstring& reasonKey)
+		template <typename String>
+		static void Parse(std::wstring_view text, const ParseLimits& limits, BasicMacOSHardwareInfo<String>& info)
+		{
+			TraceSpan span{ "ParseMacOSOcrText" };
+			std::shared_ptr<const LabelCatalog> catalog = LabelPack::Active();
+			String normalizedText{ info.Chip.get_allocator() };
+			OcrTextScanner::ApplyLimits(text, limits, normalizedText);
+
+			// Normalize OCR errors: replace common misreads
+			// OCR often reads "M1" as "Ml" (lowercase L) or "MI" (uppercase I), both after "Apple"
+			// and standalone (like "13-inch, Ml, 2020"); the normalizer fixes both in place
+			OcrNormalizer::Normalize(normalizedText, *catalog);
+
+			std::wstring_view textView = normalizedText;
+			size_t length = 0;
+
+			// macOS labels of every language in the active catalog (model and release names, units)
+			const LanguageLabels& labels = catalog->All();
+
+			// Extract device name (MacBook Pro, MacBook Air, iMac, Mac Mini, Mac Studio, Mac Pro)
+			RuleProbe probe{ Rule::MacDeviceName };
+			size_t devicePos = OcrTextScanner::FindAny(textView, labels.Labels(LabelField::MacDeviceModels), 0, length);
+			if (devicePos != OcrTextScanner::npos)
+			{
+				probe.Match();
+				info.DeviceName.assign(textView.substr(devicePos, length));
+			}
+
+			// Extract year from subtitle line like "13-inch, M1, 2020"
+			// (first run of 4 digits in the text)
+			probe.Attempt(Rule::MacYear);
+			size_t yearPos = OcrTextScanner::FindAny(textView, { L"####" }, 0, length);
+			if (yearPos != OcrTextScanner::npos)
+			{
+				std::wstring_view yearText = textView.substr(yearPos, length);
+				int year = 0;
+				if (QuantityParser::ParseInteger(yearText, year) && year >= 2010 && year <= 2035)
+				{
+					probe.Match();
+					info.DeviceYear.assign(yearText);
+				}
+			}
+
+			// Extract Chip - look for "Apple M" followed by digit(s) and optional Pro/Max/Ultra
+			probe.Attempt(Rule::MacAppleChip);
+			for (size_t pos = 0; pos < textView.size(); pos++)
+			{
+				// The digits are only skipped after a match: from every position of a long digit
+				// run, skipping the rest of it would make the scan quadratic
+				length = OcrTextScanner::MatchAt(textView, pos, L"apple m");
+				if (length == 0)
+					continue;
+				size_t digitsEnd = OcrTextScanner::SkipDigits(textView, pos + length);
+				if (digitsEnd == pos + length)
+					continue;
+
+				size_t chipEnd = digitsEnd;
+				size_t tierStart = OcrTextScanner::SkipWhitespace(textView, digitsEnd);
+				size_t tierLength = OcrTextScanner::MatchAnyAt(textView, tierStart, { L"pro", L"max", L"ultra" });
+				if (tierLength > 0)
+				{
+					chipEnd = tierStart + tierLength;
+				}
+
+				probe.Match();
+				info.Chip.assign(textView.substr(pos, chipEnd - pos));
+				info.IsAppleSilicon = true;
+
+				// Extract generation number
+				QuantityParser::ParseInteger(textView.substr(pos + length, digitsEnd - pos - length), info.ChipGeneration);
+				break;
+			}
+
+			// Check for Intel processor if no Apple Silicon found
+			if (!info.IsAppleSilicon)
+			{
+				probe.Attempt(Rule::MacIntelChip);
+				size_t intelPos = OcrTextScanner::FindAny(textView, { L"intel" }, 0, length);
+				if (intelPos != OcrTextScanner::npos)
+				{
+					probe.Match();
+					// "Intel" and at most 50 more characters of its line
+					size_t chipEnd = (std::min)(OcrTextScanner::LineEnd(textView, intelPos), intelPos + length + 50);
+					info.Chip.assign(textView.substr(intelPos, chipEnd - intelPos));
+					info.IsIntelMac = true;
+				}
+			}
+
+			// Extract Memory - look for common RAM sizes followed by GB/Go
+			// Same as "\b(8|16|24|32|48|64|96|128)\s*(GB|Go)\b"
+			probe.Attempt(Rule::MacMemory);
+			for (size_t pos = 0; pos < textView.size(); pos++)
+			{
+				if (pos > 0 && OcrTextScanner::IsWordChar(textView[pos - 1]))
+					continue;
+
+				size_t sizeLength = OcrTextScanner::MatchAnyAt(textView, pos, { L"8", L"16", L"24", L"32", L"48", L"64", L"96", L"128" });
+				if (sizeLength == 0)
+					continue;
+
+				size_t unitStart = OcrTextScanner::SkipWhitespace(textView, pos + sizeLength);
+				size_t unitLength = OcrTextScanner::MatchAnyAt(textView, unitStart, labels.Labels(LabelField::MacMemoryUnits));
+				size_t unitEnd = unitStart + unitLength;
+				if (unitLength == 0 || (unitEnd < textView.size() && OcrTextScanner::IsWordChar(textView[unitEnd])))
+					continue;
+
+				probe.Match();
+				std::wstring_view sizeText = textView.substr(pos, sizeLength);
+				std::wstring_view unitText = textView.substr(unitStart, unitLength);
+				info.Memory.assign(sizeText);
+				info.Memory += L' ';
+				info.Memory.append(unitText);
+				uint64_t bytes = 0;
+				if (QuantityParser::Parse(sizeText, unitText, bytes))
+				{
+					info.MemoryGB = QuantityParser::ToGB(bytes);
+				}
+				break;
+			}
+
+			// Extract macOS version - FIRST look for known version names
+			// This avoids matching "macOS Apple" incorrectly
+			probe.Attempt(Rule::MacOSVersionName);
+			for (size_t pos = 0; pos < textView.size(); pos++)
+			{
+				size_t nameLength = OcrTextScanner::MatchAnyAt(textView, pos, labels.Labels(LabelField::MacVersionNames));
+				if (nameLength == 0)
+					continue;
+
+				// "<name> <major>[.<minor>[.<patch>]]"
+				size_t majorStart = OcrTextScanner::SkipWhitespace(textView, pos + nameLength);
+				size_t majorEnd = OcrTextScanner::SkipDigits(textView, majorStart);
+				if (majorEnd == majorStart)
+					continue;
+
+				auto versionPart = [&](size_t dot) {
+					bool present = dot + 1 < textView.size() && textView[dot] == L'.' && OcrTextScanner::IsDigit(textView[dot + 1]);
+					return present ? OcrTextScanner::SkipDigits(textView, dot + 1) : dot;
+				};
+				size_t minorEnd = versionPart(majorEnd);
+				size_t patchEnd = minorEnd > majorEnd ? versionPart(minorEnd) : minorEnd;
+
+				probe.Match();
+				// "<name> <major>.<minor>[.<patch>]", the minor defaulting to 0
+				std::wstring_view majorText = textView.substr(majorStart, majorEnd - majorStart);
+				info.MacOSVersion.assign(textView.substr(pos, nameLength));
+				info.MacOSVersion += L' ';
+				info.MacOSVersion.append(majorText);
+				info.MacOSVersion += L'.';
+				if (minorEnd > majorEnd)
+					info.MacOSVersion.append(textView.substr(majorEnd + 1, minorEnd - majorEnd - 1));
+				else
+					info.MacOSVersion += L'0';
+				if (patchEnd > minorEnd)
+				{
+					info.MacOSVersion += L'.';
+					info.MacOSVersion.append(textView.substr(minorEnd + 1, patchEnd - minorEnd - 1));
+				}
+
+				QuantityParser::ParseInteger(majorText, info.MacOSMajorVersion);
+				break;
+			}
+		}
+
+		template <typename String>
+		static void Analyze(const BasicMacOSHardwareInfo<String>& info, BasicCheckResults<String>& results)
+		{
+			TraceSpan span{ "AnalyzeMacOSHardware" };
+			auto allocator = info.Chip.get_allocator();
+			results.reserve(3);
+
+			// Analyze Chip (Apple Silicon vs Intel)
+			auto& chipResult = results.emplace_back(allocator);
+			chipResult.Name = L"Chip";
+			chipResult.Value = info.Chip.empty() ? std::wstring_view(L"?") : std::wstring_view(info.Chip);
+			chipResult.Status = AnalyzeChip(info, chipResult.ReasonKey);
+
+			// Analyze Memory (6 GB is warning threshold per user requirement)
+			auto& memResult = results.emplace_back(allocator);
+			memResult.Name = L"Memory";
+			memResult.Value = info.Memory.empty() ? std::wstring_view(L"?") : std::wstring_view(info.Memory);
+			memResult.Status = AnalyzeMacMemory(info.MemoryGB, memResult.ReasonKey);
+
+			// Analyze macOS Version (minimum macOS 15 Sonoma)
+			auto& osResult = results.emplace_back(allocator);
+			osResult.Name = L"macOS Version";
+			osResult.Value = info.MacOSVersion.empty() ? std::wstring_view(L"?") : std::wstring_view(info.MacOSVersion);
+			osResult.Status = AnalyzeMacOSVersion(info.MacOSMajorVersion, osResult.ReasonKey);
+		}
+
+		template <typename String>
+		static StatusLevel AnalyzeChip(const BasicMacOSHardwareInfo<String>& info, String& reasonKey)
 		{
+			RuleProbe probe{ Rule::MacChipNotFound };
 			if (info.Chip.empty())
 			{
+				probe.Match();
 				reasonKey = L"Reason_ChipNotFound";
 				return StatusLevel::Warning;
 			}
 
 			// Intel Mac is not supported
+			probe.Attempt(Rule::MacChipIntel);
 			if (info.IsIntelMac)
 			{
+				probe.Match();
 				reasonKey = L"Reason_IntelMacNotSupported";
 				return StatusLevel::Bad;
 			}
 
 			// Apple Silicon is supported (M1, M2, M3, M4, M5+... no upper limit)
+			probe.Attempt(Rule::MacChipAppleSilicon);
 			if (info.IsAppleSilicon && info.ChipGeneration >= 1)
 			{
+				probe.Match();
 				reasonKey = L"Reason_AppleSiliconSupported";
 				return StatusLevel::Good;
 			}
 
+			probe.Attempt(Rule::MacChipUnknown);
+			probe.Match();
 			reasonKey = L"Reason_ChipUnknown";
 			return StatusLevel::Warning;
 		}
 
-		static StatusLevel AnalyzeMacMemory(double memoryGB, std::wstring& reasonKey)
+		template <typename String>
+		static StatusLevel AnalyzeMacMemory(double memoryGB, String& reasonKey)
 		{
 			if (memoryGB <= 0)
 			{
@@ -245,18 +376,17 @@ namespace HardwareAnalyzer
 				return StatusLevel::Warning;
 			}
 
-			// Per user requirement: 6 GB is warning threshold (same rule as Windows)
-			if (memoryGB < 6)
+			if (memoryGB < HardwareThresholds::MacMemoryBadGB)
 			{
 				reasonKey = L"Reason_MacVeryLowMemory";
 				return StatusLevel::Bad;
 			}
-			else if (memoryGB < 8)
+			else if (memoryGB < HardwareThresholds::MacMemoryWarningGB)
 			{
 				reasonKey = L"Reason_MacLowMemory";
 				return StatusLevel::Warning;
 			}
-			else if (memoryGB < 16)
+			else if (memoryGB < HardwareThresholds::MacMemoryGoodGB)
 			{
 				reasonKey = L"Reason_MacAcceptableMemory";
 				return StatusLevel::Good;
@@ -268,7 +398,8 @@ namespace HardwareAnalyzer
 			}
 		}
 
-		static StatusLevel AnalyzeMacOSVersion(int majorVersion, std::wstring& reasonKey)
+		template <typename String>
+		static StatusLevel AnalyzeMacOSVersion(int majorVersion, String& reasonKey)
 		{
 			if (majorVersion <= 0)
 			{
@@ -276,9 +407,8 @@ namespace HardwareAnalyzer
 				return StatusLevel::Warning;
 			}
 
-			// Minimum supported: macOS 15 (Sonoma) and above
-			// Support up to macOS 26 (Tahoe) and future versions (no upper limit)
-			if (majorVersion < 15)
+			// No upper limit: macOS 26 (Tahoe) and later are supported
+			if (majorVersion < HardwareThresholds::MinMacOSMajor)
 			{
 				reasonKey = L"Reason_MacOSTooOld";
 				return StatusLevel::Bad;
@@ -7,13 +7,18 @@
 #include <winrt/Windows.ApplicationModel.DataTransfer.h>
 #include <winrt/Windows.Storage.Streams.h>
 #include <winrt/Windows.Storage.h>
+#include <ShlObj.h>
 #include <filesystem>
+#include <fstream>
 
+#include "AnalysisPipeline.h"
 #include "HardwareInfo.h"
 #include "MacOSHardwareInfo.h"
 #include "OcrService.h"
 #include "ResultsDialog.h"
 #include "MacOSResultsDialog.h"
+#include "RuleStats.h"
+#include "Tracing.h"
 
 using namespace winrt::Windows::Foundation;
 using namespace winrt::Windows::ApplicationModel::Resources;
@@ -51,6 +56,18 @@ namespace winrt::HardwareAnalyzer::implementation
 		InitializeMica(this);
 
 		SetTitleBar(AppTitleBar());
+
+		// Every analysis is kept per device under %LOCALAPPDATA%\HardwareAnalyzer\History.
+		// Opening only maps the index; without it the app works as before.
+		PWSTR localAppData = nullptr;
+		if (SUCCEEDED(SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr, &localAppData)))
+		{
+			auto history = std::make_unique<::HardwareAnalyzer::AnalysisHistory>();
+			std::string error;
+			if (history->Open(std::filesystem::path{ localAppData } / L"HardwareAnalyzer" / L"History", error))
+				m_history = std::move(history);
+		}
+		CoTaskMemFree(localAppData);
 	}
 
 	void MainWindow::BrowseButton_Click(const winrt::Windows::Foundation::IInspectable&, const RoutedEventArgs&)
@@ -87,6 +104,31 @@ namespace winrt::HardwareAnalyzer::implementation
 		ProcessClipboard();
 	}
 
+	void MainWindow::CtrlShiftT_Invoked(const Microsoft::UI::Xaml::Input::KeyboardAccelerator&, const Microsoft::UI::Xaml::Input::KeyboardAcceleratorInvokedEventArgs& args)
+	{
+		args.Handled(true);
+
+		// First press starts recording spans, second press writes them as Chrome trace JSON
+		// (open %TEMP%\HardwareAnalyzer-trace.json in ui.perfetto.dev or chrome://tracing)
+		if (!::HardwareAnalyzer::Tracer::IsEnabled())
+		{
+			::HardwareAnalyzer::Tracer::Clear();
+			::HardwareAnalyzer::RuleStats::Reset();
+			::HardwareAnalyzer::Tracer::Enable(true);
+			return;
+		}
+
+		::HardwareAnalyzer::Tracer::Enable(false);
+		::HardwareAnalyzer::Tracer::WriteChromeTrace(std::filesystem::temp_directory_path() / L"HardwareAnalyzer-trace.json");
+
+		// Builds with HARDWARE_ANALYZER_RULE_STATS also dump the rule counters of the same window
+		if constexpr (::HardwareAnalyzer::RuleStats::Enabled)
+		{
+			std::ofstream rules(std::filesystem::temp_directory_path() / L"HardwareAnalyzer-rules.csv", std::ios::binary | std::ios::trunc);
+			rules << ::HardwareAnalyzer::RuleStats::ToCsv();
+		}
+	}
+
 	fire_and_forget MainWindow::OpenFilePicker()
 	{
 		FileOpenPicker picker;
@@ -144,6 +186,8 @@ namespace winrt::HardwareAnalyzer::implementation
 
 	fire_and_forget MainWindow::LoadImageFile(Windows::Storage::StorageFile file)
 	{
+		// A new image supersedes any analysis still running for the previous one
+		m_analysisJob.Cancel();
 		m_currentFile = file;
 
 		// Show preview
@@ -152,6 +196,7 @@ namespace winrt::HardwareAnalyzer::implementation
 		co_await bitmapImage.SetSourceAsync(stream);
 
 		PreviewImage().Source(bitmapImage);
+		LoadingPanel().Visibility(Visibility::Collapsed);
 		PreviewImage().Visibility(Visibility::Visible);
 		DropPrompt().Visibility(Visibility::Collapsed);
 		AnalyzeButton().IsEnabled(true);
@@ -213,6 +258,8 @@ namespace winrt::HardwareAnalyzer::implementation
 		if (!m_currentFile)
 			co_return;
 
+		::HardwareAnalyzer::TraceSpan span{ "MainWindow::AnalyzeImage", "ui" };
+
 		if (m_selectedPlatform == ::HardwareAnalyzer::TargetPlatform::macOS)
 		{
 			co_await AnalyzeMacOSImage();
@@ -231,6 +278,8 @@ namespace winrt::HardwareAnalyzer::implementation
 			co_return;
 
 		auto dispatcherQueue = Microsoft::UI::Dispatching::DispatcherQueue::GetForCurrentThread();
+		auto file = m_currentFile;
+		auto token = m_analysisJob.Begin();
 
 		// Show loading
 		LoadingPanel().Visibility(Visibility::Visible);
@@ -240,29 +289,39 @@ namespace winrt::HardwareAnalyzer::implementation
 		try
 		{
 			// Perform OCR
-			auto ocrText = co_await OcrService::PerformOcrAsync(m_currentFile);
-			std::wstring text(ocrText.c_str());
-
-			// Parse hardware info
-			auto info = ::HardwareAnalyzer::HardwareAnalyzerService::ParseOcrText(text);
-
-			// Analyze hardware
-			auto results = ::HardwareAnalyzer::HardwareAnalyzerService::AnalyzeHardware(info);
-
-			// Calculate score
-			int score = ::HardwareAnalyzer::HardwareAnalyzerService::CalculateGlobalScore(results);
+			::HardwareAnalyzer::TraceSpan ocrSpan{ "OcrService::PerformOcrAsync", "ui" };
+			auto ocrText = co_await OcrService::PerformOcrAsync(file);
+			ocrSpan.End();
+
+			// Parse, analyze and score on the worker pool; stops early if a newer job replaced this one
+			token.ThrowIfCancellationRequested();
+			auto analysis = co_await ::HardwareAnalyzer::AnalysisPipeline::AnalyzeWindowsTextAsync(std::wstring(ocrText.c_str()), token);
+			auto& info = analysis.Info;
+			auto& results = analysis.Results;
+			int score = analysis.Score;
+			if (m_history)
+				m_history->Append(analysis);
 
 			// Show results on UI thread
-			dispatcherQueue.TryEnqueue([this, info, results, score]() {
+			dispatcherQueue.TryEnqueue([this, token, info, results, score]() {
+				if (token.IsCancellationRequested())
+					return;
 				LoadingPanel().Visibility(Visibility::Collapsed);
 				PreviewImage().Visibility(Visibility::Visible);
 				AnalyzeButton().IsEnabled(true);
+				::HardwareAnalyzer::TraceSpan dialogSpan{ "ResultsDialog::Show", "ui" };
 				::HardwareAnalyzer::ResultsDialog::Show(this->Content().as<UIElement>().XamlRoot(), info, results, score);
 				});
 		}
+		catch (const ::HardwareAnalyzer::TaskCanceled&)
+		{
+			// Superseded by a newer image or analysis, which now owns the UI
+		}
 		catch (const winrt::hresult_error& ex)
 		{
-			dispatcherQueue.TryEnqueue([this, ex]() {
+			dispatcherQueue.TryEnqueue([this, token, ex]() {
+				if (token.IsCancellationRequested())
+					return;
 				LoadingPanel().Visibility(Visibility::Collapsed);
 				PreviewImage().Visibility(Visibility::Visible);
 				AnalyzeButton().IsEnabled(true);
@@ -286,6 +345,8 @@ namespace winrt::HardwareAnalyzer::implementation
 			co_return;
 
 		auto dispatcherQueue = Microsoft::UI::Dispatching::DispatcherQueue::GetForCurrentThread();
+		auto file = m_currentFile;
+		auto token = m_analysisJob.Begin();
 
 		// Show loading
 		LoadingPanel().Visibility(Visibility::Visible);
@@ -295,29 +356,39 @@ namespace winrt::HardwareAnalyzer::implementation
 		try
 		{
 			// Perform OCR
-			auto ocrText = co_await OcrService::PerformOcrAsync(m_currentFile);
-			std::wstring text(ocrText.c_str());
-
-			// Parse macOS hardware info
-			auto info = ::HardwareAnalyzer::MacOSHardwareAnalyzerService::ParseMacOSOcrText(text);
-
-			// Analyze macOS hardware
-			auto results = ::HardwareAnalyzer::MacOSHardwareAnalyzerService::AnalyzeMacOSHardware(info);
-
-			// Calculate score
-			int score = ::HardwareAnalyzer::MacOSHardwareAnalyzerService::CalculateGlobalScore(results);
+			::HardwareAnalyzer::TraceSpan ocrSpan{ "OcrService::PerformOcrAsync", "ui" };
+			auto ocrText = co_await OcrService::PerformOcrAsync(file);
+			ocrSpan.End();
+
+			// Parse, analyze and score on the worker pool; stops early if a newer job replaced this one
+			token.ThrowIfCancellationRequested();
+			auto analysis = co_await ::HardwareAnalyzer::AnalysisPipeline::AnalyzeMacOSTextAsync(std::wstring(ocrText.c_str()), token);
+			auto& info = analysis.Info;
+			auto& results = analysis.Results;
+			int score = analysis.Score;
+			if (m_history)
+				m_history->Append(analysis);
 
 			// Show results on UI thread
-			dispatcherQueue.TryEnqueue([this, info, results, score]() {
+			dispatcherQueue.TryEnqueue([this, token, info, results, score]() {
+				if (token.IsCancellationRequested())
+					return;
 				LoadingPanel().Visibility(Visibility::Collapsed);
 				PreviewImage().Visibility(Visibility::Visible);
 				AnalyzeButton().IsEnabled(true);
+				::HardwareAnalyzer::TraceSpan dialogSpan{ "MacOSResultsDialog::Show", "ui" };
 				::HardwareAnalyzer::MacOSResultsDialog::Show(this->Content().as<UIElement>().XamlRoot(), info, results, score);
 				});
 		}
+		catch (const ::HardwareAnalyzer::TaskCanceled&)
+		{
+			// Superseded by a newer image or analysis, which now owns the UI
+		}
 		catch (const winrt::hresult_error& ex)
 		{
-			dispatcherQueue.TryEnqueue([this, ex]() {
+			dispatcherQueue.TryEnqueue([this, token, ex]() {
+				if (token.IsCancellationRequested())
+					return;
 				LoadingPanel().Visibility(Visibility::Collapsed);
 				PreviewImage().Visibility(Visibility::Visible);
 				AnalyzeButton().IsEnabled(true);
@@ -2,8 +2,11 @@
 
 #include "MainWindow.g.h"
 #include "MicaWindow.h"
+#include "AnalysisHistory.h"
+#include "AsyncTask.h"
 #include "HardwareInfo.h"
 #include "MacOSHardwareInfo.h"
+#include <memory>
 
 namespace winrt::HardwareAnalyzer::implementation
 {
@@ -26,6 +29,8 @@ namespace winrt::HardwareAnalyzer::implementation
 			const Microsoft::UI::Xaml::DragEventArgs& e);
 		void CtrlV_Invoked(const Microsoft::UI::Xaml::Input::KeyboardAccelerator& sender,
 			const Microsoft::UI::Xaml::Input::KeyboardAcceleratorInvokedEventArgs& args);
+		void CtrlShiftT_Invoked(const Microsoft::UI::Xaml::Input::KeyboardAccelerator& sender,
+			const Microsoft::UI::Xaml::Input::KeyboardAcceleratorInvokedEventArgs& args);
 
 		void PlatformSelector_SelectionChanged(const Windows::Foundation::IInspectable& sender,
 			const Microsoft::UI::Xaml::Controls::SelectionChangedEventArgs& e);
@@ -43,6 +48,8 @@ namespace winrt::HardwareAnalyzer::implementation
 	private:
 		Windows::Storage::StorageFile m_currentFile{ nullptr };
 		::HardwareAnalyzer::TargetPlatform m_selectedPlatform{ ::HardwareAnalyzer::TargetPlatform::Windows };
+		::HardwareAnalyzer::LatestJob m_analysisJob;
+		std::unique_ptr<::HardwareAnalyzer::AnalysisHistory> m_history;   // nullptr if it couldn't be opened
 	};
 }
 
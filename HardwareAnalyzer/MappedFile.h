@@ -0,0 +1,268 @@
+#pragma once
+#include "pch.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace HardwareAnalyzer
+{
+	// Read-only view of a whole file mapped into memory. Pages are loaded on first touch
+	// and shared with every other process mapping the same file; the view stays valid
+	// until the MappedFile is destroyed, even if the file is deleted or replaced meanwhile.
+	// A file still being appended to can be mapped; the view covers its size at the time.
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+
+		MappedFile(MappedFile&& other) noexcept
+			: m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0))
+		{
+		}
+
+		MappedFile& operator=(MappedFile&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Unmap();
+				m_data = std::exchange(other.m_data, nullptr);
+				m_size = std::exchange(other.m_size, 0);
+			}
+			return *this;
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		~MappedFile()
+		{
+			Unmap();
+		}
+
+		// std::nullopt when the file can't be opened, is empty, or can't be mapped
+		static std::optional<MappedFile> Open(const std::filesystem::path& path)
+		{
+			MappedFile file;
+#ifdef _WIN32
+			HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+				OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (handle == INVALID_HANDLE_VALUE)
+				return std::nullopt;
+
+			LARGE_INTEGER size{};
+			if (GetFileSizeEx(handle, &size) && size.QuadPart > 0 && static_cast<unsigned long long>(size.QuadPart) <= SIZE_MAX)
+			{
+				// The view keeps the mapping object alive once both handles are closed
+				HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (mapping)
+				{
+					file.m_data = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+					file.m_size = file.m_data ? static_cast<size_t>(size.QuadPart) : 0;
+					CloseHandle(mapping);
+				}
+			}
+			CloseHandle(handle);
+#else
+			int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+				return std::nullopt;
+
+			struct stat status{};
+			if (fstat(fd, &status) == 0 && status.st_size > 0)
+			{
+				void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+				if (data != MAP_FAILED)
+				{
+					file.m_data = static_cast<const std::byte*>(data);
+					file.m_size = static_cast<size_t>(status.st_size);
+				}
+			}
+			close(fd);
+#endif
+			if (!file.m_data)
+				return std::nullopt;
+			return file;
+		}
+
+		const std::byte* Data() const { return m_data; }
+		size_t Size() const { return m_size; }
+
+	private:
+		void Unmap()
+		{
+			if (!m_data)
+				return;
+#ifdef _WIN32
+			UnmapViewOfFile(m_data);
+#else
+			munmap(const_cast<std::byte*>(m_data), m_size);
+#endif
+			m_data = nullptr;
+			m_size = 0;
+		}
+
+		const std::byte* m_data = nullptr;
+		size_t m_size = 0;
+	};
+
+	// Read-write view of a whole file. Stores go to the page cache like writes to the file,
+	// so they survive the process crashing; Flush() waits until they are on the disk.
+	class WritableMappedFile
+	{
+	public:
+		WritableMappedFile() = default;
+
+		WritableMappedFile(WritableMappedFile&& other) noexcept
+			: m_data(std::exchange(other.m_data, nullptr)), m_size(std::exchange(other.m_size, 0))
+#ifdef _WIN32
+			, m_file(std::exchange(other.m_file, INVALID_HANDLE_VALUE))
+#endif
+		{
+		}
+
+		WritableMappedFile& operator=(WritableMappedFile&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Unmap();
+				m_data = std::exchange(other.m_data, nullptr);
+				m_size = std::exchange(other.m_size, 0);
+#ifdef _WIN32
+				m_file = std::exchange(other.m_file, INVALID_HANDLE_VALUE);
+#endif
+			}
+			return *this;
+		}
+
+		WritableMappedFile(const WritableMappedFile&) = delete;
+		WritableMappedFile& operator=(const WritableMappedFile&) = delete;
+
+		~WritableMappedFile()
+		{
+			Unmap();
+		}
+
+		// With a size, the file is created if missing and resized to it; bytes it gains are
+		// zero. Without, the file must exist and not be empty. std::nullopt on failure.
+		static std::optional<WritableMappedFile> Open(const std::filesystem::path& path, size_t size = 0)
+		{
+			WritableMappedFile file;
+#ifdef _WIN32
+			HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+				size != 0 ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (handle == INVALID_HANDLE_VALUE)
+				return std::nullopt;
+
+			LARGE_INTEGER current{};
+			bool sized = GetFileSizeEx(handle, &current) != 0;
+			if (sized && size != 0 && static_cast<unsigned long long>(current.QuadPart) != size)
+			{
+				// Windows leaves the bytes an extension adds undefined, so they are written
+				LARGE_INTEGER end{};
+				end.QuadPart = static_cast<LONGLONG>(size);
+				sized = SetFilePointerEx(handle, end, nullptr, FILE_BEGIN) && SetEndOfFile(handle);
+				if (sized && size > static_cast<unsigned long long>(current.QuadPart))
+				{
+					std::vector<char> zeros(64 * 1024);
+					LARGE_INTEGER position{};
+					position.QuadPart = current.QuadPart;
+					sized = SetFilePointerEx(handle, position, nullptr, FILE_BEGIN) != 0;
+					for (size_t left = size - static_cast<size_t>(current.QuadPart); sized && left > 0;)
+					{
+						DWORD written = 0;
+						DWORD chunk = static_cast<DWORD>((std::min)(left, zeros.size()));
+						sized = WriteFile(handle, zeros.data(), chunk, &written, nullptr) && written == chunk;
+						left -= written;
+					}
+				}
+				current.QuadPart = static_cast<LONGLONG>(size);
+			}
+			if (sized && current.QuadPart > 0 && static_cast<unsigned long long>(current.QuadPart) <= SIZE_MAX)
+			{
+				HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+				if (mapping)
+				{
+					file.m_data = static_cast<std::byte*>(MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0));
+					file.m_size = file.m_data ? static_cast<size_t>(current.QuadPart) : 0;
+					CloseHandle(mapping);
+				}
+			}
+			// Kept open for FlushFileBuffers
+			file.m_file = handle;
+#else
+			int fd = open(path.c_str(), O_RDWR | O_CLOEXEC | (size != 0 ? O_CREAT : 0), 0644);
+			if (fd < 0)
+				return std::nullopt;
+
+			struct stat status{};
+			bool sized = fstat(fd, &status) == 0;
+			if (sized && size != 0 && static_cast<size_t>(status.st_size) != size)
+			{
+				sized = ftruncate(fd, static_cast<off_t>(size)) == 0;
+				status.st_size = static_cast<off_t>(size);
+			}
+			if (sized && status.st_size > 0)
+			{
+				void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+				if (data != MAP_FAILED)
+				{
+					file.m_data = static_cast<std::byte*>(data);
+					file.m_size = static_cast<size_t>(status.st_size);
+				}
+			}
+			close(fd);
+#endif
+			if (!file.m_data)
+				return std::nullopt;
+			return file;
+		}
+
+		std::byte* Data() const { return m_data; }
+		size_t Size() const { return m_size; }
+
+		bool Flush() const
+		{
+			if (!m_data)
+				return false;
+#ifdef _WIN32
+			return FlushViewOfFile(m_data, 0) && FlushFileBuffers(m_file);
+#else
+			return msync(m_data, m_size, MS_SYNC) == 0;
+#endif
+		}
+
+	private:
+		void Unmap()
+		{
+#ifdef _WIN32
+			if (m_data)
+				UnmapViewOfFile(m_data);
+			if (m_file != INVALID_HANDLE_VALUE)
+				CloseHandle(m_file);
+			m_file = INVALID_HANDLE_VALUE;
+#else
+			if (m_data)
+				munmap(m_data, m_size);
+#endif
+			m_data = nullptr;
+			m_size = 0;
+		}
+
+		std::byte* m_data = nullptr;
+		size_t m_size = 0;
+#ifdef _WIN32
+		HANDLE m_file = INVALID_HANDLE_VALUE;
+#endif
+	};
+}
@@ -0,0 +1,229 @@
+#pragma once
+#include "pch.h"
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace HardwareAnalyzer
+{
+	// What the pool needs from an OCR implementation. The WinUI app plugs in
+	// Windows.Media.Ocr; anything else (a stand-in engine on Linux, a test double) works too.
+	template <typename Engine>
+	class IOcrEngineBackend
+	{
+	public:
+		virtual ~IOcrEngineBackend() = default;
+
+		// Language tags to try for the default engine, most preferred first
+		virtual std::vector<std::wstring> CandidateLanguages() = 0;
+
+		// A new engine for the language tag, or std::nullopt when the language isn't available
+		virtual std::optional<Engine> CreateEngine(const std::wstring& language) = 0;
+	};
+
+	// Long-lived OCR engines keyed by language. Creating an engine (and working out which
+	// language to create it for) is done once, then engines are checked out exclusively and
+	// handed back when the lease ends, so concurrent jobs never share an instance.
+	// Checkout never waits for a lease to end: when every engine of a language is leased, a new
+	// one is created, and at most MaxIdlePerLanguage of them are kept once they come back.
+	// It does block while it creates that engine, and a default-language Checkout before the
+	// language is resolved blocks until it is, waiting for a WarmUp already resolving it.
+	// Callers on a UI thread check out from a background thread.
+	template <typename Engine>
+	class OcrEnginePool
+	{
+	public:
+		struct Statistics
+		{
+			size_t Created = 0;
+			size_t Reused = 0;
+			size_t Discarded = 0;   // Returned while the language already had enough idle engines
+		};
+
+		class Lease
+		{
+		public:
+			Lease() = default;
+			Lease(Lease&& other) noexcept
+				: m_pool(std::exchange(other.m_pool, nullptr)), m_engine(std::move(other.m_engine)), m_language(std::move(other.m_language))
+			{
+				other.m_engine.reset();
+			}
+
+			Lease& operator=(Lease&& other) noexcept
+			{
+				if (this != &other)
+				{
+					Release();
+					m_pool = std::exchange(other.m_pool, nullptr);
+					m_engine = std::move(other.m_engine);
+					m_language = std::move(other.m_language);
+					other.m_engine.reset();
+				}
+				return *this;
+			}
+
+			Lease(const Lease&) = delete;
+			Lease& operator=(const Lease&) = delete;
+
+			~Lease()
+			{
+				Release();
+			}
+
+			explicit operator bool() const { return m_engine.has_value(); }
+			Engine& operator*() { return *m_engine; }
+			Engine* operator->() { return &*m_engine; }
+			const std::wstring& Language() const { return m_language; }
+
+			// Hands the engine back to the pool early
+			void Release()
+			{
+				if (m_pool && m_engine)
+					m_pool->Return(m_language, std::move(*m_engine));
+				m_pool = nullptr;
+				m_engine.reset();
+			}
+
+		private:
+			friend class OcrEnginePool;
+			Lease(OcrEnginePool* pool, Engine engine, std::wstring language)
+				: m_pool(pool), m_engine(std::move(engine)), m_language(std::move(language)) {}
+
+			OcrEnginePool* m_pool = nullptr;
+			std::optional<Engine> m_engine;
+			std::wstring m_language;
+		};
+
+		explicit OcrEnginePool(std::unique_ptr<IOcrEngineBackend<Engine>> backend, size_t maxIdlePerLanguage = 2)
+			: m_backend(std::move(backend)), m_maxIdlePerLanguage(maxIdlePerLanguage)
+		{
+		}
+
+		OcrEnginePool(const OcrEnginePool&) = delete;
+		OcrEnginePool& operator=(const OcrEnginePool&) = delete;
+
+		// Resolves the default language and leaves 'count' idle engines for it.
+		// Meant to run once in the background at startup; safe to call again.
+		void WarmUp(size_t count = 1)
+		{
+			std::wstring language;
+			if (!DefaultLanguage(language))
+				return;
+			WarmUp(language, count);
+		}
+
+		void WarmUp(const std::wstring& language, size_t count)
+		{
+			std::vector<Lease> leases;
+			for (size_t i = 0; i < count; i++)
+			{
+				Lease lease = Checkout(language);
+				if (!lease)
+					break;
+				leases.push_back(std::move(lease));
+			}
+			// Leases return here, leaving the engines idle
+		}
+
+		// Engine for the default language (the user's language if OCR supports it, else the
+		// first recognizer language that works); empty lease when OCR isn't available at all
+		Lease Checkout()
+		{
+			std::wstring language;
+			if (!DefaultLanguage(language))
+				return {};
+			return Checkout(language);
+		}
+
+		Lease Checkout(const std::wstring& language)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_lock);
+				auto& idle = m_idle[language];
+				if (!idle.empty())
+				{
+					Engine engine = std::move(idle.back());
+					idle.pop_back();
+					m_statistics.Reused++;
+					return Lease{ this, std::move(engine), language };
+				}
+			}
+
+			// Engine creation can be slow; don't hold the lock while the backend works
+			std::optional<Engine> engine = m_backend->CreateEngine(language);
+			if (!engine)
+				return {};
+
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_statistics.Created++;
+			return Lease{ this, std::move(*engine), language };
+		}
+
+		Statistics GetStatistics()
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			return m_statistics;
+		}
+
+	private:
+		// Resolved once, by WarmUp or the first Checkout; after that the language is read
+		// without taking either lock, as it never changes again
+		bool DefaultLanguage(std::wstring& language)
+		{
+			if (!m_defaultResolved.load(std::memory_order_acquire))
+				ResolveDefaultLanguage();
+			language = m_defaultLanguage;
+			return !language.empty();
+		}
+
+		void ResolveDefaultLanguage()
+		{
+			std::lock_guard<std::mutex> resolveLock(m_resolveLock);
+			if (m_defaultResolved.load(std::memory_order_relaxed))
+				return;
+
+			// First candidate that yields an engine wins; that engine becomes the first idle one
+			for (const auto& candidate : m_backend->CandidateLanguages())
+			{
+				std::optional<Engine> engine = m_backend->CreateEngine(candidate);
+				if (engine)
+				{
+					m_defaultLanguage = candidate;
+					std::lock_guard<std::mutex> lock(m_lock);
+					m_statistics.Created++;
+					m_idle[candidate].push_back(std::move(*engine));
+					break;
+				}
+			}
+			m_defaultResolved.store(true, std::memory_order_release);
+		}
+
+		void Return(const std::wstring& language, Engine engine)
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+			auto& idle = m_idle[language];
+			if (idle.size() < m_maxIdlePerLanguage)
+				idle.push_back(std::move(engine));
+			else
+				m_statistics.Discarded++;
+		}
+
+		std::unique_ptr<IOcrEngineBackend<Engine>> m_backend;
+		size_t m_maxIdlePerLanguage;
+
+		std::mutex m_resolveLock;   // Serializes default-language resolution only
+		std::atomic<bool> m_defaultResolved{ false };
+		std::wstring m_defaultLanguage;     // Written once, before m_defaultResolved is set
+
+		std::mutex m_lock;          // Guards everything below
+		std::map<std::wstring, std::vector<Engine>> m_idle;
+		Statistics m_statistics;
+	};
+}
@@ -0,0 +1,394 @@
+#pragma once
+#include "pch.h"
+#include "LabelCatalog.h"
+#include "OcrTextScanner.h"
+#include <array>
+#include <cwchar>
+#include <string>
+#include <string_view>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define HARDWARE_ANALYZER_NORMALIZER_SSE2 1
+#endif
+
+namespace HardwareAnalyzer
+{
+	// Fixes the character confusions Windows.Media.Ocr commonly makes, in one pass and in place
+	// (the text never grows, so the write position can't overtake the read position):
+	//   - 'l', 'I', '|' -> '1', 'O', 'o' -> '0' right after a digit ("1O GB", "2O2O", "14.l")
+	//   - 'S' -> '5' between two digits ("1S6")
+	//     Both only inside a number: a word of digits and confusables, alone or with a unit
+	//     ("1OGB"), so identifiers such as "LAPTOP-PD2S4YS9" or "i7-47OOK" are left as they are
+	//   - "Ml" / "MI" -> "M1" as a whole word or after "Apple" ("13-inch, Ml, 2020", "Apple MI Pro")
+	//   - "rn" -> "m" when that turns the word into a word of the catalog's labels ("Mernory",
+	//     "Sonorna") or one the parsers match in code ("Ryzen ... AMD", "M1 Max")
+	//   - curly quotes, primes and Unicode dashes -> ASCII, NBSP and other spaces -> ' ',
+	//     zero-width characters removed, CR and CRLF -> LF
+	//   - a Latin letter followed by a combining accent -> the precomposed Latin-1 letter
+	// Runs of ASCII characters that none of the rules start on are skipped in blocks.
+	class OcrNormalizer
+	{
+	public:
+		template <typename String>
+		static void Normalize(String& text, const LabelCatalog& catalog)
+		{
+			wchar_t* data = text.data();
+			const size_t size = text.size();
+			size_t read = 0;
+			size_t write = 0;
+
+			while (read < size)
+			{
+				size_t run = PlainRunLength(data + read, size - read);
+				if (run > 0)
+				{
+					if (write != read)
+						std::wmemmove(data + write, data + read, run);
+					read += run;
+					write += run;
+					continue;
+				}
+				read = NormalizeAt(data, size, read, write, catalog);
+			}
+			text.resize(write);
+		}
+
+	private:
+		// Longest word that "rn" -> "m" is checked against; the catalog's longest is 12 letters
+		static constexpr size_t MaxVocabularyWord = 16;
+
+		// Longest number the digit fixes look for on either side of a confusable; a longer run
+		// isn't a quantity, and the cap keeps the look-around from making the pass quadratic
+		static constexpr size_t MaxNumberChars = 32;
+
+		// ASCII characters a rule can start on
+		static bool IsTrigger(wchar_t c)
+		{
+			switch (c)
+			{
+			case L'\r': case L'I': case L'M': case L'O': case L'S':
+			case L'l': case L'm': case L'o': case L'r': case L'|':
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		static bool IsPlain(wchar_t c)
+		{
+			return c < 0x80 && !IsTrigger(c);
+		}
+
+		static size_t PlainRunLength(const wchar_t* text, size_t length)
+		{
+			size_t i = 0;
+#ifdef HARDWARE_ANALYZER_NORMALIZER_SSE2
+			// 16 characters per step, narrowed to bytes once they are known to be ASCII
+			__m128i bytes;
+			while (i + 16 <= length && LoadAscii16(text + i, bytes))
+			{
+				__m128i triggers = _mm_setzero_si128();
+				for (char trigger : { '\r', 'I', 'M', 'O', 'S', 'l', 'm', 'o', 'r', '|' })
+					triggers = _mm_or_si128(triggers, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(trigger)));
+				if (_mm_movemask_epi8(triggers) != 0)
+					break;
+				i += 16;
+			}
+#endif
+			while (i < length && IsPlain(text[i]))
+				i++;
+			return i;
+		}
+
+#ifdef HARDWARE_ANALYZER_NORMALIZER_SSE2
+		// Packs 16 characters into 16 bytes; false when any of them is not ASCII
+		static bool LoadAscii16(const wchar_t* text, __m128i& bytes)
+		{
+			const __m128i* blocks = reinterpret_cast<const __m128i*>(text);
+			if constexpr (sizeof(wchar_t) == 2)
+			{
+				__m128i low = _mm_loadu_si128(blocks);
+				__m128i high = _mm_loadu_si128(blocks + 1);
+				__m128i highBits = _mm_and_si128(_mm_or_si128(low, high), _mm_set1_epi16(static_cast<short>(0xFF80)));
+				if (_mm_movemask_epi8(_mm_cmpeq_epi16(highBits, _mm_setzero_si128())) != 0xFFFF)
+					return false;
+				bytes = _mm_packus_epi16(low, high);
+			}
+			else
+			{
+				__m128i a = _mm_loadu_si128(blocks);
+				__m128i b = _mm_loadu_si128(blocks + 1);
+				__m128i c = _mm_loadu_si128(blocks + 2);
+				__m128i d = _mm_loadu_si128(blocks + 3);
+				__m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+				__m128i highBits = _mm_and_si128(any, _mm_set1_epi32(static_cast<int>(0xFFFFFF80)));
+				if (_mm_movemask_epi8(_mm_cmpeq_epi32(highBits, _mm_setzero_si128())) != 0xFFFF)
+					return false;
+				bytes = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+			}
+			return true;
+		}
+#endif
+
+		// Handles the character at 'read' (which is not plain ASCII) and returns the next read position
+		static size_t NormalizeAt(wchar_t* data, size_t size, size_t read, size_t& write, const LabelCatalog& catalog)
+		{
+			wchar_t c = data[read];
+			wchar_t next = read + 1 < size ? data[read + 1] : L'\0';
+
+			switch (c)
+			{
+			case L'\r':
+				data[write++] = L'\n';
+				return next == L'\n' ? read + 2 : read + 1;
+
+			case L'l': case L'I': case L'|': case L'O': case L'o': case L'S':
+			{
+				wchar_t fixed = FixDigitConfusion(data, size, read, write, c, next);
+				data[write++] = fixed;
+				return read + 1;
+			}
+
+			case L'M': case L'm':
+				if ((next == L'l' || next == L'L' || next == L'i' || next == L'I') && IsChipName(data, size, read, write))
+				{
+					data[write++] = L'M';
+					data[write++] = L'1';
+					return read + 2;
+				}
+				data[write++] = c;
+				return read + 1;
+
+			case L'r':
+				if (next == L'n')
+					return FixRnInWord(data, size, read, write, catalog);
+				data[write++] = c;
+				return read + 1;
+			}
+
+			if (c >= 0x0300 && c <= 0x036F && write > 0)
+			{
+				wchar_t composed = Compose(data[write - 1], c);
+				if (composed != 0)
+				{
+					data[write - 1] = composed;
+					return read + 1;
+				}
+			}
+
+			switch (c)
+			{
+			case 0x200B: case 0x200C: case 0x200D: case 0x2060: case 0xFEFF:
+				return read + 1;   // Zero-width characters
+			}
+			data[write++] = Replacement(c);
+			return read + 1;
+		}
+
+		static wchar_t FixDigitConfusion(const wchar_t* data, size_t size, size_t read, size_t write, wchar_t c, wchar_t next)
+		{
+			wchar_t digit = (c == L'O' || c == L'o') ? L'0' : (c == L'S' ? L'5' : L'1');
+
+			bool afterDigit = write > 0 && OcrTextScanner::IsDigit(data[write - 1]);
+			bool afterDecimal = write > 1 && (data[write - 1] == L'.' || data[write - 1] == L',') &&
+				OcrTextScanner::IsDigit(data[write - 2]);
+
+			if (c == L'S')
+				return afterDigit && OcrTextScanner::IsDigit(next) && IsInNumber(data, size, read, write) ? digit : c;
+
+			// "1O GB", "1OGB" and "2O2O" but not "4790K" style suffixes
+			if ((afterDigit || afterDecimal) && IsInNumber(data, size, read, write))
+				return digit;
+			return c;
+		}
+
+		static bool IsConfusable(wchar_t c)
+		{
+			return c == L'l' || c == L'I' || c == L'|' || c == L'O' || c == L'o' || c == L'S';
+		}
+
+		// Whether the confusable at 'read' sits in a word that is a number: the digits written
+		// before it start the word, and what follows up to the end of the word is digits,
+		// confusables and separators, then at most a unit ("1O GB", "1OGB", "2O2O", "1S6")
+		static bool IsInNumber(const wchar_t* data, size_t size, size_t read, size_t write)
+		{
+			size_t start = write;
+			while (start > 0 && write - start < MaxNumberChars &&
+				(OcrTextScanner::IsDigit(data[start - 1]) || data[start - 1] == L'.' || data[start - 1] == L','))
+			{
+				start--;
+			}
+			if (start > 0 && (OcrTextScanner::IsWordChar(data[start - 1]) || IsLetter(data[start - 1])))
+				return false;
+
+			size_t end = read + 1;
+			while (end < size && end - read < MaxNumberChars &&
+				(OcrTextScanner::IsDigit(data[end]) || IsConfusable(data[end]) || data[end] == L'.' || data[end] == L','))
+			{
+				end++;
+			}
+			size_t unitEnd = end;
+			while (unitEnd < size && unitEnd - end <= 3 && IsLetter(data[unitEnd]))
+				unitEnd++;
+			if (unitEnd < size && (OcrTextScanner::IsWordChar(data[unitEnd]) || IsLetter(data[unitEnd])))
+				return false;
+			return end == unitEnd || IsUnit(std::wstring_view(data + end, unitEnd - end));
+		}
+
+		// Units a number can be run together with
+		static bool IsUnit(std::wstring_view word)
+		{
+			for (std::wstring_view unit : { L"gb", L"go", L"gib", L"mb", L"mo", L"mib", L"tb", L"to", L"tib", L"ghz", L"mhz" })
+			{
+				if (OcrTextScanner::MatchAt(word, 0, unit) == word.size() && word.size() == unit.size())
+					return true;
+			}
+			return false;
+		}
+
+		// "M" + l/I at 'read' is a chip name when it stands alone or directly follows "Apple"
+		static bool IsChipName(const wchar_t* data, size_t size, size_t read, size_t write)
+		{
+			// Output written so far ends with "apple" plus optional whitespace
+			size_t end = write;
+			while (end > 0 && OcrTextScanner::IsSpace(data[end - 1]))
+				end--;
+			if (end >= 5 && OcrTextScanner::MatchAt(std::wstring_view(data + end - 5, 5), 0, L"apple") == 5)
+				return true;
+
+			bool startsWord = write == 0 || !OcrTextScanner::IsWordChar(data[write - 1]);
+			bool endsWord = read + 2 >= size || !OcrTextScanner::IsWordChar(data[read + 2]);
+			return startsWord && endsWord;
+		}
+
+		// Rewrites the word around an "rn" at 'read' when replacing every "rn" gives a vocabulary word;
+		// otherwise copies the rest of the word unchanged, so each word is checked only once
+		static size_t FixRnInWord(wchar_t* data, size_t size, size_t read, size_t& write, const LabelCatalog& catalog)
+		{
+			size_t wordStart = write;
+			while (wordStart > 0 && IsLetter(data[wordStart - 1]))
+				wordStart--;
+			size_t wordEnd = read;
+			while (wordEnd < size && IsLetter(data[wordEnd]))
+				wordEnd++;
+
+			std::array<wchar_t, MaxVocabularyWord> candidate{};
+			size_t candidateLength = 0;
+			bool fits = true;
+			auto append = [&](wchar_t c) {
+				if (candidateLength < candidate.size())
+					candidate[candidateLength++] = OcrTextScanner::Fold(c);
+				else
+					fits = false;
+			};
+
+			for (size_t i = wordStart; i < write && fits; i++)
+				append(data[i]);
+			for (size_t i = read; i < wordEnd && fits; i++)
+			{
+				if (data[i] == L'r' && i + 1 < wordEnd && data[i + 1] == L'n')
+				{
+					append(L'm');
+					i++;
+				}
+				else
+				{
+					append(data[i]);
+				}
+			}
+
+			bool known = fits && IsVocabularyWord(std::wstring_view(candidate.data(), candidateLength), catalog);
+			for (size_t i = read; i < wordEnd; i++)
+			{
+				if (known && data[i] == L'r' && i + 1 < wordEnd && data[i + 1] == L'n')
+				{
+					data[write++] = L'm';
+					i++;
+				}
+				else
+				{
+					data[write++] = data[i];
+				}
+			}
+			return wordEnd;
+		}
+
+		// Label words come from the catalog, so a label pack's new languages get the fix too.
+		// The values HardwareInfo.h and MacOSHardwareInfo.h match in code aren't in any label.
+		static bool IsVocabularyWord(std::wstring_view word, const LabelCatalog& catalog)
+		{
+			if (catalog.IsVocabularyWord(word))
+				return true;
+			for (std::wstring_view known : { L"amd", L"arm", L"max", L"mehrere", L"multiple" })
+			{
+				if (word == known)
+					return true;
+			}
+			return false;
+		}
+
+		static bool IsAsciiLetter(wchar_t c)
+		{
+			return (c >= L'a' && c <= L'z') || (c >= L'A' && c <= L'Z');
+		}
+
+		static bool IsLetter(wchar_t c)
+		{
+			return IsAsciiLetter(c) || (c >= 0xC0 && c <= 0xFF && c != 0xD7 && c != 0xF7);
+		}
+
+		// Single-character replacements for punctuation and spacing
+		static wchar_t Replacement(wchar_t c)
+		{
+			switch (c)
+			{
+			case 0x00A0: case 0x1680: case 0x2000: case 0x2001: case 0x2002: case 0x2003: case 0x2004:
+			case 0x2005: case 0x2006: case 0x2007: case 0x2008: case 0x2009: case 0x200A: case 0x202F:
+			case 0x205F: case 0x3000:
+				return L' ';
+			case 0x2018: case 0x2019: case 0x201A: case 0x201B: case 0x2032: case 0x00B4:
+				return L'\'';
+			case 0x201C: case 0x201D: case 0x201E: case 0x201F: case 0x2033: case 0x00AB: case 0x00BB:
+				return L'"';
+			case 0x2010: case 0x2011: case 0x2012: case 0x2013: case 0x2014: case 0x2015: case 0x2212:
+				return L'-';
+			default:
+				return c;
+			}
+		}
+
+		// Precomposed Latin-1 letter for base + combining mark, 0 if there is none
+		static wchar_t Compose(wchar_t base, wchar_t mark)
+		{
+			struct Composition
+			{
+				wchar_t Mark;
+				const wchar_t* Bases;
+				const wchar_t* Composed;
+			};
+			static constexpr Composition compositions[] = {
+				{ 0x0300, L"AEIOUaeiou",   L"\u00C0\u00C8\u00CC\u00D2\u00D9\u00E0\u00E8\u00EC\u00F2\u00F9" },
+				{ 0x0301, L"AEIOUYaeiouy", L"\u00C1\u00C9\u00CD\u00D3\u00DA\u00DD\u00E1\u00E9\u00ED\u00F3\u00FA\u00FD" },
+				{ 0x0302, L"AEIOUaeiou",   L"\u00C2\u00CA\u00CE\u00D4\u00DB\u00E2\u00EA\u00EE\u00F4\u00FB" },
+				{ 0x0303, L"ANOano",       L"\u00C3\u00D1\u00D5\u00E3\u00F1\u00F5" },
+				{ 0x0308, L"AEIOUaeiouy",  L"\u00C4\u00CB\u00CF\u00D6\u00DC\u00E4\u00EB\u00EF\u00F6\u00FC\u00FF" },
+				{ 0x030A, L"Aa",           L"\u00C5\u00E5" },
+				{ 0x0327, L"Cc",           L"\u00C7\u00E7" },
+			};
+
+			for (const auto& composition : compositions)
+			{
+				if (composition.Mark != mark)
+					continue;
+				for (size_t i = 0; composition.Bases[i] != 0; i++)
+				{
+					if (composition.Bases[i] == base)
+						return composition.Composed[i];
+				}
+				return 0;
+			}
+			return 0;
+		}
+	};
+}
@@ -1,42 +1,88 @@
 #include "pch.h"
 #include "OcrService.h"
+#include "OcrEnginePool.h"
+#include "Tracing.h"
 
 using namespace winrt;
 using namespace winrt::Windows::Foundation;
 using namespace winrt::Windows::Media::Ocr;
 using namespace winrt::Windows::Graphics::Imaging;
 using namespace winrt::Windows::Storage::Streams;
+using ::HardwareAnalyzer::TraceSpan;
 
 namespace winrt::HardwareAnalyzer
 {
-	Windows::Foundation::IAsyncOperation<winrt::hstring> OcrService::PerformOcrAsync(Windows::Storage::StorageFile file)
+	namespace
 	{
-		// Open file and decode image
-		auto stream{ co_await file.OpenAsync(Windows::Storage::FileAccessMode::Read) };
-		auto decoder{ co_await BitmapDecoder::CreateAsync(stream) };
-		auto softwareBitmap{ co_await decoder.GetSoftwareBitmapAsync() };
+		// Windows.Media.Ocr behind the engine pool
+		class WinRtOcrBackend : public ::HardwareAnalyzer::IOcrEngineBackend<OcrEngine>
+		{
+		public:
+			std::vector<std::wstring> CandidateLanguages() override
+			{
+				std::vector<std::wstring> languages;
 
-		// Get OCR engine - try user's language first, fallback to English
-		OcrEngine ocrEngine{ nullptr };
+				// Try to create engine with user's preferred language
+				auto userLanguages = Windows::Globalization::ApplicationLanguages::Languages();
+				if (userLanguages.Size() > 0)
+				{
+					Windows::Globalization::Language userLanguage(userLanguages.GetAt(0));
+					if (OcrEngine::IsLanguageSupported(userLanguage))
+						languages.emplace_back(userLanguage.LanguageTag());
+				}
 
-		// Try to create engine with user's preferred language
-		auto userLanguage = Windows::Globalization::Language(Windows::Globalization::ApplicationLanguages::Languages().GetAt(0));
-		if (OcrEngine::IsLanguageSupported(userLanguage))
-		{
-			ocrEngine = OcrEngine::TryCreateFromLanguage(userLanguage);
-		}
+				// Fallback to available languages
+				for (auto const& lang : OcrEngine::AvailableRecognizerLanguages())
+				{
+					languages.emplace_back(lang.LanguageTag());
+				}
+				return languages;
+			}
 
-		// Fallback to available languages
-		if (!ocrEngine)
-		{
-			auto availableLanguages = OcrEngine::AvailableRecognizerLanguages();
-			for (auto const& lang : availableLanguages)
+			std::optional<OcrEngine> CreateEngine(const std::wstring& language) override
 			{
-				ocrEngine = OcrEngine::TryCreateFromLanguage(lang);
-				if (ocrEngine)
-					break;
+				OcrEngine engine = OcrEngine::TryCreateFromLanguage(Windows::Globalization::Language(language));
+				if (!engine)
+					return std::nullopt;
+				return engine;
 			}
+		};
+
+		::HardwareAnalyzer::OcrEnginePool<OcrEngine>& EnginePool()
+		{
+			static ::HardwareAnalyzer::OcrEnginePool<OcrEngine> pool{ std::make_unique<WinRtOcrBackend>() };
+			return pool;
 		}
+	}
+
+	fire_and_forget OcrService::WarmUpAsync()
+	{
+		// Engine creation touches the language settings and loads recognizer data; keep it off the UI thread
+		co_await winrt::resume_background();
+
+		TraceSpan span{ "OcrEnginePool::WarmUp", "ocr" };
+		EnginePool().WarmUp();
+	}
+
+	Windows::Foundation::IAsyncOperation<winrt::hstring> OcrService::PerformOcrAsync(Windows::Storage::StorageFile file)
+	{
+		// Open file and decode image
+		auto stream{ co_await file.OpenAsync(Windows::Storage::FileAccessMode::Read) };
+
+		TraceSpan decodeSpan{ "BitmapDecoder::CreateAsync", "ocr" };
+		auto decoder{ co_await BitmapDecoder::CreateAsync(stream) };
+		decodeSpan.End();
+
+		TraceSpan bitmapSpan{ "GetSoftwareBitmapAsync", "ocr" };
+		auto softwareBitmap{ co_await decoder.GetSoftwareBitmapAsync() };
+		bitmapSpan.End();
+
+		// Get OCR engine - warm instance from the pool (user's language first, fallback to any recognizer language).
+		// A cold pool creates the engine, or waits for WarmUpAsync to, so keep that off the UI thread
+		co_await winrt::resume_background();
+		TraceSpan engineSpan{ "OcrEnginePool::Checkout", "ocr" };
+		auto ocrEngine = EnginePool().Checkout();
+		engineSpan.End();
 
 		if (!ocrEngine)
 		{
@@ -44,7 +90,9 @@ namespace winrt::HardwareAnalyzer
 		}
 
 		// Perform OCR
-		auto ocrResult{ co_await ocrEngine.RecognizeAsync(softwareBitmap) };
+		TraceSpan recognizeSpan{ "OcrEngine::RecognizeAsync", "ocr" };
+		auto ocrResult{ co_await ocrEngine->RecognizeAsync(softwareBitmap) };
+		recognizeSpan.End();
 
 		co_return ocrResult.Text();
 	}
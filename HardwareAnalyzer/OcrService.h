@@ -10,5 +10,8 @@ namespace winrt::HardwareAnalyzer
 	{
 	public:
 		static Windows::Foundation::IAsyncOperation<winrt::hstring> PerformOcrAsync(Windows::Storage::StorageFile file);
+
+		// Creates the default-language OCR engine in the background so the first analysis doesn't wait for it
+		static fire_and_forget WarmUpAsync();
 	};
 }
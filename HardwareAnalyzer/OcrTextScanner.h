@@ -0,0 +1,373 @@
+#pragma once
+#include "pch.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <initializer_list>
+#include <iterator>
+#include <vector>
+
+namespace HardwareAnalyzer
+{
+	// Caps applied to the OCR text before any extraction runs.
+	// A real "About" page is a few hundred characters; anything past these limits
+	// (e.g. a screenshot of a log file) is dropped instead of being scanned.
+	struct ParseLimits
+	{
+		size_t MaxInputChars = 64 * 1024;   // Text beyond this is ignored
+		size_t MaxLineChars = 512;          // Longer lines are truncated
+	};
+
+	// Non-owning list of folded labels: a braced list at the call site, or a vector that
+	// outlives the call (e.g. one language's labels in a LabelCatalog). Braced lists live
+	// until the end of the full expression, which is all a scanner call needs.
+	class LabelList
+	{
+	public:
+		constexpr LabelList() = default;
+		constexpr LabelList(std::initializer_list<std::wstring_view> labels) : m_begin(std::data(labels)), m_size(labels.size()) {}
+
+		LabelList(const std::vector<std::wstring_view>& labels) : m_begin(labels.data()), m_size(labels.size()) {}
+
+		constexpr const std::wstring_view* begin() const { return m_begin; }
+		constexpr const std::wstring_view* end() const { return m_begin + m_size; }
+		constexpr size_t size() const { return m_size; }
+		constexpr bool empty() const { return m_size == 0; }
+
+	private:
+		const std::wstring_view* m_begin = nullptr;
+		size_t m_size = 0;
+	};
+
+	// Matching primitives used by the platform parsers instead of std::regex.
+	// Every helper is a forward scan without backtracking, so the cost of a parse
+	// is linear in the size of the (capped) text whatever the input looks like.
+	//
+	// Labels and keywords are written folded (lowercase, no accents) and match
+	// case- and accent-insensitively. In a label, a space matches any run of
+	// whitespace (including none) and '#' matches a single digit.
+	class OcrTextScanner
+	{
+	public:
+		static constexpr size_t npos = std::wstring_view::npos;
+
+		struct QuantityMatch
+		{
+			size_t Begin = 0;        // Start of the number
+			size_t NumberEnd = 0;
+			size_t UnitBegin = 0;
+			size_t End = 0;          // End of the unit
+
+			std::wstring_view Number(std::wstring_view text) const { return text.substr(Begin, NumberEnd - Begin); }
+			std::wstring_view Unit(std::wstring_view text) const { return text.substr(UnitBegin, End - UnitBegin); }
+			std::wstring_view Text(std::wstring_view text) const { return text.substr(Begin, End - Begin); }
+
+			// "<number> <unit>" into 'value', the normalized form the parsers report
+			template <typename String>
+			void AssignNumberAndUnit(std::wstring_view text, String& value) const
+			{
+				value.assign(Number(text));
+				value += L' ';
+				value.append(Unit(text));
+			}
+		};
+
+		// Copy of the text with the limits applied and blank lines removed
+		static std::wstring ApplyLimits(const std::wstring& text, const ParseLimits& limits)
+		{
+			std::wstring result;
+			ApplyLimits(text, limits, result);
+			return result;
+		}
+
+		// Into 'result', which keeps its allocator
+		template <typename String>
+		static void ApplyLimits(std::wstring_view text, const ParseLimits& limits, String& result)
+		{
+			result.clear();
+			size_t inputLength = (std::min)(text.size(), limits.MaxInputChars);
+			result.reserve(inputLength);
+
+			size_t lineStart = 0;
+			while (lineStart < inputLength)
+			{
+				size_t lineEnd = text.find(L'\n', lineStart);
+				if (lineEnd == std::wstring_view::npos || lineEnd > inputLength)
+					lineEnd = inputLength;
+
+				size_t keep = (std::min)(lineEnd - lineStart, limits.MaxLineChars);
+				bool blank = true;
+				for (size_t i = lineStart; i < lineStart + keep && blank; i++)
+				{
+					blank = IsSpace(text[i]);
+				}
+
+				if (!blank)
+				{
+					if (!result.empty())
+						result += L'\n';
+					result.append(text.substr(lineStart, keep));
+				}
+				lineStart = lineEnd + 1;
+			}
+		}
+
+		static bool IsSpace(wchar_t c)
+		{
+			return c == L' ' || c == L'\t' || c == L'\n' || c == L'\r' || c == L'\v' || c == L'\f';
+		}
+
+		static bool IsDigit(wchar_t c)
+		{
+			return c >= L'0' && c <= L'9';
+		}
+
+		static bool IsWordChar(wchar_t c)
+		{
+			return IsDigit(c) || (c >= L'a' && c <= L'z') || (c >= L'A' && c <= L'Z') || c == L'_';
+		}
+
+		// Lowercase and strip Latin accents ('É' -> 'e', 'ä' -> 'a', 'ł' -> 'l', 'ș' -> 's');
+		// Greek and Cyrillic are lowercased, Greek also loses its tonos
+		static wchar_t Fold(wchar_t c)
+		{
+			if (c < 0x80)
+				return (c >= L'A' && c <= L'Z') ? static_cast<wchar_t>(c + (L'a' - L'A')) : c;
+
+			if (c >= 0xC0 && c <= 0x17F)
+			{
+				// U+00C0..U+017F, '.' where the character has no plain base letter
+				static constexpr char latinBase[] =
+					"aaaaaaaceeeeiiii" "dnooooo.ouuuuyts"
+					"aaaaaaaceeeeiiii" "dnooooo.ouuuuyty"
+					"aaaaaaccccccccdd" "ddeeeeeeeeeegggg"
+					"gggghhhhiiiiiiii" "ii..jjkkklllllll"
+					"lllnnnnnnnnnoooo" "oo..rrrrrrssssss"
+					"ssttttttuuuuuuuu" "uuuuwwyyyzzzzzzs";
+				char base = latinBase[c - 0xC0];
+				if (base != '.')
+					return static_cast<wchar_t>(base);
+				return c;
+			}
+
+			// Romanian comma-below letters (U+0218..U+021B)
+			if (c >= 0x218 && c <= 0x21B)
+				return c < 0x21A ? L's' : L't';
+
+			// Cyrillic capitals: U+0400..U+040F -> U+0450.., U+0410..U+042F -> U+0430..
+			if (c >= 0x400 && c <= 0x42F)
+				return static_cast<wchar_t>(c < 0x410 ? c + 0x50 : c + 0x20);
+
+			if (c >= 0x386 && c <= 0x3CE)
+			{
+				if (c >= 0x391 && c <= 0x3A9)
+					return static_cast<wchar_t>(c + 0x20);
+
+				// Accented and final forms to the plain lowercase letter
+				static constexpr wchar_t greekBase[][2] = {
+					{ 0x386, 0x3B1 }, { 0x388, 0x3B5 }, { 0x389, 0x3B7 }, { 0x38A, 0x3B9 }, { 0x38C, 0x3BF },
+					{ 0x38E, 0x3C5 }, { 0x38F, 0x3C9 }, { 0x390, 0x3B9 }, { 0x3AA, 0x3B9 }, { 0x3AB, 0x3C5 },
+					{ 0x3AC, 0x3B1 }, { 0x3AD, 0x3B5 }, { 0x3AE, 0x3B7 }, { 0x3AF, 0x3B9 }, { 0x3B0, 0x3C5 },
+					{ 0x3C2, 0x3C3 }, { 0x3CA, 0x3B9 }, { 0x3CB, 0x3C5 }, { 0x3CC, 0x3BF }, { 0x3CD, 0x3C5 },
+					{ 0x3CE, 0x3C9 },
+				};
+				for (const auto& mapping : greekBase)
+				{
+					if (mapping[0] == c)
+						return mapping[1];
+				}
+			}
+			return c;
+		}
+
+		static size_t LineEnd(std::wstring_view text, size_t pos)
+		{
+			size_t end = text.find(L'\n', pos);
+			return end == npos ? text.size() : end;
+		}
+
+		static size_t SkipWhitespace(std::wstring_view text, size_t pos)
+		{
+			while (pos < text.size() && IsSpace(text[pos]))
+				pos++;
+			return pos;
+		}
+
+		// Skips "\s*[:\-]?\s*" between a label and its value
+		static size_t SkipSeparator(std::wstring_view text, size_t pos)
+		{
+			pos = SkipWhitespace(text, pos);
+			if (pos < text.size() && (text[pos] == L':' || text[pos] == L'-'))
+				pos++;
+			return SkipWhitespace(text, pos);
+		}
+
+		static size_t SkipDigits(std::wstring_view text, size_t pos)
+		{
+			while (pos < text.size() && IsDigit(text[pos]))
+				pos++;
+			return pos;
+		}
+
+		// Number of characters matched by a folded label at pos, 0 if it doesn't match
+		static size_t MatchAt(std::wstring_view text, size_t pos, std::wstring_view label)
+		{
+			size_t i = pos;
+			for (wchar_t expected : label)
+			{
+				if (expected == L' ')
+				{
+					i = SkipWhitespace(text, i);
+					continue;
+				}
+				if (i >= text.size())
+					return 0;
+				if (expected == L'#' ? !IsDigit(text[i]) : Fold(text[i]) != expected)
+					return 0;
+				i++;
+			}
+			return i - pos;
+		}
+
+		// First label of the list matching at pos; returns its length (0 if none)
+		static size_t MatchAnyAt(std::wstring_view text, size_t pos, LabelList labels)
+		{
+			for (const auto& label : labels)
+			{
+				size_t length = MatchAt(text, pos, label);
+				if (length > 0)
+					return length;
+			}
+			return 0;
+		}
+
+		// Leftmost occurrence of any label, starting the search at 'from'
+		static size_t FindAny(std::wstring_view text, LabelList labels, size_t from, size_t& length)
+		{
+			for (size_t pos = from; pos < text.size(); pos++)
+			{
+				length = MatchAnyAt(text, pos, labels);
+				if (length > 0)
+					return pos;
+			}
+			length = 0;
+			return npos;
+		}
+
+		// Rightmost keyword occurrence inside [begin, limit) that also ends before limit.
+		// Returns its start and sets keywordEnd, or npos.
+		static size_t FindLastAny(std::wstring_view text, size_t begin, size_t limit,
+			LabelList keywords, size_t& keywordEnd)
+		{
+			std::wstring_view bounded = text.substr(0, limit);
+			for (size_t pos = limit; pos-- > begin;)
+			{
+				for (const auto& keyword : keywords)
+				{
+					size_t length = MatchAt(bounded, pos, keyword);
+					if (length > 0)
+					{
+						keywordEnd = pos + length;
+						return pos;
+					}
+				}
+			}
+			return npos;
+		}
+
+		// Equivalent of "(?:labels)\s*[:\-]?\s*(.+?)(?:\n|$)": the rest of the line after
+		// the leftmost label, or the next non-empty line when the label ends its line.
+		template <typename String>
+		static bool FindLabeledLine(std::wstring_view text, LabelList labels, String& value)
+		{
+			for (size_t pos = 0; pos < text.size(); pos++)
+			{
+				for (const auto& label : labels)
+				{
+					size_t length = MatchAt(text, pos, label);
+					if (length == 0)
+						continue;
+
+					size_t valueStart = SkipSeparator(text, pos + length);
+					if (valueStart >= text.size())
+						continue;
+
+					value.assign(text.substr(valueStart, LineEnd(text, valueStart) - valueStart));
+					TrimRight(value);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		// Number and unit at pos: "\d+[\.,]?\d*\s*(units)", or "\d+\s*(units)" without fraction
+		static bool MatchQuantityAt(std::wstring_view text, size_t pos, bool allowFraction,
+			LabelList units, QuantityMatch& match)
+		{
+			size_t i = SkipDigits(text, pos);
+			if (i == pos)
+				return false;
+
+			if (allowFraction && i < text.size() && (text[i] == L'.' || text[i] == L','))
+				i = SkipDigits(text, i + 1);
+			size_t numberEnd = i;
+
+			i = SkipWhitespace(text, i);
+			size_t unitLength = MatchAnyAt(text, i, units);
+			if (unitLength == 0)
+				return false;
+
+			match.Begin = pos;
+			match.NumberEnd = numberEnd;
+			match.UnitBegin = i;
+			match.End = i + unitLength;
+			return true;
+		}
+
+		// Leftmost quantity at or after 'from'
+		static bool FindQuantity(std::wstring_view text, size_t from, bool allowFraction,
+			LabelList units, QuantityMatch& match)
+		{
+			size_t pos = from;
+			while (pos < text.size())
+			{
+				if (!IsDigit(text[pos]))
+				{
+					pos++;
+					continue;
+				}
+				if (MatchQuantityAt(text, pos, allowFraction, units, match))
+					return true;
+
+				// Any later start inside this digit run sees the same suffix and fails too
+				pos = SkipDigits(text, pos);
+			}
+			return false;
+		}
+
+		// Equivalent of "(?:labels)\s*[:\-]?\s*<quantity>" at the leftmost possible label
+		static bool FindLabeledQuantity(std::wstring_view text, LabelList labels,
+			bool allowFraction, LabelList units, QuantityMatch& match)
+		{
+			for (size_t pos = 0; pos < text.size(); pos++)
+			{
+				for (const auto& label : labels)
+				{
+					size_t length = MatchAt(text, pos, label);
+					if (length > 0 &&
+						MatchQuantityAt(text, SkipSeparator(text, pos + length), allowFraction, units, match))
+					{
+						return true;
+					}
+				}
+			}
+			return false;
+		}
+
+		template <typename String>
+		static void TrimRight(String& value)
+		{
+			value.erase(value.find_last_not_of(L" \t\r\n") + 1);
+		}
+	};
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include "pch.h"
+#include "OcrTextScanner.h"
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+
+namespace HardwareAnalyzer
+{
+	// Parses memory sizes as OCR reads them ("16 GB", "15,8 Go", "1 To", "512 Mo", "8 GiB",
+	// "7.8 GB usable") into a byte count. Units are binary whatever their spelling, like the
+	// sizes Windows and macOS display: 1 GB = 1 GiB = 1024 MB.
+	// Nothing here throws or reads the C locale: digits are narrowed to ASCII and handed to
+	// std::from_chars, and both '.' and ',' are accepted as the decimal separator.
+	class QuantityParser
+	{
+	public:
+		static constexpr uint64_t BytesPerGB = uint64_t{ 1 } << 30;
+
+		// "<number> <unit>" at the start of text; anything after the unit is ignored
+		static bool Parse(std::wstring_view text, uint64_t& bytes)
+		{
+			size_t numberEnd = OcrTextScanner::SkipDigits(text, 0);
+			if (numberEnd == 0)
+				return false;
+			if (numberEnd < text.size() && (text[numberEnd] == L'.' || text[numberEnd] == L','))
+				numberEnd = OcrTextScanner::SkipDigits(text, numberEnd + 1);
+
+			size_t unitStart = OcrTextScanner::SkipWhitespace(text, numberEnd);
+			size_t unitEnd = unitStart;
+			while (unitEnd < text.size() && IsUnitChar(text[unitEnd]))
+				unitEnd++;
+
+			return Parse(text.substr(0, numberEnd), text.substr(unitStart, unitEnd - unitStart), bytes);
+		}
+
+		// Number and unit already split apart (e.g. by OcrTextScanner::QuantityMatch)
+		static bool Parse(std::wstring_view number, std::wstring_view unit, uint64_t& bytes)
+		{
+			double value = 0;
+			uint64_t unitBytes = 0;
+			if (!ParseNumber(number, value) || !ParseUnit(unit, unitBytes))
+				return false;
+
+			double scaled = value * static_cast<double>(unitBytes);
+			if (!(scaled >= 0 && scaled < 18446744073709551615.0))
+				return false;
+			bytes = static_cast<uint64_t>(scaled + 0.5);
+			return true;
+		}
+
+		// Quantity found by OcrTextScanner::FindQuantity / FindLabeledQuantity in text
+		static bool Parse(std::wstring_view text, const OcrTextScanner::QuantityMatch& match, uint64_t& bytes)
+		{
+			return Parse(text.substr(match.Begin, match.NumberEnd - match.Begin),
+				text.substr(match.UnitBegin, match.End - match.UnitBegin), bytes);
+		}
+
+		// Latin letters and digits, and the Cyrillic letters of "ГБ"
+		static bool IsUnitChar(wchar_t c)
+		{
+			return OcrTextScanner::IsWordChar(c) || (c >= 0x0400 && c <= 0x04FF);
+		}
+
+		static double ToGB(uint64_t bytes)
+		{
+			return static_cast<double>(bytes) / static_cast<double>(BytesPerGB);
+		}
+
+		// Digits with at most one '.' or ',' separator, as a double
+		static bool ParseNumber(std::wstring_view number, double& value)
+		{
+			char buffer[32];
+			if (number.empty() || number.size() > sizeof(buffer))
+				return false;
+
+			for (size_t i = 0; i < number.size(); i++)
+			{
+				wchar_t c = number[i];
+				if (c == L',')
+					c = L'.';
+				if (!OcrTextScanner::IsDigit(c) && c != L'.')
+					return false;
+				buffer[i] = static_cast<char>(c);
+			}
+
+			auto result = std::from_chars(buffer, buffer + number.size(), value, std::chars_format::fixed);
+			return result.ec == std::errc() && result.ptr == buffer + number.size();
+		}
+
+		// Unsigned decimal integer ("2020", "15"); fails on empty input, other characters or overflow
+		static bool ParseInteger(std::wstring_view digits, int& value)
+		{
+			char buffer[16];
+			if (digits.empty() || digits.size() > sizeof(buffer))
+				return false;
+
+			for (size_t i = 0; i < digits.size(); i++)
+			{
+				if (!OcrTextScanner::IsDigit(digits[i]))
+					return false;
+				buffer[i] = static_cast<char>(digits[i]);
+			}
+
+			auto result = std::from_chars(buffer, buffer + digits.size(), value);
+			return result.ec == std::errc() && result.ptr == buffer + digits.size();
+		}
+
+		// Bytes per unit for the English, French, Finnish, Cyrillic and IEC spellings, case-insensitive
+		static bool ParseUnit(std::wstring_view unit, uint64_t& unitBytes)
+		{
+			struct UnitName
+			{
+				std::wstring_view Name;
+				int Shift;
+			};
+			static constexpr UnitName units[] = {
+				{ L"b", 0 }, { L"o", 0 },
+				{ L"kb", 10 }, { L"ko", 10 }, { L"kib", 10 },
+				{ L"mb", 20 }, { L"mo", 20 }, { L"mib", 20 },
+				{ L"gb", 30 }, { L"go", 30 }, { L"gib", 30 },
+				{ L"tb", 40 }, { L"to", 40 }, { L"tib", 40 },
+				{ L"gt", 30 }, { L"tt", 40 },   // Finnish gigatavu, teratavu
+				// Cyrillic kB, MB, GB, TB
+				{ L"\u043A\u0431", 10 }, { L"\u043C\u0431", 20 }, { L"\u0433\u0431", 30 }, { L"\u0442\u0431", 40 },
+			};
+
+			for (const auto& candidate : units)
+			{
+				if (candidate.Name.size() == unit.size() && OcrTextScanner::MatchAt(unit, 0, candidate.Name) == unit.size())
+				{
+					unitBytes = uint64_t{ 1 } << candidate.Shift;
+					return true;
+				}
+			}
+			return false;
+		}
+	};
+}
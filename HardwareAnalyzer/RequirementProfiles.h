@@ -0,0 +1,513 @@
+#pragma once
+#include "pch.h"
+#include "AnalysisPipeline.h"
+#include "HardwareThresholds.h"
+#include "ResultCodes.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define HARDWARE_ANALYZER_PROFILES_SSE2 1
+#endif
+
+namespace HardwareAnalyzer
+{
+	// Minimum specs of one product. The defaults are the thresholds the analyzers apply
+	// (HardwareThresholds).
+	struct RequirementProfile
+	{
+		std::wstring Name;
+
+		// Windows: RAM and VRAM below Bad...GB are Bad, below Warning...GB a Warning
+		float RamBadGB = static_cast<float>(HardwareThresholds::RamBadGB);
+		float RamWarningGB = static_cast<float>(HardwareThresholds::RamWarningGB);
+		float VramBadGB = static_cast<float>(HardwareThresholds::VramBadGB);
+		float VramWarningGB = static_cast<float>(HardwareThresholds::VramWarningGB);
+		bool AllowArm64 = false;          // The product has an ARM64 build
+
+		// macOS
+		float MacMemoryBadGB = static_cast<float>(HardwareThresholds::MacMemoryBadGB);
+		float MacMemoryWarningGB = static_cast<float>(HardwareThresholds::MacMemoryWarningGB);
+		int MinMacOSMajor = HardwareThresholds::MinMacOSMajor;
+		bool AllowIntelMac = false;
+	};
+
+	// What evaluating one machine against profiles needs, taken once from its analysis: the
+	// checks no profile changes are folded into a penalty, and the rest is numbers and flags.
+	struct RequirementInputs
+	{
+		static constexpr size_t KindCount = static_cast<size_t>(CheckKind::Count);
+		static constexpr uint8_t NotApplicable = 0xFF;      // As in FleetResultStore
+
+		TargetPlatform Platform = TargetPlatform::Windows;
+		std::array<uint8_t, KindCount> Status{};    // Of the analysis; NotApplicable for the other platform
+		uint8_t Counted = 0;              // Bit per CheckKind whose value was found ("?" doesn't count)
+		uint8_t FixedPenalty = 0;         // 15 per Warning and 30 per Bad of the fixed checks
+		bool FixedUnsupported = false;    // A fixed check rules the machine out (x86)
+		bool Arm64 = false;               // Windows on ARM: Bad unless the profile allows it
+		bool IntelMac = false;            // Bad unless the profile allows it
+		float MemoryGB = 0;               // RAM, or a Mac's memory; 0 = not found
+		float VramGB = 0;
+		int MacOSMajor = 0;
+
+		template <typename String>
+		static RequirementInputs From(const BasicWindowsAnalysis<String>& analysis)
+		{
+			std::array<uint8_t, KindCount> reasons{};
+			RequirementInputs inputs = FromResults(TargetPlatform::Windows, analysis.Results, reasons);
+			inputs.MemoryGB = static_cast<float>(analysis.Info.RamGB);
+			inputs.VramGB = static_cast<float>(analysis.Info.VramGB);
+			inputs.Arm64 = reasons[static_cast<size_t>(CheckKind::Architecture)] == ResultCodes::ReasonOf(L"Reason_ARM64");
+			inputs.Fold({ CheckKind::Processor, CheckKind::GraphicsCard }, CheckKind::Architecture, !inputs.Arm64);
+			return inputs;
+		}
+
+		template <typename String>
+		static RequirementInputs From(const BasicMacOSAnalysis<String>& analysis)
+		{
+			std::array<uint8_t, KindCount> reasons{};
+			RequirementInputs inputs = FromResults(TargetPlatform::macOS, analysis.Results, reasons);
+			inputs.MemoryGB = static_cast<float>(analysis.Info.MemoryGB);
+			inputs.MacOSMajor = analysis.Info.MacOSMajorVersion;
+			inputs.IntelMac = reasons[static_cast<size_t>(CheckKind::Chip)] == ResultCodes::ReasonOf(L"Reason_IntelMacNotSupported");
+			inputs.Fold({}, CheckKind::Chip, !inputs.IntelMac);
+			return inputs;
+		}
+
+		bool IsCounted(CheckKind kind) const { return (Counted >> static_cast<int>(kind)) & 1; }
+
+	private:
+		template <typename Results>
+		static RequirementInputs FromResults(TargetPlatform platform, const Results& results, std::array<uint8_t, KindCount>& reasons)
+		{
+			RequirementInputs inputs;
+			inputs.Platform = platform;
+			inputs.Status.fill(NotApplicable);
+			for (const auto& result : results)
+			{
+				size_t kind = static_cast<size_t>(ResultCodes::KindOf(result.Name));
+				if (kind == KindCount)
+					continue;
+				inputs.Status[kind] = static_cast<uint8_t>(result.Status);
+				reasons[kind] = ResultCodes::ReasonOf(result.ReasonKey);
+				if (result.Value != L"?")
+					inputs.Counted |= static_cast<uint8_t>(1u << kind);
+			}
+			return inputs;
+		}
+
+		// The fixed checks' penalty, with 'gate' (Architecture or Chip) among them when no
+		// profile can change it; a fixed Bad gate rules the machine out as in CalculateGlobalScore
+		void Fold(std::initializer_list<CheckKind> fixed, CheckKind gate, bool gateFixed)
+		{
+			auto penalty = [&](CheckKind kind) {
+				if (!IsCounted(kind))
+					return 0;
+				uint8_t status = Status[static_cast<size_t>(kind)];
+				return status == static_cast<uint8_t>(StatusLevel::Bad) ? 30 : status == static_cast<uint8_t>(StatusLevel::Warning) ? 15 : 0;
+			};
+			int total = 0;
+			for (CheckKind kind : fixed)
+			{
+				total += penalty(kind);
+			}
+			if (gateFixed)
+			{
+				total += penalty(gate);
+				FixedUnsupported = penalty(gate) == 30;
+			}
+			FixedPenalty = static_cast<uint8_t>((std::min)(total, 100));
+		}
+	};
+
+	// Per-profile results of one machine: the score and the status of every check of its
+	// platform (NotApplicable for the other's), each indexed by profile
+	struct ProfileEvaluation
+	{
+		std::vector<int8_t> Scores;
+		std::array<std::vector<uint8_t>, RequirementInputs::KindCount> Status;
+	};
+
+	// Requirement profiles as a struct of arrays: one column per threshold, padded to a
+	// multiple of four so that a machine is evaluated against four profiles per SSE2 step.
+	// The fixed checks (CPU and GPU families, Apple Silicon) come from the analysis once per
+	// machine; only the threshold checks vary per profile, as compares and masks.
+	class RequirementProfileTable
+	{
+	public:
+		static constexpr size_t Lanes = 4;
+
+		size_t Add(const RequirementProfile& profile)
+		{
+			size_t index = m_names.size();
+			if (index % Lanes == 0)
+			{
+				// Padding lanes hold the defaults and are never read back
+				RequirementProfile defaults;
+				for (size_t lane = 0; lane < Lanes; lane++)
+				{
+					Set(defaults, true);
+				}
+			}
+			m_names.push_back(profile.Name);
+			Set(profile, false, index);
+			return index;
+		}
+
+		size_t Size() const { return m_names.size(); }
+		const std::wstring& Name(size_t profile) const { return m_names[profile]; }
+
+		// One profile per line, "<name> <setting>...", '#' starting a comment:
+		//   studio-pro  ram=16/32 vram=4/8 mac-memory=16/24 macos=15
+		//   viewer      ram=4/8 vram=0/1 arm64 intel-mac macos=13
+		// ram, vram and mac-memory are "<Bad below>/<Warning below>" in GB; settings left out
+		// keep the defaults. On a malformed line nothing is added and error names the line.
+		bool Parse(std::string_view text, std::string& error)
+		{
+			std::vector<RequirementProfile> profiles;
+			size_t lineNumber = 0;
+			for (size_t start = 0; start < text.size();)
+			{
+				size_t end = text.find('\n', start);
+				if (end == std::string_view::npos)
+					end = text.size();
+				std::string_view line = text.substr(start, end - start);
+				start = end + 1;
+				lineNumber++;
+				line = line.substr(0, line.find('#'));
+
+				RequirementProfile profile;
+				bool named = false;
+				for (std::string_view word : Words(line))
+				{
+					if (!named)
+					{
+						profile.Name = Utf8::Decode(word);
+						named = true;
+					}
+					else if (!Setting(word, profile))
+					{
+						error = "line " + std::to_string(lineNumber) + ": bad setting \"" + std::string(word) + "\"";
+						return false;
+					}
+				}
+				if (named)
+					profiles.push_back(std::move(profile));
+			}
+			for (const RequirementProfile& profile : profiles)
+			{
+				Add(profile);
+			}
+			return true;
+		}
+
+		// Every profile against one machine; 'evaluation' is reused, so its buffers are
+		// allocated once across a fleet
+		void Evaluate(const RequirementInputs& inputs, ProfileEvaluation& evaluation) const
+		{
+			size_t padded = m_ramBad.size();
+			evaluation.Scores.resize(padded);
+			std::array<uint8_t*, RequirementInputs::KindCount> status{};
+			for (size_t kind = 0; kind < RequirementInputs::KindCount; kind++)
+			{
+				std::vector<uint8_t>& column = evaluation.Status[kind];
+				column.resize(padded);
+				status[kind] = column.data();
+				// The fixed checks have the same status under every profile
+				std::memset(column.data(), inputs.Status[kind], padded);
+			}
+			Evaluate(inputs, evaluation.Scores.data(), &status);
+
+			evaluation.Scores.resize(Size());
+			for (std::vector<uint8_t>& column : evaluation.Status)
+			{
+				column.resize(Size());
+			}
+		}
+
+		template <typename Analysis>
+		ProfileEvaluation Evaluate(const Analysis& analysis) const
+		{
+			ProfileEvaluation evaluation;
+			Evaluate(RequirementInputs::From(analysis), evaluation);
+			return evaluation;
+		}
+
+		// Scores of every machine under every profile, row-major: scores[machine * Size() + profile]
+		std::vector<int8_t> Scores(std::span<const RequirementInputs> machines) const
+		{
+			std::vector<int8_t> scores(machines.size() * Size() + Lanes);
+			for (size_t machine = 0; machine < machines.size(); machine++)
+			{
+				// Rows overlap by the padding lanes, each overwritten by the next row
+				Evaluate(machines[machine], scores.data() + machine * Size(), nullptr);
+			}
+			scores.resize(machines.size() * Size());
+			return scores;
+		}
+
+		// Per profile, how many machines score at least minimumScore: which products the
+		// fleet can run, without keeping the whole matrix
+		std::vector<uint64_t> CountAtLeast(std::span<const RequirementInputs> machines, int minimumScore) const
+		{
+			size_t padded = m_ramBad.size();
+			std::vector<int8_t> scores(padded);
+			std::vector<uint64_t> counts(padded);
+			int8_t minimum = static_cast<int8_t>(std::clamp(minimumScore, -1, 101) - 1);
+			for (const RequirementInputs& machine : machines)
+			{
+				Evaluate(machine, scores.data(), nullptr);
+				for (size_t profile = 0; profile < padded; profile++)
+				{
+					counts[profile] += scores[profile] > minimum;
+				}
+			}
+			counts.resize(Size());
+			return counts;
+		}
+
+	private:
+		std::vector<std::wstring> m_names;
+		std::vector<float> m_ramBad;
+		std::vector<float> m_ramWarning;
+		std::vector<float> m_vramBad;
+		std::vector<float> m_vramWarning;
+		std::vector<float> m_macMemoryBad;
+		std::vector<float> m_macMemoryWarning;
+		std::vector<int32_t> m_minMacOSMajor;
+		std::vector<int32_t> m_allowArm64;       // -1 (all bits) or 0, ready as a lane mask
+		std::vector<int32_t> m_allowIntelMac;
+
+		void Set(const RequirementProfile& profile, bool append, size_t index = 0)
+		{
+			// A Warning threshold under the Bad one would make Bad values Warnings; the lane
+			// arithmetic counts on Bad <= Warning
+			auto set = [&](auto& column, auto value) {
+				if (append)
+					column.push_back(value);
+				else
+					column[index] = value;
+			};
+			set(m_ramBad, profile.RamBadGB);
+			set(m_ramWarning, (std::max)(profile.RamWarningGB, profile.RamBadGB));
+			set(m_vramBad, profile.VramBadGB);
+			set(m_vramWarning, (std::max)(profile.VramWarningGB, profile.VramBadGB));
+			set(m_macMemoryBad, profile.MacMemoryBadGB);
+			set(m_macMemoryWarning, (std::max)(profile.MacMemoryWarningGB, profile.MacMemoryBadGB));
+			set(m_minMacOSMajor, static_cast<int32_t>(profile.MinMacOSMajor));
+			set(m_allowArm64, profile.AllowArm64 ? int32_t{ -1 } : int32_t{ 0 });
+			set(m_allowIntelMac, profile.AllowIntelMac ? int32_t{ -1 } : int32_t{ 0 });
+		}
+
+		// Scores into scores[0, padded) and, when status is given, the statuses of the checks
+		// that vary per profile into their columns
+		void Evaluate(const RequirementInputs& inputs, int8_t* scores, std::array<uint8_t*, RequirementInputs::KindCount>* status) const
+		{
+			size_t padded = m_ramBad.size();
+			if (inputs.Counted == 0)
+			{
+				// Nothing was extracted: -1 under every profile, as CalculateGlobalScore
+				std::memset(scores, -1, padded);
+				return;
+			}
+
+			bool windows = inputs.Platform == TargetPlatform::Windows;
+			CheckKind memoryKind = windows ? CheckKind::RAM : CheckKind::Memory;
+			CheckKind gateKind = windows ? CheckKind::Architecture : CheckKind::Chip;
+			const float* memoryBad = windows ? m_ramBad.data() : m_macMemoryBad.data();
+			const float* memoryWarning = windows ? m_ramWarning.data() : m_macMemoryWarning.data();
+			const int32_t* allowGate = windows ? m_allowArm64.data() : m_allowIntelMac.data();
+			bool gateVaries = windows ? inputs.Arm64 : inputs.IntelMac;
+			uint8_t* memoryOut = status ? (*status)[static_cast<size_t>(memoryKind)] : nullptr;
+			uint8_t* vramOut = status && windows ? (*status)[static_cast<size_t>(CheckKind::VideoMemory)] : nullptr;
+			uint8_t* macOSOut = status && !windows ? (*status)[static_cast<size_t>(CheckKind::MacOSVersion)] : nullptr;
+			uint8_t* gateOut = status && gateVaries ? (*status)[static_cast<size_t>(gateKind)] : nullptr;
+
+#if HARDWARE_ANALYZER_PROFILES_SSE2
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i bad = _mm_set1_epi32(static_cast<int>(StatusLevel::Bad));
+			const __m128i base = _mm_set1_epi32(100 - inputs.FixedPenalty);
+			const __m128i fixedUnsupported = _mm_set1_epi32(inputs.FixedUnsupported ? -1 : 0);
+			const __m128 memory = _mm_set1_ps(inputs.MemoryGB);
+			const __m128 vram = _mm_set1_ps(inputs.VramGB);
+			const __m128i macOS = _mm_set1_epi32(inputs.MacOSMajor);
+			const __m128i memoryCounted = _mm_set1_epi32(inputs.IsCounted(memoryKind) ? -1 : 0);
+			const __m128i vramCounted = _mm_set1_epi32(windows && inputs.IsCounted(CheckKind::VideoMemory) ? -1 : 0);
+			const __m128i macOSCounted = _mm_set1_epi32(!windows && inputs.IsCounted(CheckKind::MacOSVersion) ? -1 : 0);
+			const __m128i gateCounted = _mm_set1_epi32(gateVaries && inputs.IsCounted(gateKind) ? -1 : 0);
+
+			for (size_t i = 0; i < padded; i += Lanes)
+			{
+				__m128i memoryStatus = Threshold(memory, memoryBad + i, memoryWarning + i);
+				__m128i penalty = _mm_and_si128(Penalty(memoryStatus), memoryCounted);
+				__m128i unsupported = fixedUnsupported;
+				if (windows)
+				{
+					__m128i vramStatus = Threshold(vram, m_vramBad.data() + i, m_vramWarning.data() + i);
+					penalty = _mm_add_epi32(penalty, _mm_and_si128(Penalty(vramStatus), vramCounted));
+					Store(vramOut, i, vramStatus);
+				}
+				else
+				{
+					// Not found is a Warning, below the minimum Bad and ruling the Mac out
+					__m128i minimum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_minMacOSMajor.data() + i));
+					__m128i tooOld = _mm_and_si128(_mm_cmpgt_epi32(minimum, macOS), bad);
+					__m128i macOSStatus = _mm_cmpgt_epi32(macOS, zero);
+					macOSStatus = _mm_or_si128(_mm_and_si128(macOSStatus, tooOld), _mm_andnot_si128(macOSStatus, _mm_set1_epi32(1)));
+					penalty = _mm_add_epi32(penalty, _mm_and_si128(Penalty(macOSStatus), macOSCounted));
+					unsupported = _mm_or_si128(unsupported, _mm_and_si128(_mm_cmpeq_epi32(macOSStatus, bad), macOSCounted));
+					Store(macOSOut, i, macOSStatus);
+				}
+				if (gateVaries)
+				{
+					// ARM64 or an Intel Mac: Good where the profile allows it, Bad otherwise
+					__m128i gateStatus = _mm_andnot_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(allowGate + i)), bad);
+					penalty = _mm_add_epi32(penalty, _mm_and_si128(Penalty(gateStatus), gateCounted));
+					unsupported = _mm_or_si128(unsupported, _mm_and_si128(_mm_cmpeq_epi32(gateStatus, bad), gateCounted));
+					Store(gateOut, i, gateStatus);
+				}
+				Store(memoryOut, i, memoryStatus);
+
+				__m128i score = _mm_andnot_si128(unsupported, _mm_sub_epi32(base, penalty));
+				score = _mm_and_si128(score, _mm_cmpgt_epi32(score, zero));
+				Store(reinterpret_cast<uint8_t*>(scores), i, score);
+			}
+#else
+			for (size_t i = 0; i < padded; i++)
+			{
+				int memoryStatus = !(inputs.MemoryGB > 0) ? 1 : inputs.MemoryGB < memoryBad[i] ? 2 : inputs.MemoryGB < memoryWarning[i] ? 1 : 0;
+				int penalty = inputs.IsCounted(memoryKind) ? memoryStatus * 15 : 0;
+				bool unsupported = inputs.FixedUnsupported;
+				if (windows)
+				{
+					int vramStatus = !(inputs.VramGB > 0) ? 1 : inputs.VramGB < m_vramBad[i] ? 2 : inputs.VramGB < m_vramWarning[i] ? 1 : 0;
+					penalty += inputs.IsCounted(CheckKind::VideoMemory) ? vramStatus * 15 : 0;
+					if (vramOut)
+						vramOut[i] = static_cast<uint8_t>(vramStatus);
+				}
+				else
+				{
+					int macOSStatus = inputs.MacOSMajor <= 0 ? 1 : inputs.MacOSMajor < m_minMacOSMajor[i] ? 2 : 0;
+					bool counted = inputs.IsCounted(CheckKind::MacOSVersion);
+					penalty += counted ? macOSStatus * 15 : 0;
+					unsupported |= counted && macOSStatus == 2;
+					if (macOSOut)
+						macOSOut[i] = static_cast<uint8_t>(macOSStatus);
+				}
+				if (gateVaries)
+				{
+					int gateStatus = allowGate[i] ? 0 : 2;
+					bool counted = inputs.IsCounted(gateKind);
+					penalty += counted ? gateStatus * 15 : 0;
+					unsupported |= counted && gateStatus == 2;
+					if (gateOut)
+						gateOut[i] = static_cast<uint8_t>(gateStatus);
+				}
+				if (memoryOut)
+					memoryOut[i] = static_cast<uint8_t>(memoryStatus);
+				scores[i] = static_cast<int8_t>(unsupported ? 0 : (std::max)(0, 100 - inputs.FixedPenalty - penalty));
+			}
+#endif
+		}
+
+#if HARDWARE_ANALYZER_PROFILES_SSE2
+		// 0 Good, 1 Warning, 2 Bad, with "not found" (value <= 0, NaN) a Warning
+		static __m128i Threshold(__m128 value, const float* bad, const float* warning)
+		{
+			__m128i below = _mm_castps_si128(_mm_cmplt_ps(value, _mm_loadu_ps(bad)));
+			__m128i belowWarning = _mm_castps_si128(_mm_cmplt_ps(value, _mm_loadu_ps(warning)));
+			__m128i status = _mm_sub_epi32(_mm_setzero_si128(), _mm_add_epi32(below, belowWarning));
+			__m128i found = _mm_castps_si128(_mm_cmpgt_ps(value, _mm_setzero_ps()));
+			return _mm_or_si128(_mm_and_si128(found, status), _mm_andnot_si128(found, _mm_set1_epi32(1)));
+		}
+
+		// 15 per Warning, 30 per Bad
+		static __m128i Penalty(__m128i status)
+		{
+			return _mm_sub_epi32(_mm_slli_epi32(status, 4), status);
+		}
+
+		// Four lanes of 0..100 (or -1) as bytes at out[i]
+		static void Store(uint8_t* out, size_t i, __m128i lanes)
+		{
+			if (!out)
+				return;
+			__m128i packed = _mm_packs_epi32(lanes, lanes);
+			int32_t bytes = _mm_cvtsi128_si32(_mm_packs_epi16(packed, packed));
+			std::memcpy(out + i, &bytes, sizeof(bytes));
+		}
+#endif
+
+		static std::vector<std::string_view> Words(std::string_view line)
+		{
+			std::vector<std::string_view> words;
+			size_t i = 0;
+			while (i < line.size())
+			{
+				while (i < line.size() && (line[i] == ' ' || line[i] == '\t' || line[i] == '\r'))
+					i++;
+				size_t start = i;
+				while (i < line.size() && line[i] != ' ' && line[i] != '\t' && line[i] != '\r')
+					i++;
+				if (i > start)
+					words.push_back(line.substr(start, i - start));
+			}
+			return words;
+		}
+
+		static bool Setting(std::string_view word, RequirementProfile& profile)
+		{
+			if (word == "arm64")
+			{
+				profile.AllowArm64 = true;
+				return true;
+			}
+			if (word == "intel-mac")
+			{
+				profile.AllowIntelMac = true;
+				return true;
+			}
+
+			size_t equals = word.find('=');
+			if (equals == std::string_view::npos)
+				return false;
+			std::string_view key = word.substr(0, equals);
+			std::string_view value = word.substr(equals + 1);
+			if (key == "macos")
+				return Number(value, profile.MinMacOSMajor);
+			if (key == "ram")
+				return Pair(value, profile.RamBadGB, profile.RamWarningGB);
+			if (key == "vram")
+				return Pair(value, profile.VramBadGB, profile.VramWarningGB);
+			if (key == "mac-memory")
+				return Pair(value, profile.MacMemoryBadGB, profile.MacMemoryWarningGB);
+			return false;
+		}
+
+		// "<bad>/<warning>"
+		static bool Pair(std::string_view value, float& bad, float& warning)
+		{
+			size_t slash = value.find('/');
+			return slash != std::string_view::npos && Number(value.substr(0, slash), bad) && Number(value.substr(slash + 1), warning);
+		}
+
+		template <typename Value>
+		static bool Number(std::string_view text, Value& value)
+		{
+			auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+			return error == std::errc{} && end == text.data() + text.size() && !text.empty();
+		}
+	};
+}
@@ -0,0 +1,176 @@
+#pragma once
+#include "pch.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace HardwareAnalyzer
+{
+	// The checks the analyzers report, by the Name they give them
+	enum class CheckKind : uint8_t
+	{
+		// Windows
+		Processor,
+		GraphicsCard,
+		RAM,
+		VideoMemory,
+		Architecture,
+
+		// macOS
+		Chip,
+		Memory,
+		MacOSVersion,
+
+		Count
+	};
+
+	// Stable numeric ids for check names and reason keys, for results kept or shipped as
+	// numbers (the C ABI, FleetResultStore). Both lists are append-only: the ids are part of
+	// HardwareAnalyzerEngine.h's ABI. Reason 0 is "unknown"; the keys after it are sorted.
+	class ResultCodes
+	{
+	public:
+		static constexpr uint8_t UnknownReason = 0;
+
+		static constexpr const char* ReasonKeys[] = {
+			"",
+			"Reason_AMDRadeon",
+			"Reason_AMDVega",
+			"Reason_ARM64",
+			"Reason_AcceptableRAM",
+			"Reason_AppleSiliconSupported",
+			"Reason_ArchUnknown",
+			"Reason_CPUDetected",
+			"Reason_CPUNotFound",
+			"Reason_ChipNotFound",
+			"Reason_ChipUnknown",
+			"Reason_GPUDetected",
+			"Reason_GPUNotFound",
+			"Reason_GoodRAM",
+			"Reason_GoodVRAM",
+			"Reason_IntelArc",
+			"Reason_IntelIntegrated",
+			"Reason_IntelIris",
+			"Reason_IntelMacNotSupported",
+			"Reason_IntelUHD",
+			"Reason_LowPerfCPU",
+			"Reason_LowRAM",
+			"Reason_LowVRAM",
+			"Reason_MacAcceptableMemory",
+			"Reason_MacGoodMemory",
+			"Reason_MacLowMemory",
+			"Reason_MacOSSupported",
+			"Reason_MacOSTooOld",
+			"Reason_MacOSVersionNotFound",
+			"Reason_MacVeryLowMemory",
+			"Reason_MemoryNotFound",
+			"Reason_ModernIntel",
+			"Reason_ModernRyzen",
+			"Reason_MultipleGPU",
+			"Reason_NVIDIADedicated",
+			"Reason_OlderIntel",
+			"Reason_OlderRyzen",
+			"Reason_QualcommARM",
+			"Reason_QualcommAdreno",
+			"Reason_RAMNotFound",
+			"Reason_SharedMemory",
+			"Reason_VRAMNotFound",
+			"Reason_VeryLowRAM",
+			"Reason_VeryLowVRAM",
+			"Reason_VeryOldCPU",
+			"Reason_x64",
+			"Reason_x86",
+		};
+
+		static constexpr size_t ReasonCount = sizeof(ReasonKeys) / sizeof(ReasonKeys[0]);
+
+		static constexpr const char* CheckNames[] = {
+			"Processor",
+			"Graphics Card",
+			"RAM",
+			"Video Memory",
+			"Architecture",
+			"Chip",
+			"Memory",
+			"macOS Version",
+		};
+
+		// UnknownReason for a key not in the list. A hash table built at compile time: one
+		// hash of the key and usually one comparison, as serializers call this per result.
+		static uint8_t ReasonOf(std::wstring_view key)
+		{
+			for (size_t slot = Hash(key) & (ReasonSlots - 1);; slot = (slot + 1) & (ReasonSlots - 1))
+			{
+				uint8_t reason = ReasonTable[slot];
+				if (reason == UnknownReason || Compare(key, ReasonKeys[reason]) == 0)
+					return reason;
+			}
+		}
+
+		static const char* ReasonKey(uint8_t reason)
+		{
+			return reason < ReasonCount ? ReasonKeys[reason] : "";
+		}
+
+		// CheckKind::Count for a name no analyzer reports
+		static CheckKind KindOf(std::wstring_view name)
+		{
+			for (size_t kind = 0; kind < static_cast<size_t>(CheckKind::Count); kind++)
+			{
+				if (Compare(name, CheckNames[kind]) == 0)
+					return static_cast<CheckKind>(kind);
+			}
+			return CheckKind::Count;
+		}
+
+	private:
+		static constexpr size_t ReasonSlots = 128;      // Power of two, at most half full
+
+		// FNV-1a; the same for a key and its wide copy
+		template <typename Text>
+		static constexpr uint32_t Hash(const Text& text)
+		{
+			uint32_t hash = 2166136261u;
+			for (auto c : text)
+				hash = (hash ^ static_cast<uint32_t>(c)) * 16777619u;
+			return hash;
+		}
+
+		static constexpr std::array<uint8_t, ReasonSlots> BuildReasonTable()
+		{
+			std::array<uint8_t, ReasonSlots> table{};
+			for (size_t reason = 1; reason < ReasonCount; reason++)
+			{
+				size_t slot = Hash(std::string_view(ReasonKeys[reason])) & (ReasonSlots - 1);
+				while (table[slot] != UnknownReason)
+					slot = (slot + 1) & (ReasonSlots - 1);
+				table[slot] = static_cast<uint8_t>(reason);
+			}
+			return table;
+		}
+
+		static const std::array<uint8_t, ReasonSlots> ReasonTable;
+
+		// Wide text against an ASCII key, ordered like strcmp
+		static int Compare(std::wstring_view wide, std::string_view ascii)
+		{
+			size_t common = (std::min)(wide.size(), ascii.size());
+			for (size_t i = 0; i < common; i++)
+			{
+				unsigned long a = static_cast<unsigned long>(wide[i]);
+				unsigned long b = static_cast<unsigned char>(ascii[i]);
+				if (a != b)
+					return a < b ? -1 : 1;
+			}
+			return wide.size() == ascii.size() ? 0 : (wide.size() < ascii.size() ? -1 : 1);
+		}
+	};
+
+	inline constexpr std::array<uint8_t, ResultCodes::ReasonSlots> ResultCodes::ReasonTable = ResultCodes::BuildReasonTable();
+
+	static_assert(ResultCodes::ReasonCount <= 256, "reason ids are stored in a byte");
+	static_assert(ResultCodes::ReasonCount <= 64, "ReasonSlots must stay at least twice the number of reason keys");
+	static_assert(sizeof(ResultCodes::CheckNames) / sizeof(ResultCodes::CheckNames[0]) == static_cast<size_t>(CheckKind::Count));
+}
@@ -0,0 +1,693 @@
+#pragma once
+#include "pch.h"
+#include "AnalysisPipeline.h"
+#include "ResultCodes.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+namespace HardwareAnalyzer
+{
+	// Bytes written by the serializers, kept across records: Clear() empties it but keeps the
+	// capacity, so once it has grown to a batch's size, writing records allocates nothing.
+	// The memory isn't zeroed when it grows, only written.
+	class OutputBuffer
+	{
+	public:
+		// Room for 'bytes' more; write them at the returned pointer, then Commit the end
+		char* Reserve(size_t bytes)
+		{
+			if (m_capacity - m_size < bytes)
+				Grow(m_size + bytes);
+			return m_data.get() + m_size;
+		}
+
+		void Commit(char* end) { m_size = static_cast<size_t>(end - m_data.get()); }
+
+		void Append(std::string_view text)
+		{
+			char* out = Reserve(text.size());
+			std::memcpy(out, text.data(), text.size());
+			m_size += text.size();
+		}
+
+		void Append(char c)
+		{
+			*Reserve(1) = c;
+			m_size++;
+		}
+
+		char* Data() { return m_data.get(); }
+		const char* Data() const { return m_data.get(); }
+		size_t Size() const { return m_size; }
+		std::string_view View() const { return { m_data.get(), m_size }; }
+		void Clear() { m_size = 0; }
+
+	private:
+		void Grow(size_t needed)
+		{
+			size_t capacity = (std::max)({ needed, m_capacity * 2, size_t(4096) });
+			std::unique_ptr<char[]> data = std::make_unique_for_overwrite<char[]>(capacity);
+			if (m_size > 0)
+				std::memcpy(data.get(), m_data.get(), m_size);
+			m_data = std::move(data);
+			m_capacity = capacity;
+		}
+
+		std::unique_ptr<char[]> m_data;
+		size_t m_size = 0;
+		size_t m_capacity = 0;
+	};
+
+	// One member of a record and its name in the output. The member's type picks the
+	// encoding: a string is text, double a real number, int an integer and bool a flag.
+	template <typename Record, typename Member>
+	struct FieldDescriptor
+	{
+		std::string_view Name;
+		Member Record::* Pointer;
+	};
+
+	template <typename Record, typename Member>
+	constexpr FieldDescriptor<Record, Member> Field(std::string_view name, Member Record::* pointer)
+	{
+		return { name, pointer };
+	}
+
+	// The fields of an info type in output order, its platform and the checks its analyzer
+	// reports. The names are AnalysisJson's, so the JSON output is the same.
+	template <typename Info>
+	struct FieldTable;
+
+	template <typename String>
+	struct FieldTable<BasicHardwareInfo<String>>
+	{
+		using Info = BasicHardwareInfo<String>;
+		static constexpr TargetPlatform Platform = TargetPlatform::Windows;
+		static constexpr std::string_view PlatformName = "windows";
+		static constexpr auto Fields = std::make_tuple(
+			Field("deviceName", &Info::DeviceName),
+			Field("processor", &Info::Processor),
+			Field("ram", &Info::RAM),
+			Field("ramGB", &Info::RamGB),
+			Field("gpu", &Info::GPU),
+			Field("vram", &Info::VRAM),
+			Field("vramGB", &Info::VramGB),
+			Field("systemType", &Info::SystemType));
+		static constexpr std::array Checks = { CheckKind::Processor, CheckKind::GraphicsCard, CheckKind::RAM, CheckKind::VideoMemory, CheckKind::Architecture };
+	};
+
+	template <typename String>
+	struct FieldTable<BasicMacOSHardwareInfo<String>>
+	{
+		using Info = BasicMacOSHardwareInfo<String>;
+		static constexpr TargetPlatform Platform = TargetPlatform::macOS;
+		static constexpr std::string_view PlatformName = "macos";
+		static constexpr auto Fields = std::make_tuple(
+			Field("deviceName", &Info::DeviceName),
+			Field("deviceYear", &Info::DeviceYear),
+			Field("chip", &Info::Chip),
+			Field("memory", &Info::Memory),
+			Field("memoryGB", &Info::MemoryGB),
+			Field("macOSVersion", &Info::MacOSVersion),
+			Field("chipGeneration", &Info::ChipGeneration),
+			Field("macOSMajorVersion", &Info::MacOSMajorVersion),
+			Field("isAppleSilicon", &Info::IsAppleSilicon),
+			Field("isIntelMac", &Info::IsIntelMac));
+		static constexpr std::array Checks = { CheckKind::Chip, CheckKind::Memory, CheckKind::MacOSVersion };
+	};
+
+	// Analyses (info, check results, score) as JSON lines, CSV rows or compact binary records,
+	// written straight into an OutputBuffer with no iostreams and no allocation of their own.
+	// Every format walks the FieldTable of the info type, so a field added there shows up in
+	// all three.
+	//
+	//   JSON    AnalysisJson::ToJson's object, byte for byte, and a newline
+	//   CSV     RFC 4180, one row per analysis and one header per platform (CsvHeader):
+	//           score, the info fields, then value, status and reasonKey of each check
+	//   Binary  little-endian, per record:
+	//             u32  size of the rest of the record
+	//             u8   TargetPlatform, i8 score
+	//             the info fields in table order: text as a varint byte count and UTF-8,
+	//             double as f64, int as a zigzag varint, bool as u8
+	//             u8   result count, then per result: u8 CheckKind, u8 StatusLevel,
+	//                  u8 ResultCodes reason id, and the value as text
+	//           Names and reason keys travel as ResultCodes ids; ReadBinary restores them.
+	class ResultSerializer
+	{
+	public:
+		enum class Format : uint8_t
+		{
+			Json,
+			Csv,
+			Binary,
+		};
+
+		template <typename Analysis>
+		static void Write(Format format, OutputBuffer& out, const Analysis& analysis)
+		{
+			switch (format)
+			{
+			case Format::Json:
+				WriteJson(out, analysis);
+				break;
+			case Format::Csv:
+				WriteCsv(out, analysis);
+				break;
+			default:
+				WriteBinary(out, analysis);
+				break;
+			}
+		}
+
+		template <typename Analysis>
+		static void WriteJson(OutputBuffer& out, const Analysis& analysis)
+		{
+			using Table = TableOf<Analysis>;
+			out.Append("{\"platform\":\"");
+			out.Append(Table::PlatformName);
+			out.Append("\",\"score\":");
+			AppendNumber(out, analysis.Score);
+			out.Append(",\"info\":{");
+			ForEachField<Table>([&](const auto& field, bool first) {
+				char* at = out.Reserve(field.Name.size() + 4);
+				if (!first)
+					*at++ = ',';
+				*at++ = '"';
+				std::memcpy(at, field.Name.data(), field.Name.size());
+				at += field.Name.size();
+				*at++ = '"';
+				*at++ = ':';
+				out.Commit(at);
+				AppendJsonValue(out, analysis.Info.*field.Pointer);
+			});
+			out.Append("},\"results\":[");
+			for (size_t i = 0; i < analysis.Results.size(); i++)
+			{
+				const auto& result = analysis.Results[i];
+				out.Append(i > 0 ? ",{\"name\":" : "{\"name\":");
+				AppendJsonValue(out, result.Name);
+				out.Append(",\"value\":");
+				AppendJsonValue(out, result.Value);
+				out.Append(StatusJson(result.Status));
+				AppendJsonValue(out, result.ReasonKey);
+				out.Append('}');
+			}
+			out.Append("]}\n");
+		}
+
+		// The header row for Analysis's platform
+		template <typename Analysis>
+		static void CsvHeader(OutputBuffer& out)
+		{
+			using Table = TableOf<Analysis>;
+			out.Append("score");
+			ForEachField<Table>([&](const auto& field, bool) {
+				out.Append(',');
+				out.Append(field.Name);
+			});
+			for (CheckKind kind : Table::Checks)
+			{
+				std::string_view name = ResultCodes::CheckNames[static_cast<size_t>(kind)];
+				for (std::string_view column : { " value", " status", " reasonKey" })
+				{
+					out.Append(',');
+					out.Append(name);
+					out.Append(column);
+				}
+			}
+			out.Append("\r\n");
+		}
+
+		// Results go to their check's columns whatever their order; a check that isn't
+		// there leaves its columns empty
+		template <typename Analysis>
+		static void WriteCsv(OutputBuffer& out, const Analysis& analysis)
+		{
+			using Table = TableOf<Analysis>;
+			AppendNumber(out, analysis.Score);
+			ForEachField<Table>([&](const auto& field, bool) {
+				out.Append(',');
+				AppendCsvValue(out, analysis.Info.*field.Pointer);
+			});
+
+			std::array<const std::remove_cvref_t<decltype(analysis.Results[0])>*, Table::Checks.size()> columns{};
+			for (size_t i = 0; i < analysis.Results.size(); i++)
+			{
+				CheckKind kind = KindOf<Table>(analysis.Results, i);
+				auto slot = std::find(Table::Checks.begin(), Table::Checks.end(), kind);
+				if (slot != Table::Checks.end())
+					columns[slot - Table::Checks.begin()] = &analysis.Results[i];
+			}
+			for (const auto* result : columns)
+			{
+				if (!result)
+				{
+					out.Append(",,,");
+					continue;
+				}
+				out.Append(',');
+				AppendCsvValue(out, result->Value);
+				out.Append(StatusCsv(result->Status));
+				AppendCsvValue(out, result->ReasonKey);
+			}
+			out.Append("\r\n");
+		}
+
+		template <typename Analysis>
+		static void WriteBinary(OutputBuffer& out, const Analysis& analysis)
+		{
+			using Table = TableOf<Analysis>;
+			size_t start = out.Size();
+			char* at = out.Reserve(6);
+			at[4] = static_cast<char>(Table::Platform);
+			at[5] = static_cast<char>(static_cast<int8_t>(analysis.Score));
+			out.Commit(at + 6);
+
+			ForEachField<Table>([&](const auto& field, bool) {
+				AppendBinaryValue(out, analysis.Info.*field.Pointer);
+			});
+
+			size_t count = (std::min)(analysis.Results.size(), size_t(255));
+			out.Append(static_cast<char>(count));
+			for (size_t i = 0; i < count; i++)
+			{
+				const auto& result = analysis.Results[i];
+				at = out.Reserve(3);
+				at[0] = static_cast<char>(KindOf<Table>(analysis.Results, i));
+				at[1] = static_cast<char>(result.Status);
+				at[2] = static_cast<char>(ResultCodes::ReasonOf(result.ReasonKey));
+				out.Commit(at + 3);
+				AppendBinaryValue(out, result.Value);
+			}
+
+			uint32_t size = static_cast<uint32_t>(out.Size() - start - 4);
+			StoreLittle(out.Data() + start, size, 4);
+		}
+
+		// The next record of a binary stream, or false at its end (or if it's cut short)
+		static bool NextBinaryRecord(std::string_view& stream, std::string_view& record, TargetPlatform& platform)
+		{
+			if (stream.size() < 6)
+				return false;
+			uint32_t size = static_cast<uint32_t>(LoadLittle(stream.data(), 4));
+			if (size < 2 || stream.size() - 4 < size)
+				return false;
+			record = stream.substr(4, size);
+			platform = static_cast<TargetPlatform>(static_cast<uint8_t>(record[0]));
+			stream.remove_prefix(4 + size);
+			return true;
+		}
+
+		// A record from NextBinaryRecord back into an analysis of its platform
+		static bool ReadBinary(std::string_view record, WindowsAnalysis& analysis) { return ReadRecord(record, analysis); }
+		static bool ReadBinary(std::string_view record, MacOSAnalysis& analysis) { return ReadRecord(record, analysis); }
+
+	private:
+		template <typename Analysis>
+		using TableOf = FieldTable<std::remove_cvref_t<decltype(std::declval<Analysis>().Info)>>;
+
+		// function(descriptor, first) for each field of the table, unrolled at compile time
+		template <typename Table, typename Function>
+		static void ForEachField(Function&& function)
+		{
+			std::apply([&](const auto&... fields) {
+				bool first = true;
+				((function(fields, first), first = false), ...);
+			}, Table::Fields);
+		}
+
+		// The check of results[i], looked up by name only when it isn't where the analyzer puts it
+		template <typename Table, typename Results>
+		static CheckKind KindOf(const Results& results, size_t i)
+		{
+			std::wstring_view name = results[i].Name;
+			if (i < Table::Checks.size())
+			{
+				std::string_view expected = ResultCodes::CheckNames[static_cast<size_t>(Table::Checks[i])];
+				if (name.size() == expected.size() && std::equal(name.begin(), name.end(), expected.begin(),
+					[](wchar_t wide, char ascii) { return static_cast<uint32_t>(wide) == static_cast<unsigned char>(ascii); }))
+					return Table::Checks[i];
+			}
+			return ResultCodes::KindOf(name);
+		}
+
+		// Whether CSV needs the text quoted
+		static bool NeedsQuotes(std::wstring_view text)
+		{
+			bool special = false;
+			for (wchar_t c : text)
+				special |= (c == L',') | (c == L'"') | (c == L'\r') | (c == L'\n');
+			return special;
+		}
+
+		static const char* StatusJson(StatusLevel status)
+		{
+			switch (status)
+			{
+			case StatusLevel::Good:
+				return ",\"status\":\"good\",\"reasonKey\":";
+			case StatusLevel::Warning:
+				return ",\"status\":\"warning\",\"reasonKey\":";
+			default:
+				return ",\"status\":\"bad\",\"reasonKey\":";
+			}
+		}
+
+		static const char* StatusCsv(StatusLevel status)
+		{
+			switch (status)
+			{
+			case StatusLevel::Good:
+				return ",good,";
+			case StatusLevel::Warning:
+				return ",warning,";
+			default:
+				return ",bad,";
+			}
+		}
+
+		template <typename Number>
+		static void AppendNumber(OutputBuffer& out, Number value)
+		{
+			char* at = out.Reserve(32);
+			auto [end, error] = std::to_chars(at, at + 32, value);
+			out.Commit(error == std::errc{} ? end : at);
+		}
+
+		template <typename Value>
+		static void AppendJsonValue(OutputBuffer& out, const Value& value)
+		{
+			if constexpr (std::is_same_v<Value, bool>)
+			{
+				out.Append(value ? std::string_view("true") : std::string_view("false"));
+			}
+			else if constexpr (std::is_arithmetic_v<Value>)
+			{
+				AppendNumber(out, value);
+			}
+			else
+			{
+				std::wstring_view text = value;
+				char* at = out.Reserve(text.size() * 6 + 2);
+				*at++ = '"';
+				at = EncodeText<Escaping::Json>(at, text);
+				*at++ = '"';
+				out.Commit(at);
+			}
+		}
+
+		// Quoted, with its quotes doubled, only when it holds a separator, quote or line break
+		template <typename Value>
+		static void AppendCsvValue(OutputBuffer& out, const Value& value)
+		{
+			if constexpr (std::is_same_v<Value, bool>)
+			{
+				out.Append(value ? std::string_view("true") : std::string_view("false"));
+			}
+			else if constexpr (std::is_arithmetic_v<Value>)
+			{
+				AppendNumber(out, value);
+			}
+			else
+			{
+				std::wstring_view text = value;
+				bool quoted = NeedsQuotes(text);
+				char* at = out.Reserve(text.size() * 4 + 2);
+				if (quoted)
+					*at++ = '"';
+				at = quoted ? EncodeText<Escaping::Csv>(at, text) : EncodeText<Escaping::None>(at, text);
+				if (quoted)
+					*at++ = '"';
+				out.Commit(at);
+			}
+		}
+
+		template <typename Value>
+		static void AppendBinaryValue(OutputBuffer& out, const Value& value)
+		{
+			if constexpr (std::is_same_v<Value, bool>)
+			{
+				out.Append(static_cast<char>(value ? 1 : 0));
+			}
+			else if constexpr (std::is_floating_point_v<Value>)
+			{
+				char* at = out.Reserve(8);
+				StoreLittle(at, std::bit_cast<uint64_t>(static_cast<double>(value)), 8);
+				out.Commit(at + 8);
+			}
+			else if constexpr (std::is_integral_v<Value>)
+			{
+				int64_t number = value;
+				char* at = out.Reserve(10);
+				out.Commit(StoreVarint(at, (static_cast<uint64_t>(number) << 1) ^ static_cast<uint64_t>(number >> 63)));
+			}
+			else
+			{
+				// Written after a one-byte count, moved up in the rare case the count needs more
+				std::wstring_view text = value;
+				char* at = out.Reserve(text.size() * 4 + 10);
+				char* end = EncodeText<Escaping::None>(at + 1, text);
+				uint64_t size = static_cast<uint64_t>(end - at - 1);
+				char count[10];
+				size_t countSize = static_cast<size_t>(StoreVarint(count, size) - count);
+				if (countSize > 1)
+					std::memmove(at + countSize, at + 1, static_cast<size_t>(size));
+				std::memcpy(at, count, countSize);
+				out.Commit(at + countSize + size);
+			}
+		}
+
+		enum class Escaping : uint8_t
+		{
+			None,
+			Json,   // Quotes, backslashes and control characters, as AnalysisJson
+			Csv,    // Quotes doubled
+		};
+
+		// Whether the eight characters at 'text' are ASCII that Mode copies as is; no branches,
+		// so the compiler can check them side by side
+		template <Escaping Mode>
+		static bool IsPlain(const wchar_t* text)
+		{
+			bool plain = true;
+			for (size_t k = 0; k < 8; k++)
+			{
+				uint32_t c = static_cast<uint32_t>(text[k]);
+				if constexpr (Mode == Escaping::Json)
+					plain &= (c - 0x20 < 0x60) & (c != '"') & (c != '\\');
+				else if constexpr (Mode == Escaping::Csv)
+					plain &= (c < 0x80) & (c != '"');
+				else
+					plain &= c < 0x80;
+			}
+			return plain;
+		}
+
+		// UTF-8 of the text, as Utf8::Append writes it, escaped for the format. Needs room
+		// for 6 bytes per character with Json and 4 otherwise.
+		template <Escaping Mode>
+		static char* EncodeText(char* out, std::wstring_view text)
+		{
+			for (size_t i = 0; i < text.size(); i++)
+			{
+				// Eight characters at a time while they need neither escaping nor encoding
+				while (i + 8 <= text.size() && IsPlain<Mode>(text.data() + i))
+				{
+					for (size_t k = 0; k < 8; k++)
+						out[k] = static_cast<char>(text[i + k]);
+					out += 8;
+					i += 8;
+				}
+				if (i == text.size())
+					break;
+
+				uint32_t c = static_cast<uint32_t>(text[i]);
+				if (c < 0x80)
+				{
+					if constexpr (Mode == Escaping::Json)
+					{
+						if (c == '"' || c == '\\')
+						{
+							*out++ = '\\';
+						}
+						else if (c < 0x20)
+						{
+							static constexpr char Hex[] = "0123456789abcdef";
+							std::memcpy(out, "\\u00", 4);
+							out[4] = Hex[c >> 4];
+							out[5] = Hex[c & 0xF];
+							out += 6;
+							continue;
+						}
+					}
+					else if constexpr (Mode == Escaping::Csv)
+					{
+						if (c == '"')
+							*out++ = '"';
+					}
+					*out++ = static_cast<char>(c);
+					continue;
+				}
+
+				if constexpr (sizeof(wchar_t) == 2)
+				{
+					if (c >= 0xD800 && c <= 0xDBFF && i + 1 < text.size())
+					{
+						uint32_t low = static_cast<uint32_t>(text[i + 1]);
+						if (low >= 0xDC00 && low <= 0xDFFF)
+						{
+							c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+							i++;
+						}
+					}
+				}
+				if ((c >= 0xD800 && c <= 0xDFFF) || c > 0x10FFFF)
+					c = 0xFFFD;
+
+				if (c < 0x800)
+				{
+					*out++ = static_cast<char>(0xC0 | (c >> 6));
+				}
+				else if (c < 0x10000)
+				{
+					*out++ = static_cast<char>(0xE0 | (c >> 12));
+					*out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+				}
+				else
+				{
+					*out++ = static_cast<char>(0xF0 | (c >> 18));
+					*out++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+					*out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+				}
+				*out++ = static_cast<char>(0x80 | (c & 0x3F));
+			}
+			return out;
+		}
+
+		static char* StoreVarint(char* out, uint64_t value)
+		{
+			while (value >= 0x80)
+			{
+				*out++ = static_cast<char>(value | 0x80);
+				value >>= 7;
+			}
+			*out++ = static_cast<char>(value);
+			return out;
+		}
+
+		static void StoreLittle(char* out, uint64_t value, size_t bytes)
+		{
+			for (size_t i = 0; i < bytes; i++)
+				out[i] = static_cast<char>(value >> (8 * i));
+		}
+
+		static uint64_t LoadLittle(const char* in, size_t bytes)
+		{
+			uint64_t value = 0;
+			for (size_t i = 0; i < bytes; i++)
+				value |= static_cast<uint64_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+			return value;
+		}
+
+		// Reads from a record, failing (and staying failed) once it runs out
+		struct RecordReader
+		{
+			std::string_view Rest;
+			bool Valid = true;
+
+			uint64_t Varint()
+			{
+				uint64_t value = 0;
+				for (int shift = 0; shift < 64 && !Rest.empty(); shift += 7)
+				{
+					uint8_t byte = static_cast<uint8_t>(Rest[0]);
+					Rest.remove_prefix(1);
+					value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+					if (byte < 0x80)
+						return value;
+				}
+				Valid = false;
+				return 0;
+			}
+
+			std::string_view Bytes(size_t count)
+			{
+				if (Rest.size() < count)
+				{
+					Valid = false;
+					count = Rest.size();
+				}
+				std::string_view bytes = Rest.substr(0, count);
+				Rest.remove_prefix(count);
+				return bytes;
+			}
+
+			template <typename Value>
+			void Read(Value& value)
+			{
+				if constexpr (std::is_same_v<Value, bool>)
+				{
+					std::string_view byte = Bytes(1);
+					value = !byte.empty() && byte[0] != 0;
+				}
+				else if constexpr (std::is_floating_point_v<Value>)
+				{
+					std::string_view bytes = Bytes(8);
+					value = bytes.size() == 8 ? std::bit_cast<double>(LoadLittle(bytes.data(), 8)) : 0;
+				}
+				else if constexpr (std::is_integral_v<Value>)
+				{
+					uint64_t zigzag = Varint();
+					value = static_cast<Value>(static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1));
+				}
+				else
+				{
+					Utf8::Decode(Bytes(static_cast<size_t>(Varint())), value);
+				}
+			}
+		};
+
+		template <typename Analysis>
+		static bool ReadRecord(std::string_view record, Analysis& analysis)
+		{
+			using Table = TableOf<Analysis>;
+			if (record.size() < 2 || static_cast<TargetPlatform>(static_cast<uint8_t>(record[0])) != Table::Platform)
+				return false;
+
+			analysis.Score = static_cast<int8_t>(record[1]);
+			RecordReader reader{ record.substr(2) };
+			ForEachField<Table>([&](const auto& field, bool) {
+				reader.Read(analysis.Info.*field.Pointer);
+			});
+
+			std::string_view count = reader.Bytes(1);
+			analysis.Results.clear();
+			for (size_t i = 0; reader.Valid && !count.empty() && i < static_cast<uint8_t>(count[0]); i++)
+			{
+				std::string_view codes = reader.Bytes(3);
+				if (!reader.Valid)
+					break;
+				auto& result = analysis.Results.emplace_back();
+				auto kind = static_cast<size_t>(static_cast<uint8_t>(codes[0]));
+				std::string_view name = kind < static_cast<size_t>(CheckKind::Count) ? ResultCodes::CheckNames[kind] : "";
+				result.Name.assign(name.begin(), name.end());
+				result.Status = static_cast<StatusLevel>(codes[1]);
+				std::string_view reason = ResultCodes::ReasonKey(static_cast<uint8_t>(codes[2]));
+				result.ReasonKey.assign(reason.begin(), reason.end());
+				reader.Read(result.Value);
+			}
+			return reader.Valid && reader.Rest.empty();
+		}
+	};
+}
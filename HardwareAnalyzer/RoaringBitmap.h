@@ -0,0 +1,405 @@
+#pragma once
+#include "pch.h"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace HardwareAnalyzer
+{
+	// Compressed set of 32-bit row numbers (Roaring layout): values are grouped by their
+	// high 16 bits into containers of up to 65536, and each container is a sorted array of
+	// the low 16 bits while it holds at most 4096 of them, a 65536-bit bitmap otherwise.
+	// Either form costs at most 8 KB per container, and set operations run container by
+	// container with word-wide ANDs and ORs on the dense ones.
+	//
+	// Run containers are left out: fleet rows are added in order and queried, and the
+	// selections (a GPU family, a RAM bucket) are scattered rather than in long runs.
+	class RoaringBitmap
+	{
+	public:
+		static constexpr size_t ArrayLimit = 4096;
+		static constexpr size_t BitmapWords = 65536 / 64;
+
+		// Cheapest when values come in ascending order, as rows do
+		void Add(uint32_t value)
+		{
+			uint16_t key = static_cast<uint16_t>(value >> 16);
+			uint16_t low = static_cast<uint16_t>(value);
+			Container& container = (!m_containers.empty() && m_containers.back().Key == key) ? m_containers.back() : Find(key);
+			container.Add(low);
+		}
+
+		bool Contains(uint32_t value) const
+		{
+			uint16_t key = static_cast<uint16_t>(value >> 16);
+			auto found = std::lower_bound(m_containers.begin(), m_containers.end(), key,
+				[](const Container& container, uint16_t k) { return container.Key < k; });
+			return found != m_containers.end() && found->Key == key && found->Contains(static_cast<uint16_t>(value));
+		}
+
+		uint64_t Cardinality() const
+		{
+			uint64_t count = 0;
+			for (const Container& container : m_containers)
+			{
+				count += container.Count;
+			}
+			return count;
+		}
+
+		bool Empty() const { return m_containers.empty(); }
+
+		// Every value in [0, end)
+		static RoaringBitmap Range(uint32_t end)
+		{
+			RoaringBitmap range;
+			for (uint32_t start = 0; start < end; start += 65536)
+			{
+				Container container;
+				container.Key = static_cast<uint16_t>(start >> 16);
+				uint32_t count = (std::min)(end - start, 65536u);
+				if (count <= ArrayLimit)
+				{
+					for (uint32_t i = 0; i < count; i++)
+					{
+						container.Array.push_back(static_cast<uint16_t>(i));
+					}
+				}
+				else
+				{
+					container.Bits.assign(BitmapWords, 0);
+					for (uint32_t word = 0; word < count / 64; word++)
+					{
+						container.Bits[word] = ~uint64_t{ 0 };
+					}
+					if (count % 64 != 0)
+						container.Bits[count / 64] = (uint64_t{ 1 } << (count % 64)) - 1;
+				}
+				container.Count = count;
+				range.m_containers.push_back(std::move(container));
+			}
+			return range;
+		}
+
+		static RoaringBitmap And(const RoaringBitmap& a, const RoaringBitmap& b)
+		{
+			RoaringBitmap result;
+			size_t i = 0;
+			size_t j = 0;
+			while (i < a.m_containers.size() && j < b.m_containers.size())
+			{
+				const Container& x = a.m_containers[i];
+				const Container& y = b.m_containers[j];
+				if (x.Key < y.Key)
+				{
+					i++;
+				}
+				else if (y.Key < x.Key)
+				{
+					j++;
+				}
+				else
+				{
+					Container both = Container::And(x, y);
+					if (both.Count > 0)
+						result.m_containers.push_back(std::move(both));
+					i++;
+					j++;
+				}
+			}
+			return result;
+		}
+
+		static RoaringBitmap Or(const RoaringBitmap& a, const RoaringBitmap& b)
+		{
+			RoaringBitmap result;
+			size_t i = 0;
+			size_t j = 0;
+			while (i < a.m_containers.size() || j < b.m_containers.size())
+			{
+				if (j == b.m_containers.size() || (i < a.m_containers.size() && a.m_containers[i].Key < b.m_containers[j].Key))
+				{
+					result.m_containers.push_back(a.m_containers[i++]);
+				}
+				else if (i == a.m_containers.size() || b.m_containers[j].Key < a.m_containers[i].Key)
+				{
+					result.m_containers.push_back(b.m_containers[j++]);
+				}
+				else
+				{
+					result.m_containers.push_back(Container::Or(a.m_containers[i++], b.m_containers[j++]));
+				}
+			}
+			return result;
+		}
+
+		// The values of a that aren't in b
+		static RoaringBitmap AndNot(const RoaringBitmap& a, const RoaringBitmap& b)
+		{
+			RoaringBitmap result;
+			size_t j = 0;
+			for (const Container& x : a.m_containers)
+			{
+				while (j < b.m_containers.size() && b.m_containers[j].Key < x.Key)
+				{
+					j++;
+				}
+				if (j == b.m_containers.size() || b.m_containers[j].Key != x.Key)
+				{
+					result.m_containers.push_back(x);
+					continue;
+				}
+				Container rest = Container::AndNot(x, b.m_containers[j]);
+				if (rest.Count > 0)
+					result.m_containers.push_back(std::move(rest));
+			}
+			return result;
+		}
+
+		// Calls function(value) in ascending order
+		template <typename Function>
+		void ForEach(Function&& function) const
+		{
+			for (const Container& container : m_containers)
+			{
+				uint32_t high = uint32_t{ container.Key } << 16;
+				if (container.IsBitmap())
+				{
+					for (size_t word = 0; word < BitmapWords; word++)
+					{
+						for (uint64_t bits = container.Bits[word]; bits != 0; bits &= bits - 1)
+						{
+							function(high | static_cast<uint32_t>(word * 64 + std::countr_zero(bits)));
+						}
+					}
+				}
+				else
+				{
+					for (uint16_t low : container.Array)
+					{
+						function(high | low);
+					}
+				}
+			}
+		}
+
+		std::vector<uint32_t> ToVector() const
+		{
+			std::vector<uint32_t> values;
+			values.reserve(static_cast<size_t>(Cardinality()));
+			ForEach([&](uint32_t value) { values.push_back(value); });
+			return values;
+		}
+
+		size_t MemoryBytes() const
+		{
+			size_t bytes = m_containers.capacity() * sizeof(Container);
+			for (const Container& container : m_containers)
+			{
+				bytes += container.Array.capacity() * sizeof(uint16_t) + container.Bits.capacity() * sizeof(uint64_t);
+			}
+			return bytes;
+		}
+
+	private:
+		struct Container
+		{
+			uint16_t Key = 0;
+			uint32_t Count = 0;
+			std::vector<uint16_t> Array;    // Sorted; used while Bits is empty
+			std::vector<uint64_t> Bits;     // BitmapWords words once past ArrayLimit values
+
+			bool IsBitmap() const { return !Bits.empty(); }
+
+			bool Contains(uint16_t low) const
+			{
+				if (IsBitmap())
+					return (Bits[low / 64] >> (low % 64)) & 1;
+				return std::binary_search(Array.begin(), Array.end(), low);
+			}
+
+			void Add(uint16_t low)
+			{
+				if (IsBitmap())
+				{
+					uint64_t bit = uint64_t{ 1 } << (low % 64);
+					Count += (Bits[low / 64] & bit) == 0;
+					Bits[low / 64] |= bit;
+					return;
+				}
+
+				if (Array.empty() || Array.back() < low)
+				{
+					Array.push_back(low);
+				}
+				else
+				{
+					auto at = std::lower_bound(Array.begin(), Array.end(), low);
+					if (*at == low)
+						return;
+					Array.insert(at, low);
+				}
+				Count++;
+				if (Array.size() > ArrayLimit)
+					ToBitmap();
+			}
+
+			void ToBitmap()
+			{
+				Bits.assign(BitmapWords, 0);
+				for (uint16_t low : Array)
+				{
+					Bits[low / 64] |= uint64_t{ 1 } << (low % 64);
+				}
+				Array.clear();
+				Array.shrink_to_fit();
+			}
+
+			// Back to an array when a bitmap result is small enough
+			void Normalize()
+			{
+				if (!IsBitmap() || Count > ArrayLimit)
+					return;
+				Array.reserve(Count);
+				for (size_t word = 0; word < BitmapWords; word++)
+				{
+					for (uint64_t bits = Bits[word]; bits != 0; bits &= bits - 1)
+					{
+						Array.push_back(static_cast<uint16_t>(word * 64 + std::countr_zero(bits)));
+					}
+				}
+				Bits.clear();
+				Bits.shrink_to_fit();
+			}
+
+			static uint32_t CountBits(const std::vector<uint64_t>& bits)
+			{
+				uint32_t count = 0;
+				for (uint64_t word : bits)
+				{
+					count += static_cast<uint32_t>(std::popcount(word));
+				}
+				return count;
+			}
+
+			static Container And(const Container& a, const Container& b)
+			{
+				Container result;
+				result.Key = a.Key;
+				if (a.IsBitmap() && b.IsBitmap())
+				{
+					result.Bits.resize(BitmapWords);
+					for (size_t word = 0; word < BitmapWords; word++)
+					{
+						result.Bits[word] = a.Bits[word] & b.Bits[word];
+					}
+					result.Count = CountBits(result.Bits);
+					result.Normalize();
+				}
+				else if (a.IsBitmap() || b.IsBitmap())
+				{
+					const Container& array = a.IsBitmap() ? b : a;
+					const Container& bitmap = a.IsBitmap() ? a : b;
+					for (uint16_t low : array.Array)
+					{
+						if ((bitmap.Bits[low / 64] >> (low % 64)) & 1)
+							result.Array.push_back(low);
+					}
+					result.Count = static_cast<uint32_t>(result.Array.size());
+				}
+				else
+				{
+					std::set_intersection(a.Array.begin(), a.Array.end(), b.Array.begin(), b.Array.end(), std::back_inserter(result.Array));
+					result.Count = static_cast<uint32_t>(result.Array.size());
+				}
+				return result;
+			}
+
+			static Container Or(const Container& a, const Container& b)
+			{
+				Container result;
+				result.Key = a.Key;
+				if (!a.IsBitmap() && !b.IsBitmap() && a.Array.size() + b.Array.size() <= ArrayLimit)
+				{
+					std::set_union(a.Array.begin(), a.Array.end(), b.Array.begin(), b.Array.end(), std::back_inserter(result.Array));
+					result.Count = static_cast<uint32_t>(result.Array.size());
+					return result;
+				}
+
+				result.Bits.assign(BitmapWords, 0);
+				for (const Container* side : { &a, &b })
+				{
+					if (side->IsBitmap())
+					{
+						for (size_t word = 0; word < BitmapWords; word++)
+						{
+							result.Bits[word] |= side->Bits[word];
+						}
+					}
+					else
+					{
+						for (uint16_t low : side->Array)
+						{
+							result.Bits[low / 64] |= uint64_t{ 1 } << (low % 64);
+						}
+					}
+				}
+				result.Count = CountBits(result.Bits);
+				result.Normalize();
+				return result;
+			}
+
+			static Container AndNot(const Container& a, const Container& b)
+			{
+				Container result;
+				result.Key = a.Key;
+				if (!a.IsBitmap())
+				{
+					for (uint16_t low : a.Array)
+					{
+						if (!b.Contains(low))
+							result.Array.push_back(low);
+					}
+					result.Count = static_cast<uint32_t>(result.Array.size());
+					return result;
+				}
+
+				result.Bits = a.Bits;
+				if (b.IsBitmap())
+				{
+					for (size_t word = 0; word < BitmapWords; word++)
+					{
+						result.Bits[word] &= ~b.Bits[word];
+					}
+				}
+				else
+				{
+					for (uint16_t low : b.Array)
+					{
+						result.Bits[low / 64] &= ~(uint64_t{ 1 } << (low % 64));
+					}
+				}
+				result.Count = CountBits(result.Bits);
+				result.Normalize();
+				return result;
+			}
+		};
+
+		std::vector<Container> m_containers;     // Sorted by Key, none empty
+
+		Container& Find(uint16_t key)
+		{
+			auto found = std::lower_bound(m_containers.begin(), m_containers.end(), key,
+				[](const Container& container, uint16_t k) { return container.Key < k; });
+			if (found == m_containers.end() || found->Key != key)
+			{
+				found = m_containers.insert(found, Container{});
+				found->Key = key;
+			}
+			return *found;
+		}
+	};
+}
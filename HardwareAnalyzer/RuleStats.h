@@ -0,0 +1,274 @@
+#pragma once
+#include "pch.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Define HARDWARE_ANALYZER_RULE_STATS=1 to count which extraction rules and classifier
+// branches fire. When it is not defined every probe below is an empty inline function.
+#ifndef HARDWARE_ANALYZER_RULE_STATS
+#define HARDWARE_ANALYZER_RULE_STATS 0
+#endif
+
+namespace HardwareAnalyzer
+{
+	// One entry per extraction fallback or classifier branch, in evaluation order
+	enum class Rule : uint16_t
+	{
+		// ParseOcrText
+		ProcessorLabel,
+		ProcessorHeaderCard,
+		RamLabel,
+		RamHeaderCard,
+		RamHeaderCardCandidate,     // Every "<n> GB" seen by the header card fallback
+		GpuMultipleHeader,
+		GpuLabel,
+		GpuVendorLine,
+		VramCardHeader,
+		VramLabel,
+		VramFromGpuName,
+		DeviceNameLabel,
+		SystemTypeLabel,
+		SystemTypeArchLine,
+		SystemTypeProcessorArch,
+
+		// AnalyzeCPU
+		CpuNotFound,
+		CpuQualcomm,
+		CpuIntelGeneration,
+		CpuRyzenSeries,
+		CpuLowPerfFamily,
+		CpuCore2,
+		CpuDefault,
+
+		// AnalyzeGPU
+		GpuNotFound,
+		GpuMultiple,
+		GpuQualcomm,
+		GpuIntel,
+		GpuNvidia,
+		GpuAmdRadeon,
+		GpuDefault,
+
+		// ParseMacOSOcrText
+		MacDeviceName,
+		MacYear,
+		MacAppleChip,
+		MacIntelChip,
+		MacMemory,
+		MacOSVersionName,
+
+		// AnalyzeChip
+		MacChipNotFound,
+		MacChipIntel,
+		MacChipAppleSilicon,
+		MacChipUnknown,
+
+		Count
+	};
+
+	struct RuleCounters
+	{
+		uint64_t Attempts = 0;
+		uint64_t Matches = 0;
+		uint64_t Nanoseconds = 0;   // Time spent evaluating the rule, matched or not
+	};
+
+	class RuleStats
+	{
+	public:
+		static constexpr bool Enabled = HARDWARE_ANALYZER_RULE_STATS != 0;
+		static constexpr size_t RuleCount = static_cast<size_t>(Rule::Count);
+
+		static const char* Name(Rule rule)
+		{
+			static constexpr const char* names[RuleCount] = {
+				"ProcessorLabel", "ProcessorHeaderCard", "RamLabel", "RamHeaderCard", "RamHeaderCardCandidate",
+				"GpuMultipleHeader", "GpuLabel", "GpuVendorLine", "VramCardHeader", "VramLabel", "VramFromGpuName",
+				"DeviceNameLabel", "SystemTypeLabel", "SystemTypeArchLine", "SystemTypeProcessorArch",
+				"CpuNotFound", "CpuQualcomm", "CpuIntelGeneration", "CpuRyzenSeries", "CpuLowPerfFamily", "CpuCore2", "CpuDefault",
+				"GpuNotFound", "GpuMultiple", "GpuQualcomm", "GpuIntel", "GpuNvidia", "GpuAmdRadeon", "GpuDefault",
+				"MacDeviceName", "MacYear", "MacAppleChip", "MacIntelChip", "MacMemory", "MacOSVersionName",
+				"MacChipNotFound", "MacChipIntel", "MacChipAppleSilicon", "MacChipUnknown"
+			};
+			size_t index = static_cast<size_t>(rule);
+			return index < RuleCount ? names[index] : "?";
+		}
+
+#if HARDWARE_ANALYZER_RULE_STATS
+		static void Record(Rule rule, bool matched, uint64_t nanoseconds)
+		{
+			// Only the owning thread writes its slots, so relaxed load + store is enough
+			// and exporting never blocks a parse
+			Slot& slot = LocalCounters().Slots[static_cast<size_t>(rule)];
+			slot.Attempts.store(slot.Attempts.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			if (matched)
+				slot.Matches.store(slot.Matches.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			slot.Nanoseconds.store(slot.Nanoseconds.load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+		}
+
+		// Totals over every thread that ever recorded, minus what Reset() saw
+		static std::array<RuleCounters, RuleCount> Snapshot()
+		{
+			std::array<RuleCounters, RuleCount> totals{};
+			GlobalState& state = State();
+			std::lock_guard<std::mutex> lock(state.RegistryLock);
+			for (const auto& counters : state.Threads)
+			{
+				for (size_t i = 0; i < RuleCount; i++)
+				{
+					totals[i].Attempts += counters->Slots[i].Attempts.load(std::memory_order_relaxed);
+					totals[i].Matches += counters->Slots[i].Matches.load(std::memory_order_relaxed);
+					totals[i].Nanoseconds += counters->Slots[i].Nanoseconds.load(std::memory_order_relaxed);
+				}
+			}
+			for (size_t i = 0; i < RuleCount; i++)
+			{
+				totals[i].Attempts -= state.Baseline[i].Attempts;
+				totals[i].Matches -= state.Baseline[i].Matches;
+				totals[i].Nanoseconds -= state.Baseline[i].Nanoseconds;
+			}
+			return totals;
+		}
+
+		// Counters are never written by other threads, so a reset just moves the baseline
+		static void Reset()
+		{
+			std::array<RuleCounters, RuleCount> current = Snapshot();
+			GlobalState& state = State();
+			std::lock_guard<std::mutex> lock(state.RegistryLock);
+			for (size_t i = 0; i < RuleCount; i++)
+			{
+				state.Baseline[i].Attempts += current[i].Attempts;
+				state.Baseline[i].Matches += current[i].Matches;
+				state.Baseline[i].Nanoseconds += current[i].Nanoseconds;
+			}
+		}
+#else
+		static void Record(Rule, bool, uint64_t) {}
+		static std::array<RuleCounters, RuleCount> Snapshot() { return {}; }
+		static void Reset() {}
+#endif
+
+		// "rule,attempts,matches,total_ns" with one line per rule
+		static std::string ToCsv()
+		{
+			std::string csv = "rule,attempts,matches,total_ns\n";
+			std::array<RuleCounters, RuleCount> totals = Snapshot();
+			for (size_t i = 0; i < RuleCount; i++)
+			{
+				csv += Name(static_cast<Rule>(i));
+				csv += ',' + std::to_string(totals[i].Attempts);
+				csv += ',' + std::to_string(totals[i].Matches);
+				csv += ',' + std::to_string(totals[i].Nanoseconds);
+				csv += '\n';
+			}
+			return csv;
+		}
+
+	private:
+#if HARDWARE_ANALYZER_RULE_STATS
+		struct Slot
+		{
+			std::atomic<uint64_t> Attempts{ 0 };
+			std::atomic<uint64_t> Matches{ 0 };
+			std::atomic<uint64_t> Nanoseconds{ 0 };
+		};
+
+		struct ThreadCounters
+		{
+			std::array<Slot, RuleCount> Slots;
+		};
+
+		struct GlobalState
+		{
+			std::mutex RegistryLock;
+			std::vector<std::shared_ptr<ThreadCounters>> Threads;
+			std::array<RuleCounters, RuleCount> Baseline{};
+		};
+
+		static GlobalState& State()
+		{
+			static GlobalState state;
+			return state;
+		}
+
+		// Registered once per thread and kept after the thread exits so its counts still add up
+		static ThreadCounters& LocalCounters()
+		{
+			thread_local std::shared_ptr<ThreadCounters> counters = [] {
+				auto created = std::make_shared<ThreadCounters>();
+				GlobalState& state = State();
+				std::lock_guard<std::mutex> lock(state.RegistryLock);
+				state.Threads.push_back(created);
+				return created;
+			}();
+			return *counters;
+		}
+#endif
+	};
+
+	// Times a chain of rules tried one after another. Attempt() closes the previous rule
+	// (as a miss unless Match() was called) and starts timing the next one; the last
+	// rule is closed on destruction.
+	class RuleProbe
+	{
+	public:
+		RuleProbe() = default;
+		explicit RuleProbe(Rule rule) { Attempt(rule); }
+		RuleProbe(const RuleProbe&) = delete;
+		RuleProbe& operator=(const RuleProbe&) = delete;
+
+#if HARDWARE_ANALYZER_RULE_STATS
+		~RuleProbe()
+		{
+			Close();
+		}
+
+		void Attempt(Rule rule)
+		{
+			Close();
+			m_rule = rule;
+			m_matched = false;
+			m_active = true;
+			m_start = std::chrono::steady_clock::now();
+		}
+
+		void Match()
+		{
+			m_matched = true;
+		}
+
+		// Attempt + Match without timing, for per-candidate counts inside a timed rule
+		static void Count(Rule rule, bool matched)
+		{
+			RuleStats::Record(rule, matched, 0);
+		}
+
+	private:
+		void Close()
+		{
+			if (!m_active)
+				return;
+			m_active = false;
+			auto elapsed = std::chrono::steady_clock::now() - m_start;
+			RuleStats::Record(m_rule, m_matched,
+				static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+		}
+
+		std::chrono::steady_clock::time_point m_start{};
+		Rule m_rule = Rule::Count;
+		bool m_matched = false;
+		bool m_active = false;
+#else
+		void Attempt(Rule) {}
+		void Match() {}
+		static void Count(Rule, bool) {}
+#endif
+	};
+}
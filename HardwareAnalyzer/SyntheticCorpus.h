@@ -0,0 +1,968 @@
+#pragma once
+#include "pch.h"
+#include "HardwareInfo.h"
+#include "LabelPack.h"
+#include "MacOSHardwareInfo.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace HardwareAnalyzer
+{
+	// OCR text of About pages for load and accuracy runs, generated instead of captured:
+	// Windows "About" pages (with or without the Windows 11 header cards, one GPU or several)
+	// and macOS "About This Mac" windows, in every language of the label catalog, with random
+	// hardware and optional OCR noise. Each document comes with its ground truth: what a
+	// perfect reader of the clean page reports, in the form the parsers report it in.
+	// Document i depends only on the options and i, so a corpus of any size can be generated
+	// in shards, in any order and on any number of threads, and generated again later.
+	class SyntheticCorpus
+	{
+	public:
+		struct Options
+		{
+			uint64_t Seed = 1;
+			double MacOSShare = 0.25;          // Documents that are "About This Mac" windows
+			double HeaderCardShare = 0.6;      // Windows pages with the Windows 11 header cards
+			double MultipleGpuShare = 0.1;     // Pages with cards whose GPU card reads "Multiple GPUs installed"
+
+			// OCR noise, off by default. The ground truth stays that of the clean page.
+			double ConfusionRate = 0;          // Per character: O/0, l/1, S/5, m/rn, NBSP, curly quote...
+			double MergedLineRate = 0;         // Per line break: the next line is read as part of this one
+			double DroppedLabelRate = 0;       // Per labeled row: only the value is read
+
+			std::vector<std::wstring> Languages;   // Tags to generate; every language of the catalog when empty
+		};
+
+		struct Document
+		{
+			uint64_t Index = 0;
+			TargetPlatform Platform = TargetPlatform::Windows;
+			std::wstring_view Language;        // Tag of the page's language
+			std::wstring Text;
+			HardwareInfo Windows;              // Ground truth of a Windows page
+			MacOSHardwareInfo Mac;             // Ground truth of a macOS page
+		};
+
+		// Fields Mismatches compares, one bit each; FieldNames[i] names bit i
+		static constexpr uint32_t DeviceNameField = 1u << 0;
+		static constexpr uint32_t ProcessorField = 1u << 1;
+		static constexpr uint32_t RamField = 1u << 2;
+		static constexpr uint32_t GpuField = 1u << 3;
+		static constexpr uint32_t VramField = 1u << 4;
+		static constexpr uint32_t SystemTypeField = 1u << 5;
+		static constexpr uint32_t DeviceYearField = 1u << 6;
+		static constexpr uint32_t ChipField = 1u << 7;
+		static constexpr uint32_t MemoryField = 1u << 8;
+		static constexpr uint32_t MacOSVersionField = 1u << 9;
+
+		static constexpr size_t FieldCount = 10;
+		static constexpr const char* FieldNames[FieldCount] = {
+			"deviceName", "processor", "ram", "gpu", "vram", "systemType",
+			"deviceYear", "chip", "memory", "macOSVersion"
+		};
+
+		explicit SyntheticCorpus(Options options, std::shared_ptr<const LabelCatalog> catalog = LabelPack::Active())
+			: m_options(std::move(options)), m_catalog(std::move(catalog))
+		{
+			m_confusion = Threshold(m_options.ConfusionRate);
+			m_merge = Threshold(m_options.MergedLineRate);
+			m_drop = Threshold(m_options.DroppedLabelRate);
+
+			for (const auto& language : m_catalog->Languages())
+			{
+				bool wanted = m_options.Languages.empty();
+				for (const auto& tag : m_options.Languages)
+					wanted = wanted || language.Tag == tag;
+				if (wanted)
+					m_languages.push_back(MakePageLanguage(language));
+			}
+			if (m_languages.empty())
+			{
+				for (const auto& language : m_catalog->Languages())
+					m_languages.push_back(MakePageLanguage(language));
+			}
+		}
+
+		// Document 'index' into 'document', whose buffers are reused. Safe to call from
+		// several threads at once with different documents.
+		void Generate(uint64_t index, Document& document) const
+		{
+			Random random(Mix(m_options.Seed ^ Mix(index + 0x9E3779B97F4A7C15ull)));
+			const PageLanguage& language = m_languages[random.Below(static_cast<uint32_t>(m_languages.size()))];
+
+			document.Index = index;
+			document.Language = language.Tag;
+			document.Text.clear();
+			PageWriter page{ document.Text, random, m_confusion, m_merge, m_drop };
+			if (random.Chance(m_options.MacOSShare))
+			{
+				document.Platform = TargetPlatform::macOS;
+				GenerateMac(random, language, page, document.Mac);
+			}
+			else
+			{
+				document.Platform = TargetPlatform::Windows;
+				GenerateWindows(random, language, page, document.Windows);
+			}
+		}
+
+		// Fields of 'parsed' that differ from the ground truth; sizes are compared in GB
+		template <typename String>
+		static uint32_t Mismatches(const HardwareInfo& truth, const BasicHardwareInfo<String>& parsed)
+		{
+			uint32_t fields = 0;
+			fields |= Differs(truth.DeviceName, parsed.DeviceName) ? DeviceNameField : 0;
+			fields |= Differs(truth.Processor, parsed.Processor) ? ProcessorField : 0;
+			fields |= Differs(truth.RamGB, parsed.RamGB) ? RamField : 0;
+			fields |= Differs(truth.GPU, parsed.GPU) ? GpuField : 0;
+			fields |= Differs(truth.VramGB, parsed.VramGB) ? VramField : 0;
+			fields |= Differs(truth.SystemType, parsed.SystemType) ? SystemTypeField : 0;
+			return fields;
+		}
+
+		template <typename String>
+		static uint32_t Mismatches(const MacOSHardwareInfo& truth, const BasicMacOSHardwareInfo<String>& parsed)
+		{
+			uint32_t fields = 0;
+			fields |= Differs(truth.DeviceName, parsed.DeviceName) ? DeviceNameField : 0;
+			fields |= Differs(truth.DeviceYear, parsed.DeviceYear) ? DeviceYearField : 0;
+			fields |= Differs(truth.Chip, parsed.Chip) || truth.ChipGeneration != parsed.ChipGeneration ? ChipField : 0;
+			fields |= Differs(truth.MemoryGB, parsed.MemoryGB) ? MemoryField : 0;
+			fields |= Differs(truth.MacOSVersion, parsed.MacOSVersion) || truth.MacOSMajorVersion != parsed.MacOSMajorVersion ? MacOSVersionField : 0;
+			return fields;
+		}
+
+	private:
+		// splitmix64, seeded per document
+		class Random
+		{
+		public:
+			explicit Random(uint64_t state) : m_state(state) {}
+
+			uint64_t Next()
+			{
+				m_state += 0x9E3779B97F4A7C15ull;
+				return Mix(m_state);
+			}
+
+			uint32_t Below(uint32_t count)
+			{
+				return static_cast<uint32_t>(((Next() >> 32) * count) >> 32);
+			}
+
+			// Compares exact integers, so the same options give the same documents everywhere
+			bool Chance(double probability)
+			{
+				return static_cast<double>(Next() >> 11) < probability * 9007199254740992.0;
+			}
+
+			template <typename T, size_t N>
+			const T& Pick(const T(&items)[N])
+			{
+				return items[Below(static_cast<uint32_t>(N))];
+			}
+
+		private:
+			uint64_t m_state;
+		};
+
+		static uint64_t Mix(uint64_t z)
+		{
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		}
+
+		// Probability -> Next() threshold; 0 never draws at all
+		static uint64_t Threshold(double rate)
+		{
+			if (!(rate > 0))
+				return 0;
+			return rate >= 1 ? UINT64_MAX : static_cast<uint64_t>(rate * 18446744073709551616.0);
+		}
+
+		// Appends page text, misreading it as configured on the way
+		class PageWriter
+		{
+		public:
+			PageWriter(std::wstring& text, Random& random, uint64_t confusion, uint64_t merge, uint64_t drop)
+				: m_text(text), m_random(random), m_confusion(confusion), m_merge(merge), m_drop(drop) {}
+
+			void Append(std::wstring_view text)
+			{
+				if (m_confusion == 0)
+				{
+					m_text.append(text);
+					return;
+				}
+				for (wchar_t c : text)
+				{
+					if (m_random.Next() >= m_confusion || !Confuse(c))
+						m_text += c;
+				}
+			}
+
+			void Append(wchar_t c) { Append(std::wstring_view(&c, 1)); }
+
+			void Integer(uint64_t value, size_t minDigits = 1)
+			{
+				wchar_t buffer[24];
+				wchar_t* end = buffer + 24;
+				wchar_t* begin = FormatInteger(value, minDigits, end);
+				Append(std::wstring_view(begin, end - begin));
+			}
+
+			void Tenths(uint32_t tenths, wchar_t decimal)
+			{
+				Integer(tenths / 10);
+				Append(decimal);
+				Integer(tenths % 10);
+			}
+
+			// '\n', or ' ' when OCR reads the next line as part of this one
+			void EndLine()
+			{
+				m_text += m_merge != 0 && m_random.Next() < m_merge ? L' ' : L'\n';
+			}
+
+			void Line(std::wstring_view text)
+			{
+				Append(text);
+				EndLine();
+			}
+
+			// The label of a row, then its value on the same line or (a table read column-wise) the next
+			void Label(std::wstring_view label, bool sameLine)
+			{
+				if (m_drop != 0 && m_random.Next() < m_drop)
+					return;
+				Append(label);
+				if (sameLine)
+					m_text.append(L"  ");
+				else
+					EndLine();
+			}
+
+			void Row(std::wstring_view label, std::wstring_view value, bool sameLine)
+			{
+				Label(label, sameLine);
+				Line(value);
+			}
+
+		private:
+			// Appends what OCR commonly reads instead of c; false when c has no such misreading
+			bool Confuse(wchar_t c)
+			{
+				switch (c)
+				{
+				case L'O':
+					m_text += L'0';
+					return true;
+				case L'0':
+					m_text += L'O';
+					return true;
+				case L'l':
+					m_text += L'1';
+					return true;
+				case L'1':
+				case L'I':
+					m_text += L'l';
+					return true;
+				case L'S':
+					m_text += L'5';
+					return true;
+				case L'5':
+					m_text += L'S';
+					return true;
+				case L'B':
+					m_text += L'8';
+					return true;
+				case L'e':
+					m_text += L'c';
+					return true;
+				case L'm':
+					m_text.append(L"rn");
+					return true;
+				case L' ':
+					m_text += L'\u00A0';
+					return true;
+				case L'\'':
+					m_text += L'\u2019';
+					return true;
+				case L'-':
+					m_text += L'\u2013';
+					return true;
+				case L'\u00E9':
+					m_text.append(L"e\u0301");
+					return true;
+				default:
+					return false;
+				}
+			}
+
+			std::wstring& m_text;
+			Random& m_random;
+			uint64_t m_confusion;
+			uint64_t m_merge;
+			uint64_t m_drop;
+		};
+
+		// Digits of value, at least minDigits of them, written backwards from 'end'; returns the first
+		static wchar_t* FormatInteger(uint64_t value, size_t minDigits, wchar_t* end)
+		{
+			wchar_t* begin = end;
+			do
+			{
+				*--begin = static_cast<wchar_t>(L'0' + value % 10);
+				value /= 10;
+			} while (value > 0 || static_cast<size_t>(end - begin) < minDigits);
+			return begin;
+		}
+
+		static void AppendInteger(std::wstring& text, uint64_t value)
+		{
+			wchar_t buffer[24];
+			wchar_t* end = buffer + 24;
+			text.append(FormatInteger(value, 1, end), end);
+		}
+
+		// "16,0" for 160 tenths
+		static void AppendTenths(std::wstring& text, uint32_t tenths, wchar_t decimal)
+		{
+			AppendInteger(text, tenths / 10);
+			text += decimal;
+			AppendInteger(text, tenths % 10);
+		}
+
+		// Page text the label catalog doesn't have, in the languages it's known for. Languages
+		// without a row get only the catalog's labels and language-neutral values, so that no
+		// English sentence changes which language their pages are identified as.
+		struct Phrases
+		{
+			std::wstring_view Tag;
+
+			// Windows "About"
+			std::wstring_view DeviceSpecifications, RenamePc, DeviceId, ProductId, PenAndTouch, NoPenOrTouch;
+			std::wstring_view WindowsSpecifications, Edition, Version, OsBuild;
+			std::wstring_view Usable;          // "(15,7 GB usable)"
+			std::wstring_view MultipleGpus;    // Empty when the parsers don't know the phrase
+			std::wstring_view SystemType;      // '#' -> 64 or 32, '@' -> x64 or ARM
+			std::wstring_view GpuMemory;       // Label of a VRAM row under a graphics card row, if any
+			std::wstring_view RamUnit, SmallUnit;
+
+			// "About This Mac"
+			std::wstring_view Chip, Memory, Processor, Graphics, StartupDisk, SerialNumber, MoreInfo;
+		};
+
+		static constexpr Phrases PhraseTable[] = {
+			{ L"en",
+				L"Device specifications", L"Rename this PC", L"Device ID", L"Product ID", L"Pen and touch",
+				L"No pen or touch input is available for this display",
+				L"Windows specifications", L"Edition", L"Version", L"OS build",
+				L"usable", L"Multiple GPUs installed", L"#-bit operating system, @-based processor", L"GPU memory",
+				L"GB", L"MB",
+				L"Chip", L"Memory", L"Processor", L"Graphics", L"Startup disk", L"Serial number", L"More Info..." },
+			{ L"fr",
+				L"Sp\u00E9cifications de l'appareil", L"Renommer ce PC", L"ID de p\u00E9riph\u00E9rique", L"ID de produit",
+				L"Stylet et fonction tactile",
+				L"La fonctionnalit\u00E9 d'entr\u00E9e tactile ou avec un stylet n'est pas disponible sur cet \u00E9cran",
+				L"Sp\u00E9cifications de Windows", L"\u00C9dition", L"Version", L"Version du syst\u00E8me d'exploitation",
+				L"utilisable", L"Plusieurs GPU install\u00E9s", L"Syst\u00E8me d'exploitation # bits, processeur @",
+				L"M\u00E9moire vid\u00E9o",
+				L"Go", L"Mo",
+				L"Puce", L"M\u00E9moire", L"Processeur", L"Graphisme", L"Disque de d\u00E9marrage",
+				L"Num\u00E9ro de s\u00E9rie", L"Plus d'infos..." },
+			{ L"de",
+				L"Ger\u00E4tespezifikationen", L"Diesen PC umbenennen", L"Ger\u00E4te-ID", L"Produkt-ID",
+				L"Stift- und Toucheingabe", L"F\u00FCr diese Anzeige ist keine Stift- oder Toucheingabe verf\u00FCgbar.",
+				L"Windows-Spezifikationen", L"Edition", L"Version", L"Betriebssystembuild",
+				L"verwendbar", L"Mehrere GPUs installiert", L"#-Bit-Betriebssystem, @-basierter Prozessor", L"",
+				L"GB", L"MB",
+				L"Chip", L"Speicher", L"Prozessor", L"Grafikkarte", L"Startvolume", L"Seriennummer", L"Weitere Infos ..." },
+			{ L"es",
+				L"Especificaciones del dispositivo", L"Cambiar el nombre de este equipo", L"Id. del dispositivo",
+				L"Id. del producto", L"L\u00E1piz y entrada t\u00E1ctil",
+				L"La entrada t\u00E1ctil o manuscrita no est\u00E1 disponible para esta pantalla",
+				L"Especificaciones de Windows", L"Edici\u00F3n", L"Versi\u00F3n", L"Compilaci\u00F3n del sistema operativo",
+				L"utilizable", L"", L"Sistema operativo de # bits, procesador basado en @", L"",
+				L"GB", L"MB",
+				L"Chip", L"Memoria", L"Procesador", L"Gr\u00E1ficos", L"Disco de arranque", L"N\u00FAmero de serie",
+				L"M\u00E1s informaci\u00F3n..." },
+		};
+
+		// A catalog language with its labels as they appear on screen
+		struct PageLanguage
+		{
+			std::wstring_view Tag;
+			const Phrases* Text = nullptr;
+			std::wstring Processor, InstalledRam, GraphicsCard, DeviceName, SystemType;
+			std::wstring RamUnit, SmallUnit, MacMemoryUnit;
+			wchar_t Decimal = L',';
+		};
+
+		static PageLanguage MakePageLanguage(const LanguageLabels& language)
+		{
+			PageLanguage page;
+			page.Tag = language.Tag;
+			for (const auto& phrases : PhraseTable)
+			{
+				if (phrases.Tag == language.Tag)
+					page.Text = &phrases;
+			}
+
+			// First alternative of a field, from English when the language has none
+			auto first = [&](LabelField field, std::wstring_view fallback) {
+				for (const LanguageLabels* set = &language; set; set = set->Fallback)
+				{
+					if (!set->Labels(field).empty())
+						return *set->Labels(field).begin();
+				}
+				return fallback;
+			};
+			page.Processor = LabelText(first(LabelField::Processor, L"processor"));
+			page.InstalledRam = LabelText(first(LabelField::InstalledRam, L"installed ram"));
+			page.GraphicsCard = LabelText(first(LabelField::GraphicsCard, L"graphics card"));
+			page.DeviceName = LabelText(first(LabelField::DeviceName, L"device name"));
+			page.SystemType = LabelText(first(LabelField::SystemType, L"system type"));
+			page.RamUnit = page.Text ? std::wstring(page.Text->RamUnit) : UnitText(first(LabelField::RamUnits, L"gb"));
+			page.SmallUnit = page.Text ? page.Text->SmallUnit : L"MB";
+			page.MacMemoryUnit = UnitText(first(LabelField::MacMemoryUnits, L"gb"));
+
+			static constexpr std::wstring_view decimalPoint[] = { L"en", L"ja", L"zh", L"ko" };
+			for (auto tag : decimalPoint)
+			{
+				if (language.Tag == tag)
+					page.Decimal = L'.';
+			}
+			return page;
+		}
+
+		// Catalog labels are folded: capitalize them, and write "ram" as "RAM"
+		static std::wstring LabelText(std::wstring_view folded)
+		{
+			std::wstring text{ folded };
+			for (size_t pos = 0; pos < text.size(); pos++)
+			{
+				bool wordStart = pos == 0 || text[pos - 1] == L' ';
+				bool wordEnd = pos + 3 >= text.size() || text[pos + 3] == L' ' || text[pos + 3] == L'-';
+				if (wordStart && wordEnd && text.compare(pos, 3, L"ram") == 0)
+					text.replace(pos, 3, L"RAM");
+			}
+			if (!text.empty())
+				text[0] = Capital(text[0]);
+			return text;
+		}
+
+		// "gb" -> "GB", "go" -> "Go", "gt" -> "Gt"
+		static std::wstring UnitText(std::wstring_view folded)
+		{
+			std::wstring text{ folded };
+			bool spelledOut = text.size() == 2 && (text[1] == L'o' || text[1] == L't');
+			for (size_t i = 0; i < (spelledOut ? 1 : text.size()); i++)
+				text[i] = Capital(text[i]);
+			return text;
+		}
+
+		// Uppercase of the Latin, Greek and Cyrillic lowercase letters the catalog uses, without
+		// the C library, whose answer depends on the locale
+		static wchar_t Capital(wchar_t c)
+		{
+			if ((c >= L'a' && c <= L'z') || (c >= 0xE0 && c <= 0xFE && c != 0xF7) ||
+				(c >= 0x3B1 && c <= 0x3C9 && c != 0x3C2) || (c >= 0x430 && c <= 0x44F))
+				return static_cast<wchar_t>(c - 0x20);
+			if (c >= 0x450 && c <= 0x45F)
+				return static_cast<wchar_t>(c - 0x50);
+			return c;
+		}
+
+		enum class Vendor : uint8_t
+		{
+			Intel,
+			Amd,
+			Nvidia,
+			Qualcomm
+		};
+
+		struct Cpu
+		{
+			std::wstring_view Name;
+			Vendor Maker;
+		};
+
+		static constexpr Cpu Cpus[] = {
+			{ L"Intel(R) Core(TM) i3-7100U CPU @ 2.40GHz   2.40 GHz", Vendor::Intel },
+			{ L"Intel(R) Core(TM) i5-8250U CPU @ 1.60GHz   1.80 GHz", Vendor::Intel },
+			{ L"Intel(R) Core(TM) i7-10750H CPU @ 2.60GHz   2.59 GHz", Vendor::Intel },
+			{ L"11th Gen Intel(R) Core(TM) i7-1165G7 @ 2.80GHz   2.80 GHz", Vendor::Intel },
+			{ L"12th Gen Intel(R) Core(TM) i5-1235U   1.30 GHz", Vendor::Intel },
+			{ L"12th Gen Intel(R) Core(TM) i7-12700H   2.30 GHz", Vendor::Intel },
+			{ L"13th Gen Intel(R) Core(TM) i9-13900K   3.00 GHz", Vendor::Intel },
+			{ L"Intel(R) Core(TM) Ultra 7 155H   1.40 GHz", Vendor::Intel },
+			{ L"Intel(R) Pentium(R) Silver N5000 CPU @ 1.10GHz   1.10 GHz", Vendor::Intel },
+			{ L"Intel(R) Celeron(R) N4020 CPU @ 1.10GHz   1.10 GHz", Vendor::Intel },
+			{ L"Intel(R) Xeon(R) W-2245 CPU @ 3.90GHz   3.91 GHz", Vendor::Intel },
+			{ L"AMD Ryzen 5 3500U with Radeon Vega Mobile Gfx   2.10 GHz", Vendor::Amd },
+			{ L"AMD Ryzen 5 5600X 6-Core Processor   3.70 GHz", Vendor::Amd },
+			{ L"AMD Ryzen 7 5800H with Radeon Graphics   3.20 GHz", Vendor::Amd },
+			{ L"AMD Ryzen 7 7840U w/ Radeon 780M Graphics   3.30 GHz", Vendor::Amd },
+			{ L"AMD Ryzen 9 7950X 16-Core Processor   4.50 GHz", Vendor::Amd },
+			{ L"AMD Athlon Silver 3050U with Radeon Graphics   2.30 GHz", Vendor::Amd },
+			{ L"Snapdragon(R) X Elite - X1E78100 - Qualcomm(R) Oryon(TM) CPU   3.42 GHz", Vendor::Qualcomm },
+			{ L"Snapdragon(R) X Plus - X1P64100 - Qualcomm(R) Oryon(TM) CPU   3.40 GHz", Vendor::Qualcomm },
+			{ L"Snapdragon (TM) 8cx Gen 3 @ 3.0 GHz   2.69 GHz", Vendor::Qualcomm },
+		};
+
+		struct Gpu
+		{
+			std::wstring_view Name;
+			Vendor Maker;
+			uint32_t VramMB;
+		};
+
+		// Integrated GPUs first, grouped by vendor
+		static constexpr Gpu Gpus[] = {
+			{ L"Intel(R) HD Graphics 620", Vendor::Intel, 128 },
+			{ L"Intel(R) UHD Graphics 620", Vendor::Intel, 128 },
+			{ L"Intel(R) UHD Graphics 770", Vendor::Intel, 128 },
+			{ L"Intel(R) Iris(R) Xe Graphics", Vendor::Intel, 128 },
+			{ L"Intel(R) Arc(TM) Graphics", Vendor::Intel, 128 },
+			{ L"AMD Radeon(TM) Graphics", Vendor::Amd, 512 },
+			{ L"AMD Radeon(TM) Vega 8 Graphics", Vendor::Amd, 2048 },
+			{ L"AMD Radeon(TM) 780M Graphics", Vendor::Amd, 512 },
+			{ L"Qualcomm(R) Adreno(TM) X1-85 GPU", Vendor::Qualcomm, 512 },
+			{ L"Qualcomm(R) Adreno(TM) 8cx Gen 3", Vendor::Qualcomm, 512 },
+		};
+
+		static constexpr Gpu DiscreteGpus[] = {
+			{ L"NVIDIA GeForce GT 730", Vendor::Nvidia, 2048 },
+			{ L"NVIDIA GeForce MX450", Vendor::Nvidia, 2048 },
+			{ L"NVIDIA GeForce GTX 1050", Vendor::Nvidia, 2048 },
+			{ L"NVIDIA GeForce GTX 1650", Vendor::Nvidia, 4096 },
+			{ L"NVIDIA GeForce RTX 3050 Ti Laptop GPU", Vendor::Nvidia, 4096 },
+			{ L"NVIDIA GeForce RTX 3060", Vendor::Nvidia, 12288 },
+			{ L"NVIDIA GeForce RTX 4060 Laptop GPU", Vendor::Nvidia, 8192 },
+			{ L"NVIDIA GeForce RTX 4070", Vendor::Nvidia, 12288 },
+			{ L"NVIDIA GeForce RTX 4090", Vendor::Nvidia, 24576 },
+			{ L"AMD Radeon RX 580 Series", Vendor::Amd, 8192 },
+			{ L"AMD Radeon RX 6700 XT", Vendor::Amd, 12288 },
+			{ L"AMD Radeon RX 7900 XTX", Vendor::Amd, 24576 },
+			{ L"Intel(R) Arc(TM) A770 Graphics", Vendor::Intel, 16384 },
+		};
+
+		static constexpr uint32_t RamSizes[] = { 4, 8, 8, 8, 12, 16, 16, 16, 16, 24, 32, 32, 64, 128 };
+
+		static constexpr std::wstring_view Models[] = {
+			L"Vivobook 15", L"ThinkPad T14 Gen 3", L"Inspiron 15 3520", L"OMEN by HP Laptop 16",
+			L"Surface Laptop, 7th Edition", L"Legion 5 15ACH6H", L"ROG Strix G15", L"XPS 13 9340",
+			L"Yoga Slim 7", L"Aspire 5", L"OptiPlex 7090", L"Galaxy Book4 Pro",
+		};
+
+		static constexpr std::wstring_view PersonalNames[] = {
+			L"Marie", L"Lukas", L"Sofia", L"Kenji", L"Olga", L"Ahmet", L"Eva", L"Pierre", L"Anna", L"Mateo",
+		};
+
+		static constexpr std::wstring_view Windows11Editions[] = { L"Windows 11 Home", L"Windows 11 Pro", L"Windows 11 Enterprise" };
+		static constexpr std::wstring_view Windows10Editions[] = { L"Windows 10 Home", L"Windows 10 Pro" };
+		static constexpr std::wstring_view Windows11Versions[] = { L"22H2", L"23H2", L"24H2", L"25H2" };
+		static constexpr std::wstring_view Windows10Versions[] = { L"21H2", L"22H2" };
+		static constexpr uint32_t Windows11Builds[] = { 22621, 22631, 26100, 26200 };
+		static constexpr uint32_t Windows10Builds[] = { 19044, 19045 };
+
+		static constexpr std::wstring_view Alphanumeric = L"ABCDEFGHJKLMNPQRSTUVWXYZ0123456789";
+		static constexpr std::wstring_view Hexadecimal = L"0123456789ABCDEF";
+
+		static void AppendRandom(std::wstring& text, Random& random, std::wstring_view alphabet, size_t count)
+		{
+			for (size_t i = 0; i < count; i++)
+				text += alphabet[random.Below(static_cast<uint32_t>(alphabet.size()))];
+		}
+
+		static void WriteRandom(PageWriter& page, Random& random, std::wstring_view alphabet, size_t count)
+		{
+			for (size_t i = 0; i < count; i++)
+				page.Append(alphabet[random.Below(static_cast<uint32_t>(alphabet.size()))]);
+		}
+
+		void GenerateWindows(Random& random, const PageLanguage& language, PageWriter& page, HardwareInfo& info) const
+		{
+			const Phrases* text = language.Text;
+			bool cards = random.Chance(m_options.HeaderCardShare);
+			bool multiple = cards && text && !text->MultipleGpus.empty() && random.Chance(m_options.MultipleGpuShare);
+
+			// Hardware: a CPU, its vendor's integrated GPU or a discrete one (both when there are several)
+			const Cpu& cpu = random.Pick(Cpus);
+			size_t integratedCount = 0;
+			const Gpu* integrated = nullptr;
+			for (const auto& gpu : Gpus)
+			{
+				if (gpu.Maker == cpu.Maker && random.Below(static_cast<uint32_t>(++integratedCount)) == 0)
+					integrated = &gpu;
+			}
+			bool discrete = cpu.Maker != Vendor::Qualcomm && (multiple || random.Chance(0.5));
+			const Gpu& gpu = discrete ? random.Pick(DiscreteGpus) : *integrated;
+			uint32_t ramTenths = random.Pick(RamSizes) * 10;
+			uint32_t usableTenths = ramTenths - 1 - random.Below(discrete ? 4 : 12);
+			bool arm = cpu.Maker == Vendor::Qualcomm;
+			bool bits32 = !arm && !cards && random.Chance(0.03);
+
+			// Ground truth
+			info.DeviceName.clear();
+			switch (random.Below(3))
+			{
+			case 0:
+				info.DeviceName = L"DESKTOP-";
+				AppendRandom(info.DeviceName, random, Alphanumeric, 7);
+				break;
+			case 1:
+				info.DeviceName = L"LAPTOP-";
+				AppendRandom(info.DeviceName, random, Alphanumeric, 8);
+				break;
+			default:
+				info.DeviceName = random.Pick(PersonalNames);
+				info.DeviceName += L"-PC";
+				break;
+			}
+			info.Processor = cpu.Name;
+			info.RAM.clear();
+			AppendTenths(info.RAM, ramTenths, language.Decimal);
+			info.RAM += L' ';
+			info.RAM += language.RamUnit;
+			info.RamGB = ramTenths / 10.0;
+			info.GPU = multiple ? std::wstring_view(L"[MULTIPLE_GPU]") : gpu.Name;
+
+			// The VRAM shows on the GPU card, or in a row of its own where the language has one
+			info.VRAM.clear();
+			info.VramGB = 0;
+			if (!multiple && (cards || (text && !text->GpuMemory.empty())))
+			{
+				bool gigabytes = gpu.VramMB >= 1024;
+				AppendInteger(info.VRAM, gigabytes ? gpu.VramMB / 1024 : gpu.VramMB);
+				info.VRAM += L' ';
+				info.VRAM += gigabytes ? std::wstring_view(language.RamUnit) : std::wstring_view(language.SmallUnit);
+				info.VramGB = gpu.VramMB / 1024.0;
+			}
+
+			info.SystemType.clear();
+			for (wchar_t c : text ? text->SystemType : std::wstring_view(L"# bit, @"))
+			{
+				if (c == L'#')
+					info.SystemType += bits32 ? L"32" : L"64";
+				else if (c == L'@')
+					info.SystemType += arm ? L"ARM" : L"x64";
+				else
+					info.SystemType += c;
+			}
+
+			// How this page was read: rows as "label  value" lines, or label and value on two lines
+			bool sameLine = random.Chance(0.5);
+
+			// Windows 11 header: device name, model, then the Processor, RAM and GPU cards
+			if (cards)
+			{
+				page.Line(info.DeviceName);
+				page.Line(random.Pick(Models));
+				if (text)
+					page.Line(text->RenamePc);
+				page.Row(language.Processor, cpu.Name, sameLine);
+				page.Row(language.InstalledRam, info.RAM, sameLine);
+				page.Label(language.GraphicsCard, sameLine);
+				if (multiple)
+				{
+					page.Line(text->MultipleGpus);
+				}
+				else if (random.Chance(0.5))
+				{
+					page.Line(info.VRAM);
+					page.Line(gpu.Name);
+				}
+				else
+				{
+					page.Line(gpu.Name);
+					page.Line(info.VRAM);
+				}
+			}
+
+			if (text)
+				page.Line(text->DeviceSpecifications);
+			page.Row(language.DeviceName, info.DeviceName, sameLine);
+			page.Row(language.Processor, cpu.Name, sameLine);
+
+			page.Label(language.InstalledRam, sameLine);
+			page.Append(info.RAM);
+			page.Append(L" (");
+			page.Tenths(usableTenths, language.Decimal);
+			page.Append(L' ');
+			page.Append(language.RamUnit);
+			if (text)
+			{
+				page.Append(L' ');
+				page.Append(text->Usable);
+			}
+			page.Line(L")");
+
+			if (text)
+			{
+				page.Label(text->DeviceId, sameLine);
+				WriteRandom(page, random, Hexadecimal, 8);
+				for (int group = 0; group < 3; group++)
+				{
+					page.Append(L'-');
+					WriteRandom(page, random, Hexadecimal, 4);
+				}
+				page.Append(L'-');
+				WriteRandom(page, random, Hexadecimal, 12);
+				page.EndLine();
+
+				page.Label(text->ProductId, sameLine);
+				for (int group = 0; group < 3; group++)
+				{
+					page.Integer(random.Below(100000), 5);
+					page.Append(L'-');
+				}
+				if (random.Chance(0.5))
+				{
+					page.Line(L"AAOEM");
+				}
+				else
+				{
+					page.Append(L"AA");
+					page.Integer(random.Below(1000), 3);
+					page.EndLine();
+				}
+			}
+			page.Row(language.SystemType, info.SystemType, sameLine);
+			if (text)
+				page.Row(text->PenAndTouch, text->NoPenOrTouch, sameLine);
+
+			// Without the cards the GPU is a row of the list
+			if (!cards)
+			{
+				page.Row(language.GraphicsCard, gpu.Name, sameLine);
+				if (!info.VRAM.empty())
+					page.Row(text->GpuMemory, info.VRAM, sameLine);
+			}
+
+			if (text)
+			{
+				bool windows11 = cards || random.Chance(0.5);
+				page.Line(text->WindowsSpecifications);
+				page.Row(text->Edition, windows11 ? random.Pick(Windows11Editions) : random.Pick(Windows10Editions), sameLine);
+				page.Row(text->Version, windows11 ? random.Pick(Windows11Versions) : random.Pick(Windows10Versions), sameLine);
+				page.Label(text->OsBuild, sameLine);
+				page.Integer(windows11 ? random.Pick(Windows11Builds) : random.Pick(Windows10Builds));
+				page.Append(L'.');
+				page.Integer(random.Below(5000));
+				page.EndLine();
+			}
+		}
+
+		struct MacRelease
+		{
+			std::wstring_view Name;
+			int Major, FirstMinor, LastMinor;
+		};
+
+		static constexpr MacRelease MacReleases[] = {
+			{ L"Mojave", 10, 14, 14 },
+			{ L"Catalina", 10, 15, 15 },
+			{ L"Big Sur", 11, 0, 7 },
+			{ L"Monterey", 12, 0, 7 },
+			{ L"Ventura", 13, 0, 7 },
+			{ L"Sonoma", 14, 0, 7 },
+			{ L"Sequoia", 15, 0, 7 },
+			{ L"Tahoe", 26, 0, 1 },
+		};
+
+		// Releases from Ventura on have the single-column window with "macOS <name> <version>" as a row
+		static constexpr int FirstSingleColumnMajor = 13;
+
+		struct MacModel
+		{
+			std::wstring_view Name, Size;
+			std::wstring_view Chip;            // "M2 Pro", or the Intel processor
+			int Generation;                    // 0 for Intel
+			int Year;
+			uint8_t FirstRelease, LastRelease; // Indexes in MacReleases
+			uint8_t Memory[4];                 // GB, 0 past the last option
+
+			// Intel Macs only
+			uint32_t ClockTenths;
+			std::wstring_view Graphics, MemoryType;
+		};
+
+		static constexpr MacModel MacModels[] = {
+			{ L"MacBook Air", L"", L"M1", 1, 2020, 2, 7, { 8, 16 }, 0, L"", L"" },
+			{ L"MacBook Air", L"13-inch", L"M2", 2, 2022, 3, 7, { 8, 16, 24 }, 0, L"", L"" },
+			{ L"MacBook Air", L"15-inch", L"M2", 2, 2023, 4, 7, { 8, 16, 24 }, 0, L"", L"" },
+			{ L"MacBook Air", L"13-inch", L"M3", 3, 2024, 5, 7, { 8, 16, 24 }, 0, L"", L"" },
+			{ L"MacBook Air", L"13-inch", L"M4", 4, 2025, 6, 7, { 16, 24, 32 }, 0, L"", L"" },
+			{ L"MacBook Pro", L"13-inch", L"M1", 1, 2020, 2, 7, { 8, 16 }, 0, L"", L"" },
+			{ L"MacBook Pro", L"14-inch", L"M1 Pro", 1, 2021, 3, 7, { 16, 32 }, 0, L"", L"" },
+			{ L"MacBook Pro", L"16-inch", L"M1 Max", 1, 2021, 3, 7, { 32, 64 }, 0, L"", L"" },
+			{ L"MacBook Pro", L"14-inch", L"M2 Pro", 2, 2023, 4, 7, { 16, 32 }, 0, L"", L"" },
+			{ L"MacBook Pro", L"16-inch", L"M2 Max", 2, 2023, 4, 7, { 32, 64, 96 }, 0, L"", L"" },
+			{ L"MacBook Pro", L"14-inch", L"M3", 3, 2023, 5, 7, { 8, 16, 24 }, 0, L"", L"" },
+			{ L"MacBook Pro", L"14-inch", L"M3 Pro", 3, 2023, 5, 7, { 18, 36 }, 0, L"", L"" },
+			{ L"MacBook Pro", L"16-inch", L"M3 Max", 3, 2023, 5, 7, { 36, 48, 64, 128 }, 0, L"", L"" },
+			{ L"MacBook Pro", L"14-inch", L"M4 Pro", 4, 2024, 6, 7, { 24, 48 }, 0, L"", L"" },
+			{ L"MacBook Pro", L"16-inch", L"M4 Max", 4, 2024, 6, 7, { 36, 48, 64, 128 }, 0, L"", L"" },
+			{ L"iMac", L"24-inch", L"M1", 1, 2021, 2, 7, { 8, 16 }, 0, L"", L"" },
+			{ L"iMac", L"24-inch", L"M3", 3, 2023, 5, 7, { 8, 16, 24 }, 0, L"", L"" },
+			{ L"iMac", L"24-inch", L"M4", 4, 2024, 6, 7, { 16, 24, 32 }, 0, L"", L"" },
+			{ L"Mac mini", L"", L"M1", 1, 2020, 2, 7, { 8, 16 }, 0, L"", L"" },
+			{ L"Mac mini", L"", L"M2 Pro", 2, 2023, 4, 7, { 16, 32 }, 0, L"", L"" },
+			{ L"Mac mini", L"", L"M4", 4, 2024, 6, 7, { 16, 24, 32 }, 0, L"", L"" },
+			{ L"Mac Studio", L"", L"M1 Max", 1, 2022, 3, 7, { 32, 64 }, 0, L"", L"" },
+			{ L"Mac Studio", L"", L"M2 Ultra", 2, 2023, 4, 7, { 64, 128, 192 }, 0, L"", L"" },
+			{ L"Mac Pro", L"", L"M2 Ultra", 2, 2023, 4, 7, { 64, 128, 192 }, 0, L"", L"" },
+			{ L"MacBook Pro", L"13-inch", L"Quad-Core Intel Core i5", 0, 2020, 1, 6, { 8, 16, 32 },
+				20, L"Intel Iris Plus Graphics 1536 MB", L"3733 MHz LPDDR4X" },
+			{ L"MacBook Pro", L"16-inch", L"6-Core Intel Core i7", 0, 2019, 1, 5, { 16, 32, 64 },
+				26, L"AMD Radeon Pro 5300M 4 GB", L"2667 MHz DDR4" },
+			{ L"MacBook Air", L"Retina, 13-inch", L"Dual-Core Intel Core i3", 0, 2020, 1, 5, { 8, 16 },
+				11, L"Intel Iris Plus Graphics 1536 MB", L"3733 MHz LPDDR4X" },
+			{ L"iMac", L"Retina 5K, 27-inch", L"6-Core Intel Core i5", 0, 2020, 1, 6, { 8, 16, 32, 64 },
+				31, L"AMD Radeon Pro 5300 4 GB", L"2667 MHz DDR4" },
+			{ L"Mac mini", L"", L"6-Core Intel Core i7", 0, 2018, 0, 6, { 8, 16, 32, 64 },
+				32, L"Intel UHD Graphics 630 1536 MB", L"2667 MHz DDR4" },
+		};
+
+		void GenerateMac(Random& random, const PageLanguage& language, PageWriter& page, MacOSHardwareInfo& info) const
+		{
+			// The window is in English where the corpus has no phrases for the language;
+			// only the memory unit then comes from the catalog
+			const Phrases& text = language.Text ? *language.Text : PhraseTable[0];
+			const MacModel& model = random.Pick(MacModels);
+			const MacRelease& release = MacReleases[model.FirstRelease + random.Below(model.LastRelease - model.FirstRelease + 1u)];
+
+			size_t memoryOptions = 0;
+			while (memoryOptions < 4 && model.Memory[memoryOptions] != 0)
+				memoryOptions++;
+			uint32_t memoryGB = model.Memory[random.Below(static_cast<uint32_t>(memoryOptions))];
+
+			int minor = release.FirstMinor + static_cast<int>(random.Below(release.LastMinor - release.FirstMinor + 1u));
+			uint32_t patch = release.Major == 10 ? 1 + random.Below(7) : random.Below(8);
+
+			// Ground truth
+			info.DeviceName = model.Name;
+			info.DeviceYear.clear();
+			AppendInteger(info.DeviceYear, model.Year);
+			info.ChipGeneration = model.Generation;
+			info.IsAppleSilicon = model.Generation > 0;
+			info.IsIntelMac = !info.IsAppleSilicon;
+			if (info.IsAppleSilicon)
+			{
+				info.Chip = L"Apple ";
+				info.Chip += model.Chip;
+			}
+			else
+			{
+				info.Chip = model.Chip.substr(model.Chip.find(L"Intel"));
+			}
+			info.Memory.clear();
+			AppendInteger(info.Memory, memoryGB);
+			info.Memory += L' ';
+			info.Memory += language.MacMemoryUnit;
+			info.MemoryGB = memoryGB;
+			info.MacOSVersion = release.Name;
+			info.MacOSVersion += L' ';
+			AppendInteger(info.MacOSVersion, release.Major);
+			info.MacOSVersion += L'.';
+			AppendInteger(info.MacOSVersion, minor);
+			if (patch > 0)
+			{
+				info.MacOSVersion += L'.';
+				AppendInteger(info.MacOSVersion, patch);
+			}
+			info.MacOSMajorVersion = release.Major;
+
+			bool sameLine = random.Chance(0.5);
+			bool singleColumn = release.Major >= FirstSingleColumnMajor;
+
+			// Older releases put "macOS <name>" and its version above the model,
+			// which is followed by "(<size>, <chip>, <year>)"
+			if (!singleColumn)
+			{
+				page.Append(L"macOS ");
+				page.Line(release.Name);
+				page.Label(L"Version", true);
+				page.Line(std::wstring_view(info.MacOSVersion).substr(release.Name.size() + 1));
+				page.Append(model.Name);
+				page.Append(L" (");
+			}
+			else
+			{
+				page.Line(model.Name);
+			}
+
+			// The subtitle names the chip only for the plain M1 to M4 ("13-inch, M2, 2022")
+			if (!model.Size.empty())
+			{
+				page.Append(model.Size);
+				page.Append(L", ");
+			}
+			if (info.IsAppleSilicon && model.Chip.find(L' ') == std::wstring_view::npos)
+			{
+				page.Append(model.Chip);
+				page.Append(L", ");
+			}
+			page.Append(info.DeviceYear);
+			if (!singleColumn)
+				page.Append(L')');
+			page.EndLine();
+
+			if (info.IsAppleSilicon)
+			{
+				page.Row(text.Chip, info.Chip, sameLine);
+			}
+			else
+			{
+				page.Label(text.Processor, sameLine);
+				page.Tenths(model.ClockTenths, language.Decimal);
+				page.Append(L" GHz ");
+				page.Line(model.Chip);
+				page.Row(text.Graphics, model.Graphics, sameLine);
+			}
+
+			page.Label(text.Memory, sameLine);
+			page.Append(info.Memory);
+			if (!model.MemoryType.empty())
+			{
+				page.Append(L' ');
+				page.Append(model.MemoryType);
+			}
+			page.EndLine();
+
+			page.Row(text.StartupDisk, L"Macintosh HD", sameLine);
+			page.Label(text.SerialNumber, sameLine);
+			WriteRandom(page, random, Alphanumeric, 10);
+			page.EndLine();
+
+			if (singleColumn)
+			{
+				page.Row(L"macOS", info.MacOSVersion, sameLine);
+				page.Line(text.MoreInfo);
+			}
+		}
+
+		static bool Differs(std::wstring_view truth, std::wstring_view parsed)
+		{
+			return truth != parsed;
+		}
+
+		static bool Differs(double truth, double parsed)
+		{
+			return truth - parsed > 0.01 || parsed - truth > 0.01;
+		}
+
+		Options m_options;
+		std::shared_ptr<const LabelCatalog> m_catalog;
+		std::vector<PageLanguage> m_languages;
+		uint64_t m_confusion = 0;
+		uint64_t m_merge = 0;
+		uint64_t m_drop = 0;
+	};
+}
@@ -0,0 +1,621 @@
+#pragma once
+#include "pch.h"
+#include "MacOSHardwareInfo.h"
+#include "MappedFile.h"
+#include "QuantityParser.h"
+#include "Tracing.h"
+#include "Utf8.h"
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+namespace HardwareAnalyzer
+{
+	// MacOSHardwareInfo from what macOS reports about itself, for users who can run a command
+	// instead of taking a screenshot:
+	//   - system_profiler -json SPHardwareDataType SPSoftwareDataType
+	//   - system_profiler -xml (an XML plist) and its plain text output
+	//   - sw_vers ("ProductName: macOS", "ProductVersion: 14.1.1")
+	// The values are exact ("chip_type" : "Apple M2 Pro", "physical_memory" : "16 GB",
+	// "os_version" : "macOS 14.1.1 (23B81)"), so none of the OCR fixes are involved.
+	//
+	// The text is read in one forward pass without building a tree: keys are compared where
+	// they are and only the values of the few keys used are decoded. An MDM export can hold
+	// many Macs; one Mac is
+	//   - JSON: the object holding the SP...DataType keys
+	//   - plist: the array holding the dicts with a _dataType
+	//   - text: the lines until a field repeats
+	//   - otherwise each top-level document.
+	// Binary plists aren't read; "plutil -convert xml1" turns them into XML.
+	class SystemProfilerParser
+	{
+	public:
+		enum class Format : uint8_t
+		{
+			Unknown,
+			Json,
+			Plist,
+			Text,
+		};
+
+		static constexpr size_t MaxDepth = 64;
+		static constexpr size_t MaxValue = 1024;
+
+		explicit SystemProfilerParser(std::string_view text)
+			: m_text(text)
+		{
+			if (m_text.substr(0, 3) == "\xEF\xBB\xBF")
+				m_position = 3;
+			while (m_position < m_text.size() && IsSpace(m_text[m_position]))
+				m_position++;
+
+			if (m_position == m_text.size() || m_text.substr(m_position, 6) == "bplist")
+				m_format = Format::Unknown;
+			else if (m_text[m_position] == '{' || m_text[m_position] == '[')
+				m_format = Format::Json;
+			else if (m_text[m_position] == '<')
+				m_format = Format::Plist;
+			else
+				m_format = Format::Text;
+		}
+
+		Format DetectedFormat() const { return m_format; }
+
+		// The next Mac of the text into info, cleared first; false once there are no more
+		bool Next(MacOSHardwareInfo& info)
+		{
+			info = MacOSHardwareInfo{};
+			m_productName.clear();
+			return Scan(info, true);
+		}
+
+		// Every field of text goes into info however many Macs it holds, so a sw_vers output
+		// can complete a report parsed before. Unknown when text is none of the formats.
+		static Format Parse(std::string_view text, MacOSHardwareInfo& info)
+		{
+			TraceSpan span{ "SystemProfilerParser" };
+			SystemProfilerParser parser(text);
+			parser.Scan(info, false);
+			return parser.m_format;
+		}
+
+		// Calls function(const MacOSHardwareInfo&) for each Mac of text; returns how many
+		template <typename Function>
+		static size_t ForEachMac(std::string_view text, Function&& function)
+		{
+			TraceSpan span{ "SystemProfilerParser" };
+			SystemProfilerParser parser(text);
+			MacOSHardwareInfo info;
+			size_t count = 0;
+			while (parser.Next(info))
+			{
+				function(static_cast<const MacOSHardwareInfo&>(info));
+				count++;
+			}
+			return count;
+		}
+
+		// The file is mapped rather than read, exports can be large; 0 when it can't be opened
+		template <typename Function>
+		static size_t ForEachMacInFile(const std::filesystem::path& path, Function&& function)
+		{
+			std::optional<MappedFile> file = MappedFile::Open(path);
+			if (!file)
+				return 0;
+			return ForEachMac(std::string_view(reinterpret_cast<const char*>(file->Data()), file->Size()), function);
+		}
+
+		// The inside of a JSON string back to UTF-8: \" \\ \/ \b \f \n \r \t and \uXXXX,
+		// surrogate pairs included
+		static std::string Unescape(std::string_view raw)
+		{
+			std::string text;
+			text.reserve(raw.size());
+			for (size_t i = 0; i < raw.size(); i++)
+			{
+				if (raw[i] != '\\' || i + 1 == raw.size())
+				{
+					text += raw[i];
+					continue;
+				}
+				char escape = raw[++i];
+				switch (escape)
+				{
+				case 'b': text += '\b'; break;
+				case 'f': text += '\f'; break;
+				case 'n': text += '\n'; break;
+				case 'r': text += '\r'; break;
+				case 't': text += '\t'; break;
+				case 'u':
+				{
+					uint32_t c = 0;
+					if (!Hex4(raw, i + 1, c))
+						break;
+					i += 4;
+					uint32_t low = 0;
+					if (c >= 0xD800 && c < 0xDC00 && raw.substr(i + 1, 2) == "\\u" && Hex4(raw, i + 3, low) && low >= 0xDC00 && low < 0xE000)
+					{
+						c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+						i += 6;
+					}
+					else if (c >= 0xD800 && c < 0xE000)
+					{
+						c = 0xFFFD;
+					}
+					AppendUtf8(text, c);
+					break;
+				}
+				default:
+					text += escape;
+					break;
+				}
+			}
+			return text;
+		}
+
+	private:
+		enum class Key : uint8_t
+		{
+			None,
+			ModelName,
+			Chip,
+			Processor,
+			Memory,
+			SystemVersion,
+			ProductName,
+			ProductVersion,
+		};
+
+		std::string_view m_text;
+		size_t m_position = 0;
+		Format m_format = Format::Unknown;
+
+		// JSON and plist
+		char m_containers[MaxDepth] = {};
+		size_t m_depth = 0;
+		size_t m_macDepth = 0;           // Depth of the container that is one Mac, 0 until known
+		bool m_expectKey = false;
+		std::string_view m_key;
+
+		// Fields of the current Mac, a bit per Key
+		uint32_t m_seen = 0;
+		std::wstring m_productName;
+
+		bool Scan(MacOSHardwareInfo& info, bool stopAtMac)
+		{
+			switch (m_format)
+			{
+			case Format::Json:
+				if (ScanJson(info, stopAtMac))
+					return true;
+				break;
+			case Format::Plist:
+				if (ScanPlist(info, stopAtMac))
+					return true;
+				break;
+			case Format::Text:
+				if (ScanText(info, stopAtMac))
+					return true;
+				break;
+			default:
+				break;
+			}
+			// A truncated last Mac still counts
+			return std::exchange(m_seen, 0) != 0;
+		}
+
+		bool ScanJson(MacOSHardwareInfo& info, bool stopAtMac)
+		{
+			while (m_position < m_text.size())
+			{
+				char c = m_text[m_position++];
+				if (c == '{' || c == '[')
+				{
+					if (m_depth == MaxDepth)
+					{
+						m_position = m_text.size();
+						break;
+					}
+					m_containers[m_depth++] = c;
+					m_expectKey = c == '{';
+					m_key = {};
+				}
+				else if (c == '}' || c == ']')
+				{
+					m_expectKey = false;
+					m_key = {};
+					if (m_depth > 0 && EndContainer(stopAtMac))
+						return true;
+				}
+				else if (c == ',')
+				{
+					m_expectKey = m_depth > 0 && m_containers[m_depth - 1] == '{';
+					m_key = {};
+				}
+				else if (c == '"')
+				{
+					std::string_view raw = JsonString();
+					if (m_expectKey)
+					{
+						m_expectKey = false;
+						m_key = raw;
+						if (m_macDepth == 0 && raw.size() > 10 && raw.substr(0, 2) == "SP" && raw.substr(raw.size() - 8) == "DataType")
+							m_macDepth = m_depth;
+					}
+					else if (!m_key.empty())
+					{
+						Key key = JsonKey(m_key);
+						m_key = {};
+						if (key != Key::None)
+							Field(info, key, raw.find('\\') == std::string_view::npos ? Utf8::Decode(raw) : Utf8::Decode(Unescape(raw)));
+					}
+				}
+			}
+			return false;
+		}
+
+		// The string whose opening quote was just read, escapes left in
+		std::string_view JsonString()
+		{
+			size_t start = m_position;
+			size_t end = start;
+			for (;;)
+			{
+				const char* quote = static_cast<const char*>(std::memchr(m_text.data() + end, '"', m_text.size() - end));
+				if (!quote)
+				{
+					m_position = m_text.size();
+					return m_text.substr(start);
+				}
+				end = static_cast<size_t>(quote - m_text.data());
+				size_t backslashes = 0;
+				while (end - backslashes > start && m_text[end - backslashes - 1] == '\\')
+					backslashes++;
+				if (backslashes % 2 == 0)
+					break;
+				end++;
+			}
+			m_position = end + 1;
+			return m_text.substr(start, end - start);
+		}
+
+		bool ScanPlist(MacOSHardwareInfo& info, bool stopAtMac)
+		{
+			while (m_position < m_text.size())
+			{
+				const char* open = static_cast<const char*>(std::memchr(m_text.data() + m_position, '<', m_text.size() - m_position));
+				if (!open)
+					break;
+				size_t tagStart = static_cast<size_t>(open - m_text.data()) + 1;
+				if (m_text.substr(tagStart, 3) == "!--")
+				{
+					size_t end = m_text.find("-->", tagStart + 3);
+					m_position = end == std::string_view::npos ? m_text.size() : end + 3;
+					continue;
+				}
+				const char* close = static_cast<const char*>(std::memchr(m_text.data() + tagStart, '>', m_text.size() - tagStart));
+				if (!close)
+					break;
+				std::string_view tag = m_text.substr(tagStart, static_cast<size_t>(close - m_text.data()) - tagStart);
+				m_position = tagStart + tag.size() + 1;
+
+				// <?xml ...?>, <!DOCTYPE ...>, <plist version="1.0">
+				if (tag.empty() || tag[0] == '?' || tag[0] == '!')
+					continue;
+				bool closing = tag[0] == '/';
+				bool empty = tag.back() == '/';
+				std::string_view name = tag.substr(closing ? 1 : 0);
+				name = name.substr(0, name.find_first_of(" \t\r\n/"));
+
+				if (name == "dict" || name == "array")
+				{
+					m_key = {};
+					if (closing)
+					{
+						if (m_depth > 0 && EndContainer(stopAtMac))
+							return true;
+					}
+					else if (!empty)
+					{
+						if (m_depth == MaxDepth)
+							break;
+						m_containers[m_depth++] = name[0];
+					}
+					continue;
+				}
+				if (closing || name == "plist")
+					continue;
+
+				// <key>, <string>, <integer>, ... hold text only; <true/> and <string/> none
+				std::string_view text;
+				if (!empty)
+				{
+					const char* end = static_cast<const char*>(std::memchr(m_text.data() + m_position, '<', m_text.size() - m_position));
+					size_t textEnd = end ? static_cast<size_t>(end - m_text.data()) : m_text.size();
+					text = m_text.substr(m_position, textEnd - m_position);
+					m_position = textEnd;
+				}
+
+				if (name == "key")
+				{
+					m_key = text;
+					continue;
+				}
+				std::string_view key = std::exchange(m_key, {});
+				if (key == "_dataType" && m_macDepth == 0 && text.substr(0, 2) == "SP")
+				{
+					// The dict describes one data type; the array around it is the Mac
+					m_macDepth = m_depth > 1 ? m_depth - 1 : m_depth;
+					continue;
+				}
+				Key field = JsonKey(key);
+				if (field != Key::None && name == "string")
+					Field(info, field, text.find('&') == std::string_view::npos ? Utf8::Decode(text) : Utf8::Decode(DecodeEntities(text)));
+			}
+			m_position = m_text.size();
+			return false;
+		}
+
+		bool ScanText(MacOSHardwareInfo& info, bool stopAtMac)
+		{
+			while (m_position < m_text.size())
+			{
+				size_t lineStart = m_position;
+				const char* newline = static_cast<const char*>(std::memchr(m_text.data() + m_position, '\n', m_text.size() - m_position));
+				size_t lineEnd = newline ? static_cast<size_t>(newline - m_text.data()) : m_text.size();
+				m_position = newline ? lineEnd + 1 : lineEnd;
+
+				// "      Chip: Apple M2 Pro", "ProductVersion:\t\t14.1.1"
+				std::string_view line = m_text.substr(lineStart, lineEnd - lineStart);
+				size_t colon = line.find(':');
+				if (colon == std::string_view::npos)
+					continue;
+				Key key = TextKey(Trim(line.substr(0, colon)));
+				if (key == Key::None)
+					continue;
+				if (stopAtMac && (m_seen & (1u << static_cast<int>(key))) != 0)
+				{
+					// A field the current Mac already has: this line starts the next one
+					m_position = lineStart;
+					m_seen = 0;
+					return true;
+				}
+				Field(info, key, Utf8::Decode(Trim(line.substr(colon + 1))));
+			}
+			return false;
+		}
+
+		// A dict, array or object closed; true when that ends a Mac to hand out
+		bool EndContainer(bool stopAtMac)
+		{
+			m_depth--;
+			bool end = m_macDepth != 0 ? m_depth < m_macDepth : m_depth == 0;
+			if (!end)
+				return false;
+			m_macDepth = 0;
+			m_expectKey = false;
+			bool found = std::exchange(m_seen, 0) != 0;
+			return stopAtMac && found;
+		}
+
+		void Field(MacOSHardwareInfo& info, Key key, std::wstring value)
+		{
+			m_seen |= 1u << static_cast<int>(key);
+			if (value.size() > MaxValue)
+				value.resize(MaxValue);
+
+			switch (key)
+			{
+			case Key::ModelName:
+				info.DeviceName = std::move(value);
+				break;
+			case Key::Chip:
+				SetChip(info, std::move(value));
+				break;
+			case Key::Processor:
+				// Intel Macs name their CPU here and have no chip_type
+				if (!info.IsAppleSilicon)
+					SetChip(info, std::move(value));
+				break;
+			case Key::Memory:
+			{
+				uint64_t bytes = 0;
+				info.MemoryGB = QuantityParser::Parse(value, bytes) ? QuantityParser::ToGB(bytes) : 0;
+				info.Memory = std::move(value);
+				break;
+			}
+			case Key::SystemVersion:
+				// "macOS 14.1.1 (23B81)", "Mac OS X 10.15.7 (19H2)"
+				info.MacOSMajorVersion = MajorVersion(value);
+				info.MacOSVersion = std::move(value);
+				break;
+			case Key::ProductName:
+				m_productName = std::move(value);
+				break;
+			case Key::ProductVersion:
+				info.MacOSMajorVersion = MajorVersion(value);
+				info.MacOSVersion = m_productName.empty() ? L"macOS" : m_productName;
+				info.MacOSVersion += L' ';
+				info.MacOSVersion += value;
+				break;
+			default:
+				break;
+			}
+		}
+
+		static void SetChip(MacOSHardwareInfo& info, std::wstring chip)
+		{
+			// "Apple M2 Pro"; "Quad-Core Intel Core i7" for Intel
+			std::wstring_view prefix = L"Apple M";
+			size_t digitsEnd = OcrTextScanner::SkipDigits(chip, prefix.size());
+			info.IsAppleSilicon = chip.compare(0, prefix.size(), prefix) == 0 && digitsEnd > prefix.size();
+			info.IsIntelMac = !info.IsAppleSilicon && chip.find(L"Intel") != std::wstring::npos;
+			info.ChipGeneration = 0;
+			if (info.IsAppleSilicon)
+				QuantityParser::ParseInteger(std::wstring_view(chip).substr(prefix.size(), digitsEnd - prefix.size()), info.ChipGeneration);
+			info.Chip = std::move(chip);
+		}
+
+		// The first number of the text
+		static int MajorVersion(std::wstring_view version)
+		{
+			size_t start = 0;
+			while (start < version.size() && !OcrTextScanner::IsDigit(version[start]))
+				start++;
+			size_t end = OcrTextScanner::SkipDigits(version, start);
+			int major = 0;
+			if (end == start || !QuantityParser::ParseInteger(version.substr(start, end - start), major))
+				return 0;
+			return major;
+		}
+
+		// Keys of system_profiler -json and -xml
+		static Key JsonKey(std::string_view key)
+		{
+			if (key.size() < 8)
+				return Key::None;
+			if (key == "machine_name")
+				return Key::ModelName;
+			if (key == "chip_type")
+				return Key::Chip;
+			if (key == "cpu_type")
+				return Key::Processor;
+			if (key == "physical_memory")
+				return Key::Memory;
+			if (key == "os_version")
+				return Key::SystemVersion;
+			return Key::None;
+		}
+
+		// Labels of system_profiler's text output and of sw_vers
+		static Key TextKey(std::string_view label)
+		{
+			if (label == "Model Name")
+				return Key::ModelName;
+			if (label == "Chip")
+				return Key::Chip;
+			if (label == "Processor Name")
+				return Key::Processor;
+			if (label == "Memory")
+				return Key::Memory;
+			if (label == "System Version")
+				return Key::SystemVersion;
+			if (label == "ProductName")
+				return Key::ProductName;
+			if (label == "ProductVersion")
+				return Key::ProductVersion;
+			return Key::None;
+		}
+
+		static bool Hex4(std::string_view raw, size_t at, uint32_t& value)
+		{
+			if (at + 4 > raw.size())
+				return false;
+			value = 0;
+			for (size_t k = 0; k < 4; k++)
+			{
+				char c = raw[at + k];
+				char lower = static_cast<char>(c | 0x20);
+				if (c >= '0' && c <= '9')
+					value = value * 16 + static_cast<uint32_t>(c - '0');
+				else if (lower >= 'a' && lower <= 'f')
+					value = value * 16 + static_cast<uint32_t>(lower - 'a' + 10);
+				else
+					return false;
+			}
+			return true;
+		}
+
+		static void AppendUtf8(std::string& text, uint32_t c)
+		{
+			if (c < 0x80)
+			{
+				text += static_cast<char>(c);
+			}
+			else if (c < 0x800)
+			{
+				text += static_cast<char>(0xC0 | (c >> 6));
+				text += static_cast<char>(0x80 | (c & 0x3F));
+			}
+			else if (c < 0x10000)
+			{
+				text += static_cast<char>(0xE0 | (c >> 12));
+				text += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+				text += static_cast<char>(0x80 | (c & 0x3F));
+			}
+			else
+			{
+				text += static_cast<char>(0xF0 | (c >> 18));
+				text += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+				text += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+				text += static_cast<char>(0x80 | (c & 0x3F));
+			}
+		}
+
+		// &amp; &lt; &gt; &quot; &apos; and numeric references
+		static std::string DecodeEntities(std::string_view text)
+		{
+			std::string decoded;
+			decoded.reserve(text.size());
+			for (size_t i = 0; i < text.size(); i++)
+			{
+				size_t semicolon = text[i] == '&' ? text.find(';', i) : std::string_view::npos;
+				if (semicolon == std::string_view::npos || semicolon - i > 10)
+				{
+					decoded += text[i];
+					continue;
+				}
+				std::string_view entity = text.substr(i + 1, semicolon - i - 1);
+				uint32_t c = 0;
+				if (entity == "amp")
+					c = '&';
+				else if (entity == "lt")
+					c = '<';
+				else if (entity == "gt")
+					c = '>';
+				else if (entity == "quot")
+					c = '"';
+				else if (entity == "apos")
+					c = '\'';
+				else if (entity.size() > 1 && entity[0] == '#')
+				{
+					bool hex = entity[1] == 'x' || entity[1] == 'X';
+					std::string_view digits = entity.substr(hex ? 2 : 1);
+					auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), c, hex ? 16 : 10);
+					if (error != std::errc{} || end != digits.data() + digits.size() || c == 0 || c > 0x10FFFF || (c >= 0xD800 && c < 0xE000))
+						c = 0xFFFD;
+				}
+				if (c == 0)
+				{
+					decoded += text[i];
+					continue;
+				}
+				AppendUtf8(decoded, c);
+				i = semicolon;
+			}
+			return decoded;
+		}
+
+		static std::string_view Trim(std::string_view text)
+		{
+			size_t start = 0;
+			while (start < text.size() && IsSpace(text[start]))
+				start++;
+			size_t end = text.size();
+			while (end > start && IsSpace(text[end - 1]))
+				end--;
+			return text.substr(start, end - start);
+		}
+
+		static bool IsSpace(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+		}
+	};
+}
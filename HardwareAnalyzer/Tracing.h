@@ -0,0 +1,238 @@
+#pragma once
+#include "pch.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace HardwareAnalyzer
+{
+	struct TraceEvent
+	{
+		const char* Name = nullptr;       // Must be a string literal (stored as-is)
+		const char* Category = nullptr;
+		uint64_t StartNs = 0;
+		uint64_t DurationNs = 0;
+		uint32_t ThreadId = 0;
+	};
+
+	// Lightweight span recorder. Each thread appends completed spans to its own
+	// fixed-size ring buffer (oldest events are overwritten), timestamps come from
+	// the monotonic clock, and a disabled tracer costs one relaxed atomic load per span.
+	// The buffers can be exported at any time as Chrome trace JSON, which both
+	// chrome://tracing and ui.perfetto.dev open directly.
+	class Tracer
+	{
+	public:
+		static constexpr size_t RingCapacity = 4096;
+
+		static void Enable(bool enabled)
+		{
+			State().Enabled.store(enabled, std::memory_order_relaxed);
+		}
+
+		static bool IsEnabled()
+		{
+			return State().Enabled.load(std::memory_order_relaxed);
+		}
+
+		// Nanoseconds since the tracer was first used
+		static uint64_t NowNs()
+		{
+			auto elapsed = std::chrono::steady_clock::now() - State().Epoch;
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+		}
+
+		static uint32_t CurrentThreadId()
+		{
+			return LocalBuffer().ThreadId;
+		}
+
+		static void Record(const char* name, const char* category, uint64_t startNs, uint64_t endNs, uint32_t threadId)
+		{
+			ThreadBuffer& buffer = LocalBuffer();
+			std::lock_guard<std::mutex> lock(buffer.Lock);   // Only contended while exporting
+			TraceEvent& slot = buffer.Events[buffer.Count % RingCapacity];
+			slot.Name = name;
+			slot.Category = category;
+			slot.StartNs = startNs;
+			slot.DurationNs = endNs > startNs ? endNs - startNs : 0;
+			slot.ThreadId = threadId;
+			buffer.Count++;
+		}
+
+		static void Clear()
+		{
+			for (const auto& buffer : Buffers())
+			{
+				std::lock_guard<std::mutex> lock(buffer->Lock);
+				buffer->Count = 0;
+			}
+		}
+
+		// Snapshot of every thread's buffer, oldest events first per thread
+		static std::vector<TraceEvent> Snapshot()
+		{
+			std::vector<TraceEvent> events;
+			for (const auto& buffer : Buffers())
+			{
+				std::lock_guard<std::mutex> lock(buffer->Lock);
+				uint64_t first = buffer->Count > RingCapacity ? buffer->Count - RingCapacity : 0;
+				for (uint64_t i = first; i < buffer->Count; i++)
+				{
+					events.push_back(buffer->Events[i % RingCapacity]);
+				}
+			}
+			return events;
+		}
+
+		static std::string ToChromeTraceJson()
+		{
+			std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+			bool first = true;
+			for (const auto& event : Snapshot())
+			{
+				if (!first)
+					json += ',';
+				first = false;
+
+				json += "{\"name\":\"";
+				AppendEscaped(json, event.Name);
+				json += "\",\"cat\":\"";
+				AppendEscaped(json, event.Category);
+				json += "\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+				json += std::to_string(event.ThreadId);
+
+				json += ",\"ts\":";
+				AppendMicroseconds(json, event.StartNs);
+				json += ",\"dur\":";
+				AppendMicroseconds(json, event.DurationNs);
+				json += '}';
+			}
+			json += "]}";
+			return json;
+		}
+
+		static bool WriteChromeTrace(const std::filesystem::path& path)
+		{
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			if (!file)
+				return false;
+			std::string json = ToChromeTraceJson();
+			file.write(json.data(), static_cast<std::streamsize>(json.size()));
+			return static_cast<bool>(file);
+		}
+
+	private:
+		struct ThreadBuffer
+		{
+			std::mutex Lock;
+			std::array<TraceEvent, RingCapacity> Events;
+			uint64_t Count = 0;
+			uint32_t ThreadId = 0;
+		};
+
+		struct GlobalState
+		{
+			std::atomic<bool> Enabled{ false };
+			std::chrono::steady_clock::time_point Epoch = std::chrono::steady_clock::now();
+			std::mutex RegistryLock;
+			std::vector<std::shared_ptr<ThreadBuffer>> Buffers;
+			uint32_t NextThreadId = 1;
+		};
+
+		static GlobalState& State()
+		{
+			static GlobalState state;
+			return state;
+		}
+
+		// The registry keeps buffers alive after their thread exits so late dumps still see them
+		static ThreadBuffer& LocalBuffer()
+		{
+			thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+				auto created = std::make_shared<ThreadBuffer>();
+				GlobalState& state = State();
+				std::lock_guard<std::mutex> lock(state.RegistryLock);
+				created->ThreadId = state.NextThreadId++;
+				state.Buffers.push_back(created);
+				return created;
+			}();
+			return *buffer;
+		}
+
+		static std::vector<std::shared_ptr<ThreadBuffer>> Buffers()
+		{
+			GlobalState& state = State();
+			std::lock_guard<std::mutex> lock(state.RegistryLock);
+			return state.Buffers;
+		}
+
+		// Chrome trace timestamps are microseconds; formatted by hand to stay locale-independent
+		static void AppendMicroseconds(std::string& json, uint64_t ns)
+		{
+			std::string fraction = std::to_string(ns % 1000);
+			json += std::to_string(ns / 1000);
+			json += '.';
+			json.append(3 - fraction.size(), '0');
+			json += fraction;
+		}
+
+		static void AppendEscaped(std::string& json, const char* text)
+		{
+			for (const char* c = text ? text : ""; *c; c++)
+			{
+				if (*c == '"' || *c == '\\')
+					json += '\\';
+				json += *c;
+			}
+		}
+	};
+
+	// Records the time between construction and End() (or destruction) as one span.
+	// Safe to hold across co_await: the span keeps the id of the thread it started on.
+	class TraceSpan
+	{
+	public:
+		explicit TraceSpan(const char* name, const char* category = "engine")
+			: m_name(name), m_category(category)
+		{
+			if (Tracer::IsEnabled())
+			{
+				m_active = true;
+				m_threadId = Tracer::CurrentThreadId();
+				m_startNs = Tracer::NowNs();
+			}
+		}
+
+		~TraceSpan()
+		{
+			End();
+		}
+
+		TraceSpan(const TraceSpan&) = delete;
+		TraceSpan& operator=(const TraceSpan&) = delete;
+
+		void End()
+		{
+			if (m_active)
+			{
+				m_active = false;
+				Tracer::Record(m_name, m_category, m_startNs, Tracer::NowNs(), m_threadId);
+			}
+		}
+
+	private:
+		const char* m_name;
+		const char* m_category;
+		uint64_t m_startNs = 0;
+		uint32_t m_threadId = 0;
+		bool m_active = false;
+	};
+}
@@ -0,0 +1,171 @@
+#pragma once
+#include "pch.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace HardwareAnalyzer
+{
+	// UTF-8 <-> wchar_t for text crossing the process boundary (sockets, C callers, files).
+	// wchar_t is UTF-16 on Windows and UTF-32 elsewhere; both are handled. Malformed input
+	// becomes U+FFFD instead of failing, like the OCR text it usually carries.
+	class Utf8
+	{
+	public:
+		static std::wstring Decode(std::string_view text)
+		{
+			std::wstring result;
+			Decode(text, result);
+			return result;
+		}
+
+		// Into 'out', reusing its capacity
+		static void Decode(std::string_view text, std::wstring& out)
+		{
+			out.clear();
+			out.reserve(text.size());
+			size_t i = 0;
+			while (i < text.size())
+			{
+				AppendCodePoint(out, Next(text, i));
+			}
+		}
+
+		// Offset in 'text' of the bytes Decode turns into its 'units'-th code unit (text.size()
+		// past the end), so a position found in the decoded text can be pointed at in the input
+		static size_t ByteOffset(std::string_view text, size_t units)
+		{
+			size_t i = 0;
+			while (i < text.size())
+			{
+				size_t next = i;
+				uint32_t c = Next(text, next);
+				size_t width = sizeof(wchar_t) == 2 && c >= 0x10000 ? 2 : 1;
+				if (units < width)
+					return i;
+				units -= width;
+				i = next;
+			}
+			return text.size();
+		}
+
+		static std::string Encode(std::wstring_view text)
+		{
+			std::string result;
+			Append(result, text);
+			return result;
+		}
+
+		static void Append(std::string& out, std::wstring_view text)
+		{
+			out.reserve(out.size() + text.size());
+			for (size_t i = 0; i < text.size(); i++)
+			{
+				uint32_t c = static_cast<uint32_t>(text[i]);
+				if constexpr (sizeof(wchar_t) == 2)
+				{
+					if (c >= 0xD800 && c <= 0xDBFF && i + 1 < text.size())
+					{
+						uint32_t low = static_cast<uint32_t>(text[i + 1]);
+						if (low >= 0xDC00 && low <= 0xDFFF)
+						{
+							c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+							i++;
+						}
+					}
+				}
+				if ((c >= 0xD800 && c <= 0xDFFF) || c > 0x10FFFF)
+					c = Replacement;
+
+				if (c < 0x80)
+				{
+					out += static_cast<char>(c);
+				}
+				else if (c < 0x800)
+				{
+					out += static_cast<char>(0xC0 | (c >> 6));
+					out += static_cast<char>(0x80 | (c & 0x3F));
+				}
+				else if (c < 0x10000)
+				{
+					out += static_cast<char>(0xE0 | (c >> 12));
+					out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+					out += static_cast<char>(0x80 | (c & 0x3F));
+				}
+				else
+				{
+					out += static_cast<char>(0xF0 | (c >> 18));
+					out += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+					out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+					out += static_cast<char>(0x80 | (c & 0x3F));
+				}
+			}
+		}
+
+	private:
+		static constexpr uint32_t Replacement = 0xFFFD;
+
+		// Code point starting at text[i]; advances i past it (by one byte when malformed)
+		static uint32_t Next(std::string_view text, size_t& i)
+		{
+			uint8_t lead = static_cast<uint8_t>(text[i++]);
+			if (lead < 0x80)
+				return lead;
+
+			size_t extra;
+			uint32_t c;
+			uint32_t minimum;
+			if (lead >= 0xC2 && lead <= 0xDF)
+			{
+				extra = 1;
+				c = lead & 0x1F;
+				minimum = 0x80;
+			}
+			else if (lead >= 0xE0 && lead <= 0xEF)
+			{
+				extra = 2;
+				c = lead & 0x0F;
+				minimum = 0x800;
+			}
+			else if (lead >= 0xF0 && lead <= 0xF4)
+			{
+				extra = 3;
+				c = lead & 0x07;
+				minimum = 0x10000;
+			}
+			else
+			{
+				return Replacement;
+			}
+
+			if (text.size() - i < extra)
+				return Replacement;
+			for (size_t k = 0; k < extra; k++)
+			{
+				uint8_t next = static_cast<uint8_t>(text[i + k]);
+				if ((next & 0xC0) != 0x80)
+					return Replacement;
+				c = (c << 6) | (next & 0x3F);
+			}
+			if (c < minimum || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+				return Replacement;
+			i += extra;
+			return c;
+		}
+
+		static void AppendCodePoint(std::wstring& out, uint32_t c)
+		{
+			if constexpr (sizeof(wchar_t) == 2)
+			{
+				if (c >= 0x10000)
+				{
+					c -= 0x10000;
+					out += static_cast<wchar_t>(0xD800 + (c >> 10));
+					out += static_cast<wchar_t>(0xDC00 + (c & 0x3FF));
+					return;
+				}
+			}
+			out += static_cast<wchar_t>(c);
+		}
+	};
+}
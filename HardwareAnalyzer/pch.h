@@ -1,5 +1,9 @@
 #pragma once
 
+// HARDWARE_ANALYZER_PORTABLE selects the standard-library-only branch on Windows too,
+// for builds of the engine outside the WinUI app (the C ABI library)
+#if defined _WIN32 && !defined HARDWARE_ANALYZER_PORTABLE
+
 // Undefine GetCurrentTime macro to prevent
 // conflict with Storyboard::GetCurrentTime
 #undef GetCurrentTime
@@ -62,3 +66,22 @@
 #include <winrt/Microsoft.Windows.ApplicationModel.Resources.h>
 #include <winrt/Windows.ApplicationModel.Resources.h>
 #include <Shobjidl.h>
+
+#else
+
+// The portable engine headers (HardwareInfo.h, MacOSHardwareInfo.h, Tracing.h...)
+// are also compiled outside the WinUI project, where only the standard library is needed
+#include <string>
+#include <cstdlib>
+#include <chrono>
+#include <sstream>
+#include <regex>
+#include <algorithm>
+#include <cwctype>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+#endif
@@ -0,0 +1,111 @@
+#pragma once
+#include "pch.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace HardwareAnalyzer::Tests
+{
+	// OCR texts built to hit the worst case of each scanner the parsers run: the shapes that
+	// made the old std::regex patterns backtrack or overflow the stack, and near misses that
+	// make every position a candidate start. Each generator makes about 'chars' characters,
+	// so parse times at two sizes show whether a parse stays linear. The same texts seed the
+	// fuzzer (Fuzz/OcrParserFuzzer.cpp).
+	struct AdversarialText
+	{
+		const char* Name;
+		std::wstring (*Make)(size_t chars);
+	};
+
+	namespace Adversarial
+	{
+		inline std::wstring Repeat(std::wstring_view unit, size_t chars, std::wstring_view tail = {})
+		{
+			std::wstring text;
+			text.reserve(chars + tail.size());
+			while (text.size() + unit.size() <= chars)
+				text += unit;
+			text += tail;
+			return text;
+		}
+
+		// "(AMD|Intel|...)[^\n]+(?:Core|Ryzen|...)[^\n]+" with vendors and no model keyword
+		inline std::wstring VendorsWithoutModel(size_t chars) { return Repeat(L"Intel AMD Qualcomm Apple ", chars); }
+
+		// Model keywords with the only vendor at the very end, after all of them
+		inline std::wstring ModelsBeforeVendor(size_t chars) { return Repeat(L"Core Ryzen Xeon M2 ", chars, L"Intel"); }
+
+		// One digit run with no unit after it, then a unit too far away to count
+		inline std::wstring DigitsWithoutUnit(size_t chars) { return Repeat(L"1234567890", chars, L" x GB"); }
+
+		// Digits and separators that keep almost forming a quantity: "1 G 1,5 G 2.0 M"
+		inline std::wstring AlmostQuantities(size_t chars) { return Repeat(L"1 G 1,5 G 2.0 M 16 Gi ", chars); }
+
+		// Label prefixes that match for a while and then fail: "Installed RA", "Processo"
+		inline std::wstring LabelPrefixes(size_t chars) { return Repeat(L"Installed RA Processo Graphics car Device nam ", chars); }
+
+		// Labels with a long whitespace run inside, which a space in a label matches
+		inline std::wstring StretchedLabels(size_t chars)
+		{
+			std::wstring unit = L"Installed" + std::wstring(200, L' ') + L"RAM" + std::wstring(200, L'\t') + L":";
+			return Repeat(unit, chars);
+		}
+
+		// Labels whose value is missing: every one ends its line, and the next line is a label too
+		inline std::wstring LabelsWithoutValues(size_t chars) { return Repeat(L"Processor\nInstalled RAM\nGraphics card\nSystem type\n", chars); }
+
+		// Architecture near misses: "64-bi", "x6", "ARM6" with a "processor" far away
+		inline std::wstring ArchitectureNearMisses(size_t chars) { return Repeat(L"64-bi x6 ARM6 32 bi aarch6 ", chars, L"processor"); }
+
+		// GPU vendors whose model keyword never follows: "Intel ... AMD ... Qualcomm ..."
+		inline std::wstring GpuVendorsWithoutModel(size_t chars) { return Repeat(L"Intel AMD Qualcomm ", chars, L"UHD"); }
+
+		// Stop patterns and labels run together without spaces, as merged OCR lines are
+		inline std::wstring MergedLines(size_t chars)
+		{
+			return Repeat(L"Graphics cardNVIDIAMemoryProcessorDevice nameInstalled RAM16GBSystem type64-bit ", chars);
+		}
+
+		// "About This Mac" near misses: chip and memory labels without values, "macOS" without a version
+		inline std::wstring MacNearMisses(size_t chars) { return Repeat(L"Chip Apple M Memory GB macOS Sonoma Version MacBook Pro ", chars); }
+
+		// Only blank lines, carriage returns and spaces
+		inline std::wstring BlankLines(size_t chars) { return Repeat(L"\r\n \n\t\n", chars); }
+
+		// Characters the normalizer and the folding tables rewrite: confusable letters, NBSP,
+		// curly quotes, accents, Cyrillic and Greek, lone surrogates
+		inline std::wstring FoldedCharacters(size_t chars)
+		{
+			return Repeat(L"1O GB Mernory \u00A0\u2019\u00C9\u00E4\u0142\u0219\u0416\u03AC \xD800 l6 S5 \u201C", chars);
+		}
+
+		// Text that every language's trigrams partly match, so identification can't settle
+		inline std::wstring MixedLanguages(size_t chars)
+		{
+			return Repeat(L"Prozessor Processeur Procesador \u041F\u0440\u043E\u0446\u0435\u0441\u0441\u043E\u0440 \u30D7\u30ED\u30BB\u30C3\u30B5 ", chars);
+		}
+	}
+
+	inline const std::vector<AdversarialText>& AdversarialCorpus()
+	{
+		static const std::vector<AdversarialText> texts = {
+			{ "vendors-without-model", Adversarial::VendorsWithoutModel },
+			{ "models-before-vendor", Adversarial::ModelsBeforeVendor },
+			{ "digits-without-unit", Adversarial::DigitsWithoutUnit },
+			{ "almost-quantities", Adversarial::AlmostQuantities },
+			{ "label-prefixes", Adversarial::LabelPrefixes },
+			{ "stretched-labels", Adversarial::StretchedLabels },
+			{ "labels-without-values", Adversarial::LabelsWithoutValues },
+			{ "architecture-near-misses", Adversarial::ArchitectureNearMisses },
+			{ "gpu-vendors-without-model", Adversarial::GpuVendorsWithoutModel },
+			{ "merged-lines", Adversarial::MergedLines },
+			{ "mac-near-misses", Adversarial::MacNearMisses },
+			{ "blank-lines", Adversarial::BlankLines },
+			{ "folded-characters", Adversarial::FoldedCharacters },
+			{ "mixed-languages", Adversarial::MixedLanguages },
+		};
+		return texts;
+	}
+}
@@ -0,0 +1,147 @@
+#include "pch.h"
+#include "AnalysisHistory.h"
+#include "AnalysisPipeline.h"
+#include "TestHarness.h"
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <variant>
+
+using namespace HardwareAnalyzer;
+
+namespace
+{
+	// An empty directory of its own under the temporary one
+	std::filesystem::path TemporaryHistory(const char* name)
+	{
+		std::filesystem::path directory = std::filesystem::temp_directory_path() / (std::string("hardware-analyzer-tests-") + name);
+		std::filesystem::remove_all(directory);
+		return directory;
+	}
+
+	MacOSAnalysis Mac(const wchar_t* chip, int score)
+	{
+		MacOSAnalysis analysis;
+		analysis.Info.DeviceName = L"MacBook Pro";
+		analysis.Info.DeviceYear = L"2023";
+		analysis.Info.Chip = chip;
+		analysis.Info.Memory = L"16 GB";
+		analysis.Score = score;
+		return analysis;
+	}
+}
+
+// Text past the 16-bit length is cut before a character, not inside one
+TEST_CASE(AnalysisHistory_LongTextIsCutBetweenCharacters)
+{
+	std::filesystem::path directory = TemporaryHistory("long-text");
+	{
+		AnalysisHistory history;
+		std::string error;
+		CHECK(history.Open(directory, error));
+
+		WindowsAnalysis analysis;
+		analysis.Info.DeviceName = L"DESKTOP-LONG";
+		analysis.Info.Processor = std::wstring(40000, L'\u00E9');   // Two bytes each, 80000 in all
+		CHECK(history.Append(analysis));
+
+		auto record = history.ReadLatest(L"DESKTOP-LONG");
+		CHECK(record.has_value());
+		if (record)
+		{
+			const std::wstring& processor = std::get<WindowsAnalysis>(record->Analysis).Info.Processor;
+			CHECK_EQUAL(processor.size(), size_t(32767));
+			CHECK(processor.find_first_not_of(L'\u00E9') == std::wstring::npos);
+		}
+	}
+	std::filesystem::remove_all(directory);
+}
+
+// "About This Mac" names only the model, so Macs of one model keep their own histories
+// by configuration
+TEST_CASE(AnalysisHistory_MacsOfOneModelAreKeptApart)
+{
+	std::filesystem::path directory = TemporaryHistory("macs");
+	{
+		AnalysisHistory history;
+		std::string error;
+		CHECK(history.Open(directory, error));
+
+		MacOSAnalysis m1 = Mac(L"Apple M1", 70);
+		MacOSAnalysis m2 = Mac(L"Apple M2 Pro", 95);
+		CHECK(history.Append(m1));
+		CHECK(history.Append(m2));
+		CHECK(history.Append(m2));
+		CHECK_EQUAL(history.DeviceCount(), size_t(2));
+		CHECK_EQUAL(AnalysisHistory::DeviceName(m2.Info), std::wstring(L"MacBook Pro / 2023 / Apple M2 Pro / 16 GB"));
+
+		auto latest = history.Latest(AnalysisHistory::DeviceName(m1.Info));
+		CHECK(latest && latest->Score == 70 && latest->Records == 1);
+		CHECK_EQUAL(history.History(AnalysisHistory::DeviceName(m2.Info)).size(), size_t(2));
+		CHECK(!history.Latest(L"MacBook Pro"));
+	}
+	std::filesystem::remove_all(directory);
+}
+
+// The index grows past its first table and reopens clean; Close waits for a compaction
+// and none starts after it
+TEST_CASE(AnalysisHistory_GrowsReopensAndStopsCompactingOnClose)
+{
+	std::filesystem::path directory = TemporaryHistory("grow");
+	{
+		AnalysisHistory history(AnalysisHistory::Options{ 32, false });
+		std::string error;
+		CHECK(history.Open(directory, error));
+		AnalysisHistory::Batch batch;
+		for (int device = 0; device < 3000; device++)
+		{
+			WindowsAnalysis analysis;
+			analysis.Info.DeviceName = L"DESKTOP-" + std::to_wstring(device);
+			analysis.Score = device % 100;
+			batch.Add(analysis, device);
+			batch.Add(analysis, device + 1);
+		}
+		CHECK(history.Append(batch));
+		CHECK_EQUAL(history.DeviceCount(), size_t(3000));
+
+		CHECK(history.StartCompaction());
+		history.Close();
+		CHECK(!history.IsOpen());
+		CHECK(!history.StartCompaction());
+
+		CHECK(history.Open(directory, error));
+		CHECK_EQUAL(history.DeviceCount(), size_t(3000));
+		auto latest = history.Latest(L"DESKTOP-2999");
+		CHECK(latest && latest->Score == 99 && latest->TimeMs == 3000);
+	}
+	std::filesystem::remove_all(directory);
+}
+
+// A worker's batch is cleared even when the history won't take it, so a history closed
+// under the workers (as losing the index while growing does) can't make their batches grow
+TEST_CASE(AnalysisHistory_ClosedHistoryDropsTheBatch)
+{
+	std::filesystem::path directory = TemporaryHistory("closed");
+	{
+		AnalysisHistory history;
+		std::string error;
+		CHECK(history.Open(directory, error));
+		AnalysisHistory::Batch batch;
+		batch.Add(Mac(L"Apple M1", 70), 1);
+		CHECK_EQUAL(history.AppendOrDrop(batch), size_t(0));
+		CHECK(batch.Empty());
+
+		history.Close();
+		for (int round = 0; round < 3; round++)
+		{
+			batch.Add(Mac(L"Apple M1", 70), 2);
+			batch.Add(Mac(L"Apple M2 Pro", 95), 2);
+			CHECK_EQUAL(history.AppendOrDrop(batch), size_t(2));
+			CHECK(batch.Empty());
+		}
+
+		CHECK(history.Open(directory, error));
+		CHECK_EQUAL(history.DeviceCount(), size_t(1));
+	}
+	std::filesystem::remove_all(directory);
+}
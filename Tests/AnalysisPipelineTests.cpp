@@ -0,0 +1,250 @@
+#include "pch.h"
+#include "AnalysisJson.h"
+#include "AnalysisPipeline.h"
+#include "SyntheticCorpus.h"
+#include "TestHarness.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cwctype>
+#include <memory_resource>
+#include <new>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace HardwareAnalyzer;
+using namespace HardwareAnalyzer::Tests;
+
+namespace
+{
+	// This file replaces the global operator new and delete, which replaces them for the whole
+	// test binary: every other test allocates through these too. Outside an AllocationCount
+	// they are plain malloc and free, and the count is per thread, so only the thread that
+	// opened one counts, and only its own allocations.
+
+	// Heap allocations made by the thread while it counts
+	thread_local bool t_counting = false;
+	thread_local uint64_t t_allocations = 0;
+
+	struct AllocationCount
+	{
+		AllocationCount() { t_allocations = 0; t_counting = true; }
+		~AllocationCount() { t_counting = false; }
+		uint64_t Count() const { return t_allocations; }
+	};
+
+	// Heap allocations and seconds of a path over all its pages
+	struct PathCost
+	{
+		double Allocations = 0;
+		double Seconds = 0;
+	};
+
+	std::vector<std::wstring> WindowsPages(uint64_t count)
+	{
+		SyntheticCorpus::Options options;
+		options.MacOSShare = 0;
+		SyntheticCorpus corpus(options);
+		std::vector<std::wstring> pages(count);
+		SyntheticCorpus::Document document;
+		for (uint64_t i = 0; i < count; i++)
+		{
+			corpus.Generate(i, document);
+			pages[i] = document.Text;
+		}
+		return pages;
+	}
+
+	// Runs analyze(thread, threads) on that many threads at once; the allocations they all
+	// made, and the wall time until the last one finished
+	template <typename Analyze>
+	PathCost RunThreads(unsigned threads, Analyze analyze)
+	{
+		std::vector<uint64_t> allocations(threads);
+		std::vector<std::thread> running;
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned t = 0; t < threads; t++)
+		{
+			running.emplace_back([&, t] {
+				AllocationCount count;
+				analyze(t, threads);
+				allocations[t] = count.Count();
+			});
+		}
+		for (std::thread& thread : running)
+			thread.join();
+
+		PathCost cost;
+		cost.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		for (uint64_t count : allocations)
+			cost.Allocations += static_cast<double>(count);
+		return cost;
+	}
+
+	// The replacements count in one place and free in another, out of the inliner's sight,
+	// so GCC doesn't take the pair for a mismatched new and free
+	[[gnu::noinline]] void* Allocate(std::size_t size)
+	{
+		if (t_counting)
+			t_allocations++;
+		if (void* block = std::malloc(size ? size : 1))
+			return block;
+		throw std::bad_alloc{};
+	}
+
+	[[gnu::noinline]] void Release(void* block) noexcept
+	{
+		std::free(block);
+	}
+}
+
+void* operator new(std::size_t size) { return Allocate(size); }
+void operator delete(void* block) noexcept { Release(block); }
+void operator delete(void* block, std::size_t) noexcept { Release(block); }
+
+// The same pages through the std path and through an arena released once per batch of 32,
+// as the daemon's workers do, with the JSON each analysis answers with. Prints allocations
+// and time per page for both, and checks the arena path allocates less and answers the same.
+TEST_CASE(AnalysisPipeline_ArenaAllocatesLessThanTheHeap)
+{
+	constexpr uint64_t Pages = 2000;
+	constexpr uint64_t BatchSize = 32;
+	std::vector<std::wstring> pages = WindowsPages(Pages);
+
+	std::vector<std::string> heapJson(Pages);
+	PathCost heap;
+	{
+		AllocationCount count;
+		auto start = std::chrono::steady_clock::now();
+		for (uint64_t i = 0; i < Pages; i++)
+			heapJson[i] = AnalysisJson::ToJson(AnalysisPipeline::AnalyzeWindowsText(pages[i]));
+		heap.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		heap.Allocations = static_cast<double>(count.Count());
+	}
+
+	std::vector<std::string> arenaJson(Pages);
+	PathCost arena;
+	{
+		std::vector<std::byte> buffer(256 * 1024);
+		std::pmr::monotonic_buffer_resource resource(buffer.data(), buffer.size());
+		AllocationCount count;
+		auto start = std::chrono::steady_clock::now();
+		for (uint64_t i = 0; i < Pages; i++)
+		{
+			arenaJson[i] = AnalysisJson::ToJson(AnalysisPipeline::AnalyzeWindowsText(pages[i], &resource));
+			if ((i + 1) % BatchSize == 0)
+				resource.release();
+		}
+		arena.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		arena.Allocations = static_cast<double>(count.Count());
+	}
+
+	// The JSON strings are in both counts, one allocation or so per page
+	std::printf("  heap:  %.1f allocations, %.2f us per page\n", heap.Allocations / Pages, heap.Seconds * 1e6 / Pages);
+	std::printf("  arena: %.1f allocations, %.2f us per page\n", arena.Allocations / Pages, arena.Seconds * 1e6 / Pages);
+	CHECK(arena.Allocations * 2 < heap.Allocations);
+	CHECK(arenaJson == heapJson);
+}
+
+// The same comparison with several threads analyzing at once, as the daemon's workers do,
+// each with its own arena: prints allocations per page and pages per second of each path.
+// Whether the arena is faster here depends on how much the heap contends across cores, so
+// only the allocations and the answers are checked.
+TEST_CASE(AnalysisPipeline_ArenaUnderThreadsAllocatesLessThanTheHeap)
+{
+	constexpr uint64_t Pages = 4000;
+	constexpr uint64_t BatchSize = 32;
+	const unsigned threads = std::clamp(std::thread::hardware_concurrency(), 4u, 16u);
+	std::vector<std::wstring> pages = WindowsPages(Pages);
+
+	std::vector<std::string> heapJson(Pages);
+	PathCost heap = RunThreads(threads, [&](unsigned thread, unsigned step) {
+		for (uint64_t i = thread; i < Pages; i += step)
+			heapJson[i] = AnalysisJson::ToJson(AnalysisPipeline::AnalyzeWindowsText(pages[i]));
+	});
+
+	std::vector<std::string> arenaJson(Pages);
+	PathCost arena = RunThreads(threads, [&](unsigned thread, unsigned step) {
+		std::vector<std::byte> buffer(256 * 1024);
+		std::pmr::monotonic_buffer_resource resource(buffer.data(), buffer.size());
+		uint64_t batch = 0;
+		for (uint64_t i = thread; i < Pages; i += step)
+		{
+			arenaJson[i] = AnalysisJson::ToJson(AnalysisPipeline::AnalyzeWindowsText(pages[i], &resource));
+			if (++batch % BatchSize == 0)
+				resource.release();
+		}
+	});
+
+	std::printf("  %u threads on %u cores\n", threads, std::thread::hardware_concurrency());
+	std::printf("  heap:  %.1f allocations per page, %.0f pages/s\n", heap.Allocations / Pages, Pages / heap.Seconds);
+	std::printf("  arena: %.1f allocations per page, %.0f pages/s\n", arena.Allocations / Pages, Pages / arena.Seconds);
+	CHECK(arena.Allocations * 2 < heap.Allocations);
+	CHECK(arenaJson == heapJson);
+}
+
+// Past its first page (which loads the label packs), the arena path of a Windows page takes
+// nothing from the default heap: the CPU generation is scanned for rather than matched with
+// std::wregex, whose state and submatch strings came from the heap whatever the allocator
+TEST_CASE(AnalysisPipeline_ArenaPathLeavesTheHeapAlone)
+{
+	SyntheticCorpus::Options options;
+	options.MacOSShare = 0;
+	options.ConfusionRate = 0.01;
+	SyntheticCorpus corpus(options);
+	SyntheticCorpus::Document document;
+	std::vector<std::byte> buffer(256 * 1024);
+	std::pmr::monotonic_buffer_resource resource(buffer.data(), buffer.size());
+	AnalysisPipeline::AnalyzeWindowsText(L"warm-up", &resource);
+	resource.release();
+
+	uint64_t allocations = 0;
+	for (uint64_t i = 0; i < 500; i++)
+	{
+		corpus.Generate(i, document);
+		AllocationCount count;
+		AnalysisPipeline::AnalyzeWindowsText(document.Text, &resource);
+		allocations += count.Count();
+		resource.release();
+	}
+	CHECK_EQUAL(allocations, uint64_t(0));
+}
+
+// The CPU generation and Ryzen series scans agree with the patterns they replace, on names
+// that match, near misses, and OCR spacing
+TEST_CASE(AnalysisPipeline_CpuScansAgreeWithTheirPatterns)
+{
+	const std::wregex intel(LR"(i[3579]-(\d{2})(\d{2,3}))", std::regex::icase);
+	const std::wregex ryzen(LR"(ryzen\s*[3579]\s*(\d)(\d{3}))", std::regex::icase);
+	const wchar_t* names[] = {
+		L"Intel(R) Core(TM) i7-12700H", L"Intel(R) Core(TM) i5-8250U CPU @ 1.60GHz", L"Intel Core i9-9900K",
+		L"Intel Core i3-1005G1", L"Intel Core i7-975", L"Intel Core i7 -10700", L"Intel Core I7-11800H",
+		L"Intel Core i4-12700", L"ii7-10510U", L"i7-1", L"i7-",
+		L"AMD Ryzen 7 5800X 8-Core Processor", L"AMD Ryzen 5 2600", L"AMD RYZEN 9 7950X3D", L"Ryzen5 3600",
+		L"AMD Ryzen 7\t\n 1700X", L"AMD Ryzen 3 360", L"AMD Ryzen 4 4600", L"ryzen 75800", L"AMD Ryzen Threadripper 3990X",
+		L"Intel Core i7-8700 + Ryzen 7 5800X",
+	};
+	for (const wchar_t* name : names)
+	{
+		std::wstring lower = name;
+		for (wchar_t& c : lower)
+			c = static_cast<wchar_t>(std::towlower(c));
+		std::wsmatch match;
+		const wchar_t* expected = L"Reason_CPUDetected";
+		if (std::regex_search(lower, match, intel))
+			expected = std::stoi(match[1].str()) >= 10 ? L"Reason_ModernIntel" : L"Reason_OlderIntel";
+		else if (std::regex_search(lower, match, ryzen))
+			expected = std::stoi(match[1].str()) >= 3 ? L"Reason_ModernRyzen" : L"Reason_OlderRyzen";
+
+		HardwareInfo info;
+		info.Processor = name;
+		std::vector<HardwareCheckResult> results = HardwareAnalyzerService::AnalyzeHardware(info);
+		if (results.empty() || results[0].ReasonKey != expected)
+			Fail(__FILE__, __LINE__, Describe(name));
+	}
+}
@@ -0,0 +1,172 @@
+#include "pch.h"
+#include "AnalysisPipeline.h"
+#include "AsyncTask.h"
+#include "SyntheticCorpus.h"
+#include "TestHarness.h"
+#include "Tracing.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace HardwareAnalyzer;
+using namespace HardwareAnalyzer::Tests;
+
+namespace
+{
+	Task<int> Answer(ThreadPoolExecutor& executor)
+	{
+		co_await executor.Schedule();
+		co_return 42;
+	}
+
+	Task<int> Doubled(ThreadPoolExecutor& executor)
+	{
+		int value = co_await Answer(executor);
+		co_return value * 2;
+	}
+
+	Task<void> Failing(ThreadPoolExecutor& executor)
+	{
+		co_await executor.Schedule();
+		throw std::runtime_error("stage failed");
+	}
+
+	// Holds the executor's thread until 'release' is set
+	Detail::DetachedTask Block(ThreadPoolExecutor& executor, std::atomic<bool>& running, std::shared_future<void> release)
+	{
+		co_await executor.Schedule();
+		running = true;
+		release.wait();
+	}
+
+	Detail::DetachedTask Increment(ThreadPoolExecutor& executor, std::atomic<int>& counter)
+	{
+		co_await executor.Schedule();
+		counter++;
+	}
+
+	std::wstring WindowsPage()
+	{
+		SyntheticCorpus::Options options;
+		options.MacOSShare = 0;
+		options.Languages = { L"en" };
+		SyntheticCorpus::Document document;
+		SyntheticCorpus(options).Generate(0, document);
+		return document.Text;
+	}
+
+	bool Traced(const char* name)
+	{
+		auto events = Tracer::Snapshot();
+		return std::any_of(events.begin(), events.end(), [&](const TraceEvent& event) { return std::strcmp(event.Name, name) == 0; });
+	}
+}
+
+// Results come back across the pool's threads through nested awaits, and so do exceptions
+TEST_CASE(AsyncTask_SyncWaitPropagatesResultsAndExceptions)
+{
+	ThreadPoolExecutor executor(2);
+	CHECK_EQUAL(SyncWait(Answer(executor)), 42);
+	CHECK_EQUAL(SyncWait(Doubled(executor)), 84);
+
+	bool thrown = false;
+	try
+	{
+		SyncWait(Failing(executor));
+	}
+	catch (const std::runtime_error& e)
+	{
+		thrown = std::string(e.what()) == "stage failed";
+	}
+	CHECK(thrown);
+}
+
+// Starting a job cancels the one before it, and only that one
+TEST_CASE(AsyncTask_LatestJobCancelsTheSupersededJob)
+{
+	LatestJob latest;
+	CancellationToken first = latest.Begin();
+	CHECK(!first.IsCancellationRequested());
+	CancellationToken second = latest.Begin();
+	CHECK(first.IsCancellationRequested());
+	CHECK(!second.IsCancellationRequested());
+	latest.Cancel();
+	CHECK(second.IsCancellationRequested());
+	CHECK(!CancellationToken{}.IsCancellationRequested());
+}
+
+// A job superseded while it waited for a thread stops at the first stage boundary, before
+// parsing; the job that superseded it runs to the end and scores like the inline pipeline
+TEST_CASE(AsyncTask_CanceledTokenStopsThePipelineBetweenStages)
+{
+	ThreadPoolExecutor executor(1);
+	std::wstring page = WindowsPage();
+	Tracer::Clear();
+	Tracer::Enable(true);
+
+	// The superseded job is queued behind a blocked thread when it is cancelled
+	LatestJob latest;
+	CancellationToken superseded = latest.Begin();
+	std::atomic<bool> running{ false };
+	std::promise<void> release;
+	Block(executor, running, release.get_future().share());
+	while (!running)
+		std::this_thread::yield();
+
+	std::atomic<bool> canceled{ false };
+	std::thread waiter([&] {
+		try
+		{
+			SyncWait(AnalysisPipeline::AnalyzeWindowsTextAsync(page, superseded, executor));
+		}
+		catch (const TaskCanceled&)
+		{
+			canceled = true;
+		}
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	CancellationToken current = latest.Begin();
+	release.set_value();
+	waiter.join();
+	CHECK(canceled);
+	CHECK(!Traced("ParseOcrText"));
+
+	WindowsAnalysis analysis = SyncWait(AnalysisPipeline::AnalyzeWindowsTextAsync(page, current, executor));
+	Tracer::Enable(false);
+	CHECK(Traced("ParseOcrText") && Traced("AnalyzeHardware"));
+	CHECK_EQUAL(analysis.Score, AnalysisPipeline::AnalyzeWindowsText(page).Score);
+	CHECK(analysis.Score >= 0);
+	Tracer::Clear();
+}
+
+// Work queued when the executor is destroyed still runs before its threads exit
+TEST_CASE(AsyncTask_ExecutorDrainsOnDestruction)
+{
+	constexpr int Jobs = 100;
+	std::atomic<int> counter{ 0 };
+	std::atomic<bool> running{ false };
+	std::promise<void> release;
+	std::thread releaser;
+	{
+		ThreadPoolExecutor executor(1);
+		Block(executor, running, release.get_future().share());
+		while (!running)
+			std::this_thread::yield();
+		for (int i = 0; i < Jobs; i++)
+			Increment(executor, counter);
+		CHECK(counter == 0);
+
+		// Let the thread go once the destructor is waiting for it
+		releaser = std::thread([&release] {
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			release.set_value();
+		});
+	}
+	releaser.join();
+	CHECK_EQUAL(counter.load(), Jobs);
+}
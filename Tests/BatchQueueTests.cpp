@@ -0,0 +1,40 @@
+#include "pch.h"
+#include "BatchQueue.h"
+#include "TestHarness.h"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace HardwareAnalyzer;
+
+// A consumer that arrives while another lingers for a full batch takes the queued items
+// straight away; the lingering one goes back to waiting rather than return an empty batch
+TEST_CASE(BatchQueue_LingeringConsumerNeverReturnsAnEmptyBatch)
+{
+	BatchQueue<int> queue(16);
+
+	size_t lingeringBatches = 0;
+	size_t emptyBatches = 0;
+	std::thread lingering([&] {
+		std::vector<int> batch;
+		while (queue.PopBatch(batch, 4, std::chrono::seconds(2)))
+		{
+			lingeringBatches++;
+			emptyBatches += batch.empty();
+		}
+	});
+	CHECK(queue.Push(1));
+	// The lingering consumer has the item's wake-up and waits out its window
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+	std::vector<int> taken;
+	auto started = std::chrono::steady_clock::now();
+	CHECK(queue.PopBatch(taken, 4, std::chrono::microseconds(0)));
+	CHECK(std::chrono::steady_clock::now() - started < std::chrono::seconds(1));
+	CHECK_EQUAL(taken.size(), size_t(1));
+
+	queue.Close();
+	lingering.join();
+	CHECK_EQUAL(lingeringBatches, size_t(0));
+	CHECK_EQUAL(emptyBatches, size_t(0));
+}
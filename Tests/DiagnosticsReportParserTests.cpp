@@ -0,0 +1,119 @@
+#include "pch.h"
+#include "DiagnosticsReportParser.h"
+#include "TestHarness.h"
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+using namespace HardwareAnalyzer;
+using namespace HardwareAnalyzer::Tests;
+
+namespace
+{
+	using Format = DiagnosticsReportParser::Format;
+
+	std::string ReadFixture(const char* name)
+	{
+		std::ifstream file(FixturesDirectory() / "DiagnosticsReports" / name, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	// The report fed 'chunk' bytes at a time
+	HardwareInfo Parse(std::string_view report, size_t chunk, Format& format)
+	{
+		DiagnosticsReportParser parser;
+		for (size_t at = 0; at < report.size(); at += chunk)
+			parser.Feed(report.substr(at, chunk));
+		HardwareInfo info = parser.Finish();
+		format = parser.DetectedFormat();
+		return info;
+	}
+
+	struct Expected
+	{
+		const char* Fixture;
+		Format ReportFormat;
+		const wchar_t* DeviceName;
+		const wchar_t* Processor;
+		const wchar_t* RAM;
+		double RamGB;
+		const wchar_t* GPU;
+		const wchar_t* VRAM;
+		double VramGB;
+		const wchar_t* SystemType;
+	};
+
+	// What each export says, as a reader of it would copy it out
+	const Expected Reports[] = {
+		{ "dxdiag.txt", Format::DxDiagText, L"DESKTOP-7Q2LM4K", L"13th Gen Intel(R) Core(TM) i7-13700K (24 CPUs), ~3.4GHz",
+			L"32768MB RAM", 32, L"NVIDIA GeForce RTX 4070", L"12011 MB", 12011.0 / 1024,
+			L"Windows 11 Pro 64-bit (10.0, Build 22631) (22621.ni_release.220506-1250)" },
+		{ "msinfo32.txt", Format::MsInfoText, L"DESKTOP-7Q2LM4K", L"13th Gen Intel(R) Core(TM) i7-13700K, 3400 Mhz, 16 Core(s), 24 Logical Processor(s)",
+			L"32.0 GB", 32, L"NVIDIA GeForce RTX 4070", L"(4,293,918,720) bytes", 4293918720.0 / 1073741824, L"x64-based PC" },
+		{ "dxdiag.xml", Format::DxDiagXml, L"GAMING-RIG", L"AMD Ryzen 7 7800X3D 8-Core Processor           (16 CPUs), ~4.2GHz",
+			L"32768MB RAM", 32, L"AMD Radeon RX 7900 XT", L"20464 MB", 20464.0 / 1024, L"Windows 11 Home 64-bit (10.0, Build 26100)" },
+	};
+}
+
+// Each recorded export gives the same fields however its bytes are chunked: one at a time,
+// a few at a time (splitting UTF-16 units, CRLFs and tags) and whole
+TEST_CASE(DiagnosticsReportParser_ReadsRecordedExportsInAnyChunking)
+{
+	for (const Expected& expected : Reports)
+	{
+		std::string report = ReadFixture(expected.Fixture);
+		CHECK(!report.empty());
+		for (size_t chunk : { size_t(1), size_t(2), size_t(7), size_t(4096), size_t(1) << 20 })
+		{
+			Format format = Format::Unknown;
+			HardwareInfo info = Parse(report, chunk, format);
+			std::string where = std::string(expected.Fixture) + " in chunks of " + std::to_string(chunk) + ": ";
+			auto check = [&](const std::wstring& actual, const wchar_t* wanted, const char* field) {
+				if (actual != wanted)
+					Fail(__FILE__, __LINE__, where + field + " " + Describe(actual) + " != " + Describe(wanted));
+			};
+			if (format != expected.ReportFormat)
+				Fail(__FILE__, __LINE__, where + "format " + Describe(format));
+			check(info.DeviceName, expected.DeviceName, "DeviceName");
+			check(info.Processor, expected.Processor, "Processor");
+			check(info.RAM, expected.RAM, "RAM");
+			check(info.GPU, expected.GPU, "GPU");
+			check(info.VRAM, expected.VRAM, "VRAM");
+			check(info.SystemType, expected.SystemType, "SystemType");
+			if (std::abs(info.RamGB - expected.RamGB) > 1e-9 || std::abs(info.VramGB - expected.VramGB) > 1e-9)
+				Fail(__FILE__, __LINE__, where + "RamGB " + Describe(info.RamGB) + ", VramGB " + Describe(info.VramGB));
+		}
+	}
+}
+
+// Every display adapter is listed, and those of other sections (sound cards) are not
+TEST_CASE(DiagnosticsReportParser_ListsTheDisplayAdapters)
+{
+	DiagnosticsReportParser parser;
+	parser.Feed(ReadFixture("dxdiag.xml"));
+	CHECK_EQUAL(parser.Adapters().size(), size_t(2));
+	if (parser.Adapters().size() == 2)
+	{
+		CHECK_EQUAL(parser.Adapters()[1].Name, std::wstring(L"AMD Radeon(TM) Graphics"));
+		CHECK_EQUAL(parser.Adapters()[1].Dedicated, std::wstring(L"512 MB"));
+	}
+}
+
+TEST_CASE(DiagnosticsReportParser_ParseFileRejectsWhatIsNoReport)
+{
+	HardwareInfo info;
+	Format format = Format::Unknown;
+	CHECK(DiagnosticsReportParser::ParseFile(FixturesDirectory() / "DiagnosticsReports" / "msinfo32.txt", info, &format));
+	CHECK_EQUAL(format, Format::MsInfoText);
+	CHECK_EQUAL(info.DeviceName, std::wstring(L"DESKTOP-7Q2LM4K"));
+
+	CHECK(!DiagnosticsReportParser::ParseFile(FixturesDirectory() / "DiagnosticsReports" / "missing.txt", info));
+
+	Parse("Processor: looks like a field\nbut has no section\n", 1, format);
+	CHECK_EQUAL(format, Format::Unknown);
+	Parse("<html><body>Processor</body></html>", 3, format);
+	CHECK_EQUAL(format, Format::Unknown);
+}
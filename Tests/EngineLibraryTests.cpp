@@ -0,0 +1,115 @@
+// The C ABI, compiled into the test binary the way the library builds it
+#include "../EngineLibrary/HardwareAnalyzerEngine.cpp"
+#include "TestHarness.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const std::string AboutPage =
+		"Intel(R) Core(TM) i7-1165G7 @ 2.80GHz\n"
+		"16,0 GB\n"
+		"Device specifications\n"
+		"Device name  DESKTOP-4K2L9\n"
+		"Processor  Intel(R) Core(TM) i7-1165G7 @ 2.80GHz\n"
+		"Installed RAM  16,0 GB\n"
+		"System type  64-bit operating system, x64-based processor\n";
+}
+
+TEST_CASE(EngineLibrary_AcceptsAnyStructSizeFromTheFirstLayout)
+{
+	ha_result small{};
+	small.struct_size = static_cast<uint32_t>(HA_RESULT_V1_SIZE - 1);
+	CHECK_EQUAL(ha_analyze(HA_PLATFORM_WINDOWS, AboutPage.data(), AboutPage.size(), &small), int32_t(HA_ERROR_STRUCT_SIZE));
+
+	// A newer caller's struct: the fields this library doesn't know come back zeroed
+	std::vector<unsigned char> newer(sizeof(ha_result) + 32, 0xAB);
+	ha_result* result = reinterpret_cast<ha_result*>(newer.data());
+	result->struct_size = static_cast<uint32_t>(newer.size());
+	result->scratch = nullptr;
+	result->scratch_capacity = 0;
+	CHECK_EQUAL(ha_analyze(HA_PLATFORM_WINDOWS, AboutPage.data(), AboutPage.size(), result), int32_t(HA_OK));
+	CHECK(result->score > 0);
+	CHECK_EQUAL(result->ram_gb, 16.0);
+	bool zeroed = true;
+	for (size_t i = sizeof(ha_result); i < newer.size(); i++)
+		zeroed = zeroed && newer[i] == 0;
+	CHECK(zeroed);
+
+	// The first layout: nothing past it is touched
+	std::vector<unsigned char> first(HA_RESULT_V1_SIZE + 32, 0xAB);
+	result = reinterpret_cast<ha_result*>(first.data());
+	result->struct_size = static_cast<uint32_t>(HA_RESULT_V1_SIZE);
+	result->scratch = nullptr;
+	result->scratch_capacity = 0;
+	CHECK_EQUAL(ha_analyze(HA_PLATFORM_WINDOWS, AboutPage.data(), AboutPage.size(), result), int32_t(HA_OK));
+	bool untouched = true;
+	for (size_t i = HA_RESULT_V1_SIZE; i < first.size(); i++)
+		untouched = untouched && first[i] == 0xAB;
+	CHECK(untouched);
+}
+
+// The processor is also in the header card above; its span is the one on the labeled line
+TEST_CASE(EngineLibrary_SpansPointAfterTheFieldLabel)
+{
+	char scratch[256];
+	ha_result result{};
+	result.struct_size = sizeof(result);
+	result.scratch = scratch;
+	result.scratch_capacity = sizeof(scratch);
+	for (int call = 0; call < 3; call++)
+	{
+		CHECK_EQUAL(ha_analyze(HA_PLATFORM_WINDOWS, AboutPage.data(), AboutPage.size(), &result), int32_t(HA_OK));
+		const ha_span& processor = result.fields[HA_FIELD_PROCESSOR];
+		CHECK_EQUAL(processor.source, uint32_t(HA_SPAN_INPUT));
+		CHECK_EQUAL(size_t(processor.offset), AboutPage.find("Processor  ") + std::strlen("Processor  "));
+		CHECK_EQUAL(AboutPage.substr(processor.offset, processor.length), std::string("Intel(R) Core(TM) i7-1165G7 @ 2.80GHz"));
+
+		const ha_span& ram = result.fields[HA_FIELD_RAM];
+		CHECK_EQUAL(size_t(ram.offset), AboutPage.find("Installed RAM  ") + std::strlen("Installed RAM  "));
+	}
+
+	// Offsets count input bytes, not decoded characters
+	std::string accented = "Nom de l'appareil  PC-\xC3\xA9t\xC3\xA9\n" + AboutPage;
+	CHECK_EQUAL(ha_analyze(HA_PLATFORM_WINDOWS, accented.data(), accented.size(), &result), int32_t(HA_OK));
+	const ha_span& processor = result.fields[HA_FIELD_PROCESSOR];
+	CHECK_EQUAL(size_t(processor.offset), accented.find("Processor  ") + std::strlen("Processor  "));
+}
+
+// VRAM that reads the same as the RAM is the one on the graphics card's line, and a macOS
+// value is the whole word rather than the end of a longer number
+TEST_CASE(EngineLibrary_SpansOfUnlabeledFieldsAreWholeWords)
+{
+	char scratch[256];
+	ha_result result{};
+	result.struct_size = sizeof(result);
+	result.scratch = scratch;
+	result.scratch_capacity = sizeof(scratch);
+
+	const std::string windows =
+		"Device name  DESKTOP-4K2L9\n"
+		"Processor  Intel(R) Core(TM) i7-12700H\n"
+		"Installed RAM  16 GB\n"
+		"Graphics Card  NVIDIA GeForce RTX 4080 16 GB\n"
+		"System type  64-bit operating system, x64-based processor\n";
+	CHECK_EQUAL(ha_analyze(HA_PLATFORM_WINDOWS, windows.data(), windows.size(), &result), int32_t(HA_OK));
+	const ha_span& vram = result.fields[HA_FIELD_VRAM];
+	CHECK_EQUAL(vram.source, uint32_t(HA_SPAN_INPUT));
+	CHECK_EQUAL(size_t(vram.offset), windows.find("4080 16 GB") + std::strlen("4080 "));
+	const ha_span& ram = result.fields[HA_FIELD_RAM];
+	CHECK_EQUAL(size_t(ram.offset), windows.find("Installed RAM  ") + std::strlen("Installed RAM  "));
+
+	const std::string macOS =
+		"MacBook Pro\n"
+		"14-inch, 2021\n"
+		"Storage  116 GB available\n"
+		"Chip  Apple M1 Pro\n"
+		"Memory  16 GB\n"
+		"macOS  Sonoma 14.2\n";
+	CHECK_EQUAL(ha_analyze(HA_PLATFORM_MACOS, macOS.data(), macOS.size(), &result), int32_t(HA_OK));
+	const ha_span& memory = result.fields[HA_FIELD_MEMORY];
+	CHECK_EQUAL(memory.source, uint32_t(HA_SPAN_INPUT));
+	CHECK_EQUAL(size_t(memory.offset), macOS.find("Memory  ") + std::strlen("Memory  "));
+	CHECK_EQUAL(macOS.substr(memory.offset, memory.length), std::string("16 GB"));
+}
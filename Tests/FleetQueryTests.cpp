@@ -0,0 +1,72 @@
+#include "pch.h"
+#include "AnalysisPipeline.h"
+#include "FleetQuery.h"
+#include "FleetResultStore.h"
+#include "RoaringBitmap.h"
+#include "SyntheticCorpus.h"
+#include "TestHarness.h"
+#include <cstdint>
+#include <limits>
+#include <string>
+
+using namespace HardwareAnalyzer;
+
+namespace
+{
+	FleetResultStore CorpusStore(uint64_t count)
+	{
+		SyntheticCorpus::Options options;
+		options.Seed = 5;
+		options.Languages = { L"en" };
+		SyntheticCorpus corpus(options);
+		SyntheticCorpus::Document document;
+		FleetResultStore store;
+		for (uint64_t index = 0; index < count; index++)
+		{
+			corpus.Generate(index, document);
+			if (document.Platform == TargetPlatform::macOS)
+				store.Append(AnalysisPipeline::AnalyzeMacOSText(document.Text));
+			else
+				store.Append(AnalysisPipeline::AnalyzeWindowsText(document.Text));
+		}
+		return store;
+	}
+}
+
+// Numeric comparisons select exactly the rows a scan of the column does
+TEST_CASE(FleetQuery_NumbersMatchTheColumns)
+{
+	FleetResultStore store = CorpusStore(3000);
+	FleetQuery query(store);
+	RoaringBitmap rows;
+	std::string error;
+
+	CHECK(query.Evaluate("ram < 8", rows, error));
+	CHECK_EQUAL(rows.Cardinality(), uint64_t(FleetResultStore::CountInRange(store.RamGB(), std::numeric_limits<float>::denorm_min(), 8)));
+	CHECK(query.Evaluate("ram >= 8", rows, error));
+	CHECK_EQUAL(rows.Cardinality(), uint64_t(FleetResultStore::CountInRange(store.RamGB(), 8, std::numeric_limits<float>::infinity())));
+
+	// A score of -1 is no data, which a comparison never matches
+	CHECK(query.Evaluate("score > -1", rows, error));
+	CHECK_EQUAL(rows.Cardinality(), uint64_t(store.Size() - FleetResultStore::CountEqual(
+		{ reinterpret_cast<const uint8_t*>(store.Score().data()), store.Size() }, 0xFF)));
+	CHECK(query.Evaluate("score >= -.5", rows, error));
+}
+
+TEST_CASE(FleetQuery_MalformedNumbersAreRejected)
+{
+	FleetResultStore store = CorpusStore(100);
+	FleetQuery query(store);
+	RoaringBitmap rows;
+	std::string error;
+
+	CHECK(!query.Evaluate("ram >", rows, error));
+	CHECK_EQUAL(error, std::string("expected a value at offset 5"));
+	for (const char* malformed : { "ram > .", "ram > -", "ram > -.", "ram > 1.2.3", "ram > - 4" })
+	{
+		CHECK(!query.Evaluate(malformed, rows, error));
+		CHECK(error.starts_with("malformed number"));
+	}
+	CHECK(!query.Evaluate("gpu > 4", rows, error));
+	CHECK_EQUAL(error, std::string("'gpu' isn't a number at offset 7"));
+}
@@ -0,0 +1,225 @@
+#include "pch.h"
+#include "AnalysisPipeline.h"
+#include "FleetResultStore.h"
+#include "ResultSerializer.h"
+#include "SyntheticCorpus.h"
+#include "TestHarness.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace HardwareAnalyzer;
+
+// The kernels run on SSE2 where the target has it. Building the tests with
+// -DHARDWARE_ANALYZER_FLEET_SCALAR runs the same checks on the scalar loops.
+
+namespace
+{
+	// xorshift64*, so a failure can be repeated
+	uint64_t NextRandom(uint64_t& state)
+	{
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return state * 0x2545F4914F6CDD1Dull;
+	}
+
+	// Lengths around the 16-byte and 4-float blocks and past 255 blocks, where CountEqual
+	// folds its byte lanes, and past 4096 floats, where AverageFound folds its float lanes
+	constexpr size_t Lengths[] = { 0, 1, 3, 4, 5, 15, 16, 17, 63, 255 * 16 - 1, 255 * 16, 255 * 16 + 17, 4096 + 3, 3 * 4096 + 9, 100003 };
+
+	std::vector<uint8_t> Bytes(size_t size, uint64_t& state)
+	{
+		std::vector<uint8_t> bytes(size);
+		for (uint8_t& byte : bytes)
+		{
+			// Mostly statuses and NotApplicable, as a status column holds
+			uint64_t random = NextRandom(state);
+			byte = random % 4 == 0 ? static_cast<uint8_t>(random >> 8) : static_cast<uint8_t>(random >> 8) % 3;
+		}
+		return bytes;
+	}
+
+	std::vector<float> Floats(size_t size, uint64_t& state)
+	{
+		std::vector<float> floats(size);
+		for (float& value : floats)
+		{
+			uint64_t random = NextRandom(state);
+			switch (random % 8)
+			{
+			case 0: value = 0; break;
+			case 1: value = -static_cast<float>((random >> 8) % 64); break;
+			case 2: value = std::numeric_limits<float>::quiet_NaN(); break;
+			default: value = static_cast<float>((random >> 8) % 1024) / 8; break;
+			}
+		}
+		return floats;
+	}
+}
+
+TEST_CASE(FleetResultStore_KernelsMatchScalarLoops)
+{
+	uint64_t state = 0x9E3779B97F4A7C15ull;
+	for (size_t length : Lengths)
+	{
+		std::vector<uint8_t> bytes = Bytes(length, state);
+		for (uint8_t value : { uint8_t(0), uint8_t(1), uint8_t(2), FleetResultStore::NotApplicable })
+		{
+			size_t expected = 0;
+			for (uint8_t byte : bytes)
+				expected += byte == value;
+			CHECK_EQUAL(FleetResultStore::CountEqual(bytes, value), expected);
+		}
+
+		std::array<uint64_t, 256> histogram{};
+		for (uint8_t byte : bytes)
+			histogram[byte]++;
+		CHECK(FleetResultStore::Histogram(bytes) == histogram);
+
+		std::vector<int8_t> scores(length);
+		FleetResultStore::ScoreHistogramBins scoreHistogram{};
+		for (int8_t& score : scores)
+		{
+			score = static_cast<int8_t>(static_cast<int>(NextRandom(state) % FleetResultStore::ScoreBins) - 1);
+			scoreHistogram[static_cast<size_t>(score + 1)]++;
+		}
+		CHECK(FleetResultStore::ScoreHistogram(scores) == scoreHistogram);
+
+		std::vector<float> floats = Floats(length, state);
+		for (auto [low, high] : { std::pair(0.0f, 8.0f), std::pair(8.0f, 12.0f), std::pair(-10.0f, 0.0f),
+			std::pair(std::numeric_limits<float>::denorm_min(), std::numeric_limits<float>::infinity()) })
+		{
+			size_t expected = 0;
+			for (float value : floats)
+				expected += value >= low && value < high;
+			CHECK_EQUAL(FleetResultStore::CountInRange(floats, low, high), expected);
+		}
+
+		double sum = 0;
+		size_t found = 0;
+		for (float value : floats)
+		{
+			if (value > 0)
+			{
+				sum += value;
+				found++;
+			}
+		}
+		double expected = found == 0 ? 0 : sum / static_cast<double>(found);
+		double average = FleetResultStore::AverageFound(floats);
+		CHECK(std::fabs(average - expected) <= 1e-5 * (std::max)(1.0, std::fabs(expected)));
+	}
+}
+
+// A binary batch output loads back into the same rows as the analyses appended directly
+TEST_CASE(FleetResultStore_BinaryRecordsLoadBack)
+{
+	SyntheticCorpus::Options options;
+	options.Seed = 3;
+	options.Languages = { L"en" };
+	SyntheticCorpus corpus(options);
+	SyntheticCorpus::Document document;
+
+	FleetResultStore direct;
+	OutputBuffer out;
+	for (uint64_t index = 0; index < 500; index++)
+	{
+		corpus.Generate(index, document);
+		if (document.Platform == TargetPlatform::macOS)
+		{
+			MacOSAnalysis analysis = AnalysisPipeline::AnalyzeMacOSText(document.Text);
+			direct.Append(analysis);
+			ResultSerializer::Write(ResultSerializer::Format::Binary, out, analysis);
+		}
+		else
+		{
+			WindowsAnalysis analysis = AnalysisPipeline::AnalyzeWindowsText(document.Text);
+			direct.Append(analysis);
+			ResultSerializer::Write(ResultSerializer::Format::Binary, out, analysis);
+		}
+	}
+
+	FleetResultStore loaded;
+	std::string_view stream(out.Data(), out.Size());
+	CHECK(loaded.AppendBinary(stream));
+	CHECK_EQUAL(loaded.Size(), direct.Size());
+	CHECK(std::ranges::equal(loaded.Platform(), direct.Platform()));
+	CHECK(std::ranges::equal(loaded.Score(), direct.Score()));
+	CHECK(std::ranges::equal(loaded.RamGB(), direct.RamGB()));
+	CHECK(std::ranges::equal(loaded.Status(CheckKind::GraphicsCard), direct.Status(CheckKind::GraphicsCard)));
+
+	FleetTotals fromLoaded;
+	fromLoaded.Add(loaded);
+	FleetTotals fromDirect;
+	fromDirect.Add(direct);
+	CHECK_EQUAL(fromLoaded.ToJson(), fromDirect.ToJson());
+	CHECK_EQUAL(fromLoaded.Rows, uint64_t(500));
+	CHECK_EQUAL(fromLoaded.Windows + fromLoaded.MacOS, uint64_t(500));
+
+	// A record cut short stops the load, with the rows before it kept
+	FleetResultStore cut;
+	CHECK(!cut.AppendBinary(stream.substr(0, stream.size() - 3)));
+	CHECK_EQUAL(cut.Size(), size_t(499));
+}
+
+// A copy caught up in steps, as the server's report thread keeps one, has the source's rows,
+// names and codes
+TEST_CASE(FleetResultStore_CatchUpCopiesTheNewRows)
+{
+	SyntheticCorpus::Options options;
+	options.Seed = 41;
+	options.ConfusionRate = 0.01;
+	SyntheticCorpus corpus(options);
+	SyntheticCorpus::Document document;
+
+	FleetResultStore source;
+	FleetResultStore copy;
+	for (uint64_t index = 0; index < 600; index++)
+	{
+		corpus.Generate(index, document);
+		if (document.Platform == TargetPlatform::macOS)
+			source.Append(AnalysisPipeline::AnalyzeMacOSText(document.Text));
+		else
+			source.Append(AnalysisPipeline::AnalyzeWindowsText(document.Text));
+		// Uneven steps, including ones with nothing new
+		if (index % 7 == 0 || index % 50 == 0)
+		{
+			copy.CatchUp(source);
+			copy.CatchUp(source);
+		}
+	}
+	copy.CatchUp(source);
+
+	CHECK_EQUAL(copy.Size(), source.Size());
+	CHECK(std::ranges::equal(copy.Platform(), source.Platform()));
+	CHECK(std::ranges::equal(copy.Score(), source.Score()));
+	CHECK(std::ranges::equal(copy.RamGB(), source.RamGB()));
+	CHECK(std::ranges::equal(copy.VramGB(), source.VramGB()));
+	CHECK(std::ranges::equal(copy.MacOSMajor(), source.MacOSMajor()));
+	for (size_t kind = 0; kind < FleetResultStore::KindCount; kind++)
+	{
+		CHECK(std::ranges::equal(copy.Status(static_cast<CheckKind>(kind)), source.Status(static_cast<CheckKind>(kind))));
+		CHECK(std::ranges::equal(copy.Reason(static_cast<CheckKind>(kind)), source.Reason(static_cast<CheckKind>(kind))));
+	}
+	CHECK(std::ranges::equal(copy.Cpu(), source.Cpu()));
+	CHECK(std::ranges::equal(copy.Gpu(), source.Gpu()));
+	CHECK_EQUAL(copy.CpuNames().Size(), source.CpuNames().Size());
+	CHECK_EQUAL(copy.GpuNames().Size(), source.GpuNames().Size());
+	for (uint32_t code = 0; code < source.CpuNames().Size(); code++)
+		CHECK(copy.CpuNames().Decode(code) == source.CpuNames().Decode(code));
+	for (uint32_t code = 0; code < source.GpuNames().Size(); code++)
+		CHECK(copy.GpuNames().Decode(code) == source.GpuNames().Decode(code));
+
+	FleetTotals fromCopy;
+	fromCopy.Add(copy);
+	FleetTotals fromSource;
+	fromSource.Add(source);
+	CHECK_EQUAL(fromCopy.ToJson(), fromSource.ToJson());
+}
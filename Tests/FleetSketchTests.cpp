@@ -0,0 +1,213 @@
+#include "pch.h"
+#include "FleetSketch.h"
+#include "SyntheticCorpus.h"
+#include "TestHarness.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace HardwareAnalyzer;
+using namespace HardwareAnalyzer::Tests;
+
+namespace
+{
+	constexpr uint64_t Pages = 800;
+	constexpr unsigned Workers = 5;
+
+	std::wstring Numbered(const wchar_t* prefix, uint64_t number)
+	{
+		return prefix + std::to_wstring(number);
+	}
+
+	// Uniform in [0, 1) from the engine's bits, so the values don't depend on the library's
+	// distributions
+	double Uniform(std::mt19937_64& engine)
+	{
+		return static_cast<double>(engine() >> 11) * 0x1.0p-53;
+	}
+
+	// Nearest-rank quantile of sorted values, as LogHistogram::Quantile ranks them
+	double ExactQuantile(const std::vector<double>& sorted, double quantile)
+	{
+		double rank = std::ceil(quantile * static_cast<double>(sorted.size()));
+		size_t index = rank < 1 ? 0 : (std::min)(static_cast<size_t>(rank) - 1, sorted.size() - 1);
+		return sorted[index];
+	}
+}
+
+// Workers that each sketch a share of the stream merge into the sketch of the whole stream:
+// the same score histogram, reason counters, value quantiles and distinct counts
+TEST_CASE(FleetSketch_MergedWorkersAreTheWholeStream)
+{
+	SyntheticCorpus::Options options;
+	options.ConfusionRate = 0.01;
+	options.DroppedLabelRate = 0.1;
+	SyntheticCorpus corpus(options);
+	SyntheticCorpus::Document document;
+
+	FleetSketch whole;
+	FleetSketch workers[Workers];
+	uint64_t results = 0;
+	for (uint64_t i = 0; i < Pages; i++)
+	{
+		corpus.Generate(i, document);
+		// Uneven shares: worker 0 gets every other page
+		FleetSketch& worker = workers[i % 2 == 0 ? 0 : 1 + (i / 2) % (Workers - 1)];
+		if (document.Platform == TargetPlatform::macOS)
+		{
+			MacOSAnalysis analysis = AnalysisPipeline::AnalyzeMacOSText(document.Text);
+			whole.Add(analysis);
+			worker.Add(analysis);
+			results += analysis.Results.size();
+		}
+		else
+		{
+			WindowsAnalysis analysis = AnalysisPipeline::AnalyzeWindowsText(document.Text);
+			whole.Add(analysis);
+			worker.Add(analysis);
+			results += analysis.Results.size();
+		}
+	}
+
+	// Merged in a different order from the one the pages were dealt in
+	FleetSketch merged;
+	for (unsigned w = Workers; w-- > 0;)
+		merged.Merge(workers[w]);
+
+	CHECK_EQUAL(merged.Count(), Pages);
+	CHECK(merged.Scores() == whole.Scores());
+	uint64_t scored = 0;
+	for (uint64_t bin : whole.Scores())
+		scored += bin;
+	CHECK_EQUAL(scored, Pages);
+
+	uint64_t counted = 0;
+	for (size_t kind = 0; kind < FleetSketch::KindCount; kind++)
+	{
+		for (StatusLevel status : { StatusLevel::Good, StatusLevel::Warning, StatusLevel::Bad })
+		{
+			for (size_t reason = 0; reason < ResultCodes::ReasonCount; reason++)
+			{
+				uint64_t count = whole.ReasonCount(static_cast<CheckKind>(kind), status, static_cast<uint8_t>(reason));
+				if (merged.ReasonCount(static_cast<CheckKind>(kind), status, static_cast<uint8_t>(reason)) != count)
+					Fail(__FILE__, __LINE__, std::string(ResultCodes::CheckNames[kind]) + " " + ResultCodes::ReasonKey(static_cast<uint8_t>(reason)));
+				counted += count;
+			}
+		}
+	}
+	CHECK_EQUAL(counted, results);
+
+	for (double quantile : { 0.0, 0.1, 0.5, 0.9, 0.99, 1.0 })
+	{
+		CHECK_EQUAL(merged.RamGB().Quantile(quantile), whole.RamGB().Quantile(quantile));
+		CHECK_EQUAL(merged.VramGB().Quantile(quantile), whole.VramGB().Quantile(quantile));
+	}
+	CHECK_EQUAL(merged.DistinctDevices(), whole.DistinctDevices());
+	CHECK_EQUAL(merged.DistinctProcessors(), whole.DistinctProcessors());
+	CHECK_EQUAL(merged.DistinctGpus(), whole.DistinctGpus());
+}
+
+// A name that dominates the fleet comes out first after a merge, its count an upper bound
+// within the count-min error, even when each worker also saw many more rare names than it
+// keeps candidates for; so does one only a single worker saw, if it saw it often enough
+TEST_CASE(HeavyHitters_MergeKeepsTheDominantName)
+{
+	constexpr uint64_t RarePerWorker = 1500;
+	constexpr uint64_t DominantPerWorker = RarePerWorker / 4;
+	constexpr uint64_t LocalOnly = 900;
+
+	HeavyHitters merged;
+	uint64_t stream = 0;
+	for (unsigned w = 0; w < Workers; w++)
+	{
+		HeavyHitters worker;
+		for (uint64_t i = 0; i < RarePerWorker; i++)
+		{
+			worker.Add(Numbered(L"Rare CPU ", w * RarePerWorker + i));
+			if (i % 4 == 0)
+				worker.Add(L"Intel(R) Core(TM) i7-12700H");
+			if (w == 2 && i < LocalOnly)
+				worker.Add(L"AMD Ryzen 7 5800X 8-Core Processor");
+		}
+		stream += RarePerWorker + DominantPerWorker + (w == 2 ? LocalOnly : 0);
+		merged.Merge(worker);
+	}
+
+	std::vector<HeavyHitters::Entry> top = merged.Top(2);
+	CHECK_EQUAL(top.size(), size_t(2));
+	if (top.size() == 2)
+	{
+		// e / Width of the stream is the count-min's stated overestimate
+		uint64_t slack = static_cast<uint64_t>(std::ceil(std::exp(1.0) / CountMinSketch::Width * static_cast<double>(stream)));
+		CHECK_EQUAL(top[0].Name, std::wstring(L"Intel(R) Core(TM) i7-12700H"));
+		CHECK(top[0].Count >= DominantPerWorker * Workers && top[0].Count <= DominantPerWorker * Workers + slack);
+		CHECK_EQUAL(top[1].Name, std::wstring(L"AMD Ryzen 7 5800X 8-Core Processor"));
+		CHECK(top[1].Count >= LocalOnly && top[1].Count <= LocalOnly + slack);
+	}
+}
+
+// Known numbers of distinct names, estimated within three standard errors (1.6% each), alone
+// and as the merge of two overlapping halves
+TEST_CASE(HyperLogLog_EstimateIsWithinItsStatedError)
+{
+	for (uint64_t cardinality : { uint64_t(10), uint64_t(100), uint64_t(1000), uint64_t(10000), uint64_t(100000), uint64_t(1000000) })
+	{
+		HyperLogLog whole;
+		HyperLogLog low;
+		HyperLogLog high;
+		for (uint64_t i = 0; i < cardinality; i++)
+		{
+			uint64_t hash = SketchHash(Numbered(L"DESKTOP-", i));
+			whole.Add(hash);
+			// Each name twice in the whole stream: repeats don't count
+			whole.Add(hash);
+			if (i < cardinality * 2 / 3)
+				low.Add(hash);
+			if (i >= cardinality / 3)
+				high.Add(hash);
+		}
+		low.Merge(high);
+
+		double error = std::abs(static_cast<double>(whole.Estimate()) - static_cast<double>(cardinality)) / static_cast<double>(cardinality);
+		if (error > 3 * 0.016)
+			Fail(__FILE__, __LINE__, std::to_string(cardinality) + " names estimated as " + std::to_string(whole.Estimate()));
+		CHECK_EQUAL(low.Estimate(), whole.Estimate());
+	}
+	CHECK_EQUAL(HyperLogLog{}.Estimate(), uint64_t(0));
+}
+
+// Every quantile is within 1% of the exact one over values spread across the whole range,
+// for the histogram of the whole and the merge of two halves
+TEST_CASE(LogHistogram_QuantilesAreWithinOnePercent)
+{
+	std::mt19937_64 engine(39);
+	std::vector<double> values;
+	LogHistogram whole;
+	LogHistogram halves[2];
+	for (size_t i = 0; i < 100000; i++)
+	{
+		// Log-uniform from 1/32 to 8192 GB, with the common sizes repeated
+		double value = i % 5 == 0 ? std::ldexp(1.0, static_cast<int>(i / 5 % 8) + 2) : 0.03125 * std::pow(2.0, 18 * Uniform(engine));
+		values.push_back(value);
+		whole.Add(value);
+		halves[i % 2].Add(value);
+	}
+	whole.Add(0);
+	whole.Add(-4);
+	halves[0].Merge(halves[1]);
+	CHECK_EQUAL(whole.Count(), uint64_t(values.size()));
+
+	std::sort(values.begin(), values.end());
+	for (double quantile : { 0.0, 0.001, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 0.999, 1.0 })
+	{
+		double exact = ExactQuantile(values, quantile);
+		double estimate = whole.Quantile(quantile);
+		if (std::abs(estimate - exact) > 0.01 * exact)
+			Fail(__FILE__, __LINE__, "q" + std::to_string(quantile) + ": " + std::to_string(estimate) + " for " + std::to_string(exact));
+		CHECK_EQUAL(halves[0].Quantile(quantile), estimate);
+	}
+	CHECK_EQUAL(LogHistogram{}.Quantile(0.5), 0.0);
+}
@@ -0,0 +1,198 @@
+// Fuzz entry point of the OCR parsers: the input is taken as UTF-8 OCR text and parsed as a
+// Windows and as a Mac page, under the default caps. Besides crashes and sanitizer reports it
+// stops on answers that disagree: the lazy extraction (LazyHardwareInfo.h) must give the same
+// fields and score as the full parse, and a score must lie in [-1, 100].
+//
+// With libFuzzer, seeded with the adversarial corpus:
+//   clang++ -std=c++20 -g -O1 -fsanitize=fuzzer,address,undefined -I../../HardwareAnalyzer -I..
+//           OcrParserFuzzer.cpp -o ocr-parser-fuzzer
+//   ./ocr-parser-fuzzer -write-corpus seeds && ./ocr-parser-fuzzer -max_len=70000 corpus seeds
+// (-write-corpus is handled here, before libFuzzer sees the arguments.)
+//
+// Without it, as a plain program that runs files, or the adversarial corpus and mutations of
+// it when given none:
+//   c++ -std=c++20 -O2 -DHARDWARE_ANALYZER_FUZZ_STANDALONE -I../../HardwareAnalyzer -I..
+//       OcrParserFuzzer.cpp -o ocr-parser-fuzzer
+//   ./ocr-parser-fuzzer [--iterations N] [FILE...] | --write-corpus DIR
+
+#include "pch.h"
+#include "AdversarialCorpus.h"
+#include "HardwareInfo.h"
+#include "LazyHardwareInfo.h"
+#include "MacOSHardwareInfo.h"
+#include "Utf8.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace HardwareAnalyzer;
+
+namespace
+{
+	void Require(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			std::fprintf(stderr, "ocr-parser-fuzzer: %s\n", what);
+			std::abort();
+		}
+	}
+
+	void ParseEverything(std::wstring_view text)
+	{
+		std::wstring page(text);
+		HardwareInfo info = HardwareAnalyzerService::ParseOcrText(page);
+		std::vector<HardwareCheckResult> results = HardwareAnalyzerService::AnalyzeHardware(info);
+		int score = HardwareAnalyzerService::CalculateGlobalScore(results);
+		Require(score >= -1 && score <= 100, "Windows score out of range");
+
+		LazyHardwareInfo lazy(page);
+		const HardwareInfo& lazyInfo = lazy.Info();
+		Require(lazyInfo.DeviceName == info.DeviceName && lazyInfo.Processor == info.Processor && lazyInfo.RAM == info.RAM &&
+			lazyInfo.GPU == info.GPU && lazyInfo.VRAM == info.VRAM && lazyInfo.SystemType == info.SystemType &&
+			lazyInfo.RamGB == info.RamGB && lazyInfo.VramGB == info.VramGB, "lazy extraction differs from ParseOcrText");
+
+		LazyHardwareInfo scored(page);
+		ShortCircuitScore shortCircuit(scored);
+		Require(shortCircuit.Score() == score, "short-circuit score differs from CalculateGlobalScore");
+
+		MacOSHardwareInfo mac = MacOSHardwareAnalyzerService::ParseMacOSOcrText(page);
+		int macScore = MacOSHardwareAnalyzerService::CalculateGlobalScore(MacOSHardwareAnalyzerService::AnalyzeMacOSHardware(mac));
+		Require(macScore >= -1 && macScore <= 100, "macOS score out of range");
+	}
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	ParseEverything(Utf8::Decode(std::string_view(reinterpret_cast<const char*>(data), size)));
+	return 0;
+}
+
+namespace
+{
+	// The adversarial texts at a few sizes, the largest past the default input cap
+	template <typename Function>
+	void ForEachSeed(Function&& function)
+	{
+		for (const Tests::AdversarialText& adversarial : Tests::AdversarialCorpus())
+		{
+			for (size_t chars : { size_t(64), size_t(4096), size_t(80 * 1024) })
+				function(adversarial.Name, chars, adversarial.Make(chars));
+		}
+	}
+
+	int WriteCorpus(const std::filesystem::path& directory)
+	{
+		std::filesystem::create_directories(directory);
+		int written = 0;
+		ForEachSeed([&](const char* name, size_t chars, const std::wstring& text) {
+			std::ofstream file(directory / (std::string(name) + "-" + std::to_string(chars)), std::ios::binary);
+			std::string bytes = Utf8::Encode(text);
+			file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+			written += file.good();
+		});
+		std::printf("%d seeds written to %s\n", written, directory.string().c_str());
+		return 0;
+	}
+}
+
+#ifdef HARDWARE_ANALYZER_FUZZ_STANDALONE
+
+namespace
+{
+	// xorshift64*, so a run can be repeated
+	uint64_t NextRandom(uint64_t& state)
+	{
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return state * 0x2545F4914F6CDD1Dull;
+	}
+
+	// Splices pieces of two seeds and flips, inserts or drops characters
+	std::wstring Mutate(const std::wstring& first, const std::wstring& second, uint64_t& state)
+	{
+		static constexpr std::wstring_view Alphabet = L"0123456789 \n\t:-.,GBMoOlIS5\u00A0\u00E9\u0416";
+		size_t cut = first.empty() ? 0 : NextRandom(state) % first.size();
+		size_t from = second.empty() ? 0 : NextRandom(state) % second.size();
+		std::wstring text = first.substr(0, cut) + second.substr(from, NextRandom(state) % 512);
+		for (uint64_t edits = NextRandom(state) % 16; edits > 0 && !text.empty(); edits--)
+		{
+			size_t at = NextRandom(state) % text.size();
+			wchar_t c = Alphabet[NextRandom(state) % Alphabet.size()];
+			switch (NextRandom(state) % 3)
+			{
+			case 0: text[at] = c; break;
+			case 1: text.insert(text.begin() + static_cast<std::ptrdiff_t>(at), c); break;
+			default: text.erase(at, 1); break;
+			}
+		}
+		return text;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	unsigned long iterations = 20000;
+	std::vector<std::string> files;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string_view argument = argv[i];
+		if (argument == "--iterations" && i + 1 < argc)
+			iterations = std::strtoul(argv[++i], nullptr, 10);
+		else if (argument == "--write-corpus" && i + 1 < argc)
+			return WriteCorpus(argv[++i]);
+		else
+			files.emplace_back(argument);
+	}
+
+	for (const std::string& path : files)
+	{
+		std::ifstream file(path, std::ios::binary);
+		std::string bytes(std::istreambuf_iterator<char>(file), {});
+		LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(bytes.data()), bytes.size());
+	}
+	if (!files.empty())
+	{
+		std::printf("%zu files parsed\n", files.size());
+		return 0;
+	}
+
+	std::vector<std::wstring> seeds;
+	ForEachSeed([&](const char*, size_t chars, const std::wstring& text) {
+		ParseEverything(text);
+		if (chars <= 4096)
+			seeds.push_back(text);
+	});
+	uint64_t state = 0x9E3779B97F4A7C15ull;
+	for (unsigned long iteration = 0; iteration < iterations; iteration++)
+	{
+		const std::wstring& first = seeds[NextRandom(state) % seeds.size()];
+		const std::wstring& second = seeds[NextRandom(state) % seeds.size()];
+		ParseEverything(Mutate(first, second, state));
+	}
+	std::printf("%zu seeds and %lu mutations parsed\n", seeds.size(), iterations);
+	return 0;
+}
+
+#else
+
+// libFuzzer's own options don't include writing the seeds, so that one is taken first
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv)
+{
+	for (int i = 1; i + 1 < *argc; i++)
+	{
+		if (std::string_view((*argv)[i]) == "-write-corpus")
+			std::exit(WriteCorpus((*argv)[i + 1]));
+	}
+	return 0;
+}
+
+#endif
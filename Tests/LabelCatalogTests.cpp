@@ -0,0 +1,44 @@
+#include "pch.h"
+#include "BuiltInLabels.h"
+#include "LabelCatalog.h"
+#include "TestHarness.h"
+#include <vector>
+
+using namespace HardwareAnalyzer;
+
+// A language falls back to English and then to every language's labels, so a page that
+// was identified wrongly still finds a label its real language has
+TEST_CASE(LabelCatalog_FallbackEndsWithTheMultilingualSet)
+{
+	auto catalog = BuiltInLabels::Catalog();
+	const LanguageLabels* german = catalog->Find(L"de");
+	const LanguageLabels* english = catalog->Find(L"en");
+	CHECK(german && english);
+	CHECK(german->Fallback == english);
+	CHECK(english->Fallback == &catalog->All());
+	CHECK(catalog->All().Fallback == nullptr);
+
+	// The device name label of a Chinese page, looked for with the German labels
+	const LanguageLabels* chinese = catalog->Find(L"zh");
+	std::wstring_view label = *chinese->Labels(LabelField::DeviceName).begin();
+	bool found = false;
+	for (const LanguageLabels* set = german; set && !found; set = set->Fallback)
+	{
+		for (std::wstring_view candidate : set->Labels(LabelField::DeviceName))
+			found = found || candidate == label;
+	}
+	CHECK(found);
+}
+
+TEST_CASE(LabelCatalog_WithoutEnglishFallsBackToTheMultilingualSet)
+{
+	LanguageLabels french;
+	french.Tag = L"fr";
+	french.Fields[static_cast<size_t>(LabelField::Processor)] = { L"processeur" };
+	LabelCatalog::Contents contents;
+	contents.Languages.push_back(french);
+	LabelCatalog catalog(std::move(contents));
+
+	CHECK(catalog.Find(L"fr")->Fallback == &catalog.All());
+	CHECK(catalog.All().Fallback == nullptr);
+}
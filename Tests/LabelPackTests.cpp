@@ -0,0 +1,189 @@
+#include "pch.h"
+#include "BuiltInLabels.h"
+#include "HardwareInfo.h"
+#include "LabelPack.h"
+#include "LabelSource.h"
+#include "TestHarness.h"
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace HardwareAnalyzer;
+
+namespace
+{
+	constexpr std::string_view IndonesianSource =
+		"# Indonesian, as in AnalysisDaemon/Labels/id.labels\n"
+		"language: id\n"
+		"processor: Prosesor\n"
+		"installed-ram: RAM yang terinstal|RAM terinstal\n"
+		"graphics-card: Kartu grafis\n"
+		"device-name: Nama perangkat\n"
+		"system-type: Jenis sistem\n"
+		"gpu-stop-labels: Beberapa|Memori|Prosesor|Nama  perangkat\n"
+		"seed: Spesifikasi perangkat Nama perangkat Prosesor RAM terinstal ID perangkat Jenis sistem\n";
+
+	std::filesystem::path TemporaryPack(const char* name)
+	{
+		return std::filesystem::temp_directory_path() / (std::string("hardware-analyzer-tests-") + name + ".halp");
+	}
+
+	std::shared_ptr<const LabelCatalog> Compile(std::string_view text, std::string& error)
+	{
+		LabelSource source;
+		if (!source.Parse(text, error))
+			return nullptr;
+		return source.Build(7, error);
+	}
+
+	std::shared_ptr<const LabelCatalog> CatalogOf(LanguageLabels language)
+	{
+		LabelCatalog::Contents contents;
+		contents.Languages.push_back(std::move(language));
+		return std::make_shared<const LabelCatalog>(std::move(contents));
+	}
+}
+
+TEST_CASE(LabelPack_BuiltInLabelsPassValidation)
+{
+	std::string error;
+	CHECK(LabelPack::Validate(*BuiltInLabels::Catalog(), error));
+	CHECK_EQUAL(error, std::string());
+}
+
+// Labels the scanners could never match, or never reach, don't get into a pack
+TEST_CASE(LabelPack_ValidationRejectsUnfoldedAndShadowedLabels)
+{
+	std::string error;
+	LanguageLabels language;
+	language.Tag = L"xx";
+	language.Fields[static_cast<size_t>(LabelField::Processor)] = { L"Processor" };
+	CHECK(!LabelPack::Validate(*CatalogOf(language), error));
+	CHECK_EQUAL(error, std::string("xx processor: \"Processor\" isn't folded"));
+
+	language.Fields[static_cast<size_t>(LabelField::Processor)] = { L"ram installe", L"ram installee" };
+	CHECK(!LabelPack::Validate(*CatalogOf(language), error));
+	CHECK_EQUAL(error, std::string("xx processor: \"ram installee\" comes after a label it starts with"));
+
+	language.Fields[static_cast<size_t>(LabelField::Processor)] = { L"processor " };
+	CHECK(!LabelPack::Validate(*CatalogOf(language), error));
+
+	language.Fields[static_cast<size_t>(LabelField::Processor)] = { L"processor" };
+	CHECK(LabelPack::Validate(*CatalogOf(language), error));
+
+	LabelCatalog::Contents twice;
+	twice.Languages = { language, language };
+	CHECK(!LabelPack::Validate(LabelCatalog(std::move(twice)), error));
+	CHECK_EQUAL(error, std::string("language xx is there twice"));
+}
+
+TEST_CASE(LabelPack_SourceIsFoldedAndChecked)
+{
+	std::string error;
+	auto catalog = Compile(IndonesianSource, error);
+	CHECK(catalog != nullptr);
+	if (!catalog)
+		return;
+
+	const LanguageLabels* indonesian = catalog->Find(L"id");
+	CHECK(indonesian && *indonesian->Labels(LabelField::InstalledRam).begin() == L"ram yang terinstal");
+	CHECK(indonesian && indonesian->Fields[static_cast<size_t>(LabelField::GpuStopLabels)].back() == L"nama perangkat");
+	CHECK(indonesian && !indonesian->Labels(LabelField::RamUnits).empty());
+	CHECK_EQUAL(catalog->TrigramLanguageCount(), size_t(1));
+	CHECK_EQUAL(catalog->DataVersion(), uint32_t(7));
+
+	CHECK(!Compile("processor: Prosesor\n", error));
+	CHECK_EQUAL(error, std::string("line 1: \"processor\" before any \"language:\" line"));
+	CHECK(!Compile("language: id\nprocessor: Pro|Prosesor\n", error));
+	CHECK_EQUAL(error, std::string("id processor: \"prosesor\" comes after a label it starts with"));
+	CHECK(!Compile("language: id\nscript: runic\n", error));
+	CHECK_EQUAL(error, std::string("line 2: unknown script \"runic\""));
+}
+
+// A compiled pack loads back, and its labels, stop labels included, read a page of its language
+TEST_CASE(LabelPack_CompiledPackReadsItsLanguage)
+{
+	std::string error;
+	auto catalog = Compile(IndonesianSource, error);
+	CHECK(catalog != nullptr);
+	if (!catalog)
+		return;
+	std::filesystem::path path = TemporaryPack("id");
+	CHECK(LabelPack::Write(*catalog, path));
+	auto pack = LabelPack::Load(path, error);
+	CHECK(pack != nullptr);
+	if (!pack)
+		return;
+
+	std::wstring page =
+		L"Spesifikasi perangkat\n"
+		L"Nama perangkat LAPTOP-ID01\n"
+		L"Prosesor Intel(R) Core(TM) i5-1135G7 @ 2.40GHz\n"
+		L"RAM terinstal 16,0 GB\n"
+		L"Kartu grafis Intel(R) Iris(R) Xe Graphics Memori 128 MB\n"
+		L"Jenis sistem Sistem operasi 64-bit, prosesor berbasis x64\n";
+	LabelPack::SetActive(LabelPack::Combine({ BuiltInLabels::Catalog(), pack }));
+	HardwareInfo info = HardwareAnalyzerService::ParseOcrText(page);
+	LabelPack::SetActive(nullptr);
+	std::filesystem::remove(path);
+
+	CHECK_EQUAL(info.DeviceName, std::wstring(L"LAPTOP-ID01"));
+	CHECK_EQUAL(info.GPU, std::wstring(L"Intel(R) Iris(R) Xe Graphics"));
+	CHECK_EQUAL(info.RamGB, 16.0);
+	CHECK(info.Processor.starts_with(L"Intel(R) Core(TM) i5-1135G7"));
+}
+
+// GpuStopLabels came after the first packs; one written without it still loads, with the
+// field empty, so its languages fall back to the English stop labels
+TEST_CASE(LabelPack_PackWithoutTheLatestFieldLoads)
+{
+	std::string error;
+	std::filesystem::path current = TemporaryPack("current");
+	CHECK(LabelPack::Write(*LabelPack::Select(BuiltInLabels::Catalog(), { L"en", L"fr" }), current));
+	std::ifstream file(current, std::ios::binary);
+	std::vector<char> bytes(std::istreambuf_iterator<char>(file), {});
+	file.close();
+	std::filesystem::remove(current);
+
+	// Header fields, in PackHeader order
+	auto field = [&](size_t index) -> uint32_t& { return *reinterpret_cast<uint32_t*>(bytes.data() + index * 4); };
+	constexpr size_t FileSize = 3, LanguageCount = 4, LanguageOffset = 5, LabelOffset = 6, TrigramOffset = 8, StringOffset = 9;
+	uint16_t fieldCount;
+	std::memcpy(&fieldCount, bytes.data() + 6, sizeof(fieldCount));
+	CHECK_EQUAL(size_t(fieldCount), LanguageLabels::FieldCount);
+
+	// Drop the last range of every record and move everything after the records up
+	const size_t records = field(LanguageCount) + 1;
+	const size_t recordSize = 20 + 8 * size_t(fieldCount);   // Tag, Markers, 4 bytes, then the ranges
+	std::vector<char> old(bytes.begin(), bytes.begin() + field(LanguageOffset));
+	for (size_t record = 0; record < records; record++)
+	{
+		auto begin = bytes.begin() + field(LanguageOffset) + record * recordSize;
+		old.insert(old.end(), begin, begin + recordSize - 8);
+	}
+	old.insert(old.end(), bytes.begin() + field(LabelOffset), bytes.end());
+	uint16_t olderFieldCount = static_cast<uint16_t>(fieldCount - 1);
+	std::memcpy(old.data() + 6, &olderFieldCount, sizeof(olderFieldCount));
+	const uint32_t shift = static_cast<uint32_t>(records * 8);
+	auto oldField = [&](size_t index) -> uint32_t& { return *reinterpret_cast<uint32_t*>(old.data() + index * 4); };
+	oldField(FileSize) -= shift;
+	oldField(LabelOffset) -= shift;
+	oldField(StringOffset) -= shift;
+	if (oldField(TrigramOffset) != 0)
+		oldField(TrigramOffset) -= shift;
+
+	std::filesystem::path older = TemporaryPack("older");
+	std::ofstream(older, std::ios::binary).write(old.data(), static_cast<std::streamsize>(old.size()));
+	auto pack = LabelPack::Load(older, error);
+	std::filesystem::remove(older);
+	CHECK(pack != nullptr);
+	if (!pack)
+		return;
+	CHECK_EQUAL(pack->Languages().size(), size_t(2));
+	CHECK(pack->Find(L"fr")->Labels(LabelField::GpuStopLabels).empty());
+	CHECK(*pack->Find(L"fr")->Labels(LabelField::Processor).begin() == L"processeur");
+}
@@ -0,0 +1,51 @@
+#include "pch.h"
+#include "BuiltInLabels.h"
+#include "LanguageIdentifier.h"
+#include "SyntheticCorpus.h"
+#include "TestHarness.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+using namespace HardwareAnalyzer;
+using namespace HardwareAnalyzer::Tests;
+
+// Windows pages of every catalog language are never given another language's tag, and most
+// get their own. "About This Mac" is left out: the corpus writes it in English only.
+TEST_CASE(LanguageIdentifier_IdentifiesEveryCatalogLanguage)
+{
+	constexpr uint64_t Pages = 200;
+	auto catalog = BuiltInLabels::Catalog();
+	CHECK(catalog->Languages().size() >= 20);
+
+	double seconds = 0;
+	uint64_t identified = 0;
+	for (const LanguageLabels& language : catalog->Languages())
+	{
+		SyntheticCorpus::Options options;
+		options.MacOSShare = 0;
+		options.Languages = { std::wstring(language.Tag) };
+		SyntheticCorpus corpus(options, catalog);
+
+		SyntheticCorpus::Document document;
+		uint64_t correct = 0;
+		for (uint64_t i = 0; i < Pages; i++)
+		{
+			corpus.Generate(i, document);
+			auto start = std::chrono::steady_clock::now();
+			const LanguageLabels* found = LanguageIdentifier::Identify(document.Text, *catalog);
+			seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			if (found && found->Tag != language.Tag)
+				Fail(__FILE__, __LINE__, "page " + std::to_string(i) + " of " + Describe(language.Tag) + " identified as " + Describe(found->Tag));
+			correct += found != nullptr && found->Tag == language.Tag;
+		}
+		if (correct * 3 < Pages * 2)
+			Fail(__FILE__, __LINE__, Describe(language.Tag) + " identified on " + std::to_string(correct) + " of " + std::to_string(Pages) + " pages");
+		identified += correct;
+	}
+
+	uint64_t pages = Pages * catalog->Languages().size();
+	std::printf("  %zu languages, %llu of %llu pages identified, %.0f ns per page\n", catalog->Languages().size(),
+		static_cast<unsigned long long>(identified), static_cast<unsigned long long>(pages), seconds * 1e9 / static_cast<double>(pages));
+}
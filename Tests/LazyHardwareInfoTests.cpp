@@ -0,0 +1,153 @@
+#include "pch.h"
+#include "HardwareInfo.h"
+#include "LazyHardwareInfo.h"
+#include "SyntheticCorpus.h"
+#include "TestHarness.h"
+#include "Tracing.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace HardwareAnalyzer;
+using namespace HardwareAnalyzer::Tests;
+
+namespace
+{
+	constexpr uint64_t Pages = 400;
+
+	// Windows pages with every kind of OCR noise, so the fallbacks of each field get used
+	std::vector<std::wstring> NoisyWindowsPages()
+	{
+		SyntheticCorpus::Options options;
+		options.Seed = 47;
+		options.MacOSShare = 0;
+		options.ConfusionRate = 0.01;
+		options.MergedLineRate = 0.05;
+		options.DroppedLabelRate = 0.1;
+		SyntheticCorpus corpus(options);
+		SyntheticCorpus::Document document;
+		std::vector<std::wstring> pages(Pages);
+		for (uint64_t i = 0; i < Pages; i++)
+		{
+			corpus.Generate(i, document);
+			pages[i] = document.Text;
+		}
+		return pages;
+	}
+
+	const HardwareCheckResult* Find(const std::vector<HardwareCheckResult>& results, const wchar_t* name)
+	{
+		for (const HardwareCheckResult& result : results)
+		{
+			if (result.Name == name)
+				return &result;
+		}
+		return nullptr;
+	}
+
+	// Spans of 'name' traced since the last Tracer::Clear
+	size_t Traced(const char* name)
+	{
+		size_t count = 0;
+		for (const TraceEvent& event : Tracer::Snapshot())
+			count += std::strcmp(event.Name, name) == 0;
+		return count;
+	}
+}
+
+// Info() is every field of ParseOcrText, and so is each field read on its own in any order
+TEST_CASE(LazyHardwareInfo_InfoIsParseOcrText)
+{
+	std::vector<std::wstring> pages = NoisyWindowsPages();
+	for (uint64_t i = 0; i < Pages; i++)
+	{
+		HardwareInfo eager = HardwareAnalyzerService::ParseOcrText(pages[i]);
+		LazyHardwareInfo lazy(pages[i]);
+		const HardwareInfo& info = lazy.Info();
+		bool same = info.DeviceName == eager.DeviceName && info.Processor == eager.Processor && info.RAM == eager.RAM &&
+			info.RamGB == eager.RamGB && info.GPU == eager.GPU && info.VRAM == eager.VRAM && info.VramGB == eager.VramGB &&
+			info.SystemType == eager.SystemType;
+
+		LazyHardwareInfo backwards(pages[i]);
+		same = same && backwards.SystemType() == eager.SystemType && backwards.VramGB() == eager.VramGB &&
+			backwards.GPU() == eager.GPU && backwards.RAM() == eager.RAM && backwards.Processor() == eager.Processor &&
+			backwards.DeviceName() == eager.DeviceName;
+		if (!same)
+			Fail(__FILE__, __LINE__, "page " + std::to_string(i) + ": " + Describe(pages[i]));
+	}
+}
+
+// Score(), Reaches(n) and PassesGate() answer as CalculateGlobalScore(AnalyzeHardware(...))
+// does, each on an info of its own so none benefits from another's extraction
+TEST_CASE(ShortCircuitScore_AgreesWithTheEagerScore)
+{
+	std::vector<std::wstring> pages = NoisyWindowsPages();
+	for (uint64_t i = 0; i < Pages; i++)
+	{
+		std::vector<HardwareCheckResult> results = HardwareAnalyzerService::AnalyzeHardware(HardwareAnalyzerService::ParseOcrText(pages[i]));
+		int score = HardwareAnalyzerService::CalculateGlobalScore(results);
+		const HardwareCheckResult* architecture = Find(results, L"Architecture");
+		const HardwareCheckResult* ram = Find(results, L"RAM");
+		bool gate = architecture && ram && architecture->Status != StatusLevel::Bad && ram->Status != StatusLevel::Bad;
+		std::string where = "page " + std::to_string(i) + " scored " + std::to_string(score);
+
+		LazyHardwareInfo scored(pages[i]);
+		int lazyScore = ShortCircuitScore(scored).Score();
+		if (lazyScore != score)
+			Fail(__FILE__, __LINE__, where + ", short-circuit " + std::to_string(lazyScore));
+
+		for (int minimum : { -1, 0, 1, 40, 55, 70, 85, 100, 101 })
+		{
+			LazyHardwareInfo info(pages[i]);
+			if (ShortCircuitScore(info).Reaches(minimum) != (score >= minimum))
+				Fail(__FILE__, __LINE__, where + ", Reaches(" + std::to_string(minimum) + ")");
+		}
+
+		LazyHardwareInfo gated(pages[i]);
+		if (ShortCircuitScore(gated).PassesGate() != gate)
+			Fail(__FILE__, __LINE__, where + ", PassesGate");
+	}
+}
+
+// A field nobody reads is never scanned for: not by a lone field, not by the gate, and not
+// by a score the architecture settles
+TEST_CASE(ShortCircuitScore_UnreadFieldsAreNeverExtracted)
+{
+	Tracer::Clear();
+	Tracer::Enable(true);
+
+	std::vector<std::wstring> pages = NoisyWindowsPages();
+	for (uint64_t i = 0; i < Pages; i += 20)
+	{
+		Tracer::Clear();
+		LazyHardwareInfo deviceOnly(pages[i]);
+		deviceOnly.DeviceName();
+		CHECK_EQUAL(Traced("ExtractProcessor") + Traced("ExtractRAM") + Traced("ExtractGPU") + Traced("ExtractVRAM") + Traced("ExtractSystemType"), size_t(0));
+
+		Tracer::Clear();
+		LazyHardwareInfo gated(pages[i]);
+		ShortCircuitScore(gated).PassesGate();
+		CHECK_EQUAL(Traced("ExtractGPU") + Traced("ExtractVRAM"), size_t(0));
+		CHECK(Traced("ExtractSystemType") <= 1 && Traced("ExtractProcessor") <= 1 && Traced("ExtractRAM") <= 1);
+	}
+
+	// ARM settles the score at 0 after the first check: RAM and the graphics are never read
+	const std::wstring arm =
+		L"Device name\tSURFACE-7\n"
+		L"Processor\tSnapdragon(R) X Elite - X1E80100 - Qualcomm(R) Oryon(TM) CPU 3.42 GHz\n"
+		L"Installed RAM\t16.0 GB\n"
+		L"System type\t64-bit operating system, ARM-based processor\n";
+	CHECK_EQUAL(HardwareAnalyzerService::CalculateGlobalScore(HardwareAnalyzerService::AnalyzeHardware(HardwareAnalyzerService::ParseOcrText(arm))), 0);
+
+	Tracer::Clear();
+	LazyHardwareInfo info(arm);
+	ShortCircuitScore score(info);
+	CHECK_EQUAL(score.Score(), 0);
+	CHECK(!score.PassesGate());
+	CHECK_EQUAL(score.Results().size(), size_t(1));
+	CHECK_EQUAL(Traced("ExtractSystemType"), size_t(1));
+	CHECK_EQUAL(Traced("ExtractRAM") + Traced("ExtractGPU") + Traced("ExtractVRAM"), size_t(0));
+
+	Tracer::Enable(false);
+	Tracer::Clear();
+}
@@ -0,0 +1,55 @@
+#include "pch.h"
+#include "AnalysisJson.h"
+#include "AnalysisPipeline.h"
+#include "HardwareInfo.h"
+#include "LinuxHardwareProbe.h"
+#include "TestHarness.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace HardwareAnalyzer;
+using namespace HardwareAnalyzer::Tests;
+
+namespace
+{
+	std::string ReadFixture(const std::filesystem::path& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		std::string text(std::istreambuf_iterator<char>(file), {});
+		while (!text.empty() && (text.back() == '\n' || text.back() == '\r'))
+			text.pop_back();
+		return text;
+	}
+}
+
+// Each directory of Fixtures/LinuxProbe is a captured machine: root/ holds its procfs and
+// sysfs files, machine what uname(2) calls it, and expected.json what "hardware-analyzerd
+// probe --root root --machine ..." prints for it. The trees cover a hybrid laptop (Iris Xe
+// and a GeForce behind resizable BAR, with connector and render nodes beside the cards), an
+// arm64 server without DMI, cpufreq or memory blocks, and a container that sees only procfs.
+TEST_CASE(LinuxHardwareProbe_FixtureTreesGiveTheExpectedAnalyses)
+{
+	std::vector<std::filesystem::path> fixtures;
+	std::error_code error;
+	for (std::filesystem::directory_iterator entry(FixturesDirectory() / "LinuxProbe", error), end; !error && entry != end; entry.increment(error))
+	{
+		if (entry->is_directory())
+			fixtures.push_back(entry->path());
+	}
+	std::sort(fixtures.begin(), fixtures.end());
+	CHECK(fixtures.size() >= 3);
+
+	for (const std::filesystem::path& fixture : fixtures)
+	{
+		WindowsAnalysis analysis;
+		analysis.Info = LinuxHardwareProbe::Probe(fixture / "root", ReadFixture(fixture / "machine"));
+		analysis.Results = HardwareAnalyzerService::AnalyzeHardware(analysis.Info);
+		analysis.Score = HardwareAnalyzerService::CalculateGlobalScore(analysis.Results);
+		CHECK_EQUAL(fixture.filename().string() + ": " + AnalysisJson::ToJson(analysis),
+			fixture.filename().string() + ": " + ReadFixture(fixture / "expected.json"));
+	}
+}
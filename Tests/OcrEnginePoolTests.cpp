@@ -0,0 +1,183 @@
+// The pool's concurrency is only meaningful under a race detector; build these with
+//   c++ -std=c++20 -O1 -g -fsanitize=thread -pthread -I../HardwareAnalyzer -I../AnalysisDaemon -I. *.cpp
+// and run "hardware-analyzer-tests OcrEnginePool".
+
+#include "pch.h"
+#include "OcrEnginePool.h"
+#include "StandInOcrBackend.h"
+#include "TestHarness.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace HardwareAnalyzer;
+using namespace HardwareAnalyzer::Tests;
+
+namespace
+{
+	using Pool = OcrEnginePool<StandInOcrEngine>;
+
+	std::unique_ptr<StandInOcrBackend> Backend(const std::shared_ptr<StandInOcrBackend::Record>& record)
+	{
+		return std::make_unique<StandInOcrBackend>(std::vector<std::wstring>{ L"xx-XX", L"fr-FR", L"en-US" },
+			std::vector<std::wstring>{ L"fr-FR", L"en-US", L"de-DE" }, record);
+	}
+}
+
+// Threads check engines out of three languages (and the default) at once: no engine is
+// ever used by two of them, every checkout is a creation or a reuse, and every engine
+// created is either idle at the end, within the cap, or was discarded
+TEST_CASE(OcrEnginePool_ConcurrentCheckoutsNeverShareAnEngine)
+{
+	constexpr int Threads = 8;
+	constexpr int CheckoutsPerThread = 400;
+	constexpr size_t MaxIdle = 2;
+	auto record = std::make_shared<StandInOcrBackend::Record>();
+	Pool pool(Backend(record), MaxIdle);
+
+	std::atomic<int> emptyLeases{ 0 };
+	std::atomic<int> wrongLanguage{ 0 };
+	std::vector<std::thread> threads;
+	for (int thread = 0; thread < Threads; thread++)
+	{
+		threads.emplace_back([&, thread] {
+			static const std::wstring languages[] = { L"fr-FR", L"en-US", L"de-DE" };
+			for (int i = 0; i < CheckoutsPerThread; i++)
+			{
+				bool byDefault = (i + thread) % 4 == 3;
+				const std::wstring& language = languages[(i + thread) % 3];
+				Pool::Lease lease = byDefault ? pool.Checkout() : pool.Checkout(language);
+				if (!lease)
+				{
+					emptyLeases++;
+					continue;
+				}
+				wrongLanguage += lease->GetState().Language != (byDefault ? std::wstring(L"fr-FR") : language);
+				lease->Recognize(L"page");
+
+				// Some leases are moved before they end, some are released early
+				if (i % 5 == 0)
+				{
+					Pool::Lease moved = std::move(lease);
+					CHECK(!lease);
+					moved->Recognize(L"page");
+				}
+				else if (i % 7 == 0)
+				{
+					lease.Release();
+				}
+			}
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+
+	CHECK_EQUAL(emptyLeases.load(), 0);
+	CHECK_EQUAL(wrongLanguage.load(), 0);
+	int calls = 0;
+	for (const auto& engine : record->Engines)
+	{
+		CHECK_EQUAL(engine->Overlaps.load(), 0);
+		CHECK_EQUAL(engine->Users.load(), 0);
+		calls += engine->Calls.load();
+	}
+
+	// One creation resolved the default language and went idle; the others are checkouts
+	Pool::Statistics stats = pool.GetStatistics();
+	CHECK_EQUAL(stats.Created, record->Engines.size());
+	CHECK_EQUAL(stats.Created - 1 + stats.Reused, size_t(Threads * CheckoutsPerThread));
+	CHECK(stats.Created - stats.Discarded <= 3 * MaxIdle);
+	CHECK(calls >= Threads * CheckoutsPerThread);
+	CHECK_EQUAL(record->CandidateCalls.load(), 1);
+}
+
+// The first candidate that yields an engine is the default; it's worked out once however
+// many threads ask at the same time
+TEST_CASE(OcrEnginePool_DefaultLanguageIsResolvedOnce)
+{
+	auto record = std::make_shared<StandInOcrBackend::Record>();
+	Pool pool(Backend(record));
+
+	std::vector<std::thread> threads;
+	std::atomic<int> french{ 0 };
+	for (int thread = 0; thread < 6; thread++)
+	{
+		threads.emplace_back([&] {
+			Pool::Lease lease = pool.Checkout();
+			french += lease && lease.Language() == L"fr-FR";
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+
+	CHECK_EQUAL(french.load(), 6);
+	CHECK_EQUAL(record->CandidateCalls.load(), 1);
+}
+
+// WarmUp resolves the default up front: the checkouts after it only read the language,
+// and the first of them gets the engine the resolution created
+TEST_CASE(OcrEnginePool_WarmUpResolvesTheDefaultForCheckouts)
+{
+	auto record = std::make_shared<StandInOcrBackend::Record>();
+	Pool pool(Backend(record));
+	pool.WarmUp();
+	CHECK_EQUAL(record->CandidateCalls.load(), 1);
+	CHECK_EQUAL(pool.GetStatistics().Created, size_t(1));
+
+	std::vector<std::thread> threads;
+	std::atomic<int> french{ 0 };
+	for (int thread = 0; thread < 4; thread++)
+	{
+		threads.emplace_back([&] {
+			for (int i = 0; i < 100; i++)
+			{
+				Pool::Lease lease = pool.Checkout();
+				french += lease && lease.Language() == L"fr-FR";
+			}
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+
+	CHECK_EQUAL(french.load(), 400);
+	CHECK_EQUAL(record->CandidateCalls.load(), 1);
+	CHECK(pool.GetStatistics().Reused >= 1);
+}
+
+TEST_CASE(OcrEnginePool_UnavailableLanguageGivesAnEmptyLease)
+{
+	auto record = std::make_shared<StandInOcrBackend::Record>();
+	Pool pool(Backend(record));
+	Pool::Lease lease = pool.Checkout(L"ja-JP");
+	CHECK(!lease);
+	CHECK_EQUAL(pool.GetStatistics().Created, size_t(0));
+
+	// No candidate at all: no default engine either
+	auto none = std::make_shared<StandInOcrBackend::Record>();
+	Pool empty(std::make_unique<StandInOcrBackend>(std::vector<std::wstring>{ L"xx-XX" }, std::vector<std::wstring>{}, none));
+	CHECK(!empty.Checkout());
+	CHECK(!empty.Checkout());
+	CHECK_EQUAL(none->CandidateCalls.load(), 1);
+}
+
+// WarmUp leaves engines idle for the next checkouts, up to the idle cap; the rest are dropped
+TEST_CASE(OcrEnginePool_WarmUpAndIdleCap)
+{
+	auto record = std::make_shared<StandInOcrBackend::Record>();
+	Pool pool(Backend(record), 2);
+	pool.WarmUp(L"en-US", 4);
+	Pool::Statistics warm = pool.GetStatistics();
+	CHECK_EQUAL(warm.Created, size_t(4));
+	CHECK_EQUAL(warm.Discarded, size_t(2));
+
+	Pool::Lease first = pool.Checkout(L"en-US");
+	Pool::Lease second = pool.Checkout(L"en-US");
+	Pool::Lease third = pool.Checkout(L"en-US");
+	Pool::Statistics after = pool.GetStatistics();
+	CHECK_EQUAL(after.Reused, size_t(2));
+	CHECK_EQUAL(after.Created, size_t(5));
+	CHECK(&first->GetState() != &second->GetState());
+	CHECK(&second->GetState() != &third->GetState());
+}
@@ -0,0 +1,81 @@
+#include "pch.h"
+#include "HardwareInfo.h"
+#include "OcrNormalizer.h"
+#include "TestHarness.h"
+#include <string>
+
+using namespace HardwareAnalyzer;
+
+namespace
+{
+	std::wstring Normalized(std::wstring text)
+	{
+		OcrNormalizer::Normalize(text, *LabelPack::Active());
+		return text;
+	}
+
+	// Host names as Windows generates them, and a few set by hand, with S, O and I after digits
+	constexpr const wchar_t* HostNames[] = {
+		L"LAPTOP-PD2S4YS9", L"DESKTOP-SQJ9S23", L"DESKTOP-2S4YO1I", L"LAPTOP-7O3KS2OL", L"DESKTOP-1OLS5QA",
+		L"WIN-1O2SQL", L"DESKTOP-9SS0OI7", L"SRV-2OI9DC", L"BUILD-AGENT-4S", L"LAPTOP-8OSCAR",
+	};
+}
+
+TEST_CASE(OcrNormalizer_FixesConfusionsInsideNumbers)
+{
+	CHECK_EQUAL(Normalized(L"1O GB"), std::wstring(L"10 GB"));
+	CHECK_EQUAL(Normalized(L"1OGB"), std::wstring(L"10GB"));
+	CHECK_EQUAL(Normalized(L"8OO MB"), std::wstring(L"800 MB"));
+	CHECK_EQUAL(Normalized(L"16,O Go"), std::wstring(L"16,0 Go"));
+	CHECK_EQUAL(Normalized(L"13-inch, M1, 2O2O"), std::wstring(L"13-inch, M1, 2020"));
+	CHECK_EQUAL(Normalized(L"macOS Sonoma 14.l"), std::wstring(L"macOS Sonoma 14.1"));
+	CHECK_EQUAL(Normalized(L"1S6 GB"), std::wstring(L"156 GB"));
+	CHECK_EQUAL(Normalized(L"Installed RAM 3I.8 GB"), std::wstring(L"Installed RAM 31.8 GB"));
+}
+
+TEST_CASE(OcrNormalizer_LeavesIdentifiersAlone)
+{
+	for (const wchar_t* name : HostNames)
+		CHECK_EQUAL(Normalized(name), std::wstring(name));
+	CHECK_EQUAL(Normalized(L"Intel Core i7-47OOK"), std::wstring(L"Intel Core i7-47OOK"));
+	CHECK_EQUAL(Normalized(L"8Go"), std::wstring(L"8Go"));
+}
+
+// The device name reaches AnalysisHistory as its key, so it must come out of the parse as written
+TEST_CASE(OcrNormalizer_HostNamesSurviveTheParse)
+{
+	for (const wchar_t* name : HostNames)
+	{
+		std::wstring page = std::wstring(L"Device specifications\nDevice name\n") + name +
+			L"\nProcessor\nIntel(R) Core(TM) i7-10750H CPU @ 2.60GHz 2.59 GHz\nInstalled RAM\n16,O GB (15,8 GB usable)\n"
+			L"System type\n64-bit operating system, x64-based processor\n";
+		HardwareInfo info = HardwareAnalyzerService::ParseOcrText(page);
+		CHECK_EQUAL(info.DeviceName, std::wstring(name));
+		CHECK_EQUAL(info.RamGB, 16.0);
+	}
+}
+
+// "rn" is read as "m" only where that makes a word of the catalog's labels, or one the
+// parsers match in code; other words keep their "rn"
+TEST_CASE(OcrNormalizer_RnBecomesMOnlyInVocabularyWords)
+{
+	CHECK_EQUAL(Normalized(L"Installed Mernory"), std::wstring(L"Installed Memory"));
+	CHECK_EQUAL(Normalized(L"Systern type"), std::wstring(L"System type"));
+	CHECK_EQUAL(Normalized(L"macOS Sonorna"), std::wstring(L"macOS Sonoma"));
+	CHECK_EQUAL(Normalized(L"Apple M2 rnax"), std::wstring(L"Apple M2 max"));
+	CHECK_EQUAL(Normalized(L"Apple M2 Maxrn"), std::wstring(L"Apple M2 Maxrn"));
+	CHECK_EQUAL(Normalized(L"Intel Core i7 Alternate"), std::wstring(L"Intel Core i7 Alternate"));
+	CHECK_EQUAL(Normalized(L"Modern Standby"), std::wstring(L"Modern Standby"));
+
+	// A label pack's words get the fix, and the built-in ones don't unless the pack has them
+	LanguageLabels klingon;
+	klingon.Tag = L"tlh";
+	klingon.Fields[static_cast<size_t>(LabelField::InstalledRam)] = { L"qawhaq mach" };
+	LabelCatalog::Contents contents;
+	contents.Languages.push_back(klingon);
+	LabelCatalog catalog(std::move(contents));
+	std::wstring text = L"qawhaq rnach\nMernory";
+	OcrNormalizer::Normalize(text, catalog);
+	CHECK_EQUAL(text, std::wstring(L"qawhaq mach\nMernory"));
+	CHECK(catalog.IsVocabularyWord(L"mach") && !catalog.IsVocabularyWord(L"qawhaq"));
+}
@@ -0,0 +1,118 @@
+#include "pch.h"
+#include "AdversarialCorpus.h"
+#include "HardwareInfo.h"
+#include "MacOSHardwareInfo.h"
+#include "SyntheticCorpus.h"
+#include "TestHarness.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+using namespace HardwareAnalyzer;
+using namespace HardwareAnalyzer::Tests;
+
+namespace
+{
+	// Limits wide enough that the adversarial text is scanned whole, in one line if it is one
+	ParseLimits Uncapped(size_t chars)
+	{
+		return ParseLimits{ chars + 64, chars + 64 };
+	}
+
+	// Best of three parses on both platforms, in seconds
+	double ParseSeconds(const std::wstring& text, const ParseLimits& limits)
+	{
+		double best = 1e9;
+		for (int run = 0; run < 3; run++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			HardwareInfo windows = HardwareAnalyzerService::ParseOcrText(text, limits);
+			MacOSHardwareInfo mac = MacOSHardwareAnalyzerService::ParseMacOSOcrText(text, limits);
+			best = (std::min)(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		}
+		return best;
+	}
+
+	double ParseSeconds(const std::wstring& text)
+	{
+		return ParseSeconds(text, Uncapped(text.size()));
+	}
+}
+
+// Four times the text must cost about four times the time; a quadratic scan would cost
+// sixteen. Measured here at x2.6 to x5.2 (timer noise at 64K), so x6 would mean a
+// superlinear scan crept in.
+BENCHMARK_CASE(OcrTextScanner_BenchmarkAdversarialTextIsLinear)
+{
+	constexpr size_t SmallChars = 64 * 1024;
+	for (const AdversarialText& adversarial : AdversarialCorpus())
+	{
+		double small = ParseSeconds(adversarial.Make(SmallChars));
+		double large = ParseSeconds(adversarial.Make(4 * SmallChars));
+		double ratio = large / (std::max)(small, 1e-5);
+		std::printf("  %-28s %8.2f ms at 64K, %8.2f ms at 256K, x%.1f\n", adversarial.Name, small * 1e3, large * 1e3, ratio);
+		CHECK(ratio < 6);
+	}
+}
+
+// The worst adversarial text under the shipped caps against the average synthetic page.
+// The cap lets such text be MaxInputChars long, 227 times the average page, and measured
+// here its worst (labels-without-values) costs 31-52 ms, 298-414 times the page's 84-127 us:
+// 1.3-1.8 times a page's cost per character. Checked at twice a page's cost per character.
+BENCHMARK_CASE(OcrTextScanner_BenchmarkDefaultCapsWorstCase)
+{
+	constexpr uint64_t Pages = 500;
+	SyntheticCorpus corpus(SyntheticCorpus::Options{});
+	SyntheticCorpus::Document document;
+	double total = 0;
+	size_t chars = 0;
+	for (uint64_t i = 0; i < Pages; i++)
+	{
+		corpus.Generate(i, document);
+		total += ParseSeconds(document.Text, ParseLimits{});
+		chars += document.Text.size();
+	}
+	double average = total / Pages;
+	double averageChars = static_cast<double>(chars) / Pages;
+
+	double worst = 0;
+	const char* worstName = "";
+	for (const AdversarialText& adversarial : AdversarialCorpus())
+	{
+		double seconds = ParseSeconds(adversarial.Make(4 * 1024 * 1024), ParseLimits{});
+		if (seconds > worst)
+		{
+			worst = seconds;
+			worstName = adversarial.Name;
+		}
+	}
+	double ratio = worst / (std::max)(average, 1e-7);
+	double perChar = ratio * averageChars / static_cast<double>(ParseLimits{}.MaxInputChars);
+	std::printf("  average page %.1f us (%.0f chars), worst %s %.1f ms, x%.0f, x%.1f per character\n",
+		average * 1e6, averageChars, worstName, worst * 1e3, ratio, perChar);
+	CHECK(perChar < 2);
+}
+
+// Under the default caps any text, however long, is cut to MaxInputChars before it is
+// scanned, and every adversarial pattern still parses
+TEST_CASE(OcrTextScanner_DefaultCapsCutAdversarialText)
+{
+	const ParseLimits limits;
+	for (const AdversarialText& adversarial : AdversarialCorpus())
+	{
+		std::wstring text = adversarial.Make(4 * 1024 * 1024);
+		if (OcrTextScanner::ApplyLimits(text, limits).size() > limits.MaxInputChars)
+			Fail(__FILE__, __LINE__, adversarial.Name);
+		HardwareInfo windows = HardwareAnalyzerService::ParseOcrText(text);
+		MacOSHardwareInfo mac = MacOSHardwareAnalyzerService::ParseMacOSOcrText(text);
+	}
+}
+
+// The input cap counts the characters of the text as given, blank lines included
+TEST_CASE(OcrTextScanner_LimitsTruncateLinesAndInput)
+{
+	ParseLimits limits{ 20, 8 };
+	std::wstring capped = OcrTextScanner::ApplyLimits(L"0123456789abc\n\n\nxy\nremaining text", limits);
+	CHECK_EQUAL(capped, std::wstring(L"01234567\nxy\nr"));
+}
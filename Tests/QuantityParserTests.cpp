@@ -0,0 +1,138 @@
+#include "pch.h"
+#include "QuantityParser.h"
+#include "TestHarness.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cwctype>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+using namespace HardwareAnalyzer;
+using namespace HardwareAnalyzer::Tests;
+
+namespace
+{
+	constexpr uint64_t MB = uint64_t{ 1 } << 20;
+	constexpr uint64_t GB = uint64_t{ 1 } << 30;
+	constexpr uint64_t TB = uint64_t{ 1 } << 40;
+
+	// Bytes of "<number> <unit>", or 0 when it doesn't parse
+	uint64_t Bytes(std::wstring_view text)
+	{
+		uint64_t bytes = 0;
+		return QuantityParser::Parse(text, bytes) ? bytes : 0;
+	}
+
+	// The parse QuantityParser replaced: the comma swapped for a point, std::stod under a
+	// try/catch and the unit lowercased and compared
+	bool ParseWithStod(std::wstring_view text, uint64_t& bytes)
+	{
+		size_t numberEnd = text.find(L' ');
+		if (numberEnd == std::wstring_view::npos)
+			return false;
+		std::wstring number(text.substr(0, numberEnd));
+		std::replace(number.begin(), number.end(), L',', L'.');
+		double value;
+		try
+		{
+			value = std::stod(number);
+		}
+		catch (const std::exception&)
+		{
+			return false;
+		}
+
+		std::wstring unit(text.substr(numberEnd + 1, 2));
+		for (wchar_t& c : unit)
+			c = static_cast<wchar_t>(std::towlower(c));
+		double scale = unit == L"tb" || unit == L"to" ? 1024.0 * 1024 : unit == L"mb" || unit == L"mo" ? 1 : unit == L"gb" || unit == L"go" ? 1024 : 0;
+		if (scale == 0)
+			return false;
+		bytes = static_cast<uint64_t>(value * scale * static_cast<double>(MB) + 0.5);
+		return true;
+	}
+}
+
+TEST_CASE(QuantityParser_ReadsTheSpellingsOcrProduces)
+{
+	CHECK_EQUAL(Bytes(L"16 GB"), 16 * GB);
+	CHECK_EQUAL(Bytes(L"15,8 Go"), static_cast<uint64_t>(15.8 * GB + 0.5));
+	CHECK_EQUAL(Bytes(L"1 To"), TB);
+	CHECK_EQUAL(Bytes(L"512 Mo"), 512 * MB);
+	CHECK_EQUAL(Bytes(L"8 GiB"), 8 * GB);
+	CHECK_EQUAL(Bytes(L"7.8 GB usable"), static_cast<uint64_t>(7.8 * GB + 0.5));
+	CHECK_EQUAL(Bytes(L"4096MB"), 4 * GB);
+	CHECK_EQUAL(Bytes(L"2 tb"), 2 * TB);
+	CHECK(std::abs(QuantityParser::ToGB(Bytes(L"15,8 Go")) - 15.8) < 1e-9);
+}
+
+TEST_CASE(QuantityParser_ReadsCyrillicAndFinnishUnits)
+{
+	CHECK_EQUAL(Bytes(L"16 \u0413\u0411"), 16 * GB);                 // ГБ
+	CHECK_EQUAL(Bytes(L"15,9 \u0433\u0431 \u0434\u043E\u0441\u0442\u0443\u043F\u043D\u043E"), static_cast<uint64_t>(15.9 * GB + 0.5));   // гб доступно
+	CHECK_EQUAL(Bytes(L"512 \u041C\u0411"), 512 * MB);               // МБ
+	CHECK_EQUAL(Bytes(L"1 \u0422\u0411"), TB);                       // ТБ
+	CHECK_EQUAL(Bytes(L"16 Gt"), 16 * GB);
+	CHECK_EQUAL(Bytes(L"2 TT"), 2 * TB);
+
+	uint64_t bytes = 0;
+	CHECK(QuantityParser::Parse(L"8", L"\u0433\u0431", bytes) && bytes == 8 * GB);
+}
+
+TEST_CASE(QuantityParser_RejectsMalformedAndOverflowingNumbers)
+{
+	for (std::wstring_view text : { L"", L"GB", L"16", L"16 GX", L"16 gigs", L"-8 GB", L".5 GB", L"1.2.3 GB",
+		L"1,,5 GB", L"99999999999 TB", L"123456789012345678901234567890123 MB" })
+	{
+		uint64_t bytes = 0;
+		if (QuantityParser::Parse(text, bytes))
+			Fail(__FILE__, __LINE__, Describe(text) + " parsed as " + std::to_string(bytes));
+	}
+
+	double value = 0;
+	CHECK(QuantityParser::ParseNumber(L"15,8", value) && value == 15.8);
+	CHECK(!QuantityParser::ParseNumber(L"15,8,1", value));
+	CHECK(!QuantityParser::ParseNumber(L"1e9", value));
+	CHECK(!QuantityParser::ParseNumber(L"", value));
+
+	int integer = 0;
+	CHECK(QuantityParser::ParseInteger(L"2020", integer) && integer == 2020);
+	CHECK(!QuantityParser::ParseInteger(L"99999999999", integer));
+	CHECK(!QuantityParser::ParseInteger(L"20x0", integer));
+	CHECK(!QuantityParser::ParseInteger(L"", integer));
+}
+
+// from_chars against the stod/catch parse it replaced, on the same values and a share of
+// unreadable ones that made stod throw
+TEST_CASE(QuantityParser_IsFasterThanStod)
+{
+	static constexpr std::wstring_view values[] = { L"16 GB", L"15,8 Go", L"1 To", L"512 Mo", L"7.8 GB", L"l6 GB", L"GB" };
+	constexpr int Rounds = 200000;
+
+	auto time = [&](auto parse) {
+		uint64_t parsed = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int round = 0; round < Rounds; round++)
+		{
+			for (std::wstring_view value : values)
+			{
+				uint64_t bytes = 0;
+				if (parse(value, bytes))
+					parsed++;
+			}
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return std::make_pair(seconds * 1e9 / (Rounds * std::size(values)), parsed);
+	};
+
+	auto [fromChars, fromCharsParsed] = time([](std::wstring_view text, uint64_t& bytes) { return QuantityParser::Parse(text, bytes); });
+	auto [stod, stodParsed] = time(ParseWithStod);
+	std::printf("  from_chars %.0f ns per value, stod/catch %.0f ns per value\n", fromChars, stod);
+	CHECK_EQUAL(fromCharsParsed, stodParsed);
+	CHECK(fromChars < stod);
+}
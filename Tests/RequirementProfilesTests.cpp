@@ -0,0 +1,81 @@
+#include "pch.h"
+#include "AnalysisPipeline.h"
+#include "HardwareInfo.h"
+#include "HardwareThresholds.h"
+#include "MacOSHardwareInfo.h"
+#include "RequirementProfiles.h"
+#include "ResultCodes.h"
+#include "TestHarness.h"
+#include <cstdint>
+#include <string>
+
+using namespace HardwareAnalyzer;
+
+namespace
+{
+	uint8_t StatusOf(const ProfileEvaluation& evaluation, CheckKind kind)
+	{
+		return evaluation.Status[static_cast<size_t>(kind)][0];
+	}
+}
+
+// A profile left at its defaults grades like the analyzers themselves, on both sides of
+// every HardwareThresholds limit
+TEST_CASE(RequirementProfiles_DefaultProfileMatchesTheAnalyzers)
+{
+	RequirementProfileTable table;
+	table.Add(RequirementProfile{ L"default" });
+
+	for (double ramGB : { 4.0, HardwareThresholds::RamBadGB - 0.5, HardwareThresholds::RamBadGB, HardwareThresholds::RamWarningGB - 0.5,
+		HardwareThresholds::RamWarningGB, HardwareThresholds::RamGoodGB, 32.0 })
+	{
+		for (double vramGB : { 1.0, HardwareThresholds::VramBadGB, HardwareThresholds::VramWarningGB - 0.5, HardwareThresholds::VramWarningGB, 8.0 })
+		{
+			WindowsAnalysis analysis;
+			analysis.Info.Processor = L"Intel(R) Core(TM) i7-12700H";
+			analysis.Info.GPU = L"NVIDIA GeForce RTX 3060 Laptop GPU";
+			analysis.Info.SystemType = L"64-bit operating system, x64-based processor";
+			analysis.Info.RamGB = ramGB;
+			analysis.Info.RAM = std::to_wstring(ramGB) + L" GB";
+			analysis.Info.VramGB = vramGB;
+			analysis.Info.VRAM = std::to_wstring(vramGB) + L" GB";
+			analysis.Results = HardwareAnalyzerService::AnalyzeHardware(analysis.Info);
+			analysis.Score = HardwareAnalyzerService::CalculateGlobalScore(analysis.Results);
+
+			ProfileEvaluation evaluation = table.Evaluate(analysis);
+			for (const auto& result : analysis.Results)
+			{
+				CheckKind kind = ResultCodes::KindOf(result.Name);
+				CHECK_EQUAL(int(StatusOf(evaluation, kind)), int(result.Status));
+			}
+			CHECK_EQUAL(int(evaluation.Scores[0]), analysis.Score);
+		}
+	}
+
+	for (double memoryGB : { 4.0, HardwareThresholds::MacMemoryBadGB, HardwareThresholds::MacMemoryWarningGB - 0.5,
+		HardwareThresholds::MacMemoryWarningGB, HardwareThresholds::MacMemoryGoodGB })
+	{
+		for (int major : { HardwareThresholds::MinMacOSMajor - 1, HardwareThresholds::MinMacOSMajor, 26 })
+		{
+			MacOSAnalysis analysis;
+			analysis.Info.DeviceName = L"MacBook Pro";
+			analysis.Info.Chip = L"Apple M2 Pro";
+			analysis.Info.ChipGeneration = 2;
+			analysis.Info.IsAppleSilicon = true;
+			analysis.Info.MemoryGB = memoryGB;
+			analysis.Info.Memory = std::to_wstring(memoryGB) + L" GB";
+			analysis.Info.MacOSMajorVersion = major;
+			analysis.Info.MacOSVersion = L"macOS " + std::to_wstring(major);
+			analysis.Results = MacOSHardwareAnalyzerService::AnalyzeMacOSHardware(analysis.Info);
+			analysis.Score = MacOSHardwareAnalyzerService::CalculateGlobalScore(analysis.Results);
+
+			ProfileEvaluation evaluation = table.Evaluate(analysis);
+			for (const auto& result : analysis.Results)
+			{
+				CheckKind kind = ResultCodes::KindOf(result.Name);
+				CHECK_EQUAL(int(StatusOf(evaluation, kind)), int(result.Status));
+			}
+			CHECK_EQUAL(int(evaluation.Scores[0]), analysis.Score);
+		}
+	}
+}
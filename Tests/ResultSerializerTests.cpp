@@ -0,0 +1,125 @@
+#include "pch.h"
+#include "AnalysisJson.h"
+#include "ResultSerializer.h"
+#include "SyntheticCorpus.h"
+#include "TestHarness.h"
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace HardwareAnalyzer;
+using namespace HardwareAnalyzer::Tests;
+
+namespace
+{
+	HardwareCheckResult Result(const wchar_t* name, const wchar_t* value, StatusLevel status, const wchar_t* reasonKey)
+	{
+		HardwareCheckResult result;
+		result.Name = name;
+		result.Value = value;
+		result.Status = status;
+		result.ReasonKey = reasonKey;
+		return result;
+	}
+
+	// Text CSV and JSON both have to escape: separators, quotes, line breaks, a control
+	// character, a backslash and non-ASCII. The results are out of the table's order and
+	// two of the five Windows checks are missing.
+	WindowsAnalysis AwkwardAnalysis()
+	{
+		WindowsAnalysis analysis;
+		analysis.Score = 72;
+		analysis.Info.DeviceName = L"Desk\nPC";
+		analysis.Info.Processor = L"Intel(R) Core(TM) i7, 3.4GHz";
+		analysis.Info.RAM = L"16 GB";
+		analysis.Info.RamGB = 16;
+		analysis.Info.GPU = L"GeForce \"RTX\" 4070";
+		analysis.Info.VRAM = L"";
+		analysis.Info.VramGB = 0;
+		analysis.Info.SystemType = L"x64 \\ caf\u00E9\t";
+		analysis.Results.push_back(Result(L"RAM", L"16 GB", StatusLevel::Warning, L"RamLow"));
+		analysis.Results.push_back(Result(L"Processor", L"i7, 3.4GHz", StatusLevel::Good, L"ProcessorOk"));
+		analysis.Results.push_back(Result(L"Architecture", L"x64\r\n", StatusLevel::Bad, L"Arch\"32\""));
+		return analysis;
+	}
+
+	template <typename Analysis>
+	std::string Json(const Analysis& analysis)
+	{
+		OutputBuffer out;
+		ResultSerializer::WriteJson(out, analysis);
+		return std::string(out.View());
+	}
+}
+
+// JSON is AnalysisJson::ToJson's object and a newline, for pages of both platforms, with the
+// std and the arena strings, and for text that needs escaping
+TEST_CASE(ResultSerializer_JsonIsToJsonAndANewline)
+{
+	SyntheticCorpus::Options options;
+	options.ConfusionRate = 0.02;
+	options.MergedLineRate = 0.05;
+	SyntheticCorpus corpus(options);
+	SyntheticCorpus::Document document;
+	std::vector<std::byte> buffer(64 * 1024);
+	std::pmr::monotonic_buffer_resource resource(buffer.data(), buffer.size());
+	for (uint64_t i = 0; i < 300; i++)
+	{
+		corpus.Generate(i, document);
+		std::string json;
+		std::string expected;
+		if (document.Platform == TargetPlatform::macOS)
+		{
+			MacOSAnalysis analysis = AnalysisPipeline::AnalyzeMacOSText(document.Text);
+			json = Json(analysis);
+			expected = AnalysisJson::ToJson(analysis) + "\n";
+		}
+		else
+		{
+			pmr::WindowsAnalysis analysis = AnalysisPipeline::AnalyzeWindowsText(document.Text, &resource);
+			json = Json(analysis);
+			expected = AnalysisJson::ToJson(analysis) + "\n";
+		}
+		if (json != expected)
+			Fail(__FILE__, __LINE__, "page " + std::to_string(i) + ": " + json + " != " + expected);
+		resource.release();
+	}
+
+	WindowsAnalysis awkward = AwkwardAnalysis();
+	CHECK_EQUAL(Json(awkward), AnalysisJson::ToJson(awkward) + "\n");
+	WindowsAnalysis empty;
+	CHECK_EQUAL(Json(empty), AnalysisJson::ToJson(empty) + "\n");
+}
+
+// Text with a comma, a quote or a line break is quoted with its quotes doubled; other text
+// is bare. A check with no result leaves its three columns empty.
+TEST_CASE(ResultSerializer_CsvQuotesTextAndLeavesMissingChecksEmpty)
+{
+	OutputBuffer header;
+	ResultSerializer::CsvHeader<WindowsAnalysis>(header);
+	CHECK_EQUAL(std::string(header.View()),
+		std::string("score,deviceName,processor,ram,ramGB,gpu,vram,vramGB,systemType,"
+			"Processor value,Processor status,Processor reasonKey,"
+			"Graphics Card value,Graphics Card status,Graphics Card reasonKey,"
+			"RAM value,RAM status,RAM reasonKey,"
+			"Video Memory value,Video Memory status,Video Memory reasonKey,"
+			"Architecture value,Architecture status,Architecture reasonKey\r\n"));
+
+	OutputBuffer row;
+	ResultSerializer::WriteCsv(row, AwkwardAnalysis());
+	CHECK_EQUAL(std::string(row.View()),
+		std::string("72,\"Desk\nPC\",\"Intel(R) Core(TM) i7, 3.4GHz\",16 GB,16,\"GeForce \"\"RTX\"\" 4070\",,0,x64 \\ caf\xC3\xA9\t"
+			",\"i7, 3.4GHz\",good,ProcessorOk"
+			",,,"
+			",16 GB,warning,RamLow"
+			",,,"
+			",\"x64\r\n\",bad,\"Arch\"\"32\"\"\""
+			"\r\n"));
+
+	// No results at all: every check's columns are empty
+	OutputBuffer bare;
+	ResultSerializer::WriteCsv(bare, WindowsAnalysis{});
+	CHECK_EQUAL(std::string(bare.View()), "-1,,,,0,,,0," + std::string(5 * 3, ',') + "\r\n");
+}
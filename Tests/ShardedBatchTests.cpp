@@ -0,0 +1,151 @@
+#include "pch.h"
+#include "AnalysisJson.h"
+#include "ResultSerializer.h"
+#include "ShardedBatch.h"
+#include "SyntheticCorpus.h"
+#include "TestHarness.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace HardwareAnalyzer;
+using namespace HardwareAnalyzer::Tests;
+
+namespace
+{
+	using Format = ResultSerializer::Format;
+
+	constexpr uint64_t Pages = 120;
+
+	std::filesystem::path TemporaryDirectory(const char* name)
+	{
+		std::filesystem::path directory = std::filesystem::temp_directory_path() / (std::string("hardware-analyzer-tests-") + name);
+		std::filesystem::remove_all(directory);
+		std::filesystem::create_directories(directory);
+		return directory;
+	}
+
+	std::string ReadFile(const std::filesystem::path& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	// Pages as "corpus" writes them, with a blank line and a line without a page among them
+	// and no newline after the last one; also the output of analyzing them in order, and
+	// how many pages that output holds. CSV has a header and the Windows pages only.
+	std::string Input(Format format, std::string& expected, uint64_t& records)
+	{
+		SyntheticCorpus::Options options;
+		options.ConfusionRate = 0.01;
+		SyntheticCorpus corpus(options);
+		SyntheticCorpus::Document document;
+		std::string input;
+		OutputBuffer out;
+		if (format == Format::Csv)
+			ResultSerializer::CsvHeader<WindowsAnalysis>(out);
+		records = 0;
+		for (uint64_t index = 0; index < Pages; index++)
+		{
+			corpus.Generate(index, document);
+			bool macOS = document.Platform == TargetPlatform::macOS;
+			input += macOS ? "{\"platform\":\"macos\",\"text\":" : "{\"platform\":\"windows\",\"text\":";
+			AnalysisJson::AppendString(input, document.Text);
+			input += "}\n";
+			if (index == 40)
+				input += "\n{\"index\":40,\"note\":\"no page here\"}\n";
+			if (macOS && format == Format::Csv)
+				continue;
+			if (macOS)
+				ResultSerializer::Write(format, out, AnalysisPipeline::AnalyzeMacOSText(document.Text));
+			else
+				ResultSerializer::Write(format, out, AnalysisPipeline::AnalyzeWindowsText(document.Text));
+			records++;
+		}
+		input.pop_back();
+		expected.assign(out.View());
+		return input;
+	}
+}
+
+// The chunks cover the data end to end, each ending after a newline or at the end, whatever
+// the lines' lengths against the chunk size
+TEST_CASE(ShardedBatch_SplitCutsOnlyAfterNewlines)
+{
+	const std::string inputs[] = {
+		"short\nlines\nwith no newline at the end",
+		"a line much longer than any chunk of the split\nb\n",
+		"\n\n\n",
+		"no newline at all",
+		"x",
+	};
+	for (const std::string& data : inputs)
+	{
+		for (size_t chunk : { size_t(0), size_t(1), size_t(3), size_t(8), size_t(1000) })
+		{
+			std::vector<ShardedBatch::Range> ranges = ShardedBatch::Split(data, chunk);
+			size_t at = 0;
+			bool valid = true;
+			for (const ShardedBatch::Range& range : ranges)
+			{
+				valid = valid && range.Begin == at && range.End > range.Begin &&
+					(range.End == data.size() || data[range.End - 1] == '\n') &&
+					(range.End == data.size() || range.End - range.Begin >= chunk);
+				at = range.End;
+			}
+			if (!valid || at != data.size())
+				Fail(__FILE__, __LINE__, Describe(data) + " split into chunks of " + std::to_string(chunk));
+		}
+	}
+	CHECK(ShardedBatch::Split("", 16).empty());
+	CHECK_EQUAL(ShardedBatch::Split("one long line\nx", 4).size(), size_t(2));
+}
+
+// Workers w of n write shards whose merge is the same bytes for every n and chunk size, and
+// those are the results of analyzing the pages one after the other
+TEST_CASE(ShardedBatch_MergeIsTheSameForAnyShardCount)
+{
+	std::filesystem::path directory = TemporaryDirectory("sharded-batch");
+	for (Format format : { Format::Json, Format::Binary, Format::Csv })
+	{
+		std::string expected;
+		uint64_t records = 0;
+		std::string input = Input(format, expected, records);
+		std::filesystem::path inputPath = directory / "pages.jsonl";
+		std::ofstream(inputPath, std::ios::binary) << input;
+
+		for (unsigned workers : { 1u, 2u, 3u, 7u })
+		{
+			for (size_t chunkBytes : { size_t(1), size_t(4096), size_t(1) << 20 })
+			{
+				ShardedBatch::Options options;
+				options.InputPath = inputPath.string();
+				options.OutputPath = (directory / "merged").string();
+				options.ChunkBytes = chunkBytes;
+				options.Format = format;
+
+				std::vector<std::string> shards;
+				std::string error;
+				for (unsigned worker = 0; worker < workers; worker++)
+				{
+					shards.push_back((directory / ("shard-" + std::to_string(worker))).string());
+					CHECK(ShardedBatch::RunWorker(options, worker, workers, shards.back(), error));
+				}
+				ShardedBatch::Statistics stats;
+				CHECK(ShardedBatch::Merge(options, shards, stats, error));
+				CHECK_EQUAL(error, std::string());
+
+				std::string merged = ReadFile(options.OutputPath);
+				std::string where = std::to_string(workers) + " workers, chunks of " + std::to_string(chunkBytes) + ": ";
+				if (merged != expected)
+					Fail(__FILE__, __LINE__, where + "output differs from the pages analyzed in order");
+				if (stats.Records != records || stats.Records + stats.Skipped != Pages + 1)
+					Fail(__FILE__, __LINE__, where + std::to_string(stats.Records) + " records, " + std::to_string(stats.Skipped) + " skipped");
+			}
+		}
+	}
+	std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "pch.h"
+#include "OcrEnginePool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace HardwareAnalyzer::Tests
+{
+	// An OCR engine that needs no OS support: it "recognizes" by returning the text it is
+	// given, after a delay, and notices when two callers use it at once. Each engine counts
+	// its users in state shared by its moved copies, which is what the pool hands around.
+	class StandInOcrEngine
+	{
+	public:
+		struct State
+		{
+			std::wstring Language;
+			int Id = 0;
+			std::atomic<int> Users{ 0 };
+			std::atomic<int> Overlaps{ 0 };   // Times a second caller came in while one was inside
+			std::atomic<int> Calls{ 0 };
+		};
+
+		explicit StandInOcrEngine(std::shared_ptr<State> state) : m_state(std::move(state)) {}
+
+		std::wstring Recognize(const std::wstring& page, std::chrono::microseconds work = std::chrono::microseconds(20))
+		{
+			if (m_state->Users.fetch_add(1) != 0)
+				m_state->Overlaps++;
+			m_state->Calls++;
+			std::this_thread::sleep_for(work);
+			m_state->Users.fetch_sub(1);
+			return page;
+		}
+
+		const State& GetState() const { return *m_state; }
+
+	private:
+		std::shared_ptr<State> m_state;
+	};
+
+	// Backend of stand-in engines: the languages in 'available' can be created, slowly;
+	// CandidateLanguages returns 'candidates'. Everything it ever created stays reachable,
+	// so a test can look at every engine once the pool is done.
+	class StandInOcrBackend : public IOcrEngineBackend<StandInOcrEngine>
+	{
+	public:
+		struct Record
+		{
+			std::atomic<int> CandidateCalls{ 0 };
+			std::atomic<int> CreateCalls{ 0 };
+			std::mutex Lock;
+			std::vector<std::shared_ptr<StandInOcrEngine::State>> Engines;
+		};
+
+		StandInOcrBackend(std::vector<std::wstring> candidates, std::vector<std::wstring> available, std::shared_ptr<Record> record,
+			std::chrono::microseconds creationTime = std::chrono::microseconds(200))
+			: m_candidates(std::move(candidates)), m_available(std::move(available)), m_record(std::move(record)), m_creationTime(creationTime)
+		{
+		}
+
+		std::vector<std::wstring> CandidateLanguages() override
+		{
+			m_record->CandidateCalls++;
+			return m_candidates;
+		}
+
+		std::optional<StandInOcrEngine> CreateEngine(const std::wstring& language) override
+		{
+			m_record->CreateCalls++;
+			std::this_thread::sleep_for(m_creationTime);
+			if (std::find(m_available.begin(), m_available.end(), language) == m_available.end())
+				return std::nullopt;
+
+			auto state = std::make_shared<StandInOcrEngine::State>();
+			state->Language = language;
+			std::lock_guard<std::mutex> lock(m_record->Lock);
+			state->Id = static_cast<int>(m_record->Engines.size());
+			m_record->Engines.push_back(state);
+			return StandInOcrEngine(state);
+		}
+
+	private:
+		std::vector<std::wstring> m_candidates;
+		std::vector<std::wstring> m_available;
+		std::shared_ptr<Record> m_record;
+		std::chrono::microseconds m_creationTime;
+	};
+}
@@ -0,0 +1,135 @@
+#include "pch.h"
+#include "SystemProfilerParser.h"
+#include "TestHarness.h"
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace HardwareAnalyzer;
+using namespace HardwareAnalyzer::Tests;
+
+namespace
+{
+	using Format = SystemProfilerParser::Format;
+
+	std::string ReadFixture(const char* name)
+	{
+		std::ifstream file(FixturesDirectory() / "SystemProfiler" / name, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	struct Expected
+	{
+		const wchar_t* DeviceName;
+		const wchar_t* Chip;
+		const wchar_t* Memory;
+		double MemoryGB;
+		const wchar_t* MacOSVersion;
+		int MacOSMajorVersion;
+		int ChipGeneration;
+		bool IsAppleSilicon;
+		bool IsIntelMac;
+	};
+
+	void CheckMac(const MacOSHardwareInfo& info, const Expected& expected, const std::string& where)
+	{
+		auto text = [&](const std::wstring& actual, const wchar_t* wanted, const char* field) {
+			if (actual != wanted)
+				Fail(__FILE__, __LINE__, where + ": " + field + " " + Describe(actual) + " != " + Describe(wanted));
+		};
+		text(info.DeviceName, expected.DeviceName, "DeviceName");
+		text(info.Chip, expected.Chip, "Chip");
+		text(info.Memory, expected.Memory, "Memory");
+		text(info.MacOSVersion, expected.MacOSVersion, "MacOSVersion");
+		if (info.MemoryGB != expected.MemoryGB || info.MacOSMajorVersion != expected.MacOSMajorVersion ||
+			info.ChipGeneration != expected.ChipGeneration || info.IsAppleSilicon != expected.IsAppleSilicon ||
+			info.IsIntelMac != expected.IsIntelMac)
+		{
+			Fail(__FILE__, __LINE__, where + ": MemoryGB " + Describe(info.MemoryGB) + ", major " + Describe(info.MacOSMajorVersion) +
+				", generation " + Describe(info.ChipGeneration) + ", Apple silicon " + Describe(info.IsAppleSilicon) + ", Intel " + Describe(info.IsIntelMac));
+		}
+	}
+
+	const Expected M2Pro{ L"MacBook Pro", L"Apple M2 Pro", L"16 GB", 16, L"macOS 14.1.1 (23B81)", 14, 2, true, false };
+	const Expected IntelIMac{ L"iMac", L"6-Core Intel Core i5", L"32 GB", 32, L"macOS 13.6.3 (22G436)", 13, 0, false, true };
+	const Expected M4Mini{ L"Mac mini", L"Apple M4", L"24 GB", 24, L"macOS 15.1 (24B83)", 15, 4, true, false };
+}
+
+// One Mac in each of the formats system_profiler writes
+TEST_CASE(SystemProfilerParser_ReadsEveryFormat)
+{
+	MacOSHardwareInfo info;
+	CHECK_EQUAL(SystemProfilerParser::Parse(ReadFixture("hardware.json"), info), Format::Json);
+	CheckMac(info, M2Pro, "hardware.json");
+
+	info = {};
+	CHECK_EQUAL(SystemProfilerParser::Parse(ReadFixture("hardware.xml"), info), Format::Plist);
+	CheckMac(info, { L"MacBook Pro", L"8-Core Intel Core i9", L"32 GB", 32, L"macOS 13.6.3 (22G436)", 13, 0, false, true }, "hardware.xml");
+
+	info = {};
+	CHECK_EQUAL(SystemProfilerParser::Parse(ReadFixture("hardware.txt"), info), Format::Text);
+	CheckMac(info, { L"MacBook Air", L"Apple M3", L"8 GB", 8, L"macOS 14.4.1 (23E224)", 14, 3, true, false }, "hardware.txt");
+}
+
+// sw_vers names the release on its own, or completes a report parsed before
+TEST_CASE(SystemProfilerParser_SwVersCompletesAReport)
+{
+	MacOSHardwareInfo info;
+	CHECK_EQUAL(SystemProfilerParser::Parse(ReadFixture("sw_vers.txt"), info), Format::Text);
+	CHECK_EQUAL(info.MacOSVersion, std::wstring(L"macOS 14.4.1"));
+	CHECK_EQUAL(info.MacOSMajorVersion, 14);
+	CHECK(info.Chip.empty());
+
+	info = {};
+	std::string hardwareOnly = ReadFixture("hardware.txt");
+	hardwareOnly.resize(hardwareOnly.find("Software:"));
+	SystemProfilerParser::Parse(hardwareOnly, info);
+	CHECK(info.MacOSVersion.empty());
+	SystemProfilerParser::Parse(ReadFixture("sw_vers.txt"), info);
+	CheckMac(info, { L"MacBook Air", L"Apple M3", L"8 GB", 8, L"macOS 14.4.1", 14, 3, true, false }, "hardware.txt and sw_vers.txt");
+}
+
+// An MDM export lists Macs one after the other, their data types in any order; Next hands
+// out each in turn. A text export is split where a field repeats.
+TEST_CASE(SystemProfilerParser_NextWalksAMultiMacExport)
+{
+	std::string json = ReadFixture("mdm-export.json");
+	SystemProfilerParser parser(json);
+	CHECK_EQUAL(parser.DetectedFormat(), Format::Json);
+	std::vector<MacOSHardwareInfo> macs;
+	MacOSHardwareInfo info;
+	while (parser.Next(info))
+		macs.push_back(info);
+	CHECK_EQUAL(macs.size(), size_t(3));
+	if (macs.size() == 3)
+	{
+		CheckMac(macs[0], M2Pro, "mdm-export.json Mac 1");
+		CheckMac(macs[1], IntelIMac, "mdm-export.json Mac 2");
+		CheckMac(macs[2], M4Mini, "mdm-export.json Mac 3");
+	}
+	CHECK(!parser.Next(info));
+
+	std::string text = ReadFixture("hardware.txt") + ReadFixture("hardware.txt");
+	size_t count = SystemProfilerParser::ForEachMac(text, [](const MacOSHardwareInfo& mac) {
+		CheckMac(mac, { L"MacBook Air", L"Apple M3", L"8 GB", 8, L"macOS 14.4.1 (23E224)", 14, 3, true, false }, "hardware.txt twice");
+	});
+	CHECK_EQUAL(count, size_t(2));
+
+	CHECK_EQUAL(SystemProfilerParser::ForEachMacInFile(FixturesDirectory() / "SystemProfiler" / "mdm-export.json", [](const MacOSHardwareInfo&) {}), size_t(3));
+}
+
+// Binary plists aren't read: the parser says so rather than guessing at their bytes
+TEST_CASE(SystemProfilerParser_BinaryPlistIsUnknown)
+{
+	std::string binary = ReadFixture("hardware.bplist");
+	CHECK(binary.starts_with("bplist00"));
+	MacOSHardwareInfo info;
+	CHECK_EQUAL(SystemProfilerParser::Parse(binary, info), Format::Unknown);
+	CHECK(info.Memory.empty());
+
+	SystemProfilerParser parser(binary);
+	CHECK_EQUAL(parser.DetectedFormat(), Format::Unknown);
+	CHECK(!parser.Next(info));
+	CHECK_EQUAL(SystemProfilerParser::Parse("", info), Format::Unknown);
+}
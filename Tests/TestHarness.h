@@ -0,0 +1,107 @@
+#pragma once
+#include "pch.h"
+#include "Utf8.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace HardwareAnalyzer::Tests
+{
+	// A check that registers itself at static initialization; main.cpp runs them all, except
+	// benchmarks, which run only when asked for by name
+	struct TestCase
+	{
+		const char* Name;
+		void (*Run)();
+		bool Benchmark;
+	};
+
+	inline std::vector<TestCase>& Registry()
+	{
+		static std::vector<TestCase> tests;
+		return tests;
+	}
+
+	struct Registrar
+	{
+		Registrar(const char* name, void (*run)(), bool benchmark = false) { Registry().push_back({ name, run, benchmark }); }
+	};
+
+	// Failed checks of the test being run
+	inline int& Failures()
+	{
+		static int failures = 0;
+		return failures;
+	}
+
+	// Fixtures/ next to the tests, or HARDWARE_ANALYZER_FIXTURES when that is set
+	inline std::filesystem::path FixturesDirectory()
+	{
+		if (const char* directory = std::getenv("HARDWARE_ANALYZER_FIXTURES"))
+			return directory;
+		return std::filesystem::path(__FILE__).parent_path() / "Fixtures";
+	}
+
+	inline void Fail(const char* file, int line, const std::string& message)
+	{
+		std::fprintf(stderr, "%s:%d: %s\n", file, line, message.c_str());
+		Failures()++;
+	}
+
+	// Values as the failure messages print them
+	inline std::string Describe(std::wstring_view value) { return '"' + Utf8::Encode(value) + '"'; }
+	inline std::string Describe(std::string_view value) { return '"' + std::string(value) + '"'; }
+	inline std::string Describe(const std::wstring& value) { return Describe(std::wstring_view(value)); }
+	inline std::string Describe(const std::string& value) { return Describe(std::string_view(value)); }
+	inline std::string Describe(const wchar_t* value) { return Describe(std::wstring_view(value)); }
+	inline std::string Describe(const char* value) { return Describe(std::string_view(value)); }
+	inline std::string Describe(bool value) { return value ? "true" : "false"; }
+
+	template <typename Value>
+	std::string Describe(const Value& value)
+	{
+		if constexpr (std::is_enum_v<Value>)
+			return std::to_string(static_cast<long long>(value));
+		else
+			return std::to_string(value);
+	}
+}
+
+#define HA_TEST_CONCAT_(a, b) a##b
+#define HA_TEST_CONCAT(a, b) HA_TEST_CONCAT_(a, b)
+
+// TEST_CASE(Name) { ...CHECK(...)... }
+#define TEST_CASE(name)                                                                                  \
+	static void name();                                                                                  \
+	static ::HardwareAnalyzer::Tests::Registrar HA_TEST_CONCAT(name, Registrar){ #name, name };          \
+	static void name()
+
+// BENCHMARK_CASE(Name) { ... }: timed, so its checks depend on the machine and its load
+#define BENCHMARK_CASE(name)                                                                             \
+	static void name();                                                                                  \
+	static ::HardwareAnalyzer::Tests::Registrar HA_TEST_CONCAT(name, Registrar){ #name, name, true };    \
+	static void name()
+
+#define CHECK(condition)                                                                                 \
+	do                                                                                                   \
+	{                                                                                                    \
+		if (!(condition))                                                                                \
+			::HardwareAnalyzer::Tests::Fail(__FILE__, __LINE__, "CHECK(" #condition ") failed");         \
+	} while (false)
+
+#define CHECK_EQUAL(actual, expected)                                                                    \
+	do                                                                                                   \
+	{                                                                                                    \
+		const auto& actualValue_ = (actual);                                                             \
+		const auto& expectedValue_ = (expected);                                                         \
+		if (!(actualValue_ == expectedValue_))                                                           \
+		{                                                                                                \
+			::HardwareAnalyzer::Tests::Fail(__FILE__, __LINE__, "CHECK_EQUAL(" #actual ", " #expected   \
+				"): " + ::HardwareAnalyzer::Tests::Describe(actualValue_) + " != " +                     \
+				::HardwareAnalyzer::Tests::Describe(expectedValue_));                                    \
+		}                                                                                                \
+	} while (false)
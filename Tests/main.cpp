@@ -0,0 +1,52 @@
+// hardware-analyzer-tests: checks of the portable engine and the daemon's components.
+// Builds on Linux and macOS without the WinUI project, like the daemon:
+//   c++ -std=c++20 -O2 -pthread -I../HardwareAnalyzer -I../AnalysisDaemon -I. *.cpp -o hardware-analyzer-tests
+//
+//   hardware-analyzer-tests [NAME...]      runs every test, or those whose name contains a NAME
+//
+// Benchmarks (BENCHMARK_CASE) run only when a NAME selects them, e.g. "Benchmark" for all.
+//
+// Tests that read fixtures find them next to this file (Fixtures/), or under
+// HARDWARE_ANALYZER_FIXTURES when that is set. Built as above, with relative paths, that
+// means running from this directory; from elsewhere, set the variable.
+
+#include "pch.h"
+#include "TestHarness.h"
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <string_view>
+
+using namespace HardwareAnalyzer::Tests;
+
+int main(int argc, char** argv)
+{
+	int failed = 0;
+	int run = 0;
+	for (const TestCase& test : Registry())
+	{
+		bool selected = argc < 2 && !test.Benchmark;
+		for (int i = 1; i < argc && !selected; i++)
+			selected = std::string_view(test.Name).find(argv[i]) != std::string_view::npos;
+		if (!selected)
+			continue;
+
+		Failures() = 0;
+		auto start = std::chrono::steady_clock::now();
+		try
+		{
+			test.Run();
+		}
+		catch (const std::exception& e)
+		{
+			std::fprintf(stderr, "%s: exception: %s\n", test.Name, e.what());
+			Failures()++;
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::printf("%-48s %s (%.0f ms)\n", test.Name, Failures() == 0 ? "ok" : "FAILED", ms);
+		failed += Failures() != 0;
+		run++;
+	}
+	std::printf("%d of %d tests passed\n", run - failed, run);
+	return failed == 0 ? 0 : 1;
+}